@@ -33,6 +33,20 @@ extern "C" {
 #define HSE_KVDB_COMPACT_CANCEL   (1u << 0)
 #define HSE_KVDB_COMPACT_SAMP_LWM (1u << 1)
 
+/* hse_kvs_bulk_create() flags */
+#define HSE_KVS_BULK_BEHIND (1u << 0)
+
+/* hse_kvs_cursor_read_batch() flags */
+#define HSE_CURSOR_READ_KEYS (1u << 0)
+
+/* hse_kvs_cursor_create() flags, in addition to those in flags.h
+ *
+ * HSE_CURSOR_CREATE_KEYS - Create a keys-only cursor.  Reads return each
+ * key along with the length of its value, but never the value itself, and
+ * so never read value blocks from media nor decompress values.
+ */
+#define HSE_CURSOR_CREATE_KEYS (1u << 1)
+
 /** @addtogroup KVDB Key-Value Database (KVDB)
  * @{
  */
@@ -152,6 +166,393 @@ hse_kvs_prefix_probe(
     size_t                      valbuf_sz,
     size_t *                    val_len);
 
+/** @brief Opaque handle that keeps a value returned by hse_kvs_get_pinned() valid. */
+struct hse_kvs_pin;
+
+/** @brief Retrieve a reference to the value for a given key without copying it.
+ *
+ * Behaves like hse_kvs_get(), except that when the value is resident in
+ * memory or in an uncompressed vblock, a read-only pointer to the value
+ * is returned in @p val and the storage backing it is pinned until the
+ * handle returned in @p pin is released via hse_kvs_pin_release().
+ * Compressed values, and values which otherwise cannot be pinned, are
+ * copied into @p valbuf exactly as hse_kvs_get() would, in which case
+ * @p val is set to @p valbuf and @p pin is set to NULL.
+ *
+ * A pinned value holds a reference on internal data structures which
+ * prevents their memory and media from being reclaimed, so pins should
+ * be released promptly.
+ *
+ * @note This function is thread safe.
+ *
+ * <b>Flags:</b>
+ * @arg 0 - Reserved for future use.
+ *
+ * @param kvs: KVS handle from hse_kvdb_kvs_open().
+ * @param flags: Flags for operation specialization.
+ * @param txn: Transaction context (optional).
+ * @param key: Key to get from @p kvs.
+ * @param key_len: Length of @p key.
+ * @param[out] found: Whether or not @p key was found.
+ * @param valbuf: Buffer into which an unpinnable value will be copied.
+ * @param valbuf_sz: Size of @p valbuf.
+ * @param[out] val: Address of the value.
+ * @param[out] val_len: Actual length of the value.
+ * @param[out] pin: Handle to pass to hse_kvs_pin_release(), or NULL.
+ *
+ * @remark @p kvs must not be NULL.
+ * @remark @p key must not be NULL.
+ * @remark @p found must not be NULL.
+ * @remark @p valbuf must not be NULL if @p valbuf_sz is non-zero.
+ * @remark @p val, @p val_len, and @p pin must not be NULL.
+ *
+ * @returns Error status.
+ */
+hse_err_t
+hse_kvs_get_pinned(
+    struct hse_kvs *      kvs,
+    unsigned int          flags,
+    struct hse_kvdb_txn * txn,
+    const void *          key,
+    size_t                key_len,
+    bool *                found,
+    void *                valbuf,
+    size_t                valbuf_sz,
+    const void **         val,
+    size_t *              val_len,
+    struct hse_kvs_pin ** pin);
+
+/** @brief Release a value pinned by hse_kvs_get_pinned().
+ *
+ * @note This function is thread safe.
+ *
+ * @param pin: Handle from hse_kvs_get_pinned() (may be NULL).
+ */
+void
+hse_kvs_pin_release(struct hse_kvs_pin *pin);
+
+/** @brief Opaque handle for a bulk load created by hse_kvs_bulk_create(). */
+struct hse_kvs_bulk;
+
+/** @brief Create a bulk loader.
+ *
+ * A bulk loader builds the KVS's on-media structures directly from a
+ * stream of key-value pairs supplied in ascending key order, bypassing
+ * the write-ahead log and the in-memory ingest path, and then publishes
+ * them atomically via hse_kvs_bulk_commit().  It is intended for initial
+ * loads and restores, where it writes each key and value to media once.
+ *
+ * By default the KVS must be empty when the load is committed, and must
+ * not be written to by any other means while the load is in progress.
+ * Loaded keys are older than any key subsequently put to the KVS.
+ *
+ * With HSE_KVS_BULK_BEHIND the KVS may be live.  The loaded data is built
+ * while the KVS continues to serve reads and writes, and the commit links
+ * it into the KVS behind all existing data: a loaded key is older than
+ * any version of that key already in the KVS, so it only becomes visible
+ * where the KVS has no other version of the key.  Only one such loader
+ * may exist per KVS at a time (EBUSY otherwise), and the commit may wait
+ * for in-progress compactions.
+ *
+ * @note This function is thread safe, but a bulk loader is not.
+ *
+ * <b>Flags:</b>
+ * @arg HSE_KVS_BULK_BEHIND - Link the load behind the data of a live KVS.
+ *
+ * @param kvs: KVS handle from hse_kvdb_kvs_open().
+ * @param flags: Flags for operation specialization.
+ * @param[out] bulk: Bulk loader handle.
+ *
+ * @remark @p kvs must not be NULL.
+ * @remark @p bulk must not be NULL.
+ * @remark @p kvs must not be a capped KVS.
+ *
+ * @returns Error status.
+ */
+hse_err_t
+hse_kvs_bulk_create(struct hse_kvs *kvs, unsigned int flags, struct hse_kvs_bulk **bulk);
+
+/** @brief Add a key-value pair to a bulk load.
+ *
+ * Keys must be supplied in strictly ascending order as defined by
+ * memcmp(), otherwise EINVAL is returned.  After an error the bulk
+ * loader can only be destroyed.
+ *
+ * @param bulk: Bulk loader handle from hse_kvs_bulk_create().
+ * @param key: Key to load.
+ * @param key_len: Length of @p key.
+ * @param val: Value associated with @p key.
+ * @param val_len: Length of @p val.
+ *
+ * @remark @p bulk must not be NULL.
+ * @remark @p key must not be NULL.
+ * @remark @p val must not be NULL if @p val_len is non-zero.
+ *
+ * @returns Error status.
+ */
+hse_err_t
+hse_kvs_bulk_put(
+    struct hse_kvs_bulk *bulk,
+    const void *         key,
+    size_t               key_len,
+    const void *         val,
+    size_t               val_len);
+
+/** @brief Atomically publish all key-value pairs added to a bulk load.
+ *
+ * Either all or none of the loaded key-value pairs become visible.
+ * Without HSE_KVS_BULK_BEHIND, EBUSY is returned if the KVS is no longer
+ * empty, including when it holds puts or deletes that have yet to be
+ * ingested from memory.  With it, EBUSY or EAGAIN is returned in the rare case that
+ * compaction has reshaped the KVS such that the load can no longer be
+ * linked behind its data.
+ *
+ * @param bulk: Bulk loader handle from hse_kvs_bulk_create().
+ *
+ * @remark @p bulk must not be NULL.
+ *
+ * @returns Error status.
+ */
+hse_err_t
+hse_kvs_bulk_commit(struct hse_kvs_bulk *bulk);
+
+/** @brief Destroy a bulk loader, discarding any uncommitted data.
+ *
+ * A bulk loader must be destroyed before its KVS is closed.
+ *
+ * @param bulk: Bulk loader handle from hse_kvs_bulk_create() (may be NULL).
+ */
+void
+hse_kvs_bulk_destroy(struct hse_kvs_bulk *bulk);
+
+/** @brief Delete all key-value pairs within a range of keys.
+ *
+ * Deletes every key @p k in @p kvs such that @p kmin <= @p k < @p kmax as
+ * defined by memcmp().  The delete is recorded as a single range tombstone,
+ * so its cost does not depend on the number of keys in the range.  Keys
+ * put after the delete are not affected.  It is not an error if no keys
+ * exist within the range.
+ *
+ * Range deletes are not supported within transactions, and a key deleted
+ * by a range delete may still be reported by hse_kvs_prefix_probe() until
+ * compaction has discarded it.
+ *
+ * @note This function is thread safe.
+ *
+ * <b>Flags:</b>
+ * @arg 0 - Reserved for future use.
+ *
+ * @param kvs: KVS handle from hse_kvdb_kvs_open().
+ * @param flags: Flags for operation specialization.
+ * @param kmin: Smallest key to delete.
+ * @param kmin_len: Length of @p kmin.
+ * @param kmax: First key past the end of the range.
+ * @param kmax_len: Length of @p kmax.
+ *
+ * @remark @p kvs must not be NULL.
+ * @remark @p kmin and @p kmax must not be NULL.
+ * @remark @p kmin_len and @p kmax_len must be within the range of
+ * [1, HSE_KVS_KEY_LEN_MAX].
+ * @remark @p kmin must be less than @p kmax.
+ *
+ * @returns Error status.
+ */
+hse_err_t
+hse_kvs_range_delete(
+    struct hse_kvs *kvs,
+    unsigned int    flags,
+    const void *    kmin,
+    size_t          kmin_len,
+    const void *    kmax,
+    size_t          kmax_len);
+
+/** @brief Put a key-value pair that expires after a time to live.
+ *
+ * Behaves like hse_kvs_put(), except that the value expires @p ttl_sec
+ * seconds after the call (as measured by the system's realtime clock).
+ * Once expired the value behaves as though the key had been deleted:
+ * gets, cursors and prefix probes no longer see it, nor any older value
+ * of the key, and compaction reclaims its space without any further
+ * delete traffic.  A later put of the key is not affected.
+ *
+ * @note This function is thread safe.
+ *
+ * <b>Flags:</b>
+ * @arg HSE_KVS_PUT_PRIO - Operation will not be throttled.
+ * @arg HSE_KVS_PUT_VCOMP_OFF - Value will not be compressed.
+ * @arg HSE_KVS_PUT_SYNC - Operation is durable when the call returns.
+ *
+ * @param kvs: KVS handle from hse_kvdb_kvs_open().
+ * @param flags: Flags for operation specialization.
+ * @param txn: Transaction context (optional).
+ * @param key: Key to put into @p kvs.
+ * @param key_len: Length of @p key.
+ * @param val: Value associated with @p key (optional).
+ * @param val_len: Length of @p value.
+ * @param ttl_sec: Time to live of the value, in seconds.
+ *
+ * @remark @p kvs must not be NULL.
+ * @remark @p key must not be NULL.
+ * @remark @p key_len must be within the range of [1, HSE_KVS_KEY_LEN_MAX].
+ * @remark @p val_len must be within the range of [0, HSE_KVS_VALUE_LEN_MAX].
+ * @remark @p ttl_sec must be greater than zero.
+ *
+ * @returns Error status.
+ */
+hse_err_t
+hse_kvs_put_ttl(
+    struct hse_kvs *     kvs,
+    unsigned int         flags,
+    struct hse_kvdb_txn *txn,
+    const void *         key,
+    size_t               key_len,
+    const void *         val,
+    size_t               val_len,
+    uint64_t             ttl_sec);
+
+/** @brief A key-value pair returned by hse_kvs_cursor_read_batch(). */
+struct hse_kvs_cursor_kv {
+    const void *kv_key;     /**< Key, within the caller's buffer. */
+    size_t      kv_key_len; /**< Length of the key. */
+    const void *kv_val;     /**< Value within the caller's buffer, or NULL. */
+    size_t      kv_val_len; /**< Length of the value. */
+};
+
+/** @brief Iteratively read many key-value pairs from a cursor in one call.
+ *
+ * Copies up to @p kvc consecutive key-value pairs into @p buf and describes
+ * them in @p kvv.  Reading stops early at the end of the cursor or at the
+ * first pair which does not fit in what remains of @p buf, in which case that
+ * pair is returned by the next read.  The merge of the cursor's sources is
+ * performed in a single pass, avoiding the per-pair call overhead of
+ * hse_kvs_cursor_read().
+ *
+ * If @p eof is set then no pairs were read and the cursor is at the end of
+ * its range.
+ *
+ * @note This function is not thread safe.
+ *
+ * <b>Flags:</b>
+ * @arg HSE_CURSOR_READ_KEYS - Copy only keys.  Each value is reported by its
+ * length alone, with kv_val set to NULL.  This is implied for cursors created
+ * with HSE_CURSOR_CREATE_KEYS.
+ *
+ * @param cursor: Cursor handle from hse_kvs_cursor_create().
+ * @param flags: Flags for operation specialization.
+ * @param buf: Buffer into which keys and values are copied.
+ * @param buf_sz: Size of @p buf.
+ * @param[out] kvv: Vector of pairs filled in by the read.
+ * @param kvc: Number of elements in @p kvv.
+ * @param[out] kv_cnt: Number of pairs read.
+ * @param[out] eof: If true, no more key-value pairs in sequence.
+ *
+ * @remark @p cursor must not be NULL.
+ * @remark @p buf, @p kvv, @p kv_cnt and @p eof must not be NULL.
+ * @remark @p kvc must be greater than zero.
+ *
+ * @returns Error status.  ENOSPC if the next pair does not fit in @p buf.
+ */
+hse_err_t
+hse_kvs_cursor_read_batch(
+    struct hse_kvs_cursor *   cursor,
+    unsigned int              flags,
+    void *                    buf,
+    size_t                    buf_sz,
+    struct hse_kvs_cursor_kv *kvv,
+    size_t                    kvc,
+    size_t *                  kv_cnt,
+    bool *                    eof);
+
+/** @brief A key that divides a KVS into slices, see hse_kvs_range_split(). */
+struct hse_kvs_split_key {
+    const void *sk_key;     /**< Smallest key of a slice. */
+    size_t      sk_key_len; /**< Length of the key. */
+};
+
+/** @brief Choose keys that divide a KVS into slices of similar size.
+ *
+ * Chooses up to @p splitc keys, in ascending order, which divide the keys of
+ * the KVS (or only those that match @p filter) into (@p splitc + 1) slices
+ * containing a similar number of keys.  Each split key is the smallest key
+ * of a slice other than the first.  The keys are chosen from a sample of the
+ * keys in the on-media portion of the KVS, so that choosing them reads only a
+ * small fraction of its key data.  Fewer keys are returned if the KVS is too
+ * small to be divided as requested or if @p buf fills up.  A buffer of
+ * (@p splitc * HSE_KVS_KEY_LEN_MAX) bytes is always sufficient.
+ *
+ * The split keys may be passed to hse_kvs_cursor_create_slices() to scan the
+ * slices in parallel.
+ *
+ * @note This function is thread safe.
+ *
+ * @param kvs: KVS handle from hse_kvdb_kvs_open().
+ * @param flags: Flags for operation specialization (reserved for future use).
+ * @param filter: Divide only the keys matching this prefix filter (optional).
+ * @param filter_len: Length of @p filter (optional).
+ * @param buf: Buffer into which the split keys are copied.
+ * @param buf_sz: Size of @p buf.
+ * @param[out] splitv: Vector of split keys.
+ * @param splitc: Number of elements in @p splitv.
+ * @param[out] split_cnt: Number of split keys chosen.
+ *
+ * @remark @p kvs, @p splitv and @p split_cnt must not be NULL.
+ * @remark @p flags must be zero.
+ *
+ * @returns Error status
+ */
+hse_err_t
+hse_kvs_range_split(
+    struct hse_kvs *          kvs,
+    unsigned int              flags,
+    const void *              filter,
+    size_t                    filter_len,
+    void *                    buf,
+    size_t                    buf_sz,
+    struct hse_kvs_split_key *splitv,
+    size_t                    splitc,
+    size_t *                  split_cnt);
+
+/** @brief Create a set of cursors, each bounded to one slice of a KVS.
+ *
+ * Creates (@p splitc + 1) cursors which share a single view of the KVS.
+ * Cursor i is positioned at split key (i - 1), or at the start of the KVS
+ * for the first cursor, and reaches eof just before split key i, or at the
+ * end of the KVS for the last cursor.  Each cursor may be read from a
+ * different thread, such that together they scan the KVS in parallel.  Each
+ * cursor must be destroyed with hse_kvs_cursor_destroy().  A seek drops the
+ * bound of a cursor unless it is supplied again via
+ * hse_kvs_cursor_seek_range().
+ *
+ * @note This function is thread safe.
+ *
+ * <b>Flags:</b>
+ * @arg HSE_CURSOR_CREATE_KEYS - Create keys-only cursors.
+ *
+ * @param kvs: KVS handle from hse_kvdb_kvs_open().
+ * @param flags: Flags for operation specialization.
+ * @param filter: Iteration limited to keys matching this prefix filter
+ * (optional).
+ * @param filter_len: Length of @p filter (optional).
+ * @param splitv: Split keys in strictly ascending order, each matching
+ * @p filter (e.g., from hse_kvs_range_split()).
+ * @param splitc: Number of elements in @p splitv.
+ * @param[out] cursorv: Vector of (@p splitc + 1) cursor handles.
+ *
+ * @remark @p kvs and @p cursorv must not be NULL.
+ * @remark Reverse cursors are not supported.
+ *
+ * @returns Error status
+ */
+hse_err_t
+hse_kvs_cursor_create_slices(
+    struct hse_kvs *                kvs,
+    unsigned int                    flags,
+    const void *                    filter,
+    size_t                          filter_len,
+    const struct hse_kvs_split_key *splitv,
+    size_t                          splitc,
+    struct hse_kvs_cursor **        cursorv);
+
 /**@} KVS */
 
 #pragma GCC visibility pop
@@ -568,6 +568,56 @@ hse_kvs_get(
     size_t               buf_len,
     size_t *             val_len);
 
+/** @brief Retrieve the values for a batch of keys from the KVS.
+ *
+ * Semantically equivalent to calling hse_kvs_get() once for each of the @p
+ * count keys, except that all keys are retrieved from the same view of the
+ * KVS and the lookups are performed together so that data structures shared
+ * by many keys (e.g., the bloom filters and indexes of the same on-media
+ * kvset) are visited once per batch rather than once per key. The i-th
+ * element of each array argument describes the i-th key. See @ref
+ * TRANSACTIONS for information on how gets within transactions are handled.
+ *
+ * @note This function is thread safe.
+ *
+ * <b>Flags:</b>
+ * @arg 0 - Reserved for future use.
+ *
+ * @param kvs: KVS handle from hse_kvdb_kvs_open().
+ * @param flags: Flags for operation specialization.
+ * @param txn: Transaction context (optional).
+ * @param count: Number of keys in the batch.
+ * @param keys: Keys to get from @p kvs.
+ * @param key_lens: Lengths of @p keys.
+ * @param[out] found: Whether or not each key was found.
+ * @param[in,out] bufs: Buffers into which the values associated with @p keys
+ * will be copied (optional).
+ * @param buf_lens: Lengths of @p bufs (optional if @p bufs is NULL).
+ * @param[out] val_lens: Actual length of each value whose key was found.
+ *
+ * @remark @p kvs must not be NULL.
+ * @remark @p count must be within the range of [1, HSE_KVS_GET_MULTI_MAX].
+ * @remark @p keys and each of its elements must not be NULL.
+ * @remark @p key_lens must not be NULL and each of its elements must be within
+ * the range of [1, HSE_KVS_KEY_LEN_MAX].
+ * @remark @p found must not be NULL.
+ * @remark @p val_lens must not be NULL.
+ *
+ * @returns Error status.
+ */
+hse_err_t
+hse_kvs_get_multi(
+    struct hse_kvs *      kvs,
+    unsigned int          flags,
+    struct hse_kvdb_txn * txn,
+    unsigned int          count,
+    const void *const *   keys,
+    const size_t *        key_lens,
+    bool *                found,
+    void *const *         bufs,
+    const size_t *        buf_lens,
+    size_t *              val_lens);
+
 /** @brief Get the name of a KVS.
  *
  * @note This function is thread safe.
@@ -668,13 +718,25 @@ hse_kvs_prefix_delete(
  *
  * If compression is enabled for the given kvs, then hse_kvs_put() will attempt
  * to compress the value unless the HSE_KVS_PUT_VCOMP_OFF flag is given.
- * Otherwise, the HSE_KVS_PUT_VCOMP_OFF flag is ignored.
+ * Otherwise, the HSE_KVS_PUT_VCOMP_OFF flag is ignored.  If compression is
+ * deferred (compression.value.defer), then values are stored uncompressed by
+ * hse_kvs_put() and are compressed later by background compaction, in which
+ * case the HSE_KVS_PUT_VCOMP_OFF flag has no effect.
+ *
+ * If the HSE_KVS_PUT_SYNC flag is given and @p txn is NULL, then
+ * hse_kvs_put() does not return until the put is durable on media.
+ * Concurrent sync puts are grouped into a single journal write.  If the
+ * durability.sync_latency_us parameter is set, that write is delayed while
+ * several sync puts are waiting so that more of them can join it, within
+ * the given latency target.  Within a transaction the flag is ignored, as durability is
+ * determined at commit.  The flag has no effect if durability is disabled.
  *
  * @note This function is thread safe.
  *
  * <b>Flags:</b>
  * @arg HSE_KVS_PUT_PRIO - Operation will not be throttled.
  * @arg HSE_KVS_PUT_VCOMP_OFF - Value will not be compressed.
+ * @arg HSE_KVS_PUT_SYNC - Operation is durable when the call returns.
  *
  * @param kvs: KVS handle from hse_kvdb_kvs_open().
  * @param flags: Flags for operation specialization.
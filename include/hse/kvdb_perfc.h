@@ -94,6 +94,8 @@ enum kvdb_perfc_sidx_sp3 {
     PERFC_BA_SP3_LSIZE_TARG,
     PERFC_BA_SP3_RSIZE_CURR,
     PERFC_BA_SP3_RSIZE_TARG,
+    PERFC_BA_SP3_WAMP,
+    PERFC_BA_SP3_RAMP,
     PERFC_EN_SP3
 };
 
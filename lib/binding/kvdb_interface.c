@@ -29,6 +29,7 @@
 #include <hse_util/rest_api.h>
 #include <hse_util/logging.h>
 #include <hse_util/vlb.h>
+#include <hse_util/keycmp.h>
 
 #include <bsd/libutil.h>
 #include <bsd/string.h>
@@ -37,8 +38,9 @@
 /* clang-format off */
 
 #define HSE_KVDB_SYNC_MASK     (HSE_KVDB_SYNC_ASYNC)
-#define HSE_KVS_PUT_MASK       (HSE_KVS_PUT_PRIO | HSE_KVS_PUT_VCOMP_OFF)
-#define HSE_CURSOR_CREATE_MASK (HSE_CURSOR_CREATE_REV)
+#define HSE_KVS_PUT_MASK       (HSE_KVS_PUT_PRIO | HSE_KVS_PUT_VCOMP_OFF | HSE_KVS_PUT_SYNC)
+#define HSE_CURSOR_CREATE_MASK (HSE_CURSOR_CREATE_REV | HSE_CURSOR_CREATE_KEYS)
+#define HSE_KVS_BULK_MASK      (HSE_KVS_BULK_BEHIND)
 
 /* clang-format on */
 
@@ -794,6 +796,347 @@ hse_kvs_get(
     return 0;
 }
 
+hse_err_t
+hse_kvs_get_multi(
+    struct hse_kvs *           handle,
+    const unsigned int         flags,
+    struct hse_kvdb_txn *const txn,
+    const unsigned int         count,
+    const void *const *        keys,
+    const size_t *             key_lens,
+    bool *                     found,
+    void *const *              bufs,
+    const size_t *             buf_lens,
+    size_t *                   val_lens)
+{
+    struct kvs_ktuple *  ktv;
+    struct kvs_buf *     vbufv;
+    enum key_lookup_res *resv;
+    size_t               sz, vlen_tot;
+    merr_t               err;
+    unsigned int         i;
+
+    if (HSE_UNLIKELY(!handle || !keys || !key_lens || !found || !val_lens || flags != 0))
+        return merr(EINVAL);
+
+    if (HSE_UNLIKELY(count == 0 || count > HSE_KVS_GET_MULTI_MAX))
+        return merr(EINVAL);
+
+    if (HSE_UNLIKELY(bufs && !buf_lens))
+        return merr(EINVAL);
+
+    for (i = 0; i < count; ++i) {
+        if (HSE_UNLIKELY(!keys[i]))
+            return merr(EINVAL);
+
+        if (HSE_UNLIKELY(bufs && !bufs[i] && buf_lens[i] > 0))
+            return merr(EINVAL);
+
+        if (HSE_UNLIKELY(key_lens[i] > HSE_KVS_KEY_LEN_MAX))
+            return merr(ENAMETOOLONG);
+
+        if (HSE_UNLIKELY(key_lens[i] == 0))
+            return merr(ENOENT);
+    }
+
+    sz = count * (sizeof(*ktv) + sizeof(*vbufv) + sizeof(*resv));
+
+    ktv = malloc(sz);
+    if (ev(!ktv))
+        return merr(ENOMEM);
+
+    vbufv = (void *)(ktv + count);
+    resv = (void *)(vbufv + count);
+
+    for (i = 0; i < count; ++i) {
+        void *valbuf = bufs ? bufs[i] : NULL;
+        size_t valbuf_sz = bufs ? buf_lens[i] : 0;
+
+        /* See hse_kvs_get() for why a NULL buffer is replaced with a
+         * non-NULL sentinel when probing for existence.
+         */
+        if (!valbuf && valbuf_sz == 0)
+            valbuf = (void *)-1;
+
+        kvs_ktuple_init_nohash(ktv + i, keys[i], key_lens[i]);
+        kvs_buf_init(vbufv + i, valbuf, valbuf_sz);
+    }
+
+    err = ikvdb_kvs_get_multi(handle, flags, txn, ktv, resv, vbufv, count);
+    if (ev(err))
+        goto out;
+
+    vlen_tot = 0;
+
+    for (i = 0; i < count; ++i) {
+        if (ev(resv[i] == FOUND_MULTIPLE)) {
+            err = merr(EPROTO);
+            goto out;
+        }
+
+        found[i] = (resv[i] == FOUND_VAL);
+        val_lens[i] = vbufv[i].b_len;
+
+        if (found[i])
+            vlen_tot += val_lens[i];
+    }
+
+    perfc_add2(&kvdb_pc, PERFC_RA_KVDBOP_KVS_GET, count, PERFC_RA_KVDBOP_KVS_GETB, vlen_tot);
+
+out:
+    free(ktv);
+
+    return err;
+}
+
+struct hse_kvs_pin {
+    struct kvs_vpin kp_vpin;
+};
+
+hse_err_t
+hse_kvs_get_pinned(
+    struct hse_kvs *           handle,
+    const unsigned int         flags,
+    struct hse_kvdb_txn *const txn,
+    const void *               key,
+    size_t                     key_len,
+    bool *                     found,
+    void *                     valbuf,
+    size_t                     valbuf_sz,
+    const void **              val,
+    size_t *                   val_len,
+    struct hse_kvs_pin **      pin)
+{
+    struct kvs_ktuple   kt;
+    struct kvs_buf      vbuf;
+    struct kvs_vpin     vpin = {};
+    struct hse_kvs_pin *p;
+    enum key_lookup_res res;
+    void *              buf;
+    merr_t              err;
+
+    if (HSE_UNLIKELY(!handle || !key || !found || !val || !val_len || !pin || flags != 0))
+        return merr(EINVAL);
+
+    if (HSE_UNLIKELY(!valbuf && valbuf_sz > 0))
+        return merr(EINVAL);
+
+    if (HSE_UNLIKELY(key_len > HSE_KVS_KEY_LEN_MAX))
+        return merr(ENAMETOOLONG);
+
+    if (HSE_UNLIKELY(key_len == 0))
+        return merr(ENOENT);
+
+    *val = NULL;
+    *pin = NULL;
+
+    /* See hse_kvs_get() for why a NULL buffer is replaced with a
+     * non-NULL sentinel when probing for existence.
+     */
+    buf = (!valbuf && valbuf_sz == 0) ? (void *)-1 : valbuf;
+
+    kvs_ktuple_init_nohash(&kt, key, key_len);
+    kvs_buf_init(&vbuf, buf, valbuf_sz);
+    vbuf.b_pin = &vpin;
+
+    err = ikvdb_kvs_get(handle, flags, txn, &kt, &res, &vbuf);
+    if (ev(err)) {
+        kvs_buf_unpin(&vbuf);
+        return err;
+    }
+
+    *found = (res == FOUND_VAL);
+    *val_len = vbuf.b_len;
+
+    if (ev(res == FOUND_MULTIPLE)) {
+        kvs_buf_unpin(&vbuf);
+        return merr(EPROTO);
+    }
+
+    if (vpin.vp_release) {
+        p = malloc(sizeof(*p));
+        if (p) {
+            p->kp_vpin = vpin;
+            *val = vpin.vp_data;
+            *pin = p;
+        } else {
+            /* Fall back to copying the value out if we can't allocate
+             * a pin handle.
+             */
+            if (valbuf_sz > 0)
+                memcpy(valbuf, vpin.vp_data, min_t(size_t, valbuf_sz, vbuf.b_len));
+            kvs_buf_unpin(&vbuf);
+            *val = valbuf;
+        }
+    } else if (*found) {
+        *val = valbuf;
+    }
+
+    PERFC_INCADD_RU(
+        &kvdb_pc, PERFC_RA_KVDBOP_KVS_GET, PERFC_RA_KVDBOP_KVS_GETB, *found ? *val_len : 0);
+
+    return 0;
+}
+
+void
+hse_kvs_pin_release(struct hse_kvs_pin *pin)
+{
+    if (!pin)
+        return;
+
+    pin->kp_vpin.vp_release(pin->kp_vpin.vp_arg);
+    free(pin);
+}
+
+hse_err_t
+hse_kvs_bulk_create(struct hse_kvs *handle, const unsigned int flags, struct hse_kvs_bulk **bulk)
+{
+    merr_t err;
+
+    if (HSE_UNLIKELY(!handle || !bulk || flags & ~HSE_KVS_BULK_MASK))
+        return merr(EINVAL);
+
+    err = ikvdb_kvs_bulk_create(handle, flags, bulk);
+    ev(err);
+
+    return err;
+}
+
+hse_err_t
+hse_kvs_bulk_put(
+    struct hse_kvs_bulk *bulk,
+    const void *         key,
+    size_t               key_len,
+    const void *         val,
+    size_t               val_len)
+{
+    struct kvs_ktuple kt;
+    struct kvs_vtuple vt;
+    merr_t            err;
+
+    if (HSE_UNLIKELY(!bulk || !key || (val_len > 0 && !val)))
+        return merr(EINVAL);
+
+    if (HSE_UNLIKELY(key_len > HSE_KVS_KEY_LEN_MAX))
+        return merr(ENAMETOOLONG);
+
+    if (HSE_UNLIKELY(key_len == 0))
+        return merr(ENOENT);
+
+    if (HSE_UNLIKELY(val_len > HSE_KVS_VALUE_LEN_MAX))
+        return merr(EMSGSIZE);
+
+    kvs_ktuple_init_nohash(&kt, key, key_len);
+    kvs_vtuple_init(&vt, (void *)val, val_len);
+
+    err = ikvdb_kvs_bulk_put(bulk, &kt, &vt);
+    ev(err);
+
+    return err;
+}
+
+hse_err_t
+hse_kvs_bulk_commit(struct hse_kvs_bulk *bulk)
+{
+    merr_t err;
+
+    if (HSE_UNLIKELY(!bulk))
+        return merr(EINVAL);
+
+    err = ikvdb_kvs_bulk_commit(bulk);
+    ev(err);
+
+    return err;
+}
+
+void
+hse_kvs_bulk_destroy(struct hse_kvs_bulk *bulk)
+{
+    ikvdb_kvs_bulk_destroy(bulk);
+}
+
+hse_err_t
+hse_kvs_range_delete(
+    struct hse_kvs *   handle,
+    const unsigned int flags,
+    const void *       kmin,
+    size_t             kmin_len,
+    const void *       kmax,
+    size_t             kmax_len)
+{
+    struct kvs_ktuple kt, kt_end;
+    merr_t            err;
+    int               rc;
+
+    if (HSE_UNLIKELY(!handle || !kmin || !kmax || flags != 0))
+        return merr(EINVAL);
+
+    if (HSE_UNLIKELY(kmin_len > HSE_KVS_KEY_LEN_MAX || kmax_len > HSE_KVS_KEY_LEN_MAX))
+        return merr(ENAMETOOLONG);
+
+    if (HSE_UNLIKELY(kmin_len == 0 || kmax_len == 0))
+        return merr(EINVAL);
+
+    rc = keycmp(kmin, kmin_len, kmax, kmax_len);
+    if (HSE_UNLIKELY(rc >= 0))
+        return merr(EINVAL);
+
+    kvs_ktuple_init_nohash(&kt, kmin, kmin_len);
+    kvs_ktuple_init_nohash(&kt_end, kmax, kmax_len);
+
+    err = ikvdb_kvs_range_delete(handle, flags, &kt, &kt_end);
+    ev(err);
+
+    return err;
+}
+
+hse_err_t
+hse_kvs_put_ttl(
+    struct hse_kvs *           handle,
+    const unsigned int         flags,
+    struct hse_kvdb_txn *const txn,
+    const void *               key,
+    size_t                     key_len,
+    const void *               val,
+    size_t                     val_len,
+    uint64_t                   ttl_sec)
+{
+    struct kvs_ktuple kt;
+    struct kvs_vtuple vt;
+    struct timespec   ts;
+    merr_t            err;
+
+    if (HSE_UNLIKELY(!handle || !key || (val_len > 0 && !val) || flags & ~HSE_KVS_PUT_MASK))
+        return merr(EINVAL);
+
+    if (HSE_UNLIKELY(key_len > HSE_KVS_KEY_LEN_MAX))
+        return merr(ENAMETOOLONG);
+
+    if (HSE_UNLIKELY(key_len == 0))
+        return merr(ENOENT);
+
+    if (HSE_UNLIKELY(val_len > HSE_KVS_VALUE_LEN_MAX))
+        return merr(EMSGSIZE);
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+
+    if (HSE_UNLIKELY(ttl_sec == 0 || ttl_sec > HG64_MAX - ts.tv_sec))
+        return merr(EINVAL);
+
+    kvs_ktuple_init_nohash(&kt, key, key_len);
+    kvs_vtuple_init(&vt, (void *)val, val_len);
+    vt.vt_expire = ts.tv_sec + ttl_sec;
+
+    err = ikvdb_kvs_put(handle, flags, txn, &kt, &vt);
+    ev(err);
+
+    if (!err)
+        PERFC_INCADD_RU(
+            &kvdb_pc, PERFC_RA_KVDBOP_KVS_PUT, PERFC_RA_KVDBOP_KVS_PUTB, key_len + val_len);
+
+    return err;
+}
+
 /**
  * hse_kvs_delete() - remove the supplied key and associated value from the KVS
  */
@@ -1119,6 +1462,55 @@ hse_kvs_cursor_create(
     return err;
 }
 
+hse_err_t
+hse_kvs_range_split(
+    struct hse_kvs *          handle,
+    const unsigned int        flags,
+    const void *              filter,
+    size_t                    filter_len,
+    void *                    buf,
+    size_t                    buf_sz,
+    struct hse_kvs_split_key *splitv,
+    size_t                    splitc,
+    size_t *                  split_cnt)
+{
+    merr_t err;
+
+    if (HSE_UNLIKELY(!handle || !splitv || !split_cnt || (filter_len && !filter) ||
+                     (buf_sz && !buf) || flags != 0))
+        return merr(EINVAL);
+
+    err = ikvdb_kvs_range_split(handle, filter, filter_len, buf, buf_sz, splitv, splitc, split_cnt);
+    ev(err);
+
+    return err;
+}
+
+hse_err_t
+hse_kvs_cursor_create_slices(
+    struct hse_kvs *                handle,
+    const unsigned int              flags,
+    const void *                    filter,
+    size_t                          filter_len,
+    const struct hse_kvs_split_key *splitv,
+    size_t                          splitc,
+    struct hse_kvs_cursor **        cursorv)
+{
+    merr_t err;
+
+    if (HSE_UNLIKELY(!handle || !cursorv || (splitc && !splitv) || (filter_len && !filter) ||
+                     flags & ~HSE_CURSOR_CREATE_MASK))
+        return merr(EINVAL);
+
+    PERFC_INC_RU(&kvdb_pc, PERFC_RA_KVDBOP_KVS_CURSOR_CREATE);
+
+    err = ikvdb_kvs_cursor_create_slices(
+        handle, flags, filter, filter_len, splitv, splitc, cursorv);
+    ev(err);
+
+    return err;
+}
+
 hse_err_t
 hse_kvs_cursor_update_view(struct hse_kvs_cursor *cursor, const unsigned int flags)
 {
@@ -1267,6 +1659,42 @@ hse_kvs_cursor_read_copy(
     return err;
 }
 
+hse_err_t
+hse_kvs_cursor_read_batch(
+    struct hse_kvs_cursor *   cursor,
+    unsigned int              flags,
+    void *                    buf,
+    size_t                    buf_sz,
+    struct hse_kvs_cursor_kv *kvv,
+    size_t                    kvc,
+    size_t *                  kv_cnt,
+    bool *                    eof)
+{
+    merr_t err;
+
+    if (HSE_UNLIKELY(!cursor || !buf || !kvv || !kvc || !kv_cnt || !eof))
+        return merr(EINVAL);
+
+    if (HSE_UNLIKELY(flags & ~HSE_CURSOR_READ_KEYS))
+        return merr(EINVAL);
+
+    *kv_cnt = 0;
+
+    err = ikvdb_kvs_cursor_read_batch(cursor, flags, buf, buf_sz, kvv, kvc, kv_cnt, eof);
+    ev(err);
+
+    if (*kv_cnt > 0) {
+        size_t len = 0;
+        size_t i;
+
+        for (i = 0; i < *kv_cnt; i++)
+            len += kvv[i].kv_key_len + (kvv[i].kv_val ? kvv[i].kv_val_len : 0);
+
+        PERFC_INCADD_RU(&kvdb_pc, PERFC_RA_KVDBOP_KVS_CURSOR_READ, PERFC_RA_KVDBOP_KVS_GETB, len);
+    }
+
+    return err;
+}
 
 hse_err_t
 hse_kvs_cursor_destroy(struct hse_kvs_cursor *cursor)
@@ -127,6 +127,19 @@ c0_prefix_del(struct c0 *handle, struct kvs_ktuple *kt, uintptr_t seqnoref)
     return c0sk_prefix_del(self->c0_c0sk, self->c0_index, kt, seqnoref);
 }
 
+merr_t
+c0_range_del(
+    struct c0 *        handle,
+    struct kvs_ktuple *kt,
+    struct kvs_ktuple *kt_end,
+    uintptr_t          seqnoref)
+{
+    struct c0_impl *self = c0_h2r(handle);
+
+    assert(self->c0_index < HSE_KVS_COUNT_MAX);
+    return c0sk_range_del(self->c0_c0sk, self->c0_index, kt, kt_end, seqnoref);
+}
+
 /*
  * Tombstone indicated by:
  *     return value == 0 && res == FOUND_TOMB
@@ -281,6 +294,12 @@ c0_cursor_prepare(struct c0_cursor *cur)
     c0sk_cursor_prepare(cur);
 }
 
+merr_t
+c0_cursor_rtombs(struct c0_cursor *c0cur, rtomb_visit_fn *visit, void *arg)
+{
+    return c0sk_cursor_rtombs(c0cur, visit, arg);
+}
+
 void
 c0_cursor_bind_txn(struct c0_cursor *c0cur, struct kvdb_ctxn *ctxn)
 {
@@ -19,6 +19,32 @@
 
 /* clang-format off */
 
+/**
+ * struct c0_ingest_part - a key range of one kvs to be built by one kvset builder
+ * @cip_ingest:   ingest work to which this partition belongs
+ * @cip_bldr:     kvset builder for this partition
+ * @cip_start:    index of the partition's first entry in the merged cn list
+ * @cip_end:      index one past the partition's last entry
+ * @cip_vgroup:   vgroup ID for the partition's vblocks
+ * @cip_skidx:    index of the kvs to which the entries belong
+ * @cip_partidx:  index of this partition among those of its kvs
+ * @cip_partc:    number of partitions of its kvs
+ * @cip_vblkc:    number of vblocks written by the value pass
+ * @cip_err:      first error encountered while building the partition
+ */
+struct c0_ingest_part {
+    struct c0_ingest_work *cip_ingest;
+    struct kvset_builder  *cip_bldr;
+    size_t                 cip_start;
+    size_t                 cip_end;
+    u64                    cip_vgroup;
+    u16                    cip_skidx;
+    u16                    cip_partidx;
+    u16                    cip_partc;
+    uint                   cip_vblkc;
+    merr_t                 cip_err;
+};
+
 /**
  * struct c0_ingest_work - description of ingest work to be performed
  * @c0iw_c0:            struct c0 in whose context the ingest is occuring
@@ -26,7 +52,8 @@
  * @c0iw_sources:
  * @c0iw_kvms_iterv:
  * @c0iw_coalscedbldrs:
- * @c0iw_bldrs:
+ * @c0iw_partv:         vector of partitions to be built
+ * @c0iw_partc:         number of partitions in c0iw_partv
  * @c0iw_mblocks:
  * @c0iw_c0kvms:        struct c0_kvmultiset being ingested
  * @c0iw_c0:
@@ -45,7 +72,8 @@ struct c0_ingest_work {
     struct c0_kvset_iterator c0iw_kvms_iterv[HSE_C0_INGEST_WIDTH_MAX];
     struct lc_ingest_iter    c0iw_lc_iterv[LC_SOURCE_CNT_MAX];
     struct element_source   *c0iw_lc_sourcev[LC_SOURCE_CNT_MAX];
-    struct kvset_builder    *c0iw_bldrs[HSE_KVS_COUNT_MAX];
+    struct c0_ingest_part   *c0iw_partv;
+    uint                     c0iw_partc;
     struct kvset_mblocks     c0iw_mblocks[HSE_KVS_COUNT_MAX];
     struct c0_kvmultiset    *c0iw_c0kvms;
     u32                      c0iw_kvms_iterc;
@@ -182,10 +182,26 @@ c0kvs_ior_stats(
  *   if (kvms_seqno != HSE_SQNREF_INVALID):
  *     s = kvms_seqno
  */
+static HSE_ALWAYS_INLINE u64
+c0kvs_seqno_get(struct c0_kvset_impl *c0kvs, bool inc)
+{
+    atomic_ulong *sref = c0kvs->c0s_kvdb_seqno;
+    u64 seq;
+
+    seq = inc ? atomic_inc_return(sref) : atomic_read(sref);
+
+    /* If KVMS seqno is valid, use it. */
+    if (HSE_UNLIKELY(atomic_read(c0kvs->c0s_kvms_seqno) != HSE_SQNREF_INVALID)) {
+        sref = c0kvs->c0s_kvms_seqno;
+        seq = inc ? atomic_inc_return(sref) : atomic_read(sref);
+    }
+
+    return seq;
+}
+
 static u64
 c0kvs_seqno_set(struct c0_kvset_impl *c0kvs, struct bonsai_val *bv)
 {
-    atomic_ulong *sref = c0kvs->c0s_kvdb_seqno;
     u64 seq;
 
     /* [HSE_REVISIT]
@@ -203,13 +219,7 @@ c0kvs_seqno_set(struct c0_kvset_impl *c0kvs, struct bonsai_val *bv)
      * have changed.
      */
 
-    seq = HSE_CORE_IS_PTOMB(bv->bv_value) ? atomic_inc_return(sref) : atomic_read(sref);
-
-    /* If KVMS seqno is valid, use it. */
-    if (HSE_UNLIKELY(atomic_read(c0kvs->c0s_kvms_seqno) != HSE_SQNREF_INVALID)) {
-        sref = c0kvs->c0s_kvms_seqno;
-        seq = HSE_CORE_IS_PTOMB(bv->bv_value) ? atomic_inc_return(sref) : atomic_read(sref);
-    }
+    seq = c0kvs_seqno_get(c0kvs, HSE_CORE_IS_PTOMB(bv->bv_value));
 
     bv->bv_seqnoref = HSE_ORDNL_TO_SQNREF(seq);
 
@@ -467,7 +477,9 @@ c0kvs_create(
     set->c0s_alloc_sz = alloc_sz;
     set->c0s_cheap = cheap;
     atomic_set(&set->c0s_finalized, 0);
-    mutex_init(&set->c0s_mutex);
+    mutex_init_adaptive(&set->c0s_mutex);
+    set->c0s_putreqs = NULL;
+    set->c0s_rtombs = NULL;
 
     err = bn_create(cheap, c0kvs_ior_cb, set, &set->c0s_broot);
     if (ev(err)) {
@@ -535,6 +547,7 @@ c0kvs_reset(struct c0_kvset *handle, size_t sz)
 
     bn_reset(set->c0s_broot);
 
+    set->c0s_rtombs = NULL;
     atomic_set(&set->c0s_finalized, 0);
     set->c0s_num_entries = 0;
     set->c0s_num_tombstones = 0;
@@ -570,6 +583,65 @@ c0kvs_alloc(struct c0_kvset *handle, size_t align, size_t sz)
     return mem;
 }
 
+/**
+ * struct c0kvs_putreq - a put request published to the c0kvs mutex holder
+ * @pr_next:  c0s_putreqs stack linkage
+ * @pr_skey:  key to insert
+ * @pr_sval:  value to insert
+ * @pr_err:   result of bn_insert_or_replace()
+ * @pr_done:  set (with release semantics) once the request has been applied
+ *
+ * Under heavy contention handing off the c0kvs mutex between threads
+ * (and migrating the bonsai tree's hot cache lines along with it) costs
+ * far more than the insert itself.  So rather than queue up on the mutex,
+ * a put that cannot immediately acquire it pushes a request onto a
+ * lock-free stack and spins until either the current mutex holder has
+ * applied the request on its behalf or it acquires the mutex itself.
+ * The requests live on the callers' stacks.
+ */
+struct c0kvs_putreq {
+    struct c0kvs_putreq *pr_next;
+    struct bonsai_skey  *pr_skey;
+    struct bonsai_sval  *pr_sval;
+    merr_t               pr_err;
+    atomic_int           pr_done;
+};
+
+/* Maximum number of times the mutex holder will drain the request
+ * stack before releasing the mutex, so as to bound its latency.
+ */
+#define C0KVS_COMBINE_PASSES_MAX (4)
+
+static void
+c0kvs_combine(struct c0_kvset_impl *self)
+{
+    struct c0kvs_putreq *head, *prev, *next;
+    int                  passes;
+
+    for (passes = 0; passes < C0KVS_COMBINE_PASSES_MAX; ++passes) {
+        do {
+            head = self->c0s_putreqs;
+            if (!head)
+                return;
+        } while (!atomic_cas(&self->c0s_putreqs, head, NULL));
+
+        /* Reverse the stack to apply the requests in arrival order.
+         */
+        for (prev = NULL; head; head = next) {
+            next = head->pr_next;
+            head->pr_next = prev;
+            prev = head;
+        }
+
+        for (head = prev; head; head = next) {
+            next = head->pr_next;
+
+            head->pr_err = bn_insert_or_replace(self->c0s_broot, head->pr_skey, head->pr_sval);
+            atomic_set_rel(&head->pr_done, 1);
+        }
+    }
+}
+
 static merr_t
 c0kvs_putdel(
     struct c0_kvset_impl *self,
@@ -577,12 +649,45 @@ c0kvs_putdel(
     struct bonsai_sval   *sval,
     u64                  *seqno)
 {
-    merr_t err;
+    struct c0kvs_putreq req;
+    merr_t              err;
+
+    if (mutex_trylock(&self->c0s_mutex)) {
+        err = bn_insert_or_replace(self->c0s_broot, skey, sval);
+        c0kvs_combine(self);
+        c0kvs_unlock(self);
+        goto out;
+    }
 
-    c0kvs_lock(self);
-    err = bn_insert_or_replace(self->c0s_broot, skey, sval);
-    c0kvs_unlock(self);
+    req.pr_skey = skey;
+    req.pr_sval = sval;
+    req.pr_err = 0;
+    atomic_set(&req.pr_done, 0);
+
+    do {
+        req.pr_next = self->c0s_putreqs;
+    } while (!atomic_cas(&self->c0s_putreqs, req.pr_next, &req));
+
+    /* Each waiter either has its request applied by the mutex holder
+     * or eventually acquires the mutex itself and drains the stack
+     * (which includes its own request), so no request is ever left
+     * stranded on the stack.
+     */
+    while (!atomic_read_acq(&req.pr_done)) {
+        if (mutex_trylock(&self->c0s_mutex)) {
+            c0kvs_combine(self);
+            c0kvs_unlock(self);
+
+            assert(atomic_read(&req.pr_done));
+            break;
+        }
+
+        cpu_relax();
+    }
+
+    err = req.pr_err;
 
+out:
     /* Callers putting keys into the active kvms must hold the
      * RCU read lock.  As such, a c0kvset undergoing ingest will
      * be finalized (i.e., frozen) the end of the grace period,
@@ -611,6 +716,7 @@ c0kvs_put(
 
     bn_skey_init(kt->kt_data, kt->kt_len, kt->kt_flags, skidx, &skey);
     bn_sval_init(vt->vt_data, vt->vt_xlen, seqnoref, &sval);
+    sval.bsv_expire = vt->vt_expire;
 
     return c0kvs_putdel(self, &skey, &sval, &kt->kt_seqno);
 }
@@ -645,6 +751,88 @@ c0kvs_prefix_del(
     return c0kvs_putdel(self, &skey, &sval, &key->kt_seqno);
 }
 
+merr_t
+c0kvs_range_del(
+    struct c0_kvset *  handle,
+    u16                skidx,
+    struct kvs_ktuple *kt,
+    struct kvs_ktuple *kt_end,
+    uintptr_t          seqnoref)
+{
+    struct c0_kvset_impl *self = c0_kvset_h2r(handle);
+    struct c0_rtomb *     rt;
+    size_t                sz;
+
+    sz = sizeof(*rt) + kt->kt_len + kt_end->kt_len;
+
+    c0kvs_lock(self);
+    rt = cheap_memalign(self->c0s_cheap, alignof(*rt), sz);
+    if (ev(!rt)) {
+        c0kvs_unlock(self);
+        return merr(ENOMEM);
+    }
+
+    rt->rt_skidx = skidx;
+    rt->rt_slen = kt->kt_len;
+    rt->rt_elen = kt_end->kt_len;
+    memcpy(rt->rt_data, kt->kt_data, kt->kt_len);
+    memcpy(rt->rt_data + kt->kt_len, kt_end->kt_data, kt_end->kt_len);
+
+    /* Like a ptomb, a range tombstone takes the next seqno such that
+     * keys put after it can be distinguished from those it deletes.
+     */
+    if (HSE_SQNREF_ORDNL_P(seqnoref))
+        rt->rt_seqno = HSE_SQNREF_TO_ORDNL(seqnoref);
+    else
+        rt->rt_seqno = c0kvs_seqno_get(self, true);
+
+    rt->rt_next = self->c0s_rtombs;
+    rcu_assign_pointer(self->c0s_rtombs, rt);
+
+    ++self->c0s_num_entries;
+    ++self->c0s_num_tombstones;
+    self->c0s_keyb += kt->kt_len + kt_end->kt_len;
+    self->c0s_memsz += sz;
+    c0kvs_unlock(self);
+
+    assert(atomic_read(&self->c0s_finalized) == 0);
+
+    kt->kt_seqno = rt->rt_seqno;
+
+    return 0;
+}
+
+struct c0_rtomb *
+c0kvs_rtombs_get(struct c0_kvset *handle)
+{
+    struct c0_kvset_impl *self = c0_kvset_h2r(handle);
+
+    return rcu_dereference(self->c0s_rtombs);
+}
+
+u64
+c0kvs_rtomb_seqno(struct c0_kvset *handle, u16 skidx, const struct kvs_ktuple *kt, u64 view_seqno)
+{
+    struct c0_rtomb *crt;
+    struct key_obj   kobj;
+    u64              seq = 0;
+
+    key2kobj(&kobj, kt->kt_data, kt->kt_len);
+
+    for (crt = c0kvs_rtombs_get(handle); crt; crt = rcu_dereference(crt->rt_next)) {
+        struct rtomb rt;
+
+        if (crt->rt_skidx != skidx || crt->rt_seqno <= seq || crt->rt_seqno > view_seqno)
+            continue;
+
+        c0_rtomb_get(crt, &rt);
+        if (rtomb_covers(&rt, &kobj))
+            seq = crt->rt_seqno;
+    }
+
+    return seq;
+}
+
 u64
 c0kvs_get_element_count(struct c0_kvset *handle)
 {
@@ -725,7 +913,7 @@ c0kvs_get_excl(
 
     *oseqnoref = val->bv_seqnoref;
 
-    if (HSE_CORE_IS_TOMB(val->bv_value)) {
+    if (HSE_CORE_IS_TOMB(val->bv_value) || kvs_expired(val->bv_expire)) {
         *res = FOUND_TMB;
         return 0;
     }
@@ -733,6 +921,15 @@ c0kvs_get_excl(
     vbuf->b_len = bonsai_val_vlen(val);
     copylen = vbuf->b_len;
 
+    /* Values remain visible for the life of the c0kvms, so the caller
+     * may pin an uncompressed value by taking a ref on the c0kvms.
+     */
+    if (vbuf->b_pin && bonsai_val_clen(val) == 0) {
+        vbuf->b_pin->vp_data = val->bv_value;
+        *res = FOUND_VAL;
+        return 0;
+    }
+
     if (copylen > vbuf->b_buf_sz)
         copylen = vbuf->b_buf_sz;
 
@@ -847,8 +1044,8 @@ c0kvs_pfx_probe_cmn(
                 continue;
         }
 
-        /* add to tomblist if a tombstone was encountered */
-        if (HSE_CORE_IS_TOMB(val->bv_value)) {
+        /* add to tomblist if a tombstone (or expired value) was encountered */
+        if (HSE_CORE_IS_TOMB(val->bv_value) || kvs_expired(val->bv_expire)) {
             err = qctx_tomb_insert(qctx, kv->bkv_key + klen - sfx_len, sfx_len);
             if (ev(err))
                 break;
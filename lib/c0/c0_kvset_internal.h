@@ -23,6 +23,8 @@
  * @c0s_kvdb_seqno:        pointer to kvdb seqno
  * @c0s_kvms_seqno:        pointer to kvms seqno
  * @c0s_mutex:             mutex for bonsai tree updates
+ * @c0s_putreqs:           stack of put requests awaiting the mutex holder
+ * @c0s_rtombs:            list of range tombstones (newest first)
  * @c0s_num_entries:       how many entries (includes tombstones)
  * @c0s_num_tombstones:    how many tombstones
  * @c0s_keyb:              total key bytes
@@ -50,6 +52,9 @@ struct c0_kvset_impl {
     atomic_ulong *c0s_kvms_seqno;
 
     struct mutex c0s_mutex HSE_ACP_ALIGNED;
+    void        *c0s_putreqs;
+
+    struct c0_rtomb *c0s_rtombs;
 
     u32 c0s_num_entries HSE_L1D_ALIGNED;
     u32 c0s_num_tombstones;
@@ -281,6 +281,28 @@ c0sk_prefix_del(struct c0sk *handle, u16 skidx, struct kvs_ktuple *kt, uintptr_t
     return c0sk_putdel(self, skidx, C0SK_OP_PREFIX_DEL, kt, NULL, seqnoref);
 }
 
+merr_t
+c0sk_range_del(
+    struct c0sk *      handle,
+    u16                skidx,
+    struct kvs_ktuple *kt,
+    struct kvs_ktuple *kt_end,
+    uintptr_t          seqnoref)
+{
+    struct c0sk_impl *self = c0sk_h2r(handle);
+    struct kvs_vtuple vt;
+
+    kvs_vtuple_init(&vt, (void *)kt_end->kt_data, kt_end->kt_len);
+
+    return c0sk_putdel(self, skidx, C0SK_OP_RANGE_DEL, kt, &vt, seqnoref);
+}
+
+static void
+c0sk_vpin_release(void *arg)
+{
+    c0kvms_putref(arg);
+}
+
 /*
  * Tombstone indicated by:
  *     return value == 0 && res == FOUND_TOMB
@@ -300,7 +322,7 @@ c0sk_get(
     struct c0sk_impl *    self;
     uintptr_t             key_seqref = 0, ptomb_seqref = 0;
     u64                   start;
-    u64                   pfx_seq = 0, val_seq = 0;
+    u64                   pfx_seq = 0, val_seq = 0, rt_seq = 0;
     u64                   seq;
     merr_t                err = 0;
 
@@ -333,6 +355,11 @@ c0sk_get(
                 pfx_seq = seq;
         }
 
+        /* Range tombstones apply only to non-txn kvses, hence view_seq. */
+        seq = c0kvs_rtomb_seqno(c0kvms_ptomb_c0kvset_get(c0kvms), skidx, kt, view_seq);
+        if (seq > rt_seq)
+            rt_seq = seq;
+
         /* Search for latest value of key w/ seqno <= iseqno. */
         c0kvs = c0kvms_get_hashed_c0kvset(c0kvms, kt->kt_hash);
         err = c0kvs_get_rcu(c0kvs, skidx, kt, view_seq, seqref, res, vbuf, &key_seqref);
@@ -341,14 +368,25 @@ c0sk_get(
 
         val_seq = HSE_SQNREF_TO_ORDNL(key_seqref);
 
-        if (*res != NOT_FOUND)
+        if (*res != NOT_FOUND) {
+            if (*res == FOUND_VAL && vbuf->b_pin && vbuf->b_pin->vp_data) {
+                c0kvms_getref(c0kvms);
+                vbuf->b_pin->vp_release = c0sk_vpin_release;
+                vbuf->b_pin->vp_arg = c0kvms;
+            }
             break;
+        }
     }
     rcu_read_unlock();
 
-    if (pfx_seq > val_seq) {
+    if (pfx_seq > val_seq && pfx_seq >= rt_seq) {
         *res = FOUND_PTMB;
         vbuf->b_len = 0;
+        kvs_buf_unpin(vbuf);
+    } else if (rt_seq > val_seq) {
+        *res = FOUND_TMB;
+        vbuf->b_len = 0;
+        kvs_buf_unpin(vbuf);
     }
 
     if (start > 0) {
@@ -490,6 +528,17 @@ c0sk_open(
         goto errout;
     }
 
+    /* Each ingest thread builds one partition itself and may enlist
+     * up to (c0_ingest_parts - 1) build threads to help.
+     */
+    tdmax *= clamp_t(uint, kvdb_rp->c0_ingest_parts, 1, HSE_C0_INGEST_PARTS_MAX) - 1;
+
+    c0sk->c0sk_wq_build = alloc_workqueue("hse_c0sk_build", 0, 1, max_t(uint, tdmax, 1));
+    if (!c0sk->c0sk_wq_build) {
+        err = merr(ENOMEM);
+        goto errout;
+    }
+
     tdmax = clamp_t(uint, kvdb_rp->c0_maint_threads, 1, HSE_C0_MAINT_THREADS_MAX);
 
     c0sk->c0sk_wq_maint = alloc_workqueue("hse_c0sk_maint", 0, 1, tdmax);
@@ -531,6 +580,7 @@ errout:
 
         if (c0sk) {
             destroy_workqueue(c0sk->c0sk_wq_ingest);
+            destroy_workqueue(c0sk->c0sk_wq_build);
             destroy_workqueue(c0sk->c0sk_wq_maint);
             cv_destroy(&c0sk->c0sk_kvms_cv);
             mutex_destroy(&c0sk->c0sk_sync_mutex);
@@ -582,6 +632,7 @@ c0sk_close(struct c0sk *handle)
     }
 
     destroy_workqueue(self->c0sk_wq_ingest);
+    destroy_workqueue(self->c0sk_wq_build);
     destroy_workqueue(self->c0sk_wq_maint);
     c0kvms_destroy_cache(&self->c0sk_stash);
     cv_destroy(&self->c0sk_kvms_cv);
@@ -997,6 +1048,32 @@ c0sk_cursor_prepare(struct c0_cursor *cur)
     bin_heap2_prepare(cur->c0cur_bh, cur->c0cur_cnt, cur->c0cur_esrcv);
 }
 
+merr_t
+c0sk_cursor_rtombs(struct c0_cursor *cur, rtomb_visit_fn *visit, void *arg)
+{
+    merr_t err = 0;
+    int    i;
+
+    rcu_read_lock();
+    for (i = 0; i < cur->c0cur_cnt && !err; i++) {
+        struct c0_kvset *c0kvs = c0kvms_ptomb_c0kvset_get(cur->c0cur_curv[i]->c0mc_kvms);
+        struct c0_rtomb *crt;
+
+        for (crt = c0kvs_rtombs_get(c0kvs); crt && !err; crt = rcu_dereference(crt->rt_next)) {
+            struct rtomb rt;
+
+            if (crt->rt_skidx != cur->c0cur_skidx)
+                continue;
+
+            c0_rtomb_get(crt, &rt);
+            err = visit(arg, &rt);
+        }
+    }
+    rcu_read_unlock();
+
+    return err;
+}
+
 merr_t
 c0sk_cursor_create(
     struct c0sk *          handle,
@@ -1238,6 +1315,8 @@ c0sk_cursor_read(struct c0_cursor *cur, struct kvs_cursor_element *elem, bool *e
             kvs_vtuple_init(&elem->kce_vt, val->bv_value, val->bv_xlen);
             if (HSE_CORE_IS_PTOMB(val->bv_value))
                 elem->kce_is_ptomb = true;
+        } else if (kvs_expired(val->bv_expire)) {
+            kvs_vtuple_init(&elem->kce_vt, HSE_CORE_TOMB_REG, 0);
         } else {
             kvs_vtuple_init(&elem->kce_vt, val->bv_value, bonsai_val_ulen(val));
             elem->kce_complen = bonsai_val_clen(val);
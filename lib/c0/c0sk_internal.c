@@ -243,42 +243,25 @@ c0sk_bkv_sort_vals(struct bonsai_kv *bkv, struct bonsai_val **val_head)
 }
 
 /**
- * c0sk_cningest_cb() - Callback function for bkv_collection. Called once for every pair of
- *                      key and its value list.
+ * c0sk_cningest_add() - Add a key and its value list to a partition's kvset builder
  *
- * @rock:  Context - ingest worker object
+ * @part:  Partition to which the key belongs
  * @bkv:   Key
- * @vlist: List of values
+ * @vlist: List of values, sorted by seqno (see c0sk_cningest_merge_cb())
  */
 static merr_t
-c0sk_cningest_cb(void *rock, struct bonsai_kv *bkv, struct bonsai_val *vlist)
+c0sk_cningest_add(struct c0_ingest_part *part, struct bonsai_kv *bkv, struct bonsai_val *vlist)
 {
-    struct c0_ingest_work *ingest = rock;
-    struct bonsai_val *    val;
-    merr_t                 err;
-    u64                    seqno_prev, pt_seqno_prev;
-    struct key_obj         ko;
-
-    u16                    skidx = key_immediate_index(&bkv->bkv_key_imm);
-    struct c0sk_impl *     c0sk = c0sk_h2r(ingest->c0iw_c0sk);
-    struct cn *            cn = c0sk->c0sk_cnv[skidx];
-    struct kvset_builder **kvbldrs = ingest->c0iw_bldrs;
-    struct kvset_builder * bldr = kvbldrs[skidx];
+    struct c0sk_impl *    c0sk = c0sk_h2r(part->cip_ingest->c0iw_c0sk);
+    struct kvset_builder *bldr = part->cip_bldr;
+    struct bonsai_val *   val;
+    merr_t                err;
+    u64                   seqno_prev, pt_seqno_prev;
+    struct key_obj        ko;
 
     assert(bkv);
     assert(vlist);
-
-    if (!bldr) {
-        assert(cn);
-        err = kvset_builder_create(&bldr, cn, cn_get_ingest_perfc(cn), get_time_ns());
-        if (ev(err))
-            return err;
-
-        kvset_builder_set_agegroup(bldr, HSE_MPOLICY_AGE_ROOT);
-        kvbldrs[skidx] = bldr;
-    }
-
-    c0sk_bkv_sort_vals(bkv, &vlist);
+    assert(key_immediate_index(&bkv->bkv_key_imm) == part->cip_skidx);
 
     seqno_prev = U64_MAX;
     pt_seqno_prev = U64_MAX;
@@ -303,6 +286,12 @@ c0sk_cningest_cb(void *rock, struct bonsai_kv *bkv, struct bonsai_val *vlist)
         else
             seqno_prev = seqno;
 
+        if (val->bv_expire) {
+            err = kvset_builder_add_expire(bldr, val->bv_expire);
+            if (ev(err))
+                return err;
+        }
+
         err = kvset_builder_add_val(
             bldr, seqno, val->bv_value, bonsai_val_ulen(val), bonsai_val_clen(val));
 
@@ -318,6 +307,27 @@ c0sk_cningest_cb(void *rock, struct bonsai_kv *bkv, struct bonsai_val *vlist)
     return 0;
 }
 
+/**
+ * c0sk_cningest_merge_cb() - Callback function for bkv_collection. Called once for every pair
+ *                            of key and its value list.
+ *
+ * @rock:  Context - the merged cn list
+ * @bkv:   Key
+ * @vlist: List of values
+ *
+ * Value lists are sorted here rather than when they're added to the kvset builders, as the
+ * entries of partitioned kvs's are visited twice (see c0sk_ingest_build()).
+ */
+static merr_t
+c0sk_cningest_merge_cb(void *rock, struct bonsai_kv *bkv, struct bonsai_val *vlist)
+{
+    struct bkv_collection *cn_merged = rock;
+
+    c0sk_bkv_sort_vals(bkv, &vlist);
+
+    return bkv_collection_add(cn_merged, bkv, vlist);
+}
+
 static void
 c0sk_ingest_rec_perfc(struct perfc_set *perfc, u32 sidx, u64 cycles)
 {
@@ -508,6 +518,402 @@ c0sk_ingest_serialize_wait(struct c0_ingest_work *ingest)
     mutex_unlock(&c0sk->c0sk_kvms_mutex);
 }
 
+/* A kvs is split into key range partitions only if each partition would
+ * have at least this many entries.
+ */
+#define C0_INGEST_PART_ENTRIES_MIN (256u << 10)
+
+typedef merr_t
+c0sk_ingest_part_fn(struct c0_ingest_part *part, struct bkv_collection *cn_merged);
+
+/**
+ * struct c0sk_ingest_runner - builds an ingest's partitions in parallel
+ * @cir_ingest:   ingest work whose partitions are to be built
+ * @cir_merged:   merged cn list
+ * @cir_func:     function to apply to each partition
+ * @cir_next:     index of next partition to build
+ * @cir_helpers:  number of helper threads that have yet to finish
+ * @cir_lock:     protects cir_helpers
+ * @cir_cv:       signaled when cir_helpers drops to zero
+ */
+struct c0sk_ingest_runner {
+    struct c0_ingest_work *cir_ingest;
+    struct bkv_collection *cir_merged;
+    c0sk_ingest_part_fn   *cir_func;
+    atomic_uint            cir_next;
+    uint                   cir_helpers;
+    struct mutex           cir_lock;
+    struct cv              cir_cv;
+};
+
+struct c0sk_ingest_helper {
+    struct work_struct         cih_work;
+    struct c0sk_ingest_runner *cih_runner;
+};
+
+static merr_t
+c0sk_ingest_part_apply(struct c0_ingest_part *part, struct bkv_collection *cn_merged)
+{
+    struct bonsai_kv * bkv;
+    struct bonsai_val *vlist;
+    merr_t             err;
+    size_t             i;
+
+    for (i = part->cip_start; i < part->cip_end; ++i) {
+        bkv_collection_get(cn_merged, i, &bkv, &vlist);
+
+        err = c0sk_cningest_add(part, bkv, vlist);
+        if (ev(err))
+            return err;
+    }
+
+    return 0;
+}
+
+/* Add the range tombstones of the kvms for the given kvs to its kvset.
+ */
+static merr_t
+c0sk_ingest_rtombs_add(struct c0_ingest_work *ingest, struct kvset_builder *bldr, u16 skidx)
+{
+    struct c0_kvset *c0kvs = c0kvms_ptomb_c0kvset_get(ingest->c0iw_c0kvms);
+    struct c0_rtomb *crt;
+    merr_t           err;
+
+    for (crt = c0kvs_rtombs_get(c0kvs); crt; crt = crt->rt_next) {
+        struct rtomb rt;
+
+        if (crt->rt_skidx != skidx)
+            continue;
+
+        c0_rtomb_get(crt, &rt);
+
+        err = kvset_builder_add_rtomb(bldr, &rt);
+        if (ev(err))
+            return err;
+    }
+
+    return 0;
+}
+
+/* First pass: Write the vblocks of a partitioned kvs, or build the kvset
+ * in its entirety if the kvs has only one partition.
+ */
+static merr_t
+c0sk_ingest_part_values(struct c0_ingest_part *part, struct bkv_collection *cn_merged)
+{
+    struct c0_ingest_work *ingest = part->cip_ingest;
+    struct c0sk_impl *     c0sk = c0sk_h2r(ingest->c0iw_c0sk);
+    struct cn *            cn = c0sk->c0sk_cnv[part->cip_skidx];
+    u16                    skidx = part->cip_skidx;
+    merr_t                 err;
+
+    assert(cn);
+
+    err = kvset_builder_create(&part->cip_bldr, cn, cn_get_ingest_perfc(cn), part->cip_vgroup);
+    if (ev(err))
+        return err;
+
+    kvset_builder_set_agegroup(part->cip_bldr, HSE_MPOLICY_AGE_ROOT);
+
+    if (part->cip_partc > 1)
+        kvset_builder_part_begin(part->cip_bldr);
+
+    err = c0sk_ingest_part_apply(part, cn_merged);
+    if (ev(err))
+        return err;
+
+    if (part->cip_partc > 1)
+        return kvset_builder_part_vblocks(part->cip_bldr, &part->cip_vblkc);
+
+    err = c0sk_ingest_rtombs_add(ingest, part->cip_bldr, skidx);
+    if (ev(err))
+        return err;
+
+    err = kvset_builder_get_mblocks(part->cip_bldr, &ingest->c0iw_mblocks[skidx]);
+    if (ev(err))
+        return err;
+
+    ingest->c0iw_mbv[skidx] = &ingest->c0iw_mblocks[skidx];
+
+    return 0;
+}
+
+/* Second pass: Build the kblocks of a partitioned kvs.
+ */
+static merr_t
+c0sk_ingest_part_keys(struct c0_ingest_part *part, struct bkv_collection *cn_merged)
+{
+    if (part->cip_partc < 2)
+        return 0;
+
+    return c0sk_ingest_part_apply(part, cn_merged);
+}
+
+static void
+c0sk_ingest_runner_run(struct c0sk_ingest_runner *r)
+{
+    struct c0_ingest_work *ingest = r->cir_ingest;
+    uint                   i;
+
+    while ((i = atomic_inc_return(&r->cir_next) - 1) < ingest->c0iw_partc) {
+        struct c0_ingest_part *part = ingest->c0iw_partv + i;
+
+        part->cip_err = r->cir_func(part, r->cir_merged);
+    }
+}
+
+static void
+c0sk_ingest_helper(struct work_struct *work)
+{
+    struct c0sk_ingest_helper *h = container_of(work, struct c0sk_ingest_helper, cih_work);
+    struct c0sk_ingest_runner *r = h->cih_runner;
+
+    c0sk_ingest_runner_run(r);
+
+    mutex_lock(&r->cir_lock);
+    if (--r->cir_helpers == 0)
+        cv_signal(&r->cir_cv);
+    mutex_unlock(&r->cir_lock);
+}
+
+/**
+ * c0sk_ingest_parts_run() - apply func to all of an ingest's partitions
+ *
+ * The calling ingest thread builds partitions itself while up to
+ * (c0_ingest_parts - 1) helpers from c0sk_wq_build build the rest,
+ * such that progress never depends upon the availability of helpers.
+ */
+static merr_t
+c0sk_ingest_parts_run(
+    struct c0_ingest_work *ingest,
+    struct bkv_collection *cn_merged,
+    c0sk_ingest_part_fn   *func)
+{
+    struct c0sk_impl *        c0sk = c0sk_h2r(ingest->c0iw_c0sk);
+    struct c0sk_ingest_helper helperv[HSE_C0_INGEST_PARTS_MAX - 1];
+    struct c0sk_ingest_runner r;
+    uint                      helperc, i;
+
+    helperc = clamp_t(uint, c0sk->c0sk_kvdb_rp->c0_ingest_parts, 1, HSE_C0_INGEST_PARTS_MAX);
+    helperc = min_t(uint, helperc, ingest->c0iw_partc) - 1;
+
+    r.cir_ingest = ingest;
+    r.cir_merged = cn_merged;
+    r.cir_func = func;
+    r.cir_helpers = helperc;
+    atomic_set(&r.cir_next, 0);
+    mutex_init(&r.cir_lock);
+    cv_init(&r.cir_cv, "c0sk_ingest_runner");
+
+    for (i = 0; i < helperc; ++i) {
+        helperv[i].cih_runner = &r;
+        INIT_WORK(&helperv[i].cih_work, c0sk_ingest_helper);
+        queue_work(c0sk->c0sk_wq_build, &helperv[i].cih_work);
+    }
+
+    c0sk_ingest_runner_run(&r);
+
+    mutex_lock(&r.cir_lock);
+    while (r.cir_helpers > 0)
+        cv_wait(&r.cir_cv, &r.cir_lock);
+    mutex_unlock(&r.cir_lock);
+
+    cv_destroy(&r.cir_cv);
+    mutex_destroy(&r.cir_lock);
+
+    for (i = 0; i < ingest->c0iw_partc; ++i) {
+        if (ingest->c0iw_partv[i].cip_err)
+            return ingest->c0iw_partv[i].cip_err;
+    }
+
+    return 0;
+}
+
+/**
+ * c0sk_ingest_parts_init() - split the merged cn list into partitions
+ *
+ * The merged cn list is sorted by kvs index and then by key.  Each kvs with
+ * enough entries is split into up to c0_ingest_parts partitions of equal
+ * entry counts.  A kvs that contains prefix or range tombstones is never split,
+ * as the ptomb tree and range tombstones must reside in the last kblock of a
+ * kvset.  A kvs that contains only range tombstones gets an empty range.
+ */
+static merr_t
+c0sk_ingest_parts_init(struct c0_ingest_work *ingest, struct bkv_collection *cn_merged)
+{
+    struct c0sk_impl *c0sk = c0sk_h2r(ingest->c0iw_c0sk);
+    struct {
+        size_t start;
+        size_t end;
+        u16    skidx;
+        bool   ptomb;
+    } rangev[HSE_KVS_COUNT_MAX];
+    struct c0_ingest_part *part;
+    struct c0_rtomb *      crt;
+    size_t                 cnt, i;
+    uint                   rangec, partmax, partc, j;
+    u64                    vgroup;
+
+    cnt = bkv_collection_count(cn_merged);
+    rangec = 0;
+
+    for (i = 0; i < cnt; ++i) {
+        struct bonsai_kv * bkv;
+        struct bonsai_val *vlist;
+        u16                skidx;
+
+        bkv_collection_get(cn_merged, i, &bkv, &vlist);
+        skidx = key_immediate_index(&bkv->bkv_key_imm);
+
+        if (rangec == 0 || rangev[rangec - 1].skidx != skidx) {
+            assert(rangec == 0 || rangev[rangec - 1].skidx < skidx);
+            if (ev(rangec >= NELEM(rangev)))
+                return merr(EBUG);
+
+            rangev[rangec].start = i;
+            rangev[rangec].skidx = skidx;
+            rangev[rangec].ptomb = false;
+            ++rangec;
+        }
+
+        rangev[rangec - 1].end = i + 1;
+        if (bkv->bkv_flags & BKV_FLAG_PTOMB)
+            rangev[rangec - 1].ptomb = true;
+    }
+
+    crt = c0kvs_rtombs_get(c0kvms_ptomb_c0kvset_get(ingest->c0iw_c0kvms));
+
+    for (; crt; crt = crt->rt_next) {
+        for (j = 0; j < rangec; ++j) {
+            if (rangev[j].skidx == crt->rt_skidx)
+                break;
+        }
+
+        if (j == rangec) {
+            if (ev(rangec >= NELEM(rangev)))
+                return merr(EBUG);
+
+            rangev[rangec].start = cnt;
+            rangev[rangec].end = cnt;
+            rangev[rangec].skidx = crt->rt_skidx;
+            ++rangec;
+        }
+
+        rangev[j].ptomb = true;
+    }
+
+    partmax = clamp_t(uint, c0sk->c0sk_kvdb_rp->c0_ingest_parts, 1, HSE_C0_INGEST_PARTS_MAX);
+    partc = 0;
+
+    for (j = 0; j < rangec; ++j)
+        partc += rangev[j].ptomb ? 1 : clamp_t(size_t,
+            (rangev[j].end - rangev[j].start) / C0_INGEST_PART_ENTRIES_MIN, 1, partmax);
+
+    ingest->c0iw_partc = 0;
+    ingest->c0iw_partv = NULL;
+
+    if (partc == 0)
+        return 0;
+
+    ingest->c0iw_partv = calloc(partc, sizeof(*ingest->c0iw_partv));
+    if (ev(!ingest->c0iw_partv))
+        return merr(ENOMEM);
+
+    part = ingest->c0iw_partv;
+    vgroup = get_time_ns();
+
+    for (j = 0; j < rangec; ++j) {
+        size_t n = rangev[j].end - rangev[j].start;
+        uint   k, c;
+
+        c = rangev[j].ptomb ? 1 : clamp_t(size_t, n / C0_INGEST_PART_ENTRIES_MIN, 1, partmax);
+
+        for (k = 0; k < c; ++k, ++part) {
+            part->cip_ingest = ingest;
+            part->cip_start = rangev[j].start + (n * k) / c;
+            part->cip_end = rangev[j].start + (n * (k + 1)) / c;
+            part->cip_vgroup = vgroup++;
+            part->cip_skidx = rangev[j].skidx;
+            part->cip_partidx = k;
+            part->cip_partc = c;
+        }
+    }
+
+    ingest->c0iw_partc = partc;
+
+    return 0;
+}
+
+/**
+ * c0sk_ingest_build() - build a kvset for each kvs from the merged cn list
+ *
+ * Partitions of a kvs are built in two parallel passes.  The first writes
+ * each partition's values to its own vblocks (a separate vgroup).  Once the
+ * vblock counts of all partitions are known, the second pass builds each
+ * partition's kblocks using vblock indices rebased onto the kvset's vblock
+ * list.  The partitions are then joined into one kvset per kvs such that the
+ * ingest is committed via a single cndb transaction as before.
+ */
+static merr_t
+c0sk_ingest_build(struct c0_ingest_work *ingest, struct bkv_collection *cn_merged)
+{
+    struct kvset_builder *bldv[HSE_C0_INGEST_PARTS_MAX];
+    merr_t                err;
+    uint                  i, j, vbidx;
+
+    err = c0sk_ingest_parts_init(ingest, cn_merged);
+    if (ev(err))
+        return err;
+
+    if (ingest->c0iw_partc == 0)
+        return 0;
+
+    err = c0sk_ingest_parts_run(ingest, cn_merged, c0sk_ingest_part_values);
+    if (ev(err))
+        return err;
+
+    vbidx = 0;
+
+    for (i = 0; i < ingest->c0iw_partc; ++i) {
+        struct c0_ingest_part *part = ingest->c0iw_partv + i;
+
+        if (part->cip_partc < 2)
+            continue;
+
+        if (part->cip_partidx == 0)
+            vbidx = 0;
+
+        kvset_builder_part_rebase(part->cip_bldr, vbidx);
+        vbidx += part->cip_vblkc;
+    }
+
+    err = c0sk_ingest_parts_run(ingest, cn_merged, c0sk_ingest_part_keys);
+    if (ev(err))
+        return err;
+
+    for (i = 0; i < ingest->c0iw_partc; i += j) {
+        struct c0_ingest_part *part = ingest->c0iw_partv + i;
+        u16                    skidx = part->cip_skidx;
+
+        j = part->cip_partc;
+        if (j < 2)
+            continue;
+
+        assert(part->cip_partidx == 0);
+
+        for (vbidx = 0; vbidx < j; ++vbidx)
+            bldv[vbidx] = part[vbidx].cip_bldr;
+
+        err = kvset_builder_join(bldv, j, &ingest->c0iw_mblocks[skidx]);
+        if (ev(err))
+            return err;
+
+        ingest->c0iw_mbv[skidx] = &ingest->c0iw_mblocks[skidx];
+    }
+
+    return 0;
+}
+
 /**
  * c0sk_ingest_worker() - Ingest worker thread
  *
@@ -526,7 +932,8 @@ c0sk_ingest_serialize_wait(struct c0_ingest_work *ingest)
  *  2. Iterate over kv-pairs in LC and add them to cn_list[1] if they are ready for ingest.
  *  3. Update LC with the entries in lc_list.
  *  4. Merge cn_list[0] and cn_list[1] and add the resulting list of kv-pairs to cn using kvset
- *     builders.
+ *     builders.  Large kvs's are split into key range partitions which are built in parallel
+ *     (see c0sk_ingest_build()).
  *
  * For all ingests, steps 2 and 3 need to be performed in ingest queuing order.
  */
@@ -542,6 +949,7 @@ c0sk_ingest_worker(struct work_struct *work)
 
     struct bin_heap2 *     kvms_minheap, *lc_minheap;
     struct bkv_collection *cn_list[2] = { 0 };
+    struct bkv_collection *cn_merged = NULL;
     struct lc_builder *    lc_list = { 0 };
     u64                    kvms_gen = c0kvms_gen_read(kvms);
     u64                    txhorizon = c0kvms_txhorizon_get(kvms);
@@ -580,8 +988,13 @@ c0sk_ingest_worker(struct work_struct *work)
     if (debug)
         ingest->t0 = get_time_ns();
 
+    err = bkv_collection_create(&cn_merged, CN_INGEST_BKV_CNT, NULL, NULL);
+    if (ev(err))
+        goto exit_err;
+
     for (i = 0; i < 2; i++) {
-        err = bkv_collection_create(&cn_list[i], CN_INGEST_BKV_CNT, &c0sk_cningest_cb, ingest);
+        err = bkv_collection_create(&cn_list[i], CN_INGEST_BKV_CNT, &c0sk_cningest_merge_cb,
+                                    cn_merged);
         if (ev(err))
             goto exit_err;
     }
@@ -652,17 +1065,11 @@ c0sk_ingest_worker(struct work_struct *work)
     if (ev(err))
         goto health_err;
 
-    ingest->t7 = get_time_ns();
-
-    for (i = 0; i < HSE_KVS_COUNT_MAX; ++i) {
-        if (ingest->c0iw_bldrs[i] == 0)
-            continue;
+    err = c0sk_ingest_build(ingest, cn_merged);
+    if (ev(err))
+        goto health_err;
 
-        mbv[i] = &mblocks[i];
-        err = kvset_builder_get_mblocks(ingest->c0iw_bldrs[i], &mblocks[i]);
-        if (ev(err))
-            goto health_err;
-    }
+    ingest->t7 = get_time_ns();
 
 health_err:
     if (err)
@@ -686,6 +1093,9 @@ exit_err:
             bkv_collection_destroy(cn_list[i]);
     }
 
+    if (cn_merged)
+        bkv_collection_destroy(cn_merged);
+
     if (debug)
         ingest->t8 = get_time_ns();
 
@@ -755,15 +1165,19 @@ exit_err:
     c0sk_signal_waiters(c0sk, kvms_gen);
 
     for (i = 0; i < HSE_KVS_COUNT_MAX; ++i) {
-        if (ingest->c0iw_bldrs[i] == 0)
-            continue;
-
-        kvset_mblocks_destroy(&mblocks[i]);
-        kvset_builder_destroy(ingest->c0iw_bldrs[i]);
+        if (mbv[i])
+            kvset_mblocks_destroy(&mblocks[i]);
+    }
 
-        ingest->c0iw_bldrs[i] = NULL;
+    for (i = 0; i < ingest->c0iw_partc; ++i) {
+        if (ingest->c0iw_partv[i].cip_bldr)
+            kvset_builder_destroy(ingest->c0iw_partv[i].cip_bldr);
     }
 
+    free(ingest->c0iw_partv);
+    ingest->c0iw_partv = NULL;
+    ingest->c0iw_partc = 0;
+
     if (debug) {
         ingest->t10 = get_time_ns();
 
@@ -1218,12 +1632,19 @@ c0sk_putdel(
             err = c0kvs_put(kvs, skidx, kt, vt, seqnoref);
         } else if (op == C0SK_OP_DEL) {
             err = c0kvs_del(kvs, skidx, kt, seqnoref);
-        } else {
-            assert(op == C0SK_OP_PREFIX_DEL);
-
+        } else if (op == C0SK_OP_PREFIX_DEL) {
             /* Ignore hashed kvset. Use ptomb kvset. */
             kvs = c0kvms_ptomb_c0kvset_get(dst);
             err = c0kvs_prefix_del(kvs, skidx, kt, seqnoref);
+        } else {
+            struct kvs_ktuple kt_end;
+
+            assert(op == C0SK_OP_RANGE_DEL && !is_txn);
+
+            /* Range tombstones also reside in the ptomb kvset. */
+            kvs_ktuple_init_nohash(&kt_end, vt->vt_data, vt->vt_xlen);
+            kvs = c0kvms_ptomb_c0kvset_get(dst);
+            err = c0kvs_range_del(kvs, skidx, kt, &kt_end, seqnoref);
         }
 
         assert(!c0kvms_is_finalized(dst)); /* See c0kvs_putdel() */
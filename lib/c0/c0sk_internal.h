@@ -44,6 +44,7 @@ struct c0sk {
  * @c0sk_ds:              mpool dataset
  * @c0sk_wq_ingest        workqueue for ingest processing (one thread)
  * @c0sk_wq_maint         workqueue for concurrent maintenance tasks
+ * @c0sk_wq_build         workqueue for building ingest partitions in parallel
  * @c0sk_kvdb_seq:        kvdb seqno
  * @c0sk_closing:         set to %true when c0sk is closing
  * @c0sk_pc_op:           perf counter for c0sk
@@ -73,6 +74,7 @@ struct c0sk_impl {
     struct mpool            *c0sk_ds;      /* not owned by c0sk */
     struct workqueue_struct *c0sk_wq_ingest;
     struct workqueue_struct *c0sk_wq_maint;
+    struct workqueue_struct *c0sk_wq_build;
     struct kvdb_health      *c0sk_kvdb_health;
     struct kvdb_callback    *c0sk_cb;
     struct csched           *c0sk_csched;
@@ -191,6 +193,7 @@ enum c0sk_op {
     C0SK_OP_PUT,
     C0SK_OP_DEL,
     C0SK_OP_PREFIX_DEL,
+    C0SK_OP_RANGE_DEL,
 };
 
 /**
@@ -199,7 +202,7 @@ enum c0sk_op {
  * @skidx:       which kvs is the insert targeted to
  * @op:
  * @kt:          key tuple
- * @vt:          value tuple
+ * @vt:          value tuple (end of the range for C0SK_OP_RANGE_DEL)
  * @seqnoref:    seqnoref of kvtuple
  *
  * The function c0sk_putdel() embodies the primary functionality of c0sk.
@@ -7,12 +7,14 @@
 #include <hse_util/event_counter.h>
 #include <hse_util/page.h>
 #include <hse_util/bloom_filter.h>
+#include <hse_util/xor_filter.h>
 
 #include <hse_ikvdb/tuple.h>
 #include <hse_ikvdb/key_hash.h>
 
 #include <mpool/mpool.h>
 
+#include "omf.h"
 #include "bloom_reader.h"
 #include "kvs_mblk_desc.h"
 
@@ -31,6 +33,65 @@
  * The rub is to implement it in a way that doesn't clobber performance.
  */
 
+/* An xor filter probe touches three slots which are typically on
+ * three different pages, so fetch each page in turn and accumulate
+ * the xor of the three fingerprints.
+ */
+static merr_t
+bloom_reader_mcache_lookup_xor(
+    const struct bloom_desc *   desc,
+    const struct kvs_mblk_desc *kbd,
+    struct kvs_ktuple *         kt,
+    bool *                      hit)
+{
+    u32    fpbits = desc->bd_n_hashes;
+    u32    fpbytes = fpbits / 8;
+    u32    slotv[3], fp, kfp;
+    off_t  offsetv[3];
+    void * pagev[3];
+    merr_t err;
+    int    i;
+
+    kfp = xf_hash2slots(kt->kt_hash, desc->bd_seed, desc->bd_modulus, slotv);
+
+    for (i = 0; i < 3; ++i)
+        offsetv[i] = desc->bd_first_page + (slotv[i] * fpbytes) / PAGE_SIZE;
+
+    if (kbd->bcache) {
+        fp = kfp;
+
+        for (i = 0; i < 3; ++i) {
+            struct mpool_bcache_page *bp;
+
+            err = mpool_bcache_get(kbd->ds, kbd->mb_id, offsetv[i], kbd->bcache > 1, &bp,
+                                   &pagev[i]);
+            if (ev(err))
+                break;
+
+            fp ^= xf_fpget(pagev[i] + (slotv[i] * fpbytes) % PAGE_SIZE, 0, fpbits);
+            mpool_bcache_put(bp);
+        }
+
+        if (i == 3) {
+            *hit = (fp & ((1u << fpbits) - 1)) == 0;
+            return 0;
+        }
+    }
+
+    err = mpool_mcache_getpages(kbd->map, 3, kbd->map_idx, offsetv, pagev);
+    if (ev(err))
+        return err;
+
+    fp = kfp;
+
+    for (i = 0; i < 3; ++i)
+        fp ^= xf_fpget(pagev[i] + (slotv[i] * fpbytes) % PAGE_SIZE, 0, fpbits);
+
+    *hit = (fp & ((1u << fpbits) - 1)) == 0;
+
+    return 0;
+}
+
 merr_t
 bloom_reader_mcache_lookup(
     const struct bloom_desc *   desc,
@@ -47,9 +108,27 @@ bloom_reader_mcache_lookup(
     if (!kt->kt_hash)
         kt->kt_hash = key_hash64(kt->kt_data, kt->kt_len);
 
+    if (desc->bd_type == BLOOM_OMF_TYPE_XOR)
+        return bloom_reader_mcache_lookup_xor(desc, kbd, kt, hit);
+
     bkt = bf_hash2bkt(kt->kt_hash, desc->bd_modulus, desc->bd_bktshift);
     offsetv[0] = desc->bd_first_page + bkt / PAGE_SIZE;
 
+    if (kbd->bcache) {
+        struct mpool_bcache_page *bp;
+
+        err = mpool_bcache_get(kbd->ds, kbd->mb_id, offsetv[0], kbd->bcache > 1, &bp, pagev);
+        if (!ev(err)) {
+            bitmap = pagev[0] + (bkt % PAGE_SIZE);
+
+            *hit = bf_lookup(kt->kt_hash, bitmap, desc->bd_n_hashes, desc->bd_rotl,
+                             desc->bd_bktmask);
+
+            mpool_bcache_put(bp);
+            return 0;
+        }
+    }
+
     err = mpool_mcache_getpages(kbd->map, 1, kbd->map_idx, offsetv, pagev);
     if (ev(err))
         return err;
@@ -67,11 +146,40 @@ bloom_reader_buffer_lookup(const struct bloom_desc *desc, const u8 *bitmap, stru
     if (!kt->kt_hash)
         kt->kt_hash = key_hash64(kt->kt_data, kt->kt_len);
 
+    if (desc->bd_type == BLOOM_OMF_TYPE_XOR)
+        return xf_lookup(kt->kt_hash, bitmap, desc->bd_seed, desc->bd_modulus, desc->bd_n_hashes);
+
     bitmap += bf_hash2bkt(kt->kt_hash, desc->bd_modulus, desc->bd_bktshift);
 
     return bf_lookup(kt->kt_hash, bitmap, desc->bd_n_hashes, desc->bd_rotl, desc->bd_bktmask);
 }
 
+void
+bloom_reader_buffer_prefetch(
+    const struct bloom_desc *desc,
+    const u8 *               bitmap,
+    struct kvs_ktuple *      kt)
+{
+    if (!kt->kt_hash)
+        kt->kt_hash = key_hash64(kt->kt_data, kt->kt_len);
+
+    if (desc->bd_type == BLOOM_OMF_TYPE_XOR) {
+        u32 fpbytes = desc->bd_n_hashes / 8;
+        u32 slotv[3];
+
+        xf_hash2slots(kt->kt_hash, desc->bd_seed, desc->bd_modulus, slotv);
+
+        __builtin_prefetch(bitmap + slotv[0] * fpbytes);
+        __builtin_prefetch(bitmap + slotv[1] * fpbytes);
+        __builtin_prefetch(bitmap + slotv[2] * fpbytes);
+        return;
+    }
+
+    bitmap += bf_hash2bkt(kt->kt_hash, desc->bd_modulus, desc->bd_bktshift);
+
+    __builtin_prefetch(bitmap);
+}
+
 #if HSE_MOCKING
 merr_t
 bloom_reader_filter_info(struct bloom_desc *desc, u32 *hash_cnt, u32 *modulus)
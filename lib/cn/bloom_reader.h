@@ -20,6 +20,8 @@ struct kvs_mblk_desc;
  * @bd_n_pages:     size of data region in pages
  * @bd_n_hashes:
  * @bd_n_bits:      size of bloom filter in bits
+ * @bd_type:        filter type (BLOOM_OMF_TYPE_BLOOM or BLOOM_OMF_TYPE_XOR)
+ * @bd_seed:        xor filter hash seed
  *
  * When a kblock is opened for reading, the @bloom_hdr_omf struct is read from
  * media and the relevant information is stored in a @bloom_desc struct.
@@ -29,6 +31,8 @@ struct kvs_mblk_desc;
  *    So, if @bd_first_page=2 and @bd_n_pages=3, then the Bloom
  *    filter data region occupies pages 2,3 and 4 -- which maps
  *    to bytes 2*4096 to 5*4096-1 (end of page 4).
+ *  - For xor filters @bd_modulus is the number of slots per segment
+ *    and @bd_n_hashes is the fingerprint width in bits.
  */
 struct bloom_desc {
     u32 bd_modulus;
@@ -39,6 +43,8 @@ struct bloom_desc {
     u32 bd_first_page;
     u32 bd_n_pages;
     u32 bd_bktsz;
+    u32 bd_type;
+    u32 bd_seed;
 };
 
 #define BLOOM_LOOKUP_NONE (0)
@@ -58,6 +64,22 @@ struct bloom_desc {
 bool
 bloom_reader_buffer_lookup(const struct bloom_desc *desc, const u8 *buffer, struct kvs_ktuple *kt);
 
+/**
+ * bloom_reader_buffer_prefetch() - prefetch the bloom bucket for a key
+ * @desc:       bloom descriptor
+ * @buffer:     base address of bloom bitmap
+ * @kt:         key/value tuple
+ *
+ * Computes the key hash if necessary (such that a subsequent lookup
+ * need not) and issues a prefetch for the bucket that would be
+ * probed by bloom_reader_buffer_lookup().
+ */
+void
+bloom_reader_buffer_prefetch(
+    const struct bloom_desc *desc,
+    const u8 *               buffer,
+    struct kvs_ktuple *      kt);
+
 merr_t
 bloom_reader_mcache_lookup(
     const struct bloom_desc *   desc,
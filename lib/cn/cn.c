@@ -49,6 +49,7 @@
 #include "cn_tree_stats.h"
 #include "cn_mblocks.h"
 #include "cn_cursor.h"
+#include "cn_vcomp.h"
 
 #include "omf.h"
 #include "kvset.h"
@@ -151,6 +152,56 @@ cn_get_rp(const struct cn *cn)
     return cn->rp;
 }
 
+/* Number of times to try training a zstd dictionary before giving up,
+ * as training fails if the values are too few or too uniform.
+ */
+#define CN_VCOMP_TRAIN_TRIES (3)
+
+const struct cn_vcomp *
+cn_get_vcomp(struct cn *cn)
+{
+    const struct cn_vcomp *vc;
+
+    if (!cn)
+        return NULL;
+
+    vc = atomic_read_acq(&cn->cn_vcomp_dict);
+
+    return vc ?: cn->cn_vcomp;
+}
+
+bool
+cn_vcomp_train_begin(struct cn *cn)
+{
+    if (!cn || !cn->cn_vcomp || cn->cn_vcomp->cv_calgo != VBLOCK_CALGO_ZSTD)
+        return false;
+
+    if (!cn->rp->cn_vcomp_dictsz || atomic_read(&cn->cn_vcomp_dict))
+        return false;
+
+    if (atomic_read(&cn->cn_vcomp_tries) >= CN_VCOMP_TRAIN_TRIES)
+        return false;
+
+    return atomic_cas(&cn->cn_vcomp_training, 0, 1);
+}
+
+void
+cn_vcomp_train_end(struct cn *cn, struct cn_vcomp *vc, bool tried)
+{
+    assert(atomic_read(&cn->cn_vcomp_training));
+
+    if (vc) {
+        atomic_set_rel(&cn->cn_vcomp_dict, vc);
+
+        log_info("%s: trained zstd dictionary id %u, %u bytes",
+                 cn->cn_kvsname, vc->cv_dictid, vc->cv_dictlen);
+    } else if (tried) {
+        atomic_inc(&cn->cn_vcomp_tries);
+    }
+
+    atomic_set(&cn->cn_vcomp_training, 0);
+}
+
 struct mclass_policy *
 cn_get_mclass_policy(const struct cn *cn)
 {
@@ -193,6 +244,25 @@ cn_get_maint_wq(struct cn *cn)
     return cn ? cn->cn_maint_wq : NULL;
 }
 
+struct workqueue_struct *
+cn_get_slice_wq(struct cn *cn, uint *slices)
+{
+    if (!cn || !cn->cn_slice_wq) {
+        *slices = 1;
+        return NULL;
+    }
+
+    *slices = cn->cn_slices;
+
+    return cn->cn_slice_wq;
+}
+
+struct cn_iogov *
+cn_get_iogov(struct cn *cn)
+{
+    return cn ? cn->cn_iogov : NULL;
+}
+
 struct csched *
 cn_get_sched(struct cn *cn)
 {
@@ -308,6 +378,9 @@ cn_cp2cflags(const struct kvs_cparams *cp)
     if (cp->kvs_ext01)
         flags |= CN_CFLAG_CAPPED;
 
+    if (cp->filter_type == KVS_FILTER_XOR)
+        flags |= CN_CFLAG_XOR_FILTER;
+
     return flags;
 }
 
@@ -339,6 +412,20 @@ cn_get_sfx_len(struct cn *cn)
     return cn->cp->sfx_len;
 }
 
+merr_t
+cn_split_keys(
+    struct cn *        cn,
+    const void *       pfx,
+    uint               pfx_len,
+    uint               splitc,
+    void *             buf,
+    size_t             bufsz,
+    struct kvs_ktuple *splitv,
+    uint *             splitcnt)
+{
+    return cn_tree_split_keys(cn->cn_tree, pfx, pfx_len, splitc, buf, bufsz, splitv, splitcnt);
+}
+
 /*----------------------------------------------------------------
  * CN GET
  */
@@ -357,6 +444,18 @@ cn_get(
     return cn_tree_lookup(cn->cn_tree, &cn->cn_pc_get, kt, seq, res, &qctx, 0, vbuf);
 }
 
+merr_t
+cn_get_multi(
+    struct cn *          cn,
+    struct kvs_ktuple *  ktv,
+    u64                  seq,
+    enum key_lookup_res *resv,
+    struct kvs_buf *     vbufv,
+    uint                 cnt)
+{
+    return cn_tree_lookup_multi(cn->cn_tree, &cn->cn_pc_get, ktv, seq, resv, vbufv, cnt);
+}
+
 merr_t
 cn_pfx_probe(
     struct cn *          cn,
@@ -603,7 +702,7 @@ cn_ingest_prep(
     if (ev(!mblocks))
         return merr(EINVAL);
 
-    dgen = atomic_read(&cn->cn_ingest_dgen) + 1;
+    dgen = cn_tree_dgen_claim(cn->cn_tree);
 
     /* Note: cn_mblocks_commit() creates "C" records in CNDB */
     err = cn_mblocks_commit(
@@ -985,10 +1084,12 @@ cn_tstate_destroy(struct cn_tstate *tstate)
 }
 
 struct cn_kvsetmk_ctx {
-    struct cn *ckmk_cn;
-    u64 *      ckmk_dgen;
-    uint       ckmk_node_level_max;
-    uint       ckmk_kvsets;
+    struct cn *   ckmk_cn;
+    u64 *         ckmk_dgen;
+    uint          ckmk_node_level_max;
+    uint          ckmk_kvsets;
+    struct kvset *ckmk_vcomp_ks;
+    u64           ckmk_vcomp_dgen;
 };
 
 static merr_t
@@ -1016,6 +1117,20 @@ cn_kvset_mk(struct cn_kvsetmk_ctx *ctx, struct kvset_meta *km, u64 tag)
     if (km->km_node_level > ctx->ckmk_node_level_max)
         ctx->ckmk_node_level_max = km->km_node_level;
 
+    /* Remember the newest kvset with a zstd dictionary so that
+     * compaction can continue to use it rather than train anew.
+     */
+    if (cn->cn_vcomp && cn->cn_vcomp->cv_calgo == VBLOCK_CALGO_ZSTD &&
+        km->km_dgen > ctx->ckmk_vcomp_dgen) {
+        const void *dict;
+        uint        dictlen;
+
+        if (kvset_get_vcomp_dict(kvset, &dict, &dictlen)) {
+            ctx->ckmk_vcomp_ks = kvset;
+            ctx->ckmk_vcomp_dgen = km->km_dgen;
+        }
+    }
+
     return 0;
 }
 
@@ -1055,6 +1170,7 @@ cn_open(
     struct cn_kvsetmk_ctx ctx = { 0 };
     struct mpool_props    mpprops;
     struct merr_info      ei;
+    enum vcomp_algorithm  vcomp;
 
     assert(cn_kvdb);
     assert(mp);
@@ -1118,6 +1234,20 @@ cn_open(
 
     log_info("%s using %s media class policy", cn->cn_kvsname, rp->mclass_policy);
 
+    vcomp = cn_vcomp_algo(rp);
+    if (vcomp != VCOMP_ALGO_NONE) {
+        err = cn_vcomp_create(
+            vcomp, rp->cn_vcomp_level, rp->cn_vcomp_blksz, NULL, 0, &cn->cn_vcomp);
+        if (merr_errno(err) == ENOTSUP) {
+            log_warn("%s: compression.cn.algorithm not supported by this build, ignored",
+                     cn->cn_kvsname);
+            err = 0;
+        }
+
+        if (ev(err))
+            goto err_exit;
+    }
+
     cn->cn_replay = flags & IKVS_OFLAG_REPLAY;
     maint = cn->csched && !cn->cn_replay && !rp->cn_diag_mode && !rp->read_only;
 
@@ -1153,6 +1283,21 @@ cn_open(
     if (ev(err))
         goto err_exit;
 
+    if (ctx.ckmk_vcomp_ks) {
+        struct cn_vcomp *vc;
+        const void *     dict;
+        uint             dictlen;
+
+        kvset_get_vcomp_dict(ctx.ckmk_vcomp_ks, &dict, &dictlen);
+
+        err = cn_vcomp_create(
+            VCOMP_ALGO_ZSTD, rp->cn_vcomp_level, rp->cn_vcomp_blksz, dict, dictlen, &vc);
+        if (ev(err))
+            goto err_exit;
+
+        atomic_set(&cn->cn_vcomp_dict, vc);
+    }
+
     if (cn_kvdb) {
         /* [HSE_REVISIT]: This approach is not thread-safe */
         ksz = atomic_read(&cn_kvdb->cnd_kblk_size) - ksz;
@@ -1167,6 +1312,11 @@ cn_open(
         vszsuf += vshift;
     }
 
+    /* A tree without kvsets has yet to use a dgen.
+     */
+    if (!dgen)
+        dgen = CN_DGEN_BULK_RESERVED;
+
     cn_tree_set_initial_dgen(cn->cn_tree, dgen);
 
     cn_tree_samp_init(cn->cn_tree);
@@ -1176,6 +1326,9 @@ cn_open(
     if (maint) {
         cn->cn_maint_wq = cn_kvdb->cn_maint_wq;
         cn->cn_io_wq = cn_kvdb->cn_io_wq;
+        cn->cn_slice_wq = cn_kvdb->cn_slice_wq;
+        cn->cn_slices = cn_kvdb->cn_slices;
+        cn->cn_iogov = &cn_kvdb->cn_iogov;
 
         if (cn_is_capped(cn)) {
             cn->cn_maint_running = true;
@@ -1221,6 +1374,8 @@ err_exit:
     flush_workqueue(cn->cn_io_wq);
     cn_tree_destroy(cn->cn_tree);
     cn_tstate_destroy(cn->cn_tstate);
+    cn_vcomp_destroy(atomic_read(&cn->cn_vcomp_dict));
+    cn_vcomp_destroy(cn->cn_vcomp);
     if (!cn->cn_replay)
         cn_perfc_free(cn);
     free_aligned(cn);
@@ -1260,6 +1415,9 @@ cn_close(struct cn *cn)
 
     cn_tstate_destroy(cn->cn_tstate);
 
+    cn_vcomp_destroy(atomic_read(&cn->cn_vcomp_dict));
+    cn_vcomp_destroy(cn->cn_vcomp);
+
     cn_perfc_free(cn);
     free_aligned(cn);
 
@@ -1364,6 +1522,7 @@ cn_cursor_create(
     struct cn *            cn,
     u64                    seqno,
     bool                   reverse,
+    bool                   keys_only,
     const void *           prefix,
     u32                    pfx_len,
     struct cursor_summary *summary,
@@ -1405,6 +1564,7 @@ cn_cursor_create(
 
     cur->summary = summary;
     cur->reverse = reverse;
+    cur->keys_only = keys_only;
 
     err = cn_tree_cursor_create(cur, cn->cn_tree);
     if (ev(err)) {
@@ -1494,12 +1654,32 @@ cn_cursor_es_get(struct cn_cursor *cncur)
     return &cncur->es;
 }
 
+merr_t
+cn_cursor_rtombs(struct cn_cursor *cncur, rtomb_visit_fn *visit, void *arg)
+{
+    merr_t err = 0;
+    u32    i;
+
+    for (i = 0; i < cncur->iterc && !err; i++) {
+        const struct rtomb *rtv;
+        uint                rtc, j;
+
+        rtc = kvset_get_rtombs(cncur->ksv[i], &rtv);
+        for (j = 0; j < rtc && !err; j++)
+            err = visit(arg, rtv + j);
+    }
+
+    return err;
+}
+
 void
 cn_cursor_destroy(struct cn_cursor *cur)
 {
     cn_tree_cursor_destroy(cur);
+    free(cur->ksv);
     free(cur->iterv);
     free(cur->esrcv);
+    free(cur->vbuf);
     cn_cursor_free(cur);
 }
 
@@ -0,0 +1,514 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/*
+ * Copyright (C) 2021 Micron Technology, Inc.  All rights reserved.
+ */
+
+#include <hse_util/alloc.h>
+#include <hse_util/assert.h>
+#include <hse_util/event_counter.h>
+#include <hse_util/keycmp.h>
+#include <hse_util/time.h>
+
+#include <hse_ikvdb/cn.h>
+#include <hse_ikvdb/cndb.h>
+#include <hse_ikvdb/key_hash.h>
+#include <hse_ikvdb/kvs_cparams.h>
+#include <hse_ikvdb/kvset_builder.h>
+#include <hse_ikvdb/limits.h>
+#include <hse_ikvdb/tuple.h>
+
+#include "cn_internal.h"
+#include "cn_mblocks.h"
+#include "cn_tree.h"
+#include "cn_tree_compact.h"
+#include "cn_tree_internal.h"
+#include "kvset.h"
+#include "omf.h"
+#include "spill.h"
+
+/**
+ * struct cn_bulk_dest - destination node of a bulk load
+ * @cbd_loc: node location (the node need not exist)
+ * @cbd_bld: kvset builder for the keys routed to the node
+ */
+struct cn_bulk_dest {
+    struct cn_node_loc    cbd_loc;
+    struct kvset_builder *cbd_bld;
+};
+
+/**
+ * struct cn_bulk - cn bulk loader
+ * @cb_cn:      cn handle
+ * @cb_tree:    cn tree
+ * @cb_shift:   per-level shift of the spill hash
+ * @cb_pfx_len: kvs prefix length
+ * @cb_sfx_len: kvs suffix length
+ * @cb_behind:  true if linking behind the existing data of a live tree
+ * @cb_err:     sticky error, the loader can only be destroyed once set
+ * @cb_done:    true once the load has been committed (or failed to)
+ * @cb_destc:   number of destination nodes
+ * @cb_destmax: allocated size of @cb_destv
+ * @cb_destv:   destination nodes, sorted by location
+ * @cb_klen:    length of the last key added
+ * @cb_key:     the last key added
+ *
+ * Keys are routed by the same hashes that spills would use, so each
+ * resulting kvset is indistinguishable from one that spills would have
+ * produced (other than having a zero seqno).
+ */
+struct cn_bulk {
+    struct cn *          cb_cn;
+    struct cn_tree *     cb_tree;
+    uint                 cb_shift;
+    uint                 cb_pfx_len;
+    uint                 cb_sfx_len;
+    bool                 cb_behind;
+    merr_t               cb_err;
+    bool                 cb_done;
+    uint                 cb_destc;
+    uint                 cb_destmax;
+    struct cn_bulk_dest *cb_destv;
+    uint                 cb_klen;
+    u8                   cb_key[HSE_KVS_KEY_LEN_MAX];
+};
+
+merr_t
+cn_bulk_create(struct cn *cn, bool behind, struct cn_bulk **bulkp)
+{
+    struct kvs_cparams *cp = cn_get_cparams(cn);
+    struct cn_tree *    tree = cn_get_tree(cn);
+    struct cn_bulk *    bulk;
+
+    INVARIANT(bulkp);
+
+    if (ev(cn_is_capped(cn)))
+        return merr(EINVAL);
+
+    if (ev(!behind && !cn_tree_is_empty(tree)))
+        return merr(EBUSY);
+
+    bulk = calloc(1, sizeof(*bulk));
+    if (ev(!bulk))
+        return merr(ENOMEM);
+
+    /* Only one loader at a time may link behind the tree's data, as
+     * the dgens chosen by concurrent loaders could collide.
+     */
+    if (behind && !atomic_cas(&tree->ct_bulk_behind, 0, 1)) {
+        free(bulk);
+        return merr(EBUSY);
+    }
+
+    bulk->cb_cn = cn;
+    bulk->cb_tree = tree;
+    bulk->cb_shift = cn_tree_get_khashmap(tree) ? CN_KHASHMAP_SHIFT : tree->ct_fanout_bits;
+    bulk->cb_pfx_len = cp->pfx_len;
+    bulk->cb_sfx_len = cp->sfx_len;
+    bulk->cb_behind = behind;
+
+    *bulkp = bulk;
+
+    return 0;
+}
+
+/* Select the child to which a spill would route the given (shifted) hash.
+ */
+static uint
+cn_bulk_child(struct cn_bulk *bulk, u64 hash)
+{
+    struct cn_khashmap *khashmap;
+    u64                 cnum;
+
+    khashmap = cn_tree_get_khashmap(bulk->cb_tree);
+    if (khashmap) {
+        u8 * mapv = khashmap->khm_mapv;
+        uint idx = hash % CN_TSTATE_KHM_SZ;
+
+        if (HSE_UNLIKELY(mapv[idx] == 0)) {
+            spin_lock(&khashmap->khm_lock);
+            while (mapv[idx] == 0)
+                mapv[idx] = (khashmap->khm_gen += 3);
+            spin_unlock(&khashmap->khm_lock);
+        }
+        cnum = mapv[idx];
+    } else {
+        cnum = hash;
+    }
+
+    return cnum & bulk->cb_tree->ct_fanout_mask;
+}
+
+/* Select the node to which spills would eventually carry the given key,
+ * which is the first node below the root on the key's path that is either
+ * a leaf or does not yet exist.
+ */
+static void
+cn_bulk_route(struct cn_bulk *bulk, const struct key_obj *kobj, struct cn_node_loc *loc)
+{
+    struct cn_tree *     tree = bulk->cb_tree;
+    struct cn_tree_node *tn, *child;
+    uint                 klen = key_obj_len(kobj);
+    uint                 hashlen = UINT_MAX;
+    u64                  hash = 0;
+    void *               lock;
+
+    rmlock_rlock(&tree->ct_lock, &lock);
+
+    for (tn = tree->ct_root; tn; tn = child) {
+        uint level = tn->tn_loc.node_level;
+        uint len, cx;
+
+        /* Prefix nodes spill by the kvs prefix, others by the full key.
+         */
+        len = (tn->tn_pfx_spill ? bulk->cb_pfx_len : 0) ?: klen - bulk->cb_sfx_len;
+        if (len != hashlen) {
+            hashlen = len;
+            hash = pfx_obj_hash64(kobj, hashlen);
+        }
+
+        cx = cn_bulk_child(bulk, hash >> (bulk->cb_shift * level));
+
+        child = tn->tn_childv[cx];
+        if (!child) {
+            loc->node_level = level + 1;
+            loc->node_offset = node_nth_child_offset(tree->ct_fanout_bits, &tn->tn_loc, cx);
+        } else if (cn_node_isleaf(child)) {
+            *loc = child->tn_loc;
+            child = NULL;
+        }
+    }
+
+    rmlock_runlock(lock);
+}
+
+static int
+cn_bulk_loc_cmp(const struct cn_node_loc *a, const struct cn_node_loc *b)
+{
+    if (a->node_level != b->node_level)
+        return a->node_level < b->node_level ? -1 : 1;
+
+    if (a->node_offset != b->node_offset)
+        return a->node_offset < b->node_offset ? -1 : 1;
+
+    return 0;
+}
+
+static merr_t
+cn_bulk_builder_create(struct cn_bulk *bulk, struct kvset_builder **bldp)
+{
+    struct cn *cn = bulk->cb_cn;
+    merr_t     err;
+
+    /* Each builder writes its own vblocks, so give each its own vgroup.
+     */
+    err = kvset_builder_create(bldp, cn, cn_get_ingest_perfc(cn), get_time_ns());
+    if (ev(err))
+        return err;
+
+    kvset_builder_set_agegroup(*bldp, HSE_MPOLICY_AGE_LEAF);
+
+    err = kvset_builder_set_vcomp(*bldp, cn_get_vcomp(cn));
+    if (ev(err)) {
+        kvset_builder_destroy(*bldp);
+        *bldp = NULL;
+    }
+
+    return err;
+}
+
+/* Get the kvset builder for the given destination, creating it if need be.
+ */
+static merr_t
+cn_bulk_builder_get(
+    struct cn_bulk *          bulk,
+    const struct cn_node_loc *loc,
+    struct kvset_builder **   bldp)
+{
+    struct cn_bulk_dest *dest;
+    uint                 lo = 0, hi = bulk->cb_destc;
+    merr_t               err;
+
+    while (lo < hi) {
+        uint mid = (lo + hi) / 2;
+        int  rc = cn_bulk_loc_cmp(loc, &bulk->cb_destv[mid].cbd_loc);
+
+        if (rc == 0) {
+            *bldp = bulk->cb_destv[mid].cbd_bld;
+            return 0;
+        }
+
+        if (rc < 0)
+            hi = mid;
+        else
+            lo = mid + 1;
+    }
+
+    if (bulk->cb_destc == bulk->cb_destmax) {
+        uint destmax = bulk->cb_destmax ? bulk->cb_destmax * 2 : 16;
+
+        dest = realloc(bulk->cb_destv, destmax * sizeof(*dest));
+        if (ev(!dest))
+            return merr(ENOMEM);
+
+        bulk->cb_destv = dest;
+        bulk->cb_destmax = destmax;
+    }
+
+    err = cn_bulk_builder_create(bulk, bldp);
+    if (ev(err))
+        return err;
+
+    dest = bulk->cb_destv + lo;
+    memmove(dest + 1, dest, (bulk->cb_destc - lo) * sizeof(*dest));
+    bulk->cb_destc++;
+
+    dest->cbd_loc = *loc;
+    dest->cbd_bld = *bldp;
+
+    return 0;
+}
+
+merr_t
+cn_bulk_add(struct cn_bulk *bulk, const struct kvs_ktuple *kt, const struct kvs_vtuple *vt)
+{
+    struct kvset_builder *bld;
+    struct cn_node_loc    loc;
+    struct key_obj        kobj;
+    uint                  klen = kt->kt_len;
+    merr_t                err;
+
+    if (ev(bulk->cb_err || bulk->cb_done))
+        return bulk->cb_err ?: merr(EINVAL);
+
+    if (ev(bulk->cb_sfx_len && klen < bulk->cb_sfx_len + bulk->cb_pfx_len))
+        return merr(EINVAL);
+
+    /* Keys must be strictly ascending so that each builder receives its
+     * keys in order and no key is loaded twice.
+     */
+    if (ev(bulk->cb_klen && keycmp(kt->kt_data, klen, bulk->cb_key, bulk->cb_klen) <= 0))
+        return merr(EINVAL);
+
+    key2kobj(&kobj, kt->kt_data, klen);
+
+    cn_bulk_route(bulk, &kobj, &loc);
+
+    err = cn_bulk_builder_get(bulk, &loc, &bld);
+    if (ev(err))
+        goto errout;
+
+    /* Loaded values are older than anything subsequently put to the
+     * kvs, so they all get seqno zero.
+     */
+    err = kvset_builder_add_val(bld, 0, vt->vt_data, kvs_vtuple_vlen(vt), 0);
+    if (!err)
+        err = kvset_builder_add_key(bld, &kobj);
+    if (ev(err))
+        goto errout;
+
+    memcpy(bulk->cb_key, kt->kt_data, klen);
+    bulk->cb_klen = klen;
+
+    return 0;
+
+errout:
+    bulk->cb_err = err;
+
+    return err;
+}
+
+merr_t
+cn_bulk_commit(struct cn_bulk *bulk)
+{
+    struct kvset_mblocks *mbv = NULL;
+    struct kvset **       kvsetv = NULL;
+    struct cn_tree_node **nodev = NULL;
+    struct cn_node_loc *  locv;
+    struct cn *           cn = bulk->cb_cn;
+    struct cn_tree *      tree = bulk->cb_tree;
+    uint                  destc = bulk->cb_destc;
+    u64 *                 tagv, *dgenv;
+    u64                   txid = 0, context = 0;
+    u32                   commitc = 0;
+    uint                  i, n = 0;
+    merr_t                err = 0;
+
+    if (ev(bulk->cb_err || bulk->cb_done))
+        return bulk->cb_err ?: merr(EINVAL);
+
+    bulk->cb_done = true;
+
+    if (!destc)
+        return 0;
+
+    mbv = calloc(
+        destc,
+        sizeof(*mbv) + sizeof(*kvsetv) + sizeof(*nodev) + sizeof(*tagv) + sizeof(*dgenv) +
+            sizeof(*locv));
+    if (ev(!mbv)) {
+        err = merr(ENOMEM);
+        goto done;
+    }
+
+    kvsetv = (void *)(mbv + destc);
+    nodev = (void *)(kvsetv + destc);
+    tagv = (void *)(nodev + destc);
+    dgenv = tagv + destc;
+    locv = (void *)(dgenv + destc);
+
+    /* Finish each builder, keeping only those that produced a kvset.
+     * Once its mblocks are retrieved a builder no longer owns them.
+     */
+    for (i = n = 0; i < destc; i++) {
+        struct cn_bulk_dest *dest = bulk->cb_destv + i;
+
+        err = kvset_builder_get_mblocks(dest->cbd_bld, &mbv[n]);
+
+        kvset_builder_destroy(dest->cbd_bld);
+        dest->cbd_bld = NULL;
+
+        if (ev(err))
+            goto done;
+
+        if (mbv[n].kblks.n_blks == 0) {
+            assert(mbv[n].vblks.n_blks == 0);
+            kvset_mblocks_destroy(&mbv[n]);
+            continue;
+        }
+
+        locv[n++] = dest->cbd_loc;
+    }
+
+    if (!n)
+        goto done;
+
+    if (bulk->cb_behind) {
+
+        /* Each kvset gets a dgen older than that of any kvset on the
+         * path to its node, and its node is pinned until it is linked.
+         */
+        for (i = 0; i < n; i++) {
+            err = cn_tree_bulk_pin(tree, &locv[i], &nodev[i], &dgenv[i]);
+            if (ev(err))
+                goto done;
+        }
+    } else {
+
+        /* The kvsets share a freshly claimed dgen.  The tree update
+         * verifies that no ingest claimed an older dgen that has yet
+         * to be linked, and that no ingest has been linked since.
+         */
+        dgenv[0] = cn_tree_dgen_claim(tree);
+        for (i = 1; i < n; i++)
+            dgenv[i] = dgenv[0];
+    }
+
+    /* Persist the child assignments of any hashes we routed first.
+     */
+    err = cn_spill_khashmap_update(tree);
+    if (ev(err))
+        goto done;
+
+    err = cndb_txn_start(
+        cn_get_cndb(cn), &txid, n, 0, 0, CNDB_INVAL_INGESTID, CNDB_INVAL_HORIZON);
+    if (ev(err))
+        goto done;
+
+    /* Note: cn_mblocks_commit() creates "C" records in CNDB */
+    err = cn_mblocks_commit(
+        cn_get_dataset(cn),
+        cn_get_cndb(cn),
+        cn_get_cnid(cn),
+        txid,
+        n,
+        mbv,
+        CN_MUT_OTHER,
+        &commitc,
+        &context,
+        tagv);
+    if (ev(err))
+        goto done;
+
+    for (i = 0; i < n; i++) {
+        struct kvset_meta km = {};
+
+        /* Lend kblk and vblk lists to kvset_create().
+         */
+        km.km_kblk_list = mbv[i].kblks;
+        km.km_vblk_list = mbv[i].vblks;
+        km.km_dgen = dgenv[i];
+        km.km_node_level = locv[i].node_level;
+        km.km_node_offset = locv[i].node_offset;
+
+        km.km_vused = mbv[i].bl_vused;
+        km.km_compc = 0;
+        km.km_capped = false;
+        km.km_restored = false;
+        km.km_scatter = km.km_vused ? 1 : 0;
+
+        err = cndb_txn_meta(cn_get_cndb(cn), txid, cn_get_cnid(cn), tagv[i], &km);
+        if (ev(err))
+            goto done;
+
+        err = kvset_create(tree, tagv[i], &km, &kvsetv[i]);
+        if (ev(err))
+            goto done;
+    }
+
+    /* Acknowledges the transaction and publishes the kvsets.
+     */
+    err = cn_tree_bulk_update(tree, txid, bulk->cb_behind, n, kvsetv, locv);
+    ev(err);
+
+done:
+    if (err) {
+        bulk->cb_err = err;
+
+        if (txid && cndb_txn_nak(cn_get_cndb(cn), txid))
+            ev(1);
+
+        for (i = 0; kvsetv && i < n; i++) {
+            if (kvsetv[i])
+                kvset_put_ref(kvsetv[i]);
+        }
+
+        /* Delete committed mblocks, abort those not yet committed. */
+        if (mbv)
+            cn_mblocks_destroy(cn_get_dataset(cn), n, mbv, false, commitc);
+    }
+
+    for (i = 0; nodev && i < n; i++) {
+        if (nodev[i])
+            cn_node_comp_token_put(nodev[i]);
+    }
+
+    if (mbv) {
+        for (i = 0; i < n; i++)
+            kvset_mblocks_destroy(&mbv[i]);
+        free(mbv);
+    }
+
+    return err;
+}
+
+void
+cn_bulk_destroy(struct cn_bulk *bulk)
+{
+    uint i;
+
+    if (!bulk)
+        return;
+
+    /* Destroying an uncommitted builder aborts its mblocks.
+     */
+    for (i = 0; i < bulk->cb_destc; i++) {
+        if (bulk->cb_destv[i].cbd_bld)
+            kvset_builder_destroy(bulk->cb_destv[i].cbd_bld);
+    }
+
+    if (bulk->cb_behind)
+        atomic_set(&bulk->cb_tree->ct_bulk_behind, 0);
+
+    free(bulk->cb_destv);
+    free(bulk);
+}
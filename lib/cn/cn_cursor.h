@@ -11,12 +11,14 @@
 #include <hse_util/bin_heap.h>
 
 #include <hse_ikvdb/cursor.h>
+#include <hse_ikvdb/rtomb.h>
 
 #include "cn_metrics.h"
 
 /* MTF_MOCK_DECL(cn_cursor) */
 
 struct cn;
+struct kvset;
 struct kvs_ktuple;
 struct kvs_kvtuple;
 struct cursor_summary;
@@ -25,9 +27,10 @@ struct cursor_summary;
  * struct cn_cursor - allocated prefix scan context, including output buffer
  * @bh:         how to merge iterators
  * @iterc:      number of kvsets referenced
- * @itermax:    max elements in iterv[] and esrcv[]
- * @iterv:      kvset iterator vector
- * @esrcv:      element source vector
+ * @itermax:    max elements in ksv[], iterv[] and esrcv[]
+ * @ksv:        kvset vector (the cursor holds a reference on each kvset)
+ * @iterv:      kvset iterator vector (NULL until needed by prepare or seek)
+ * @esrcv:      element source vector (NULL for kvsets without elements)
  * @cn:         cn this cursor operates upon
  * @summary:
  * @pfx:        prefix is saved here
@@ -40,6 +43,7 @@ struct cursor_summary;
  * @dgen:       max dgen in this scan
  * @seqno:      view sequence number for this cursor
  * @reverse:    reverse iterator: 1=yes 0=no
+ * @keys_only:  return value lengths but never read values: 1=yes 0=no
  * @eof:        cursor is at eof: 1=yes 0=no
  * @pt_set:     if the ptomb in pt_kobj, if there is one, is relevant.
  * @stats:      metrics for this scan; exists lifetime of cursor
@@ -55,6 +59,7 @@ struct cn_cursor {
     struct kvs_cursor_element elem;
     u32                     iterc;
     u32                     itermax;
+    struct kvset **         ksv;
     struct kv_iterator **   iterv;
     struct element_source **esrcv;
     struct cn *             cn;
@@ -71,6 +76,7 @@ struct cn_cursor {
 
     /* bitflags */
     u32 reverse : 1;
+    u32 keys_only : 1;
     u32 eof : 1;
     u32 pt_set : 1;
 
@@ -79,6 +85,10 @@ struct cn_cursor {
 
     struct key_obj pt_kobj;
     u64            pt_seq;
+
+    /* for values not compressed with lz4 */
+    void *vbuf;
+    uint  vbufsz;
 };
 
 /* MTF_MOCK */
@@ -87,6 +97,7 @@ cn_cursor_create(
     struct cn *            cn,
     u64                    seqno,
     bool                   reverse,
+    bool                   keys_only,
     const void *           prefix,
     u32                    len,
     struct cursor_summary *summary,
@@ -128,6 +139,18 @@ cn_cursor_es_make(struct cn_cursor *cncur);
 struct element_source *
 cn_cursor_es_get(struct cn_cursor *cncur);
 
+/**
+ * cn_cursor_rtombs() - enumerate the range tombstones of a cursor's kvsets
+ * @cncur: cn cursor
+ * @visit: called once for each range tombstone
+ * @arg:   passed through to @visit
+ *
+ * The tombstones' keys remain valid until the cursor is updated or destroyed.
+ */
+/* MTF_MOCK */
+merr_t
+cn_cursor_rtombs(struct cn_cursor *cncur, rtomb_visit_fn *visit, void *arg);
+
 #if HSE_MOCKING
 #include "cn_cursor_ut.h"
 #endif /* HSE_MOCKING */
@@ -13,6 +13,7 @@ struct cndb;
 struct ikvdb;
 struct kvdb_health;
 struct csched;
+struct cn_vcomp;
 
 #include <hse_util/atomic.h>
 #include <hse_util/workqueue.h>
@@ -24,6 +25,12 @@ struct csched;
 #include <hse/limits.h>
 #include <mpool/mpool.h>
 
+/* A new tree starts its ingest dgens above this, which leaves the dgens
+ * below it free for the kvsets that bulk loads link behind its data
+ * (see cn_tree_bulk_pin()).
+ */
+#define CN_DGEN_BULK_RESERVED (1ul << 24)
+
 struct cn {
     struct cn_tree *  cn_tree;
     struct perfc_set  cn_pc_get;
@@ -42,6 +49,19 @@ struct cn {
     /* for asynchronous mblock I/O */
     struct workqueue_struct *cn_io_wq;
 
+    /* for parallel spill and kv-compaction slices */
+    struct workqueue_struct *cn_slice_wq;
+    uint                     cn_slices;
+
+    /* compaction IO rate limiting */
+    struct cn_iogov *cn_iogov;
+
+    /* value compression applied by spill and kv-compaction */
+    struct cn_vcomp *          cn_vcomp;
+    _Atomic(struct cn_vcomp *) cn_vcomp_dict;
+    atomic_int                 cn_vcomp_training;
+    atomic_int                 cn_vcomp_tries;
+
     /* perf counters */
     struct perfc_set cn_pc_ingest;
     struct perfc_set cn_pc_spill;
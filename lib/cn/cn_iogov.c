@@ -0,0 +1,142 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/*
+ * Copyright (C) 2021 Micron Technology, Inc.  All rights reserved.
+ */
+
+#include <hse_util/arch.h>
+#include <hse_util/assert.h>
+#include <hse_util/minmax.h>
+#include <hse_util/timer.h>
+
+#include <hse_ikvdb/cn_iogov.h>
+#include <hse_ikvdb/throttle.h>
+
+/* Re-evaluate the throttle sensors at most this often.
+ */
+#define CN_IOGOV_ADJUST_NS (100 * 1000 * 1000)
+
+/* Each class may burst a quarter second's worth of its rate, but no less
+ * than this.
+ */
+#define CN_IOGOV_BURST_MIN (1024 * 1024)
+
+/* Percentage of the total rate given to each class.
+ */
+static const uint cn_iogov_share[CN_IOGOV_CLASS_CNT] = {
+    [CN_IOGOV_ROOT] = 50,
+    [CN_IOGOV_INTERN] = 30,
+    [CN_IOGOV_LEAF] = 20,
+};
+
+static void
+cn_iogov_class_rate(const struct cn_iogov *gov, enum cn_iogov_class cls, u64 *burst, u64 *rate)
+{
+    u64 r = gov->ig_rate * cn_iogov_share[cls] / 100;
+
+    if (cls != CN_IOGOV_LEAF)
+        r = gov->ig_factor ? r * gov->ig_factor / 100 : 0;
+
+    *rate = r;
+    *burst = max_t(u64, r / 4, CN_IOGOV_BURST_MIN);
+}
+
+/* Map the highest sensor value to a rate multiplier:  Backpressure below
+ * half the sensor scale is ignored, after which the multiplier rises
+ * linearly from 100% to 400% just below THROTTLE_SENSOR_SCALE.  Beyond
+ * that the throttle is delaying ingest, so zero (unlimited) is returned.
+ */
+static uint
+cn_iogov_factor(const struct cn_iogov *gov)
+{
+    int  sval = 0;
+    uint i;
+
+    for (i = 0; i < gov->ig_sensorc; i++)
+        sval = max_t(int, sval, throttle_sensor_get(gov->ig_sensorv[i]));
+
+    if (sval >= THROTTLE_SENSOR_SCALE)
+        return 0;
+
+    if (sval <= THROTTLE_SENSOR_SCALE / 2)
+        return 100;
+
+    return 100 + 600 * (sval - THROTTLE_SENSOR_SCALE / 2) / THROTTLE_SENSOR_SCALE;
+}
+
+static void
+cn_iogov_adjust(struct cn_iogov *gov, u64 now)
+{
+    ulong next = atomic_read(&gov->ig_adjust);
+    uint  factor;
+    int   cls;
+
+    /* Only the thread that advances the adjustment time re-evaluates.
+     */
+    if (now < next || !atomic_cas(&gov->ig_adjust, next, now + CN_IOGOV_ADJUST_NS))
+        return;
+
+    factor = cn_iogov_factor(gov);
+    if (factor == gov->ig_factor)
+        return;
+
+    gov->ig_factor = factor;
+
+    /* The leaf class is never loosened.
+     */
+    for (cls = CN_IOGOV_ROOT; cls < CN_IOGOV_LEAF; cls++) {
+        u64 burst, rate;
+
+        cn_iogov_class_rate(gov, cls, &burst, &rate);
+        tbkt_adjust(&gov->ig_tbv[cls], burst, rate);
+    }
+}
+
+void
+cn_iogov_init(struct cn_iogov *gov, uint rate_mb)
+{
+    int cls;
+
+    INVARIANT(gov);
+
+    memset(gov, 0, sizeof(*gov));
+
+    gov->ig_rate = (u64)rate_mb << 20;
+    gov->ig_factor = 100;
+    atomic_set(&gov->ig_adjust, 0);
+
+    for (cls = 0; cls < CN_IOGOV_CLASS_CNT; cls++) {
+        u64 burst, rate;
+
+        cn_iogov_class_rate(gov, cls, &burst, &rate);
+        tbkt_init(&gov->ig_tbv[cls], burst, rate);
+    }
+}
+
+void
+cn_iogov_sensors_set(struct cn_iogov *gov, struct throttle_sensor **sensorv, uint sensorc)
+{
+    uint i, n = 0;
+
+    for (i = 0; i < sensorc && n < CN_IOGOV_SENSOR_MAX; i++) {
+        if (sensorv[i])
+            gov->ig_sensorv[n++] = sensorv[i];
+    }
+
+    gov->ig_sensorc = n;
+}
+
+void
+cn_iogov_request_slow(struct cn_iogov *gov, enum cn_iogov_class cls, u64 bytes)
+{
+    u64 now, sleep_ns;
+
+    assert(cls < CN_IOGOV_CLASS_CNT);
+
+    now = get_time_ns();
+    if (now >= atomic_read(&gov->ig_adjust))
+        cn_iogov_adjust(gov, now);
+
+    sleep_ns = tbkt_request(&gov->ig_tbv[cls], bytes, &now);
+    if (sleep_ns > timer_slack / 2)
+        tbkt_delay(sleep_ns);
+}
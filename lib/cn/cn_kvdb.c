@@ -10,24 +10,38 @@
 #include <hse_util/atomic.h>
 #include <hse_util/hse_err.h>
 #include <hse_util/event_counter.h>
+#include <hse_util/minmax.h>
 
 #include <hse_ikvdb/cn_kvdb.h>
+#include <hse_ikvdb/limits.h>
 
 /* MTF_MOCK */
 merr_t
-cn_kvdb_create(uint cn_maint_threads, uint cn_io_threads, struct cn_kvdb **out)
+cn_kvdb_create(
+    uint             cn_maint_threads,
+    uint             cn_io_threads,
+    uint             cn_slices,
+    uint             cn_io_rate_mb,
+    struct cn_kvdb **out)
 {
     struct cn_kvdb *self;
+    uint            tdmax;
 
-    self = calloc(1, sizeof(*self));
+    /* The embedded token buckets require cache line alignment.
+     */
+    self = aligned_alloc(alignof(*self), sizeof(*self));
     if (ev(!self))
         return merr(ENOMEM);
 
+    memset(self, 0, sizeof(*self));
+
     atomic_set(&self->cnd_kblk_cnt, 0);
     atomic_set(&self->cnd_vblk_cnt, 0);
     atomic_set(&self->cnd_kblk_size, 0);
     atomic_set(&self->cnd_vblk_size, 0);
 
+    cn_iogov_init(&self->cn_iogov, cn_io_rate_mb);
+
     self->cn_maint_wq = alloc_workqueue("hse_cn_maint", 0, 3, cn_maint_threads);
     if (ev(!self->cn_maint_wq)) {
         free(self);
@@ -41,6 +55,21 @@ cn_kvdb_create(uint cn_maint_threads, uint cn_io_threads, struct cn_kvdb **out)
         return merr(ENOMEM);
     }
 
+    /* A sliced compaction merges one slice in the compaction thread and
+     * enlists up to (cn_slices - 1) slice threads to help.  Allow for two
+     * such jobs (e.g., a root spill and a large leaf kv-compaction).
+     */
+    self->cn_slices = clamp_t(uint, cn_slices, 1, HSE_CN_COMPACTION_SLICES_MAX);
+    tdmax = max_t(uint, (self->cn_slices - 1) * 2, 1);
+
+    self->cn_slice_wq = alloc_workqueue("hse_cn_slice", 0, 1, tdmax);
+    if (ev(!self->cn_slice_wq)) {
+        destroy_workqueue(self->cn_io_wq);
+        destroy_workqueue(self->cn_maint_wq);
+        free(self);
+        return merr(ENOMEM);
+    }
+
     *out = self;
 
     return 0;
@@ -52,6 +81,7 @@ cn_kvdb_destroy(struct cn_kvdb *h)
     if (h) {
         destroy_workqueue(h->cn_maint_wq);
         destroy_workqueue(h->cn_io_wq);
+        destroy_workqueue(h->cn_slice_wq);
         free(h);
     }
 }
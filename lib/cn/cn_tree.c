@@ -58,6 +58,7 @@
 #include "cn_mblocks.h"
 #include "cn_metrics.h"
 #include "kvset.h"
+#include "omf.h"
 #include "cn_perfc.h"
 #include "kcompact.h"
 #include "blk_list.h"
@@ -74,8 +75,6 @@ static struct kmem_cache *cn_node_cache HSE_READ_MOSTLY;
  */
 struct kvstarts {
     struct kvset_view view; /* must be first field! */
-    int               start;
-    int               pt_start;
 };
 
 /**
@@ -95,8 +94,10 @@ kvset_iterv_release_cb(struct work_struct *work)
 
     w = container_of(work, struct kir_work, kir_work);
 
-    for (i = 0; i < w->kir_iterc; ++i)
-        kvset_iter_release(w->kir_iterv[i]);
+    for (i = 0; i < w->kir_iterc; ++i) {
+        if (w->kir_iterv[i])
+            kvset_iter_release(w->kir_iterv[i]);
+    }
 
     free(work);
 }
@@ -127,8 +128,10 @@ kvset_iterv_release(uint iterc, struct kv_iterator **iterv, struct workqueue_str
         }
     }
 
-    for (i = 0; i < iterc; ++i)
-        kvset_iter_release(iterv[i]);
+    for (i = 0; i < iterc; ++i) {
+        if (iterv[i])
+            kvset_iter_release(iterv[i]);
+    }
     ev(1);
 }
 
@@ -384,6 +387,11 @@ cn_tree_create(
     tree->ct_l_nodec = 1;
     tree->ct_lvl_max = 0; /* root at level 0 */
 
+    atomic_init(&tree->ct_bulk_behind, 0);
+    atomic_init(&tree->ct_bulk_waiters, 0);
+    mutex_init(&tree->ct_bulk_lock);
+    cv_init(&tree->ct_bulk_cv, "bulkpin");
+
     err = rmlock_init(&tree->ct_lock);
     if (err) {
         cn_tree_destroy(tree);
@@ -432,6 +440,8 @@ cn_tree_destroy(struct cn_tree *tree)
      */
     cn_ref_wait(tree->cn);
 
+    cv_destroy(&tree->ct_bulk_cv);
+    mutex_destroy(&tree->ct_bulk_lock);
     rmlock_destroy(&tree->ct_lock);
     free_aligned(tree);
 }
@@ -1112,6 +1122,143 @@ unlock:
     rmlock_runlock(lock);
 }
 
+/* Number of keys sampled from the cn tree for each slice produced by
+ * cn_tree_split_keys().
+ */
+#define CN_SPLIT_SAMPLES_PER_SLICE (32)
+
+static int
+cn_split_sample_cmp(const void *lhs, const void *rhs)
+{
+    const struct kvset_sample *a = lhs;
+    const struct kvset_sample *b = rhs;
+
+    return key_obj_cmp(&a->ksa_kobj, &b->ksa_kobj);
+}
+
+merr_t
+cn_tree_split_keys(
+    struct cn_tree *   tree,
+    const void *       pfx,
+    uint               pfx_len,
+    uint               splitc,
+    void *             buf,
+    size_t             bufsz,
+    struct kvs_ktuple *splitv,
+    uint *             splitcnt)
+{
+    struct kvset_sample *    samplev;
+    struct cn_tree_node *    tn;
+    struct kvset_list_entry *le;
+    struct tree_iter         iter;
+    struct key_obj           pfx_kobj;
+    void *                   lock;
+    uint                     budget, samplemax, n, cnt, i;
+    u64                      keys, total, sum;
+    size_t                   used;
+
+    *splitcnt = 0;
+
+    if (!splitc)
+        return 0;
+
+    budget = (splitc + 1) * CN_SPLIT_SAMPLES_PER_SLICE;
+    key2kobj(&pfx_kobj, pfx, pfx_len);
+
+    rmlock_rlock(&tree->ct_lock, &lock);
+
+    /* Count the kvsets and their keys so that the sample budget can be
+     * shared among the kvsets in proportion to their sizes, with at least
+     * one sample per kvset.
+     */
+    samplemax = budget;
+    keys = 0;
+
+    tree_iter_init(tree, &iter, TRAVERSE_TOPDOWN);
+    while (NULL != (tn = tree_iter_next(tree, &iter))) {
+        list_for_each_entry (le, &tn->tn_kvset_list, le_link) {
+            keys += kvset_statsp(le->le_kvset)->kst_keys;
+            samplemax++;
+        }
+    }
+
+    samplev = malloc(samplemax * sizeof(*samplev));
+    if (ev(!samplev)) {
+        rmlock_runlock(lock);
+        return merr(ENOMEM);
+    }
+
+    n = 0;
+
+    tree_iter_init(tree, &iter, TRAVERSE_TOPDOWN);
+    while (NULL != (tn = tree_iter_next(tree, &iter))) {
+        list_for_each_entry (le, &tn->tn_kvset_list, le_link) {
+            struct kvset *ks = le->le_kvset;
+            uint          quota;
+
+            quota = keys ? ((u64)budget * kvset_statsp(ks)->kst_keys) / keys : 0;
+            quota = min_t(uint, max_t(uint, quota, 1), samplemax - n);
+
+            n += kvset_sample_keys(ks, pfx, pfx_len, quota, samplev + n);
+        }
+    }
+
+    /* Keep only the samples within the range, and sum their weights. */
+    total = 0;
+    cnt = 0;
+
+    for (i = 0; i < n; i++) {
+        if (pfx_len > 0 && key_obj_cmp_prefix(&pfx_kobj, &samplev[i].ksa_kobj))
+            continue;
+
+        total += samplev[i].ksa_weight;
+        samplev[cnt++] = samplev[i];
+    }
+
+    n = cnt;
+    qsort(samplev, n, sizeof(*samplev), cn_split_sample_cmp);
+
+    /* Choose as the smallest key of each slice the first sample at which
+     * the running total of the sample weights reaches the slice's share
+     * of the total.
+     */
+    sum = 0;
+    used = 0;
+    cnt = 0;
+
+    for (i = 0; i < n && cnt < splitc; sum += samplev[i++].ksa_weight) {
+        const struct key_obj *kobj = &samplev[i].ksa_kobj;
+        struct key_obj        prev;
+        void *                key;
+        uint                  klen;
+
+        if (sum == 0 || sum < (total * (cnt + 1)) / (splitc + 1))
+            continue;
+
+        if (cnt > 0) {
+            key2kobj(&prev, splitv[cnt - 1].kt_data, splitv[cnt - 1].kt_len);
+            if (key_obj_cmp(&prev, kobj) >= 0)
+                continue;
+        }
+
+        klen = key_obj_len(kobj);
+        if (used + klen > bufsz)
+            break;
+
+        key = key_obj_copy(buf + used, bufsz - used, &klen, kobj);
+        kvs_ktuple_init_nohash(&splitv[cnt++], key, klen);
+        used += klen;
+    }
+
+    rmlock_runlock(lock);
+
+    free(samplev);
+
+    *splitcnt = cnt;
+
+    return 0;
+}
+
 static HSE_ALWAYS_INLINE uint
 khashmap2child(struct cn_khashmap *khashmap, u64 hash, uint shift, uint level)
 {
@@ -1327,6 +1474,232 @@ done:
     return err;
 }
 
+/* Per-key descent state for cn_tree_lookup_multi().
+ */
+struct cn_lookup_state {
+    struct cn_tree_node *ls_node;
+    struct kvs_ktuple *  ls_kt;
+    u64                  ls_spill_hash;
+    struct key_disc      ls_kdisc;
+    uint                 ls_idx;
+    bool                 ls_pfx_hashing;
+    bool                 ls_first;
+};
+
+static int
+cn_lookup_state_cmp(const void *lhs, const void *rhs)
+{
+    const struct cn_lookup_state *l = *(const struct cn_lookup_state **)lhs;
+    const struct cn_lookup_state *r = *(const struct cn_lookup_state **)rhs;
+
+    if (l->ls_node != r->ls_node)
+        return (uintptr_t)l->ls_node < (uintptr_t)r->ls_node ? -1 : 1;
+
+    return (l->ls_idx > r->ls_idx) - (l->ls_idx < r->ls_idx);
+}
+
+/* Advance a key to the child node it would have been spilled into, using
+ * the same prefix/full-key descent rules as cn_tree_lookup().
+ */
+static HSE_ALWAYS_INLINE void
+cn_lookup_state_descend(struct cn_tree *tree, struct cn_lookup_state *ls, uint shift, uint depth)
+{
+    struct cn_tree_node *node = ls->ls_node;
+    struct kvs_ktuple *  kt = ls->ls_kt;
+    u32                  child;
+
+    if (ls->ls_first && ls->ls_pfx_hashing) {
+        ls->ls_spill_hash = key_hash64(kt->kt_data, tree->ct_pfx_len);
+        ls->ls_first = false;
+    } else if (ls->ls_first || (ls->ls_pfx_hashing && !node->tn_pfx_spill)) {
+        if (ls->ls_pfx_hashing && !node->tn_pfx_spill)
+            ls->ls_pfx_hashing = false;
+        ls->ls_first = false;
+
+        if (!tree->ct_sfx_len) {
+            if (!kt->kt_hash)
+                kt->kt_hash = key_hash64(kt->kt_data, kt->kt_len);
+
+            ls->ls_spill_hash = kt->kt_hash;
+        } else {
+            ls->ls_spill_hash = key_hash64(kt->kt_data, kt->kt_len - tree->ct_sfx_len);
+        }
+    }
+
+    child = khashmap2child(tree->ct_khashmap, ls->ls_spill_hash, shift, depth);
+    child &= tree->ct_fanout_mask;
+
+    ls->ls_node = node->tn_childv[child];
+    __builtin_prefetch(ls->ls_node);
+}
+
+/**
+ * cn_tree_lookup_multi() - search cn tree for a batch of keys
+ * @tree:  cn tree
+ * @pc:    perf counters
+ * @ktv:   vector of keys to search for
+ * @seq:   view sequence number
+ * @resv:  (in/out) vector of results, only keys whose result is %NOT_FOUND
+ *         on entry are searched
+ * @vbufv: (output) vector of values for keys found in cn
+ * @cnt:   number of elements in each of @ktv, @resv and @vbufv
+ *
+ * Equivalent to calling cn_tree_lookup() for each pending key, but the tree
+ * lock is acquired once for the whole batch and the tree is descended one
+ * level at a time.  At each level the pending keys are grouped by the node
+ * they reside in so that each kvset in that node is probed for all of the
+ * keys in the group back-to-back, which keeps its bloom filter, wbt pages
+ * and vblocks hot while they are needed.
+ */
+merr_t
+cn_tree_lookup_multi(
+    struct cn_tree *     tree,
+    struct perfc_set *   pc,
+    struct kvs_ktuple *  ktv,
+    u64                  seq,
+    enum key_lookup_res *resv,
+    struct kvs_buf *     vbufv,
+    uint                 cnt)
+{
+    struct cn_lookup_state * statev, **pendv;
+    struct kvset_list_entry *le;
+    void *                   lock;
+    merr_t                   err;
+    uint                     shift, depth;
+    uint                     npend, nsearch, i, j, k;
+    size_t                   sz;
+
+    sz = cnt * (sizeof(*statev) + sizeof(*pendv));
+
+    statev = malloc(sz);
+    if (ev(!statev))
+        return merr(ENOMEM);
+
+    pendv = (void *)(statev + cnt);
+
+    shift = tree->ct_khashmap ? CN_KHASHMAP_SHIFT : tree->ct_fanout_bits;
+
+    for (i = npend = 0; i < cnt; ++i) {
+        struct cn_lookup_state *ls;
+        struct kvs_ktuple *     kt = ktv + i;
+
+        if (resv[i] != NOT_FOUND)
+            continue;
+
+        ls = statev + npend;
+        ls->ls_node = tree->ct_root;
+        ls->ls_kt = kt;
+        ls->ls_spill_hash = 0;
+        ls->ls_idx = i;
+        ls->ls_pfx_hashing = kt->kt_len > tree->ct_pfx_len && tree->ct_root->tn_pfx_spill;
+        ls->ls_first = true;
+        key_disc_init(kt->kt_data, kt->kt_len, &ls->ls_kdisc);
+
+        pendv[npend++] = ls;
+    }
+
+    nsearch = npend;
+    err = 0;
+    depth = 0;
+
+    rmlock_rlock(&tree->ct_lock, &lock);
+    while (npend > 0) {
+        bool yield = false;
+
+        if (npend > 1)
+            qsort(pendv, npend, sizeof(*pendv), cn_lookup_state_cmp);
+
+        for (i = 0; i < npend; i = j) {
+            struct cn_tree_node *node = pendv[i]->ls_node;
+
+            for (j = i + 1; j < npend && pendv[j]->ls_node == node; ++j)
+                ; /* do nothing */
+
+            /* Search kvsets from newest to oldest, probing each kvset
+             * for every key in the group that has not yet been resolved.
+             */
+            list_for_each_entry (le, &node->tn_kvset_list, le_link) {
+                yield = true;
+
+                for (k = i; k < j;) {
+                    struct cn_lookup_state *lsv[KVSET_BLOOM_PROBE_MAX];
+                    struct kvs_ktuple *     ktv_probe[KVSET_BLOOM_PROBE_MAX];
+                    const struct key_disc * kdiscv[KVSET_BLOOM_PROBE_MAX];
+                    bool                    hitv[KVSET_BLOOM_PROBE_MAX];
+                    uint                    n, m;
+
+                    /* Probe the kvset's blooms for a chunk of unresolved keys
+                     * and only search the kvset for those that hit.
+                     */
+                    for (n = 0; k < j && n < KVSET_BLOOM_PROBE_MAX; ++k) {
+                        struct cn_lookup_state *ls = pendv[k];
+
+                        if (resv[ls->ls_idx] != NOT_FOUND)
+                            continue;
+
+                        lsv[n] = ls;
+                        ktv_probe[n] = ls->ls_kt;
+                        kdiscv[n] = &ls->ls_kdisc;
+                        ++n;
+                    }
+
+                    if (n == 0)
+                        break;
+
+                    kvset_bloom_probe_multi(le->le_kvset, ktv_probe, kdiscv, n, hitv);
+
+                    for (m = 0; m < n; ++m) {
+                        struct cn_lookup_state *ls = lsv[m];
+                        uint                    idx = ls->ls_idx;
+
+                        if (!hitv[m])
+                            continue;
+
+                        err = kvset_lookup(
+                            le->le_kvset, ls->ls_kt, &ls->ls_kdisc, seq, resv + idx, vbufv + idx);
+                        if (ev(err))
+                            goto unlock;
+                    }
+                }
+            }
+
+            for (k = i; k < j; ++k) {
+                struct cn_lookup_state *ls = pendv[k];
+
+                if (resv[ls->ls_idx] == NOT_FOUND)
+                    cn_lookup_state_descend(tree, ls, shift, depth);
+                else
+                    ls->ls_node = NULL;
+            }
+        }
+
+        /* Retire keys that were found or have fallen off the bottom of the tree.
+         */
+        for (i = j = 0; i < npend; ++i) {
+            if (pendv[i]->ls_node)
+                pendv[j++] = pendv[i];
+        }
+        npend = j;
+
+        if (depth > 0 && yield)
+            rmlock_yield(&tree->ct_lock, &lock);
+
+        ++depth;
+    }
+
+unlock:
+    rmlock_runlock(lock);
+
+    for (i = 0; i < nsearch; ++i)
+        perfc_inc(pc, resv[statev[i].ls_idx]);
+
+    perfc_rec_sample(pc, PERFC_DI_CNGET_DEPTH, depth);
+
+    free(statev);
+
+    return err;
+}
+
 u64
 cn_tree_initial_dgen(const struct cn_tree *tree)
 {
@@ -1361,10 +1734,21 @@ cn_node_comp_token_get(struct cn_tree_node *tn)
 void
 cn_node_comp_token_put(struct cn_tree_node *tn)
 {
-    bool b HSE_MAYBE_UNUSED;
+    struct cn_tree *tree = tn->tn_tree;
+    bool            b HSE_MAYBE_UNUSED;
 
     b = atomic_cas(&tn->tn_compacting, 1, 0);
     assert(b);
+
+    /* Wake bulk commits waiting for a token (see cn_tree_bulk_pin()).
+     * Both this load and the waiter's increment are sequentially
+     * consistent, so either we see the waiter or it sees the token.
+     */
+    if (atomic_load(&tree->ct_bulk_waiters) > 0) {
+        mutex_lock(&tree->ct_bulk_lock);
+        cv_broadcast(&tree->ct_bulk_cv);
+        mutex_unlock(&tree->ct_bulk_lock);
+    }
 }
 
 static void
@@ -1598,6 +1982,8 @@ cn_tree_prepare_compaction(struct cn_compaction_work *w)
     bool *                   drop_tombs = 0;
     struct kvset_mblocks *   outs = 0;
     struct kvset_vblk_map    vbm = {};
+    struct rtomb *           rtombv = 0;
+    uint                     rtombc = 0;
     bool                     oldest;
     struct workqueue_struct *vra_wq;
 
@@ -1619,6 +2005,11 @@ cn_tree_prepare_compaction(struct cn_compaction_work *w)
 
     vra_wq = cn_get_maint_wq(node->tn_tree->cn);
 
+    /* Choose the key range slices of a large spill or kv-compaction
+     * before creating the iterators, as slicing requires mcache maps.
+     */
+    cn_spill_slices_init(w);
+
     /*
      * Create one iterator for each input kvset.  The list 'ins' must be
      * ordered such that 'ins[i]' is newer then 'ins[i+1]'.  We walk the
@@ -1650,6 +2041,39 @@ cn_tree_prepare_compaction(struct cn_compaction_work *w)
             goto err_exit;
         }
         kvset_iter_set_stats(*iter, &w->cw_stats);
+        kvset_iter_set_iogov(*iter, w->cw_iogov, w->cw_iocls);
+        kvset_iter_set_now(*iter, w->cw_now);
+    }
+
+    /* Gather the range tombstones of the input kvsets so that the merge
+     * loop can drop the keys they hide.  The input iterators hold refs
+     * on the kvsets, which own the tombstones' keys.
+     */
+    for (i = 0, le = w->cw_mark; i < w->cw_kvset_cnt; i++, le = list_prev_entry(le, le_link)) {
+        const struct rtomb *rtv;
+
+        rtombc += kvset_get_rtombs(le->le_kvset, &rtv);
+    }
+
+    if (rtombc > 0) {
+        rtombv = malloc(rtombc * sizeof(*rtombv));
+        if (ev(!rtombv)) {
+            err = merr(ENOMEM);
+            goto err_exit;
+        }
+
+        rtombc = 0;
+        for (i = 0, le = w->cw_mark; i < w->cw_kvset_cnt;
+             i++, le = list_prev_entry(le, le_link)) {
+            const struct rtomb *rtv;
+            uint                rtc;
+
+            rtc = kvset_get_rtombs(le->le_kvset, &rtv);
+            memcpy(rtombv + rtombc, rtv, rtc * sizeof(*rtv));
+            rtombc += rtc;
+        }
+
+        rtomb_sort(rtombv, rtombc);
     }
 
     /* k-compaction keeps all the vblocks from the source kvsets
@@ -1690,6 +2114,8 @@ cn_tree_prepare_compaction(struct cn_compaction_work *w)
     w->cw_outv = outs;
     w->cw_vbmap = vbm;
     w->cw_drop_tombv = drop_tombs;
+    w->cw_rtombv = rtombv;
+    w->cw_rtombc = rtombc;
     w->cw_hash_shift = 0;
 
     if (n_outs > 1) {
@@ -1711,6 +2137,7 @@ err_exit:
         free(ins);
         free(vbm.vbm_blkv);
     }
+    free(rtombv);
     free(drop_tombs);
     free(outs);
 
@@ -1743,6 +2170,18 @@ cn_kv_cmp(const void *a_blob, const void *b_blob)
     return key_obj_cmp(&a->kobj, &b->kobj);
 }
 
+/*
+ * Min heap discriminator, consistent with cn_kv_cmp() (but not with
+ * cn_kv_cmp_rev(), which orders ptombs ahead of their matching keys).
+ */
+static u64
+cn_kv_disc(const void *blob)
+{
+    const struct cn_kv_item *item = blob;
+
+    return key_obj_disc64(&item->kobj);
+}
+
 /*
  * Max heap comparator with a caveat: A ptomb sorts before all keys w/ matching
  * prefix.
@@ -1800,18 +2239,14 @@ cn_tree_cursor_active_kvsets(struct cn_cursor *cur, u32 *active, u32 *total)
 merr_t
 cn_tree_cursor_create(struct cn_cursor *cur, struct cn_tree *tree)
 {
-    struct workqueue_struct *vra_wq;
     struct cn_tree_node *    node;
     struct cn_khashmap *     khashmap;
     struct kvset_list_entry *le;
     void *                   lock;
     struct table *           view;
     struct tree_iter         iter, *iterp;
-    struct kv_iterator **    kv_iter;
-    struct element_source ** esrc;
     uint                     iterc;
     uint                     shift;
-    enum kvset_iter_flags    flags;
 
     merr_t err = 0;
     int    i;
@@ -1833,6 +2268,8 @@ cn_tree_cursor_create(struct cn_cursor *cur, struct cn_tree *tree)
      * We must collect these pointers first, since we
      * need to police the set prior to creating iterators
      * and bin_heap_create requires a vector + len.
+     * Iterators are created only when the cursor is first
+     * prepared or seeked (see cn_tree_cursor_iter_get()).
      *
      * The logic for descending the tree is similar to the logic
      * cn_tree_lookup().
@@ -1874,8 +2311,6 @@ cn_tree_cursor_create(struct cn_cursor *cur, struct cn_tree *tree)
             kvset_get_ref(kvset);
             s->view.kvset = kvset;
             s->view.node_loc = node->tn_loc;
-            s->start = start;
-            s->pt_start = pt_start;
 
             ++iterc;
         }
@@ -1926,13 +2361,15 @@ cn_tree_cursor_create(struct cn_cursor *cur, struct cn_tree *tree)
     if (iterc > cur->itermax) {
         uint itermax = ALIGN(iterc, 256);
 
+        free(cur->ksv);
         free(cur->iterv);
         free(cur->esrcv);
 
+        cur->ksv = malloc(itermax * sizeof(*cur->ksv));
         cur->iterv = malloc(itermax * sizeof(*cur->iterv));
         cur->esrcv = malloc(itermax * sizeof(*cur->esrcv));
 
-        if (ev(!cur->iterv || !cur->esrcv)) {
+        if (ev(!cur->ksv || !cur->iterv || !cur->esrcv)) {
             err = merr(ENOMEM);
             goto errout;
         }
@@ -1940,56 +2377,28 @@ cn_tree_cursor_create(struct cn_cursor *cur, struct cn_tree *tree)
         cur->itermax = itermax;
     }
 
-    flags = kvset_iter_flag_mcache;
-    if (cur->reverse)
-        flags |= kvset_iter_flag_reverse;
-    vra_wq = cn_get_maint_wq(cur->cn);
-
-    kv_iter = cur->iterv;
-    esrc = cur->esrcv;
-
     assert(cur->iterc == 0);
 
+    /* The cursor adopts the view's kvset references.
+     */
     for (i = 0; i < iterc; ++i) {
-        struct kvstarts *   s = table_at(view, i);
-        struct kv_iterator *p;
-        struct kvset *      ks = s->view.kvset;
+        struct kvstarts *s = table_at(view, i);
 
-        err = kvset_iter_create(ks, NULL, vra_wq, NULL, flags, &p);
-        if (ev(err))
-            goto errout;
-
-        /* kvset_iter_create() adopted our kvset reference.
-         */
+        cur->ksv[i] = s->view.kvset;
+        cur->iterv[i] = NULL;
+        cur->esrcv[i] = NULL;
         s->view.kvset = NULL;
 
-        if (cur->pfx_len) {
-            bool eof;
-
-            err = kvset_iter_seek(p, cur->pfx, -cur->pfx_len, &eof);
-        } else {
-            err = kvset_iter_set_start(p, s->start, s->pt_start);
-        }
-
-        if (ev(err)) {
-            kvset_iter_release(p);
-            goto errout;
-        }
-
-        *kv_iter++ = p;
-        *esrc++ = &p->kvi_es;
-
         ++cur->iterc;
     }
 
-    for (i = 0; i < cur->iterc; ++i) {
-        assert(cur->iterv[i]);
-    }
-
     err = bin_heap2_create(cur->iterc, cur->reverse ? cn_kv_cmp_rev : cn_kv_cmp, &cur->bh);
     if (ev(err))
         goto errout;
 
+    if (!cur->reverse)
+        bin_heap2_set_disc(cur->bh, cn_kv_disc);
+
     cursor_summary_add_dgen(cur->summary, cur->dgen);
     cur->summary->n_kvset = cur->iterc;
 
@@ -2004,16 +2413,97 @@ errout:
     return err;
 }
 
+/* Release the cursor's kvset iterators and kvset references.
+ */
+static void
+cn_tree_cursor_release(struct cn_cursor *cur, uint first)
+{
+    uint i;
+
+    if (first >= cur->iterc)
+        return;
+
+    kvset_iterv_release(cur->iterc - first, cur->iterv + first, cn_get_maint_wq(cur->cn));
+
+    for (i = first; i < cur->iterc; ++i) {
+        kvset_put_ref(cur->ksv[i]);
+        cur->iterv[i] = NULL;
+        cur->esrcv[i] = NULL;
+    }
+
+    cur->iterc = first;
+}
+
+/* Create the iterator for the cursor's i'th kvset, if it doesn't already
+ * exist.  If %start is true a new iterator is positioned at the beginning
+ * of the cursor's range, otherwise the caller must seek it.
+ */
+static merr_t
+cn_tree_cursor_iter_get(struct cn_cursor *cur, uint i, bool start)
+{
+    struct kvset *        ks = cur->ksv[i];
+    struct kv_iterator *  iter;
+    enum kvset_iter_flags flags;
+    merr_t                err;
+
+    if (cur->iterv[i])
+        return 0;
+
+    flags = kvset_iter_flag_mcache;
+    if (cur->reverse)
+        flags |= kvset_iter_flag_reverse;
+    if (cur->keys_only)
+        flags |= kvset_iter_flag_keys;
+
+    /* kvset_iter_create() adopts this reference, the cursor keeps its own.
+     */
+    kvset_get_ref(ks);
+
+    err = kvset_iter_create(ks, NULL, cn_get_maint_wq(cur->cn), NULL, flags, &iter);
+    if (ev(err)) {
+        kvset_put_ref(ks);
+        return err;
+    }
+
+    if (start) {
+        if (cur->pfx_len) {
+            bool eof;
+
+            err = kvset_iter_seek(iter, cur->pfx, -cur->pfx_len, &eof);
+        } else {
+            err = kvset_iter_set_start(
+                iter, kvset_kblk_start(ks, cur->pfx, 0, cur->reverse), kvset_pt_start(ks));
+        }
+
+        if (ev(err)) {
+            kvset_iter_release(iter);
+            return err;
+        }
+    }
+
+    cur->iterv[i] = iter;
+    cur->esrcv[i] = start ? &iter->kvi_es : NULL;
+
+    return 0;
+}
+
 merr_t
 cn_tree_cursor_prepare(struct cn_cursor *cur)
 {
     merr_t err;
+    uint   i;
 
     if (!cur->bh) {
         assert(cur->eof);
         return 0;
     }
 
+    for (i = 0; i < cur->iterc; ++i) {
+        err = cn_tree_cursor_iter_get(cur, i, true);
+        if (ev(err))
+            return err;
+    }
+
     err = bin_heap2_prepare(cur->bh, cur->iterc, cur->esrcv);
     return ev(err);
 }
@@ -2021,13 +2511,12 @@ cn_tree_cursor_prepare(struct cn_cursor *cur)
 static merr_t
 cn_tree_capped_cursor_update(struct cn_cursor *cur, struct cn_tree *tree)
 {
-    struct workqueue_struct *vra_wq;
     struct cn_tree_node *    node;
     struct kvset_list_entry *le;
-    enum kvset_iter_flags    flags;
     int                      iterc, new_cnt, old_cnt;
     merr_t                   err = 0;
     struct table *           view;
+    struct kvset **          k;
     struct kv_iterator **    p;
     struct element_source ** q;
     void *                   lock;
@@ -2074,8 +2563,6 @@ cn_tree_capped_cursor_update(struct cn_cursor *cur, struct cn_tree *tree)
 
         s->view.kvset = ks;
         s->view.node_loc = node->tn_loc;
-        s->start = 0;
-        s->pt_start = kvset_pt_start(ks);
 
         kvset_get_ref(ks);
         dgen = dgen ?: ks_dgen;
@@ -2086,11 +2573,10 @@ cn_tree_capped_cursor_update(struct cn_cursor *cur, struct cn_tree *tree)
     node_oldest_dgen = kvset_get_dgen(le->le_kvset);
     rmlock_runlock(lock);
 
-    /* Find the oldest kvset in cur->iterv[] that's still alive in the node.
+    /* Find the oldest kvset in cur->ksv[] that's still alive in the node.
      */
     for (i = cur->iterc - 1; i >= 0; i--) {
-        struct kv_iterator *it = cur->iterv[i];
-        u64 ks_dgen = kvset_get_dgen(kvset_from_iter(it));
+        u64 ks_dgen = kvset_get_dgen(cur->ksv[i]);
 
         if (ks_dgen >= node_oldest_dgen)
             break;
@@ -2109,14 +2595,9 @@ cn_tree_capped_cursor_update(struct cn_cursor *cur, struct cn_tree *tree)
      *
      * First 'old_cnt' kvsets are still valid. Retire the rest.
      */
-    if (old_cnt < cur->iterc) {
-        kvset_iterv_release(cur->iterc - old_cnt, &cur->iterv[old_cnt], cn_get_maint_wq(cur->cn));
-
-        memset(cur->iterv + old_cnt, 0, (cur->iterc - old_cnt) * sizeof(cur->iterv[0]));
-    }
+    cn_tree_cursor_release(cur, old_cnt);
 
     if (!iterc) {
-        cur->iterc = iterc;
         vtc_free(view);
         cur->eof = 1;
         return 0; /* no kvsets in cn */
@@ -2128,18 +2609,21 @@ cn_tree_capped_cursor_update(struct cn_cursor *cur, struct cn_tree *tree)
     cur->dgen = dgen;
 
     allocated = false;
+    k = cur->ksv;
     p = cur->iterv;
     q = cur->esrcv;
 
-    /* Grow iterator vectors if necessary.
+    /* Grow kvset and iterator vectors if necessary.
      */
     if (iterc > cur->itermax) {
         uint itermax = ALIGN(iterc, 256);
 
+        k = malloc(itermax * sizeof(*cur->ksv));
         p = malloc(itermax * sizeof(*cur->iterv));
         q = malloc(itermax * sizeof(*cur->esrcv));
 
-        if (ev(!p || !q)) {
+        if (ev(!k || !p || !q)) {
+            free(k);
             free(p);
             free(q);
             err = merr(ENOMEM);
@@ -2150,77 +2634,41 @@ cn_tree_capped_cursor_update(struct cn_cursor *cur, struct cn_tree *tree)
         allocated = true;
     }
 
-    /* Move the old iterators to make room for the new kvsets' iterators.
+    /* Move the old kvsets to make room for the new kvsets.
      */
+    memmove(k + new_cnt, cur->ksv, old_cnt * sizeof(*k));
     memmove(p + new_cnt, cur->iterv, old_cnt * sizeof(*p));
     memmove(q + new_cnt, cur->esrcv, old_cnt * sizeof(*q));
 
     if (allocated) {
+        free(cur->ksv);
         free(cur->iterv);
         free(cur->esrcv);
+        cur->ksv = k;
         cur->iterv = p;
         cur->esrcv = q;
     }
 
-    flags = kvset_iter_flag_mcache;
-    if (cur->reverse)
-        flags |= kvset_iter_flag_reverse;
-    vra_wq = cn_get_maint_wq(cur->cn);
-
-    /* Create iterators for the new kvsets.
+    /* The cursor adopts the view's references on the new kvsets.
      */
     for (i = 0; i < new_cnt; i++) {
-        struct kvstarts *   s = table_at(view, i);
-        struct kv_iterator *iter;
-        struct kvset *      ks = s->view.kvset;
+        struct kvstarts *s = table_at(view, i);
 
-        err = kvset_iter_create(ks, NULL, vra_wq, NULL, flags, &iter);
-        if (ev(err))
-            break;
-
-        /* kvset_iter_create() adopted our kvset reference.
-         */
+        cur->ksv[i] = s->view.kvset;
+        cur->iterv[i] = NULL;
+        cur->esrcv[i] = NULL;
         s->view.kvset = NULL;
-
-        /* The kvs layer always seeks the cursor after an update. So
-         * position at the beginning of the kvset.
-         */
-        err = kvset_iter_set_start(iter, s->start, s->pt_start);
-        if (ev(err)) {
-            kvset_iter_release(iter);
-            break;
-        }
-
-        cur->iterv[i] = iter;
-        cur->esrcv[i] = &iter->kvi_es;
-    }
-
-    if (err) {
-        /* Not all iterators in cur->iterv[] have been setup. So cleanup
-         * only the onses that are valid.
-         */
-
-        while (i--)
-            kvset_iter_release(cur->iterv[i]); /* new iters */
-
-        for (i = new_cnt; i < iterc; i++)
-            kvset_iter_release(cur->iterv[i]); /* old iters */
-
-        cur->iterc = 0; /* mark all kvset iterators as destroyed */
-        goto errout;
     }
 
 done:
-    for (i = 0; i < iterc; ++i) {
-        assert(cur->iterv[i]);
-    }
-
     cur->iterc = iterc;
     err = bin_heap2_create(cur->iterc, cn_kv_cmp, &cur->bh);
     if (ev(err))
         goto errout;
 
-    err = bin_heap2_prepare(cur->bh, cur->iterc, cur->esrcv);
+    bin_heap2_set_disc(cur->bh, cn_kv_disc);
+
+    err = cn_tree_cursor_prepare(cur);
     if (ev(err))
         goto errout;
 
@@ -2246,13 +2694,12 @@ cn_tree_cursor_update(struct cn_cursor *cur, struct cn_tree *tree)
     if (ev(cn_is_capped(cur->cn) && !cur->reverse))
         return cn_tree_capped_cursor_update(cur, tree);
 
-    kvset_iterv_release(cur->iterc, cur->iterv, cn_get_maint_wq(cur->cn));
+    cn_tree_cursor_release(cur, 0);
     bin_heap2_destroy(cur->bh);
 
-    /* Note that we intentionally preserve the iterv and esrcv
+    /* Note that we intentionally preserve the ksv, iterv and esrcv
      * buffers for reuse by cn_tree_cursor_create().
      */
-    cur->iterc = 0;
     cur->bh = NULL;
     cur->eof = 0;
 
@@ -2265,14 +2712,16 @@ cn_tree_cursor_update(struct cn_cursor *cur, struct cn_tree *tree)
 void
 cn_tree_cursor_destroy(struct cn_cursor *cur)
 {
-    kvset_iterv_release(cur->iterc, cur->iterv, cn_get_maint_wq(cur->cn));
+    cn_tree_cursor_release(cur, 0);
     bin_heap2_destroy(cur->bh);
     cur->bh = 0;
 
+    free(cur->ksv);
     free(cur->iterv);
     free(cur->esrcv);
     cur->itermax = 0;
     cur->iterc = 0;
+    cur->ksv = 0;
     cur->iterv = 0;
     cur->esrcv = 0;
 
@@ -2333,6 +2782,62 @@ cur_item_pfx_cmp(struct cn_cursor *cur, struct cn_kv_item *item)
     return rc;
 }
 
+static merr_t
+cn_tree_cursor_vbuf_reserve(struct cn_cursor *cur, uint vlen)
+{
+    if (vlen > cur->vbufsz) {
+        uint sz = ALIGN(vlen, PAGE_SIZE);
+        void *buf;
+
+        buf = malloc(sz);
+        if (ev(!buf))
+            return merr(ENOMEM);
+
+        free(cur->vbuf);
+        cur->vbuf = buf;
+        cur->vbufsz = sz;
+    }
+
+    return 0;
+}
+
+/* The kvs cursor decompresses values with lz4, so values compressed with
+ * any other algorithm are decompressed here into a cursor owned buffer,
+ * which remains valid until the next read.
+ */
+static merr_t
+cn_tree_cursor_decompress(
+    struct cn_cursor *  cur,
+    struct kv_iterator *kv_iter,
+    uint                vbidx,
+    const void **       vdata,
+    uint                vlen,
+    uint *              complen)
+{
+    uint   calgo, dictid, outlen;
+    merr_t err;
+
+    kvset_iter_vblock_comp(kv_iter, vbidx, &calgo, &dictid);
+    if (calgo == VBLOCK_CALGO_LZ4)
+        return 0;
+
+    err = cn_tree_cursor_vbuf_reserve(cur, vlen);
+    if (ev(err))
+        return err;
+
+    err = kvset_iter_val_decompress(kv_iter, vbidx, *vdata, *complen, cur->vbuf, vlen, &outlen);
+    if (ev(err))
+        return err;
+
+    if (ev(outlen != vlen))
+        return merr(EBUG);
+
+    *vdata = cur->vbuf;
+    *complen = 0;
+
+    return 0;
+}
+
 /*
  * cn_tree_cursor_read - returns the next value in the cursor
  * @cur: the cursor returned from cn_cursor_create
@@ -2407,10 +2912,18 @@ cn_tree_cursor_read(struct cn_cursor *cur, struct kvs_cursor_element *elem, bool
         if (!found)
             continue; /* Key doesn't have a value in the cursor's view. */
 
-        cur->merr = kvset_iter_next_val(kv_iter, &item.vctx, vtype, vbidx,
-                                        vboff, &vdata, &vlen, &complen);
-        if (ev(cur->merr))
-            return cur->merr;
+        /* A keys-only cursor needs only the value length, which is
+         * recorded in the kblock, so leave the vblocks untouched.
+         */
+        if (cur->keys_only && (vtype == vtype_val || vtype == vtype_cval || vtype == vtype_bval)) {
+            vdata = NULL;
+            complen = 0;
+        } else {
+            cur->merr = kvset_iter_next_val(kv_iter, &item.vctx, vtype, vbidx,
+                                            vboff, &vdata, &vlen, &complen);
+            if (ev(cur->merr))
+                return cur->merr;
+        }
 
         if (cur->pt_set) {
             if (key_obj_cmp_prefix(&cur->pt_kobj, &item.kobj) == 0) {
@@ -2442,6 +2955,24 @@ cn_tree_cursor_read(struct cn_cursor *cur, struct kvs_cursor_element *elem, bool
         if (vtype == vtype_ptomb)
             found = false;
 
+        if (found && complen > 0) {
+            cur->merr = cn_tree_cursor_decompress(cur, kv_iter, vbidx, &vdata, vlen, &complen);
+            if (ev(cur->merr))
+                return cur->merr;
+        }
+
+        /* Block values point into a per-thread cache of decompressed
+         * blocks, copy them out so they remain valid until the next read.
+         */
+        if (found && vtype == vtype_bval && vlen > 0 && vdata) {
+            cur->merr = cn_tree_cursor_vbuf_reserve(cur, vlen);
+            if (ev(cur->merr))
+                return cur->merr;
+
+            memcpy(cur->vbuf, vdata, vlen);
+            vdata = cur->vbuf;
+        }
+
     } while (!found);
 
     /* set output */
@@ -2503,35 +3034,60 @@ cn_tree_cursor_seek(
             len = cur->pfx_len;
         }
     }
-    /* [HSE_REVISIT]: this is parallelizable */
+    /* Skip kvsets whose key range cannot contain the seek key (or, given
+     * a limit, any key up to the limit) without creating or seeking their
+     * iterators, which would fault in their wbtree nodes.  Iterators for
+     * the remaining kvsets are created on demand.
+     *
+     * Kvsets with ptombs are never skipped: kvset_iter_seek() positions
+     * the ptomb iterator at the seek key truncated to the prefix length
+     * (so ptomb "ab" covers a seek to "abc"), and the kvset's min/max
+     * keys ignore ptombs.  Skipping such a kvset would resurrect keys
+     * it deletes from older kvsets.
+     *
+     * [HSE_REVISIT]: this is parallelizable
+     */
     first = -1; /* first kvset that is not at EOF */
     for (i = cur->iterc - 1; i >= 0; --i) {
-        bool eof = false;
+        struct kvset *ks = cur->ksv[i];
+        const void *  ekey;
+        u16           eklen;
+        bool          eof = false;
+
+        if (kvset_pt_start(ks) < 0) {
+            if (cur->reverse) {
+                kvset_minkey(ks, &ekey, &eklen);
+                eof = keycmp(key, len, ekey, eklen) < 0;
+            } else {
+                kvset_maxkey(ks, &ekey, &eklen);
+                eof = keycmp(key, len, ekey, eklen) > 0;
 
-        if (cur->filter) {
-            struct kvset *ks = kvset_from_iter(cur->iterv[i]);
-            const void *  minkey, *smaxkey;
-            u16           minklen, smaxklen;
+                if (!eof && cur->filter) {
+                    const struct kc_filter *filt = cur->filter;
 
-            kvset_minkey(ks, &minkey, &minklen);
-            smaxkey = cur->filter->kcf_maxkey;
-            smaxklen = cur->filter->kcf_maxklen;
+                    kvset_minkey(ks, &ekey, &eklen);
+                    eof = keycmp(filt->kcf_maxkey, filt->kcf_maxklen, ekey, eklen) < 0;
+                }
+            }
+        }
 
-            /* If there's no overlap between the seek range and the
-             * kvset's range, skip it.
-             */
-            if (!cur->reverse && keycmp(smaxkey, smaxklen, minkey, minklen) < 0) {
+        if (eof) {
+            if (cur->iterv[i])
                 kvset_iter_mark_eof(cur->iterv[i]);
-                continue;
-            }
+            cur->esrcv[i] = NULL;
+            continue;
         }
 
-        assert(cur->iterv[i]);
+        cur->merr = cn_tree_cursor_iter_get(cur, i, false);
+        if (ev(cur->merr))
+            return cur->merr;
 
         cur->merr = kvset_iter_seek(cur->iterv[i], key, len, &eof);
         if (ev(cur->merr))
             return cur->merr;
 
+        cur->esrcv[i] = eof ? NULL : &cur->iterv[i]->kvi_es;
+
         if (!eof)
             first = first < 0 ? i : first;
     }
@@ -2712,9 +3268,12 @@ cn_comp_update_spill(struct cn_compaction_work *work, struct spill_child *childv
                 continue;
 
             cnode = childv[cx].node;
-            if (cnode) {
-                /* Add new kvsets to new children. */
-                assert(!pnode->tn_childv[cx]);
+            if (cnode && !pnode->tn_childv[cx]) {
+                /* Add new kvsets to new children.  A bulk load may have
+                 * created the child since it was allocated, in which case
+                 * the unused node is left for the caller to free.
+                 */
+                childv[cx].node = NULL;
 
                 kvset_list_add(kvset, &cnode->tn_kvset_list);
                 cnode->tn_parent = pnode;
@@ -2834,10 +3393,8 @@ cn_comp_commit_spill(struct cn_compaction_work *work, struct kvset **kvsets)
     cn_comp_update_spill(work, childv);
 
 done:
-    if (err) {
-        while (cx-- > 0)
-            cn_node_free(childv[cx].node);
-    }
+    for (cx = 0; cx < work->cw_outc; cx++)
+        cn_node_free(childv[cx].node);
     free(childv);
 
     return err;
@@ -3081,6 +3638,7 @@ cn_comp_compact(struct cn_compaction_work *w)
         return;
 
     w->cw_horizon = cn_get_seqno_horizon(w->cw_tree->cn);
+    w->cw_now = kvs_now();
     w->cw_cancel_request = cn_get_cancel(w->cw_tree->cn);
 
     perfc_inc(w->cw_pc, PERFC_BA_CNCOMP_START);
@@ -3136,6 +3694,7 @@ cn_comp_compact(struct cn_compaction_work *w)
             w->cw_inputv[i]->kvi_ops->kvi_release(w->cw_inputv[i]);
     free(w->cw_inputv);
     free(w->cw_drop_tombv);
+    free(w->cw_rtombv);
     if (ev(err)) {
         if (!w->cw_canceled)
             kvdb_health_error(hp, err);
@@ -3283,6 +3842,27 @@ cn_comp_slice_cb(struct sts_job *job)
     cn_comp(w);
 }
 
+/**
+ * cn_tree_dgen_claim() - claim the dgen for a kvset to be ingested
+ * @tree:  pointer to struct cn_tree.
+ *
+ * Ingests and bulk loads claim their dgens under the tree lock so that
+ * no two of them can produce kvsets with the same dgen.  Cursors learn
+ * of a claimed dgen only once its kvset is linked into the tree.
+ */
+u64
+cn_tree_dgen_claim(struct cn_tree *tree)
+{
+    u64 dgen;
+
+    rmlock_wlock(&tree->ct_lock);
+    dgen = max_t(u64, tree->ct_dgen_claim, cn_get_ingest_dgen(tree->cn)) + 1;
+    tree->ct_dgen_claim = dgen;
+    rmlock_wunlock(&tree->ct_lock);
+
+    return dgen;
+}
+
 /**
  * cn_tree_ingest_update() - Update the cn tree with the new kvset
  * @tree:  pointer to struct cn_tree.
@@ -3327,6 +3907,265 @@ cn_tree_ingest_update(struct cn_tree *tree, struct kvset *kvset, void *ptomb, ui
         cn_get_sched(tree->cn), tree, post.r_alen - pre.r_alen, post.r_wlen - pre.r_wlen);
 }
 
+/* Caller must hold the tree lock. */
+static bool
+cn_tree_is_empty_locked(struct cn_tree *tree)
+{
+    struct cn_tree_node *tn;
+    struct tree_iter     iter;
+
+    tree_iter_init(tree, &iter, TRAVERSE_TOPDOWN);
+
+    while (NULL != (tn = tree_iter_next(tree, &iter))) {
+        if (!list_empty(&tn->tn_kvset_list))
+            return false;
+    }
+
+    return true;
+}
+
+bool
+cn_tree_is_empty(struct cn_tree *tree)
+{
+    void *lock;
+    bool  empty;
+
+    rmlock_rlock(&tree->ct_lock, &lock);
+    empty = cn_tree_is_empty_locked(tree);
+    rmlock_runlock(lock);
+
+    return empty;
+}
+
+/**
+ * cn_tree_bulk_pin() - prepare to link a bulk loaded kvset behind a node's kvsets
+ * @tree:  pointer to struct cn_tree.
+ * @loc:   location of the destination node (which need not exist)
+ * @nodep: (output) the destination node if it exists, else NULL
+ * @dgenp: (output) dgen for the kvset
+ *
+ * Waits for and then holds the compaction token of an existing destination
+ * node, which the caller must release via cn_node_comp_token_put().  This
+ * ensures the node isn't spilled after the kvset is linked, which would
+ * leave the kvset in front of the data that was spilled to the children.
+ *
+ * The returned dgen is less than that of any kvset on the path from the
+ * root to the destination node.  Ingests, spills and compactions only ever
+ * add kvsets with newer dgens to the path, so it remains valid until the
+ * kvset is linked.  A new tree reserves CN_DGEN_BULK_RESERVED dgens for
+ * this purpose, a tree whose first ingest predates the reservation may
+ * have none to spare (EAGAIN).
+ */
+merr_t
+cn_tree_bulk_pin(
+    struct cn_tree *      tree,
+    struct cn_node_loc *  loc,
+    struct cn_tree_node **nodep,
+    u64 *                 dgenp)
+{
+    struct cn_tree_node * tn, *parent, **link;
+    struct kvset_list_entry *le;
+    void *                lock;
+    u64                   dgen;
+    merr_t                err;
+
+    *nodep = NULL;
+
+    rmlock_rlock(&tree->ct_lock, &lock);
+
+    err = cn_tree_find_parent_child_link(tree, loc, &parent, &link);
+    if (ev(err)) {
+        rmlock_runlock(lock);
+        return err;
+    }
+
+    tn = *link;
+    if (tn && !cn_node_comp_token_get(tn)) {
+        rmlock_runlock(lock);
+
+        /* Nodes are never removed, so tn remains valid without the tree
+         * lock.  The tree lock must not be held while waiting as token
+         * holders may need it to finish (and release the token).
+         */
+        mutex_lock(&tree->ct_bulk_lock);
+        (void)atomic_inc_return(&tree->ct_bulk_waiters);
+        while (!cn_node_comp_token_get(tn))
+            cv_wait(&tree->ct_bulk_cv, &tree->ct_bulk_lock);
+        atomic_dec(&tree->ct_bulk_waiters);
+        mutex_unlock(&tree->ct_bulk_lock);
+
+        rmlock_rlock(&tree->ct_lock, &lock);
+
+        err = cn_tree_find_parent_child_link(tree, loc, &parent, &link);
+        if (ev(err))
+            goto errout;
+
+        assert(*link == tn);
+    }
+
+    if (ev(tn && !cn_node_isleaf(tn))) {
+        err = merr(EBUSY);
+        goto errout;
+    }
+
+    dgen = cn_get_ingest_dgen(tree->cn) + 1;
+
+    for (parent = tn ?: parent; parent; parent = parent->tn_parent) {
+        le = list_last_entry_or_null(&parent->tn_kvset_list, typeof(*le), le_link);
+        if (le)
+            dgen = min_t(u64, dgen, kvset_get_dgen(le->le_kvset));
+    }
+
+    /* Dgen zero is reserved (it means "not busy" as a work ID).
+     */
+    if (ev(dgen < 2)) {
+        err = merr(EAGAIN);
+        goto errout;
+    }
+
+    rmlock_runlock(lock);
+
+    *nodep = tn;
+    *dgenp = dgen - 1;
+
+    return 0;
+
+errout:
+    rmlock_runlock(lock);
+
+    if (tn)
+        cn_node_comp_token_put(tn);
+
+    return err;
+}
+
+/**
+ * cn_tree_bulk_update() - link bulk loaded kvsets into the tree
+ * @tree:   pointer to struct cn_tree.
+ * @txid:   cndb transaction that created the kvsets
+ * @behind: link the kvsets behind the existing kvsets of their nodes
+ * @kvsetc: number of kvsets
+ * @kvsetv: kvsets, each with a distinct destination
+ * @locv:   destination node of each kvset (which need not exist)
+ *
+ * The transaction is acknowledged with the tree write lock held so that
+ * no ingest or compaction can change the tree between verifying that the
+ * kvsets can still be linked and linking them.  Without @behind the tree
+ * must still be empty and the kvsets must have the next ingest dgen.
+ */
+merr_t
+cn_tree_bulk_update(
+    struct cn_tree *    tree,
+    u64                 txid,
+    bool                behind,
+    uint                kvsetc,
+    struct kvset **     kvsetv,
+    struct cn_node_loc *locv)
+{
+    struct cn_tree_node * tn, *pnode, **link;
+    struct cn_tree_node **nodev;
+    struct cn_samp_stats  pre, post, diff;
+    void *                lock;
+    merr_t                err = 0;
+    uint                  i;
+
+    nodev = calloc(kvsetc, sizeof(*nodev));
+    if (ev(!nodev))
+        return merr(ENOMEM);
+
+    /* Allocate missing nodes up front as there must not be
+     * any failures after ACK_C.  Nodes are never removed.
+     */
+    for (i = 0; i < kvsetc; i++) {
+        rmlock_rlock(&tree->ct_lock, &lock);
+        tn = cn_tree_find_node(tree, &locv[i]);
+        rmlock_runlock(lock);
+
+        if (tn)
+            continue;
+
+        nodev[i] = cn_node_alloc(tree, locv[i].node_level, locv[i].node_offset);
+        if (ev(!nodev[i])) {
+            err = merr(ENOMEM);
+            goto done;
+        }
+    }
+
+    rmlock_wlock(&tree->ct_lock);
+    if (!behind) {
+        if (!cn_tree_is_empty_locked(tree) ||
+            cn_get_ingest_dgen(tree->cn) + 1 != kvset_get_dgen(kvsetv[0]))
+            err = merr(EBUSY);
+    }
+
+    for (i = 0; i < kvsetc && !err; i++) {
+        err = cn_tree_find_parent_child_link(tree, &locv[i], &pnode, &link);
+        if (!err && *link && !cn_node_isleaf(*link))
+            err = merr(EBUSY);
+    }
+
+    if (!err)
+        err = cndb_txn_ack_c(tree->cndb, txid);
+
+    if (ev(err)) {
+        rmlock_wunlock(&tree->ct_lock);
+        goto done;
+    }
+
+    cn_tree_samp(tree, &pre);
+
+    for (i = 0; i < kvsetc; i++) {
+        cn_tree_find_parent_child_link(tree, &locv[i], &pnode, &link);
+
+        tn = *link;
+        if (!tn) {
+            tn = nodev[i];
+            nodev[i] = NULL;
+            assert(tn);
+
+            tn->tn_parent = pnode;
+            *link = tn;
+            pnode->tn_childc++;
+            if (pnode->tn_childc == 1)
+                tree->ct_i_nodec++;
+            else
+                tree->ct_l_nodec++;
+
+            tree->ct_lvl_max = max(tree->ct_lvl_max, tn->tn_loc.node_level);
+
+            /* The parent may have morphed from a leaf to an internal node.
+             */
+            if (pnode->tn_childc == 1)
+                cn_tree_samp_update_compact(tree, pnode);
+        }
+
+        if (behind)
+            kvset_list_add_tail(kvsetv[i], &tn->tn_kvset_list);
+        else
+            kvset_list_add(kvsetv[i], &tn->tn_kvset_list);
+
+        cn_tree_samp_update_compact(tree, tn);
+    }
+
+    /* Cursors notice the change via the ingest dgen.
+     */
+    cn_inc_ingest_dgen(tree->cn);
+
+    cn_tree_samp(tree, &post);
+
+    rmlock_wunlock(&tree->ct_lock);
+
+    cn_samp_diff(&diff, &post, &pre);
+    csched_notify_load(cn_get_sched(tree->cn), tree, &diff);
+
+done:
+    for (i = 0; i < kvsetc; i++)
+        cn_node_free(nodev[i]);
+    free(nodev);
+
+    return err;
+}
+
 void
 cn_tree_perfc_shape_report(
     struct cn_tree *  tree,
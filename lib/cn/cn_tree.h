@@ -57,6 +57,16 @@ cn_tree_lookup(
     struct kvs_buf *     kbuf,
     struct kvs_buf *     vbuf);
 
+merr_t
+cn_tree_lookup_multi(
+    struct cn_tree *     tree,
+    struct perfc_set *   pc,
+    struct kvs_ktuple *  ktv,
+    u64                  seq,
+    enum key_lookup_res *resv,
+    struct kvs_buf *     vbufv,
+    uint                 cnt);
+
 /**
  * cn_tree_initial_dgen() - return most current dgen in tree
  * @tree: tree to query
@@ -121,6 +131,34 @@ cn_tree_get_pfx_pivot(struct cn_tree *tree);
 void
 cn_tree_samp(const struct cn_tree *tree, struct cn_samp_stats *s_out);
 
+/**
+ * cn_tree_split_keys() - choose keys that divide a key range into slices of similar size
+ * @tree:     cn tree
+ * @pfx:      restrict the range to keys with this prefix
+ * @pfx_len:  length of @pfx, zero for the entire tree
+ * @splitc:   maximum number of split keys (one fewer than the number of slices)
+ * @buf:      buffer into which the split keys are copied
+ * @bufsz:    size of @buf
+ * @splitv:   (output) split keys in ascending order, pointing into @buf
+ * @splitcnt: (output) number of split keys
+ *
+ * Each split key is the smallest key of a slice other than the first.  The
+ * keys are chosen from samples of the wbtree leaf nodes of every kvset in the
+ * tree, weighted by the number of keys each sample represents.  Fewer than
+ * @splitc keys are returned if the range is too small to be divided further,
+ * or if @buf fills up (@splitc * HSE_KVS_KEY_LEN_MAX bytes always suffice).
+ */
+merr_t
+cn_tree_split_keys(
+    struct cn_tree *   tree,
+    const void *       pfx,
+    uint               pfx_len,
+    uint               splitc,
+    void *             buf,
+    size_t             bufsz,
+    struct kvs_ktuple *splitv,
+    uint *             splitcnt);
+
 merr_t
 cn_tree_init(void);
 
@@ -12,7 +12,9 @@
 #include <hse_util/workqueue.h>
 #include <hse_util/perfc.h>
 
+#include <hse_ikvdb/cn_iogov.h>
 #include <hse_ikvdb/sched_sts.h>
+#include <hse_ikvdb/limits.h>
 
 #include "cn_metrics.h"
 #include "kcompact.h"
@@ -21,10 +23,14 @@
 
 struct cn_tree;
 struct cn_tree_node;
+struct cn_node_loc;
 struct kv_iterator;
 struct kvset_list_entry;
 struct kvset_mblocks;
 struct kvset;
+struct cn_vcomp;
+struct cn_vcomp_samples;
+struct rtomb;
 
 enum cn_action {
     CN_ACTION_NONE = 0,
@@ -133,11 +139,21 @@ struct cn_work_est {
     u64                  cwe_keys;
 };
 
+/**
+ * struct cn_slice_pivot - smallest key of a key range slice of a compaction
+ */
+struct cn_slice_pivot {
+    const void *sp_key;
+    uint        sp_klen;
+};
+
 /**
  * struct cn_compaction_work - control structure for cn tree compaction
  *
  * @cw_work:         for linking into workqueues
  * @cw_debug:        enables debug stats
+ * @cw_iogov:        IO governor charged for compaction reads and writes
+ * @cw_iocls:        IO class charged by this work
  * @cw_tree:         cn tree
  * @cw_node:         node within cn tree
  * @cw_mark:         oldest kvset to be compacted
@@ -151,6 +167,7 @@ struct cn_work_est {
  * @cw_dgen_lo:      the dgen of the oldest kvset to be compacted
  * @cw_active_count: for tracking the number of active "root" or "other" threads
  * @cw_horizon:      sequence number horizon to use while compacting
+ * @cw_now:          time (seconds since the epoch) against which value ttls expire
  * @cw_outc:         number of output kvsets
  * @cw_outv:         outputs (mblock ids used to make output kvsets)
  * @cw_inputv:       number of input kvsets
@@ -158,6 +175,12 @@ struct cn_work_est {
  *                       kvsets during k-compaction
  * @cw_hash_shift:   used to determine output child when spilling
  * @cw_drop_tombv:   if true, then tombstones can be dropped in the merge loop
+ * @cw_rtombv:       range tombstones of the input kvsets (keys owned by the kvsets)
+ * @cw_rtombc:       number of elements in @cw_rtombv
+ * @cw_slicec:       number of key range slices to be merged in parallel
+ * @cw_pivotv:       smallest key of each slice (other than the first)
+ * @cw_vcomp:        value compressor applied by spill and kv-compaction
+ * @cw_samples:      dictionary training samples (NULL unless training)
  * @cw_work_txid:    the cndb transaction id
  * @cw_commitc:      keeps track of how many output mblocks have been committed
  * @cw_keep_vblks:   indicates whether or not vblocks should be deleted or
@@ -177,11 +200,14 @@ struct cn_compaction_work {
     /* initialized in cn_compaction() */
     struct work_struct       cw_work;
     u64                      cw_horizon;
+    u64                      cw_now;
     uint                     cw_iter_flags;
     uint                     cw_debug;
     bool                     cw_canceled;
     merr_t                   cw_err;
     struct workqueue_struct *cw_io_workq;
+    struct cn_iogov *        cw_iogov;
+    enum cn_iogov_class      cw_iocls;
     struct perfc_set *       cw_pc;
     atomic_int              *cw_cancel_request;
     struct mpool *           cw_ds;
@@ -230,6 +256,14 @@ struct cn_compaction_work {
     struct kvset_vblk_map cw_vbmap;
     u32                   cw_hash_shift;
     bool *                cw_drop_tombv;
+    struct rtomb *        cw_rtombv;
+    uint                  cw_rtombc;
+    uint                  cw_slicec;
+    struct cn_slice_pivot cw_pivotv[HSE_CN_COMPACTION_SLICES_MAX];
+
+    /* initialized in cn_spill() */
+    const struct cn_vcomp *  cw_vcomp;
+    struct cn_vcomp_samples *cw_samples;
 
     /* initialized in cn_compaction_worker() */
     u64                   cw_work_txid;
@@ -256,6 +290,32 @@ cn_tree_ingest_update(
     uint            ptlen,
     u64             ptseq);
 
+/* MTF_MOCK */
+u64
+cn_tree_dgen_claim(struct cn_tree *tree);
+
+/* MTF_MOCK */
+bool
+cn_tree_is_empty(struct cn_tree *tree);
+
+/* MTF_MOCK */
+merr_t
+cn_tree_bulk_pin(
+    struct cn_tree *      tree,
+    struct cn_node_loc *  loc,
+    struct cn_tree_node **nodep,
+    u64 *                 dgenp);
+
+/* MTF_MOCK */
+merr_t
+cn_tree_bulk_update(
+    struct cn_tree *    tree,
+    u64                 txid,
+    bool                behind,
+    uint                kvsetc,
+    struct kvset **     kvsetv,
+    struct cn_node_loc *locv);
+
 /* MTF_MOCK */
 void
 cn_tree_capped_compact(struct cn_tree *tree);
@@ -8,6 +8,7 @@
 
 /* MTF_MOCK_DECL(cn_tree_internal) */
 
+#include <hse_util/condvar.h>
 #include <hse_util/mutex.h>
 #include <hse_util/rmlock.h>
 #include <hse_util/spinlock.h>
@@ -102,6 +103,12 @@ struct cn_khashmap {
  * @ct_last_ptseq:
  * @ct_last_ptlen:  length of @ct_last_ptomb
  * @ct_last_ptomb:  if cn is a capped, this holds the last (largest) ptomb in cn
+ * @ct_dgen_claim:  the most recent dgen claimed by an ingest or bulk load
+ * @ct_bulk_behind: set while a bulk loader that links behind existing data
+ *                  exists (only one may exist at a time)
+ * @ct_bulk_waiters: number of bulk commits waiting in cn_tree_bulk_pin()
+ * @ct_bulk_lock:   protects @ct_bulk_cv
+ * @ct_bulk_cv:     signaled when a node's compaction token is released
  * @ct_kle_cache:   kvset list entry cache
  * @ct_lock:        read-mostly lock to protect kvset list
  *
@@ -149,6 +156,12 @@ struct cn_tree {
     u32 ct_last_ptlen;
     u8  ct_last_ptomb[HSE_KVS_PFX_LEN_MAX];
 
+    u64          ct_dgen_claim;
+    atomic_int   ct_bulk_behind;
+    atomic_int   ct_bulk_waiters;
+    struct mutex ct_bulk_lock;
+    struct cv    ct_bulk_cv;
+
     struct cn_kle_cache ct_kle_cache HSE_L1D_ALIGNED;
 
     struct rmlock ct_lock;
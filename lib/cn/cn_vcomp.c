@@ -0,0 +1,186 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/*
+ * Copyright (C) 2021 Micron Technology, Inc.  All rights reserved.
+ */
+
+#include <hse_util/alloc.h>
+#include <hse_util/assert.h>
+#include <hse_util/event_counter.h>
+#include <hse_util/logging.h>
+#include <hse_util/compression_lz4.h>
+#include <hse_util/compression_zstd.h>
+
+#include <hse_ikvdb/limits.h>
+#include <hse_ikvdb/kvs_rparams.h>
+
+#include "omf.h"
+#include "cn_vcomp.h"
+
+_Static_assert(HSE_CN_VCOMP_BLKSZ_MAX <= VBLOCK_CBLK_LEN_MAX, "compression.cn.block_size too large");
+
+enum vcomp_algorithm
+cn_vcomp_algo(const struct kvs_rparams *rp)
+{
+    enum vcomp_algorithm algo = rp->cn_vcomp;
+
+    if (algo == VCOMP_ALGO_NONE && rp->vcomp_defer)
+        algo = rp->value_compression;
+
+    /* Packing small values into compressed blocks requires an algorithm.
+     */
+    if (algo == VCOMP_ALGO_NONE && rp->cn_vcomp_blksz > 0)
+        algo = VCOMP_ALGO_LZ4;
+
+    return algo;
+}
+
+merr_t
+cn_vcomp_create(
+    enum vcomp_algorithm algo,
+    uint                 level,
+    uint                 blksz,
+    const void *         dict,
+    uint                 dictlen,
+    struct cn_vcomp **   vcp)
+{
+    struct cn_vcomp *vc;
+
+    INVARIANT(vcp);
+
+    if (ev(dictlen > VBLOCK_DICT_LEN_MAX || (dictlen && algo != VCOMP_ALGO_ZSTD)))
+        return merr(EINVAL);
+
+    if (ev(algo != VCOMP_ALGO_LZ4 && algo != VCOMP_ALGO_ZSTD))
+        return merr(EINVAL);
+
+    if (ev(blksz > VBLOCK_CBLK_LEN_MAX))
+        return merr(EINVAL);
+
+#ifndef HAVE_ZSTD
+    if (algo == VCOMP_ALGO_ZSTD)
+        return merr(ENOTSUP);
+#endif
+
+    vc = calloc(1, sizeof(*vc) + dictlen);
+    if (ev(!vc))
+        return merr(ENOMEM);
+
+    vc->cv_calgo = (algo == VCOMP_ALGO_ZSTD) ? VBLOCK_CALGO_ZSTD : VBLOCK_CALGO_LZ4;
+    vc->cv_level = level;
+    vc->cv_blksz = blksz;
+
+#ifdef HAVE_ZSTD
+    if (algo == VCOMP_ALGO_ZSTD) {
+        merr_t err;
+
+        if (dictlen > 0) {
+            memcpy(vc->cv_dict, dict, dictlen);
+            vc->cv_dictlen = dictlen;
+            vc->cv_dictid = compress_zstd_dict_id(dict, dictlen);
+        }
+
+        err = compress_zstd_cdict_create(vc->cv_dict, dictlen, level, &vc->cv_cdict);
+        if (ev(err)) {
+            free(vc);
+            return err;
+        }
+    }
+#endif
+
+    *vcp = vc;
+
+    return 0;
+}
+
+void
+cn_vcomp_destroy(struct cn_vcomp *vc)
+{
+    if (!vc)
+        return;
+
+#ifdef HAVE_ZSTD
+    compress_zstd_cdict_destroy(vc->cv_cdict);
+#endif
+    free(vc);
+}
+
+merr_t
+cn_vcomp_compress(
+    const struct cn_vcomp *vc,
+    const void *           src,
+    uint                   srclen,
+    void *                 dst,
+    uint                   dstcap,
+    uint *                 dstlen)
+{
+#ifdef HAVE_ZSTD
+    if (vc->cv_calgo == VBLOCK_CALGO_ZSTD)
+        return compress_zstd_compress(vc->cv_cdict, src, srclen, dst, dstcap, dstlen);
+#endif
+
+    return compress_lz4_ops.cop_compress(src, srclen, dst, dstcap, dstlen);
+}
+
+merr_t
+cn_vcomp_train(
+    const struct cn_vcomp *         vc,
+    const struct cn_vcomp_samples *samples,
+    uint                            dictsz,
+    struct cn_vcomp **              vcp)
+{
+#ifdef HAVE_ZSTD
+    size_t dictlen;
+    merr_t err;
+    void * dict;
+
+    INVARIANT(vc && samples && vcp);
+
+    if (ev(vc->cv_calgo != VBLOCK_CALGO_ZSTD || !dictsz || dictsz > VBLOCK_DICT_LEN_MAX))
+        return merr(EINVAL);
+
+    dict = malloc(dictsz);
+    if (ev(!dict))
+        return merr(ENOMEM);
+
+    err = compress_zstd_dict_train(
+        samples->cvs_buf, samples->cvs_lenv, samples->cvs_cnt, dict, dictsz, &dictlen);
+    if (!err)
+        err = cn_vcomp_create(VCOMP_ALGO_ZSTD, vc->cv_level, vc->cv_blksz, dict, dictlen, vcp);
+
+    free(dict);
+
+    return err;
+#else
+    return merr(ENOTSUP);
+#endif
+}
+
+merr_t
+cn_vcomp_samples_init(struct cn_vcomp_samples *samples, size_t cap)
+{
+    memset(samples, 0, sizeof(*samples));
+
+    /* Assume samples of at least 64 bytes on average.
+     */
+    samples->cvs_max = cap / 64 + 1;
+
+    samples->cvs_buf = malloc(cap);
+    samples->cvs_lenv = malloc(samples->cvs_max * sizeof(*samples->cvs_lenv));
+
+    if (ev(!samples->cvs_buf || !samples->cvs_lenv)) {
+        cn_vcomp_samples_fini(samples);
+        return merr(ENOMEM);
+    }
+
+    samples->cvs_cap = cap;
+
+    return 0;
+}
+
+void
+cn_vcomp_samples_fini(struct cn_vcomp_samples *samples)
+{
+    free(samples->cvs_buf);
+    free(samples->cvs_lenv);
+    memset(samples, 0, sizeof(*samples));
+}
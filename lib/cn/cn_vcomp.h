@@ -0,0 +1,179 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/*
+ * Copyright (C) 2021 Micron Technology, Inc.  All rights reserved.
+ */
+
+#ifndef HSE_KVS_CN_VCOMP_H
+#define HSE_KVS_CN_VCOMP_H
+
+#include <hse_util/inttypes.h>
+#include <hse_util/hse_err.h>
+
+#include <hse_ikvdb/vcomp_params.h>
+
+struct compress_zstd_cdict;
+struct kvs_rparams;
+
+/* Values no longer than this are eligible as dictionary training samples.
+ */
+#define CN_VCOMP_SAMPLE_LEN_MAX (16 * 1024)
+
+/* The sample budget, as a multiple of the dictionary size.  Zstd recommends
+ * roughly 100x for training to be effective.
+ */
+#define CN_VCOMP_SAMPLE_RATIO (100)
+
+/**
+ * struct cn_vcomp - value compression applied by cn compaction
+ * @cv_calgo:   vblock compression algorithm (VBLOCK_CALGO_*)
+ * @cv_level:   compression level (zstd only)
+ * @cv_blksz:   size of blocks into which to pack small values (zero if none)
+ * @cv_dictid:  dictionary ID (zero if no dictionary)
+ * @cv_dictlen: dictionary length (zero if no dictionary)
+ * @cv_cdict:   prepared zstd compression dictionary
+ * @cv_dict:    dictionary content, copied into each vblock header
+ *
+ * A cn_vcomp is immutable once created and may be shared by any number
+ * of concurrent compaction jobs.
+ */
+struct cn_vcomp {
+    uint                        cv_calgo;
+    uint                        cv_level;
+    uint                        cv_blksz;
+    uint                        cv_dictid;
+    uint                        cv_dictlen;
+    struct compress_zstd_cdict *cv_cdict;
+    u8                          cv_dict[];
+};
+
+/**
+ * struct cn_vcomp_samples - dictionary training sample set
+ * @cvs_buf:  concatenated samples
+ * @cvs_lenv: length of each sample
+ * @cvs_len:  total length of all samples
+ * @cvs_cap:  size of @cvs_buf
+ * @cvs_cnt:  number of samples
+ * @cvs_max:  max number of samples
+ */
+struct cn_vcomp_samples {
+    u8 *    cvs_buf;
+    size_t *cvs_lenv;
+    size_t  cvs_len;
+    size_t  cvs_cap;
+    uint    cvs_cnt;
+    uint    cvs_max;
+};
+
+/**
+ * cn_vcomp_algo() - select the algorithm with which compaction compresses values
+ * @rp: kvs rparams
+ *
+ * This is compression.cn.algorithm if given, otherwise the value algorithm
+ * when its compression is deferred to compaction, and lz4 if small values
+ * are to be packed into compressed blocks but no algorithm was chosen.
+ */
+enum vcomp_algorithm
+cn_vcomp_algo(const struct kvs_rparams *rp);
+
+/**
+ * cn_vcomp_create() - create a value compressor
+ * @algo:    compression algorithm (VCOMP_ALGO_LZ4 or VCOMP_ALGO_ZSTD)
+ * @level:   compression level (zstd only)
+ * @blksz:   size of blocks into which to pack small values (zero if none)
+ * @dict:    zstd dictionary (may be NULL)
+ * @dictlen: length of @dict
+ * @vcp:     (output) value compressor
+ *
+ * Return: ENOTSUP if @algo is not supported by this build.
+ */
+merr_t
+cn_vcomp_create(
+    enum vcomp_algorithm algo,
+    uint                 level,
+    uint                 blksz,
+    const void *         dict,
+    uint                 dictlen,
+    struct cn_vcomp **   vcp);
+
+void
+cn_vcomp_destroy(struct cn_vcomp *vc);
+
+/**
+ * cn_vcomp_compress() - compress a value
+ *
+ * Return: EFBIG if the compressed value would not fit in @dstcap bytes.
+ */
+merr_t
+cn_vcomp_compress(
+    const struct cn_vcomp *vc,
+    const void *           src,
+    uint                   srclen,
+    void *                 dst,
+    uint                   dstcap,
+    uint *                 dstlen);
+
+/**
+ * cn_vcomp_blkval() - determine whether to pack a value into a block
+ * @vc:   value compressor
+ * @vlen: uncompressed length of a value destined for a vblock
+ *
+ * Values no longer than a quarter of the block size are packed into
+ * blocks, larger values are compressed individually.
+ */
+static inline bool
+cn_vcomp_blkval(const struct cn_vcomp *vc, uint vlen)
+{
+    return vc && vlen <= vc->cv_blksz / 4;
+}
+
+/**
+ * cn_vcomp_train() - create a zstd compressor with a trained dictionary
+ * @vc:      compressor whose level and block size to use
+ * @samples: training samples
+ * @dictsz:  max dictionary size
+ * @vcp:     (output) value compressor
+ */
+merr_t
+cn_vcomp_train(
+    const struct cn_vcomp *         vc,
+    const struct cn_vcomp_samples *samples,
+    uint                            dictsz,
+    struct cn_vcomp **              vcp);
+
+merr_t
+cn_vcomp_samples_init(struct cn_vcomp_samples *samples, size_t cap);
+
+void
+cn_vcomp_samples_fini(struct cn_vcomp_samples *samples);
+
+/**
+ * cn_vcomp_samples_reserve() - reserve space for the next sample
+ * @samples: sample set
+ * @len:     length of the next sample
+ *
+ * Return: a pointer to @len bytes in which to copy the sample, or NULL
+ * if the sample set is full.  The sample is added by cn_vcomp_samples_add().
+ */
+static inline void *
+cn_vcomp_samples_reserve(struct cn_vcomp_samples *samples, size_t len)
+{
+    if (samples->cvs_cnt >= samples->cvs_max || samples->cvs_len + len > samples->cvs_cap)
+        return NULL;
+
+    return samples->cvs_buf + samples->cvs_len;
+}
+
+static inline void
+cn_vcomp_samples_add(struct cn_vcomp_samples *samples, size_t len)
+{
+    samples->cvs_lenv[samples->cvs_cnt++] = len;
+    samples->cvs_len += len;
+}
+
+static inline bool
+cn_vcomp_samples_full(const struct cn_vcomp_samples *samples)
+{
+    return samples->cvs_cnt >= samples->cvs_max || samples->cvs_len >= samples->cvs_cap;
+}
+
+#endif
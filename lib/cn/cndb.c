@@ -795,6 +795,8 @@ cndb_import_md(struct cndb *cndb, struct cndb_hdr_omf *buf, union cndb_mtu **mtu
             .pfx_len = mti->mti_prefix_len,
             .sfx_len = mti->mti_sfx_len,
             .pfx_pivot = mti->mti_prefix_pivot,
+            .filter_type =
+                (mti->mti_flags & CN_CFLAG_XOR_FILTER) ? KVS_FILTER_XOR : KVS_FILTER_BLOOM,
         };
 
         err = cndb_cnv_add(
@@ -2942,6 +2944,9 @@ cndb_cn_create2(struct cndb *cndb, const struct kvs_cparams *cparams, u64 *cnid_
     if (cparams->kvs_ext01)
         flags |= CN_CFLAG_CAPPED;
 
+    if (cparams->filter_type == KVS_FILTER_XOR)
+        flags |= CN_CFLAG_XOR_FILTER;
+
     omf_set_cninfo_flags(&info, flags);
 
     mutex_lock(&cndb->cndb_cnv_lock);
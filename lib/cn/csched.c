@@ -45,6 +45,7 @@ csched_create(
             err = sp_noop_create(&cs);
             break;
         case csched_policy_sp3:
+        case csched_policy_adapt:
             err = sp3_create(ds, rp, kvdb_alias, health, &cs);
             break;
     }
@@ -73,6 +74,15 @@ csched_notify_ingest(struct csched *handle, struct cn_tree *tree, size_t alen, s
         cs->cs_notify_ingest(cs, tree, alen, wlen);
 }
 
+void
+csched_notify_load(struct csched *handle, struct cn_tree *tree, const struct cn_samp_stats *diff)
+{
+    struct csched_ops *cs = (void *)handle;
+
+    if (cs && cs->cs_notify_load)
+        cs->cs_notify_load(cs, tree, diff);
+}
+
 void
 csched_tree_add(struct csched *handle, struct cn_tree *tree)
 {
@@ -12,6 +12,7 @@
 
 struct csched_ops;
 struct cn_tree;
+struct cn_samp_stats;
 struct throttle_sensor;
 struct hse_kvdb_compact_status;
 
@@ -23,6 +24,8 @@ struct csched_ops {
 
     void (*cs_notify_ingest)(struct csched_ops *, struct cn_tree *, size_t, size_t);
 
+    void (*cs_notify_load)(struct csched_ops *, struct cn_tree *, const struct cn_samp_stats *);
+
     void (*cs_throttle_sensor)(struct csched_ops *, struct throttle_sensor *);
 
     void (*cs_compact_request)(struct csched_ops *, int);
@@ -41,6 +41,8 @@ struct perfc_name csched_sp3_perfc[] _dt_section = {
     NE(PERFC_BA_SP3_LSIZE_TARG, 3, "target leaf size",         "t_sp3_lsize"),
     NE(PERFC_BA_SP3_RSIZE_CURR, 3, "currrent non-leaf size",   "c_sp3_rsize"),
     NE(PERFC_BA_SP3_RSIZE_TARG, 3, "target non-leaf size",     "t_sp3_rsize"),
+    NE(PERFC_BA_SP3_WAMP,       2, "writeamp",                 "c_sp3_wamp"),
+    NE(PERFC_BA_SP3_RAMP,       2, "readamp",                  "c_sp3_ramp"),
 };
 NE_CHECK(csched_sp3_perfc, PERFC_EN_SP3, "csched_sp3_perfc table/enum mismatch");
 
@@ -155,6 +157,25 @@ NE_CHECK(csched_sp3_perfc, PERFC_EN_SP3, "csched_sp3_perfc table/enum mismatch")
  *      size because long nodes decrease query performance, and large nodes
  *      are hard to compact and spill.  This extra logic is not strictly
  *      required to manage space amp.
+ *
+ * Adaptive Policy
+ * ---------------
+ * With csched_policy_adapt the red-black trees and work builders are the
+ * same, but instead of visiting job types round robin the monitor thread
+ * ranks them once a second from measured state:
+ *
+ *    - write amp:  (ingest bytes + compaction bytes) / ingest bytes, over
+ *                  an exponentially decaying window
+ *    - space amp:  SAMP_EST, as above
+ *    - read amp:   the most kvsets on any root-to-leaf path, which is the
+ *                  worst case number of kvsets a point get may visit
+ *    - throttle:   the root node throttle sensor value
+ *
+ * Space amp is held below csched_samp_max and read amp below
+ * csched_adapt_ramp_max.  Job types that aren't needed to meet either
+ * bound are ranked by csched_adapt_goal: minimizing write amp defers
+ * garbage and length compactions until a bound is at risk, while
+ * minimizing read or space amp spends idle bandwidth on them.
  */
 
 /* Red-Black Trees */
@@ -195,6 +216,8 @@ struct sp3_qinfo {
  * @mon_signaled: set by sp3_monitor_wake()
  * @mon_cv:       monitor thread conditional var
  * @samp_reduce:  if true, compact while samp > LWM
+ * @adaptive:     job selection by csched_policy_adapt
+ * @adapt:        measured state and job ranking for @adaptive
  * @mon_wq:       monitor thread workqueue
  * @mon_work:     monitor thread work struct
  * @name:         name for logging and data tree
@@ -255,6 +278,22 @@ struct sp3 {
     /* Throttle sensors */
     u64         rspill_dt_prev;
     atomic_long rspill_dt;
+    uint        rspill_sval;
+
+    /* Adaptive job selection.  Write amp is in SCALE units.
+     */
+    bool adaptive;
+    struct {
+        u64  ingest_wlen;
+        u64  comp_wlen;
+        u64  win_ingest;
+        u64  win_comp;
+        u64  next;
+        uint wamp;
+        uint ramp;
+
+        struct sp3_adapt_rank rank;
+    } adapt;
 
 
     u64 qos_log_ttl;
@@ -1268,6 +1307,38 @@ sp3_dirty_node(struct sp3 *sp, struct cn_tree_node *tn)
     rmlock_runlock(lock);
 }
 
+/* Caller must hold the tree lock.  New kvsets were added to the children
+ * of the given node (by a spill or a bulk load), some of which may be new.
+ */
+static void
+sp3_dirty_children_locked(struct sp3 *sp, struct cn_tree_node *tn)
+{
+    struct sp3_node *spn;
+    uint             fanout = tn->tn_tree->ct_cp->fanout;
+    uint             i;
+    bool             newleaf = false;
+
+    for (i = 0; i < fanout; i++) {
+        if (tn->tn_childv[i]) {
+            spn = tn2spn(tn->tn_childv[i]);
+            if (!spn->spn_initialized) {
+                sp3_node_init(sp, spn);
+                newleaf = true;
+            }
+
+            /* [HSE_REVISIT] Skip if node didn't change.
+             */
+            sp3_dirty_node_locked(sp, tn->tn_childv[i]);
+        }
+    }
+
+    /* Unlink parent from all RB trees as this might be the
+     * first time it morphed from leaf to internal node.
+     */
+    if (newleaf)
+        sp3_node_unlink(sp, spn);
+}
+
 static void
 sp3_process_workitem(struct sp3 *sp, struct cn_compaction_work *w)
 {
@@ -1305,34 +1376,11 @@ sp3_process_workitem(struct sp3 *sp, struct cn_compaction_work *w)
     sp->samp_wip.l_alen -= w->cw_est.cwe_samp.l_alen;
     sp->samp_wip.l_good -= w->cw_est.cwe_samp.l_good;
 
-    rmlock_rlock(&w->cw_tree->ct_lock, &lock);
-    if (w->cw_action == CN_ACTION_SPILL) {
+    sp->adapt.comp_wlen += w->cw_stats.ms_kblk_write.op_size + w->cw_stats.ms_vblk_write.op_size;
 
-        struct sp3_node *spn;
-        uint             fanout = w->cw_tree->ct_cp->fanout;
-        uint             i;
-        bool             newleaf = false;
-
-        for (i = 0; i < fanout; i++) {
-            if (tn->tn_childv[i]) {
-                spn = tn2spn(tn->tn_childv[i]);
-                if (!spn->spn_initialized) {
-                    sp3_node_init(sp, spn);
-                    newleaf = true;
-                }
-
-                /* [HSE_REVISIT] Skip if node didn't change.
-                 */
-                sp3_dirty_node_locked(sp, tn->tn_childv[i]);
-            }
-        }
-
-        /* Unlink parent from all RB trees as this might be the
-         * first time it morphed from leaf to internal node.
-         */
-        if (newleaf)
-            sp3_node_unlink(sp, spn);
-    }
+    rmlock_rlock(&w->cw_tree->ct_lock, &lock);
+    if (w->cw_action == CN_ACTION_SPILL)
+        sp3_dirty_children_locked(sp, tn);
 
     sp3_dirty_node_locked(sp, tn);
     rmlock_runlock(lock);
@@ -1369,6 +1417,7 @@ sp3_process_ingest(struct sp3 *sp)
         struct sp3_tree *spt = tree2spt(tree);
         long             alen;
         long             wlen;
+        int              loadc;
 
         if (atomic_read_acq(&sp->sp_ingest_count) == 0)
             break;
@@ -1389,10 +1438,48 @@ sp3_process_ingest(struct sp3 *sp)
 
             atomic_sub(&spt->spt_ingest_wlen, wlen);
             sp->samp.r_wlen += wlen;
+            sp->adapt.ingest_wlen += wlen;
 
             sp3_dirty_node(sp, tree->ct_root);
             ingested = true;
         }
+
+        /* Bulk loads add kvsets directly to nodes below the root,
+         * some of which may be new.
+         */
+        loadc = atomic_read_acq(&spt->spt_load_cnt);
+        if (loadc) {
+            struct cn_tree_node *tn;
+            struct tree_iter     iter;
+            void *               lock;
+
+            atomic_sub(&sp->sp_ingest_count, loadc);
+            atomic_sub(&spt->spt_load_cnt, loadc);
+
+            alen = atomic_read(&spt->spt_load_ialen);
+            atomic_sub(&spt->spt_load_ialen, alen);
+            sp->samp.i_alen += alen;
+
+            alen = atomic_read(&spt->spt_load_lalen);
+            atomic_sub(&spt->spt_load_lalen, alen);
+            sp->samp.l_alen += alen;
+
+            alen = atomic_read(&spt->spt_load_lgood);
+            atomic_sub(&spt->spt_load_lgood, alen);
+            sp->samp.l_good += alen;
+
+            rmlock_rlock(&tree->ct_lock, &lock);
+            tree_iter_init(tree, &iter, TRAVERSE_TOPDOWN);
+            while (NULL != (tn = tree_iter_next(tree, &iter))) {
+                if (!cn_node_isleaf(tn))
+                    sp3_dirty_children_locked(sp, tn);
+            }
+            sp3_dirty_node_locked(sp, tree->ct_root);
+            rmlock_runlock(lock);
+
+            sp->lvl_max = max(sp->lvl_max, tree->ct_lvl_max);
+            ingested = true;
+        }
     }
 
     if (ingested)
@@ -1706,6 +1793,17 @@ sp3_submit(struct sp3 *sp, struct cn_compaction_work *w, uint qnum)
         w->cw_io_workq = NULL;
     }
 
+    /* Root node work gates ingest, internal spills feed the leaves,
+     * and everything else merely reclaims garbage.
+     */
+    w->cw_iogov = cn_get_iogov(w->cw_tree->cn);
+    if (cn_node_isroot(tn))
+        w->cw_iocls = CN_IOGOV_ROOT;
+    else if (w->cw_action == CN_ACTION_SPILL)
+        w->cw_iocls = CN_IOGOV_INTERN;
+    else
+        w->cw_iocls = CN_IOGOV_LEAF;
+
     w->cw_sched = sp;
     w->cw_completion = sp3_work_complete;
     w->cw_progress = sp3_work_progress;
@@ -2126,6 +2224,7 @@ sp3_qos_check(struct sp3 *sp)
     }
 
     throttle_sensor_set(sp->throttle_sensor_root, (uint)sval);
+    sp->rspill_sval = sval;
 
     if (debug_qos(sp) && jclock_ns > sp->qos_log_ttl) {
         sp->qos_log_ttl = jclock_ns + NSEC_PER_SEC;
@@ -2141,25 +2240,170 @@ sp3_qos_check(struct sp3 *sp)
     }
 }
 
+/**
+ * sp3_schedule_jtype() - try to schedule a single job of the given type
+ */
+static bool
+sp3_schedule_jtype(struct sp3 *sp, enum sp3_job_type jtype)
+{
+    uint64_t thresh;
+    uint rp_leaf_pct;
+    bool job = false;
+    uint qnum;
+
+    /* convert rparam to internal scale */
+    rp_leaf_pct = sp->inputs.csched_leaf_pct * SCALE / EXT_SCALE;
+
+    switch (jtype) {
+    case jtype_root:
+        qnum = SP3_QNUM_ROOT;
+        if (qfull(sp, qnum))
+            break;
+
+        /* Implements root node query-shape rule.
+         * Uses "root" queue.
+         */
+        job = sp3_check_roots(sp, qnum);
+        break;
+
+    case jtype_ispill:
+        qnum = SP3_QNUM_INTERN;
+        if (qfull(sp, qnum)) {
+            qnum = SP3_QNUM_SHARED;
+            if (qfull(sp, qnum))
+                break;
+        }
+
+        thresh = (uint64_t)sp->thresh.ispill_pop_szgb << 32;
+        if (sp->lpct_targ < rp_leaf_pct)
+            thresh = 0;
+
+        /* Internal nodes count as garbage, so the adaptive policy
+         * spills them regardless of size while space amp is over.
+         */
+        if (sp->adaptive && sp->samp_targ > sp->samp_max)
+            thresh = 0;
+
+        /* Service RBT_RI_ALEN red-black tree, which
+         * contains both root and internal nodes and
+         * keeps leaf_pct above configured value.
+         * Implements:
+         *   - Root node space amp rule
+         *   - Internal node space amp rule
+         */
+        job = sp3_check_rb_tree(sp, RBT_RI_ALEN, thresh, wtype_ispill, qnum);
+        break;
+
+    case jtype_node_len:
+        qnum = SP3_QNUM_NODELEN;
+        if (qfull(sp, qnum))
+            break;
+
+        /* Service RBT_LI_LEN red-black tree.
+         * Implements:
+         *   - Internal node query-shape rule
+         *   - Leaf node query-shape rule
+         */
+        thresh = sp->adaptive ? (uint64_t)sp->adapt.rank.llen_min << 32 : 0;
+
+        job = sp3_check_rb_tree(sp, RBT_LI_LEN, thresh, wtype_node_len, qnum);
+        break;
+
+    case jtype_node_idle:
+        qnum = SP3_QNUM_SHARED;
+        if (qfull(sp, qnum))
+            break;
+
+        /* Service RBT_LI_IDLE red-black tree.
+         * Implements:
+         *   - Idle node query-shape rule
+         */
+        if (sp->thresh.llen_idlec > 0) {
+            thresh = (UINT32_MAX - (jclock_ns >> 32)) << 32;
+
+            job = sp3_check_rb_tree(sp, RBT_LI_IDLE, thresh, wtype_node_idle, qnum);
+        }
+        break;
+
+    case jtype_leaf_garbage:
+        qnum = SP3_QNUM_LGARB;
+        if (qfull(sp, qnum)) {
+            qnum = SP3_QNUM_SHARED;
+            if (qfull(sp, qnum))
+                break;
+        }
+
+        /* Service RBT_L_GARB red-black tree.
+         * Implements:
+         *   - Leaf node space amp rule
+         * Notes:
+         *   - Don't check for garbage unless ucomp is active
+         *     or if in samp_reduce mode and leaf percent is
+         *     somewhat caught up (ie, current leaf pct
+         *     (lpct_targ) is within 90% of rparam setting
+         *     (rp_leaf_pct)).
+         *   - When checking for garbage, if leaf percent is
+         *     behind, then bump up threshold so we don't waste
+         *     write amp by compacting nodes with a small
+         *     amount of garbage (we'd rather wait for
+         *     leaf_pct to catch up).
+         */
+        if (sp->adaptive) {
+            thresh = (uint64_t)sp->adapt.rank.gmin << 32;
+
+            job = sp3_check_rb_tree(sp, RBT_L_GARB, thresh, wtype_leaf_garbage, qnum);
+        } else if (sp->samp_reduce && (100 * sp->lpct_targ > 90 * rp_leaf_pct)) {
+            thresh = (sp->lpct_targ < rp_leaf_pct ? 10ul : 0ul) << 32;
+
+            job = sp3_check_rb_tree(sp, RBT_L_GARB, thresh, wtype_leaf_garbage, qnum);
+        }
+        break;
+
+    case jtype_leaf_size:
+        qnum = SP3_QNUM_LSIZE;
+        if (qfull(sp, qnum)) {
+            qnum = SP3_QNUM_SHARED;
+            if (qfull(sp, qnum))
+                break;
+        }
+
+        /* Service RBT_L_PCAP red-black tree.
+         * - Handles big leaf nodes with or with out garbage.
+         * Implements:
+         *   - Leaf node size rule
+         */
+        job = sp3_check_rb_tree(sp, RBT_L_PCAP, 0, wtype_leaf_size, qnum);
+        break;
+
+    case jtype_leaf_scatter:
+        qnum = SP3_QNUM_SHARED;
+        if (qfull(sp, qnum))
+            break;
+
+        /* Implements:
+         *   - Leaf node scatter rule
+         */
+        if (sp->thresh.lscatter_pct < 100) {
+            thresh = (UINT32_MAX - (jclock_ns >> 32)) << 32;
+
+            job = sp3_check_rb_tree(sp, RBT_L_SCAT, thresh, wtype_leaf_scatter, qnum);
+        }
+        break;
+
+    case jtype_MAX:
+        break;
+    }
+
+    return job;
+}
+
 /**
  * sp3_schedule() - try to schedule a single job
  */
 static void
 sp3_schedule(struct sp3 *sp)
 {
-    enum job_type {
-        jtype_root,
-        jtype_ispill,
-        jtype_node_len,
-        jtype_node_idle,
-        jtype_leaf_garbage,
-        jtype_leaf_size,
-        jtype_leaf_scatter,
-        jtype_MAX,
-    };
-
     bool job = false;
-    uint rp_leaf_pct;
     uint rr;
 
     /* This log message should never be emitted (unless someone has reduced
@@ -2173,142 +2417,202 @@ sp3_schedule(struct sp3 *sp)
         return;
     }
 
-    /* convert rparam to internal scale */
-    rp_leaf_pct = sp->inputs.csched_leaf_pct * SCALE / EXT_SCALE;
+    /* The adaptive policy tries job types in priority order, so lower
+     * priority types run only when higher priority queues are full or
+     * have nothing to do.
+     */
+    if (sp->adaptive) {
+        for (rr = 0; !job && rr < sp->adapt.rank.orderc; rr++)
+            job = sp3_schedule_jtype(sp, sp->adapt.rank.orderv[rr]);
+        return;
+    }
 
     for (rr = 0; !job && rr < jtype_MAX; rr++) {
-        uint64_t thresh;
-        uint qnum;
 
         /* round robin between job types */
         sp->rr_job_type++;
         if (sp->rr_job_type >= jtype_MAX)
             sp->rr_job_type = 0;
 
-        switch (sp->rr_job_type) {
-        case jtype_root:
-            qnum = SP3_QNUM_ROOT;
-            if (qfull(sp, qnum))
-                break;
+        job = sp3_schedule_jtype(sp, sp->rr_job_type);
+    }
+}
 
-            /* Implements root node query-shape rule.
-             * Uses "root" queue.
-             */
-            job = sp3_check_roots(sp, qnum);
-            break;
+/*
+ * sp3_adapt_ramp() - compute read amp
+ *
+ * Returns the largest number of kvsets on any root-to-leaf path, which
+ * is the most kvsets a point get may have to visit.
+ */
+static uint
+sp3_adapt_ramp(struct sp3 *sp)
+{
+    struct sp3_node *spn;
+    uint ramp = 0;
 
-        case jtype_ispill:
-            qnum = SP3_QNUM_INTERN;
-            if (qfull(sp, qnum)) {
-                qnum = SP3_QNUM_SHARED;
-                if (qfull(sp, qnum))
-                    break;
-            }
+    /* spn_alist is private to the monitor thread, but node stats and
+     * parent links are changed by compaction jobs under the tree lock.
+     */
+    list_for_each_entry(spn, &sp->spn_alist, spn_alink) {
+        struct cn_tree_node *tn = spn2tn(spn);
+        uint len = 0;
+        void *lock;
 
-            thresh = (uint64_t)sp->thresh.ispill_pop_szgb << 32;
-            if (sp->lpct_targ < rp_leaf_pct)
-                thresh = 0;
+        if (!cn_node_isleaf(tn))
+            continue;
 
-            /* Service RBT_RI_ALEN red-black tree, which
-             * contains both root and internal nodes and
-             * keeps leaf_pct above configured value.
-             * Implements:
-             *   - Root node space amp rule
-             *   - Internal node space amp rule
-             */
-            job = sp3_check_rb_tree(sp, RBT_RI_ALEN, thresh, wtype_ispill, qnum);
-            break;
+        rmlock_rlock(&tn->tn_tree->ct_lock, &lock);
+        for (; tn; tn = tn->tn_parent)
+            len += cn_ns_kvsets(&tn->tn_ns);
+        rmlock_runlock(lock);
 
-        case jtype_node_len:
-            qnum = SP3_QNUM_NODELEN;
-            if (qfull(sp, qnum))
-                break;
+        ramp = max(ramp, len);
+    }
 
-            /* Service RBT_LI_LEN red-black tree.
-             * Implements:
-             *   - Internal node query-shape rule
-             *   - Leaf node query-shape rule
-             */
-            job = sp3_check_rb_tree(sp, RBT_LI_LEN, 0, wtype_node_len, qnum);
-            break;
+    return ramp;
+}
 
-        case jtype_node_idle:
-            qnum = SP3_QNUM_SHARED;
-            if (qfull(sp, qnum))
-                break;
+/* Pressure of a metric relative to its bound, in SCALE units: zero at
+ * the bound, ONE at twice the bound, negative below the bound.
+ */
+static inline int
+sp3_adapt_press(uint64_t curr, uint64_t max)
+{
+    return max ? ((int64_t)curr - (int64_t)max) * ONE / (int64_t)max : 0;
+}
 
-            /* Service RBT_LI_IDLE red-black tree.
-             * Implements:
-             *   - Idle node query-shape rule
-             */
-            if (sp->thresh.llen_idlec > 0) {
-                thresh = (UINT32_MAX - (jclock_ns >> 32)) << 32;
+void
+sp3_adapt_rank(const struct sp3_adapt_input *in, struct sp3_adapt_rank *rank)
+{
+    int  samp_press, ramp_press, tpress, *prio;
+    uint i, j;
 
-                job = sp3_check_rb_tree(sp, RBT_LI_IDLE, thresh, wtype_node_idle, qnum);
-            }
-            break;
+    samp_press = sp3_adapt_press(in->samp, in->samp_max);
+    ramp_press = sp3_adapt_press(in->ramp, max_t(uint, in->ramp_max, 1));
+    tpress = min_t(int, in->rspill_sval, 2 * THROTTLE_SENSOR_SCALE) * ONE / THROTTLE_SENSOR_SCALE;
 
-        case jtype_leaf_garbage:
-            qnum = SP3_QNUM_LGARB;
-            if (qfull(sp, qnum)) {
-                qnum = SP3_QNUM_SHARED;
-                if (qfull(sp, qnum))
-                    break;
-            }
+    prio = rank->prio;
 
-            /* Service RBT_L_GARB red-black tree.
-             * Implements:
-             *   - Leaf node space amp rule
-             * Notes:
-             *   - Don't check for garbage unless ucomp is active
-             *     or if in samp_reduce mode and leaf percent is
-             *     somewhat caught up (ie, current leaf pct
-             *     (lpct_targ) is within 90% of rparam setting
-             *     (rp_leaf_pct)).
-             *   - When checking for garbage, if leaf percent is
-             *     behind, then bump up threshold so we don't waste
-             *     write amp by compacting nodes with a small
-             *     amount of garbage (we'd rather wait for
-             *     leaf_pct to catch up).
-             */
-            if (sp->samp_reduce && (100 * sp->lpct_targ > 90 * rp_leaf_pct)) {
-                thresh = (sp->lpct_targ < rp_leaf_pct ? 10ul : 0ul) << 32;
+    /* Root spills relieve ingest throttling and are always needed.
+     * Internal spills keep the leaf percentage up and shrink R_SIZE.
+     * Leaf size jobs keep nodes splittable.
+     */
+    prio[jtype_root] = ONE + tpress;
+    prio[jtype_ispill] = ONE / 2 + max(samp_press, 0);
+    if (in->lpct < in->lpct_min)
+        prio[jtype_ispill] += (in->lpct_min - in->lpct) * ONE / in->lpct_min;
+    prio[jtype_leaf_size] = ONE / 4;
+
+    /* Node length compactions reduce read amp.  Unless read amp is the
+     * goal only the longest nodes are compacted while within the bound.
+     */
+    prio[jtype_node_len] = ONE / 4 + 2 * ramp_press;
+    rank->llen_min = in->llen_max;
+    if (in->goal == csched_adapt_goal_ramp) {
+        prio[jtype_node_len] += ONE / 2;
+        rank->llen_min = 0;
+    } else if (ramp_press > 0) {
+        rank->llen_min = 0;
+    }
 
-                job = sp3_check_rb_tree(sp, RBT_L_GARB, thresh, wtype_leaf_garbage, qnum);
-            }
-            break;
+    /* Garbage compactions reduce space amp at the cost of write amp.
+     * When minimizing write amp they run only when over the bound, and
+     * until then only on nodes with substantial garbage.
+     */
+    prio[jtype_leaf_garbage] = 2 * samp_press;
+    rank->gmin = samp_press > ONE / 10 ? 0 : 20;
+    if (in->goal == csched_adapt_goal_samp) {
+        prio[jtype_leaf_garbage] = ONE / 2 + sp3_adapt_press(in->samp, in->samp_lwm);
+        rank->gmin = 0;
+    } else if (in->goal == csched_adapt_goal_ramp) {
+        rank->gmin = min_t(uint, rank->gmin, 10);
+    }
 
-        case jtype_leaf_size:
-            qnum = SP3_QNUM_LSIZE;
-            if (qfull(sp, qnum)) {
-                qnum = SP3_QNUM_SHARED;
-                if (qfull(sp, qnum))
-                    break;
-            }
+    /* Idle and scatter compactions are optional, they only improve
+     * read performance and are deferred while ingest is throttled.
+     */
+    prio[jtype_node_idle] = 0;
+    prio[jtype_leaf_scatter] = 0;
+    if (in->goal != csched_adapt_goal_wamp || ramp_press > 0) {
+        prio[jtype_node_idle] = ONE / 8 - tpress;
+        prio[jtype_leaf_scatter] = ONE / 8 - tpress;
+    }
 
-            /* Service RBT_L_PCAP red-black tree.
-             * - Handles big leaf nodes with or with out garbage.
-             * Implements:
-             *   - Leaf node size rule
-             */
-            job = sp3_check_rb_tree(sp, RBT_L_PCAP, 0, wtype_leaf_size, qnum);
-            break;
+    /* Insertion sort job types by descending priority, dropping those
+     * that have no priority.
+     */
+    rank->orderc = 0;
 
-        case jtype_leaf_scatter:
-            qnum = SP3_QNUM_SHARED;
-            if (qfull(sp, qnum))
-                break;
+    for (i = 0; i < jtype_MAX; i++) {
+        if (prio[i] <= 0)
+            continue;
 
-            /* Implements:
-             *   - Leaf node scatter rule
-             */
-            if (sp->thresh.lscatter_pct < 100) {
-                thresh = (UINT32_MAX - (jclock_ns >> 32)) << 32;
+        for (j = rank->orderc++; j > 0 && prio[rank->orderv[j - 1]] < prio[i]; j--)
+            rank->orderv[j] = rank->orderv[j - 1];
 
-                job = sp3_check_rb_tree(sp, RBT_L_SCAT, thresh, wtype_leaf_scatter, qnum);
-            }
-            break;
-        }
+        rank->orderv[j] = i;
+    }
+}
+
+/*
+ * sp3_adapt_update() - measure write, space and read amp and rank job types
+ *
+ * Updates sp->adapt once per second.  Called only by the monitor thread,
+ * which is also the only thread that updates sp->adapt and the space amp
+ * and throttle state read here, so none of it needs a lock.
+ */
+static void
+sp3_adapt_update(struct sp3 *sp, u64 now)
+{
+    struct sp3_adapt_rank *rank = &sp->adapt.rank;
+    struct sp3_adapt_input in;
+
+    if (now < sp->adapt.next)
+        return;
+
+    sp->adapt.next = now + NSEC_PER_SEC;
+
+    /* Write amp over a window that decays by 1/8 every second.
+     */
+    sp->adapt.win_ingest -= sp->adapt.win_ingest / 8;
+    sp->adapt.win_ingest += sp->adapt.ingest_wlen;
+    sp->adapt.win_comp -= sp->adapt.win_comp / 8;
+    sp->adapt.win_comp += sp->adapt.comp_wlen;
+    sp->adapt.ingest_wlen = 0;
+    sp->adapt.comp_wlen = 0;
+
+    if (sp->adapt.win_ingest > 0)
+        sp->adapt.wamp = ONE * (sp->adapt.win_ingest + sp->adapt.win_comp) / sp->adapt.win_ingest;
+
+    sp->adapt.ramp = sp3_adapt_ramp(sp);
+
+    perfc_set(&sp->sched_pc, PERFC_BA_SP3_WAMP, sp->adapt.wamp);
+    perfc_set(&sp->sched_pc, PERFC_BA_SP3_RAMP, sp->adapt.ramp);
+
+    in.goal = sp->ucomp_active ? csched_adapt_goal_samp : sp->rp->csched_adapt_goal;
+    in.samp = sp->samp_targ;
+    in.samp_max = sp->samp_max;
+    in.samp_lwm = sp->samp_lwm;
+    in.ramp = sp->adapt.ramp;
+    in.ramp_max = sp->rp->csched_adapt_ramp_max;
+    in.lpct = sp->lpct_targ;
+    in.lpct_min = sp->inputs.csched_leaf_pct * SCALE / EXT_SCALE;
+    in.rspill_sval = sp->rspill_sval;
+    in.llen_max = sp->thresh.llen_runlen_max;
+
+    sp3_adapt_rank(&in, rank);
+
+    if (debug_sched(sp)) {
+        slog_info(
+            HSE_SLOG_START("cn_sched_adapt"),
+            HSE_SLOG_FIELD("goal", "%u", in.goal),
+            HSE_SLOG_FIELD("wamp", "%.3f", scale2dbl(sp->adapt.wamp)),
+            HSE_SLOG_FIELD("samp", "%.3f", scale2dbl(sp->samp_targ)),
+            HSE_SLOG_FIELD("ramp", "%u", sp->adapt.ramp),
+            HSE_SLOG_FIELD("rspill_sval", "%u", in.rspill_sval),
+            HSE_SLOG_FIELD("njtypes", "%u", rank->orderc),
+            HSE_SLOG_FIELD("first", "%u", rank->orderc ? rank->orderv[0] : jtype_MAX),
+            HSE_SLOG_END);
     }
 }
 
@@ -2404,6 +2708,9 @@ sp3_monitor(struct work_struct *work)
 
         sp3_update_samp(sp);
 
+        if (sp->adaptive)
+            sp3_adapt_update(sp, now);
+
         err = kvdb_health_check(sp->health, KVDB_HEALTH_FLAG_ALL);
         if (ev(err)) {
             if (!bad_health)
@@ -2499,6 +2806,27 @@ sp3_op_notify_ingest(struct csched_ops *handle, struct cn_tree *tree, size_t ale
     sp3_monitor_wake(sp);
 }
 
+/**
+ * sp3_op_notify_load() - External API: notify bulk load has completed
+ */
+static void
+sp3_op_notify_load(
+    struct csched_ops *         handle,
+    struct cn_tree *            tree,
+    const struct cn_samp_stats *diff)
+{
+    struct sp3 *     sp = h2sp(handle);
+    struct sp3_tree *spt = tree2spt(tree);
+
+    atomic_add(&spt->spt_load_ialen, diff->i_alen);
+    atomic_add(&spt->spt_load_lalen, diff->l_alen);
+    atomic_add(&spt->spt_load_lgood, diff->l_good);
+    atomic_inc_rel(&spt->spt_load_cnt);
+    atomic_inc_rel(&sp->sp_ingest_count);
+
+    sp3_monitor_wake(sp);
+}
+
 static void
 sp3_tree_init(struct sp3_tree *spt)
 {
@@ -2633,6 +2961,8 @@ sp3_create(
 
     sp->rp = rp;
     sp->health = health;
+    sp->adaptive = csched_rp_policy(rp) == csched_policy_adapt;
+    sp->adapt.wamp = ONE;
 
     mutex_init(&sp->new_tlist_lock);
     mutex_init(&sp->work_list_lock);
@@ -2665,6 +2995,7 @@ sp3_create(
 
     sp->ops.cs_destroy = sp3_op_destroy;
     sp->ops.cs_notify_ingest = sp3_op_notify_ingest;
+    sp->ops.cs_notify_load = sp3_op_notify_load;
     sp->ops.cs_throttle_sensor = sp3_op_throttle_sensor;
     sp->ops.cs_compact_request = sp3_op_compact_request;
     sp->ops.cs_compact_status_get = sp3_op_compact_status_get;
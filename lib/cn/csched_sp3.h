@@ -12,6 +12,8 @@
 #include <hse_util/hse_err.h>
 #include <hse_util/list.h>
 
+#include <hse_ikvdb/csched.h>
+
 /* MTF_MOCK_DECL(csched_sp3) */
 
 #define RBT_MAX 6
@@ -50,8 +52,73 @@ struct sp3_tree {
     atomic_int       spt_enabled;
     atomic_ulong     spt_ingest_alen;
     atomic_ulong     spt_ingest_wlen;
+    atomic_int       spt_load_cnt;
+    atomic_ulong     spt_load_ialen;
+    atomic_ulong     spt_load_lalen;
+    atomic_ulong     spt_load_lgood;
+};
+
+enum sp3_job_type {
+    jtype_root,
+    jtype_ispill,
+    jtype_node_len,
+    jtype_node_idle,
+    jtype_leaf_garbage,
+    jtype_leaf_size,
+    jtype_leaf_scatter,
+    jtype_MAX,
+};
+
+/**
+ * struct sp3_adapt_input - measured state ranked by the adaptive policy
+ * @goal:        what to minimize once space and read amp are within bounds
+ * @samp:        space amp (any unit, as long as @samp_max and @samp_lwm agree)
+ * @samp_max:    space amp bound
+ * @samp_lwm:    space amp low water mark
+ * @ramp:        read amp (kvsets on the longest root-to-leaf path)
+ * @ramp_max:    read amp bound
+ * @lpct:        leaf percentage (any unit, as long as @lpct_min agrees)
+ * @lpct_min:    desired leaf percentage
+ * @rspill_sval: root spill throttle sensor value
+ * @llen_max:    node length above which length compactions always run
+ */
+struct sp3_adapt_input {
+    enum csched_adapt_goal goal;
+    uint                   samp;
+    uint                   samp_max;
+    uint                   samp_lwm;
+    uint                   ramp;
+    uint                   ramp_max;
+    uint                   lpct;
+    uint                   lpct_min;
+    uint                   rspill_sval;
+    uint                   llen_max;
 };
 
+/**
+ * struct sp3_adapt_rank - job types ranked by the adaptive policy
+ * @prio:     priority of each job type (zero or less if not to be scheduled)
+ * @orderv:   job types in descending priority order
+ * @orderc:   number of job types in @orderv
+ * @llen_min: minimum node length for length compactions
+ * @gmin:     minimum garbage percentage for garbage compactions
+ */
+struct sp3_adapt_rank {
+    int  prio[jtype_MAX];
+    uint orderv[jtype_MAX];
+    uint orderc;
+    uint llen_min;
+    uint gmin;
+};
+
+/**
+ * sp3_adapt_rank() - rank job types for the adaptive policy
+ * @in:   measured state
+ * @rank: (output) job type ranking
+ */
+void
+sp3_adapt_rank(const struct sp3_adapt_input *in, struct sp3_adapt_rank *rank);
+
 #if HSE_MOCKING
 #include "csched_sp3_ut.h"
 #endif /* HSE_MOCKING */
@@ -15,12 +15,14 @@
 #include <hse_ikvdb/kvset_builder.h>
 #include <hse_ikvdb/cn.h>
 #include <hse_ikvdb/kvs_rparams.h>
+#include <hse_ikvdb/rtomb.h>
 
 #include <hse_util/alloc.h>
 #include <hse_util/slab.h>
 #include <hse_util/page.h>
 #include <hse_util/assert.h>
 #include <hse_util/bloom_filter.h>
+#include <hse_util/xor_filter.h>
 #include <hse_util/event_counter.h>
 #include <hse_util/perfc.h>
 #include <hse_util/hlog.h>
@@ -96,6 +98,7 @@ struct hash_set {
  * @wbt_pgc:  Number of pages reserved for wbtree.
  * @blm_pgc:  Number of pages reserved for Bloom filter.
  * @bloom_elt_cap: Number of keys Bloom filter can hold at current size
+ * @xf_fpbits: Xor filter fingerprint width, or zero to build a Bloom filter
  * @hash_set:  Hash set to store key hashes. Used to build
  *             Bloom filter at end of kblock construction.
  * @num_keys:  Number of keys in kblock.
@@ -144,6 +147,7 @@ struct curr_kblock {
     uint32_t wbt_pgc;
 
     uint                   blm_elt_cap;
+    uint                   xf_fpbits;
     struct hash_set        hash_set;
     struct bf_bithash_desc desc;
 
@@ -166,11 +170,34 @@ free_pgc(struct curr_kblock *kblk)
     return 0;
 }
 
+/**
+ * struct kbb_rtombs - image of the range tombstone region of the last kblock
+ * @buf:     page aligned region image (struct kblock_rt_hdr_omf followed by records)
+ * @len:     bytes of @buf in use
+ * @alloc:   size of @buf
+ * @cnt:     number of range tombstones
+ * @min_off: offset in @buf of the smallest start key
+ * @max_off: offset in @buf of the largest end key
+ * @min_len: length of the smallest start key
+ * @max_len: length of the largest end key
+ */
+struct kbb_rtombs {
+    void  *buf;
+    size_t len;
+    size_t alloc;
+    uint   cnt;
+    uint   min_off;
+    uint   max_off;
+    u16    min_len;
+    u16    max_len;
+};
+
 /**
  * struct kblock_builder - Create kblocks from a stream of key/value pairs.
  * @ds: the dataset in which kblocks will be created
  * @finished_kblks: list of finished kblocks (written, not committed)
  * @curr: the kblock currently being built
+ * @rtombs: range tombstones to be written to the last kblock
  * @finished: mark builder as finished (end of life)
  * @max_size: Maximum mblock size of all configured media classes.
  */
@@ -182,9 +209,12 @@ struct kblock_builder {
     struct perfc_set *         pc;
     struct hlog *              hlog;
     struct cn_merge_stats *    mstats;
+    struct cn_iogov *          iogov;
+    enum cn_iogov_class        iocls;
     struct blk_list            finished_kblks;
     struct curr_kblock         curr;
     struct wbb *               ptree;
+    struct kbb_rtombs          rtombs;
     enum hse_mclass_policy_age agegroup;
     bool                       finished;
     uint                       pt_pgc;
@@ -359,6 +389,7 @@ mblk_blow_chunks(
 
         if (stats)
             count_ops(&stats->ms_kblk_write, 1, wlen, dt);
+        cn_iogov_request(self->iogov, self->iocls, wlen);
 
         written += wlen;
 
@@ -456,7 +487,8 @@ kblock_init(
     struct kvs_cparams *cp,
     struct kvs_rparams *rp,
     struct perfc_set *  pc,
-    uint32_t            max_size)
+    uint32_t            max_size,
+    bool                xor_filter)
 {
     merr_t err;
 
@@ -471,6 +503,9 @@ kblock_init(
     kblk->pc = pc;
     kblk->desc = bf_compute_bithash_est(rp->cn_bloom_prob);
 
+    if (xor_filter)
+        kblk->xf_fpbits = xf_fpbits(rp->cn_bloom_prob);
+
     err = wbb_create(&kblk->wbtree, kblk->wbt_pgc + free_pgc(kblk), &kblk->wbt_pgc);
     if (ev(err))
         return err;
@@ -546,7 +581,11 @@ kblock_add_entry(
             if (!free_pgc(kblk))
                 return 0;
             kblk->blm_pgc++;
-            kblk->blm_elt_cap = bf_element_estimate(kblk->desc, kblk->blm_pgc * PAGE_SIZE);
+
+            if (kblk->xf_fpbits)
+                kblk->blm_elt_cap = xf_element_estimate(kblk->xf_fpbits, kblk->blm_pgc * PAGE_SIZE);
+            else
+                kblk->blm_elt_cap = bf_element_estimate(kblk->desc, kblk->blm_pgc * PAGE_SIZE);
         }
 
         /* Add key's hash to hash_set. Hash only on the soft prefix. */
@@ -589,6 +628,41 @@ kblock_add_entry(
     return 0;
 }
 
+/**
+ * _kblock_finish_xor() - build an xor filter in the kblock's bloom buffer
+ * @xf: (output) xor filter descriptor
+ *
+ * The xor filter must be built from a single array of all the key hashes,
+ * so gather the hash set into a temporary array.
+ */
+static merr_t
+_kblock_finish_xor(struct curr_kblock *kblk, struct xor_filter *xf)
+{
+    struct hash_set_part *part;
+    u64 *                 hashv;
+    u32                   hashc = 0;
+    merr_t                err;
+
+    list_for_each_entry (part, &kblk->hash_set.part_list, part_link)
+        hashc += part->n_hashes;
+
+    hashv = malloc(hashc * sizeof(*hashv));
+    if (ev(!hashv))
+        return merr(ENOMEM);
+
+    hashc = 0;
+    list_for_each_entry (part, &kblk->hash_set.part_list, part_link) {
+        memcpy(hashv + hashc, part->hashvec, part->n_hashes * sizeof(*hashv));
+        hashc += part->n_hashes;
+    }
+
+    err = xf_filter_build(xf, kblk->xf_fpbits, hashv, hashc, kblk->bloom, kblk->bloom_len);
+
+    free(hashv);
+
+    return err;
+}
+
 /**
  * _kblock_finish_bloom() - finalize wbtree and Bloom filter regions
  * @blm_hdr: (output) Bloom filter header
@@ -598,6 +672,8 @@ _kblock_finish_bloom(struct curr_kblock *kblk, struct bloom_hdr_omf *blm_hdr)
 {
     struct bloom_filter   bloom;
     struct hash_set_part *part;
+    struct xor_filter     xf;
+    merr_t                err;
 
     if (kblk->num_keys == 0 || kblk->rp->cn_bloom_create == 0) {
         assert(kblk->blm_pgc == 0);
@@ -621,6 +697,31 @@ _kblock_finish_bloom(struct curr_kblock *kblk, struct bloom_hdr_omf *blm_hdr)
         kblk->bloom_used_max = max_t(uint, kblk->bloom_used_max, kblk->bloom_len);
 
         memset(kblk->bloom, 0, kblk->bloom_len);
+
+        if (kblk->xf_fpbits) {
+            err = _kblock_finish_xor(kblk, &xf);
+            if (!err) {
+                memset(blm_hdr, 0, sizeof(*blm_hdr));
+                omf_set_bh_magic(blm_hdr, BLOOM_OMF_MAGIC);
+                omf_set_bh_version(blm_hdr, BLOOM_OMF_VERSION);
+                omf_set_bh_type(blm_hdr, BLOOM_OMF_TYPE_XOR);
+                omf_set_bh_bitmapsz(blm_hdr, xf.xf_fpvsz);
+                omf_set_bh_modulus(blm_hdr, xf.xf_seglen);
+                omf_set_bh_n_hashes(blm_hdr, xf.xf_fpbits);
+                omf_set_bh_seed(blm_hdr, xf.xf_seed);
+
+                return 0;
+            }
+
+            if (merr_errno(err) == ENOMEM)
+                return err;
+
+            /* Failing to build an xor filter is exceedingly unlikely,
+             * but should it happen fall back to a Bloom filter in
+             * the same space (with a higher false positive rate).
+             */
+        }
+
         bf_filter_init(&bloom, kblk->desc, kblk->num_keys, kblk->bloom, kblk->bloom_len);
         list_for_each_entry (part, &kblk->hash_set.part_list, part_link) {
             bf_filter_insert_by_hashv(&bloom, part->hashvec, part->n_hashes);
@@ -631,6 +732,7 @@ _kblock_finish_bloom(struct curr_kblock *kblk, struct bloom_hdr_omf *blm_hdr)
     memset(blm_hdr, 0, sizeof(*blm_hdr));
     omf_set_bh_magic(blm_hdr, BLOOM_OMF_MAGIC);
     omf_set_bh_version(blm_hdr, BLOOM_OMF_VERSION);
+    omf_set_bh_type(blm_hdr, BLOOM_OMF_TYPE_BLOOM);
     omf_set_bh_bitmapsz(blm_hdr, bloom.bf_bitmapsz);
     omf_set_bh_modulus(blm_hdr, bloom.bf_modulus);
     omf_set_bh_bktshift(blm_hdr, bloom.bf_bktshift);
@@ -644,6 +746,8 @@ _kblock_finish_bloom(struct curr_kblock *kblk, struct bloom_hdr_omf *blm_hdr)
  * _kblock_make_header() - prepare kblock omf header for writing
  * @wbt_hdr: (input) Wbtree header
  * @blm_hdr: (input) Bloom filter header
+ * @rt:      (input) Range tombstones (only used if @rt_pgc is non-zero)
+ * @rt_pgc:  (input) Number of pages in the range tombstone region
  *
  * Caller must ensure the kblock is not empty.
  *
@@ -654,6 +758,8 @@ _kblock_finish_bloom(struct curr_kblock *kblk, struct bloom_hdr_omf *blm_hdr)
  *    wbtree header;
  *    pad to 8 bytes;
  *    bloom filter header;
+ *    pad to 8 bytes;
+ *    ptree header;
  *    pad so that min key is at end of page, min & max keys are 8-byte aligned
  *    max key;
  *    pad to 8 bytes;
@@ -666,6 +772,8 @@ _kblock_make_header(
     struct wbt_hdr_omf *   wbt_hdr,
     struct wbt_hdr_omf *   pt_hdr,
     uint                   pt_pgc,
+    struct kbb_rtombs *    rt,
+    uint                   rt_pgc,
     struct bloom_hdr_omf * blm_hdr,
     u64                    seqno_min,
     u64                    seqno_max,
@@ -676,11 +784,11 @@ _kblock_make_header(
     unsigned        off;
     const unsigned  align = 7;
 
-    struct key_obj  tmp_kobj;
+    struct key_obj  tmp_kobj, rt_min, rt_max;
     unsigned char   tmp_kobj_buf[HSE_KVS_KEY_LEN_MAX];
     unsigned int    tmp_kobj_bufsz = sizeof(tmp_kobj_buf);
 
-    assert(kblk->num_keys > 0);
+    assert(kblk->num_keys > 0 || rt_pgc > 0);
 
     memset(hdr, 0, KBLOCK_HDR_LEN);
 
@@ -765,6 +873,19 @@ _kblock_make_header(
         }
     }
 
+    /* Widen the min/max keys to cover the range tombstones, if any.
+     */
+    if (rt_pgc) {
+        key2kobj(&rt_min, rt->buf + rt->min_off, rt->min_len);
+        key2kobj(&rt_max, rt->buf + rt->max_off, rt->max_len);
+
+        if (!key_obj_len(min_kobj) || key_obj_cmp(&rt_min, min_kobj) < 0)
+            min_kobj = &rt_min;
+
+        if (!key_obj_len(max_kobj) || key_obj_cmp(&rt_max, max_kobj) > 0)
+            max_kobj = &rt_max;
+    }
+
 #ifndef NDEBUG
     if (omf_wbt_kmd_pgc(wbt_hdr)) {
         uint minkey_len = key_obj_len(min_kobj);
@@ -808,6 +929,12 @@ _kblock_make_header(
         omf_set_kbh_pt_dlen_pg(hdr, pt_pgc);
     }
 
+    if (rt_pgc) {
+        omf_set_kbh_rt_doff_pg(
+            hdr, KBLOCK_HDR_PAGES + kblk->wbt_pgc + kblk->blm_pgc + HLOG_PGC + pt_pgc);
+        omf_set_kbh_rt_dlen_pg(hdr, rt_pgc);
+    }
+
     omf_set_kbh_min_seqno(hdr, seqno_min);
     omf_set_kbh_max_seqno(hdr, seqno_max);
 
@@ -863,6 +990,7 @@ kblock_finish(struct kblock_builder *bld, struct wbb *ptree)
     merr_t err;
     u64    blkid = 0;
     uint   pt_pgc = 0;
+    uint   rt_pgc = 0;
     u64    tstart = 0;
     u64    kblocksz;
 
@@ -883,6 +1011,8 @@ kblock_finish(struct kblock_builder *bld, struct wbb *ptree)
     iov_max = 3 + 1 + wbb_max_inodec_get(kblk->wbtree) + wbb_kmd_pgc_get(kblk->wbtree);
     if (ptree && wbb_entries(ptree))
         iov_max += 1 + wbb_max_inodec_get(ptree) + wbb_kmd_pgc_get(ptree);
+    if (ptree && bld->rtombs.cnt)
+        iov_max += 1;
 
     iov = malloc(sizeof(*iov) * iov_max);
     if (ev(!iov))
@@ -938,10 +1068,27 @@ kblock_finish(struct kblock_builder *bld, struct wbb *ptree)
         iov_cnt += i;
     }
 
+    /* Range tombstones follow the ptomb tree in the last kblock. */
+    if (ptree && bld->rtombs.cnt) {
+        struct kbb_rtombs *rt = &bld->rtombs;
+        size_t             len = ALIGN(rt->len, PAGE_SIZE);
+
+        assert(len <= rt->alloc);
+        memset(rt->buf + rt->len, 0, len - rt->len);
+        omf_set_krh_magic(rt->buf, KBLOCK_RT_MAGIC);
+        omf_set_krh_entries(rt->buf, rt->cnt);
+
+        rt_pgc = len / PAGE_SIZE;
+        iov[iov_cnt].iov_base = rt->buf;
+        iov[iov_cnt].iov_len = len;
+        iov_cnt++;
+    }
+
     /* Format kblock header. */
     kblk->num_keys += ptree ? wbb_entries(ptree) : 0;
     _kblock_make_header(
-        kblk, ptree, &wbt_hdr, &pt_hdr, pt_pgc, &blm_hdr, bld->seqno_min, bld->seqno_max, kblk->kblk_hdr);
+        kblk, ptree, &wbt_hdr, &pt_hdr, pt_pgc, &bld->rtombs, rt_pgc, &blm_hdr,
+        bld->seqno_min, bld->seqno_max, kblk->kblk_hdr);
 
     assert(iov_cnt <= iov_max);
 
@@ -1053,7 +1200,8 @@ kbb_create(struct kblock_builder **builder_out, struct cn *cn, struct perfc_set
     if (ev(err))
         goto err_exit1;
 
-    err = kblock_init(&bld->curr, bld->cp, bld->rp, bld->pc, bld->max_size);
+    err = kblock_init(&bld->curr, bld->cp, bld->rp, bld->pc, bld->max_size,
+                      cn_get_flags(cn) & CN_CFLAG_XOR_FILTER);
     if (ev(err))
         goto err_exit2;
 
@@ -1085,6 +1233,7 @@ kbb_destroy(struct kblock_builder *bld)
     hlog_destroy(bld->hlog);
     kblock_free(&bld->curr);
     wbb_destroy(bld->ptree);
+    free_aligned(bld->rtombs.buf);
     abort_mblocks(bld->ds, &bld->finished_kblks);
     blk_list_free(&bld->finished_kblks);
     free(bld);
@@ -1121,6 +1270,69 @@ kbb_add_ptomb(
     return 0;
 }
 
+merr_t
+kbb_add_rtomb(struct kblock_builder *bld, const struct rtomb *rt)
+{
+    struct kbb_rtombs *   rtv = &bld->rtombs;
+    struct kblock_rt_omf *omf;
+    struct key_obj        ko, ko_ext;
+    size_t                need;
+    void *                p;
+
+    assert(!bld->finished);
+
+    if (!rtv->len)
+        rtv->len = sizeof(struct kblock_rt_hdr_omf);
+
+    need = sizeof(*omf) + ALIGN(rt->rt_slen + rt->rt_elen, 8);
+
+    if (rtv->len + need > rtv->alloc) {
+        size_t sz = ALIGN(max_t(size_t, rtv->alloc * 2, rtv->len + need), PAGE_SIZE);
+
+        p = alloc_page_aligned(sz);
+        if (ev(!p))
+            return merr(ENOMEM);
+
+        if (rtv->buf)
+            memcpy(p, rtv->buf, rtv->len);
+
+        free_aligned(rtv->buf);
+        rtv->buf = p;
+        rtv->alloc = sz;
+    }
+
+    omf = rtv->buf + rtv->len;
+    memset(omf, 0, need);
+    omf_set_kro_seqno(omf, rt->rt_seqno);
+    omf_set_kro_slen(omf, rt->rt_slen);
+    omf_set_kro_elen(omf, rt->rt_elen);
+
+    p = omf + 1;
+    memcpy(p, rt->rt_start, rt->rt_slen);
+    memcpy(p + rt->rt_slen, rt->rt_end, rt->rt_elen);
+
+    key2kobj(&ko, rt->rt_start, rt->rt_slen);
+
+    key2kobj(&ko_ext, rtv->buf + rtv->min_off, rtv->min_len);
+    if (!rtv->cnt || key_obj_cmp(&ko, &ko_ext) < 0) {
+        rtv->min_off = p - rtv->buf;
+        rtv->min_len = rt->rt_slen;
+    }
+
+    key2kobj(&ko, rt->rt_end, rt->rt_elen);
+
+    key2kobj(&ko_ext, rtv->buf + rtv->max_off, rtv->max_len);
+    if (!rtv->cnt || key_obj_cmp(&ko, &ko_ext) > 0) {
+        rtv->max_off = p + rt->rt_slen - rtv->buf;
+        rtv->max_len = rt->rt_elen;
+    }
+
+    rtv->len += need;
+    rtv->cnt++;
+
+    return 0;
+}
+
 /* Add a key with a vref to kblock. Create new kblock if needed. */
 merr_t
 kbb_add_entry(
@@ -1200,18 +1412,20 @@ kbb_finish(struct kblock_builder *bld, struct blk_list *kblks, u64 seqno_min, u6
     assert(bld->finished_kblks.n_blks == 0 || !kblock_is_empty(&bld->curr));
 
     /* Finish main wbtree. If there's enough space left in the kblock, add
-     * ptree to this kblock. If not, add the ptree to the next kblock.
+     * ptree and range tombstones to this kblock. If not, add them to the
+     * next kblock.
      */
     if (!kblock_is_empty(&bld->curr)) {
         struct wbb *pt = 0;
         uint64_t    kbsize = bld->max_size;
         uint64_t    ptsize = (wbb_page_cnt_get(bld->ptree)) * PAGE_SIZE;
+        uint64_t    rtsize = ALIGN(bld->rtombs.len, PAGE_SIZE);
         uint64_t    kbused =
             (KBLOCK_HDR_PAGES + HLOG_PGC + bld->curr.blm_pgc + wbb_page_cnt_get(bld->curr.wbtree)) *
             PAGE_SIZE;
 
-        /* Write ptree here if we have enough space */
-        if ((kbused + ptsize < kbsize)) {
+        /* Write ptree and range tombstones here if we have enough space */
+        if ((kbused + ptsize + rtsize < kbsize)) {
             pt_kblock = false;
             pt = bld->ptree;
         }
@@ -1221,7 +1435,7 @@ kbb_finish(struct kblock_builder *bld, struct blk_list *kblks, u64 seqno_min, u6
             return err;
     }
 
-    if (wbb_entries(bld->ptree) && pt_kblock) {
+    if ((wbb_entries(bld->ptree) || bld->rtombs.cnt) && pt_kblock) {
         err = kblock_finish(bld, bld->ptree);
         if (ev(err))
             return err;
@@ -1269,6 +1483,21 @@ kbb_set_merge_stats(struct kblock_builder *bld, struct cn_merge_stats *stats)
     bld->mstats = stats;
 }
 
+void
+kbb_set_iogov(struct kblock_builder *bld, struct cn_iogov *gov, enum cn_iogov_class cls)
+{
+    bld->iogov = gov;
+    bld->iocls = cls;
+}
+
+void
+kbb_hlog_union(struct kblock_builder *bld, struct kblock_builder *src)
+{
+    assert(!bld->finished);
+
+    hlog_union(bld->hlog, hlog_data(src->hlog));
+}
+
 #if HSE_MOCKING
 #include "kblock_builder_ut_impl.i"
 #endif /* HSE_MOCKING */
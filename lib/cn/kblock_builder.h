@@ -12,11 +12,14 @@
 #include <hse_util/perfc.h>
 #include <hse_util/key_util.h>
 
+#include <hse_ikvdb/cn_iogov.h>
+
 struct cn;
 struct kblock_builder;
 struct blk_list;
 struct kvs_rparams;
 struct cn_merge_stats;
+struct rtomb;
 
 enum hse_mclass;
 enum hse_mclass_policy_age;
@@ -84,6 +87,18 @@ kbb_add_ptomb(
     uint                   kmd_len,
     struct kbb_key_stats * stats);
 
+/**
+ * kbb_add_rtomb() - add a range tombstone to the last kblock
+ * @bld: builder handle
+ * @rt:  range tombstone (copied)
+ *
+ * Range tombstones are written to a region of the kvset's last kblock,
+ * in the order in which they were added.
+ */
+/* MTF_MOCK */
+merr_t
+kbb_add_rtomb(struct kblock_builder *bld, const struct rtomb *rt);
+
 /**
  * kbb_add_entry() - Store a key and a value reference in a kblock.
  * @bld: builder handle
@@ -141,6 +156,26 @@ kbb_get_agegroup(struct kblock_builder *bld);
 void
 kbb_set_merge_stats(struct kblock_builder *bld, struct cn_merge_stats *stats);
 
+/**
+ * kbb_set_iogov() - charge kblock writes to an IO governor
+ */
+void
+kbb_set_iogov(struct kblock_builder *bld, struct cn_iogov *gov, enum cn_iogov_class cls);
+
+/**
+ * kbb_hlog_union() - merge the hyperloglog of one builder into another
+ * @bld: builder whose hlog is to be updated
+ * @src: builder whose hlog is to be merged into @bld's hlog
+ *
+ * Used when the kblocks from several builders are combined into a single
+ * kvset, in which case the hlog in the final kblock of the kvset must
+ * account for the keys from all the builders.  Must be called before
+ * kbb_finish() is called on @bld.
+ */
+/* MTF_MOCK */
+void
+kbb_hlog_union(struct kblock_builder *bld, struct kblock_builder *src);
+
 #if HSE_MOCKING
 #include "kblock_builder_ut.h"
 #endif /* HSE_MOCKING */
@@ -13,9 +13,11 @@
 #include <hse_util/arch.h>
 #include <hse_util/bloom_filter.h>
 #include <hse_util/logging.h>
+#include <hse_util/xor_filter.h>
 
 #include <hse_ikvdb/kvs_rparams.h>
 #include <hse_ikvdb/tuple.h>
+#include <hse_ikvdb/rtomb.h>
 
 #include <mpool/mpool.h>
 
@@ -56,6 +58,7 @@ kbr_get_kblock_desc(
     kblkdesc->map_idx = map_idx;
     kblkdesc->map_base = base;
     kblkdesc->mclass = props->mpr_mclass;
+    kblkdesc->bcache = 0;
 
     return 0;
 }
@@ -66,7 +69,9 @@ kbr_read_wbt_region_desc_mem(void *wbt_hdr, struct wbt_desc *desc)
     desc->wbd_version = wbt_hdr_version(wbt_hdr);
 
     switch (desc->wbd_version) {
-        case WBT_TREE_VERSION:
+        case WBT_TREE_VERSION6:
+        case WBT_TREE_VERSION7:
+        case WBT_TREE_VERSION8:
             desc->wbd_root = omf_wbt_root(wbt_hdr);
             desc->wbd_leaf = omf_wbt_leaf(wbt_hdr);
             desc->wbd_leaf_cnt = omf_wbt_leaf_cnt(wbt_hdr);
@@ -163,6 +168,65 @@ kbr_read_pt_region_desc(struct kvs_mblk_desc *kblkdesc, struct wbt_desc *desc)
     return err;
 }
 
+merr_t
+kbr_read_rtombs(struct kvs_mblk_desc *kblkdesc, rtomb_visit_fn *visit, void *arg)
+{
+    const struct kblock_rt_hdr_omf *rt_hdr;
+    struct kblock_hdr_omf *         kb_hdr;
+    const void *                    p, *end;
+    off_t                           pg_idxs[1];
+    void *                          pg;
+    uint                            entries, i;
+    merr_t                          err;
+
+    pg_idxs[0] = 0;
+    err = mpool_mcache_getpages(kblkdesc->map, 1, kblkdesc->map_idx, pg_idxs, &pg);
+    if (ev(err))
+        return err;
+
+    kb_hdr = pg;
+    if (!kblock_hdr_valid(kb_hdr))
+        return merr(EINVAL);
+
+    if (omf_kbh_version(kb_hdr) < KBLOCK_HDR_VERSION6 || !omf_kbh_rt_dlen_pg(kb_hdr))
+        return 0;
+
+    rt_hdr = kblkdesc->map_base + omf_kbh_rt_doff_pg(kb_hdr) * PAGE_SIZE;
+    end = (const void *)rt_hdr + omf_kbh_rt_dlen_pg(kb_hdr) * PAGE_SIZE;
+
+    if (ev(omf_krh_magic(rt_hdr) != KBLOCK_RT_MAGIC))
+        return merr(EINVAL);
+
+    entries = omf_krh_entries(rt_hdr);
+    p = rt_hdr + 1;
+
+    for (i = 0; i < entries; i++) {
+        const struct kblock_rt_omf *omf = p;
+        struct rtomb                rt;
+
+        if (ev(p + sizeof(*omf) > end))
+            return merr(EPROTO);
+
+        rt.rt_seqno = omf_kro_seqno(omf);
+        rt.rt_slen = omf_kro_slen(omf);
+        rt.rt_elen = omf_kro_elen(omf);
+        rt.rt_start = omf + 1;
+        rt.rt_end = rt.rt_start + rt.rt_slen;
+        rt.rt_maxend = rt.rt_end;
+        rt.rt_maxelen = rt.rt_elen;
+
+        p = rt.rt_start + ALIGN(rt.rt_slen + rt.rt_elen, 8);
+        if (ev(p > end))
+            return merr(EPROTO);
+
+        err = visit(arg, &rt);
+        if (err)
+            return err;
+    }
+
+    return 0;
+}
+
 merr_t
 kbr_read_blm_region_desc(struct kvs_mblk_desc *kbd, struct bloom_desc *desc)
 {
@@ -201,12 +265,24 @@ kbr_read_blm_region_desc(struct kvs_mblk_desc *kbd, struct bloom_desc *desc)
      * it's safe to run without blooms, albeit at a big hit to read perf.
      */
     version = omf_bh_version(blm_omf);
-    if (ev(version != BLOOM_OMF_VERSION)) {
+    if (ev(version < BLOOM_OMF_VERSION5 || version > BLOOM_OMF_VERSION)) {
         log_err("bloom %lx invalid version %u (expected %u)",
                 mbid, version, BLOOM_OMF_VERSION);
         return 0;
     }
 
+    /* v5 blooms predate bh_type, which was reserved (zero) in v5.
+     */
+    desc->bd_type = BLOOM_OMF_TYPE_BLOOM;
+    if (version >= BLOOM_OMF_VERSION6)
+        desc->bd_type = omf_bh_type(blm_omf);
+
+    if (ev(desc->bd_type != BLOOM_OMF_TYPE_BLOOM && desc->bd_type != BLOOM_OMF_TYPE_XOR)) {
+        log_err("bloom %lx invalid type %u", mbid, desc->bd_type);
+        memset(desc, 0, sizeof(*desc));
+        return 0;
+    }
+
     desc->bd_first_page = omf_kbh_blm_doff_pg(hdr);
     desc->bd_n_pages = omf_kbh_blm_dlen_pg(hdr);
 
@@ -216,6 +292,17 @@ kbr_read_blm_region_desc(struct kvs_mblk_desc *kbd, struct bloom_desc *desc)
     desc->bd_rotl = omf_bh_rotl(blm_omf);
     desc->bd_bktmask = (1u << desc->bd_bktshift) - 1;
 
+    if (desc->bd_type == BLOOM_OMF_TYPE_XOR) {
+        desc->bd_seed = omf_bh_seed(blm_omf);
+
+        if (ev(desc->bd_n_hashes < XF_FPBITS_MIN || desc->bd_n_hashes > XF_FPBITS_MAX ||
+               desc->bd_n_hashes % 8)) {
+            log_err("bloom %lx invalid xor fingerprint width %u", mbid, desc->bd_n_hashes);
+            memset(desc, 0, sizeof(*desc));
+            return 0;
+        }
+    }
+
     return 0;
 }
 
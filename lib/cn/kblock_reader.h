@@ -8,6 +8,7 @@
 
 #include <hse_util/inttypes.h>
 #include <hse_ikvdb/tuple.h>
+#include <hse_ikvdb/rtomb.h>
 
 struct mpool;
 struct mpool_mcache_map;
@@ -86,6 +87,18 @@ kbr_read_blm_pages(
 merr_t
 kbr_read_pt_region_desc(struct kvs_mblk_desc *kblkdesc, struct wbt_desc *desc);
 
+/**
+ * kbr_read_rtombs() - Enumerate the range tombstones of a kblock
+ * @kblkdesc: KVBLOCK_DESC for KBLOCK to read
+ * @visit:    called once for each range tombstone
+ * @arg:      passed through to @visit
+ *
+ * Only the last kblock of a kvset has range tombstones.  The keys passed
+ * to @visit point into the kblock's mcache map.
+ */
+merr_t
+kbr_read_rtombs(struct kvs_mblk_desc *kblkdesc, rtomb_visit_fn *visit, void *arg);
+
 merr_t
 kbr_read_seqno_range(struct kvs_mblk_desc *kblkdesc, u64 *seqno_min, u64 *seqno_max);
 
@@ -6,6 +6,7 @@
 #include <hse_util/platform.h>
 #include <hse_util/event_counter.h>
 #include <hse_util/logging.h>
+#include <hse_util/bin_heap.h>
 
 #include <hse_ikvdb/kvs_rparams.h>
 #include <hse_ikvdb/limits.h>
@@ -36,6 +37,27 @@ struct merge_item {
     uint                   src;
 };
 
+/**
+ * struct merge_src -- element source that feeds a merge input into the bin_heap
+ * @ms_es:    element source
+ * @ms_iter:  merge input
+ * @ms_stats: merge stats
+ * @ms_err:   error from the last read of @ms_iter
+ * @ms_item:  item most recently read from @ms_iter
+ */
+struct merge_src {
+    struct element_source  ms_es;
+    struct kv_iterator *   ms_iter;
+    struct cn_merge_stats *ms_stats;
+    merr_t                 ms_err;
+    struct merge_item      ms_item;
+};
+
+struct merge {
+    struct bin_heap2 *m_bh;
+    struct merge_src *m_srcv;
+};
+
 static int
 merge_item_compare(const void *a_blob, const void *b_blob)
 {
@@ -57,81 +79,116 @@ merge_item_compare(const void *a_blob, const void *b_blob)
     return 0;
 }
 
-static merr_t
-replenish(struct bin_heap *bh, struct kv_iterator **iterv, uint src, struct cn_merge_stats *stats)
+static u64
+merge_item_disc(const void *blob)
 {
-    struct kv_iterator *iter = iterv[src];
-    merr_t              err;
-    struct merge_item   item;
+    const struct merge_item *item = blob;
 
-    if (HSE_UNLIKELY(iter->kvi_eof))
-        return 0;
+    return key_obj_disc64(&item->kobj);
+}
 
-    err = kvset_iter_next_key(iter, &item.kobj, &item.vctx);
-    if (ev(err))
-        return err;
-    if (HSE_UNLIKELY(iter->kvi_eof))
-        return 0;
+static bool
+merge_src_next(struct element_source *es, void **element)
+{
+    struct merge_src * ms = container_of(es, struct merge_src, ms_es);
+    struct merge_item *item = &ms->ms_item;
 
-    item.src = src;
+    if (HSE_UNLIKELY(ms->ms_iter->kvi_eof))
+        return false;
 
-    err = bin_heap_insert(bh, &item);
-    if (ev(err))
-        return err;
+    ms->ms_err = kvset_iter_next_key(ms->ms_iter, &item->kobj, &item->vctx);
+    if (ev(ms->ms_err) || HSE_UNLIKELY(ms->ms_iter->kvi_eof))
+        return false;
 
-    stats->ms_keys_in++;
-    stats->ms_key_bytes_in += key_obj_len(&item.kobj);
+    ms->ms_stats->ms_keys_in++;
+    ms->ms_stats->ms_key_bytes_in += key_obj_len(&item->kobj);
 
-    return 0;
+    *element = item;
+
+    return true;
 }
 
 static merr_t
 merge_init(
-    struct bin_heap **     bh_out,
+    struct merge *         merge,
     struct kv_iterator **  iterv,
     u32                    iterc,
     struct cn_merge_stats *stats)
 {
-    u32    i;
-    merr_t err;
+    struct element_source **esv;
+    u32                     i;
+    merr_t                  err;
 
-    err = bin_heap_create(bh_out, iterc, sizeof(struct merge_item), merge_item_compare);
+    err = bin_heap2_create(iterc, merge_item_compare, &merge->m_bh);
     if (ev(err))
-        goto err_exit1;
+        return err;
+
+    bin_heap2_set_disc(merge->m_bh, merge_item_disc);
+
+    merge->m_srcv = malloc(iterc * (sizeof(*merge->m_srcv) + sizeof(*esv)));
+    if (ev(!merge->m_srcv)) {
+        err = merr(ENOMEM);
+        goto err_exit;
+    }
+
+    esv = (void *)(merge->m_srcv + iterc);
 
     stats->ms_srcs = iterc;
 
     for (i = 0; i < iterc; i++) {
-        err = replenish(*bh_out, iterv, i, stats);
-        if (ev(err))
-            goto err_exit2;
+        struct merge_src *ms = merge->m_srcv + i;
+
+        ms->ms_es = es_make(merge_src_next, NULL, NULL);
+        ms->ms_iter = iterv[i];
+        ms->ms_stats = stats;
+        ms->ms_err = 0;
+        ms->ms_item.src = i;
+        esv[i] = &ms->ms_es;
     }
 
+    err = bin_heap2_prepare(merge->m_bh, iterc, esv);
+
+    for (i = 0; i < iterc && !err; i++)
+        err = merge->m_srcv[i].ms_err;
+
+    if (ev(err))
+        goto err_exit;
+
     return 0;
 
-err_exit2:
-    bin_heap_destroy(*bh_out);
-err_exit1:
+err_exit:
+    free(merge->m_srcv);
+    bin_heap2_destroy(merge->m_bh);
     return err;
 }
 
+static void
+merge_fini(struct merge *merge)
+{
+    free(merge->m_srcv);
+    bin_heap2_destroy(merge->m_bh);
+}
+
 /* return true if item returned, false if no more items */
 static HSE_ALWAYS_INLINE bool
-get_next_item(
-    struct bin_heap *      bh,
-    struct kv_iterator **  iterv,
-    struct merge_item *    item,
-    struct cn_merge_stats *stats,
-    merr_t *               err_out)
+get_next_item(struct merge *merge, struct merge_item *item, merr_t *err_out)
 {
-    bool got_item;
-
-    got_item = bin_heap_get_delete(bh, item);
-    if (got_item)
-        *err_out = replenish(bh, iterv, item->src, stats);
-    else
-        *err_out = 0;
-    return got_item;
+    struct merge_item *top;
+
+    *err_out = 0;
+
+    if (!bin_heap2_peek(merge->m_bh, (void **)&top))
+        return false;
+
+    /* Copy out the item before bin_heap2_pop() overwrites it with the
+     * source's next item.
+     */
+    *item = *top;
+    bin_heap2_pop(merge->m_bh, (void **)&top);
+
+    *err_out = merge->m_srcv[item->src].ms_err;
+
+    return true;
 }
 
 /**
@@ -143,7 +200,7 @@ get_next_item(
 static merr_t
 kcompact(struct cn_compaction_work *w)
 {
-    struct bin_heap * bh;
+    struct merge      merge;
     struct merge_item curr;
     merr_t            err;
 
@@ -158,6 +215,7 @@ kcompact(struct cn_compaction_work *w)
 
     bool pt_set = false;
     u64  pt_seq = 0;
+    u64  rt_seq = 0;
     u64  tprog = 0;
 
     u64 dbg_prev_seq HSE_MAYBE_UNUSED;
@@ -175,11 +233,11 @@ kcompact(struct cn_compaction_work *w)
     if (w->cw_prog_interval && w->cw_progress)
         tprog = jiffies;
 
-    err = merge_init(&bh, w->cw_inputv, w->cw_kvset_cnt, &w->cw_stats);
+    err = merge_init(&merge, w->cw_inputv, w->cw_kvset_cnt, &w->cw_stats);
     if (ev(err))
         return err;
 
-    more = get_next_item(bh, w->cw_inputv, &curr, &w->cw_stats, &err);
+    more = get_next_item(&merge, &curr, &err);
     if (!more || ev(err))
         goto done;
 
@@ -204,6 +262,9 @@ new_key:
     emitted_seq = 0;
     emitted_seq_pt = 0;
 
+    if (w->cw_rtombc)
+        rt_seq = rtomb_seqno(w->cw_rtombv, w->cw_rtombc, &curr.kobj, w->cw_horizon);
+
     dbg_prev_seq = 0;
     dbg_prev_src = 0;
     dbg_nvals_this_key = 0;
@@ -236,6 +297,9 @@ get_values:
             if (pt_set && seq < pt_seq)
                 continue; /* skip value */
 
+            if (seq < rt_seq && vtype != vtype_ptomb)
+                continue; /* hidden by a range tombstone */
+
             if (vtype == vtype_ptomb) {
                 pt_set = true;
                 pt_kobj = curr.kobj;
@@ -259,6 +323,11 @@ get_values:
          * value from the first kvset is emitted.
          */
         if (should_emit) {
+            if (curr.vctx.expire) {
+                err = kvset_builder_add_expire(w->cw_child[0], curr.vctx.expire);
+                if (ev(err))
+                    goto done;
+            }
 
             switch (vtype) {
                 case vtype_val:
@@ -267,6 +336,11 @@ get_values:
                         w->cw_child[0], seq, vbidx + w->cw_vbmap.vbm_map[curr.src],
                         vboff, vlen, complen);
                     break;
+                case vtype_bval:
+                    err = kvset_builder_add_bref(
+                        w->cw_child[0], seq, vbidx + w->cw_vbmap.vbm_map[curr.src],
+                        vboff, vlen, curr.vctx.boff);
+                    break;
                 case vtype_zval:
                 case vtype_ival:
                     err = kvset_builder_add_val(w->cw_child[0], seq, vdata, vlen, 0);
@@ -318,7 +392,7 @@ get_values:
     dbg_nvals_this_key = 0;
     dbg_prev_src = curr.src;
 
-    more = get_next_item(bh, w->cw_inputv, &curr, &w->cw_stats, &err);
+    more = get_next_item(&merge, &curr, &err);
     if (ev(err))
         goto done;
 
@@ -344,8 +418,12 @@ get_values:
         goto new_key;
 
 done:
-    w->cw_vbmap.vbm_waste = w->cw_vbmap.vbm_tot - w->cw_vbmap.vbm_used;
-    bin_heap_destroy(bh);
+    /* Block values count their uncompressed length as used, which can
+     * exceed the space they occupy.
+     */
+    w->cw_vbmap.vbm_waste = w->cw_vbmap.vbm_tot > w->cw_vbmap.vbm_used ?
+        w->cw_vbmap.vbm_tot - w->cw_vbmap.vbm_used : 0;
+    merge_fini(&merge);
 
     if (seqno_errcnt)
         log_warn("seqno errcnt %u", seqno_errcnt);
@@ -361,6 +439,7 @@ cn_kcompact(struct cn_compaction_work *w)
 {
     merr_t               err;
     struct cn_tree_node *pnode;
+    uint                 i;
 
     err = kvset_builder_create(
         &w->cw_child[0],
@@ -381,11 +460,21 @@ cn_kcompact(struct cn_compaction_work *w)
     }
 
     kvset_builder_set_merge_stats(w->cw_child[0], &w->cw_stats);
+    kvset_builder_set_iogov(w->cw_child[0], w->cw_iogov, w->cw_iocls);
 
     err = kcompact(w);
     if (ev(err))
         goto done;
 
+    for (i = 0; i < w->cw_rtombc; i++) {
+        if (w->cw_drop_tombv[0] && w->cw_rtombv[i].rt_seqno <= w->cw_horizon)
+            continue;
+
+        err = kvset_builder_add_rtomb(w->cw_child[0], w->cw_rtombv + i);
+        if (ev(err))
+            goto done;
+    }
+
     /* get resulting mblocks */
     err = kvset_builder_get_mblocks(w->cw_child[0], w->cw_outv);
     if (ev(err))
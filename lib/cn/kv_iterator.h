@@ -35,6 +35,9 @@ struct kvset_iter_vctx {
     size_t      off;
     uint        nvals;
     uint        next;
+    uint        boff;   /* vtype_bval offset within its block */
+    u64         expire; /* expiration time of the current value, if any */
+    u64         now;    /* time at which values expire, zero for wall clock */
     bool        is_ptomb;
 };
 
@@ -20,6 +20,7 @@ struct kvs_mblk_desc {
     enum hse_mclass          mclass;   /* media class */
     struct mpool *           ds;       /* mpool dataset */
     u64                      mb_id;    /* mblock id */
+    u8                       bcache;   /* read via mpool page cache (see cn_bcache) */
 };
 
 #endif
@@ -19,7 +19,6 @@
 #include <hse_util/mman.h>
 #include <hse_util/delay.h>
 #include <hse_util/keycmp.h>
-#include <hse_util/compression_lz4.h>
 #include <hse_util/vlb.h>
 
 #include <hse/limits.h>
@@ -212,6 +211,77 @@ kvset_put_ref(struct kvset *ks)
     cn_work_submit(cn, kvset_put_ref_work, &ks->ks_kvset_cn_work);
 }
 
+struct kvset_rtomb_load {
+    struct rtomb *rtv;
+    uint          rtc;
+    size_t        sz;
+    u8 *          kbuf;
+};
+
+static merr_t
+kvset_rtomb_load_cb(void *arg, const struct rtomb *rt)
+{
+    struct kvset_rtomb_load *ld = arg;
+    struct rtomb *           dst;
+
+    if (!ld->rtv) {
+        ld->sz += sizeof(*dst) + rt->rt_slen + rt->rt_elen;
+        ld->rtc++;
+        return 0;
+    }
+
+    dst = ld->rtv + ld->rtc++;
+    *dst = *rt;
+    dst->rt_start = memcpy(ld->kbuf, rt->rt_start, rt->rt_slen);
+    ld->kbuf += rt->rt_slen;
+    dst->rt_end = memcpy(ld->kbuf, rt->rt_end, rt->rt_elen);
+    ld->kbuf += rt->rt_elen;
+
+    return 0;
+}
+
+/* Copy the range tombstones out of the kvset's last kblock so that they
+ * remain accessible after its header page has been released.
+ */
+static merr_t
+kvset_rtombs_load(struct kvset *ks, struct kvset_kblk *kblk)
+{
+    struct kvset_rtomb_load ld = { 0 };
+    merr_t                  err;
+
+    err = kbr_read_rtombs(&kblk->kb_kblk_desc, kvset_rtomb_load_cb, &ld);
+    if (ev(err) || !ld.rtc)
+        return err;
+
+    ld.rtv = malloc(ld.sz);
+    if (ev(!ld.rtv))
+        return merr(ENOMEM);
+
+    ld.kbuf = (u8 *)(ld.rtv + ld.rtc);
+    ld.rtc = 0;
+
+    err = kbr_read_rtombs(&kblk->kb_kblk_desc, kvset_rtomb_load_cb, &ld);
+    if (ev(err)) {
+        free(ld.rtv);
+        return err;
+    }
+
+    rtomb_sort(ld.rtv, ld.rtc);
+
+    ks->ks_rtombv = ld.rtv;
+    ks->ks_rtombc = ld.rtc;
+
+    return 0;
+}
+
+uint
+kvset_get_rtombs(const struct kvset *ks, const struct rtomb **rtv)
+{
+    *rtv = ks->ks_rtombv;
+
+    return ks->ks_rtombc;
+}
+
 static merr_t
 kvset_kblk_init(
     struct kvs_rparams *     rp,
@@ -219,6 +289,7 @@ kvset_kblk_init(
     struct mblock_props     *props,
     struct mpool_mcache_map *kmap,
     u32                      idx,
+    u8                       bcache,
     struct kvset_kblk *      p,
     u8 **                    hlog)
 {
@@ -232,6 +303,9 @@ kvset_kblk_init(
     if (ev(err))
         return err;
 
+    if (kbd->mclass != HSE_MCLASS_PMEM)
+        kbd->bcache = bcache;
+
     err = kbr_read_wbt_region_desc(kbd, &p->kb_wbt_desc);
     if (ev(err))
         return err;
@@ -240,9 +314,14 @@ kvset_kblk_init(
     if (ev(err))
         return err;
 
-    err = kbr_read_blm_pages(kbd, p->kb_cn_bloom_lookup, &p->kb_blm_desc, &p->kb_blm_pages);
-    if (ev(err))
-        return err;
+    /* Bloom lookups via the page cache go through bloom_reader_mcache_lookup(),
+     * which requires that kb_blm_pages not point into the mcache map.
+     */
+    if (!(kbd->bcache && p->kb_cn_bloom_lookup == BLOOM_LOOKUP_MCACHE)) {
+        err = kbr_read_blm_pages(kbd, p->kb_cn_bloom_lookup, &p->kb_blm_desc, &p->kb_blm_pages);
+        if (ev(err))
+            return err;
+    }
 
     err = kbr_read_pt_region_desc(kbd, &p->kb_pt_desc);
     if (ev(err))
@@ -287,6 +366,12 @@ kvset_kblk_init(
     key_disc_init(p->kb_koff_max, p->kb_klen_max, &p->kb_kdisc_max);
     key_disc_init(p->kb_koff_min, p->kb_klen_min, &p->kb_kdisc_min);
 
+    /* Preloading into the page cache would defeat the purpose of the
+     * mpool page cache, which manages its own residency.
+     */
+    if (kbd->bcache)
+        return 0;
+
     /* Preload the wbtree nodes.
      */
     if (rp->cn_mcache_wbt > 0) {
@@ -409,6 +494,12 @@ vblock_udata_update(
         rock);
 }
 
+static void
+vblock_udata_fini(struct mbset *mbs, uint bnum, void *rock)
+{
+    vbr_desc_destroy(rock);
+}
+
 merr_t
 kvset_create2(
     struct cn_tree *   tree,
@@ -517,6 +608,7 @@ kvset_create2(
     ks->ks_vminlvl = min_t(u16, rp->cn_mcache_vminlvl, U16_MAX);
     ks->ks_vmin = rp->cn_mcache_vmin;
     ks->ks_vmax = rp->cn_mcache_vmax;
+    ks->ks_bcache = mpool_bcache_enabled(ds) ? rp->cn_bcache : 0;
     ks->ks_cn_kvdb = cn_kvdb;
 
     /* initialize atomics */
@@ -559,7 +651,7 @@ kvset_create2(
         kblk->kb_kblk.bk_blkid = mbid;
 
         err = kvset_kblk_init(rp, ds, &props, ks->ks_kmapv[i / mblock_max], i % mblock_max,
-                              kblk, &hlog);
+                              ks->ks_bcache, kblk, &hlog);
         if (ev(err))
             goto err_exit;
 
@@ -578,6 +670,10 @@ kvset_create2(
         ks->ks_st.kst_keys += kblk->kb_metrics.num_keys;
     }
 
+    err = kvset_rtombs_load(ks, ks->ks_kblks + last_kb);
+    if (ev(err))
+        goto err_exit;
+
     /* Cache the large min/max keys from all the kblocks into a packed
      * buffer to avoid having to reference their mcache mapped header
      * to find them.  The malloc here might be very large and hence
@@ -734,7 +830,9 @@ kvset_create2(
     atomic_add(&cn_kvdb->cnd_kblk_cnt, ks->ks_st.kst_kblks);
     atomic_add(&cn_kvdb->cnd_vblk_cnt, ks->ks_st.kst_vblks);
 
-    if (cn_tree_is_replay(tree))
+    /* Skip mcache readahead if gets are served from the mpool page cache.
+     */
+    if (cn_tree_is_replay(tree) || ks->ks_bcache)
         goto done;
 
     hse_meminfo(NULL, &mavail, 30);
@@ -824,7 +922,8 @@ kvset_create(struct cn_tree *tree, u64 tag, struct kvset_meta *km, struct kvset
             flags |= MBSET_FLAGS_CAPPED;
 
         err = mbset_create(cn_tree_get_ds(tree), n_vblks, idv, sizeof(struct vblock_desc),
-                           vblock_udata_init, flags, cn_vma_mblock_max(tree->cn), &vbset);
+                           vblock_udata_init, vblock_udata_fini, flags,
+                           cn_vma_mblock_max(tree->cn), &vbset);
         if (idv != bufv)
             free(idv);
         if (ev(err))
@@ -1008,6 +1107,7 @@ _kvset_destroy(struct kvset *ks)
         cndb_txn_ack_d(ks->ks_cndb, ks->ks_delete_txid, ks->ks_tag, ks->ks_cnid);
 
     free((void *)ks->ks_klarge);
+    free(ks->ks_rtombv);
 
     if (ks->ks_kvset_sz > kvset_cache[0].sz)
         free_aligned(ks);
@@ -1327,6 +1427,21 @@ done:
         }
     }
 
+    /* A range tombstone hides all older versions of the keys it covers.
+     */
+    if (ks->ks_rtombc) {
+        struct key_obj ko;
+        u64            rt_seq;
+
+        key2kobj(&ko, kt->kt_data, kt->kt_len);
+
+        rt_seq = rtomb_seqno(ks->ks_rtombv, ks->ks_rtombc, &ko, seq);
+        if (rt_seq && (*result == NOT_FOUND || vref->vr_seq < rt_seq)) {
+            *result = FOUND_TMB;
+            vref->vr_seq = rt_seq;
+        }
+    }
+
     return 0;
 }
 
@@ -1461,7 +1576,7 @@ kvset_lookup_val_direct_decompress(
     } else {
         src = iov.iov_base + (vboff & ~PAGE_MASK);
 
-        err = compress_lz4_ops.cop_decompress(src, omlen, vbuf, copylen, outlenp);
+        err = vbr_decompress(vbd, src, omlen, vbuf, copylen, outlenp);
     }
 
     if (freeme)
@@ -1470,6 +1585,87 @@ kvset_lookup_val_direct_decompress(
     return ev(err);
 }
 
+/* Copy %len bytes at offset %vboff of the given vblock out of the mpool
+ * page cache.
+ */
+static merr_t
+kvset_lookup_val_bcache(
+    struct kvset *      ks,
+    struct vblock_desc *vbd,
+    u16                 vbidx,
+    u32                 vboff,
+    void *              dst,
+    uint                len)
+{
+    size_t off;
+    u64    mbid;
+
+    mbid = lvx2mbid(ks, vbidx);
+    off = vbd->vbd_off + vboff;
+
+    while (len > 0) {
+        struct mpool_bcache_page *bp;
+        size_t                    pgoff, n;
+        void *                    addr;
+        merr_t                    err;
+
+        err = mpool_bcache_get(ks->ks_ds, mbid, off / PAGE_SIZE, false, &bp, &addr);
+        if (ev(err))
+            return err;
+
+        pgoff = off & ~PAGE_MASK;
+        n = min_t(size_t, len, PAGE_SIZE - pgoff);
+
+        memcpy(dst, addr + pgoff, n);
+        mpool_bcache_put(bp);
+
+        dst += n;
+        off += n;
+        len -= n;
+    }
+
+    return 0;
+}
+
+static merr_t
+kvset_lookup_val_bcache_decompress(
+    struct kvset *      ks,
+    struct vblock_desc *vbd,
+    u16                 vbidx,
+    u32                 vboff,
+    void *              vbuf,
+    uint                copylen,
+    uint                omlen,
+    uint *              outlenp)
+{
+    bool   freeme = false;
+    void * src = tls_vbuf;
+    merr_t err;
+
+    if (omlen > tls_vbufsz) {
+        src = vlb_alloc(omlen);
+        if (!src)
+            return merr(ENOMEM);
+
+        freeme = true;
+    }
+
+    err = kvset_lookup_val_bcache(ks, vbd, vbidx, vboff, src, omlen);
+    if (!ev(err))
+        err = vbr_decompress(vbd, src, omlen, vbuf, copylen, outlenp);
+
+    if (freeme)
+        vlb_free(src, omlen);
+
+    return ev(err);
+}
+
+static void
+kvset_vpin_release(void *arg)
+{
+    kvset_put_ref(arg);
+}
+
 static
 merr_t
 kvset_lookup_val(struct kvset *ks, struct kvs_vtuple_ref *vref, struct kvs_buf *vbuf)
@@ -1478,12 +1674,13 @@ kvset_lookup_val(struct kvset *ks, struct kvs_vtuple_ref *vref, struct kvs_buf *
     merr_t              err;
     void               *src, *dst;
     uint                omlen, copylen;
-    bool direct;
+    bool direct, bcache;
 
     assert(vref->vr_type == vtype_ival
         || vref->vr_type == vtype_zval
         || vref->vr_type == vtype_val
-        || vref->vr_type == vtype_cval);
+        || vref->vr_type == vtype_cval
+        || vref->vr_type == vtype_bval);
 
     if (HSE_UNLIKELY(vref->vr_type == vtype_zval)) {
         vbuf->b_len = 0;
@@ -1496,10 +1693,42 @@ kvset_lookup_val(struct kvset *ks, struct kvs_vtuple_ref *vref, struct kvs_buf *
     vbd = lvx2vbd(ks, vref->vb.vr_index);
     assert(vbd);
 
+    /* Values packed into compressed blocks are always copied out, the
+     * decompressed block lives in a per-thread cache.
+     */
+    if (vref->vr_type == vtype_bval) {
+        const void *vdata;
+
+        err = vbr_cblk_value(vbd, vref->vb.vr_off, NULL, vref->vb.vr_boff, vref->vb.vr_len, &vdata);
+        if (ev(err))
+            return err;
+
+        copylen = min(vref->vb.vr_len, vbuf->b_buf_sz);
+        if (copylen)
+            memcpy(vbuf->b_buf, vdata, copylen);
+
+        vbuf->b_len = vref->vb.vr_len;
+        return 0;
+    }
+
     /* on-media len, ptr to on-media data */
     omlen = vref->vb.vr_complen ? vref->vb.vr_complen : vref->vb.vr_len;
     src = vbr_value(vbd, vref->vb.vr_off, omlen);
 
+    /* Uncompressed values can be handed out directly from the vblock
+     * mapping, which remains valid for as long as we hold a ref on
+     * the kvset.
+     */
+    if (vbuf->b_pin && !vref->vb.vr_complen) {
+        kvset_get_ref(ks);
+
+        vbuf->b_pin->vp_data = src;
+        vbuf->b_pin->vp_release = kvset_vpin_release;
+        vbuf->b_pin->vp_arg = ks;
+        vbuf->b_len = vref->vb.vr_len;
+        return 0;
+    }
+
     /* output buffer and how much to copy out */
     dst = vbuf->b_buf;
     copylen = min(vref->vb.vr_len, vbuf->b_buf_sz);
@@ -1508,6 +1737,8 @@ kvset_lookup_val(struct kvset *ks, struct kvs_vtuple_ref *vref, struct kvs_buf *
               (copylen >= ks->ks_vmin && ks->ks_node_level >= ks->ks_vminlvl)) &&
              (vbd->vbd_mblkdesc.mclass != HSE_MCLASS_PMEM);
 
+    bcache = !direct && ks->ks_bcache && vbd->vbd_mblkdesc.mclass != HSE_MCLASS_PMEM;
+
     if (!copylen)
         goto done;
 
@@ -1519,9 +1750,12 @@ kvset_lookup_val(struct kvset *ks, struct kvs_vtuple_ref *vref, struct kvs_buf *
         if (direct)
             err = kvset_lookup_val_direct_decompress(
                 ks, vbd, vref->vb.vr_index, vref->vb.vr_off, dst, copylen, omlen, &outlen);
+        else if (bcache)
+            err = kvset_lookup_val_bcache_decompress(
+                ks, vbd, vref->vb.vr_index, vref->vb.vr_off, dst, copylen, omlen, &outlen);
 
-        if (!direct || err) {
-            err = compress_lz4_ops.cop_decompress(src, omlen, dst, copylen, &outlen);
+        if ((!direct && !bcache) || err) {
+            err = vbr_decompress(vbd, src, omlen, dst, copylen, &outlen);
             if (ev(err))
                 return err;
         }
@@ -1539,6 +1773,13 @@ kvset_lookup_val(struct kvset *ks, struct kvs_vtuple_ref *vref, struct kvs_buf *
             if (!ev(err))
                 goto done;
 
+            err = 0; /* fall through to memcpy */
+        } else if (bcache) {
+            err = kvset_lookup_val_bcache(
+                ks, vbd, vref->vb.vr_index, vref->vb.vr_off, dst, copylen);
+            if (!ev(err))
+                goto done;
+
             err = 0; /* fall through to memcpy */
         }
 
@@ -1619,7 +1860,10 @@ next_kblk:
         bool      hit = true;
 
         if (HSE_LIKELY(lookup == BLOOM_LOOKUP_MCACHE)) {
-            hit = bloom_reader_buffer_lookup(&kblk->kb_blm_desc, kblk->kb_blm_pages, kt);
+            if (kblk->kb_blm_pages)
+                hit = bloom_reader_buffer_lookup(&kblk->kb_blm_desc, kblk->kb_blm_pages, kt);
+            else if (ev(bloom_reader_mcache_lookup(&kblk->kb_blm_desc, &kblk->kb_kblk_desc, kt, &hit)))
+                hit = true;
         } else if (lookup == BLOOM_LOOKUP_BUFFER) {
             hit = bloom_reader_buffer_lookup(&kblk->kb_blm_desc, kblk->kb_blm_pages, kt);
         }
@@ -1768,6 +2012,103 @@ kvset_lookup(
     return kvset_lookup_val(ks, &vref, vbuf);
 }
 
+void
+kvset_bloom_probe_multi(
+    struct kvset *          ks,
+    struct kvs_ktuple **    ktv,
+    const struct key_disc **kdiscv,
+    uint                    cnt,
+    bool *                  hitv)
+{
+    struct kvset_kblk *kblkv[KVSET_BLOOM_PROBE_MAX];
+    bool               ptombs;
+    int                last;
+    uint               i;
+
+    assert(cnt <= KVSET_BLOOM_PROBE_MAX);
+
+    last = ks->ks_st.kst_kblks - 1;
+    ptombs = ks->ks_pfx_len > 0 && ks->ks_kblks[last].kb_pt_desc.wbd_n_pages > 0;
+
+    if (last && ks->ks_kblks[last].kb_wbt_desc.wbd_n_pages == 0)
+        --last; /* last kblk contains only ptombs */
+
+    /* Pass 1: Find the kblock in which each key might reside and prefetch
+     * the bloom bucket it hashes to, so that the buckets for the whole
+     * batch are in flight at the same time.
+     */
+    for (i = 0; i < cnt; ++i) {
+        struct kvs_ktuple *kt = ktv[i];
+        struct kvset_kblk *kblk;
+        int                first, hi, mid, rc;
+
+        kblkv[i] = NULL;
+        hitv[i] = true;
+
+        /* A key covered by a ptomb must be resolved by kvset_lookup().
+         */
+        if (ptombs && kt->kt_len >= ks->ks_pfx_len)
+            continue;
+
+        /* Ditto for a key covered by a range tombstone.
+         */
+        if (ks->ks_rtombc) {
+            struct key_obj ko;
+
+            key2kobj(&ko, kt->kt_data, kt->kt_len);
+
+            if (rtomb_seqno(ks->ks_rtombv, ks->ks_rtombc, &ko, U64_MAX))
+                continue;
+        }
+
+        if (key_disc_cmp(kdiscv[i], &ks->ks_kdisc_max) > 0 ||
+            key_disc_cmp(kdiscv[i], &ks->ks_kdisc_min) < 0) {
+            hitv[i] = false;
+            continue;
+        }
+
+        first = 0;
+        hi = last;
+        kblk = NULL;
+
+        while (first <= hi) {
+            mid = (first + hi) / 2;
+
+            rc = kblk_plausible(ks->ks_kblks + mid, kdiscv[i], kt->kt_data, kt->kt_len, 0);
+            if (rc < 0) {
+                hi = mid - 1;
+            } else if (rc > 0) {
+                first = mid + 1;
+            } else {
+                kblk = ks->ks_kblks + mid;
+                break;
+            }
+        }
+
+        if (!kblk) {
+            hitv[i] = false;
+            continue;
+        }
+
+        /* Only buffered blooms are probed here, mcache and bcache
+         * based blooms are left to kvset_lookup().
+         */
+        if (kblk->kb_blm_pages) {
+            bloom_reader_buffer_prefetch(&kblk->kb_blm_desc, kblk->kb_blm_pages, kt);
+            kblkv[i] = kblk;
+        }
+    }
+
+    /* Pass 2: Probe the (hopefully now cached) buckets.
+     */
+    for (i = 0; i < cnt; ++i) {
+        struct kvset_kblk *kblk = kblkv[i];
+
+        if (kblk)
+            hitv[i] = bloom_reader_buffer_lookup(&kblk->kb_blm_desc, kblk->kb_blm_pages, ktv[i]);
+    }
+}
+
 u64
 kvset_get_dgen(struct kvset *ks)
 {
@@ -1922,6 +2263,26 @@ kvset_get_nth_vblock_len(struct kvset *ks, u32 index)
     return vbd ? vbd->vbd_len : 0;
 }
 
+bool
+kvset_get_vcomp_dict(struct kvset *ks, const void **dict, uint *dictlen)
+{
+    uint i;
+
+    /* Vblocks are ordered oldest to newest.
+     */
+    for (i = ks->ks_st.kst_vblks; i-- > 0;) {
+        struct vblock_desc *vbd = lvx2vbd(ks, i);
+
+        if (vbd && vbd->vbd_calgo == VBLOCK_CALGO_ZSTD && vbd->vbd_dictlen > 0) {
+            *dict = vbd->vbd_dict;
+            *dictlen = vbd->vbd_dictlen;
+            return true;
+        }
+    }
+
+    return false;
+}
+
 struct mbset **
 kvset_get_vbsetv(struct kvset *ks, uint *vbsetc)
 {
@@ -1961,6 +2322,86 @@ kvset_get_max_key(struct kvset *ks, void **key, uint *klen)
     *klen = kb->kb_klen_max;
 }
 
+/**
+ * kvset_get_nth_kblock_min_key() - Get the smallest key in a kblock
+ * @ks:    struct kvset handle.
+ * @index: kblock index
+ * @key:   (output) smallest key. Null if the kblock contains only ptombs.
+ * @klen:  (output) length of @key. Zero if the kblock contains only ptombs.
+ */
+void
+kvset_get_nth_kblock_min_key(struct kvset *ks, u32 index, const void **key, uint *klen)
+{
+    struct kvset_kblk *kb;
+
+    *key = 0;
+    *klen = 0;
+
+    if (index >= ks->ks_st.kst_kblks)
+        return;
+
+    kb = &ks->ks_kblks[index];
+    if (kb->kb_wbt_desc.wbd_n_pages == 0)
+        return;
+
+    *key = kb->kb_koff_min;
+    *klen = kb->kb_klen_min;
+}
+
+uint
+kvset_sample_keys(
+    struct kvset *       ks,
+    const void *         pfx,
+    uint                 pfx_len,
+    uint                 samplec,
+    struct kvset_sample *samplev)
+{
+    uint n = 0;
+    u32  i;
+
+    if (!ks->ks_st.kst_keys)
+        return 0;
+
+    for (i = 0; i < ks->ks_st.kst_kblks && n < samplec; i++) {
+        struct kvset_kblk *kb = &ks->ks_kblks[i];
+        const uint         keys = kb->kb_metrics.num_keys;
+        uint               first, last, leafc, quota, j;
+
+        if (kb->kb_wbt_desc.wbd_n_pages == 0 || keys == 0)
+            continue;
+
+        /* Skip kblocks whose keys all sort before or after the prefix. */
+        if (pfx_len > 0) {
+            if (keycmp(kb->kb_koff_max, min_t(uint, kb->kb_klen_max, pfx_len), pfx, pfx_len) < 0)
+                continue;
+            if (keycmp(kb->kb_koff_min, min_t(uint, kb->kb_klen_min, pfx_len), pfx, pfx_len) > 0)
+                continue;
+        }
+
+        wbtr_leaf_range(&kb->kb_kblk_desc, &kb->kb_wbt_desc, pfx, pfx_len, &first, &last);
+        leafc = last - first + 1;
+
+        quota = ((u64)samplec * keys) / ks->ks_st.kst_keys;
+        quota = clamp_t(uint, quota, 1, samplec - n);
+        quota = min_t(uint, quota, leafc);
+
+        for (j = 0; j < quota; j++) {
+            struct kvset_sample *s = samplev + n + j;
+            uint                 leaf = first + ((u64)j * leafc) / quota;
+
+            wbtr_leaf_min_key(&kb->kb_kblk_desc, &kb->kb_wbt_desc, leaf, &s->ksa_kobj);
+
+            /* Assume keys are spread evenly over the kblock's leaf nodes. */
+            s->ksa_weight = ((u64)keys * leafc) / ((u64)kb->kb_wbt_desc.wbd_leaf_cnt * quota);
+            s->ksa_weight = max_t(u64, s->ksa_weight, 1);
+        }
+
+        n += quota;
+    }
+
+    return n;
+}
+
 void
 kvset_get_metrics(struct kvset *ks, struct kvset_metrics *m)
 {
@@ -2003,12 +2444,18 @@ kvset_list_add_tail(struct kvset *ks, struct list_head *head)
 
 struct kv_iterator_ops kvset_iter_ops;
 
-/* async_mbio: for asynchronous mblock i/o */
+/* async_mbio: for asynchronous mblock i/o
+ *
+ * If @aio is set then reads are issued via the mpool async io context
+ * and completed by polling it from mbio_wait(), otherwise they are
+ * issued synchronously from a cn_io_wq worker which signals @cv.
+ */
 struct async_mbio {
-    struct cv    cv;
-    struct mutex mutex;
-    int          pending;
-    int          status;
+    struct cv             cv;
+    struct mutex          mutex;
+    struct mpool_aio_ctx *aio;
+    int                   pending;
+    int                   status;
 };
 
 struct kr_buf {
@@ -2035,6 +2482,16 @@ struct kblk_reader {
     bool kr_requested;
     bool kr_eof;
 
+    /* in-progress io state */
+    struct iovec kr_iov;
+    struct {
+        size_t kr_kmd_a;
+        size_t kr_rlen;
+        uint   kr_node_read_cnt;
+        u32    kr_start_node_kmd_off;
+        bool   kr_last_node;
+    } io;
+
     /* io results */
     struct {
         uint  kr_nodec;
@@ -2078,6 +2535,7 @@ struct vblk_reader {
     u64  vr_mbid;
     uint vr_mblk_dstart;
     uint vr_mblk_dlen;
+    struct iovec vr_iov;
     /* buffer */
     struct vr_buf vr_buf[2];
     uint          vr_buf_sz;
@@ -2119,11 +2577,15 @@ struct kvset_iterator {
     struct wbti *            pti;
     struct perfc_set *       pc;
     struct cn_merge_stats *  stats;
+    struct cn_iogov *        iogov;
+    enum cn_iogov_class      iocls;
+    u64                      now;
     uint                     curr_kblk;
     enum last_src            last;
     u32                      vra_flags;
     u32                      vra_len;
     struct workqueue_struct *vra_wq;
+    struct mpool_aio_ctx *   aio;
     bool                     reverse;
     bool                     asyncio;
     struct iter_meta         wbti_meta;
@@ -2151,10 +2613,11 @@ struct kvset_iterator {
 #define handle_to_kvset_iter(_handle) container_of(_handle, struct kvset_iterator, handle)
 
 static void
-mbio_init(struct async_mbio *io)
+mbio_init(struct async_mbio *io, struct mpool_aio_ctx *aio)
 {
     mutex_init(&io->mutex);
     cv_init(&io->cv, "kvset_mbio");
+    io->aio = aio;
     io->status = 0;
     io->pending = 0;
 }
@@ -2185,6 +2648,22 @@ mbio_wait(struct async_mbio *io, struct cn_merge_stats_ops *stats)
     merr_t err;
     u64    tstart = 0;
 
+    if (io->aio) {
+        /* Completions are delivered only by polling, and the callbacks
+         * take io->mutex, so poll without holding it.
+         */
+        if (stats && io->pending)
+            tstart = get_time_ns();
+        while (io->pending) {
+            err = mpool_aio_poll(io->aio, 1);
+            if (ev(err))
+                return err;
+        }
+        if (tstart)
+            count_ops(stats, 1, 0, get_time_ns() - tstart);
+        return io->status;
+    }
+
     mutex_lock(&io->mutex);
     if (stats && io->pending)
         tstart = get_time_ns();
@@ -2197,66 +2676,69 @@ mbio_wait(struct async_mbio *io, struct cn_merge_stats_ops *stats)
     return err;
 }
 
+/* Prepare to read the next batch of wbt leaf nodes from the current kblock.
+ */
 static void
-kvset_iter_kblock_read(struct work_struct *rock)
+kblk_read_nodes_prep(struct kblk_reader *kr, struct iovec *iov, size_t *offp)
 {
-    struct kblk_reader *     kr = container_of(rock, struct kblk_reader, work);
-    struct wbt_node_hdr_omf *hdr;
-
-    struct iovec   iov;
-    merr_t         err = 0;
+    struct kr_buf *buf = &kr->kr_buf[kr->kr_bufx];
     uint           node_read_cnt;
-    size_t         a, b, kblk_off, rlen;
-    u32            end_node_kmd_off;
-    u32            start_node_kmd_off;
-    bool           last_node;
-    struct kr_buf *buf;
 
     assert(kr->kr_nodex < kr->kr_nodec);
 
-    buf = &kr->kr_buf[kr->kr_bufx];
-
     /* Read leaf nodes from mblock.  Need buffer space for at
      * least two nodes as explained below.
      */
     assert(buf->node_buf_sz > 2 * PAGE_SIZE);
     node_read_cnt = kr->kr_nodec - kr->kr_nodex;
     if (node_read_cnt * PAGE_SIZE > buf->node_buf_sz) {
-        last_node = false;
+        kr->io.kr_last_node = false;
         node_read_cnt = buf->node_buf_sz / PAGE_SIZE;
     } else {
-        last_node = true;
+        kr->io.kr_last_node = true;
     }
 
-    iov.iov_base = buf->node_buf;
-    iov.iov_len = node_read_cnt * PAGE_SIZE;
-    kblk_off = (kr->kr_node_start_pg + kr->kr_nodex) * PAGE_SIZE;
+    kr->io.kr_node_read_cnt = node_read_cnt;
 
-    rlen = iov.iov_len;
-    err = mpool_mblock_read(kr->ds, kr->kr_mbid, &iov, 1, kblk_off);
-    if (ev(err))
-        goto done;
+    iov->iov_base = buf->node_buf;
+    iov->iov_len = node_read_cnt * PAGE_SIZE;
+    *offp = (kr->kr_node_start_pg + kr->kr_nodex) * PAGE_SIZE;
+
+    kr->io.kr_rlen = iov->iov_len;
+}
+
+/* Given the leaf nodes just read, prepare to read the kmd that corresponds
+ * to them (growing the kmd buffer if necessary).
+ */
+static merr_t
+kblk_read_kmd_prep(struct kblk_reader *kr, struct iovec *iov, size_t *offp)
+{
+    struct kr_buf *          buf = &kr->kr_buf[kr->kr_bufx];
+    struct wbt_node_hdr_omf *hdr;
+    u32                      end_node_kmd_off;
+    u32                      start_node_kmd_off;
+    size_t                   a, b;
 
     perfc_inc(kr->pc, PERFC_RA_CNCOMP_RREQS);
-    perfc_add(kr->pc, PERFC_RA_CNCOMP_RBYTES, iov.iov_len);
+    perfc_add(kr->pc, PERFC_RA_CNCOMP_RBYTES, kr->io.kr_rlen);
 
     /* figure out kmd range that corresponds to leaf nodes */
-    hdr = iov.iov_base;
+    hdr = buf->node_buf;
     assert(omf_wbn_magic(hdr) == WBT_LFE_NODE_MAGIC);
     start_node_kmd_off = omf_wbn_kmd(hdr);
 
-    if (last_node) {
+    if (kr->io.kr_last_node) {
         end_node_kmd_off = kr->kr_kmd_pgc * PAGE_SIZE;
     } else {
         /* get end of kmd range last node */
-        hdr = iov.iov_base + iov.iov_len - PAGE_SIZE;
+        hdr = buf->node_buf + (kr->io.kr_node_read_cnt - 1) * PAGE_SIZE;
         assert(omf_wbn_magic(hdr) == WBT_LFE_NODE_MAGIC);
         end_node_kmd_off = omf_wbn_kmd(hdr);
         /* Cannot read keys from last node b/c we don't have kmd
          * for them.  This is why we insist node buffer is at
          * least two pages.
          */
-        node_read_cnt--;
+        kr->io.kr_node_read_cnt--;
     }
 
     assert(end_node_kmd_off > start_node_kmd_off);
@@ -2266,55 +2748,147 @@ kvset_iter_kblock_read(struct work_struct *rock)
     assert(b - a == PAGE_ALIGN(b - a));
 
     /* kmd read parameters */
-    iov.iov_base = buf->kmd_buf;
-    iov.iov_len = b - a;
-    kblk_off = kr->kr_kmd_start_pg * PAGE_SIZE + a;
+    iov->iov_base = buf->kmd_buf;
+    iov->iov_len = b - a;
+    *offp = kr->kr_kmd_start_pg * PAGE_SIZE + a;
 
     /* is kmd buffer big enough ? */
-    if (iov.iov_len > buf->kmd_buf_sz) {
-        size_t sz = roundup(iov.iov_len + 1, VLB_ALLOCSZ_MAX);
+    if (iov->iov_len > buf->kmd_buf_sz) {
+        size_t sz = roundup(iov->iov_len + 1, VLB_ALLOCSZ_MAX);
 
-        iov.iov_base = vlb_alloc(sz);
-        if (ev(!iov.iov_base)) {
-            err = merr(ENOMEM);
-            goto done;
-        }
+        iov->iov_base = vlb_alloc(sz);
+        if (ev(!iov->iov_base))
+            return merr(ENOMEM);
 
         vlb_free(buf->kmd_buf, buf->kmd_used_sz);
 
-        buf->kmd_used_sz = (sz > VLB_ALLOCSZ_MAX) ? sz : iov.iov_len;
+        buf->kmd_used_sz = (sz > VLB_ALLOCSZ_MAX) ? sz : iov->iov_len;
         buf->kmd_buf_sz = sz;
-        buf->kmd_buf = iov.iov_base;
+        buf->kmd_buf = iov->iov_base;
 
-    } else if (iov.iov_len > buf->kmd_used_sz) {
-        buf->kmd_used_sz = iov.iov_len;
+    } else if (iov->iov_len > buf->kmd_used_sz) {
+        buf->kmd_used_sz = iov->iov_len;
     }
 
-    rlen += iov.iov_len;
-    err = mpool_mblock_read(kr->ds, kr->kr_mbid, &iov, 1, kblk_off);
-    if (ev(err))
-        goto done;
+    kr->io.kr_kmd_a = a;
+    kr->io.kr_start_node_kmd_off = start_node_kmd_off;
+    kr->io.kr_rlen += iov->iov_len;
+
+    return 0;
+}
+
+/* Both the nodes and their kmd have been read, stash the results in
+ * consumable form for the caller and setup for the next read.
+ */
+static void
+kblk_read_done(struct kblk_reader *kr, size_t kmd_len)
+{
+    struct kr_buf *buf = &kr->kr_buf[kr->kr_bufx];
 
     perfc_inc(kr->pc, PERFC_RA_CNCOMP_RREQS);
-    perfc_add(kr->pc, PERFC_RA_CNCOMP_RBYTES, iov.iov_len);
+    perfc_add(kr->pc, PERFC_RA_CNCOMP_RBYTES, kmd_len);
 
-    /* stash results in consumable form for caller */
     kr->iores.kr_ops = 2;
-    kr->iores.kr_bytes = rlen;
-    kr->iores.kr_nodec = node_read_cnt;
+    kr->iores.kr_bytes = kr->io.kr_rlen;
+    kr->iores.kr_nodec = kr->io.kr_node_read_cnt;
     kr->iores.kr_nodev = buf->node_buf;
-    kr->iores.kr_kmd_base = buf->kmd_buf + start_node_kmd_off - a;
-    kr->iores.kr_node_kmd_off_adj = start_node_kmd_off;
+    kr->iores.kr_kmd_base = buf->kmd_buf + kr->io.kr_start_node_kmd_off - kr->io.kr_kmd_a;
+    kr->iores.kr_node_kmd_off_adj = kr->io.kr_start_node_kmd_off;
 
-    /* setup for next read */
     kr->kr_nodex += kr->iores.kr_nodec;
     if (kr->asyncio)
         kr->kr_bufx = !kr->kr_bufx;
+}
+
+static void
+kvset_iter_kblock_read(struct work_struct *rock)
+{
+    struct kblk_reader *kr = container_of(rock, struct kblk_reader, work);
+    struct iovec        iov;
+    size_t              kblk_off;
+    merr_t              err;
+
+    kblk_read_nodes_prep(kr, &iov, &kblk_off);
+
+    err = mpool_mblock_read(kr->ds, kr->kr_mbid, &iov, 1, kblk_off);
+    if (ev(err))
+        goto done;
+
+    err = kblk_read_kmd_prep(kr, &iov, &kblk_off);
+    if (ev(err))
+        goto done;
+
+    err = mpool_mblock_read(kr->ds, kr->kr_mbid, &iov, 1, kblk_off);
+    if (ev(err))
+        goto done;
+
+    kblk_read_done(kr, iov.iov_len);
 
 done:
     mbio_signal(&kr->mbio, err);
 }
 
+static void
+kblk_aio_kmd_read_cb(void *arg, merr_t err, size_t len)
+{
+    struct kblk_reader *kr = arg;
+
+    if (!ev(err))
+        kblk_read_done(kr, kr->kr_iov.iov_len);
+
+    mbio_signal(&kr->mbio, err);
+}
+
+static void
+kblk_aio_nodes_read_cb(void *arg, merr_t err, size_t len)
+{
+    struct kblk_reader *kr = arg;
+    size_t              kblk_off;
+
+    if (ev(err))
+        goto done;
+
+    err = kblk_read_kmd_prep(kr, &kr->kr_iov, &kblk_off);
+    if (ev(err))
+        goto done;
+
+    err = mpool_mblock_read_async(
+        kr->ds, kr->mbio.aio, kr->kr_mbid, &kr->kr_iov, 1, kblk_off, kblk_aio_kmd_read_cb, kr);
+    if (!ev(err))
+        return;
+
+done:
+    mbio_signal(&kr->mbio, err);
+}
+
+static void
+kvset_iter_kblock_read_aio(struct kblk_reader *kr)
+{
+    size_t kblk_off;
+    merr_t err;
+
+    kblk_read_nodes_prep(kr, &kr->kr_iov, &kblk_off);
+
+    err = mpool_mblock_read_async(
+        kr->ds, kr->mbio.aio, kr->kr_mbid, &kr->kr_iov, 1, kblk_off, kblk_aio_nodes_read_cb, kr);
+    if (ev(err))
+        mbio_signal(&kr->mbio, err);
+}
+
+static void
+kvset_iter_aio_submit(struct kvset_iterator *iter)
+{
+    merr_t err;
+
+    /* A failed submit leaves the reads queued, they will be
+     * resubmitted by the next poll from mbio_wait().
+     */
+    if (iter->aio) {
+        err = mpool_aio_submit(iter->aio);
+        ev(err);
+    }
+}
+
 enum read_type { READ_WBT = true, READ_PT = false };
 
 static void
@@ -2356,6 +2930,11 @@ kblk_start_read(struct kvset_iterator *iter, struct kblk_reader *kr, enum read_t
     }
 
     mbio_arm(&kr->mbio);
+    if (kr->mbio.aio) {
+        kvset_iter_kblock_read_aio(kr);
+        return;
+    }
+
     INIT_WORK(&kr->work, kvset_iter_kblock_read);
     if (iter->asyncio) {
         success = queue_work(iter->workq, &kr->work);
@@ -2365,32 +2944,56 @@ kblk_start_read(struct kvset_iterator *iter, struct kblk_reader *kr, enum read_t
     }
 }
 
+static void
+vr_read_prep(struct vblk_reader *vr, struct iovec *iov, size_t *offp)
+{
+    int empty = !vr->vr_active;
+
+    iov->iov_base = vr->vr_buf[empty].data;
+    iov->iov_len = vr->vr_io_len;
+
+    /* adjust offset for start of vblock data region */
+    *offp = vr->vr_io_offset + vr->vr_mblk_dstart;
+}
+
+static void
+vr_read_done(struct vblk_reader *vr, size_t len)
+{
+    int empty = !vr->vr_active;
+
+    perfc_inc(vr->pc, PERFC_RA_CNCOMP_RREQS);
+    perfc_add(vr->pc, PERFC_RA_CNCOMP_RBYTES, len);
+
+    vr->vr_buf[empty].idx = vr->vr_io_vbidx;
+    vr->vr_buf[empty].off = vr->vr_io_offset;
+    vr->vr_buf[empty].len = vr->vr_io_len;
+}
+
 static void
 vr_read_work(struct work_struct *rock)
 {
     struct vblk_reader *vr = container_of(rock, struct vblk_reader, work);
     struct iovec        iov;
     merr_t              err;
-    int                 empty = !vr->vr_active;
     size_t              vblk_offset;
 
-    iov.iov_base = vr->vr_buf[empty].data;
-    iov.iov_len = vr->vr_io_len;
+    vr_read_prep(vr, &iov, &vblk_offset);
 
-    /* adjust offset for start of vblock data region */
-    vblk_offset = vr->vr_io_offset + vr->vr_mblk_dstart;
     err = mpool_mblock_read(vr->ds, vr->vr_mbid, &iov, 1, vblk_offset);
-    if (ev(err))
-        goto done;
+    if (!ev(err))
+        vr_read_done(vr, iov.iov_len);
 
-    perfc_inc(vr->pc, PERFC_RA_CNCOMP_RREQS);
-    perfc_add(vr->pc, PERFC_RA_CNCOMP_RBYTES, iov.iov_len);
+    mbio_signal(&vr->mbio, err);
+}
 
-    vr->vr_buf[empty].idx = vr->vr_io_vbidx;
-    vr->vr_buf[empty].off = vr->vr_io_offset;
-    vr->vr_buf[empty].len = vr->vr_io_len;
+static void
+vr_aio_read_cb(void *arg, merr_t err, size_t len)
+{
+    struct vblk_reader *vr = arg;
+
+    if (!ev(err))
+        vr_read_done(vr, vr->vr_iov.iov_len);
 
-done:
     mbio_signal(&vr->mbio, err);
 }
 
@@ -2423,6 +3026,20 @@ vr_start_read(
 
     vr->mbio.pending = 1;
 
+    if (vr->mbio.aio) {
+        size_t vblk_offset;
+        merr_t err;
+
+        vr_read_prep(vr, &vr->vr_iov, &vblk_offset);
+
+        err = mpool_mblock_read_async(
+            vr->ds, vr->mbio.aio, vr->vr_mbid, &vr->vr_iov, 1, vblk_offset, vr_aio_read_cb, vr);
+        if (ev(err))
+            mbio_signal(&vr->mbio, err);
+
+        return true;
+    }
+
     INIT_WORK(&vr->work, vr_read_work);
     if (vr->asyncio) {
         success = queue_work(workq, &vr->work);
@@ -2494,7 +3111,7 @@ kvset_iter_enable_mblock_read_cmn(struct kvset_iterator *iter, struct kblk_reade
     kr->ds = iter->ks->ks_ds;
     kr->pc = iter->pc;
 
-    mbio_init(&kr->mbio);
+    mbio_init(&kr->mbio, iter->aio);
 
     return 0;
 
@@ -2569,7 +3186,7 @@ kvset_iter_enable_mblock_read(struct kvset_iterator *iter)
         for (i = 0; i < iter->ks->ks_vgroups; i++) {
             vr = iter->vreaders + i;
 
-            mbio_init(&vr->mbio);
+            mbio_init(&vr->mbio, iter->aio);
 
             mem = vlb_alloc(vr_buf_sz * 2);
             if (ev(!mem))
@@ -2622,6 +3239,9 @@ kvset_iter_mblock_read_start(struct kvset_iterator *iter)
 
         vr->vr_requested = vr_start_read(vr, 0, 0, iter->workq, iter->ks);
     }
+
+    /* Issue all of the initial reads in one batch */
+    kvset_iter_aio_submit(iter);
 }
 
 merr_t
@@ -2668,6 +3288,8 @@ kvset_iter_create(
     }
 
     iter->vra_len = min_t(u32, iter->vra_len, 1024 * 1024);
+    if (flags & kvset_iter_flag_keys)
+        iter->vra_len = 0;
     iter->vra_wq = vra_wq;
 
     iter->workq = io_workq;
@@ -2677,6 +3299,18 @@ kvset_iter_create(
     if (mblock_read) {
         iter->asyncio = io_workq ? true : false;
 
+        /* Prefer issuing reads from this thread via an async io context
+         * over handing each one off to a cn_io_wq worker.  Fall back to
+         * the workqueue if there is no async io backend.
+         */
+        if (iter->asyncio && ks->ks_rp->cn_compact_aio_qdepth > 0) {
+            err = mpool_aio_ctx_create(ks->ks_rp->cn_compact_aio_qdepth, &iter->aio);
+            if (err) {
+                ev(merr_errno(err) != ENOTSUP);
+                iter->aio = NULL;
+            }
+        }
+
         err = kvset_iter_enable_mblock_read(iter);
         if (ev(err))
             goto err_exit1;
@@ -2696,6 +3330,7 @@ err_exit2:
     kvset_iter_free_buffers(iter, &iter->kreader);
 
 err_exit1:
+    mpool_aio_ctx_destroy(iter->aio);
     kmem_cache_free(kvset_iter_cache, iter);
     return err;
 }
@@ -2726,6 +3361,23 @@ kvset_iter_set_stats(struct kv_iterator *handle, struct cn_merge_stats *stats)
     iter->stats = stats;
 }
 
+void
+kvset_iter_set_iogov(struct kv_iterator *handle, struct cn_iogov *gov, enum cn_iogov_class cls)
+{
+    struct kvset_iterator *iter = handle_to_kvset_iter(handle);
+
+    iter->iogov = gov;
+    iter->iocls = cls;
+}
+
+void
+kvset_iter_set_now(struct kv_iterator *handle, u64 now)
+{
+    struct kvset_iterator *iter = handle_to_kvset_iter(handle);
+
+    iter->now = now;
+}
+
 merr_t
 kvset_iter_set_start(struct kv_iterator *handle, int start, int pt_start)
 {
@@ -3042,6 +3694,7 @@ fetch_wbti(struct kvset_iterator *iter, struct key_obj *kobj, struct kvset_iter_
     wbti_kobj_get(iter, kobj);
 
     vc->kmd = iter->wbti_meta.kmd;
+    vc->now = iter->now;
     vc->is_ptomb = false;
     iter->last = SRC_WBT;
 }
@@ -3066,6 +3719,7 @@ fetch_pti(struct kvset_iterator *iter, struct key_obj *kobj, struct kvset_iter_v
     pti_kobj_get(iter, kobj);
 
     vc->kmd = iter->pti_meta.kmd;
+    vc->now = iter->now;
     vc->is_ptomb = true;
     iter->last = SRC_PT;
 }
@@ -3165,6 +3819,7 @@ kvset_iter_next_key_read(
         if (iter->asyncio && !kr->kr_requested) {
             kr->kr_requested = true;
             kblk_start_read(iter, kr, read_type);
+            kvset_iter_aio_submit(iter);
         }
     } else {
         /* We are out of data.  If asyncio: start read (if not
@@ -3185,6 +3840,7 @@ kvset_iter_next_key_read(
         }
         if (ms)
             count_ops(&ms->ms_kblk_read, kr->iores.kr_ops, kr->iores.kr_bytes, 0);
+        cn_iogov_request(iter->iogov, iter->iocls, kr->iores.kr_bytes);
 
         /* new work buffer */
         wbt_reader->wb_node = kr->iores.kr_nodev;
@@ -3375,7 +4031,7 @@ kvset_iter_next_vref(
     if (vc->next >= vc->nvals)
         return false;
 
-    kmd_type_seq(vc->kmd, &vc->off, vtype, seq);
+    kmd_type_seq_expire(vc->kmd, &vc->off, vtype, seq, &vc->expire);
     switch (*vtype) {
         case vtype_val:
             kmd_val(vc->kmd, &vc->off, vbidx, vboff, vlen);
@@ -3383,6 +4039,9 @@ kvset_iter_next_vref(
         case vtype_cval:
             kmd_cval(vc->kmd, &vc->off, vbidx, vboff, vlen, complen);
             break;
+        case vtype_bval:
+            kmd_bval(vc->kmd, &vc->off, vbidx, vboff, vlen, &vc->boff);
+            break;
         case vtype_ival:
             kmd_ival(vc->kmd, &vc->off, vdata, vlen);
             break;
@@ -3395,6 +4054,18 @@ kvset_iter_next_vref(
             break;
     }
 
+    /* An expired value reads as a tombstone, which lets compaction
+     * reclaim it along with the older values it hides.  Compaction
+     * fixes the time once per job so that a slice merged twice sees
+     * the same values expire in both passes.
+     */
+    if (vc->now ? kvs_expired_at(vc->expire, vc->now) : kvs_expired(vc->expire)) {
+        *vtype = vtype_tomb;
+        *vlen = 0;
+        *complen = 0;
+        vc->expire = 0;
+    }
+
     vc->next++;
     return true;
 }
@@ -3443,6 +4114,7 @@ kvset_iter_get_valptr_read(
 
         if (ms)
             count_ops(&ms->ms_vblk_read1, 1, active->len, 0);
+        cn_iogov_request(iter->iogov, iter->iocls, active->len);
 
         /* Check if previous read satisfied our need. If not, then
          * read ahead guessed wrong and we need to start a new one
@@ -3470,6 +4142,7 @@ kvset_iter_get_valptr_read(
 
     if (ms)
         count_ops(&ms->ms_vblk_read2, 1, active->len, 0);
+    cn_iogov_request(iter->iogov, iter->iocls, active->len);
 
 have_data:
 
@@ -3523,6 +4196,8 @@ have_data:
         vr->vr_requested = vr_start_read(vr, vbidx, off, iter->workq, iter->ks);
         if (!vr->vr_requested)
             vr->vr_read_ahead = false;
+        else
+            kvset_iter_aio_submit(iter);
     }
 
 skip_read_ahead:
@@ -3574,6 +4249,50 @@ kvset_iter_get_valptr(
     return 0;
 }
 
+static merr_t
+kvset_iter_get_blkval(
+    struct kv_iterator *handle,
+    uint                vbidx,
+    uint                vboff,
+    uint                boff,
+    uint                vlen,
+    const void **       vdata)
+{
+    struct kvset_iterator *iter = handle_to_kvset_iter(handle);
+    struct vblock_desc *   vbd;
+    const void *           blk = NULL;
+    merr_t                 err;
+
+    vbd = lvx2vbd(iter->ks, vbidx);
+    assert(vbd);
+
+    /* Read the block through the iterator's vblock readers unless it's
+     * already cached or too large for the read buffer, in which case
+     * vbr_cblk_value() falls back to the mcache map.
+     */
+    if (iter->workq && !vbr_cblk_cached(vbd, vboff)) {
+        struct vblk_reader *vr = iter->vreaders + (atomic_read(&vbd->vbd_vgidx) - 1);
+        uint                len = sizeof(struct vblock_cblk_omf);
+
+        if (vboff + len <= vbd->vbd_len) {
+            err = kvset_iter_get_valptr_read(iter, vbidx, vboff, len, &blk);
+            if (ev(err))
+                return err;
+
+            len = vbr_cblk_len(vbd, vboff, blk);
+
+            blk = NULL;
+            if (len <= vr->vr_buf_sz) {
+                err = kvset_iter_get_valptr_read(iter, vbidx, vboff, len, &blk);
+                if (ev(err))
+                    return err;
+            }
+        }
+    }
+
+    return vbr_cblk_value(vbd, vboff, blk, boff, vlen, vdata);
+}
+
 merr_t
 kvset_iter_next_val(
     struct kv_iterator *    handle,
@@ -3590,6 +4309,9 @@ kvset_iter_next_val(
             return kvset_iter_get_valptr(handle, vbidx, vboff, *vlen, vdata);
         case vtype_cval:
             return kvset_iter_get_valptr(handle, vbidx, vboff, *complen, vdata);
+        case vtype_bval:
+            *complen = 0;
+            return kvset_iter_get_blkval(handle, vbidx, vboff, vc->boff, *vlen, vdata);
         case vtype_zval:
             *vdata = 0;
             *vlen = 0;
@@ -3636,6 +4358,38 @@ kvset_iter_next_val_direct(
     return kvset_lookup_val_direct(iter->ks, vbd, vbidx, vboff, vdata, bufsz, vlen);
 }
 
+void
+kvset_iter_vblock_comp(struct kv_iterator *handle, uint vbidx, uint *calgo, uint *dictid)
+{
+    struct kvset_iterator *iter = handle_to_kvset_iter(handle);
+    struct vblock_desc *   vbd;
+
+    vbd = lvx2vbd(iter->ks, vbidx);
+    assert(vbd);
+
+    *calgo = vbd->vbd_calgo;
+    *dictid = vbd->vbd_dictid;
+}
+
+merr_t
+kvset_iter_val_decompress(
+    struct kv_iterator *handle,
+    uint                vbidx,
+    const void *        src,
+    uint                srclen,
+    void *              dst,
+    uint                dstcap,
+    uint *              dstlen)
+{
+    struct kvset_iterator *iter = handle_to_kvset_iter(handle);
+    struct vblock_desc *   vbd;
+
+    vbd = lvx2vbd(iter->ks, vbidx);
+    assert(vbd);
+
+    return vbr_decompress(vbd, src, srclen, dst, dstcap, dstlen);
+}
+
 void
 kvset_iter_release(struct kv_iterator *handle)
 {
@@ -3673,6 +4427,8 @@ kvset_iter_release(struct kv_iterator *handle)
         }
     }
 
+    mpool_aio_ctx_destroy(iter->aio);
+
     wbti_destroy(iter->wbti);
     wbti_destroy(iter->pti);
     kvset_put_ref(iter->ks);
@@ -3703,8 +4459,8 @@ kvset_from_iter(struct kv_iterator *iv)
 void
 kvset_maxkey(struct kvset *ks, const void **maxkey, u16 *maxklen)
 {
-    *maxkey = ks->ks_minkey;
-    *maxklen = ks->ks_minklen;
+    *maxkey = ks->ks_maxkey;
+    *maxklen = ks->ks_maxklen;
 }
 
 void
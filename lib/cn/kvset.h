@@ -11,6 +11,7 @@
 #include <hse_util/list.h>
 #include <hse_util/perfc.h>
 
+#include <hse_ikvdb/cn_iogov.h>
 #include <hse_ikvdb/kvs_cparams.h>
 #include <hse_ikvdb/tuple.h>
 #include <hse_ikvdb/omf_kmd.h>
@@ -45,6 +46,7 @@ enum kvset_iter_flags {
     kvset_iter_flag_mcache = (1u << 0),
     kvset_iter_flag_reverse = (1u << 1),
     kvset_iter_flag_fullscan = (1u << 2),
+    kvset_iter_flag_keys = (1u << 3),
 };
 
 /**
@@ -248,6 +250,42 @@ kvset_list_add_tail(struct kvset *kvset, struct list_head *head);
 void
 kvset_get_max_key(struct kvset *km, void **key, uint *klen);
 
+/* MTF_MOCK */
+void
+kvset_get_nth_kblock_min_key(struct kvset *km, u32 index, const void **key, uint *klen);
+
+/**
+ * struct kvset_sample - a key sampled by kvset_sample_keys()
+ * @ksa_kobj:   sampled key, valid while the kvset is referenced
+ * @ksa_weight: estimated number of keys from @ksa_kobj up to the next sample
+ */
+struct kvset_sample {
+    struct key_obj ksa_kobj;
+    u64            ksa_weight;
+};
+
+/**
+ * kvset_sample_keys() - sample the keys of a kvset at evenly spaced wbtree leaf nodes
+ * @km:      kvset
+ * @pfx:     sample only keys that may have this prefix
+ * @pfx_len: length of @pfx, zero to sample all keys
+ * @samplec: maximum number of samples
+ * @samplev: (output) vector of samples
+ *
+ * Each kblock receives a share of @samplec in proportion to its number of
+ * keys.  Only the wbtree leaf nodes that are sampled are read.
+ *
+ * Return: the number of samples
+ */
+/* MTF_MOCK */
+uint
+kvset_sample_keys(
+    struct kvset *       km,
+    const void *         pfx,
+    uint                 pfx_len,
+    uint                 samplec,
+    struct kvset_sample *samplev);
+
 /* MTF_MOCK */
 u64
 kvset_ctime(const struct kvset *kvset);
@@ -283,6 +321,7 @@ kvset_kblk_start(struct kvset *kvset, const void *key, int len, bool reverse);
  *                   If vbuf->b_buf is NULL, a buffer large enough to hold the
  *                   value will be allocated.
  */
+/* MTF_MOCK */
 merr_t
 kvset_lookup(
     struct kvset *         kvset,
@@ -292,6 +331,31 @@ kvset_lookup(
     enum key_lookup_res *  res,
     struct kvs_buf *       vbuf);
 
+/* Max number of keys per call to kvset_bloom_probe_multi() */
+#define KVSET_BLOOM_PROBE_MAX   (16)
+
+/**
+ * kvset_bloom_probe_multi() - Probe a kvset's bloom filters for a batch of keys
+ * @kvset:  kvset to search
+ * @ktv:    vector of keys to search for
+ * @kdiscv: vector of key discriminators
+ * @cnt:    number of keys (at most KVSET_BLOOM_PROBE_MAX)
+ * @hitv:   (output) %false if the key is definitely not in the kvset
+ *
+ * Keys for which @hitv is %true must still be resolved by kvset_lookup().
+ * The bloom buckets for all keys are prefetched before any of them are
+ * probed, which hides most of the cache miss latency when the kvset's
+ * blooms are not already cache resident.
+ */
+/* MTF_MOCK */
+void
+kvset_bloom_probe_multi(
+    struct kvset *          kvset,
+    struct kvs_ktuple **    ktv,
+    const struct key_disc **kdiscv,
+    uint                    cnt,
+    bool *                  hitv);
+
 struct query_ctx;
 
 merr_t
@@ -327,6 +391,17 @@ kvset_set_workid(struct kvset *km, u64 id);
 u64
 kvset_get_nth_vblock_len(struct kvset *km, u32 index);
 
+/**
+ * kvset_get_vcomp_dict() - Get the newest zstd dictionary of a kvset
+ * @ks:      kvset handle
+ * @dict:    (output) dictionary, valid for as long as the kvset
+ * @dictlen: (output) length of @dict
+ *
+ * Return: false if none of the kvset's vblocks has a zstd dictionary
+ */
+bool
+kvset_get_vcomp_dict(struct kvset *ks, const void **dict, uint *dictlen);
+
 /* MTF_MOCK */
 void
 kvset_stats(const struct kvset *ks, struct kvset_stats *stats);
@@ -351,6 +426,17 @@ kvset_set_scatter_pct(struct kvset *self, uint spct);
 u8 *
 kvset_get_hlog(struct kvset *km);
 
+/**
+ * kvset_get_rtombs() - get the range tombstones of a kvset
+ * @ks:  kvset handle
+ * @rtv: (output) vector of range tombstones, owned by the kvset
+ *
+ * Return: the number of elements in @rtv
+ */
+/* MTF_MOCK */
+uint
+kvset_get_rtombs(const struct kvset *ks, const struct rtomb **rtv);
+
 /* MTF_MOCK */
 uint
 kvset_get_compc(struct kvset *km);
@@ -393,6 +479,8 @@ kvset_defer_compc(struct kvset *km, u64 totkeys);
  *     be used with mcache map based iteration.
  *   - %kvset_iter_flag_mcache: If set, use mcache maps to access
  *     mblock data.  If not set, access data with mblock read.
+ *   - %kvset_iter_flag_keys: The caller never retrieves values via
+ *     kvset_iter_next_val(), so vblock readahead is disabled.
  *
  * Notes:
  *   - @io_workq is ignored when iterating with mcache maps.
@@ -429,6 +517,25 @@ kvset_iter_release(struct kv_iterator *handle);
 void
 kvset_iter_set_stats(struct kv_iterator *handle, struct cn_merge_stats *stats);
 
+/**
+ * kvset_iter_set_iogov() - charge the iterator's mblock reads to an IO governor
+ * @handle: kvset iterator
+ * @gov:    IO governor (NULL to disable)
+ * @cls:    IO class to charge
+ */
+/* MTF_MOCK */
+void
+kvset_iter_set_iogov(struct kv_iterator *handle, struct cn_iogov *gov, enum cn_iogov_class cls);
+
+/**
+ * kvset_iter_set_now() - fix the time against which value ttls expire
+ * @handle: kvset iterator
+ * @now:    seconds since the epoch (zero to use the wall clock)
+ */
+/* MTF_MOCK */
+void
+kvset_iter_set_now(struct kv_iterator *handle, u64 now);
+
 /* MTF_MOCK */
 merr_t
 kvset_iter_set_start(struct kv_iterator *kv_iter, int start, int pt_start);
@@ -561,6 +668,33 @@ kvset_iter_next_val_direct(
     uint                vlen,
     uint                bufsz);
 
+/**
+ * kvset_iter_vblock_comp() - Get the compression attributes of a vblock
+ * @handle: handle to kv iterator
+ * @vbidx:  vblock index
+ * @calgo:  (output) algorithm of compressed values (VBLOCK_CALGO_*)
+ * @dictid: (output) compression dictionary ID (zero if none)
+ */
+/* MTF_MOCK */
+void
+kvset_iter_vblock_comp(struct kv_iterator *handle, uint vbidx, uint *calgo, uint *dictid);
+
+/**
+ * kvset_iter_val_decompress() - Decompress a value read from a vblock
+ * @handle: handle to kv iterator
+ * @vbidx:  index of the vblock from which the value was read
+ */
+/* MTF_MOCK */
+merr_t
+kvset_iter_val_decompress(
+    struct kv_iterator *handle,
+    uint                vbidx,
+    const void *        src,
+    uint                srclen,
+    void *              dst,
+    uint                dstcap,
+    uint *              dstlen);
+
 #if HSE_MOCKING
 #include "kvset_ut.h"
 #endif /* HSE_MOCKING */
@@ -10,11 +10,13 @@
 #include <hse_util/slab.h>
 #include <hse_util/event_counter.h>
 #include <hse_util/bonsai_tree.h>
+#include <hse_util/page.h>
 
 #include <hse_ikvdb/kvset_builder.h>
 #include <hse_ikvdb/key_hash.h>
 #include <hse_ikvdb/limits.h>
 #include <hse_ikvdb/cn.h>
+#include <hse_ikvdb/rtomb.h>
 
 #include <hse/limits.h>
 
@@ -24,6 +26,7 @@
 #include "kblock_builder.h"
 #include "vblock_builder.h"
 #include "vblock_reader.h"
+#include "cn_vcomp.h"
 #include "blk_list.h"
 #include "kvset_builder_internal.h"
 
@@ -101,6 +104,62 @@ reserve_kmd(struct kmd_info *ki)
     return 0;
 }
 
+/* Retain an entry added during the value pass of a partitioned build
+ * for replay by the key pass (see kvset_builder_part_replay()).  If the
+ * log would exceed KVSET_BUILDER_LOG_MAX it is discarded, and the caller
+ * must produce the entries again for the key pass.
+ */
+static merr_t
+kvset_builder_log(
+    struct kvset_builder *self,
+    enum part_logtype     type,
+    u64                   seq,
+    const void           *data,
+    uint                  datalen,
+    uint                  vlen,
+    uint                  complen)
+{
+    struct part_logrec *rec;
+    size_t              sz;
+
+    sz = ALIGN(sizeof(*rec) + datalen, sizeof(u64));
+
+    if (self->logsz + sz > KVSET_BUILDER_LOG_MAX) {
+        kvset_builder_part_unlog(self);
+        return 0;
+    }
+
+    if (self->logsz + sz > self->logmax) {
+        size_t logmax = self->logmax ? self->logmax * 2 : (1u << 20);
+        u8 *   logv;
+
+        while (logmax < self->logsz + sz)
+            logmax *= 2;
+
+        logmax = min_t(size_t, logmax, KVSET_BUILDER_LOG_MAX);
+
+        logv = realloc(self->logv, logmax);
+        if (ev(!logv))
+            return merr(ENOMEM);
+
+        self->logv = logv;
+        self->logmax = logmax;
+    }
+
+    rec = (void *)(self->logv + self->logsz);
+    rec->pl_seq = seq;
+    rec->pl_vlen = vlen;
+    rec->pl_complen = complen;
+    rec->pl_type = type;
+
+    if (datalen > 0)
+        memcpy(rec + 1, data, datalen);
+
+    self->logsz += sz;
+
+    return 0;
+}
+
 merr_t
 kvset_builder_add_key(struct kvset_builder *self, const struct key_obj *kobj)
 {
@@ -114,6 +173,20 @@ kvset_builder_add_key(struct kvset_builder *self, const struct key_obj *kobj)
     if (ev(!klen || klen > HSE_KVS_KEY_LEN_MAX))
         return merr(EINVAL);
 
+    /* Keys are added to the kblock builder in the key pass */
+    if (self->vpass) {
+        if (self->log) {
+            u8   kbuf[HSE_KVS_KEY_LEN_MAX];
+            uint kbuflen;
+
+            key_obj_copy(kbuf, sizeof(kbuf), &kbuflen, kobj);
+
+            return kvset_builder_log(self, PART_LOG_KEY, 0, kbuf, kbuflen, kbuflen, 0);
+        }
+
+        return 0;
+    }
+
     if (self->key_stats.nptombs > 0) {
         err = kbb_add_ptomb(self->kbb, kobj, self->sec.kmd, self->sec.kmd_used, &self->key_stats);
         if (ev(err))
@@ -143,6 +216,91 @@ kvset_builder_add_key(struct kvset_builder *self, const struct key_obj *kobj)
     return ev(err);
 }
 
+/* Write a value to a vblock and record its location for use by the
+ * key pass of a partitioned build (see kvset_builder_part_begin()).
+ * Values that will not reside in a vblock are ignored.
+ */
+static merr_t
+kvset_builder_vpass_add_val(
+    struct kvset_builder   *self,
+    const void             *vdata,
+    uint                    vlen,
+    uint                    complen)
+{
+    struct vblk_loc *vloc;
+    uint             vbidx = 0, vboff = 0, boff = 0;
+    u64              vbid = 0;
+    bool             bval;
+    merr_t           err;
+
+    if (vdata == HSE_CORE_TOMB_REG || vdata == HSE_CORE_TOMB_PFX || !vdata || vlen == 0)
+        return 0;
+
+    if (complen == 0 && vlen <= CN_SMALL_VALUE_THRESHOLD)
+        return 0;
+
+    if (self->vlocc >= self->vlocmax) {
+        size_t vlocmax = self->vlocmax ? self->vlocmax * 2 : 4096;
+
+        vloc = realloc(self->vlocv, vlocmax * sizeof(*vloc));
+        if (ev(!vloc))
+            return merr(ENOMEM);
+
+        self->vlocv = vloc;
+        self->vlocmax = vlocmax;
+    }
+
+    bval = !complen && cn_vcomp_blkval(self->vcomp, vlen);
+
+    if (bval)
+        err = vbb_add_blk_entry(self->vbb, vdata, vlen, &vbid, &vbidx, &vboff, &boff);
+    else
+        err = vbb_add_entry(self->vbb, vdata, complen ? complen : vlen, &vbid, &vbidx, &vboff);
+    if (ev(err))
+        return err;
+
+    vloc = self->vlocv + self->vlocc++;
+    vloc->vl_vbidx = vbidx;
+    vloc->vl_vboff = vboff;
+    vloc->vl_complen = complen;
+    vloc->vl_boff = boff;
+    vloc->vl_bval = bval;
+
+    return 0;
+}
+
+/* Compress a value into the builder's compression buffer.  The value is
+ * left as is if it doesn't compress to less than its uncompressed length.
+ */
+static merr_t
+kvset_builder_compress(struct kvset_builder *self, const void **vdata, uint vlen, uint *complen)
+{
+    uint   clen;
+    merr_t err;
+
+    if (vlen > self->cbufsz) {
+        uint  sz = ALIGN(vlen, PAGE_SIZE);
+        void *buf;
+
+        buf = malloc(sz);
+        if (ev(!buf))
+            return merr(ENOMEM);
+
+        free(self->cbuf);
+        self->cbuf = buf;
+        self->cbufsz = sz;
+    }
+
+    err = cn_vcomp_compress(self->vcomp, *vdata, vlen, self->cbuf, vlen - 1, &clen);
+    if (err)
+        return 0;
+
+    *vdata = self->cbuf;
+    *complen = clen;
+
+    return 0;
+}
+
 /**
  * kvset_builder_add_val() - Add a value or a tombstone to a kvset entry.
  * @builder: Kvset builder object.
@@ -178,6 +336,46 @@ kvset_builder_add_val(
     u64              seqno_prev;
     struct kmd_info *ki = vdata == HSE_CORE_TOMB_PFX ? &self->sec : &self->main;
 
+    /* Compress values destined for a vblock, other than those that will
+     * be packed into compressed blocks.  In the key pass of a partitioned
+     * build the value pass has already done so, and the compressed length
+     * is taken from the value's vblk_loc.
+     */
+    if (self->vcomp && !complen && vlen > CN_SMALL_VALUE_THRESHOLD && vdata &&
+        vdata != HSE_CORE_TOMB_REG && vdata != HSE_CORE_TOMB_PFX &&
+        !(self->part && !self->vpass) && !cn_vcomp_blkval(self->vcomp, vlen)) {
+
+        err = kvset_builder_compress(self, &vdata, vlen, &complen);
+        if (ev(err))
+            return err;
+    }
+
+    if (self->vpass) {
+        if (self->log) {
+            enum part_logtype type;
+            uint              datalen = 0;
+
+            if (vdata == HSE_CORE_TOMB_REG) {
+                type = PART_LOG_TOMB;
+            } else if (vdata == HSE_CORE_TOMB_PFX) {
+                type = PART_LOG_PTOMB;
+            } else if (!vdata || vlen == 0) {
+                type = PART_LOG_ZVAL;
+            } else if (complen == 0 && vlen <= CN_SMALL_VALUE_THRESHOLD) {
+                type = PART_LOG_IVAL;
+                datalen = vlen;
+            } else {
+                type = PART_LOG_VAL;
+            }
+
+            err = kvset_builder_log(self, type, seq, vdata, datalen, vlen, complen);
+            if (ev(err))
+                return err;
+        }
+
+        return kvset_builder_vpass_add_val(self, vdata, vlen, complen);
+    }
+
     if (ev(reserve_kmd(ki)))
         return merr(ENOMEM);
 
@@ -198,9 +396,10 @@ kvset_builder_add_val(
         self->key_stats.tot_vlen += vlen;
     } else {
 
-        uint vbidx = 0, vboff = 0;
+        uint vbidx = 0, vboff = 0, boff = 0;
         u64 vbid = 0;
         uint omlen; /* on media length */
+        bool bval = false;
 
         assert(vdata);
 
@@ -208,13 +407,47 @@ kvset_builder_add_val(
 
         /* vblock builder needs on-media length */
         omlen = complen ? complen : vlen;
-        err = vbb_add_entry(self->vbb, vdata, omlen, &vbid, &vbidx, &vboff);
-        if (ev(err))
-            return err;
+
+        if (self->part) {
+            struct vblk_loc *vloc;
+
+            /* The value was written to a vblock in the value pass.
+             */
+            assert(self->vlocidx < self->vlocc);
+            if (ev(self->vlocidx >= self->vlocc))
+                return merr(EBUG);
+
+            vloc = self->vlocv + self->vlocidx++;
+            vbidx = vloc->vl_vbidx + self->vblk_baseidx;
+            vboff = vloc->vl_vboff;
+
+            if (vloc->vl_complen) {
+                complen = vloc->vl_complen;
+                omlen = complen;
+            }
+
+            boff = vloc->vl_boff;
+            bval = vloc->vl_bval;
+        } else if (!complen && cn_vcomp_blkval(self->vcomp, vlen)) {
+            err = vbb_add_blk_entry(self->vbb, vdata, vlen, &vbid, &vbidx, &vboff, &boff);
+            if (ev(err))
+                return err;
+
+            bval = true;
+        } else {
+            err = vbb_add_entry(self->vbb, vdata, omlen, &vbid, &vbidx, &vboff);
+            if (ev(err))
+                return err;
+        }
 
         self->key_stats.c0_vlen += omlen;
 
-        if (complen)
+        /* A block value's share of its compressed block isn't known,
+         * so its uncompressed length is used as its on-media length.
+         */
+        if (bval)
+            kmd_add_bval(self->main.kmd, &self->main.kmd_used, seq, vbidx, vboff, vlen, boff);
+        else if (complen)
             kmd_add_cval(self->main.kmd, &self->main.kmd_used, seq, vbidx, vboff, vlen, complen);
         else
             kmd_add_val(self->main.kmd, &self->main.kmd_used, seq, vbidx, vboff, vlen);
@@ -244,6 +477,31 @@ kvset_builder_add_val(
     return 0;
 }
 
+merr_t
+kvset_builder_add_expire(struct kvset_builder *self, u64 expire)
+{
+    if (!expire)
+        return 0;
+
+    /* In the value pass of a partitioned build the expiration time
+     * is logged for replay by the key pass, if there is a log.
+     * Otherwise the caller will add it again in the key pass.
+     */
+    if (self->vpass) {
+        if (self->log)
+            return kvset_builder_log(self, PART_LOG_EXPIRE, expire, NULL, 0, 0, 0);
+
+        return 0;
+    }
+
+    if (ev(reserve_kmd(&self->main)))
+        return merr(ENOMEM);
+
+    kmd_add_expire(self->main.kmd, &self->main.kmd_used, expire);
+
+    return 0;
+}
+
 /**
  * kvset_builder_add_vref() - add a vtype_val or vtype_cval entry its a kvset
  *
@@ -279,6 +537,35 @@ kvset_builder_add_vref(
     return 0;
 }
 
+/**
+ * kvset_builder_add_bref() - add a vtype_bval entry to a kvset
+ *
+ * The entry refers to a value in an existing compressed block.
+ */
+merr_t
+kvset_builder_add_bref(
+    struct kvset_builder   *self,
+    u64                     seq,
+    uint                    vbidx,
+    uint                    vboff,
+    uint                    vlen,
+    uint                    boff)
+{
+    if (reserve_kmd(&self->main))
+        return merr(ev(ENOMEM));
+
+    kmd_add_bval(self->main.kmd, &self->main.kmd_used, seq, vbidx, vboff, vlen, boff);
+
+    self->vused += vlen;
+    self->key_stats.tot_vlen += vlen;
+    self->key_stats.nvals++;
+
+    self->seqno_max = max_t(u64, self->seqno_max, seq);
+    self->seqno_min = min_t(u64, self->seqno_min, seq);
+
+    return 0;
+}
+
 merr_t
 kvset_builder_add_nonval(struct kvset_builder *self, u64 seq, enum kmd_vtype vtype)
 {
@@ -305,6 +592,27 @@ kvset_builder_add_nonval(struct kvset_builder *self, u64 seq, enum kmd_vtype vty
     return 0;
 }
 
+merr_t
+kvset_builder_add_rtomb(struct kvset_builder *self, const struct rtomb *rt)
+{
+    merr_t err;
+
+    if (ev(!rt || !rt->rt_slen || !rt->rt_elen))
+        return merr(EINVAL);
+
+    if (ev(self->vpass))
+        return merr(EINVAL);
+
+    err = kbb_add_rtomb(self->kbb, rt);
+    if (ev(err))
+        return err;
+
+    self->seqno_max = max_t(u64, self->seqno_max, rt->rt_seqno);
+    self->seqno_min = min_t(u64, self->seqno_min, rt->rt_seqno);
+
+    return 0;
+}
+
 void
 kvset_builder_destroy(struct kvset_builder *bld)
 {
@@ -320,6 +628,9 @@ kvset_builder_destroy(struct kvset_builder *bld)
     kbb_destroy(bld->kbb);
     vbb_destroy(bld->vbb);
 
+    free(bld->logv);
+    free(bld->vlocv);
+    free(bld->cbuf);
     free(bld->main.kmd);
     free(bld->sec.kmd);
     free(bld);
@@ -403,6 +714,253 @@ kvset_builder_get_mblocks(struct kvset_builder *self, struct kvset_mblocks *mblk
     return 0;
 }
 
+void
+kvset_builder_part_begin(struct kvset_builder *self)
+{
+    assert(!self->part);
+    assert(self->seqno_min == U64_MAX);
+
+    self->part = true;
+    self->vpass = true;
+}
+
+void
+kvset_builder_part_log(struct kvset_builder *self)
+{
+    assert(self->part && self->vpass);
+    assert(self->logsz == 0);
+
+    self->log = true;
+}
+
+void
+kvset_builder_part_unlog(struct kvset_builder *self)
+{
+    assert(self->part);
+
+    free(self->logv);
+    self->logv = NULL;
+    self->logsz = self->logmax = 0;
+    self->log = false;
+}
+
+bool
+kvset_builder_part_logged(struct kvset_builder *self)
+{
+    return self->log;
+}
+
+merr_t
+kvset_builder_part_vblocks(struct kvset_builder *self, uint *vblkc)
+{
+    merr_t err;
+
+    assert(self->part && self->vpass);
+
+    err = vbb_finish(self->vbb, &self->vblk_list);
+    if (ev(err))
+        return err;
+
+    self->vpass = false;
+    *vblkc = self->vblk_list.n_blks;
+
+    return 0;
+}
+
+void
+kvset_builder_part_rebase(struct kvset_builder *self, uint vbidx_base)
+{
+    assert(self->part && !self->vpass);
+
+    self->vblk_baseidx = vbidx_base;
+}
+
+merr_t
+kvset_builder_part_replay(struct kvset_builder *self)
+{
+    struct part_logrec *rec;
+    struct key_obj      kobj;
+    const void *        vdata;
+    size_t              off, sz;
+    uint                datalen;
+    merr_t              err;
+
+    assert(self->part && !self->vpass && self->log);
+
+    for (off = 0; off < self->logsz; off += sz) {
+        rec = (void *)(self->logv + off);
+
+        datalen = 0;
+        if (rec->pl_type == PART_LOG_KEY || rec->pl_type == PART_LOG_IVAL)
+            datalen = rec->pl_vlen;
+
+        sz = ALIGN(sizeof(*rec) + datalen, sizeof(u64));
+
+        switch (rec->pl_type) {
+        case PART_LOG_KEY:
+            key2kobj(&kobj, rec + 1, rec->pl_vlen);
+
+            err = kvset_builder_add_key(self, &kobj);
+            if (ev(err))
+                return err;
+            continue;
+
+        case PART_LOG_TOMB:
+            vdata = HSE_CORE_TOMB_REG;
+            break;
+
+        case PART_LOG_PTOMB:
+            vdata = HSE_CORE_TOMB_PFX;
+            break;
+
+        case PART_LOG_ZVAL:
+            vdata = NULL;
+            break;
+
+        case PART_LOG_IVAL:
+            vdata = rec + 1;
+            break;
+
+        case PART_LOG_VAL:
+            /* The value resides in a vblock written by the value
+             * pass, so any non-null pointer will do.
+             */
+            vdata = rec;
+            break;
+
+        case PART_LOG_EXPIRE:
+            err = kvset_builder_add_expire(self, rec->pl_seq);
+            if (ev(err))
+                return err;
+            continue;
+
+        default:
+            assert(0);
+            return merr(EBUG);
+        }
+
+        err = kvset_builder_add_val(self, rec->pl_seq, vdata, rec->pl_vlen, rec->pl_complen);
+        if (ev(err))
+            return err;
+    }
+
+    kvset_builder_part_unlog(self);
+
+    return 0;
+}
+
+static merr_t
+kvset_builder_join_list(struct blk_list *dst, struct blk_list *src)
+{
+    merr_t err;
+    uint   i;
+
+    for (i = 0; i < src->n_blks; ++i) {
+        err = blk_list_append(dst, src->blks[i].bk_blkid);
+        if (ev(err))
+            return err;
+    }
+
+    return 0;
+}
+
+merr_t
+kvset_builder_join(struct kvset_builder **bldv, uint bldc, struct kvset_mblocks *mblks)
+{
+    struct kvset_builder *last;
+    struct blk_list       kblks, vblks;
+    u64                   seqno_min, seqno_max, vused;
+    merr_t                err;
+    uint                  i;
+
+    if (ev(bldc < 1))
+        return merr(EINVAL);
+
+    /* A builder to which no entries were added produces no kblocks,
+     * so the kvset's last kblock is that of the last non-empty builder.
+     */
+    last = bldv[bldc - 1];
+    for (i = bldc; i-- > 0;) {
+        if (bldv[i]->seqno_min <= bldv[i]->seqno_max) {
+            last = bldv[i];
+            break;
+        }
+    }
+
+    seqno_min = U64_MAX;
+    seqno_max = vused = 0;
+
+    /* The hlog and seqno range of a kvset are taken from its last kblock,
+     * so they must reflect the keys of all the builders.
+     */
+    for (i = 0; i < bldc; ++i) {
+        struct kvset_builder *bld = bldv[i];
+
+        assert(bld->part && !bld->vpass);
+
+        /* Every value written in the value pass must have been claimed
+         * by a key in the key pass, else the vlocs are misaligned.
+         */
+        assert(bld->vlocidx == bld->vlocc);
+        if (ev(bld->vlocidx != bld->vlocc))
+            return merr(EBUG);
+
+        if (bld != last)
+            kbb_hlog_union(last->kbb, bld->kbb);
+
+        seqno_min = min_t(u64, seqno_min, bld->seqno_min);
+        seqno_max = max_t(u64, seqno_max, bld->seqno_max);
+        vused += bld->vused;
+    }
+
+    for (i = 0; i < bldc; ++i) {
+        err = kbb_finish(bldv[i]->kbb, &bldv[i]->kblk_list, seqno_min, seqno_max);
+        if (ev(err))
+            return err;
+    }
+
+    /* The builders retain ownership of their mblocks until the combined
+     * lists have been successfully constructed.
+     */
+    blk_list_init(&kblks);
+    blk_list_init(&vblks);
+
+    for (i = 0; i < bldc; ++i) {
+        err = kvset_builder_join_list(&kblks, &bldv[i]->kblk_list);
+        if (ev(err))
+            goto errout;
+
+        err = kvset_builder_join_list(&vblks, &bldv[i]->vblk_list);
+        if (ev(err))
+            goto errout;
+    }
+
+    for (i = 0; i < bldc; ++i) {
+        blk_list_free(&bldv[i]->kblk_list);
+        blk_list_free(&bldv[i]->vblk_list);
+    }
+
+    mblks->kblks = kblks;
+    mblks->vblks = vblks;
+    mblks->bl_vused = vused;
+    mblks->bl_seqno_max = seqno_max;
+    mblks->bl_seqno_min = seqno_min;
+
+    if (cn_get_flags(last->cn) & CN_CFLAG_CAPPED) {
+        mblks->bl_last_ptomb = last->last_ptomb;
+        mblks->bl_last_ptlen = last->last_ptlen;
+        mblks->bl_last_ptseq = last->last_ptseq;
+    }
+
+    return 0;
+
+errout:
+    blk_list_free(&kblks);
+    blk_list_free(&vblks);
+
+    return err;
+}
+
 void
 kvset_builder_set_agegroup(struct kvset_builder *self, enum hse_mclass_policy_age age)
 {
@@ -418,6 +976,30 @@ kvset_builder_set_merge_stats(struct kvset_builder *self, struct cn_merge_stats
     vbb_set_merge_stats(self->vbb, stats);
 }
 
+void
+kvset_builder_set_iogov(struct kvset_builder *self, struct cn_iogov *gov, enum cn_iogov_class cls)
+{
+    kbb_set_iogov(self->kbb, gov, cls);
+    vbb_set_iogov(self->vbb, gov, cls);
+}
+
+merr_t
+kvset_builder_set_vcomp(struct kvset_builder *self, const struct cn_vcomp *vcomp)
+{
+    merr_t err;
+
+    if (!vcomp)
+        return 0;
+
+    err = vbb_set_comp(self->vbb, vcomp);
+    if (ev(err))
+        return err;
+
+    self->vcomp = vcomp;
+
+    return 0;
+}
+
 #if HSE_MOCKING
 #include "kvset_builder_ut_impl.i"
 #endif /* HSE_MOCKING */
@@ -12,6 +12,7 @@
 #include "cn_metrics.h"
 
 struct cn;
+struct cn_vcomp;
 
 struct kmd_info {
     u8 *   kmd;
@@ -19,6 +20,46 @@ struct kmd_info {
     size_t kmd_used;
 };
 
+/* Location of a value written during the value pass of a partitioned build.
+ */
+struct vblk_loc {
+    u32  vl_vbidx;
+    u32  vl_vboff;
+    u32  vl_complen;
+    u32  vl_boff;
+    bool vl_bval;
+};
+
+/* Entry types retained by the value pass of a partitioned build for replay
+ * by the key pass (see kvset_builder_part_log()).
+ */
+enum part_logtype {
+    PART_LOG_KEY,
+    PART_LOG_TOMB,
+    PART_LOG_PTOMB,
+    PART_LOG_ZVAL,
+    PART_LOG_IVAL,
+    PART_LOG_VAL,
+    PART_LOG_EXPIRE,
+};
+
+/* Upper bound on the memory retained by one builder's value pass.  A spill
+ * has one builder per child for each of its slices, so this bounds the log
+ * memory of a sliced spill at (slices * fanout * KVSET_BUILDER_LOG_MAX).
+ */
+#define KVSET_BUILDER_LOG_MAX (16ul << 20)
+
+/* A retained entry is followed by its key (for PART_LOG_KEY, in which case
+ * pl_vlen is the key length) or its value data (for PART_LOG_IVAL).  The
+ * pl_seq of a PART_LOG_EXPIRE entry holds the expiration time.
+ */
+struct part_logrec {
+    u64 pl_seq;
+    u32 pl_vlen;
+    u32 pl_complen;
+    u32 pl_type;
+};
+
 /**
  * struct kvset_builder - context for holding the results of a merge operation
  * @cn:              pointer to cn struct
@@ -36,6 +77,17 @@ struct kmd_info {
  *                   only if cn is a capped.
  * @last_ptlen:      length of @last_ptomb
  * @vblk_baseidx:    base index used for coalescing multiple vblock builders
+ * @vlocv:           locations of values written during the value pass
+ * @vlocc:           number of entries in @vlocv
+ * @vlocmax:         allocated size of @vlocv (in entries)
+ * @vlocidx:         index of next @vlocv entry to consume in the key pass
+ * @part:            true if this is a partitioned build
+ * @vpass:           true if in the value pass of a partitioned build
+ * @logv:            entries retained by the value pass for replay
+ * @logsz:           number of bytes used in @logv
+ * @logmax:          allocated size of @logv (in bytes)
+ * @log:             true if the value pass retains its entries (cleared if
+ *                   the log would exceed KVSET_BUILDER_LOG_MAX)
  *
  * This struct contains the output kvset when merging multiple input kvsets
  * into one output kvset.  It is used for ingest, compaction and spill.  When
@@ -69,5 +121,22 @@ struct kvset_builder {
     u8  last_ptomb[HSE_KVS_PFX_LEN_MAX];
     u32 last_ptlen;
     u64 last_ptseq;
+
+    uint             vblk_baseidx;
+    struct vblk_loc *vlocv;
+    size_t           vlocc;
+    size_t           vlocmax;
+    size_t           vlocidx;
+    bool             part;
+    bool             vpass;
+
+    u8    *logv;
+    size_t logsz;
+    size_t logmax;
+    bool   log;
+
+    const struct cn_vcomp *vcomp;
+    void *                 cbuf;
+    uint                   cbufsz;
 };
 #endif
@@ -441,10 +441,16 @@ wbn_leaf_check(
             u64            seq;
             const void *   ival;
             u32            ivlen;
+            u32            vbidx, vboff, vlen, boff;
+            u64            expire;
 
             kb_info->kmd_idx = j;
 
-            kmd_type_seq(kb_info->kmd, &off, &vtype, &seq);
+            kmd_type_seq_expire(kb_info->kmd, &off, &vtype, &seq, &expire);
+            if (expire && kb_info->wbt_version < WBT_TREE_VERSION8) {
+                kmd_err(kb_info, "expiration time in a v%u wbtree", kb_info->wbt_version);
+                err = true;
+            }
             if (last_seq && seq < last_seq) {
                 kmd_err(kb_info, "seqno out of order");
                 last_seq = seq;
@@ -457,6 +463,15 @@ wbn_leaf_check(
                         0)
                         err = true;
                     break;
+                case vtype_bval:
+                    kmd_bval(kb_info->kmd, &off, &vbidx, &vboff, &vlen, &boff);
+                    if (boff + vlen > VBLOCK_CBLK_LEN_MAX) {
+                        err = true;
+                        kmd_err(kb_info, "vb %u off %u len %u boff %u: extends beyond block",
+                                vbidx, vboff, vlen, boff);
+                    }
+                    kb_metrics->val_bytes += vlen;
+                    break;
                 case vtype_tomb:
                     kb_metrics->tombs++;
                     break;
@@ -590,6 +605,14 @@ kc_vblock_meta(struct mpool *ds, struct blk_list *list)
         if (omf_vbh_version(vb_hdr) > VBLOCK_HDR_VERSION)
             print_err("vblock 0x%08lx: invalid version", vbid);
 
+        if (omf_vbh_version(vb_hdr) >= VBLOCK_HDR_VERSION3) {
+            if (omf_vbh_calgo(vb_hdr) > VBLOCK_CALGO_ZSTD)
+                print_err("vblock 0x%08lx: invalid compression algorithm", vbid);
+
+            if (omf_vbh_dictlen(vb_hdr) > VBLOCK_DICT_LEN_MAX)
+                print_err("vblock 0x%08lx: invalid dictionary length", vbid);
+        }
+
         free_aligned(vb_buf);
     }
 
@@ -758,7 +781,9 @@ _kblock_check(struct kb_info *kb_info, struct vb_meta *vb_meta)
 
     wbt_ver = omf_wbt_version(wbt_hdr);
     switch (wbt_ver) {
-        case WBT_TREE_VERSION:
+        case WBT_TREE_VERSION6:
+        case WBT_TREE_VERSION7:
+        case WBT_TREE_VERSION8:
             kb_info->wbt_ops.wops_lfe = wbt_lfe;
             kb_info->wbt_ops.wops_node_pfx = wbt_node_pfx;
             kb_info->wbt_ops.wops_lfe_key = wbt_lfe_key;
@@ -770,6 +795,8 @@ _kblock_check(struct kb_info *kb_info, struct vb_meta *vb_meta)
             return merr(EINVAL);
     }
 
+    kb_info->wbt_version = wbt_ver;
+
     blm_hdr = kb_info->blk + omf_kbh_blm_hoff(kb_hdr);
 
     if (omf_bh_magic(blm_hdr) != BLOOM_OMF_MAGIC && (++errcnt))
@@ -778,6 +805,11 @@ _kblock_check(struct kb_info *kb_info, struct vb_meta *vb_meta)
     if (omf_bh_version(blm_hdr) > BLOOM_OMF_VERSION && (++errcnt))
         kb_err(kb_info, "Invalid bloom hdr version");
 
+    if (omf_bh_version(blm_hdr) >= BLOOM_OMF_VERSION6 &&
+        omf_bh_type(blm_hdr) != BLOOM_OMF_TYPE_BLOOM &&
+        omf_bh_type(blm_hdr) != BLOOM_OMF_TYPE_XOR && (++errcnt))
+        kb_err(kb_info, "Invalid bloom hdr type");
+
     if (errcnt)
         return merr(ev(EILSEQ));
 
@@ -801,6 +833,11 @@ _kblock_check(struct kb_info *kb_info, struct vb_meta *vb_meta)
     kb_info->blm_desc.bd_rotl = omf_bh_rotl(blm_hdr);
     kb_info->blm_desc.bd_bktmask = (1u << kb_info->blm_desc.bd_bktshift) - 1;
 
+    if (omf_bh_version(blm_hdr) >= BLOOM_OMF_VERSION6) {
+        kb_info->blm_desc.bd_type = omf_bh_type(blm_hdr);
+        kb_info->blm_desc.bd_seed = omf_bh_seed(blm_hdr);
+    }
+
     kb_info->blm_data = (void *)kb_hdr + pgoff(kb_info->blm_desc.bd_first_page);
 
     kb_info->kmd = (void *)kb_hdr + pgoff(omf_kbh_wbt_doff_pg(kb_hdr) + omf_wbt_root(wbt_hdr) + 1);
@@ -16,6 +16,7 @@
 #include <hse_ikvdb/tuple.h>
 #include <hse_ikvdb/omf_kmd.h>
 #include <hse_ikvdb/kvset_view.h>
+#include <hse_ikvdb/rtomb.h>
 
 #include <mpool/mpool.h>
 
@@ -65,6 +66,7 @@ struct kvset {
     u32           ks_vmin;
     u32           ks_vmax;
     u32           ks_vra_len;
+    u8            ks_bcache;
     uint          ks_compc;
 
     struct kvs_rparams *ks_rp;
@@ -96,6 +98,9 @@ struct kvset {
     struct cn_work ks_kvset_cn_work;
     u64            ks_delete_txid;
 
+    struct rtomb *ks_rtombv; /* range tombstones (keys copied) */
+    uint          ks_rtombc; /* number of range tombstones */
+
     const void *ks_maxkey;  /* largest key in kvset */
     const void *ks_minkey;  /* smallest key in kvset */
     u16         ks_maxklen; /* length of largest key */
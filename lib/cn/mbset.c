@@ -102,6 +102,13 @@ _mbset_mblk_getprops(struct mbset *self, mbset_udata_init_fn *cb)
         self->mbs_wlen += props.mpr_write_len;
     }
 
+    /* Release the udata of the blocks initialized prior to the failure.
+     */
+    if (err && cb && self->mbs_udata_fini) {
+        while (i-- > 0)
+            self->mbs_udata_fini(self, i, mbset_get_udata(self, i));
+    }
+
     free(argv);
 
     return err;
@@ -198,6 +205,7 @@ mbset_create(
     u64 *               idv,
     size_t              udata_sz,
     mbset_udata_init_fn udata_init_fn,
+    mbset_udata_fini_fn udata_fini_fn,
     uint                flags,
     u64                 mblock_max,
     struct mbset **     handle)
@@ -240,6 +248,7 @@ mbset_create(
     self->mbs_ds = ds;
     self->mbs_del = false;
     self->mbs_udata_sz = udata_sz;
+    self->mbs_udata_fini = udata_fini_fn;
     self->mbs_mblock_max = mblock_max;
 
     err = _mbset_map(self, flags);
@@ -273,6 +282,13 @@ _mbset_destroy(struct mbset *self, bool *delete_errors)
     if (ev(!self))
         return;
 
+    if (self->mbs_udata_fini) {
+        uint i;
+
+        for (i = 0; i < self->mbs_idc; i++)
+            self->mbs_udata_fini(self, i, mbset_get_udata(self, i));
+    }
+
     _mbset_unmap(self);
     if (self->mbs_del) {
         err = _mbset_mblk_del(self);
@@ -33,6 +33,9 @@ mbset_udata_init_fn(
     struct mblock_props *props,
     void *               rock);
 
+typedef void
+mbset_udata_fini_fn(struct mbset *mbs, uint bnum, void *rock);
+
 /**
  * struct mbset - a ref counted set of mblocks
  * @mbs_mapv: vector of mcache map handles
@@ -61,6 +64,7 @@ struct mbset {
     mbset_callback *          mbs_callback;
     void *                    mbs_callback_rock;
     void *                    mbs_udata;
+    mbset_udata_fini_fn *     mbs_udata_fini;
     uint                      mbs_udata_sz;
     bool                      mbs_del;
 };
@@ -73,6 +77,7 @@ mbset_create(
     u64 *               idv,
     size_t              udata_sz,
     mbset_udata_init_fn udata_init_fn,
+    mbset_udata_fini_fn udata_fini_fn,
     uint                flags,
     u64                 mblock_max,
     struct mbset **     handle);
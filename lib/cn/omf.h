@@ -67,6 +67,10 @@ struct kblock_hdr_omf {
     uint64_t kbh_min_seqno;
     uint64_t kbh_max_seqno;
 
+    /* range tombstones (v6) */
+    uint32_t kbh_rt_doff_pg;
+    uint32_t kbh_rt_dlen_pg;
+
 } HSE_PACKED;
 
 /* Define set/get methods for kblock_hdr_omf */
@@ -102,6 +106,36 @@ OMF_SETGET(struct kblock_hdr_omf, kbh_pt_dlen_pg, 32)
 OMF_SETGET(struct kblock_hdr_omf, kbh_min_seqno, 64)
 OMF_SETGET(struct kblock_hdr_omf, kbh_max_seqno, 64)
 
+OMF_SETGET(struct kblock_hdr_omf, kbh_rt_doff_pg, 32)
+OMF_SETGET(struct kblock_hdr_omf, kbh_rt_dlen_pg, 32)
+
+/* Range tombstone region
+ *
+ * The range tombstones of a kvset are stored in its last kblock as this
+ * header followed by krh_entries records.  Each record is followed by its
+ * start key and then its end key, and is padded to an 8-byte boundary.
+ */
+#define KBLOCK_RT_MAGIC ((u32)('k' << 24 | 'b' << 16 | 'r' << 8 | 't'))
+
+struct kblock_rt_hdr_omf {
+    uint32_t krh_magic;
+    uint32_t krh_entries;
+} HSE_PACKED;
+
+OMF_SETGET(struct kblock_rt_hdr_omf, krh_magic, 32)
+OMF_SETGET(struct kblock_rt_hdr_omf, krh_entries, 32)
+
+struct kblock_rt_omf {
+    uint64_t kro_seqno;
+    uint16_t kro_slen;
+    uint16_t kro_elen;
+    uint32_t kro_rsvd;
+} HSE_PACKED;
+
+OMF_SETGET(struct kblock_rt_omf, kro_seqno, 64)
+OMF_SETGET(struct kblock_rt_omf, kro_slen, 16)
+OMF_SETGET(struct kblock_rt_omf, kro_elen, 16)
+
 /*****************************************************************
  *
  * Bloom filter header OMF (part of the kblock)
@@ -110,15 +144,26 @@ OMF_SETGET(struct kblock_hdr_omf, kbh_max_seqno, 64)
 
 #define BLOOM_OMF_MAGIC ((u32)('b' << 24 | 'l' << 16 | 'm' << 8 | 'h'))
 
+/* Filter types (bh_type)
+ */
+#define BLOOM_OMF_TYPE_BLOOM (0)
+#define BLOOM_OMF_TYPE_XOR   (1)
+
 /**
  * struct bloom_hdr_omf -
  * @bh_magic:           BLOOM_OMF_MAGIC
  * @bh_version:         BLOOM_OMF_VERSION
  * @bh_bktsz:           number of bytes per bucket
+ * @bh_type:            filter type (BLOOM_OMF_TYPE_*, v6 and later)
  * @bh_rotl:            hash rotate left amount
  * @bh_n_hashes:        number of hashes per bucket
  * @bh_bitmapsz:        size of bitmap in bytes
  * @bh_modulus:         modulus used to convert first hash to bucket
+ * @bh_seed:            hash seed (xor filter only)
+ *
+ * For xor filters the bitmap holds the fingerprint array, @bh_modulus
+ * is the number of slots per segment, and @bh_n_hashes is the width of
+ * a fingerprint in bits.
  */
 struct bloom_hdr_omf {
     uint32_t bh_magic;
@@ -126,10 +171,10 @@ struct bloom_hdr_omf {
     uint32_t bh_bitmapsz;
     uint32_t bh_modulus;
     uint32_t bh_bktshift;
-    uint16_t bh_rsvd1;
+    uint16_t bh_type;
     uint8_t  bh_rotl;
     uint8_t  bh_n_hashes;
-    uint32_t bh_rsvd2;
+    uint32_t bh_seed;
     uint32_t bh_rsvd3;
 } HSE_PACKED;
 
@@ -139,14 +184,20 @@ OMF_SETGET(struct bloom_hdr_omf, bh_version, 32)
 OMF_SETGET(struct bloom_hdr_omf, bh_bitmapsz, 32)
 OMF_SETGET(struct bloom_hdr_omf, bh_modulus, 32)
 OMF_SETGET(struct bloom_hdr_omf, bh_bktshift, 32)
+OMF_SETGET(struct bloom_hdr_omf, bh_type, 16)
 OMF_SETGET(struct bloom_hdr_omf, bh_rotl, 8)
 OMF_SETGET(struct bloom_hdr_omf, bh_n_hashes, 8)
+OMF_SETGET(struct bloom_hdr_omf, bh_seed, 32)
 
 /*****************************************************************
  *
  * Wanna B-Tree (WBT) On-Media-Format
  *
  * Supported versions:
+ *     v8: Added expiration times (KMD_EXPIRE_MARK prefix) to the KMD of
+ *         values put with a ttl, otherwise identical to v7.
+ *     v7: Added support for values packed into compressed blocks.  Uses a
+ *         new value type (vtype_bval), otherwise identical to v6.
  *     v6: Added support for compressed values. Uses a new value type
  *         (vtype_cval) which affects KMD format. Unfortunately,
  *         there is no version field for KMD, so we bump the WBTree
@@ -161,7 +212,7 @@ OMF_SETGET(struct bloom_hdr_omf, bh_n_hashes, 8)
 
 #define WBT_TREE_MAGIC ((u32)0x4a3a2a1a)
 
-/* WBT header (v6) */
+/* WBT header (v6, v7, v8) */
 struct wbt_hdr_omf {
     uint32_t wbt_magic;
     uint32_t wbt_version;
@@ -234,16 +285,56 @@ OMF_SETGET(struct wbt_lfe_omf, lfe_kmd, 16)
 
 #define VBLOCK_HDR_MAGIC ((u32)0xea73feed)
 
-/* Version 2 header */
+/* Compression algorithm of the compressed values in a vblock.
+ */
+#define VBLOCK_CALGO_LZ4  (0)
+#define VBLOCK_CALGO_ZSTD (1)
+
+/* Max length of the compression dictionary stored in a vblock header.
+ */
+#define VBLOCK_DICT_LEN_MAX (128 * 1024)
+
+/* Version 3 header
+ *
+ * Version 2 headers end at vbh_vgroup, all their compressed values are lz4,
+ * and their value data starts at PAGE_SIZE.
+ *
+ * In version 3 the compression dictionary (if any) immediately follows the
+ * header, and value data starts at the first page boundary at or after the
+ * end of the dictionary.
+ */
 struct vblock_hdr_omf {
     uint32_t vbh_magic;
     uint32_t vbh_version;
     uint64_t vbh_vgroup;
+    uint32_t vbh_calgo;
+    uint32_t vbh_dictlen;
 } HSE_PACKED;
 
 OMF_SETGET(struct vblock_hdr_omf, vbh_magic, 32)
 OMF_SETGET(struct vblock_hdr_omf, vbh_version, 32)
 OMF_SETGET(struct vblock_hdr_omf, vbh_vgroup, 64)
+OMF_SETGET(struct vblock_hdr_omf, vbh_calgo, 32)
+OMF_SETGET(struct vblock_hdr_omf, vbh_dictlen, 32)
+
+/* Compressed value block
+ *
+ * Small values may be packed into blocks that are compressed as a whole
+ * with the vblock's algorithm and dictionary.  Each block is stored in the
+ * vblock as this header followed by cbh_clen bytes of block data, which is
+ * stored uncompressed if cbh_clen equals cbh_rawlen.  Values in a block are
+ * referenced by the offset of the block within the vblock and the offset of
+ * the value within the uncompressed block (see vtype_bval).
+ */
+#define VBLOCK_CBLK_LEN_MAX (16 * 1024)
+
+struct vblock_cblk_omf {
+    uint32_t cbh_rawlen;
+    uint32_t cbh_clen;
+} HSE_PACKED;
+
+OMF_SETGET(struct vblock_cblk_omf, cbh_rawlen, 32)
+OMF_SETGET(struct vblock_cblk_omf, cbh_clen, 32)
 
 /* cn dynamic state
  */
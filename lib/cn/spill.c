@@ -9,6 +9,10 @@
 #include <hse_util/page.h>
 #include <hse_util/event_counter.h>
 #include <hse_util/logging.h>
+#include <hse_util/bin_heap.h>
+#include <hse_util/mutex.h>
+#include <hse_util/condvar.h>
+#include <hse_util/workqueue.h>
 
 #include <hse_ikvdb/kvs_cparams.h>
 #include <hse_ikvdb/kvs_rparams.h>
@@ -16,6 +20,7 @@
 #include <hse_ikvdb/tuple.h>
 #include <hse_ikvdb/kvset_builder.h>
 #include <hse_ikvdb/kvdb_perfc.h>
+#include <hse_ikvdb/cn.h>
 
 /* [HSE_REVISIT] - Why is this at the top of this file? */
 
@@ -32,6 +37,43 @@
 #include "cn_metrics.h"
 #include "kv_iterator.h"
 #include "blk_list.h"
+#include "cn_vcomp.h"
+#include "omf.h"
+
+/* A job is split into slices only if each slice would read at least this
+ * many bytes (see cn_spill_slices_init()).
+ */
+#define CN_SLICE_READSZ_MIN (256ul << 20)
+
+/**
+ * struct spill_slice - a key range slice of a spill or kv-compaction
+ * @ss_work:   compaction work
+ * @ss_inputv: input iterators, positioned at the start of the slice
+ * @ss_childv: output kvset builders, one for each child
+ * @ss_stats:  merge stats of the slice
+ * @ss_idx:    index of the slice
+ * @ss_end:    smallest key of the next slice (NULL for the last slice)
+ * @ss_endlen: length of @ss_end
+ * @ss_vblkc:  number of vblocks written for each child by the value pass
+ * @ss_err:    status of the last pass run on the slice
+ *
+ * An unsliced job is run as a single slice which uses the iterators,
+ * builders and merge stats of the compaction work struct.
+ */
+struct spill_slice {
+    struct cn_compaction_work *ss_work;
+    struct kv_iterator **      ss_inputv;
+    struct kvset_builder **    ss_childv;
+    struct cn_merge_stats *    ss_stats;
+    uint                       ss_idx;
+    const void *               ss_end;
+    uint                       ss_endlen;
+    uint                       ss_vblkc[CN_FANOUT_MAX];
+    merr_t                     ss_err;
+
+    struct kvset_builder *ss_child[CN_FANOUT_MAX];
+    struct cn_merge_stats ss_mstats;
+};
 
 /**
  * struct merge_item -- an item in the bin_heap
@@ -42,6 +84,27 @@ struct merge_item {
     uint                   src;
 };
 
+/**
+ * struct merge_src -- element source that feeds a merge input into the bin_heap
+ * @ms_es:    element source
+ * @ms_iter:  merge input
+ * @ms_stats: merge stats
+ * @ms_err:   error from the last read of @ms_iter
+ * @ms_item:  item most recently read from @ms_iter
+ */
+struct merge_src {
+    struct element_source  ms_es;
+    struct kv_iterator *   ms_iter;
+    struct cn_merge_stats *ms_stats;
+    merr_t                 ms_err;
+    struct merge_item      ms_item;
+};
+
+struct merge {
+    struct bin_heap2 *m_bh;
+    struct merge_src *m_srcv;
+};
+
 static int
 merge_item_compare(const void *a_blob, const void *b_blob)
 {
@@ -63,81 +126,116 @@ merge_item_compare(const void *a_blob, const void *b_blob)
     return 0;
 }
 
-static merr_t
-replenish(struct bin_heap *bh, struct kv_iterator **iterv, uint src, struct cn_merge_stats *stats)
+static u64
+merge_item_disc(const void *blob)
 {
-    struct kv_iterator *iter = iterv[src];
-    merr_t              err;
-    struct merge_item   item;
+    const struct merge_item *item = blob;
 
-    if (HSE_UNLIKELY(iter->kvi_eof))
-        return 0;
+    return key_obj_disc64(&item->kobj);
+}
 
-    err = kvset_iter_next_key(iter, &item.kobj, &item.vctx);
-    if (ev(err))
-        return err;
-    if (HSE_UNLIKELY(iter->kvi_eof))
-        return 0;
+static bool
+merge_src_next(struct element_source *es, void **element)
+{
+    struct merge_src * ms = container_of(es, struct merge_src, ms_es);
+    struct merge_item *item = &ms->ms_item;
 
-    item.src = src;
+    if (HSE_UNLIKELY(ms->ms_iter->kvi_eof))
+        return false;
 
-    err = bin_heap_insert(bh, &item);
-    if (ev(err))
-        return err;
+    ms->ms_err = kvset_iter_next_key(ms->ms_iter, &item->kobj, &item->vctx);
+    if (ev(ms->ms_err) || HSE_UNLIKELY(ms->ms_iter->kvi_eof))
+        return false;
 
-    stats->ms_keys_in++;
-    stats->ms_key_bytes_in += key_obj_len(&item.kobj);
+    ms->ms_stats->ms_keys_in++;
+    ms->ms_stats->ms_key_bytes_in += key_obj_len(&item->kobj);
 
-    return 0;
+    *element = item;
+
+    return true;
 }
 
 static merr_t
 merge_init(
-    struct bin_heap **     bh_out,
+    struct merge *         merge,
     struct kv_iterator **  iterv,
     u32                    iterc,
     struct cn_merge_stats *stats)
 {
-    u32    i;
-    merr_t err;
+    struct element_source **esv;
+    u32                     i;
+    merr_t                  err;
 
-    err = bin_heap_create(bh_out, iterc, sizeof(struct merge_item), merge_item_compare);
+    err = bin_heap2_create(iterc, merge_item_compare, &merge->m_bh);
     if (ev(err))
-        goto err_exit1;
+        return err;
+
+    bin_heap2_set_disc(merge->m_bh, merge_item_disc);
+
+    merge->m_srcv = malloc(iterc * (sizeof(*merge->m_srcv) + sizeof(*esv)));
+    if (ev(!merge->m_srcv)) {
+        err = merr(ENOMEM);
+        goto err_exit;
+    }
+
+    esv = (void *)(merge->m_srcv + iterc);
 
     stats->ms_srcs = iterc;
 
     for (i = 0; i < iterc; i++) {
-        err = replenish(*bh_out, iterv, i, stats);
-        if (ev(err))
-            goto err_exit2;
+        struct merge_src *ms = merge->m_srcv + i;
+
+        ms->ms_es = es_make(merge_src_next, NULL, NULL);
+        ms->ms_iter = iterv[i];
+        ms->ms_stats = stats;
+        ms->ms_err = 0;
+        ms->ms_item.src = i;
+        esv[i] = &ms->ms_es;
     }
 
+    err = bin_heap2_prepare(merge->m_bh, iterc, esv);
+
+    for (i = 0; i < iterc && !err; i++)
+        err = merge->m_srcv[i].ms_err;
+
+    if (ev(err))
+        goto err_exit;
+
     return 0;
 
-err_exit2:
-    bin_heap_destroy(*bh_out);
-err_exit1:
+err_exit:
+    free(merge->m_srcv);
+    bin_heap2_destroy(merge->m_bh);
     return err;
 }
 
+static void
+merge_fini(struct merge *merge)
+{
+    free(merge->m_srcv);
+    bin_heap2_destroy(merge->m_bh);
+}
+
 /* return true if item returned, false if no more items */
 static HSE_ALWAYS_INLINE bool
-get_next_item(
-    struct bin_heap *      bh,
-    struct kv_iterator **  iterv,
-    struct merge_item *    item,
-    struct cn_merge_stats *stats,
-    merr_t *               err_out)
+get_next_item(struct merge *merge, struct merge_item *item, merr_t *err_out)
 {
-    bool got_item;
-
-    got_item = bin_heap_get_delete(bh, item);
-    if (got_item)
-        *err_out = replenish(bh, iterv, item->src, stats);
-    else
-        *err_out = 0;
-    return got_item;
+    struct merge_item *top;
+
+    *err_out = 0;
+
+    if (!bin_heap2_peek(merge->m_bh, (void **)&top))
+        return false;
+
+    /* Copy out the item before bin_heap2_pop() overwrites it with the
+     * source's next item.
+     */
+    *item = *top;
+    bin_heap2_pop(merge->m_bh, (void **)&top);
+
+    *err_out = merge->m_srcv[item->src].ms_err;
+
+    return true;
 }
 
 static merr_t
@@ -180,16 +278,105 @@ kv_spill_abort(struct cn_tstate_omf *omf, void *arg)
 {
 }
 
+/* A compressed value is copied to the output as is only if it was
+ * compressed with the same algorithm and dictionary that the output's
+ * vblocks will record, otherwise it is decompressed here (and then
+ * recompressed by the kvset builder if the output is compressed).
+ */
+static merr_t
+kv_spill_transcode(
+    struct cn_compaction_work *w,
+    struct kv_iterator *       iter,
+    uint                       vbidx,
+    const void **              vdata,
+    uint                       vlen,
+    uint *                     complen,
+    void **                    bufp,
+    uint *                     bufszp)
+{
+    const struct cn_vcomp *vc = w->cw_vcomp;
+    uint                   calgo, dictid, outlen;
+    merr_t                 err;
+
+    kvset_iter_vblock_comp(iter, vbidx, &calgo, &dictid);
+
+    if (vc ? (calgo == vc->cv_calgo && dictid == vc->cv_dictid) : (calgo == VBLOCK_CALGO_LZ4))
+        return 0;
+
+    if (vlen > *bufszp) {
+        uint  sz = ALIGN(vlen, PAGE_SIZE);
+        void *buf;
+
+        buf = malloc(sz);
+        if (ev(!buf))
+            return merr(ENOMEM);
+
+        free(*bufp);
+        *bufp = buf;
+        *bufszp = sz;
+    }
+
+    err = kvset_iter_val_decompress(iter, vbidx, *vdata, *complen, *bufp, vlen, &outlen);
+    if (ev(err))
+        return err;
+
+    if (ev(outlen != vlen))
+        return merr(EBUG);
+
+    *vdata = *bufp;
+    *complen = 0;
+
+    return 0;
+}
+
+/* Add a value to the dictionary training samples (best effort).  Only
+ * values that would be compressed and are not too large are sampled.
+ */
+static void
+kv_spill_sample(
+    struct cn_vcomp_samples *samples,
+    struct kv_iterator *     iter,
+    uint                     vbidx,
+    const void *             vdata,
+    uint                     vlen,
+    uint                     complen)
+{
+    uint  outlen;
+    void *dst;
+
+    if (vlen <= CN_SMALL_VALUE_THRESHOLD || vlen > CN_VCOMP_SAMPLE_LEN_MAX)
+        return;
+
+    dst = cn_vcomp_samples_reserve(samples, vlen);
+    if (!dst)
+        return;
+
+    if (complen > 0) {
+        if (kvset_iter_val_decompress(iter, vbidx, vdata, complen, dst, vlen, &outlen))
+            return;
+
+        if (outlen != vlen)
+            return;
+    } else {
+        memcpy(dst, vdata, vlen);
+    }
+
+    cn_vcomp_samples_add(samples, vlen);
+}
+
 /**
  * kv_spill() - merge key-value streams, then partition by child
+ * @w:  compaction work
+ * @ss: the key range slice of @w to merge (possibly all of it)
+ *
  * Requirements:
  *   - Each input iterator must produce keys in sorted order.
  *   - Iterator iterv[i] must contain newer entries than iterv[i+1].
  */
 static merr_t
-kv_spill(struct cn_compaction_work *w)
+kv_spill(struct cn_compaction_work *w, struct spill_slice *ss)
 {
-    struct bin_heap *     bh;
+    struct merge          merge;
     struct merge_item     curr;
     merr_t                err;
     struct kvset_builder *child;
@@ -202,6 +389,10 @@ kv_spill(struct cn_compaction_work *w)
     u32   childmask; /* mask: which children get kvpairs */
     void *buf = NULL;
     u32   bufsz = 0;
+    void *vbuf = NULL;
+    uint  vbufsz = 0;
+
+    struct cn_vcomp_samples *samples;
 
     struct cn_khashmap *khashmap = NULL;
 
@@ -210,6 +401,7 @@ kv_spill(struct cn_compaction_work *w)
     uint curr_klen;
 
     struct key_obj prev_kobj;
+    struct key_obj end_kobj;
 
     /* pt_kobj is set to a prefix that can annihilate keys - i.e. it has a
      * seqno <= horizon
@@ -217,6 +409,7 @@ kv_spill(struct cn_compaction_work *w)
     struct key_obj pt_kobj = { 0 };
     bool           pt_set = false;
     u64            pt_seq = 0;
+    u64            rt_seq = 0;
     u32            pt_spread; /* mask: which children get ptomb */
 
     uint   seqno_errcnt = 0;
@@ -230,14 +423,28 @@ kv_spill(struct cn_compaction_work *w)
     uint dbg_nvals_this_key HSE_MAYBE_UNUSED;
     bool dbg_dup HSE_MAYBE_UNUSED;
 
-    if (w->cw_prog_interval && w->cw_progress)
+    /* Progress is reported only by the first slice, whose merge stats
+     * are those of the compaction work.
+     */
+    if (w->cw_prog_interval && w->cw_progress && ss->ss_stats == &w->cw_stats)
         tprog = jiffies;
 
-    err = merge_init(&bh, w->cw_inputv, w->cw_kvset_cnt, &w->cw_stats);
+    if (ss->ss_end)
+        key2kobj(&end_kobj, ss->ss_end, ss->ss_endlen);
+
+    /* Only the first slice collects dictionary training samples, and
+     * not again if it is merged a second time (see spill_slice_keys()).
+     */
+    samples = ss->ss_stats == &w->cw_stats ? w->cw_samples : NULL;
+
+    err = merge_init(&merge, ss->ss_inputv, w->cw_kvset_cnt, ss->ss_stats);
     if (ev(err))
         return err;
 
-    more = get_next_item(bh, w->cw_inputv, &curr, &w->cw_stats, &err);
+    more = get_next_item(&merge, &curr, &err);
+    if (ss->ss_end && more && key_obj_cmp(&curr.kobj, &end_kobj) >= 0)
+        more = false;
+
     if (!more || ev(err))
         goto done;
 
@@ -309,7 +516,10 @@ new_key:
     }
 
     cnum &= (w->cw_outc - 1);
-    child = w->cw_child[cnum];
+    child = ss->ss_childv[cnum];
+
+    if (w->cw_rtombc)
+        rt_seq = rtomb_seqno(w->cw_rtombv, w->cw_rtombc, &curr.kobj, w->cw_horizon);
 
     bg_val = false;
     emitted_val = false;
@@ -335,10 +545,23 @@ get_values:
             tstart = get_time_ns();
 
         if (!kvset_iter_next_vref(
-                w->cw_inputv[curr.src], &curr.vctx, &seq, &vtype, &vbidx, &vboff,
+                ss->ss_inputv[curr.src], &curr.vctx, &seq, &vtype, &vbidx, &vboff,
                 &vdata, &vlen, &complen))
             break;
 
+        /* Values hidden by a ptomb or range tombstone are dropped on
+         * their seqno alone, before paying to read them.
+         */
+        bg_val = (seq <= w->cw_horizon);
+
+        if (bg_val) {
+            if (pt_set && seq < pt_seq)
+                break; /* drop val */
+
+            if (seq < rt_seq && vtype != vtype_ptomb)
+                break; /* hidden by a range tombstone */
+        }
+
         if (vtype == vtype_val)
             omlen = vlen;
         else if (vtype == vtype_cval)
@@ -392,11 +615,11 @@ get_values:
             }
 
             err = kvset_iter_next_val_direct(
-                w->cw_inputv[curr.src], vtype, vbidx, vboff, buf, omlen, bufsz);
+                ss->ss_inputv[curr.src], vtype, vbidx, vboff, buf, omlen, bufsz);
             vdata = buf;
         } else {
             err = kvset_iter_next_val(
-                w->cw_inputv[curr.src], &curr.vctx, vtype, vbidx, vboff, &vdata, &vlen, &complen);
+                ss->ss_inputv[curr.src], &curr.vctx, vtype, vbidx, vboff, &vdata, &vlen, &complen);
         }
         if (ev(err))
             goto done;
@@ -424,17 +647,10 @@ get_values:
         dbg_nvals_this_key++;
         dbg_prev_seq = seq;
 
-        bg_val = (seq <= w->cw_horizon);
-
-        if (bg_val) {
-            if (pt_set && seq < pt_seq)
-                break; /* drop val */
-
-            if (HSE_CORE_IS_PTOMB(vdata)) {
-                pt_set = true;
-                pt_kobj = curr.kobj;
-                pt_seq = seq;
-            }
+        if (bg_val && HSE_CORE_IS_PTOMB(vdata)) {
+            pt_set = true;
+            pt_kobj = curr.kobj;
+            pt_seq = seq;
         }
 
         if (HSE_CORE_IS_PTOMB(vdata))
@@ -459,7 +675,7 @@ get_values:
                     if (w->cw_drop_tombv[i] && bg_val)
                         continue;
 
-                    err = kvset_builder_add_val(w->cw_child[i], seq, vdata, vlen, 0);
+                    err = kvset_builder_add_val(ss->ss_childv[i], seq, vdata, vlen, 0);
                     if (ev(err))
                         goto done;
 
@@ -471,11 +687,27 @@ get_values:
                 if (w->cw_drop_tombv[cnum] && HSE_CORE_IS_TOMB(vdata) && bg_val)
                     continue; /* skip value */
 
+                if (samples && !cn_vcomp_samples_full(samples) && !HSE_CORE_IS_TOMB(vdata))
+                    kv_spill_sample(samples, ss->ss_inputv[curr.src], vbidx, vdata, vlen, complen);
+
+                if (complen > 0) {
+                    err = kv_spill_transcode(w, ss->ss_inputv[curr.src], vbidx, &vdata, vlen,
+                                             &complen, &vbuf, &vbufsz);
+                    if (ev(err))
+                        goto done;
+                }
+
+                if (curr.vctx.expire) {
+                    err = kvset_builder_add_expire(child, curr.vctx.expire);
+                    if (ev(err))
+                        goto done;
+                }
+
                 err = kvset_builder_add_val(child, seq, vdata, vlen, complen);
                 if (ev(err))
                     goto done;
 
-                w->cw_stats.ms_val_bytes_out += complen ? complen : vlen;
+                ss->ss_stats->ms_val_bytes_out += complen ? complen : vlen;
                 emitted_val = true;
                 childmask |= (1 << cnum);
                 if (HSE_CORE_IS_PTOMB(vdata))
@@ -520,10 +752,16 @@ get_values:
     dbg_nvals_this_key = 0;
     dbg_prev_src = curr.src;
 
-    more = get_next_item(bh, w->cw_inputv, &curr, &w->cw_stats, &err);
+    more = get_next_item(&merge, &curr, &err);
     if (ev(err))
         goto done;
 
+    /* The slice ends at the first key of the next slice.  All the values
+     * of a key reside in one slice as the pivots are whole keys.
+     */
+    if (ss->ss_end && more && key_obj_cmp(&curr.kobj, &end_kobj) >= 0)
+        more = false;
+
     if (more) {
         if (0 == key_obj_cmp(&curr.kobj, &prev_kobj)) {
             dbg_dup = true;
@@ -544,12 +782,12 @@ get_values:
                 if ((spillmask & (1 << i)) == 0)
                     continue;
 
-                err = kvset_builder_add_key(w->cw_child[i], &prev_kobj);
+                err = kvset_builder_add_key(ss->ss_childv[i], &prev_kobj);
                 if (ev(err))
                     goto done;
 
-                w->cw_stats.ms_keys_out++;
-                w->cw_stats.ms_key_bytes_out += key_obj_len(&prev_kobj);
+                ss->ss_stats->ms_keys_out++;
+                ss->ss_stats->ms_key_bytes_out += key_obj_len(&prev_kobj);
             }
 
         } else {
@@ -557,8 +795,8 @@ get_values:
             if (ev(err))
                 goto done;
 
-            w->cw_stats.ms_keys_out++;
-            w->cw_stats.ms_key_bytes_out += key_obj_len(&prev_kobj);
+            ss->ss_stats->ms_keys_out++;
+            ss->ss_stats->ms_key_bytes_out += key_obj_len(&prev_kobj);
         }
     }
 
@@ -566,28 +804,9 @@ get_values:
         goto new_key;
 
 done:
-    bin_heap_destroy(bh);
+    merge_fini(&merge);
     free_aligned(buf);
-
-    /* We must ensure the latest version of the key hash map is persisted
-     * if it changed while we were using it (regardless of who changed it,
-     * and especially if we changed it, regardless of error).
-     */
-    if (khashmap) {
-        merr_t err2;
-        bool   update;
-
-        spin_lock(&khashmap->khm_lock);
-        update = (khashmap->khm_gen > khashmap->khm_gen_committed);
-        spin_unlock(&khashmap->khm_lock);
-
-        if (update) {
-            struct cn_tstate *ts = w->cw_tree->ct_tstate;
-
-            err2 = ts->ts_update(ts, kv_spill_prepare, kv_spill_commit, kv_spill_abort, w->cw_tree);
-            err = err ?: err2;
-        }
-    }
+    free(vbuf);
 
     if (seqno_errcnt)
         log_warn("seqno errcnt %u", seqno_errcnt);
@@ -598,58 +817,602 @@ done:
     return err;
 }
 
+/* We must ensure the latest version of the key hash map is persisted
+ * if it changed while we were using it (regardless of who changed it,
+ * and especially if we changed it, regardless of error).
+ */
+merr_t
+cn_spill_khashmap_update(struct cn_tree *tree)
+{
+    struct cn_khashmap *khashmap;
+    struct cn_tstate *  ts;
+    bool                update;
+
+    khashmap = cn_tree_get_khashmap(tree);
+    if (!khashmap)
+        return 0;
+
+    spin_lock(&khashmap->khm_lock);
+    update = (khashmap->khm_gen > khashmap->khm_gen_committed);
+    spin_unlock(&khashmap->khm_lock);
+
+    if (!update)
+        return 0;
+
+    ts = tree->ct_tstate;
+
+    return ts->ts_update(ts, kv_spill_prepare, kv_spill_commit, kv_spill_abort, tree);
+}
+
 static inline bool
 is_spill_to_intnode(struct cn_tree_node *pnode, u32 child)
 {
     return pnode->tn_childv[child] && !cn_node_isleaf(pnode->tn_childv[child]);
 }
 
-merr_t
-cn_spill(struct cn_compaction_work *w)
+static merr_t
+cn_spill_builder_create(
+    struct cn_compaction_work *w,
+    uint                       child,
+    struct cn_merge_stats *    stats,
+    struct kvset_builder **    bldp)
 {
-    merr_t err;
-    uint   i;
+    struct cn_tree_node *pnode;
+    merr_t               err;
 
-    assert(w->cw_kvset_cnt);
-    assert(w->cw_inputv);
+    err = kvset_builder_create(bldp, cn_tree_get_cn(w->cw_tree), w->cw_pc, w->cw_dgen_hi);
+    if (ev(err))
+        return err;
 
-    memset(w->cw_outv, 0, w->cw_outc * sizeof(*w->cw_outv));
+    kvset_builder_set_merge_stats(*bldp, stats);
+    kvset_builder_set_iogov(*bldp, w->cw_iogov, w->cw_iocls);
+
+    err = kvset_builder_set_vcomp(*bldp, w->cw_vcomp);
+    if (ev(err))
+        return err;
+
+    pnode = w->cw_node;
+    if (pnode && w->cw_action == CN_ACTION_SPILL) {
+        if (is_spill_to_intnode(pnode, child))
+            kvset_builder_set_agegroup(*bldp, HSE_MPOLICY_AGE_INTERNAL);
+        else
+            kvset_builder_set_agegroup(*bldp, HSE_MPOLICY_AGE_LEAF);
+    }
+
+    if (pnode && w->cw_action == CN_ACTION_COMPACT_KV) {
+        if (cn_node_isleaf(pnode))
+            kvset_builder_set_agegroup(*bldp, HSE_MPOLICY_AGE_LEAF);
+        else if (cn_node_isroot(pnode))
+            kvset_builder_set_agegroup(*bldp, HSE_MPOLICY_AGE_ROOT);
+        else
+            kvset_builder_set_agegroup(*bldp, HSE_MPOLICY_AGE_INTERNAL);
+    }
+
+    return 0;
+}
+
+void
+cn_spill_slices_init(struct cn_compaction_work *w)
+{
+    struct kvset_list_entry *le;
+    struct kvset *           ks = NULL;
+    uint                     slices, kblkc, i;
+
+    w->cw_slicec = 1;
+
+    if (w->cw_action != CN_ACTION_SPILL && w->cw_action != CN_ACTION_COMPACT_KV)
+        return;
+
+    if (!cn_get_slice_wq(cn_tree_get_cn(w->cw_tree), &slices) || slices < 2)
+        return;
+
+    slices = min_t(u64, slices, max_t(s64, w->cw_est.cwe_read_sz, 0) / CN_SLICE_READSZ_MIN);
+    if (slices < 2)
+        return;
+
+    /* The marked kvsets are adjacent and stable (see
+     * cn_tree_prepare_compaction()).
+     */
+    kblkc = 0;
+
+    for (i = 0, le = w->cw_mark; i < w->cw_kvset_cnt; i++, le = list_prev_entry(le, le_link)) {
+        const struct rtomb *rtv;
+
+        /* Range tombstones are added to each child's builder after the
+         * merge, which a partitioned build doesn't allow.
+         */
+        if (kvset_pt_start(le->le_kvset) >= 0 || kvset_get_rtombs(le->le_kvset, &rtv) > 0)
+            return;
+
+        if (kvset_get_num_kblocks(le->le_kvset) > kblkc) {
+            ks = le->le_kvset;
+            kblkc = kvset_get_num_kblocks(ks);
+        }
+    }
+
+    slices = min_t(uint, slices, kblkc);
+    if (slices < 2)
+        return;
+
+    memset(w->cw_pivotv, 0, sizeof(w->cw_pivotv));
+
+    /* The smallest keys of distinct kblocks of one kvset are distinct
+     * and ascending, and hence so are the pivots.
+     */
+    for (i = 1; i < slices; ++i) {
+        struct cn_slice_pivot *pivot = w->cw_pivotv + i;
+
+        kvset_get_nth_kblock_min_key(ks, (kblkc * i) / slices, &pivot->sp_key, &pivot->sp_klen);
+        if (!pivot->sp_key)
+            return;
+    }
+
+    w->cw_slicec = slices;
+}
+
+/* Create the iterators of a slice and position them at its first key.  In
+ * the value pass the first slice uses the iterators of the compaction work
+ * instead.  Seeking requires mcache maps, so unlike the iterators of the
+ * compaction work these never read mblocks via the cn io workqueue (vblock
+ * readahead via mcache still applies).
+ */
+static merr_t
+spill_slice_iterv_create(struct spill_slice *ss)
+{
+    struct cn_compaction_work *  w = ss->ss_work;
+    const struct cn_slice_pivot *pivot = w->cw_pivotv + ss->ss_idx;
+    struct workqueue_struct *    vra_wq;
+    struct kvset_list_entry *    le;
+    struct kv_iterator **        iterv;
+    merr_t                       err = 0;
+    uint                         i;
+
+    assert(ss->ss_idx == 0 || pivot->sp_key);
+
+    iterv = calloc(w->cw_kvset_cnt, sizeof(*iterv));
+    if (ev(!iterv))
+        return merr(ENOMEM);
+
+    ss->ss_inputv = iterv;
+    vra_wq = cn_get_maint_wq(cn_tree_get_cn(w->cw_tree));
+
+    for (i = 0, le = w->cw_mark; i < w->cw_kvset_cnt; i++, le = list_prev_entry(le, le_link)) {
+        struct kv_iterator **iter = &iterv[w->cw_kvset_cnt - 1 - i];
+        bool                 eof;
+
+        /* If successful, kvset_iter_create() adopts this reference.
+         */
+        kvset_get_ref(le->le_kvset);
+
+        err = kvset_iter_create(le->le_kvset, NULL, vra_wq, w->cw_pc,
+                                w->cw_iter_flags | kvset_iter_flag_mcache, iter);
+        if (ev(err)) {
+            kvset_put_ref(le->le_kvset);
+            break;
+        }
+
+        kvset_iter_set_stats(*iter, ss->ss_stats);
+        kvset_iter_set_iogov(*iter, w->cw_iogov, w->cw_iocls);
+        kvset_iter_set_now(*iter, w->cw_now);
+
+        if (ss->ss_idx == 0)
+            continue;
+
+        err = kvset_iter_seek(*iter, pivot->sp_key, pivot->sp_klen, &eof);
+        if (ev(err))
+            break;
+    }
+
+    return err;
+}
+
+static void
+spill_slice_iterv_destroy(struct spill_slice *ss)
+{
+    struct cn_compaction_work *w = ss->ss_work;
+    uint                       i;
+
+    if (!ss->ss_inputv || ss->ss_inputv == w->cw_inputv)
+        return;
+
+    for (i = 0; i < w->cw_kvset_cnt; i++) {
+        if (ss->ss_inputv[i])
+            ss->ss_inputv[i]->kvi_ops->kvi_release(ss->ss_inputv[i]);
+    }
+
+    free(ss->ss_inputv);
+    ss->ss_inputv = NULL;
+}
+
+typedef merr_t
+spill_slice_fn(struct spill_slice *ss);
+
+/* First pass: Merge the slice's inputs, which writes each child's vblocks
+ * and retains the rest of each child's entries in memory.
+ */
+static merr_t
+spill_slice_values(struct spill_slice *ss)
+{
+    struct cn_compaction_work *w = ss->ss_work;
+    merr_t                     err = 0;
+    uint                       i;
+
+    if (!ss->ss_inputv) {
+        err = spill_slice_iterv_create(ss);
+        if (ev(err))
+            goto out;
+    }
 
     for (i = 0; i < w->cw_outc; i++) {
-        struct cn_tree_node *pnode;
+        err = cn_spill_builder_create(w, i, ss->ss_stats, &ss->ss_child[i]);
+        if (ev(err))
+            goto out;
+
+        kvset_builder_part_begin(ss->ss_child[i]);
+        kvset_builder_part_log(ss->ss_child[i]);
+    }
+
+    err = kv_spill(w, ss);
+    if (ev(err))
+        goto out;
 
-        err = kvset_builder_create(
-            &w->cw_child[i],
-            cn_tree_get_cn(w->cw_tree),
-            w->cw_pc,
-            w->cw_dgen_hi);
+    for (i = 0; i < w->cw_outc; i++) {
+        err = kvset_builder_part_vblocks(ss->ss_child[i], &ss->ss_vblkc[i]);
         if (ev(err))
-            goto done;
+            break;
+    }
+
+out:
+    spill_slice_iterv_destroy(ss);
+
+    return err;
+}
+
+/* Second pass: Build each child's kblocks from the retained entries.  If
+ * any child's log was discarded for being too large, merge the slice's
+ * inputs again instead, which feeds all its children.  The value pass has
+ * already accounted for the slice in the merge stats.
+ */
+static merr_t
+spill_slice_keys(struct spill_slice *ss)
+{
+    struct cn_compaction_work *w = ss->ss_work;
+    struct cn_merge_stats *    stats = ss->ss_stats;
+    struct cn_merge_stats      mstats;
+    merr_t                     err;
+    uint                       i;
+
+    for (i = 0; i < w->cw_outc; i++) {
+        if (!kvset_builder_part_logged(ss->ss_child[i]))
+            break;
+    }
+
+    if (i < w->cw_outc) {
+        for (i = 0; i < w->cw_outc; i++)
+            kvset_builder_part_unlog(ss->ss_child[i]);
+
+        memset(&mstats, 0, sizeof(mstats));
+        ss->ss_stats = &mstats;
+        ss->ss_inputv = NULL;
+
+        err = spill_slice_iterv_create(ss);
+        if (!err)
+            err = kv_spill(w, ss);
+
+        spill_slice_iterv_destroy(ss);
+        ss->ss_stats = stats;
+
+        return err;
+    }
+
+    for (i = 0; i < w->cw_outc; i++) {
+        err = kvset_builder_part_replay(ss->ss_child[i]);
+        if (ev(err))
+            return err;
+    }
+
+    return 0;
+}
+
+/**
+ * struct spill_runner - runs a pass over all the slices of a job in parallel
+ * @sr_slicev:   slices of the job
+ * @sr_slicec:   number of slices in @sr_slicev
+ * @sr_func:     pass to apply to each slice
+ * @sr_next:     index of next slice to run
+ * @sr_helpers:  number of helper threads that have yet to finish
+ * @sr_lock:     protects sr_helpers
+ * @sr_cv:       signaled when sr_helpers drops to zero
+ */
+struct spill_runner {
+    struct spill_slice *sr_slicev;
+    uint                sr_slicec;
+    spill_slice_fn *    sr_func;
+    atomic_uint         sr_next;
+    uint                sr_helpers;
+    struct mutex        sr_lock;
+    struct cv           sr_cv;
+};
+
+struct spill_helper {
+    struct work_struct   sh_work;
+    struct spill_runner *sh_runner;
+};
+
+static void
+spill_runner_run(struct spill_runner *r)
+{
+    uint i;
+
+    while ((i = atomic_inc_return(&r->sr_next) - 1) < r->sr_slicec) {
+        struct spill_slice *ss = r->sr_slicev + i;
+
+        ss->ss_err = r->sr_func(ss);
+    }
+}
+
+static void
+spill_helper(struct work_struct *work)
+{
+    struct spill_helper *h = container_of(work, struct spill_helper, sh_work);
+    struct spill_runner *r = h->sh_runner;
+
+    spill_runner_run(r);
+
+    mutex_lock(&r->sr_lock);
+    if (--r->sr_helpers == 0)
+        cv_signal(&r->sr_cv);
+    mutex_unlock(&r->sr_lock);
+}
+
+/**
+ * spill_slices_run() - apply func to all the slices of a job
+ *
+ * The compaction thread runs slices itself while up to (slicec - 1)
+ * helpers from the cn slice workqueue run the rest, such that progress
+ * never depends upon the availability of helpers.
+ */
+static merr_t
+spill_slices_run(
+    struct cn_compaction_work *w,
+    struct spill_slice *       slicev,
+    uint                       slicec,
+    spill_slice_fn *           func)
+{
+    struct spill_helper      helperv[HSE_CN_COMPACTION_SLICES_MAX - 1];
+    struct workqueue_struct *wq;
+    struct spill_runner      r;
+    uint                     helperc, slices, i;
+
+    wq = cn_get_slice_wq(cn_tree_get_cn(w->cw_tree), &slices);
+
+    helperc = min_t(uint, slicec, NELEM(helperv) + 1) - 1;
+    if (!wq)
+        helperc = 0;
+
+    r.sr_slicev = slicev;
+    r.sr_slicec = slicec;
+    r.sr_func = func;
+    r.sr_helpers = helperc;
+    atomic_set(&r.sr_next, 0);
+    mutex_init(&r.sr_lock);
+    cv_init(&r.sr_cv, "spill_runner");
+
+    for (i = 0; i < helperc; ++i) {
+        helperv[i].sh_runner = &r;
+        INIT_WORK(&helperv[i].sh_work, spill_helper);
+        queue_work(wq, &helperv[i].sh_work);
+    }
+
+    spill_runner_run(&r);
+
+    mutex_lock(&r.sr_lock);
+    while (r.sr_helpers > 0)
+        cv_wait(&r.sr_cv, &r.sr_lock);
+    mutex_unlock(&r.sr_lock);
+
+    cv_destroy(&r.sr_cv);
+    mutex_destroy(&r.sr_lock);
+
+    for (i = 0; i < slicec; ++i) {
+        if (slicev[i].ss_err)
+            return slicev[i].ss_err;
+    }
+
+    return 0;
+}
+
+/**
+ * cn_spill_sliced() - merge the key range slices of a job in parallel
+ *
+ * Each child still gets exactly one kvset, committed through the usual
+ * single cndb transaction, so the slices of each child are joined via
+ * a partitioned kvset build (see kvset_builder_part_begin()):
+ *
+ *  - The value pass merges each slice, writes the slice's vblocks for
+ *    each child and retains the rest of each child's entries in memory
+ *    (so the input is normally read only once).
+ *  - The key pass builds each slice's kblocks for each child from the
+ *    retained entries, with vblock indices rebased onto the child's
+ *    vblock list.  A slice whose retained entries outgrew the log limit
+ *    is merged again instead.
+ *  - kvset_builder_join() assembles each child's kvset.
+ */
+static merr_t
+cn_spill_sliced(struct cn_compaction_work *w)
+{
+    struct kvset_builder *bldv[HSE_CN_COMPACTION_SLICES_MAX];
+    struct spill_slice *  slicev;
+    uint                  slicec = w->cw_slicec;
+    uint                  i, j, vbidx;
+    merr_t                err;
+
+    assert(slicec > 1 && slicec <= NELEM(bldv));
+
+    slicev = calloc(slicec, sizeof(*slicev));
+    if (ev(!slicev))
+        return merr(ENOMEM);
 
-        kvset_builder_set_merge_stats(w->cw_child[i], &w->cw_stats);
+    for (i = 0; i < slicec; i++) {
+        struct spill_slice *ss = slicev + i;
 
-        pnode = w->cw_node;
-        if (pnode && w->cw_action == CN_ACTION_SPILL) {
-            if (is_spill_to_intnode(pnode, i))
-                kvset_builder_set_agegroup(w->cw_child[i], HSE_MPOLICY_AGE_INTERNAL);
-            else
-                kvset_builder_set_agegroup(w->cw_child[i], HSE_MPOLICY_AGE_LEAF);
+        ss->ss_work = w;
+        ss->ss_idx = i;
+        ss->ss_childv = ss->ss_child;
+        ss->ss_inputv = i > 0 ? NULL : w->cw_inputv;
+        ss->ss_stats = i > 0 ? &ss->ss_mstats : &w->cw_stats;
+
+        if (i + 1 < slicec) {
+            ss->ss_end = w->cw_pivotv[i + 1].sp_key;
+            ss->ss_endlen = w->cw_pivotv[i + 1].sp_klen;
         }
+    }
 
-        if (pnode && w->cw_action == CN_ACTION_COMPACT_KV) {
-            if (cn_node_isleaf(pnode))
-                kvset_builder_set_agegroup(w->cw_child[i], HSE_MPOLICY_AGE_LEAF);
-            else if (cn_node_isroot(pnode))
-                kvset_builder_set_agegroup(w->cw_child[i], HSE_MPOLICY_AGE_ROOT);
-            else
-                kvset_builder_set_agegroup(w->cw_child[i], HSE_MPOLICY_AGE_INTERNAL);
+    err = spill_slices_run(w, slicev, slicec, spill_slice_values);
+    if (ev(err))
+        goto done;
+
+    for (j = 0; j < w->cw_outc; j++) {
+        for (i = vbidx = 0; i < slicec; i++) {
+            kvset_builder_part_rebase(slicev[i].ss_child[j], vbidx);
+            vbidx += slicev[i].ss_vblkc[j];
         }
     }
 
-    err = kv_spill(w);
+    err = spill_slices_run(w, slicev, slicec, spill_slice_keys);
+    if (ev(err))
+        goto done;
+
+    for (j = 0; j < w->cw_outc; j++) {
+        for (i = 0; i < slicec; i++)
+            bldv[i] = slicev[i].ss_child[j];
+
+        err = kvset_builder_join(bldv, slicec, &w->cw_outv[j]);
+        if (ev(err))
+            break;
+    }
+
+    if (err) {
+        while (j-- > 0) {
+            abort_mblocks(w->cw_ds, &w->cw_outv[j].kblks);
+            abort_mblocks(w->cw_ds, &w->cw_outv[j].vblks);
+        }
+        memset(w->cw_outv, 0, w->cw_outc * sizeof(*w->cw_outv));
+    }
+
+done:
+    /* Applies to success and failure paths */
+    for (i = 0; i < slicec; i++) {
+        for (j = 0; j < w->cw_outc; j++)
+            kvset_builder_destroy(slicev[i].ss_child[j]);
+
+        if (i > 0)
+            cn_merge_stats_add(&w->cw_stats, &slicev[i].ss_mstats);
+    }
+
+    free(slicev);
+
+    return err;
+}
+
+/* Keys are routed to children by the hash of their prefix (or of their
+ * whole key, less the suffix, if cw_pfx_len is zero), so in general any
+ * child may hold keys covered by a range tombstone.  But if the tombstone's
+ * start and end keys share a prefix, then so do all the keys it covers,
+ * all of which reside in the subtree of that prefix's child.
+ *
+ * Return the index of that child, or -1 if the tombstone must be given
+ * to all the children.
+ */
+static int
+spill_rtomb_child(struct cn_compaction_work *w, const struct rtomb *rt)
+{
+    struct cn_khashmap *khashmap;
+    struct key_obj      kobj;
+    uint                pfxlen = w->cw_pfx_len;
+    uint                cnum;
+    u64                 hash;
+
+    if (w->cw_outc == 1)
+        return 0;
+
+    if (!pfxlen || rt->rt_slen < pfxlen || rt->rt_elen < pfxlen ||
+        memcmp(rt->rt_start, rt->rt_end, pfxlen))
+        return -1;
+
+    key2kobj(&kobj, rt->rt_start, pfxlen);
+    hash = pfx_obj_hash64(&kobj, pfxlen);
+
+    /* A prefix whose key hash map entry is unassigned never reached a
+     * child.  Play it safe rather than rely upon that.
+     */
+    khashmap = cn_tree_get_khashmap(w->cw_tree);
+    if (khashmap) {
+        cnum = khashmap->khm_mapv[(hash >> w->cw_hash_shift) % CN_TSTATE_KHM_SZ];
+        if (!cnum)
+            return -1;
+    } else {
+        cnum = hash >> w->cw_hash_shift;
+    }
+
+    return cnum & (w->cw_outc - 1);
+}
+
+static merr_t
+cn_spill_merge(struct cn_compaction_work *w)
+{
+    struct spill_slice ss = {};
+    merr_t             err, err2;
+    uint               i;
+
+    assert(w->cw_kvset_cnt);
+    assert(w->cw_inputv);
+
+    memset(w->cw_outv, 0, w->cw_outc * sizeof(*w->cw_outv));
+
+    if (w->cw_slicec > 1) {
+        err = cn_spill_sliced(w);
+        err2 = cn_spill_khashmap_update(w->cw_tree);
+
+        return err ?: err2;
+    }
+
+    for (i = 0; i < w->cw_outc; i++) {
+        err = cn_spill_builder_create(w, i, &w->cw_stats, &w->cw_child[i]);
+        if (ev(err))
+            goto done;
+    }
+
+    ss.ss_work = w;
+    ss.ss_inputv = w->cw_inputv;
+    ss.ss_childv = w->cw_child;
+    ss.ss_stats = &w->cw_stats;
+
+    err = kv_spill(w, &ss);
+    err2 = cn_spill_khashmap_update(w->cw_tree);
+    err = err ?: err2;
     if (ev(err))
         goto done;
 
+    for (i = 0; i < w->cw_outc; i++) {
+        uint j;
+
+        for (j = 0; j < w->cw_rtombc; j++) {
+            int cnum;
+
+            if (w->cw_drop_tombv[i] && w->cw_rtombv[j].rt_seqno <= w->cw_horizon)
+                continue;
+
+            cnum = spill_rtomb_child(w, w->cw_rtombv + j);
+            if (cnum >= 0 && cnum != i)
+                continue;
+
+            err = kvset_builder_add_rtomb(w->cw_child[i], w->cw_rtombv + j);
+            if (ev(err))
+                goto done;
+        }
+    }
+
     /* Get each child's output mblocks */
     for (i = 0; i < w->cw_outc; i++) {
         err = kvset_builder_get_mblocks(w->cw_child[i], &w->cw_outv[i]);
@@ -672,3 +1435,60 @@ done:
 
     return err;
 }
+
+/* Train a dictionary from the samples collected by the job, provided
+ * the job succeeded and collected a full set of samples (otherwise the
+ * next job will try again).
+ */
+static void
+cn_spill_train(struct cn_compaction_work *w, struct cn *cn, merr_t err)
+{
+    struct cn_vcomp *vc = NULL;
+    bool             tried = false;
+
+    if (!err && cn_vcomp_samples_full(w->cw_samples)) {
+        tried = true;
+
+        err = cn_vcomp_train(w->cw_vcomp, w->cw_samples, w->cw_rp->cn_vcomp_dictsz, &vc);
+        if (err) {
+            log_debug("samples %u, bytes %zu: training failed: %d",
+                      w->cw_samples->cvs_cnt, w->cw_samples->cvs_len, merr_errno(err));
+            vc = NULL;
+        }
+    }
+
+    cn_vcomp_train_end(cn, vc, tried);
+}
+
+merr_t
+cn_spill(struct cn_compaction_work *w)
+{
+    struct cn_vcomp_samples samples;
+    struct cn *             cn;
+    merr_t                  err;
+
+    cn = cn_tree_get_cn(w->cw_tree);
+
+    w->cw_vcomp = cn_get_vcomp(cn);
+    w->cw_samples = NULL;
+
+    if (cn_vcomp_train_begin(cn)) {
+        size_t cap = (size_t)w->cw_rp->cn_vcomp_dictsz * CN_VCOMP_SAMPLE_RATIO;
+
+        err = cn_vcomp_samples_init(&samples, cap);
+        if (!ev(err))
+            w->cw_samples = &samples;
+        else
+            cn_vcomp_train_end(cn, NULL, false);
+    }
+
+    err = cn_spill_merge(w);
+
+    if (w->cw_samples) {
+        cn_spill_train(w, cn, err);
+        cn_vcomp_samples_fini(&samples);
+        w->cw_samples = NULL;
+    }
+
+    return err;
+}
@@ -10,6 +10,7 @@
 #include <hse_util/inttypes.h>
 
 struct cn_compaction_work;
+struct cn_tree;
 
 /* MTF_MOCK_DECL(spill) */
 
@@ -42,6 +43,35 @@ struct cn_compaction_work;
 merr_t
 cn_spill(struct cn_compaction_work *w);
 
+/**
+ * cn_spill_slices_init() - split a spill or kv-compaction into key range slices
+ * @w: compaction work struct
+ *
+ * Sets @w->cw_slicec to the number of key range slices that cn_spill()
+ * will merge in parallel, and @w->cw_pivotv to the smallest key of each
+ * slice.  The pivots are kblock boundary keys of the input kvset with the
+ * most kblocks.  Each slice but the first positions its iterators via the
+ * wbtree, so a sliced job always iterates its inputs via mcache maps.
+ *
+ * A job is not sliced if any of its input kvsets contains prefix tombstones,
+ * as a ptomb may annihilate keys in subsequent slices.
+ */
+/* MTF_MOCK */
+void
+cn_spill_slices_init(struct cn_compaction_work *w);
+
+/**
+ * cn_spill_khashmap_update() - persist the key hash map if it changed
+ * @tree: cn tree
+ *
+ * The key hash map assigns child nodes to key hashes on first use, so
+ * the latest version must be persisted by anyone who routes keys to the
+ * root's children before their kvsets are committed (regardless of error).
+ */
+/* MTF_MOCK */
+merr_t
+cn_spill_khashmap_update(struct cn_tree *tree);
+
 #if HSE_MOCKING
 #include "spill_ut.h"
 #endif /* HSE_MOCKING */
@@ -29,6 +29,7 @@
 #include "cn_mblocks.h"
 #include "cn_metrics.h"
 #include "cn_perfc.h"
+#include "cn_vcomp.h"
 
 #include <mpool/mpool.h>
 
@@ -79,17 +80,25 @@ _vblock_start(struct vblock_builder *bld)
     assert(mbprop.mpr_optimal_wrsz);
 
     /* set offsets to leave space for header */
-    bld->vblk_off = VBLOCK_HDR_LEN;
-    bld->wbuf_off = VBLOCK_HDR_LEN;
+    bld->vblk_off = bld->hdr_len;
+    bld->wbuf_off = bld->hdr_len;
     bld->blkid = blkid;
     bld->wbuf_len = WBUF_LEN_MAX - (WBUF_LEN_MAX % mbprop.mpr_optimal_wrsz);
     bld->opt_wrsz = mbprop.mpr_optimal_wrsz;
 
     /* add header to write buffer */
-    memset(bld->wbuf, 0x0, VBLOCK_HDR_LEN);
+    memset(bld->wbuf, 0x0, bld->hdr_len);
     omf_set_vbh_magic(bld->wbuf, VBLOCK_HDR_MAGIC);
     omf_set_vbh_version(bld->wbuf, VBLOCK_HDR_VERSION);
     omf_set_vbh_vgroup(bld->wbuf, bld->vgroup);
+    omf_set_vbh_calgo(bld->wbuf, bld->calgo);
+    omf_set_vbh_dictlen(bld->wbuf, bld->dictlen);
+
+    /* Every vblock carries its own copy of the dictionary so that
+     * it can be read independently of the kvset that created it.
+     */
+    if (bld->dictlen > 0)
+        memcpy(bld->wbuf + sizeof(struct vblock_hdr_omf), bld->dict, bld->dictlen);
 
     return 0;
 }
@@ -117,6 +126,7 @@ _vblock_write(struct vblock_builder *bld)
 
     if (stats)
         count_ops(&stats->ms_vblk_write, 1, iov.iov_len, get_time_ns() - tstart);
+    cn_iogov_request(bld->iogov, bld->iocls, iov.iov_len);
 
     if (ev(err)) {
         bld->destruct = true;
@@ -187,6 +197,8 @@ vbb_create(
     bld->vgroup = vgroup;
     bld->agegroup = HSE_MPOLICY_AGE_LEAF;
     bld->wbuf = wbuf;
+    bld->hdr_len = VBLOCK_HDR_LEN;
+    bld->calgo = VBLOCK_CALGO_LZ4;
 
     policy = cn_get_mclass_policy(bld->cn);
 
@@ -212,15 +224,16 @@ vbb_destroy(struct vblock_builder *bld)
     abort_mblocks(bld->ds, &bld->vblk_list);
     blk_list_free(&bld->vblk_list);
 
+    free(bld->blk);
+
     vlb_free(bld->wbuf, WBUF_LEN_MAX + sizeof(*bld));
 }
 
-/* Add a value to vblock.  Create new vblock if needed. */
-merr_t
-vbb_add_entry(
+static merr_t
+_vblock_add(
     struct vblock_builder *bld,
     const void *           vdata,
-    uint                   vlen, /* on-media length */
+    uint                   vlen,
     u64 *                  vbidout,
     uint *                 vbidxout,
     uint *                 vboffout)
@@ -228,8 +241,6 @@ vbb_add_entry(
     merr_t err;
     uint   voff, space, bytes;
 
-    assert(!bld->destruct);
-
     assert(vdata);
     assert(vlen);
     assert(vlen <= HSE_KVS_VALUE_LEN_MAX);
@@ -276,7 +287,7 @@ vbb_add_entry(
 
     assert(bld->wbuf_off < bld->wbuf_len);
 
-    *vboffout = bld->vblk_off - VBLOCK_HDR_LEN;
+    *vboffout = bld->vblk_off - bld->hdr_len;
     *vbidxout = bld->vblk_list.n_blks - 1;
     *vbidout = bld->vblk_list.blks[*vbidxout].bk_blkid;
 
@@ -286,6 +297,123 @@ vbb_add_entry(
     return 0;
 }
 
+/* Compress and write out the open compressed block, if any.  The block is
+ * stored uncompressed if it doesn't compress.
+ */
+static merr_t
+_vblock_cblk_close(struct vblock_builder *bld)
+{
+    struct vblock_cblk_omf *hdr = bld->cblk;
+    uint                    clen, vbidx, vboff;
+    u64                     vbid;
+    merr_t                  err;
+
+    if (!bld->blklen)
+        return 0;
+
+    err = merr(EFBIG);
+    if (bld->blklen > 1)
+        err = cn_vcomp_compress(bld->vcomp, bld->blk, bld->blklen, hdr + 1, bld->blklen - 1, &clen);
+    if (err) {
+        memcpy(hdr + 1, bld->blk, bld->blklen);
+        clen = bld->blklen;
+    }
+
+    omf_set_cbh_rawlen(hdr, bld->blklen);
+    omf_set_cbh_clen(hdr, clen);
+
+    bld->blklen = 0;
+
+    err = _vblock_add(bld, hdr, sizeof(*hdr) + clen, &vbid, &vbidx, &vboff);
+    if (ev(err))
+        return err;
+
+    assert(vbidx == bld->blkvbidx && vboff == bld->blkvboff);
+
+    return 0;
+}
+
+/* Add a value to vblock.  Create new vblock if needed. */
+merr_t
+vbb_add_entry(
+    struct vblock_builder *bld,
+    const void *           vdata,
+    uint                   vlen, /* on-media length */
+    u64 *                  vbidout,
+    uint *                 vbidxout,
+    uint *                 vboffout)
+{
+    merr_t err;
+
+    assert(!bld->destruct);
+
+    err = _vblock_cblk_close(bld);
+    if (ev(err))
+        return err;
+
+    return _vblock_add(bld, vdata, vlen, vbidout, vbidxout, vboffout);
+}
+
+merr_t
+vbb_add_blk_entry(
+    struct vblock_builder *bld,
+    const void *           vdata,
+    uint                   vlen,
+    u64 *                  vbidout,
+    uint *                 vbidxout,
+    uint *                 vboffout,
+    uint *                 boffout)
+{
+    uint   blksz;
+    merr_t err;
+
+    assert(!bld->destruct);
+    assert(vdata && vlen);
+
+    blksz = bld->vcomp ? bld->vcomp->cv_blksz : 0;
+    if (ev(!bld->blk || vlen > blksz))
+        return merr(EINVAL);
+
+    if (bld->blklen + vlen > blksz) {
+        err = _vblock_cblk_close(bld);
+        if (ev(err))
+            return err;
+    }
+
+    if (!bld->blklen) {
+        uint need = sizeof(struct vblock_cblk_omf) + blksz;
+
+        /* Reserve room for the block in the current vblock, assuming
+         * it won't compress.
+         */
+        if (HSE_UNLIKELY(!_vblock_has_room(bld, need))) {
+            err = _vblock_finish(bld);
+            if (ev(err))
+                return err;
+        }
+
+        if (HSE_UNLIKELY(!bld->blkid)) {
+            err = _vblock_start(bld);
+            if (ev(err))
+                return err;
+        }
+
+        bld->blkvbidx = bld->vblk_list.n_blks - 1;
+        bld->blkvboff = bld->vblk_off - bld->hdr_len;
+    }
+
+    memcpy(bld->blk + bld->blklen, vdata, vlen);
+
+    *boffout = bld->blklen;
+    *vboffout = bld->blkvboff;
+    *vbidxout = bld->blkvbidx;
+    *vbidout = bld->vblk_list.blks[*vbidxout].bk_blkid;
+
+    bld->blklen += vlen;
+
+    return 0;
+}
+
 /* Close out the current vblock, return IDs of all mblocks allocated so far,
  * and mark the builder as closed for business.
  */
@@ -296,6 +424,10 @@ vbb_finish(struct vblock_builder *bld, struct blk_list *vblks)
 
     assert(!bld->destruct);
 
+    err = _vblock_cblk_close(bld);
+    if (ev(err))
+        return err;
+
     bld->destruct = true;
 
     err = _vblock_finish(bld);
@@ -343,6 +475,43 @@ vbb_set_merge_stats(struct vblock_builder *bld, struct cn_merge_stats *stats)
     bld->mstats = stats;
 }
 
+void
+vbb_set_iogov(struct vblock_builder *bld, struct cn_iogov *gov, enum cn_iogov_class cls)
+{
+    bld->iogov = gov;
+    bld->iocls = cls;
+}
+
+merr_t
+vbb_set_comp(struct vblock_builder *bld, const struct cn_vcomp *vcomp)
+{
+    uint blksz = vcomp->cv_blksz;
+
+    if (ev(bld->blkid || bld->vblk_list.n_blks || bld->vcomp))
+        return merr(EBUSY);
+
+    if (ev(vcomp->cv_dictlen > VBLOCK_DICT_LEN_MAX || blksz > VBLOCK_CBLK_LEN_MAX))
+        return merr(EINVAL);
+
+    if (blksz > 0) {
+        bld->blk = malloc(blksz * 2 + sizeof(struct vblock_cblk_omf));
+        if (ev(!bld->blk))
+            return merr(ENOMEM);
+
+        bld->cblk = bld->blk + blksz;
+    }
+
+    bld->vcomp = vcomp;
+    bld->calgo = vcomp->cv_calgo;
+    bld->dict = vcomp->cv_dict;
+    bld->dictlen = vcomp->cv_dictlen;
+    bld->hdr_len = ALIGN(sizeof(struct vblock_hdr_omf) + bld->dictlen, PAGE_SIZE);
+
+    assert(bld->hdr_len >= VBLOCK_HDR_LEN);
+
+    return 0;
+}
+
 #if HSE_MOCKING
 #include "vblock_builder_ut_impl.i"
 #endif /* HSE_MOCKING */
@@ -11,11 +11,14 @@
 
 #include <hse_util/perfc.h>
 
+#include <hse_ikvdb/cn_iogov.h>
+
 struct cn;
 struct vblock_builder;
 struct blk_list;
 struct kvs_rparams;
 struct cn_merge_stats;
+struct cn_vcomp;
 
 enum hse_mclass;
 enum hse_mclass_policy_age;
@@ -64,6 +67,29 @@ vbb_add_entry(
     uint *                 vbidxout,
     uint *                 vboffout);
 
+/**
+ * vbb_add_blk_entry() - Pack a value into a compressed block
+ * @bld:      builder handle
+ * @vdata, @vlen: value to add (@vlen must not exceed the block size)
+ * @vbidout:  id of the vblock that holds the value's block
+ * @vbidxout: index of the vblock that holds the value's block
+ * @vboffout: offset of the value's block into the vblock
+ * @boffout:  offset of the value into the uncompressed block
+ *
+ * The block is written when it fills or when the next value is added via
+ * vbb_add_entry().  Requires a block size to have been set via vbb_set_comp().
+ */
+/* MTF_MOCK */
+merr_t
+vbb_add_blk_entry(
+    struct vblock_builder *bld,
+    const void *           vdata,
+    uint                   vlen,
+    u64 *                  vbidout,
+    uint *                 vbidxout,
+    uint *                 vboffout,
+    uint *                 boffout);
+
 /* MTF_MOCK */
 merr_t
 vbb_finish(struct vblock_builder *bld, struct blk_list *vblks);
@@ -123,6 +149,26 @@ vbb_get_agegroup(struct vblock_builder *bld);
 void
 vbb_set_merge_stats(struct vblock_builder *bld, struct cn_merge_stats *stats);
 
+/**
+ * vbb_set_iogov() - charge vblock writes to an IO governor
+ */
+void
+vbb_set_iogov(struct vblock_builder *bld, struct cn_iogov *gov, enum cn_iogov_class cls);
+
+/**
+ * vbb_set_comp() - Set the compression attributes of new vblocks
+ * @bld:   builder handle
+ * @vcomp: value compressor, which must remain valid until vbb_finish()
+ *
+ * Must be called before the first value is added.  The compression
+ * algorithm and dictionary of @vcomp are recorded in the header of each
+ * vblock, and if @vcomp has a block size then vbb_add_blk_entry() may be
+ * used to pack small values into blocks compressed with @vcomp.
+ */
+/* MTF_MOCK */
+merr_t
+vbb_set_comp(struct vblock_builder *bld, const struct cn_vcomp *vcomp);
+
 #if HSE_MOCKING
 #include "vblock_builder_ut.h"
 #endif /* HSE_MOCKING */
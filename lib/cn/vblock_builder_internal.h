@@ -11,6 +11,7 @@
 #include <stdint.h>
 
 #include <hse_ikvdb/blk_list.h>
+#include <hse_ikvdb/cn_iogov.h>
 #include <hse_ikvdb/mclass_policy.h>
 
 #include <hse_util/hse_err.h>
@@ -19,6 +20,7 @@
 #define VBLOCK_HDR_LEN 4096
 
 struct cn_merge_stats;
+struct cn_vcomp;
 
 /**
  * struct vblock_builder - create vblocks from a stream of values
@@ -35,6 +37,12 @@ struct cn_merge_stats;
  * @destruct:  if true, vlbock builder is ready to be destroyed
  * @opt_wrsz:  optimal write size for incremental mblock writes
  * @mblocksz:  mblock size of specified media class
+ * @vcomp:     value compressor (for compressed blocks)
+ * @blk:       uncompressed contents of the open compressed block
+ * @blklen:    length of @blk (zero if no block is open)
+ * @blkvbidx:  index of the vblock to which the open block will be written
+ * @blkvboff:  offset within that vblock at which it will be written
+ * @cblk:      buffer in which to compress @blk
  *
  * WBUF_LEN_MAX is the allocated size of the write buffer.  Each mblock write
  * will be at most WBUF_LEN_MAX bytes.  Member @wbuf_len is the actual write
@@ -72,12 +80,20 @@ struct cn_merge_stats;
  *       -- write @wbuf_len bytes to mblock
  *       -- set @wbuf_off to 0
  *       -- set @vblk_off += @wbuff_off
+ *
+ * Small values may instead be packed into compressed blocks (see
+ * vbb_add_blk_entry()).  Space for the open block is reserved in the
+ * current vblock when the block is opened, and no other entries are added
+ * until it is closed, so that the location of each value is known when it
+ * is added even though the block is written later.
  */
 struct vblock_builder {
     struct mpool *             ds;
     struct cn *                cn;
     struct perfc_set *         pc;
     struct cn_merge_stats *    mstats;
+    struct cn_iogov *          iogov;
+    enum cn_iogov_class        iocls;
     struct blk_list            vblk_list;
     enum hse_mclass_policy_age agegroup;
     uint64_t                   vsize;
@@ -90,6 +106,16 @@ struct vblock_builder {
     uint64_t                   vgroup;
     bool                       destruct;
     uint32_t                   opt_wrsz;
+    uint32_t                   hdr_len;
+    uint32_t                   calgo;
+    uint32_t                   dictlen;
+    const void *               dict;
+    const struct cn_vcomp *    vcomp;
+    void *                     blk;
+    uint32_t                   blklen;
+    uint32_t                   blkvbidx;
+    uint32_t                   blkvboff;
+    void *                     cblk;
 };
 
 static inline bool
@@ -10,6 +10,8 @@
 #include <hse_util/slab.h>
 #include <hse_util/assert.h>
 #include <hse_util/arch.h>
+#include <hse_util/compression_lz4.h>
+#include <hse_util/compression_zstd.h>
 
 #include <mpool/mpool.h>
 
@@ -33,7 +35,7 @@ vbr_desc_read(
     bool     supported;
     void    *base;
     u64      vgroup;
-    uint32_t vers;
+    uint32_t vers, calgo, dictlen;
 
     base = mpool_mcache_getbase(map, idx);
     if (ev(!base))
@@ -48,21 +50,75 @@ vbr_desc_read(
     if (ev(!supported))
         return merr(EPROTO);
 
+    calgo = VBLOCK_CALGO_LZ4;
+    dictlen = 0;
+
+    if (vers >= VBLOCK_HDR_VERSION3) {
+        calgo = omf_vbh_calgo(hdr);
+        dictlen = omf_vbh_dictlen(hdr);
+
+        if (ev(calgo > VBLOCK_CALGO_ZSTD || dictlen > VBLOCK_DICT_LEN_MAX))
+            return merr(EPROTO);
+    }
+
     memset(vblk_desc, 0, sizeof(*vblk_desc));
     vblk_desc->vbd_mblkdesc.map_base = base;
     vblk_desc->vbd_mblkdesc.mb_id = props->mpr_objid;
     vblk_desc->vbd_mblkdesc.map = map;
     vblk_desc->vbd_mblkdesc.map_idx = idx;
     vblk_desc->vbd_mblkdesc.mclass = props->mpr_mclass;
-    vblk_desc->vbd_off = PAGE_SIZE;
-    vblk_desc->vbd_len = props->mpr_write_len - PAGE_SIZE;
+    vblk_desc->vbd_off = ALIGN(sizeof(*hdr) + dictlen, PAGE_SIZE);
+    vblk_desc->vbd_len = props->mpr_write_len - vblk_desc->vbd_off;
     vblk_desc->vbd_vgroup = vgroup;
+    vblk_desc->vbd_calgo = calgo;
     atomic_set(&vblk_desc->vbd_vgidx, 1);
     atomic_set(&vblk_desc->vbd_refcnt, 0);
 
+    if (dictlen > 0) {
+        vblk_desc->vbd_dict = base + sizeof(*hdr);
+        vblk_desc->vbd_dictlen = dictlen;
+
+#ifdef HAVE_ZSTD
+        if (calgo == VBLOCK_CALGO_ZSTD) {
+            merr_t err;
+
+            vblk_desc->vbd_dictid = compress_zstd_dict_id(vblk_desc->vbd_dict, dictlen);
+
+            err = compress_zstd_ddict_get(vblk_desc->vbd_dict, dictlen, &vblk_desc->vbd_ddict);
+            if (ev(err))
+                return err;
+        }
+#endif
+    }
+
     return 0;
 }
 
+merr_t
+vbr_decompress(
+    const struct vblock_desc *vbd,
+    const void *              src,
+    uint                      srclen,
+    void *                    dst,
+    uint                      dstcap,
+    uint *                    dstlen)
+{
+    switch (vbd->vbd_calgo) {
+    case VBLOCK_CALGO_LZ4:
+        return compress_lz4_ops.cop_decompress(src, srclen, dst, dstcap, dstlen);
+
+#ifdef HAVE_ZSTD
+    case VBLOCK_CALGO_ZSTD:
+        return compress_zstd_decompress(vbd->vbd_ddict, src, srclen, dst, dstcap, dstlen);
+#endif
+
+    default:
+        break;
+    }
+
+    return merr(ev(ENOTSUP));
+}
+
 merr_t
 vbr_desc_update(
     struct mpool *           ds,
@@ -93,6 +149,15 @@ vbr_desc_update(
     return 0;
 }
 
+void
+vbr_desc_destroy(struct vblock_desc *vblk_desc)
+{
+#ifdef HAVE_ZSTD
+    compress_zstd_ddict_put(vblk_desc->vbd_ddict);
+#endif
+    vblk_desc->vbd_ddict = NULL;
+}
+
 void
 vbr_readahead(
     struct vblock_desc *     vbd,
@@ -266,3 +331,126 @@ vbr_value(struct vblock_desc *vbd, uint vboff, uint vlen)
     assert(vboff + vlen <= vbd->vbd_len);
     return vbd->vbd_mblkdesc.map_base + vbd->vbd_off + vboff;
 }
+
+/* Each thread keeps a small cache of recently decompressed value blocks
+ * so that iterating over or looking up neighboring block values costs
+ * one decompression per block rather than one per value.  Blocks are
+ * identified by the vblock's mblock ID, its vgroup (which distinguishes
+ * a reused mblock ID) and the block's offset within the vblock.
+ */
+#define VBR_CBLK_CACHE_SZ (4)
+
+struct vbr_cblk_ent {
+    u64  vc_mbid;
+    u64  vc_vgroup;
+    uint vc_blkoff;
+    uint vc_len;
+    u8   vc_data[VBLOCK_CBLK_LEN_MAX];
+};
+
+struct vbr_cblk_cache {
+    uint                vcc_next;
+    struct vbr_cblk_ent vcc_entv[VBR_CBLK_CACHE_SZ];
+};
+
+static thread_local struct vbr_cblk_cache vbr_cblk_cache;
+
+static struct vbr_cblk_ent *
+vbr_cblk_lookup(struct vbr_cblk_cache *cache, const struct vblock_desc *vbd, uint vboff)
+{
+    uint i;
+
+    for (i = 0; i < VBR_CBLK_CACHE_SZ; ++i) {
+        struct vbr_cblk_ent *ent = cache->vcc_entv + i;
+
+        if (ent->vc_len && ent->vc_blkoff == vboff && ent->vc_mbid == vbd->vbd_mblkdesc.mb_id &&
+            ent->vc_vgroup == vbd->vbd_vgroup)
+            return ent;
+    }
+
+    return NULL;
+}
+
+bool
+vbr_cblk_cached(const struct vblock_desc *vbd, uint vboff)
+{
+    return vbr_cblk_lookup(&vbr_cblk_cache, vbd, vboff);
+}
+
+uint
+vbr_cblk_len(const struct vblock_desc *vbd, uint vboff, const void *hdr)
+{
+    const struct vblock_cblk_omf *cbh = hdr;
+    uint clen = omf_cbh_clen(cbh);
+
+    /* Clamp corrupt lengths so that callers never read past the vblock,
+     * vbr_cblk_value() detects and reports the corruption.
+     */
+    if (clen > VBLOCK_CBLK_LEN_MAX || vboff + sizeof(*cbh) + clen > vbd->vbd_len)
+        clen = 0;
+
+    return sizeof(*cbh) + clen;
+}
+
+merr_t
+vbr_cblk_value(
+    struct vblock_desc *vbd,
+    uint                vboff,
+    const void *        blk,
+    uint                boff,
+    uint                vlen,
+    const void **       vdata)
+{
+    const struct vblock_cblk_omf *cbh;
+    struct vbr_cblk_cache *       cache = &vbr_cblk_cache;
+    struct vbr_cblk_ent *         ent;
+    uint                          rawlen, clen, outlen;
+    merr_t                        err;
+
+    ent = vbr_cblk_lookup(cache, vbd, vboff);
+    if (ent)
+        goto found;
+
+    if (ev(vboff + sizeof(*cbh) > vbd->vbd_len))
+        return merr(EPROTO);
+
+    cbh = blk ?: vbr_value(vbd, vboff, sizeof(*cbh));
+    rawlen = omf_cbh_rawlen(cbh);
+    clen = omf_cbh_clen(cbh);
+
+    if (ev(rawlen > VBLOCK_CBLK_LEN_MAX || clen > rawlen || boff + vlen > rawlen ||
+           vboff + sizeof(*cbh) + clen > vbd->vbd_len))
+        return merr(EPROTO);
+
+    /* Blocks that didn't compress are stored raw and need no caching.
+     */
+    if (clen == rawlen) {
+        *vdata = (const u8 *)(cbh + 1) + boff;
+        return 0;
+    }
+
+    ent = cache->vcc_entv + cache->vcc_next;
+    ent->vc_len = 0;
+
+    err = vbr_decompress(vbd, cbh + 1, clen, ent->vc_data, rawlen, &outlen);
+    if (ev(err))
+        return err;
+
+    if (ev(outlen != rawlen))
+        return merr(EPROTO);
+
+    ent->vc_mbid = vbd->vbd_mblkdesc.mb_id;
+    ent->vc_vgroup = vbd->vbd_vgroup;
+    ent->vc_blkoff = vboff;
+    ent->vc_len = rawlen;
+
+    cache->vcc_next = (cache->vcc_next + 1) % VBR_CBLK_CACHE_SZ;
+
+  found:
+    if (ev(boff + vlen > ent->vc_len))
+        return merr(EPROTO);
+
+    *vdata = ent->vc_data + boff;
+
+    return 0;
+}
@@ -23,6 +23,7 @@
 struct mpool;
 struct mpool_mcache_map;
 struct mblock_props;
+struct compress_zstd_ddict;
 
 /**
  * struct ra_hist - readahead history cache record
@@ -58,6 +59,12 @@ struct vblock_desc {
     u64                  vbd_vgroup;   /* vblock group ID (dgen_hi) */
     atomic_int           vbd_vgidx;    /* vblock group index */
     atomic_int           vbd_refcnt;   /* vbr_madvise_async() refcnt */
+    u32                  vbd_calgo;    /* compression algo (VBLOCK_CALGO_*) */
+    u32                  vbd_dictlen;  /* compression dictionary length */
+    u32                  vbd_dictid;   /* compression dictionary ID */
+    const void          *vbd_dict;     /* compression dictionary (in header) */
+
+    const struct compress_zstd_ddict *vbd_ddict;
 };
 
 /**
@@ -84,6 +91,12 @@ vbr_desc_update(
     struct mblock_props *    props,
     struct vblock_desc *     vblock_desc);
 
+/**
+ * vbr_desc_destroy() - Release resources acquired by vbr_desc_read()
+ */
+void
+vbr_desc_destroy(struct vblock_desc *vblock_desc);
+
 /**
  * vbr_madvise_async() - initiate async vblock readahead
  */
@@ -131,4 +144,66 @@ vbr_madvise(struct vblock_desc *vbd, uint off, uint len, int advice);
 void *
 vbr_value(struct vblock_desc *vbd, uint vboff, uint vlen);
 
+/**
+ * vbr_decompress() - Decompress a value stored in a vblock
+ * @vbd:     vblock from which @src was read
+ * @src:     compressed value
+ * @srclen:  length of @src
+ * @dst:     output buffer
+ * @dstcap:  size of @dst (may be less than the uncompressed length)
+ * @dstlen:  (output) number of bytes decompressed into @dst
+ *
+ * Uses the compression algorithm and dictionary recorded in the header
+ * of the vblock.
+ */
+merr_t
+vbr_decompress(
+    const struct vblock_desc *vbd,
+    const void *              src,
+    uint                      srclen,
+    void *                    dst,
+    uint                      dstcap,
+    uint *                    dstlen);
+
+/**
+ * vbr_cblk_cached() - determine whether a compressed block is cached
+ * @vbd:   vblock containing the block
+ * @vboff: offset of the block within the vblock
+ *
+ * Returns true if the calling thread has the block of values at @vboff
+ * in its cache of decompressed blocks.
+ */
+bool
+vbr_cblk_cached(const struct vblock_desc *vbd, uint vboff);
+
+/**
+ * vbr_cblk_len() - get the on-media length of a compressed block
+ * @vbd:   vblock containing the block
+ * @vboff: offset of the block within the vblock
+ * @hdr:   the block's header (struct vblock_cblk_omf)
+ */
+uint
+vbr_cblk_len(const struct vblock_desc *vbd, uint vboff, const void *hdr);
+
+/**
+ * vbr_cblk_value() - Get ptr to a value packed into a compressed block
+ * @vbd:   vblock containing the block
+ * @vboff: offset of the block within the vblock
+ * @blk:   the block as read from media (NULL to use the mcache map)
+ * @boff:  offset of the value within the uncompressed block
+ * @vlen:  length of the value
+ * @vdata: (output) ptr to the value
+ *
+ * Decompressed blocks are kept in a small per-thread cache, so @vdata
+ * remains valid only until the calling thread's next call.
+ */
+merr_t
+vbr_cblk_value(
+    struct vblock_desc *vbd,
+    uint                vboff,
+    const void *        blk,
+    uint                boff,
+    uint                vlen,
+    const void **       vdata);
+
 #endif
@@ -5,7 +5,14 @@
 
 #include <hse_ikvdb/vcomp_params.h>
 #include <hse_util/compression_lz4.h>
+#include <hse_util/compression_zstd.h>
 
 const struct compress_ops *vcomp_compress_ops[VCOMP_ALGO_COUNT] = {
-    NULL, &compress_lz4_ops,
+    NULL,
+    &compress_lz4_ops,
+#ifdef HAVE_ZSTD
+    &compress_zstd_ops,
+#else
+    NULL,
+#endif
 };
@@ -17,6 +17,8 @@
 #include <hse_ikvdb/tuple.h>
 #include <hse_ikvdb/omf_kmd.h>
 
+#include <mpool/mpool.h>
+
 #include "wbt_internal.h"
 #include "omf.h"
 #include "kvs_mblk_desc.h"
@@ -31,6 +33,86 @@
 
 static struct kmem_cache *wbti_cache HSE_READ_MOSTLY;
 
+/* When a kblock is read via the mpool page cache, point lookups copy the
+ * key metadata they need into this thread-local window.  Every kmd entry
+ * is much smaller than a page, so any entry that starts in the first page
+ * of the window ends within it.
+ */
+struct wbtr_kmd_win {
+    char   buf[2 * PAGE_SIZE];
+    size_t base; /* offset of buf[0] within the kmd region */
+};
+
+static thread_local struct wbtr_kmd_win wbtr_kmd_win HSE_ALIGNED(PAGE_SIZE);
+
+static HSE_ALWAYS_INLINE bool
+wbtr_is_leaf(const struct wbt_desc *wbd, uint node_num)
+{
+    return node_num - wbd->wbd_leaf < wbd->wbd_leaf_cnt;
+}
+
+/* Get the address of page %pg of the kblock, from the mpool page cache if
+ * the kblock is configured to use it, otherwise from the mcache map.  If a
+ * cache page was pinned it is returned via %bpp and must be released with
+ * wbtr_page_put().
+ */
+static HSE_ALWAYS_INLINE void *
+wbtr_page_get(const struct kvs_mblk_desc *kbd, size_t pg, bool prio, struct mpool_bcache_page **bpp)
+{
+    void  *addr;
+    merr_t err;
+
+    *bpp = NULL;
+
+    if (kbd->bcache) {
+        err = mpool_bcache_get(kbd->ds, kbd->mb_id, pg, prio && kbd->bcache > 1, bpp, &addr);
+        if (!ev(err))
+            return addr;
+
+        *bpp = NULL;
+    }
+
+    return kbd->map_base + pg * PAGE_SIZE;
+}
+
+static HSE_ALWAYS_INLINE void
+wbtr_page_put(struct mpool_bcache_page *bp)
+{
+    if (bp)
+        mpool_bcache_put(bp);
+}
+
+/* Load the kmd window such that it starts at the page containing %off.
+ */
+static merr_t
+wbtr_kmd_win_load(
+    const struct kvs_mblk_desc *kbd,
+    const struct wbt_desc *     wbd,
+    size_t                      off,
+    struct wbtr_kmd_win *       win)
+{
+    size_t kmd_pg = wbd->wbd_first_page + wbd->wbd_root + 1;
+    size_t pg = off / PAGE_SIZE;
+    uint   i;
+
+    for (i = 0; i < 2 && pg + i < wbd->wbd_kmd_pgc; i++) {
+        struct mpool_bcache_page *bp;
+        void *                    addr;
+        merr_t                    err;
+
+        err = mpool_bcache_get(kbd->ds, kbd->mb_id, kmd_pg + pg + i, false, &bp, &addr);
+        if (ev(err))
+            return err;
+
+        memcpy(win->buf + i * PAGE_SIZE, addr, PAGE_SIZE);
+        mpool_bcache_put(bp);
+    }
+
+    win->base = pg * PAGE_SIZE;
+
+    return 0;
+}
+
 void
 wbt_read_kmd_vref(const void *kmd, size_t *off, u64 *seq, struct kvs_vtuple_ref *vref)
 {
@@ -39,9 +121,11 @@ wbt_read_kmd_vref(const void *kmd, size_t *off, u64 *seq, struct kvs_vtuple_ref
     uint           vboff = 0;
     uint           vlen = 0;
     uint           complen = 0;
+    uint           boff = 0;
     const void *   vdata = 0;
+    u64            expire;
 
-    kmd_type_seq(kmd, off, &vtype, seq);
+    kmd_type_seq_expire(kmd, off, &vtype, seq, &expire);
 
     switch (vtype) {
         case vtype_val:
@@ -67,6 +151,15 @@ wbt_read_kmd_vref(const void *kmd, size_t *off, u64 *seq, struct kvs_vtuple_ref
             vref->vb.vr_len = vlen;
             vref->vb.vr_complen = complen;
             break;
+        case vtype_bval:
+            kmd_bval(kmd, off, &vbidx, &vboff, &vlen, &boff);
+            assert(vbidx <= U16_MAX);
+            vref->vb.vr_index = vbidx;
+            vref->vb.vr_off = vboff;
+            vref->vb.vr_len = vlen;
+            vref->vb.vr_complen = 0;
+            vref->vb.vr_boff = boff;
+            break;
         case vtype_ival:
             kmd_ival(kmd, off, &vdata, &vlen);
             /* assert no truncation */
@@ -80,7 +173,8 @@ wbt_read_kmd_vref(const void *kmd, size_t *off, u64 *seq, struct kvs_vtuple_ref
             break;
     }
 
-    vref->vr_type = vtype;
+    /* An expired value reads as a tombstone. */
+    vref->vr_type = kvs_expired(expire) ? vtype_tomb : vtype;
 }
 
 static void
@@ -107,24 +201,24 @@ wbtr_seek_page(
     uint                        kt_len,
     uint                        lcp)
 {
-    struct wbt_node_hdr_omf *node;
-    int                      j, cmp, node_num;
-    uint                     cmplen;
-    size_t                   pg;
+    struct wbt_node_hdr_omf * node;
+    struct mpool_bcache_page *bp;
+    int                       j, cmp, node_num;
+    uint                      cmplen;
+    size_t                    pg;
 
     /* pull struct derefs out of the loop */
-    uint  first_page = wbd->wbd_first_page;
-    void *map_base = kbd->map_base;
+    uint first_page = wbd->wbd_first_page;
 
     /* search from root */
     node_num = wbd->wbd_root;
 
-    /* prefetch root node header */
-    __builtin_prefetch(map_base + (first_page + wbd->wbd_root) * PAGE_SIZE);
-
     assert(0 <= node_num && node_num < wbd->wbd_n_pages);
     pg = first_page + node_num;
-    node = map_base + pg * PAGE_SIZE;
+    node = wbtr_page_get(kbd, pg, !wbtr_is_leaf(wbd, node_num), &bp);
+
+    /* prefetch root node header */
+    __builtin_prefetch(node);
 
     while (omf_wbn_magic(node) == WBT_INE_NODE_MAGIC) {
         struct wbt_ine_omf *ine;
@@ -183,13 +277,16 @@ wbtr_seek_page(
 
         assert(omf_ine_left_child(ine) < node_num);
         node_num = omf_ine_left_child(ine);
+        wbtr_page_put(bp);
 
         assert(0 <= node_num && node_num < wbd->wbd_n_pages);
         pg = first_page + node_num;
-        node = map_base + pg * PAGE_SIZE;
+        node = wbtr_page_get(kbd, pg, !wbtr_is_leaf(wbd, node_num), &bp);
         __builtin_prefetch(node);
     }
 
+    wbtr_page_put(bp);
+
     return node_num;
 }
 
@@ -740,13 +837,15 @@ wbtr_read_vref(
     enum key_lookup_res *       lookup_res,
     struct kvs_vtuple_ref *     vref)
 {
-    struct wbt_node_hdr_omf *node;
-    int                      j, cmp, node_num;
-    int                      first, last;
-    size_t                   pg;
-    const void *             kdata, *kt_data;
-    uint                     klen, kt_len;
-    struct wbt_lfe_omf *     lfe;
+    struct wbt_node_hdr_omf * node;
+    struct mpool_bcache_page *bp = NULL;
+    int                       j, cmp, node_num;
+    int                       first, last;
+    size_t                    pg;
+    const void *              kdata, *kt_data;
+    uint                      klen, kt_len;
+    struct wbt_lfe_omf *      lfe;
+    merr_t                    err = 0;
 
     const void *node_pfx;
     uint        node_pfx_len;
@@ -756,14 +855,16 @@ wbtr_read_vref(
 
     assert(kt->kt_len > 0);
 
+    *lookup_res = NOT_FOUND;
+
     if (HSE_UNLIKELY(!wbd->wbd_n_pages))
-        goto done;
+        return 0;
 
     node_num = wbtr_seek_page(kbd, wbd, kt_data, kt_len, 0);
 
     assert(0 <= node_num && node_num < wbd->wbd_n_pages);
     pg = wbd->wbd_first_page + node_num;
-    node = kbd->map_base + pg * PAGE_SIZE;
+    node = wbtr_page_get(kbd, pg, false, &bp);
 
     /* at leaf */
     assert(omf_wbn_magic(node) == WBT_LFE_NODE_MAGIC);
@@ -800,19 +901,45 @@ wbtr_read_vref(
         else {
             /* Found key */
             void * kmd;
-            size_t off;
+            size_t off, kbase;
             u64    vseq;
             uint   nvals;
+            bool   win = false;
 
             kmd = kbd->map_base + PAGE_SIZE * (wbd->wbd_first_page + wbd->wbd_root + 1);
+            kbase = 0;
 
             off = wbt_lfe_kmd(node, lfe);
             assert(off < wbd->wbd_kmd_pgc * PAGE_SIZE);
+
+            wbtr_page_put(bp);
+            bp = NULL;
+
+            if (kbd->bcache) {
+                err = wbtr_kmd_win_load(kbd, wbd, off, &wbtr_kmd_win);
+                if (ev(err))
+                    goto done;
+
+                kmd = wbtr_kmd_win.buf;
+                kbase = wbtr_kmd_win.base;
+                off -= kbase;
+                win = true;
+            }
+
             nvals = kmd_count(kmd, &off);
             assert(nvals > 0);
             while (nvals--) {
+                if (win && off >= PAGE_SIZE) {
+                    err = wbtr_kmd_win_load(kbd, wbd, kbase + off, &wbtr_kmd_win);
+                    if (ev(err))
+                        goto done;
+
+                    off = kbase + off - wbtr_kmd_win.base;
+                    kbase = wbtr_kmd_win.base;
+                }
+
                 wbt_read_kmd_vref(kmd, &off, &vseq, vref);
-                assert(off <= wbd->wbd_kmd_pgc * PAGE_SIZE);
+                assert(kbase + off <= wbd->wbd_kmd_pgc * PAGE_SIZE);
                 if (seq >= vseq) {
                     vref->vr_seq = vseq;
                     if (vref->vr_type == vtype_tomb)
@@ -828,10 +955,62 @@ wbtr_read_vref(
             break;
         }
     }
+
 done:
+    wbtr_page_put(bp);
+
     /* Not finding the key is *not* an error. */
-    *lookup_res = NOT_FOUND;
-    return 0;
+    return err;
+}
+
+void
+wbtr_leaf_range(
+    const struct kvs_mblk_desc *kbd,
+    const struct wbt_desc *     wbd,
+    const void *                pfx,
+    uint                        pfx_len,
+    uint *                      first,
+    uint *                      last)
+{
+    u8 kbuf[HSE_KVS_KEY_LEN_MAX];
+
+    assert(wbd->wbd_n_pages > 0);
+
+    *first = 0;
+    *last = wbd->wbd_leaf_cnt - 1;
+
+    if (!pfx_len)
+        return;
+
+    /* The last leaf node that may contain a key with the prefix is the
+     * one that would contain the largest possible such key.
+     */
+    pfx_len = min_t(uint, pfx_len, sizeof(kbuf));
+    memcpy(kbuf, pfx, pfx_len);
+    memset(kbuf + pfx_len, 0xff, sizeof(kbuf) - pfx_len);
+
+    *first = wbtr_seek_page(kbd, wbd, pfx, pfx_len, 0) - wbd->wbd_leaf;
+    *last = wbtr_seek_page(kbd, wbd, kbuf, sizeof(kbuf), 0) - wbd->wbd_leaf;
+
+    assert(*first <= *last && *last < wbd->wbd_leaf_cnt);
+}
+
+void
+wbtr_leaf_min_key(
+    const struct kvs_mblk_desc *kbd,
+    const struct wbt_desc *     wbd,
+    uint                        leaf,
+    struct key_obj *            kobj)
+{
+    void *node;
+
+    assert(leaf < wbd->wbd_leaf_cnt);
+
+    node = kbd->map_base + PAGE_SIZE * (wbd->wbd_first_page + wbd->wbd_leaf + leaf);
+    assert(omf_wbn_magic(node) == WBT_LFE_NODE_MAGIC);
+
+    wbt_node_pfx(node, &kobj->ko_pfx, &kobj->ko_pfx_len);
+    wbt_lfe_key(node, wbt_lfe(node, 0), &kobj->ko_sfx, &kobj->ko_sfx_len);
 }
 
 void
@@ -79,6 +79,40 @@ wbtr_read_vref(
     enum key_lookup_res *       lookup_res,
     struct kvs_vtuple_ref *     vref);
 
+/**
+ * wbtr_leaf_range() - find the leaf nodes that may contain keys with a prefix
+ * @kbd:     kblock region descriptor
+ * @wbd:     wbtree descriptor (must not be empty)
+ * @pfx:     prefix
+ * @pfx_len: length of @pfx, zero to select all leaf nodes
+ * @first:   (output) index of the first leaf node in the range
+ * @last:    (output) index of the last leaf node in the range
+ *
+ * Leaf node indices are relative to the first leaf node of the wbtree.
+ */
+void
+wbtr_leaf_range(
+    const struct kvs_mblk_desc *kbd,
+    const struct wbt_desc *     wbd,
+    const void *                pfx,
+    uint                        pfx_len,
+    uint *                      first,
+    uint *                      last);
+
+/**
+ * wbtr_leaf_min_key() - get the smallest key of a leaf node
+ * @kbd:  kblock region descriptor
+ * @wbd:  wbtree descriptor
+ * @leaf: index of the leaf node (see wbtr_leaf_range())
+ * @kobj: (output) smallest key, which points into the kblock's mcache map
+ */
+void
+wbtr_leaf_min_key(
+    const struct kvs_mblk_desc *kbd,
+    const struct wbt_desc *     wbd,
+    uint                        leaf,
+    struct key_obj *            kobj);
+
 merr_t
 wbti_alloc(struct wbti **wbti_out);
 
@@ -13,6 +13,7 @@
 
 #include <hse_ikvdb/ikvdb.h>
 #include <hse_ikvdb/cursor.h>
+#include <hse_ikvdb/rtomb.h>
 
 #define CURSOR_FLAG_SEQNO_CHANGE 1
 #define CURSOR_FLAG_TOMBS_INV_KVMS 2
@@ -171,6 +172,21 @@ c0_pfx_probe(
 merr_t
 c0_prefix_del(struct c0 *self, struct kvs_ktuple *key, uintptr_t seqnoref);
 
+/**
+ * c0_range_del() - delete all keys in the range [kt, kt_end)
+ * @self:      Instance of struct c0 from which to delete
+ * @kt:        smallest key to delete
+ * @kt_end:    first key past the end of the range
+ * @seqnoref:  seqnoref for the range tombstone
+ */
+/* MTF_MOCK */
+merr_t
+c0_range_del(
+    struct c0 *        self,
+    struct kvs_ktuple *kt,
+    struct kvs_ktuple *kt_end,
+    uintptr_t          seqnoref);
+
 /**
  * c0_sync() - force ingest of existing c0 data and waits until ingest complete
  * @self:      Instance of struct c0 to flush
@@ -198,6 +214,18 @@ c0_cursor_create(
 void
 c0_cursor_prepare(struct c0_cursor *cur);
 
+/**
+ * c0_cursor_rtombs() - enumerate the range tombstones visible to a c0 cursor
+ * @c0cur: Instance of struct c0_cursor
+ * @visit: called once for each range tombstone of the cursor's kvs
+ * @arg:   passed through to @visit
+ *
+ * The tombstones' keys remain valid until the cursor is updated or destroyed.
+ */
+/* MTF_MOCK */
+merr_t
+c0_cursor_rtombs(struct c0_cursor *c0cur, rtomb_visit_fn *visit, void *arg);
+
 /**
  * c0_cursor_bind_txn() - Assign ctxn to c0 cursor
  * @c0cur:      Instance of struct c0_cursor
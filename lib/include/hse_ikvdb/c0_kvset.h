@@ -11,10 +11,42 @@
 #include <hse_util/rcu.h>
 
 #include <hse_ikvdb/kvs.h>
+#include <hse_ikvdb/rtomb.h>
 
 struct c0_kvset {
 };
 
+/**
+ * struct c0_rtomb - a range tombstone in a c0kvset
+ * @rt_next:  next older range tombstone in the c0kvset
+ * @rt_seqno: seqno of the range delete
+ * @rt_skidx: index of the kvs to which the tombstone applies
+ * @rt_slen:  length of the start key
+ * @rt_elen:  length of the end key
+ * @rt_data:  start key followed by the end key
+ *
+ * Range tombstones live beside the ptomb bonsai tree in the ptomb
+ * c0kvset of each kvms.  They are immutable once published.
+ */
+struct c0_rtomb {
+    struct c0_rtomb *rt_next;
+    u64              rt_seqno;
+    u16              rt_skidx;
+    u16              rt_slen;
+    u16              rt_elen;
+    char             rt_data[];
+};
+
+static inline void
+c0_rtomb_get(const struct c0_rtomb *crt, struct rtomb *rt)
+{
+    rt->rt_start = crt->rt_data;
+    rt->rt_end = crt->rt_data + crt->rt_slen;
+    rt->rt_slen = crt->rt_slen;
+    rt->rt_elen = crt->rt_elen;
+    rt->rt_seqno = crt->rt_seqno;
+}
+
 struct c0kvs_ingest_ctx;
 struct c0_kvset_iterator;
 
@@ -181,6 +213,46 @@ c0kvs_prefix_del(
     struct kvs_ktuple       *key,
     const uintptr_t          seqno);
 
+/**
+ * c0kvs_range_del() - add a range tombstone to a c0_kvset
+ * @set:      Struct c0_kvset to which to add the tombstone (the ptomb c0kvset)
+ * @skidx:    kvs index
+ * @kt:       smallest key to delete (its kt_seqno is set on success)
+ * @kt_end:   first key past the end of the range
+ * @seqnoref: seqnoref of the delete (HSE_SQNREF_SINGLE or an ordinal)
+ *
+ * Return: ENOMEM if the c0kvset's cheap is exhausted
+ */
+merr_t
+c0kvs_range_del(
+    struct c0_kvset *  set,
+    u16                skidx,
+    struct kvs_ktuple *kt,
+    struct kvs_ktuple *kt_end,
+    uintptr_t          seqnoref);
+
+/**
+ * c0kvs_rtombs_get() - get the newest range tombstone of a c0_kvset
+ * @set: Struct c0_kvset
+ *
+ * Older tombstones are reached via rt_next.  The caller must either be
+ * within an rcu read-side critical section or the c0kvset must be frozen.
+ */
+struct c0_rtomb *
+c0kvs_rtombs_get(struct c0_kvset *set);
+
+/**
+ * c0kvs_rtomb_seqno() - find the newest range tombstone covering a key
+ * @set:        Struct c0_kvset to search
+ * @skidx:      kvs index
+ * @kt:         key
+ * @view_seqno: ignore tombstones newer than view_seqno
+ *
+ * Return: the seqno of the tombstone, or zero if there is none
+ */
+u64
+c0kvs_rtomb_seqno(struct c0_kvset *set, u16 skidx, const struct kvs_ktuple *kt, u64 view_seqno);
+
 /**
  * c0kvs_get_rcu() - given a key, retrieve a value from a struct c0_kvset
  * @handle:     Struct c0_kvset to search
@@ -205,7 +277,10 @@ c0kvs_prefix_del(
  * status as follows:
  *
  *     FOUND_VAL:  the key was found and the associated value
- *                 was copied into @vbuf.
+ *                 was copied into @vbuf.  If @vbuf->b_pin is set
+ *                 and the value is not compressed, the value's
+ *                 address is instead returned in @vbuf->b_pin->vp_data
+ *                 and it is up to the caller to pin the c0kvms.
  *
  *     FOUND_TMB:  a tombstone entry was found.
  *
@@ -16,6 +16,7 @@
 #include <hse_ikvdb/kvs.h>
 #include <hse_ikvdb/tuple.h>
 #include <hse_ikvdb/kvdb_health.h>
+#include <hse_ikvdb/rtomb.h>
 
 struct c0_kvmultiset;
 struct c0sk;
@@ -227,6 +228,23 @@ c0sk_pfx_probe(
 merr_t
 c0sk_prefix_del(struct c0sk *self, u16 skidx, struct kvs_ktuple *key, uintptr_t seqnoref);
 
+/**
+ * c0sk_range_del() - delete all keys in the range [kt, kt_end)
+ * @self:      Instance of struct c0sk from which to delete
+ * @skidx:     Structured key index
+ * @kt:        Smallest key to delete
+ * @kt_end:    First key past the end of the range
+ * @seqnoref:  seqnoref for the range tombstone (must not be a txn's)
+ */
+/* MTF_MOCK */
+merr_t
+c0sk_range_del(
+    struct c0sk *      self,
+    u16                skidx,
+    struct kvs_ktuple *kt,
+    struct kvs_ktuple *kt_end,
+    uintptr_t          seqnoref);
+
 /**
  * c0sk_rparams() - Get a ptr to c0sk kvdb rparams
  * @self:       Instance of struct c0sk
@@ -305,6 +323,15 @@ c0sk_cursor_update(
 void
 c0sk_cursor_prepare(struct c0_cursor *cur);
 
+/**
+ * c0sk_cursor_rtombs() - enumerate the range tombstones in a cursor's kvms
+ * @c0cur:      The existing cursor.
+ * @visit:      Called once for each range tombstone of the cursor's kvs
+ * @arg:        Passed through to @visit
+ */
+merr_t
+c0sk_cursor_rtombs(struct c0_cursor *cur, rtomb_visit_fn *visit, void *arg);
+
 /**
  * c0sk_cursor_destroy() - destroy existing iterators over c0
  * @c0cur:      The existing cursor.
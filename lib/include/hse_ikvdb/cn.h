@@ -17,10 +17,13 @@
 
 /* MTF_MOCK_DECL(cn) */
 
-#define CN_CFLAG_CAPPED (1 << 0)
+#define CN_CFLAG_CAPPED     (1 << 0)
+#define CN_CFLAG_XOR_FILTER (1 << 1)
 
 struct cn;
+struct cn_vcomp;
 struct cn_kvdb;
+struct cn_iogov;
 struct cndb;
 struct mpool;
 struct kvs_cparams;
@@ -91,6 +94,42 @@ cn_inc_ingest_dgen(struct cn *cn);
 struct kvs_rparams *
 cn_get_rp(const struct cn *cn);
 
+/**
+ * cn_get_vcomp() - get the value compressor for spill and kv-compaction
+ * @cn: cn handle
+ *
+ * Returns the compressor with the trained zstd dictionary once there is
+ * one, otherwise the compressor configured by the kvs rparams (NULL if
+ * compaction doesn't compress values).
+ */
+/* MTF_MOCK */
+const struct cn_vcomp *
+cn_get_vcomp(struct cn *cn);
+
+/**
+ * cn_vcomp_train_begin() - claim the job of training a zstd dictionary
+ * @cn: cn handle
+ *
+ * Returns true if the caller should collect samples and then call
+ * cn_vcomp_train_end(), which it must do whether or not it trains.
+ */
+/* MTF_MOCK */
+bool
+cn_vcomp_train_begin(struct cn *cn);
+
+/**
+ * cn_vcomp_train_end() - finish training a zstd dictionary
+ * @cn:    cn handle
+ * @vcomp: compressor with the trained dictionary (NULL if none)
+ * @tried: true if training was attempted
+ *
+ * On success, ownership of @vcomp passes to @cn.  Training is given up
+ * on after a few failed attempts.
+ */
+/* MTF_MOCK */
+void
+cn_vcomp_train_end(struct cn *cn, struct cn_vcomp *vcomp, bool tried);
+
 /* MTF_MOCK */
 struct mpool *
 cn_get_dataset(const struct cn *cn);
@@ -116,6 +155,20 @@ cn_get(
     enum key_lookup_res *res,
     struct kvs_buf *     vbuf);
 
+/**
+ * cn_get_multi() - search cn for a batch of keys
+ *
+ * Only keys whose result in @resv is %NOT_FOUND on entry are searched.
+ */
+merr_t
+cn_get_multi(
+    struct cn *          cn,
+    struct kvs_ktuple *  ktv,
+    u64                  seq,
+    enum key_lookup_res *resv,
+    struct kvs_buf *     vbufv,
+    uint                 cnt);
+
 struct query_ctx;
 
 merr_t
@@ -149,6 +202,81 @@ cn_ingestv(
     u64                   *min_seqno_out,
     u64                   *max_seqno_out);
 
+struct cn_bulk;
+
+/**
+ * cn_bulk_create() - create a loader that builds leaf kvsets directly
+ * @cn:     cn handle
+ * @behind: link the load behind the existing data of a live tree
+ * @bulkp:  (output) bulk loader
+ *
+ * Keys added to a bulk loader are routed down the tree exactly as spills
+ * would route them, to the first node below the root that is either a
+ * leaf or does not yet exist, and written by one kvset builder per such
+ * node.  cn_bulk_commit() then publishes the resulting kvsets in a single
+ * cndb transaction, so the load becomes visible atomically.  Each key and
+ * value is written to media once, bypassing c0, the WAL, ingest and the
+ * spills that would otherwise carry it down the tree.
+ *
+ * Without @behind the tree must be empty.  With @behind each kvset is
+ * linked at the tail of its node with a dgen older than that of any kvset
+ * on the path from the root, so the load is older than all existing data.
+ *
+ * Return: EINVAL for a capped kvs, EBUSY if the cn tree is not empty
+ * (or, with @behind, if there's already a loader linking behind it).
+ */
+merr_t
+cn_bulk_create(struct cn *cn, bool behind, struct cn_bulk **bulkp);
+
+/**
+ * cn_bulk_add() - add a key-value pair to a bulk load
+ * @bulk: bulk loader
+ * @kt:   key, which must be greater than the previously added key
+ * @vt:   value
+ */
+merr_t
+cn_bulk_add(struct cn_bulk *bulk, const struct kvs_ktuple *kt, const struct kvs_vtuple *vt);
+
+/**
+ * cn_bulk_commit() - atomically add the loaded kvsets to the cn tree
+ * @bulk: bulk loader
+ *
+ * Return: EBUSY if the cn tree is no longer empty, or if a destination
+ * leaf of a load linking behind was spilled while the load was built.
+ * EAGAIN if there is no free dgen below that of the kvsets on the path
+ * to a destination node.
+ */
+merr_t
+cn_bulk_commit(struct cn_bulk *bulk);
+
+void
+cn_bulk_destroy(struct cn_bulk *bulk);
+
+/**
+ * cn_split_keys() - choose keys that divide a key range into slices of similar size
+ * @cn:       cn handle
+ * @pfx:      restrict the range to keys with this prefix
+ * @pfx_len:  length of @pfx, zero for the entire cn
+ * @splitc:   maximum number of split keys (one fewer than the number of slices)
+ * @buf:      buffer into which the split keys are copied
+ * @bufsz:    size of @buf
+ * @splitv:   (output) split keys in ascending order, pointing into @buf
+ * @splitcnt: (output) number of split keys
+ *
+ * Only keys in cn are considered, keys in c0 and lc are assumed to be
+ * comparatively few.
+ */
+merr_t
+cn_split_keys(
+    struct cn *        cn,
+    const void *       pfx,
+    uint               pfx_len,
+    uint               splitc,
+    void *             buf,
+    size_t             bufsz,
+    struct kvs_ktuple *splitv,
+    uint *             splitcnt);
+
 /* MTF_MOCK */
 struct perfc_set *
 cn_get_ingest_perfc(const struct cn *cn);
@@ -180,6 +308,25 @@ cn_get_io_wq(struct cn *cn);
 struct workqueue_struct *
 cn_get_maint_wq(struct cn *cn);
 
+/**
+ * cn_get_slice_wq() - get the workqueue for helping with sliced compactions
+ * @cn:     cn handle
+ * @slices: (output) max number of key range slices per compaction
+ */
+/* MTF_MOCK */
+struct workqueue_struct *
+cn_get_slice_wq(struct cn *cn, uint *slices);
+
+/**
+ * cn_get_iogov() - get the IO governor for compaction reads and writes
+ * @cn: cn handle
+ *
+ * Return: NULL if maintenance is not enabled for @cn.
+ */
+/* MTF_MOCK */
+struct cn_iogov *
+cn_get_iogov(struct cn *cn);
+
 /* MTF_MOCK */
 struct csched *
 cn_get_sched(struct cn *cn);
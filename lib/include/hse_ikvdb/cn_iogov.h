@@ -0,0 +1,94 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/*
+ * Copyright (C) 2021 Micron Technology, Inc.  All rights reserved.
+ */
+
+#ifndef HSE_IKVDB_CN_IOGOV_H
+#define HSE_IKVDB_CN_IOGOV_H
+
+#include <hse_util/arch.h>
+#include <hse_util/atomic.h>
+#include <hse_util/inttypes.h>
+#include <hse_util/time.h>
+#include <hse_util/token_bucket.h>
+
+struct throttle_sensor;
+
+/**
+ * enum cn_iogov_class - compaction IO priority classes
+ * @CN_IOGOV_ROOT:   root node spills and compactions (urgent, gate ingest)
+ * @CN_IOGOV_INTERN: internal node spills
+ * @CN_IOGOV_LEAF:   all other compactions (e.g., leaf garbage compaction)
+ */
+enum cn_iogov_class {
+    CN_IOGOV_ROOT,
+    CN_IOGOV_INTERN,
+    CN_IOGOV_LEAF,
+    CN_IOGOV_CLASS_CNT,
+};
+
+#define CN_IOGOV_SENSOR_MAX (4)
+
+/**
+ * struct cn_iogov - compaction IO governor
+ * @ig_rate:     total rate across all classes in bytes/sec (0: unlimited)
+ * @ig_adjust:   time (ns) at which to next re-evaluate the sensors
+ * @ig_factor:   current rate multiplier (percent) for root and internal spills
+ * @ig_sensorc:  number of sensors in @ig_sensorv
+ * @ig_sensorv:  throttle sensors that indicate backpressure
+ * @ig_tbv:      one token bucket per class
+ *
+ * Compaction reads and mblock writes draw tokens from the bucket of their
+ * class, and sleep when the bucket is in debt.  Each class is given a fixed
+ * share of the total rate so that maintenance cannot monopolize the media,
+ * but root and internal spills are loosened as the throttle sensors rise
+ * (up to unlimited once a sensor reaches THROTTLE_SENSOR_SCALE), since
+ * stalling them then stalls ingest.  Leaf compactions never relieve ingest
+ * backpressure, so their share is never loosened.
+ */
+struct cn_iogov {
+    u64                     ig_rate;
+    atomic_ulong            ig_adjust;
+    uint                    ig_factor;
+    uint                    ig_sensorc;
+    struct throttle_sensor *ig_sensorv[CN_IOGOV_SENSOR_MAX];
+    struct tbkt             ig_tbv[CN_IOGOV_CLASS_CNT];
+};
+
+/**
+ * cn_iogov_init() - initialize a compaction IO governor
+ * @gov:     governor
+ * @rate_mb: total compaction IO rate in MiB/s (0: unlimited)
+ */
+void
+cn_iogov_init(struct cn_iogov *gov, uint rate_mb);
+
+/**
+ * cn_iogov_sensors_set() - set the sensors used to loosen the governor
+ * @gov:     governor
+ * @sensorv: vector of throttle sensors (NULL entries are ignored)
+ * @sensorc: number of sensors in @sensorv
+ */
+void
+cn_iogov_sensors_set(struct cn_iogov *gov, struct throttle_sensor **sensorv, uint sensorc);
+
+void
+cn_iogov_request_slow(struct cn_iogov *gov, enum cn_iogov_class cls, u64 bytes);
+
+/**
+ * cn_iogov_request() - acquire IO tokens, sleeping if the class is over budget
+ * @gov:   governor (may be NULL)
+ * @cls:   IO class of the caller
+ * @bytes: number of bytes read or written
+ *
+ * Callers charge IO after the fact (i.e., once the read completes or the
+ * write is issued), so the delay is incurred before their next IO.
+ */
+static inline void
+cn_iogov_request(struct cn_iogov *gov, enum cn_iogov_class cls, u64 bytes)
+{
+    if (gov && gov->ig_rate && bytes)
+        cn_iogov_request_slow(gov, cls, bytes);
+}
+
+#endif
@@ -10,6 +10,8 @@
 #include <hse_util/hse_err.h>
 #include <hse_util/workqueue.h>
 
+#include <hse_ikvdb/cn_iogov.h>
+
 /* MTF_MOCK_DECL(cn_kvdb) */
 
 /**
@@ -18,6 +20,8 @@
  * @cnd_vblk_cnt:  number of cn vblocks in kvdb
  * @cnd_kblk_size: sum of on-media sizes of all cn kblocks in kvdb (bytes)
  * @cnd_vblk_size: sum of on-media sizes of all cn vblocks in kvdb (bytes)
+ * @cn_slices:     max number of key range slices per spill or kv-compaction
+ * @cn_iogov:      compaction IO governor shared by all cn trees in kvdb
  */
 struct cn_kvdb {
     atomic_ulong cnd_kblk_cnt;
@@ -27,16 +31,36 @@ struct cn_kvdb {
 
     struct workqueue_struct *cn_maint_wq;
     struct workqueue_struct *cn_io_wq;
+    struct workqueue_struct *cn_slice_wq;
+    uint                     cn_slices;
+    struct cn_iogov          cn_iogov;
 };
 
 /* MTF_MOCK */
 merr_t
-cn_kvdb_create(uint cn_maint_threads, uint cn_io_threads, struct cn_kvdb **h);
+cn_kvdb_create(
+    uint             cn_maint_threads,
+    uint             cn_io_threads,
+    uint             cn_slices,
+    uint             cn_io_rate_mb,
+    struct cn_kvdb **h);
 
 /* MTF_MOCK */
 void
 cn_kvdb_destroy(struct cn_kvdb *h);
 
+/**
+ * cn_kvdb_throttle_sensors() - set the sensors that loosen the IO governor
+ * @h:       cn_kvdb handle
+ * @sensorv: vector of throttle sensors
+ * @sensorc: number of sensors in @sensorv
+ */
+static inline void
+cn_kvdb_throttle_sensors(struct cn_kvdb *h, struct throttle_sensor **sensorv, uint sensorc)
+{
+    cn_iogov_sensors_set(&h->cn_iogov, sensorv, sensorc);
+}
+
 #if HSE_MOCKING
 #include "cn_kvdb_ut.h"
 #endif /* HSE_MOCKING */
@@ -48,10 +48,31 @@ enum sp3_qnum {
 
 /**
  * enum csched_policy - compaction scheduler policy
- * csched_policy_old:  Do not use csched.  Use old tree walker scheduler.
- * csched_policy_noop: Disable scheduler.
+ * csched_policy_old:   Do not use csched.  Use old tree walker scheduler.
+ * csched_policy_sp3:   Space amp scheduler driven by static thresholds.
+ * csched_policy_adapt: sp3 with job selection driven by measured write,
+ *                      space and read amp (see csched_adapt_goal).
+ * csched_policy_noop:  Disable scheduler.
  */
-enum csched_policy { csched_policy_old = 0, csched_policy_sp3 = 3, csched_policy_noop = 0xff };
+enum csched_policy {
+    csched_policy_old = 0,
+    csched_policy_sp3 = 3,
+    csched_policy_adapt = 4,
+    csched_policy_noop = 0xff,
+};
+
+/**
+ * enum csched_adapt_goal - what csched_policy_adapt minimizes
+ *
+ * Space amp is always held below csched_samp_max and read amp below
+ * csched_adapt_ramp_max, the goal determines how the scheduler spends
+ * any remaining compaction bandwidth.
+ */
+enum csched_adapt_goal {
+    csched_adapt_goal_wamp = 0,
+    csched_adapt_goal_ramp = 1,
+    csched_adapt_goal_samp = 2,
+};
 
 /**
  * csched_create() - create a scheduler for kvdb compaction work
@@ -80,6 +101,16 @@ csched_destroy(struct csched *csched);
 void
 csched_notify_ingest(struct csched *handle, struct cn_tree *tree, size_t alen, size_t wlen);
 
+/**
+ * csched_notify_load() - notify that kvsets were bulk loaded below the root
+ * @handle: csched handle
+ * @tree:   cn tree into whose root's children the kvsets were added
+ * @diff:   change in the tree's samp stats
+ */
+/* MTF_MOCK */
+void
+csched_notify_load(struct csched *handle, struct cn_tree *tree, const struct cn_samp_stats *diff);
+
 /* MTF_MOCK */
 void
 csched_tree_add(struct csched *csched, struct cn_tree *tree);
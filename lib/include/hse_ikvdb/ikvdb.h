@@ -393,6 +393,21 @@ ikvdb_kvs_get(
     enum key_lookup_res *res,
     struct kvs_buf *     vbuf);
 
+/**
+ * ikvdb_kvs_get_multi() - search for a batch of keys within the KVS using a
+ * single view. Each key's result and value are returned in the corresponding
+ * elements of resv[] and vbufv[].
+ */
+merr_t
+ikvdb_kvs_get_multi(
+    struct hse_kvs *     kvs,
+    unsigned int         flags,
+    struct hse_kvdb_txn *txn,
+    struct kvs_ktuple *  ktv,
+    enum key_lookup_res *resv,
+    struct kvs_buf *     vbufv,
+    unsigned int         cnt);
+
 /**
  * ikvdb_kvs_del() - remove the supplied key and associated value from the KVS
  * indexed by opspec->kop_index.
@@ -429,6 +444,48 @@ ikvdb_kvs_prefix_delete(
     struct hse_kvdb_txn *txn,
     struct kvs_ktuple *  kt);
 
+/**
+ * ikvdb_kvs_range_delete() - delete all keys in the range [kt, kt_end)
+ * @kvs:    kvs handle
+ * @flags:  reserved
+ * @kt:     smallest key to delete
+ * @kt_end: first key past the end of the range
+ *
+ * Range deletes are recorded as range tombstones and are not supported
+ * within transactions.
+ */
+/* MTF_MOCK */
+merr_t
+ikvdb_kvs_range_delete(
+    struct hse_kvs *   kvs,
+    unsigned int       flags,
+    struct kvs_ktuple *kt,
+    struct kvs_ktuple *kt_end);
+
+struct hse_kvs_bulk;
+
+/**
+ * ikvdb_kvs_bulk_create() - create a loader that builds cn kvsets directly
+ * @kvs:   kvs handle
+ * @flags: HSE_KVS_BULK_BEHIND to link the load behind existing data
+ * @bulk:  (output) bulk loader
+ *
+ * See cn_bulk_create() for details.  Without HSE_KVS_BULK_BEHIND both the
+ * create and the commit also fail with EBUSY while c0 or LC hold data for
+ * the kvs.
+ */
+merr_t
+ikvdb_kvs_bulk_create(struct hse_kvs *kvs, unsigned int flags, struct hse_kvs_bulk **bulk);
+
+merr_t
+ikvdb_kvs_bulk_put(struct hse_kvs_bulk *bulk, struct kvs_ktuple *kt, struct kvs_vtuple *vt);
+
+merr_t
+ikvdb_kvs_bulk_commit(struct hse_kvs_bulk *bulk);
+
+void
+ikvdb_kvs_bulk_destroy(struct hse_kvs_bulk *bulk);
+
 merr_t
 ikvdb_kvs_param_get(
     struct hse_kvs *kvs,
@@ -510,6 +567,36 @@ ikvdb_kvs_cursor_create(
     size_t                  pfx_len,
     struct hse_kvs_cursor **cursor);
 
+struct hse_kvs_split_key;
+
+/**
+ * ikvdb_kvs_range_split() - choose keys that divide a KVS into slices of similar size
+ */
+merr_t
+ikvdb_kvs_range_split(
+    struct hse_kvs *          kvs,
+    const void *              prefix,
+    size_t                    pfx_len,
+    void *                    buf,
+    size_t                    buf_sz,
+    struct hse_kvs_split_key *splitv,
+    size_t                    splitc,
+    size_t *                  split_cnt);
+
+/**
+ * ikvdb_kvs_cursor_create_slices() - create (splitc + 1) cursors with one view,
+ * each bounded to the slice of the KVS between two consecutive split keys
+ */
+merr_t
+ikvdb_kvs_cursor_create_slices(
+    struct hse_kvs *                kvs,
+    unsigned int                    flags,
+    const void *                    prefix,
+    size_t                          pfx_len,
+    const struct hse_kvs_split_key *splitv,
+    size_t                          splitc,
+    struct hse_kvs_cursor **        cursorv);
+
 /**
  * ikvdb_kvs_cursor_update() - incorporate updates since cursor created
  */
@@ -558,6 +645,22 @@ ikvdb_kvs_cursor_read_copy(
     size_t *               val_len,
     bool *                 eof);
 
+struct hse_kvs_cursor_kv;
+
+/**
+ * ikvdb_kvs_cursor_read_batch() - read many pairs into a caller's arena
+ */
+merr_t
+ikvdb_kvs_cursor_read_batch(
+    struct hse_kvs_cursor *   cur,
+    unsigned int              flags,
+    void *                    buf,
+    size_t                    buf_sz,
+    struct hse_kvs_cursor_kv *kvv,
+    size_t                    kvc,
+    size_t *                  kv_cnt,
+    bool *                    eof);
+
 /**
  * ikvdb_kvs_cursor_destroy() - allow the caller to indicate that is is done
  * with the scan and release the associated cursor
@@ -655,6 +758,15 @@ ikvdb_wal_replay_prefix_del(
     u64                   seqno,
     struct kvs_ktuple    *kt);
 
+merr_t
+ikvdb_wal_replay_range_del(
+    struct ikvdb         *ikvdb,
+    struct ikvdb_kvs_hdl *ikvsh,
+    u64                   cnid,
+    u64                   seqno,
+    struct kvs_ktuple    *kt,
+    struct kvs_ktuple    *kt_end);
+
 void
 ikvdb_wal_replay_seqno_set(struct ikvdb *ikvdb, uint64_t seqno);
 
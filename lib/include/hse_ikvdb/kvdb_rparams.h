@@ -72,9 +72,13 @@ struct kvdb_rparams {
     uint64_t csched_leaf_comp_params;
     uint64_t csched_leaf_len_params;
     uint64_t csched_node_min_ttl;
+    uint32_t csched_adapt_ramp_max;
+    uint8_t  csched_adapt_goal;
 
     uint32_t          dur_bufsz_mb;
     uint32_t          dur_intvl_ms;
+    uint32_t          dur_sync_lat_us;
+    uint32_t          dur_aio_qdepth;
     uint8_t           dur_throttle_lo_th;
     uint8_t           dur_throttle_hi_th;
     bool              dur_enable;
@@ -96,8 +100,12 @@ struct kvdb_rparams {
     uint32_t cndb_entries;
     uint32_t c0_maint_threads;
     uint32_t c0_ingest_threads;
+    uint32_t c0_ingest_parts;
     uint16_t cn_maint_threads;
     uint16_t cn_io_threads;
+    uint32_t cn_compaction_slices;
+    uint32_t cn_io_rate_mb;
+    uint32_t cn_bcache_size_mb;
 
     uint32_t keylock_tables;
 
@@ -113,6 +113,8 @@ kvs_init(void) HSE_COLD;
 void
 kvs_fini(void) HSE_COLD;
 
+struct hse_kvs_cursor_kv;
+
 /* kvs_cursor interfaces...
  */
 merr_t
@@ -127,6 +129,31 @@ kvs_cursor_seek(
 merr_t
 kvs_cursor_read(struct hse_kvs_cursor *cursor, unsigned int flags, bool *eof);
 
+/**
+ * kvs_cursor_read_batch() - read up to @kvc pairs in a single pass
+ * @cursor: cursor handle
+ * @flags:  HSE_CURSOR_READ_KEYS to skip copying values
+ * @buf:    arena into which keys (and values) are copied
+ * @bufsz:  size of @buf
+ * @kvv:    vector of pairs to fill in, pointing into @buf
+ * @kvc:    number of elements in @kvv
+ * @kvcnt:  (output) number of pairs read
+ * @eof:    (output) true if the cursor was at eof
+ *
+ * A pair that doesn't fit in what remains of @buf is left to be returned by
+ * the next read.  Returns ENOSPC if not even the first pair fits.
+ */
+merr_t
+kvs_cursor_read_batch(
+    struct hse_kvs_cursor *   cursor,
+    unsigned int              flags,
+    void *                    buf,
+    size_t                    bufsz,
+    struct hse_kvs_cursor_kv *kvv,
+    size_t                    kvc,
+    size_t *                  kvcnt,
+    bool *                    eof);
+
 void
 kvs_cursor_key_copy(
     struct hse_kvs_cursor  *cursor,
@@ -174,7 +201,8 @@ kvs_put(
     struct hse_kvdb_txn *    txn,
     struct kvs_ktuple *      kt,
     struct kvs_vtuple       *vt,
-    u64                      seqno);
+    u64                      seqno,
+    unsigned int             flags);
 
 merr_t
 kvs_get(
@@ -185,6 +213,16 @@ kvs_get(
     enum key_lookup_res *res,
     struct kvs_buf *     vbuf);
 
+merr_t
+kvs_get_multi(
+    struct ikvs *        ikvs,
+    struct hse_kvdb_txn *txn,
+    struct kvs_ktuple *  ktv,
+    u64                  seqno,
+    enum key_lookup_res *resv,
+    struct kvs_buf *     vbufv,
+    uint                 cnt);
+
 merr_t
 kvs_del(struct ikvs *ikvs, struct hse_kvdb_txn *txn, struct kvs_ktuple *key, u64 seqno);
 
@@ -201,11 +239,23 @@ kvs_pfx_probe(
 merr_t
 kvs_prefix_del(struct ikvs *ikvs, struct hse_kvdb_txn *txn, struct kvs_ktuple *key, u64 seqno);
 
+merr_t
+kvs_range_del(
+    struct ikvs *      ikvs,
+    struct kvs_ktuple *kt,
+    struct kvs_ktuple *kt_end,
+    uintptr_t          seqnoref);
+
 void
 kvs_maint_task(struct ikvs *ikvs, u64 now);
 
 struct hse_kvs_cursor *
-kvs_cursor_alloc(struct ikvs *ikvs, const void *prefix, size_t pfx_len, bool reverse);
+kvs_cursor_alloc(
+    struct ikvs *ikvs,
+    const void * prefix,
+    size_t       pfx_len,
+    bool         reverse,
+    bool         keys_only);
 
 void
 kvs_cursor_free(struct hse_kvs_cursor *cursor);
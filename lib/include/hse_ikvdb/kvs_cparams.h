@@ -14,12 +14,27 @@
 #include <hse_util/compiler.h>
 #include <hse_util/hse_err.h>
 
+#define KVS_FILTER_PARAM_BLOOM "bloom"
+#define KVS_FILTER_PARAM_XOR   "xor"
+
+/* Type of the per-kblock key filter built for a kvs.
+ */
+enum kvs_filter_type
+{
+    KVS_FILTER_BLOOM,
+    KVS_FILTER_XOR,
+};
+
+#define KVS_FILTER_MIN KVS_FILTER_BLOOM
+#define KVS_FILTER_MAX KVS_FILTER_XOR
+
 struct kvs_cparams {
 	uint32_t  fanout;
     uint32_t  pfx_len;
     uint32_t  pfx_pivot;
     uint32_t  kvs_ext01;
     uint32_t  sfx_len;
+    enum kvs_filter_type filter_type;
 };
 
 const struct param_spec *
@@ -46,6 +46,7 @@ struct kvs_rparams {
     uint64_t cn_compact_kblk_ra;
     uint64_t cn_compact_vblk_ra;
     uint64_t cn_compact_vra;
+    uint32_t cn_compact_aio_qdepth;
 
     uint64_t cn_node_size_lo;
     uint64_t cn_node_size_hi;
@@ -64,6 +65,7 @@ struct kvs_rparams {
 
     uint64_t cn_mcache_kra_params;
     uint64_t cn_mcache_vra_params;
+    uint8_t  cn_bcache;
 
     bool     cn_bloom_create;
     uint64_t cn_bloom_lookup;
@@ -79,6 +81,11 @@ struct kvs_rparams {
 
     uint64_t             vcompmin;
     enum vcomp_algorithm value_compression;
+    bool                 vcomp_defer;
+    enum vcomp_algorithm cn_vcomp;
+    uint32_t             cn_vcomp_level;
+    uint32_t             cn_vcomp_dictsz;
+    uint32_t             cn_vcomp_blksz;
 };
 
 const struct param_spec *
@@ -11,6 +11,7 @@
 
 #include <hse_ikvdb/tuple.h>
 #include <hse_ikvdb/blk_list.h>
+#include <hse_ikvdb/cn_iogov.h>
 #include <hse_ikvdb/omf_kmd.h>
 #include <hse_ikvdb/mclass_policy.h>
 
@@ -21,6 +22,8 @@ struct kvset_builder;
 struct kvs_rparams;
 struct perfc_set;
 struct cn_merge_stats;
+struct cn_vcomp;
+struct rtomb;
 
 /* MTF_MOCK_DECL(kvset_builder) */
 /* MTF_MOCK */
@@ -86,10 +89,47 @@ kvset_builder_add_vref(
     uint                    vlen,
     uint                    complen);
 
+/* MTF_MOCK */
+merr_t
+kvset_builder_add_bref(
+    struct kvset_builder   *self,
+    u64                     seq,
+    uint                    vbidx,
+    uint                    vboff,
+    uint                    vlen,
+    uint                    boff);
+
 /* MTF_MOCK */
 merr_t
 kvset_builder_add_nonval(struct kvset_builder *self, u64 seq, enum kmd_vtype vtype);
 
+/**
+ * kvset_builder_add_expire() - set the expiration time of the next value
+ * @builder: kvset builder object
+ * @expire:  expiration time in seconds since the epoch, zero if none
+ *
+ * Must be called immediately before the kvset_builder_add_val(),
+ * kvset_builder_add_vref() or kvset_builder_add_bref() call that adds
+ * the value to which @expire applies.  Tombstones do not expire.
+ */
+/* MTF_MOCK */
+merr_t
+kvset_builder_add_expire(struct kvset_builder *builder, u64 expire);
+
+/**
+ * kvset_builder_add_rtomb() - add a range tombstone to a kvset
+ * @builder: kvset builder object
+ * @rt:      range tombstone, copied by the builder
+ *
+ * Range tombstones are stored in the last kblock of the kvset, alongside
+ * the prefix tombstones, and may be added at any time before the mblocks
+ * are retrieved.  In a partitioned build they must be added to the last
+ * partition, during its key pass.
+ */
+/* MTF_MOCK */
+merr_t
+kvset_builder_add_rtomb(struct kvset_builder *builder, const struct rtomb *rt);
+
 /* MTF_MOCK */
 void
 kvset_builder_destroy(struct kvset_builder *builder);
@@ -98,6 +138,105 @@ kvset_builder_destroy(struct kvset_builder *builder);
 void
 kvset_mblocks_destroy(struct kvset_mblocks *kvset);
 
+/**
+ * kvset_builder_part_begin() - start a partitioned build
+ * @builder: kvset builder object
+ *
+ * A kvset may be built in parallel by several builders, each of which is
+ * given a disjoint key range (a partition) of the kvset's entries, such that
+ * the ranges of builders[0] through builders[n-1] are in ascending key order.
+ * Each builder's vblocks form a separate vgroup within the resulting kvset
+ * if the builders are created with distinct vgroup IDs.  Since the partitions
+ * are in key order, the builders may instead share one vgroup ID such that
+ * the kvset's values are laid out as if it had been built by one builder.
+ *
+ * The kvset's vblock indices aren't known until all the builders have written
+ * their vblocks, so the entries of each partition are added twice:
+ *
+ *  1. The value pass: Add each entry via kvset_builder_add_val() and
+ *     kvset_builder_add_key() as usual, which writes only the vblocks,
+ *     then call kvset_builder_part_vblocks() to get the vblock count.
+ *  2. Call kvset_builder_part_rebase() with the sum of the vblock counts
+ *     of all the builders of preceding partitions.
+ *  3. The key pass: Add the same entries in the same order again, which
+ *     generates the kblocks.
+ *  4. Call kvset_builder_join() on all the builders to obtain the mblocks
+ *     of the kvset.
+ *
+ * If the entries cannot cheaply be produced twice, call kvset_builder_part_log()
+ * before the value pass, and in step 3 call kvset_builder_part_replay() rather
+ * than adding the entries again.  The log is bounded in size, so if
+ * kvset_builder_part_logged() returns false after the value pass the entries
+ * must nevertheless be added again.
+ *
+ * Only kvset_builder_add_val() and kvset_builder_add_key() may be used to
+ * add entries to a partitioned build, and prefix tombstones must not be
+ * added to any but the last partition.
+ */
+/* MTF_MOCK */
+void
+kvset_builder_part_begin(struct kvset_builder *builder);
+
+/**
+ * kvset_builder_part_log() - retain the entries of the value pass
+ * @builder: kvset builder object
+ *
+ * The keys, inline values and value metadata (but not the vblock values)
+ * added during the value pass are retained in memory until the key pass
+ * is run by kvset_builder_part_replay().
+ */
+/* MTF_MOCK */
+void
+kvset_builder_part_log(struct kvset_builder *builder);
+
+/**
+ * kvset_builder_part_logged() - check whether the value pass log is complete
+ * @builder: kvset builder object
+ *
+ * Returns false if kvset_builder_part_log() was not called, or if the log
+ * grew too large and was discarded during the value pass.
+ */
+/* MTF_MOCK */
+bool
+kvset_builder_part_logged(struct kvset_builder *builder);
+
+/**
+ * kvset_builder_part_unlog() - discard the entries retained by the value pass
+ * @builder: kvset builder object
+ *
+ * The entries must then be added again in the key pass.
+ */
+/* MTF_MOCK */
+void
+kvset_builder_part_unlog(struct kvset_builder *builder);
+
+/* MTF_MOCK */
+merr_t
+kvset_builder_part_replay(struct kvset_builder *builder);
+
+/* MTF_MOCK */
+merr_t
+kvset_builder_part_vblocks(struct kvset_builder *builder, uint *vblkc);
+
+/* MTF_MOCK */
+void
+kvset_builder_part_rebase(struct kvset_builder *builder, uint vbidx_base);
+
+/**
+ * kvset_builder_join() - finish a partitioned build
+ * @bldv:   builders, in partition order
+ * @bldc:   number of builders in @bldv
+ * @mblocks: (output) mblocks of the kvset
+ *
+ * Builders to which no entries were added are permitted (they contribute
+ * no mblocks).  On success, ownership of all the mblocks is transferred
+ * to @mblocks.  The builders must be destroyed via kvset_builder_destroy() regardless
+ * of whether or not kvset_builder_join() succeeds.
+ */
+/* MTF_MOCK */
+merr_t
+kvset_builder_join(struct kvset_builder **bldv, uint bldc, struct kvset_mblocks *mblocks);
+
 /* MTF_MOCK */
 void
 kvset_builder_set_agegroup(struct kvset_builder *self, enum hse_mclass_policy_age age);
@@ -106,6 +245,30 @@ kvset_builder_set_agegroup(struct kvset_builder *self, enum hse_mclass_policy_ag
 void
 kvset_builder_set_merge_stats(struct kvset_builder *self, struct cn_merge_stats *stats);
 
+/**
+ * kvset_builder_set_iogov() - charge mblock writes to an IO governor
+ * @self: kvset builder object
+ * @gov:  IO governor (NULL to disable)
+ * @cls:  IO class to charge
+ */
+/* MTF_MOCK */
+void
+kvset_builder_set_iogov(struct kvset_builder *self, struct cn_iogov *gov, enum cn_iogov_class cls);
+
+/**
+ * kvset_builder_set_vcomp() - compress values added to the builder
+ * @self:  kvset builder object
+ * @vcomp: value compressor, must outlive the builder
+ *
+ * Uncompressed values too large to be stored inline are compressed with
+ * @vcomp.  Values added already compressed must have been compressed
+ * with the same algorithm and dictionary as @vcomp, or with lz4 if
+ * @vcomp is NULL.  Must be called before the first value is added.
+ */
+/* MTF_MOCK */
+merr_t
+kvset_builder_set_vcomp(struct kvset_builder *self, const struct cn_vcomp *vcomp);
+
 #if HSE_MOCKING
 #include "kvset_builder_ut.h"
 #endif /* HSE_MOCKING */
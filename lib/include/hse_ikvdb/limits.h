@@ -24,6 +24,23 @@
 #define HSE_C0_INGEST_THREADS_DFLT  (3)
 #define HSE_C0_INGEST_THREADS_MAX   (5)
 
+#define HSE_C0_INGEST_PARTS_MIN     (1)
+#define HSE_C0_INGEST_PARTS_DFLT    (4)
+#define HSE_C0_INGEST_PARTS_MAX     (16)
+
+#define HSE_CN_COMPACTION_SLICES_MIN    (1)
+#define HSE_CN_COMPACTION_SLICES_DFLT   (4)
+#define HSE_CN_COMPACTION_SLICES_MAX    (16)
+
+#define HSE_CN_VCOMP_LEVEL_MIN      (1)
+#define HSE_CN_VCOMP_LEVEL_DFLT     (3)
+#define HSE_CN_VCOMP_LEVEL_MAX      (19)
+
+#define HSE_CN_VCOMP_DICTSZ_DFLT    (16 * 1024)
+#define HSE_CN_VCOMP_DICTSZ_MAX     (110 * 1024)
+
+#define HSE_CN_VCOMP_BLKSZ_MAX      (16 * 1024)
+
 #define HSE_C0_MAINT_THREADS_MIN    (1)
 #define HSE_C0_MAINT_THREADS_DFLT   (3)
 #define HSE_C0_MAINT_THREADS_MAX    (7)
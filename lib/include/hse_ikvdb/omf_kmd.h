@@ -15,6 +15,9 @@
  *
  *   Member  Encoding    Min Typ Max  Notes
  *   ------  --------    --- --- ---  -----
+ *   emark   u8           1   1   1   values with a ttl only, see below
+ *   expire  hg64         2   6   8   values with a ttl only, expiration
+ *                                    time in seconds since the epoch
  *   vtype   u8           1   1   1
  *   seqno   hg64         2   2   8   sequence number
  *   vboff   u32          4   4   4   not present for tombs
@@ -22,6 +25,8 @@
  *   vlen    hg32_1024m   1   1   4   not present for tombs
  *   clen    hg32_1024m   1   1   4   not present for tombs and
  *                                    non-compressed values
+ *   boff    hg32_1024m   1   2   4   block values only, offset of the
+ *                                    value within its uncompressed block
  *
  * Per-entry overhead:
  *
@@ -29,6 +34,8 @@
  *      3      3      9     A key with 1 tombstone entry
  *      9      9     19     A key with a non-zero length value
  *     10     10     23     A compressed key
+ *     10     11     23     A value in a compressed block
+ *      3      7      9     Additional overhead of a value with a ttl
  *
  * KMD List:
  *
@@ -64,6 +71,12 @@
  *    }
  *
  * Notes:
+ *   - A value put with a ttl is prefixed by KMD_EXPIRE_MARK and its
+ *     expiration time.  kmd_type_seq() skips the prefix, while
+ *     kmd_type_seq_expire() returns it.  The prefix is counted as part
+ *     of the entry that follows it, not as a separate entry.
+ *   - The vboff of a block value (vtype_bval) is the offset of its
+ *     compressed block within the vblock (see struct vblock_cblk_omf).
  *   - Vblock offfsets are not encoded because the vast majority of offsets in
  *     a large vblock will exceed 16MB and thus require 4-bytes to encode
  *     anyhow.
@@ -71,16 +84,20 @@
 
 #define KMD_MAX_COUNT HG32_1024M_MAX
 
-#define KMD_MAX_ENCODED_ENTRY_LEN 23
+#define KMD_MAX_ENCODED_ENTRY_LEN 32
 #define KMD_MAX_ENCODED_COUNT_LEN 4
 
+/* Prefix byte of an entry's expiration time, distinct from every vtype. */
+#define KMD_EXPIRE_MARK 0x80
+
 enum kmd_vtype {
     vtype_val = 0,   /* normal value            */
     vtype_zval = 1,  /* zero-length value       */
     vtype_tomb = 2,  /* tombstone               */
     vtype_ptomb = 3, /* prefix tombstone        */
     vtype_ival = 4,  /* immediate (short) value */
-    vtype_cval = 5   /* LZ4 compressed value */
+    vtype_cval = 5,  /* LZ4 compressed value */
+    vtype_bval = 6   /* value in a compressed block */
 };
 
 static inline uint
@@ -96,6 +113,14 @@ kmd_set_count(void *kmd, size_t *off, uint count)
     encode_hg32_1024m(kmd, off, count);
 }
 
+static inline void
+kmd_add_expire(void *kmd, size_t *off, u64 expire)
+{
+    ((u8 *)kmd)[*off] = KMD_EXPIRE_MARK;
+    *off += 1;
+    encode_hg64(kmd, off, expire);
+}
+
 static inline void
 kmd_add_tomb(void *kmd, size_t *off, u64 seq)
 {
@@ -163,6 +188,22 @@ kmd_add_cval(void *kmd, size_t *off, u64 seq, uint vbidx, uint vboff, uint vlen,
     encode_hg32_1024m(kmd, off, complen);
 }
 
+static inline void
+kmd_add_bval(void *kmd, size_t *off, u64 seq, uint vbidx, uint vboff, uint vlen, uint boff)
+{
+    __be32 val32;
+
+    ((u8 *)kmd)[*off] = vtype_bval;
+    *off += 1;
+    encode_hg64(kmd, off, seq);
+    encode_hg16_32k(kmd, off, vbidx);
+    val32 = cpu_to_be32(vboff);
+    memcpy(kmd + *off, &val32, sizeof(val32));
+    *off += sizeof(val32);
+    encode_hg32_1024m(kmd, off, vlen);
+    encode_hg32_1024m(kmd, off, boff);
+}
+
 static inline uint
 kmd_count(const void *kmd, size_t *off)
 {
@@ -170,13 +211,28 @@ kmd_count(const void *kmd, size_t *off)
 }
 
 static inline void
-kmd_type_seq(const void *kmd, size_t *off, enum kmd_vtype *vtype, u64 *seq)
+kmd_type_seq_expire(const void *kmd, size_t *off, enum kmd_vtype *vtype, u64 *seq, u64 *expire)
 {
+    *expire = 0;
+
+    if (((const u8 *)kmd)[*off] == KMD_EXPIRE_MARK) {
+        *off += 1;
+        *expire = decode_hg64(kmd, off);
+    }
+
     *vtype = ((const u8 *)kmd)[*off];
     *off += 1;
     *seq = decode_hg64(kmd, off);
 }
 
+static inline void
+kmd_type_seq(const void *kmd, size_t *off, enum kmd_vtype *vtype, u64 *seq)
+{
+    u64 expire;
+
+    kmd_type_seq_expire(kmd, off, vtype, seq, &expire);
+}
+
 static inline void
 kmd_val(const void *kmd, size_t *off, uint *vbidx, uint *vboff, uint *vlen)
 {
@@ -202,6 +258,12 @@ kmd_cval(const void *kmd, size_t *off, uint *vbidx, uint *vboff, uint *vlen, uin
     *complen = decode_hg32_1024m(kmd, off);
 }
 
+static inline void
+kmd_bval(const void *kmd, size_t *off, uint *vbidx, uint *vboff, uint *vlen, uint *boff)
+{
+    kmd_cval(kmd, off, vbidx, vboff, vlen, boff);
+}
+
 static inline void
 kmd_ival(const void *kmd, size_t *off, const void **vbase, uint *vlen)
 {
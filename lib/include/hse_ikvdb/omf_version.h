@@ -11,6 +11,11 @@
 enum {
     GLOBAL_OMF_VERSION1 = 1,
     GLOBAL_OMF_VERSION2 = 2,
+    GLOBAL_OMF_VERSION3 = 3,
+    GLOBAL_OMF_VERSION4 = 4,
+    GLOBAL_OMF_VERSION5 = 5,
+    GLOBAL_OMF_VERSION6 = 6,
+    GLOBAL_OMF_VERSION7 = 7,
 };
 
 enum {
@@ -21,18 +26,23 @@ enum {
 
 enum {
     KBLOCK_HDR_VERSION5 = 5,
+    KBLOCK_HDR_VERSION6 = 6,
 };
 
 enum {
     VBLOCK_HDR_VERSION2 = 2,
+    VBLOCK_HDR_VERSION3 = 3,
 };
 
 enum {
     BLOOM_OMF_VERSION5 = 5,
+    BLOOM_OMF_VERSION6 = 6,
 };
 
 enum {
     WBT_TREE_VERSION6 = 6,
+    WBT_TREE_VERSION7 = 7,
+    WBT_TREE_VERSION8 = 8,
 };
 
 enum {
@@ -59,17 +69,17 @@ enum {
     KVDB_META_VERSION2 = 2,
 };
 
-#define GLOBAL_OMF_VERSION GLOBAL_OMF_VERSION2
+#define GLOBAL_OMF_VERSION GLOBAL_OMF_VERSION7
 
 /* In the event one of the following versions in incremented, increment the
  * global OMF version.
  */
 
 #define CNDB_VERSION           CNDB_VERSION12
-#define KBLOCK_HDR_VERSION     KBLOCK_HDR_VERSION5
-#define VBLOCK_HDR_VERSION     VBLOCK_HDR_VERSION2
-#define BLOOM_OMF_VERSION      BLOOM_OMF_VERSION5
-#define WBT_TREE_VERSION       WBT_TREE_VERSION6
+#define KBLOCK_HDR_VERSION     KBLOCK_HDR_VERSION6
+#define VBLOCK_HDR_VERSION     VBLOCK_HDR_VERSION3
+#define BLOOM_OMF_VERSION      BLOOM_OMF_VERSION6
+#define WBT_TREE_VERSION       WBT_TREE_VERSION8
 #define CN_TSTATE_VERSION      CN_TSTATE_VERSION1
 #define MBLOCK_METAHDR_VERSION MBLOCK_METAHDR_VERSION2
 #define MDC_LOGHDR_VERSION     MDC_LOGHDR_VERSION2
@@ -0,0 +1,148 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/*
+ * Copyright (C) 2021 Micron Technology, Inc.  All rights reserved.
+ */
+
+#ifndef HSE_IKVDB_RTOMB_H
+#define HSE_IKVDB_RTOMB_H
+
+#include <stdlib.h>
+
+#include <hse_util/hse_err.h>
+#include <hse_util/inttypes.h>
+#include <hse_util/key_util.h>
+#include <hse_util/keycmp.h>
+
+/**
+ * struct rtomb - range tombstone
+ * @rt_start: smallest key covered by the tombstone
+ * @rt_end:   first key past the end of the range (exclusive)
+ * @rt_slen:  length of @rt_start
+ * @rt_elen:  length of @rt_end
+ * @rt_seqno: sequence number of the delete
+ * @rt_maxend:  largest end key of this and all the preceding tombstones
+ *              of a vector sorted by rtomb_sort()
+ * @rt_maxelen: length of @rt_maxend
+ *
+ * A range tombstone hides every version of every key in [start, end)
+ * whose sequence number is lower than that of the tombstone.
+ */
+struct rtomb {
+    const void *rt_start;
+    const void *rt_end;
+    u16         rt_slen;
+    u16         rt_elen;
+    u64         rt_seqno;
+    const void *rt_maxend;
+    u16         rt_maxelen;
+};
+
+/**
+ * rtomb_visit_fn - callback used to enumerate range tombstones
+ * @arg: caller's context
+ * @rt:  range tombstone, valid only for the duration of the call
+ */
+typedef merr_t
+rtomb_visit_fn(void *arg, const struct rtomb *rt);
+
+static HSE_ALWAYS_INLINE bool
+rtomb_covers(const struct rtomb *rt, const struct key_obj *kobj)
+{
+    struct key_obj ko;
+
+    key2kobj(&ko, rt->rt_start, rt->rt_slen);
+    if (key_obj_cmp(kobj, &ko) < 0)
+        return false;
+
+    key2kobj(&ko, rt->rt_end, rt->rt_elen);
+
+    return key_obj_cmp(kobj, &ko) < 0;
+}
+
+static inline int
+rtomb_cmp(const void *lhs, const void *rhs)
+{
+    const struct rtomb *a = lhs;
+    const struct rtomb *b = rhs;
+
+    return keycmp(a->rt_start, a->rt_slen, b->rt_start, b->rt_slen);
+}
+
+/**
+ * rtomb_sort() - prepare a vector of range tombstones for rtomb_seqno()
+ * @rtv: vector of range tombstones
+ * @rtc: number of elements in @rtv
+ *
+ * Sorts @rtv by start key and sets the rt_maxend of each element.
+ */
+static inline void
+rtomb_sort(struct rtomb *rtv, uint rtc)
+{
+    uint i;
+
+    if (rtc > 1)
+        qsort(rtv, rtc, sizeof(*rtv), rtomb_cmp);
+
+    for (i = 0; i < rtc; i++) {
+        struct rtomb *rt = rtv + i;
+
+        rt->rt_maxend = rt->rt_end;
+        rt->rt_maxelen = rt->rt_elen;
+
+        if (i > 0 && keycmp(rt[-1].rt_maxend, rt[-1].rt_maxelen, rt->rt_end, rt->rt_elen) > 0) {
+            rt->rt_maxend = rt[-1].rt_maxend;
+            rt->rt_maxelen = rt[-1].rt_maxelen;
+        }
+    }
+}
+
+/**
+ * rtomb_seqno() - find the newest range tombstone that hides a key
+ * @rtv:  vector of range tombstones, sorted by rtomb_sort()
+ * @rtc:  number of elements in @rtv
+ * @kobj: key
+ * @view: ignore tombstones with a sequence number higher than this
+ *
+ * Binary search finds the tombstones that start at or before @kobj, of
+ * which only the trailing ones whose rt_maxend lies past @kobj need be
+ * examined.
+ *
+ * Return: the seqno of the newest visible tombstone covering @kobj,
+ * or zero if there is none.
+ */
+static inline u64
+rtomb_seqno(const struct rtomb *rtv, uint rtc, const struct key_obj *kobj, u64 view)
+{
+    struct key_obj ko;
+    uint           lo = 0, hi = rtc;
+    u64            seq = 0;
+
+    while (lo < hi) {
+        uint mid = (lo + hi) / 2;
+
+        key2kobj(&ko, rtv[mid].rt_start, rtv[mid].rt_slen);
+
+        if (key_obj_cmp(kobj, &ko) < 0)
+            hi = mid;
+        else
+            lo = mid + 1;
+    }
+
+    while (lo-- > 0) {
+        const struct rtomb *rt = rtv + lo;
+
+        key2kobj(&ko, rt->rt_maxend, rt->rt_maxelen);
+        if (key_obj_cmp(kobj, &ko) >= 0)
+            break;
+
+        if (rt->rt_seqno > seq && rt->rt_seqno <= view) {
+            key2kobj(&ko, rt->rt_end, rt->rt_elen);
+            if (key_obj_cmp(kobj, &ko) < 0)
+                seq = rt->rt_seqno;
+        }
+    }
+
+    return seq;
+}
+
+#endif
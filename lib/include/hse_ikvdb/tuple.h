@@ -6,6 +6,8 @@
 #ifndef HSE_CORE_TUPLE_H
 #define HSE_CORE_TUPLE_H
 
+#include <time.h>
+
 #include <hse_util/inttypes.h>
 #include <hse_util/hse_err.h>
 #include <hse_util/key_util.h>
@@ -47,8 +49,9 @@ struct kvs_ktuple {
 
 /**
  * struct kvs_vtuple - a container for carrying a value
- * @vt_data: ptr to the value in-core memory or a special tomb value
- * @vt_xlen: opaque encoded length
+ * @vt_data:   ptr to the value in-core memory or a special tomb value
+ * @vt_xlen:   opaque encoded length
+ * @vt_expire: expiration time in seconds since the epoch, zero if none
  *
  * Always use kvs_vtuple_vlen() to learn the in-core length of a value.
  * If it returns zero then @kt_data likely is not a valid pointer but
@@ -57,12 +60,31 @@ struct kvs_ktuple {
 struct kvs_vtuple {
     void *vt_data;
     u64   vt_xlen;
+    u64   vt_expire;
+};
+
+/**
+ * struct kvs_vpin - reference to a value that remains valid until released
+ * @vp_data:    address of the (uncompressed) value
+ * @vp_release: drops the reference that keeps @vp_data valid
+ * @vp_arg:     argument passed to @vp_release
+ *
+ * A get that supplies a kvs_vpin via kvs_buf.b_pin permits the layer
+ * holding the value to return a pointer to it rather than copying it
+ * into kvs_buf.b_buf.  Layers that cannot pin a value (e.g., because
+ * it is compressed or not reference counted) ignore b_pin and copy.
+ */
+struct kvs_vpin {
+    const void *vp_data;
+    void      (*vp_release)(void *arg);
+    void       *vp_arg;
 };
 
 struct kvs_buf {
-    void *b_buf;
-    u32   b_buf_sz;
-    u32   b_len;
+    void            *b_buf;
+    u32              b_buf_sz;
+    u32              b_len;
+    struct kvs_vpin *b_pin;
 };
 
 struct kvs_kvtuple {
@@ -78,6 +100,7 @@ struct kvs_vtuple_ref {
             u32 vr_off;
             u32 vr_len;
             u32 vr_complen;
+            u32 vr_boff; /* vtype_bval only */
         } vb;
         struct {
             u16         vr_len;
@@ -120,6 +143,7 @@ kvs_vtuple_init(struct kvs_vtuple *vt, void *val, u64 xlen)
 {
     vt->vt_data = val;
     vt->vt_xlen = xlen;
+    vt->vt_expire = 0;
 }
 
 /**
@@ -132,6 +156,7 @@ kvs_vtuple_init(struct kvs_vtuple *vt, void *val, u64 xlen)
  * A compressed value length should always be greater than zero
  * and less than the uncompressed value length.  The val pointer
  * should always be a valid memory pointer, not a tomb encoding.
+ * The expiration time of the vtuple (if any) is left unchanged.
  */
 static inline void
 kvs_vtuple_cinit(struct kvs_vtuple *vt, void *val, uint vlen, uint clen)
@@ -165,11 +190,65 @@ kvs_vtuple_clen(const struct kvs_vtuple *vt)
     return vt->vt_xlen >> 32;
 }
 
+/**
+ * kvs_now() - current time in seconds since the epoch, as used for ttls
+ */
+static inline u64
+kvs_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+
+    return ts.tv_sec;
+}
+
+/**
+ * kvs_expired_at() - determine whether a value's ttl has run out at @now
+ * @expire: expiration time in seconds since the epoch, zero if none
+ * @now:    reference time in seconds since the epoch
+ */
+static inline bool
+kvs_expired_at(u64 expire, u64 now)
+{
+    return expire && expire <= now;
+}
+
+/**
+ * kvs_expired() - determine whether a value has outlived its ttl
+ * @expire: expiration time in seconds since the epoch, zero if none
+ *
+ * An expired value is treated as a tombstone by gets, cursors and
+ * compaction.
+ */
+static inline bool
+kvs_expired(u64 expire)
+{
+    if (HSE_LIKELY(!expire))
+        return false;
+
+    return kvs_expired_at(expire, kvs_now());
+}
+
 static inline void
 kvs_buf_init(struct kvs_buf *vbuf, void *buf, u32 buf_size)
 {
     vbuf->b_buf = buf;
     vbuf->b_buf_sz = buf_size;
     vbuf->b_len = 0;
+    vbuf->b_pin = NULL;
+}
+
+static inline void
+kvs_buf_unpin(struct kvs_buf *vbuf)
+{
+    struct kvs_vpin *pin = vbuf->b_pin;
+
+    if (pin && pin->vp_release) {
+        pin->vp_release(pin->vp_arg);
+        pin->vp_release = NULL;
+        pin->vp_arg = NULL;
+        pin->vp_data = NULL;
+    }
 }
 #endif
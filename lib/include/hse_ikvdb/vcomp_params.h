@@ -8,17 +8,24 @@
 
 #define VCOMP_PARAM_NONE    "none"
 #define VCOMP_PARAM_LZ4     "lz4"
+#define VCOMP_PARAM_ZSTD    "zstd"
 
 enum vcomp_algorithm
 {
 	VCOMP_ALGO_NONE,
 	VCOMP_ALGO_LZ4,
+	VCOMP_ALGO_ZSTD,
 };
 
 #define VCOMP_ALGO_MIN   VCOMP_ALGO_NONE
-#define VCOMP_ALGO_MAX   VCOMP_ALGO_LZ4
+#define VCOMP_ALGO_MAX   VCOMP_ALGO_ZSTD
 #define VCOMP_ALGO_COUNT (VCOMP_ALGO_MAX + 1)
 
+/* Values compressed by c0 puts travel through c0, lc and the WAL, all of
+ * which decompress with lz4.  Other algorithms are applied by cn compaction.
+ */
+#define VCOMP_ALGO_PUT_MAX  VCOMP_ALGO_LZ4
+
 extern const struct compress_ops *vcomp_compress_ops[VCOMP_ALGO_COUNT];
 
 #endif
@@ -20,6 +20,16 @@
 #define HSE_WAL_DUR_BUFSZ_MB_DFLT  (4096ul)
 #define HSE_WAL_DUR_BUFSZ_MB_MAX   (8192ul)
 
+/* Target p99 latency for synchronous operations (0 disables group commit) */
+#define HSE_WAL_SYNC_LAT_US_MIN    (0)
+#define HSE_WAL_SYNC_LAT_US_DFLT   (0)
+#define HSE_WAL_SYNC_LAT_US_MAX    (100 * 1000)
+
+/* Async write queue depth per wal buffer (0 selects synchronous writes) */
+#define HSE_WAL_AIO_QDEPTH_MIN     (0)
+#define HSE_WAL_AIO_QDEPTH_DFLT    (0)
+#define HSE_WAL_AIO_QDEPTH_MAX     (1024)
+
 struct wal;
 struct throttle_sensor;
 
@@ -92,6 +102,15 @@ wal_del_pfx(
     uint64_t txid,
     struct wal_record *recout);
 
+/* MTF_MOCK */
+merr_t
+wal_del_range(
+    struct wal *wal,
+    struct ikvs *kvs,
+    struct kvs_ktuple *kt,
+    struct kvs_ktuple *kt_end,
+    struct wal_record *recout);
+
 /* MTF_MOCK */
 merr_t
 wal_txn_begin(struct wal *wal, uint64_t txid, int64_t *cookie);
@@ -107,6 +126,20 @@ wal_txn_commit(struct wal *wal, uint64_t txid, uint64_t seqno, uint64_t cid, int
 void
 wal_op_finish(struct wal *wal, struct wal_record *rec, uint64_t seqno, uint64_t gen, int rc);
 
+/**
+ * wal_op_sync() - wait for a finished record to become durable
+ * @wal: wal handle
+ * @rec: record previously passed to wal_op_finish()
+ *
+ * Unlike wal_sync(), this waits only for the buffer that holds @rec, and
+ * only up to the end of @rec.  Concurrent callers are coalesced into a
+ * single flush by the wal timer thread.  If durability.sync_latency_us is
+ * set and several callers are waiting, the timer delays the flush for an
+ * adaptive window sized to meet that target.
+ */
+merr_t
+wal_op_sync(struct wal *wal, const struct wal_record *rec);
+
 void
 wal_cningest_cb(
     struct wal *wal,
@@ -24,6 +24,7 @@
 #include <hse_util/xrand.h>
 #include <hse_util/bkv_collection.h>
 #include <hse_util/alloc.h>
+#include <hse_util/keycmp.h>
 
 #include <hse_ikvdb/config.h>
 #include <hse_ikvdb/argv.h>
@@ -768,6 +769,8 @@ ikvdb_maint_task(struct work_struct *work)
 static void
 ikvdb_init_throttle_params(struct ikvdb_impl *self)
 {
+    struct throttle_sensor *sensorv[2];
+
     if (self->ikdb_read_only)
         return;
 
@@ -782,6 +785,12 @@ ikvdb_init_throttle_params(struct ikvdb_impl *self)
     wal_throttle_sensor(
         self->ikdb_wal, throttle_sensor(&self->ikdb_throttle, THROTTLE_SENSOR_WAL));
 
+    /* Loosen the cn IO governor when root spills or c0 ingest fall behind.
+     */
+    sensorv[0] = throttle_sensor(&self->ikdb_throttle, THROTTLE_SENSOR_CNROOT);
+    sensorv[1] = throttle_sensor(&self->ikdb_throttle, THROTTLE_SENSOR_C0SK);
+
+    cn_kvdb_throttle_sensors(self->ikdb_cn_kvdb, sensorv, NELEM(sensorv));
 }
 
 static void
@@ -899,7 +908,7 @@ ikvdb_diag_open(
     struct ikvdb_impl   *self = NULL;
     merr_t               err;
     struct kvdb_meta     meta;
-    struct mpool_rparams mparams;
+    struct mpool_rparams mparams = {0};
 
     err = ikvdb_alloc(kvdb_home, params, &self);
     if (err)
@@ -1270,7 +1279,7 @@ ikvdb_open(
     uint32_t               flags;
     u64                    ingestid, gen = 0, txhorizon = 0;
     struct wal_replay_info rinfo = {0};
-    struct mpool_rparams   mparams;
+    struct mpool_rparams   mparams = {0};
     struct kvdb_meta       meta;
 
     assert(kvdb_home);
@@ -1314,6 +1323,8 @@ ikvdb_open(
     if (ev(err))
         goto out;
 
+    mparams.bcache_size = (uint64_t)params->cn_bcache_size_mb << MB_SHIFT;
+
     flags = params->read_only ? O_RDONLY : O_RDWR;
     err = mpool_open(kvdb_home, &mparams, flags, &self->ikdb_mp);
     if (ev(err))
@@ -1428,6 +1439,7 @@ ikvdb_open(
     }
 
     err = cn_kvdb_create(self->ikdb_rp.cn_maint_threads, self->ikdb_rp.cn_io_threads,
+                         self->ikdb_rp.cn_compaction_slices, self->ikdb_rp.cn_io_rate_mb,
                          &self->ikdb_cn_kvdb);
     if (err) {
         log_errx("cannot open %s: @@e", err, kvdb_home);
@@ -2045,8 +2057,12 @@ ikvdb_kvs_open(
 
     kvs->kk_vcompmin = UINT_MAX;
     assert(params->value_compression >= VCOMP_ALGO_MIN &&
-        params->value_compression <= VCOMP_ALGO_MAX);
-    cops = vcomp_compress_ops[params->value_compression];
+        params->value_compression <= VCOMP_ALGO_PUT_MAX);
+
+    /* In deferred mode values are stored uncompressed by puts and ingest,
+     * and compressed later by kv-compaction and spill (see cn_open()).
+     */
+    cops = params->vcomp_defer ? NULL : vcomp_compress_ops[params->value_compression];
     if (cops) {
         assert(cops->cop_compress && cops->cop_estimate);
 
@@ -2349,7 +2365,7 @@ ikvdb_kvs_put(
 
     seqnoref = txn ? 0 : HSE_SQNREF_SINGLE;
 
-    err = kvs_put(kk->kk_ikvs, txn, kt, vt, seqnoref);
+    err = kvs_put(kk->kk_ikvs, txn, kt, vt, seqnoref, flags);
 
     if (vbuf && vbuf != tls_vbuf)
         vlb_free(vbuf, (vbufsz > VLB_ALLOCSZ_MAX) ? vbufsz : clen);
@@ -2433,6 +2449,41 @@ ikvdb_kvs_get(
     return kvs_get(kk->kk_ikvs, txn, kt, view_seqno, res, vbuf);
 }
 
+merr_t
+ikvdb_kvs_get_multi(
+    struct hse_kvs *           handle,
+    const unsigned int         flags,
+    struct hse_kvdb_txn *const txn,
+    struct kvs_ktuple *        ktv,
+    enum key_lookup_res *      resv,
+    struct kvs_buf *           vbufv,
+    unsigned int               cnt)
+{
+    struct kvdb_kvs *  kk = (struct kvdb_kvs *)handle;
+    struct ikvdb_impl *p;
+    u64                view_seqno;
+
+    if (ev(!handle))
+        return merr(EINVAL);
+
+    if (ev(!is_read_allowed(kk->kk_ikvs, txn)))
+        return merr(EINVAL);
+
+    p = kk->kk_parent;
+
+    if (txn) {
+        view_seqno = 0;
+    } else {
+        /* One view for the whole batch, established before waiting on
+         * ongoing commits just as for a single get.
+         */
+        view_seqno = atomic_read(&p->ikdb_seqno);
+        kvdb_ctxn_set_wait_commits(p->ikdb_ctxn_set, 0);
+    }
+
+    return kvs_get_multi(kk->kk_ikvs, txn, ktv, view_seqno, resv, vbufv, cnt);
+}
+
 merr_t
 ikvdb_kvs_del(
     struct hse_kvs *           handle,
@@ -2505,6 +2556,203 @@ ikvdb_kvs_prefix_delete(
     return kvs_prefix_del(kk->kk_ikvs, txn, kt, seqnoref);
 }
 
+merr_t
+ikvdb_kvs_range_delete(
+    struct hse_kvs *   handle,
+    const unsigned int flags,
+    struct kvs_ktuple *kt,
+    struct kvs_ktuple *kt_end)
+{
+    struct kvdb_kvs *  kk = (struct kvdb_kvs *)handle;
+    struct ikvdb_impl *parent;
+    merr_t             err;
+
+    if (ev(!handle))
+        return merr(EINVAL);
+
+    if (ev(!is_write_allowed(kk->kk_ikvs, NULL)))
+        return merr(EINVAL);
+
+    parent = kk->kk_parent;
+    if (ev(parent->ikdb_read_only))
+        return merr(EROFS);
+
+    err = kvdb_health_check(
+        &parent->ikdb_health, KVDB_HEALTH_FLAG_ALL & ~KVDB_HEALTH_FLAG_DELBLKFAIL);
+    if (ev(err))
+        return err;
+
+    return kvs_range_del(kk->kk_ikvs, kt, kt_end, HSE_SQNREF_SINGLE);
+}
+
+/*-  IKVDB Bulk Load ------------------------------------------------*/
+
+/* A bulk load bypasses c0 and the WAL and builds kvsets directly in cn.
+ * The public handle wraps the cn bulk loader with the kvs it loads.
+ */
+struct ikvdb_kvs_bulk {
+    struct cn_bulk * kb_bulk;
+    struct kvdb_kvs *kb_kvs;
+    bool             kb_behind;
+};
+
+static merr_t
+ikvdb_kvs_rtomb_seen(void *arg, const struct rtomb *rt)
+{
+    *(bool *)arg = true;
+
+    return 0;
+}
+
+/* Determine whether c0 or LC hold any keys, tombstones or range tombstones
+ * of the kvs that have yet to be ingested into its cn tree.
+ */
+static merr_t
+ikvdb_kvs_c0lc_empty(struct kvdb_kvs *kk, bool *empty)
+{
+    struct ikvdb_impl *       parent = kk->kk_parent;
+    struct c0 *               c0 = kk->kk_ikvs->ikv_c0;
+    struct cursor_summary     summary = {};
+    struct kvs_cursor_element elem;
+    struct c0_cursor *        c0cur;
+    struct lc_cursor *        lccur;
+    bool                      eof, seen = false;
+    u64                       seqno;
+    merr_t                    err;
+
+    seqno = atomic_read(&parent->ikdb_seqno);
+
+    err = c0_cursor_create(c0, seqno, false, NULL, 0, &summary, &c0cur);
+    if (ev(err))
+        return err;
+
+    err = c0_cursor_rtombs(c0cur, ikvdb_kvs_rtomb_seen, &seen);
+    if (!err && !seen)
+        err = c0_cursor_seek(c0cur, NULL, 0, NULL);
+    if (!err && !seen) {
+        err = c0_cursor_read(c0cur, &elem, &eof);
+        seen = !err && !eof;
+    }
+
+    c0_cursor_destroy(c0cur);
+
+    if (ev(err))
+        return err;
+
+    if (!seen) {
+        err = lc_cursor_create(parent->ikdb_lc, c0_index(c0), seqno, 0, false, NULL, 0,
+                               c0_get_pfx_len(c0), &summary, &lccur);
+        if (ev(err))
+            return err;
+
+        err = lc_cursor_seek(lccur, NULL, 0, NULL);
+        if (!err) {
+            lc_cursor_read(lccur, &elem, &eof);
+            seen = !eof;
+        }
+
+        lc_cursor_destroy(lccur);
+
+        if (ev(err))
+            return err;
+    }
+
+    *empty = !seen;
+
+    return 0;
+}
+
+/* A load into an empty cn tree becomes the kvs's newest cn data, so it is
+ * refused while older puts or deletes of the kvs await ingest from c0 or
+ * LC.  Puts that race with the commit are simply newer than the load.
+ */
+static merr_t
+ikvdb_kvs_bulk_check(struct ikvdb_kvs_bulk *kb)
+{
+    bool   empty;
+    merr_t err;
+
+    if (kb->kb_behind)
+        return 0;
+
+    err = ikvdb_kvs_c0lc_empty(kb->kb_kvs, &empty);
+    if (ev(err))
+        return err;
+
+    return empty ? 0 : merr(EBUSY);
+}
+
+merr_t
+ikvdb_kvs_bulk_create(struct hse_kvs *handle, const unsigned int flags, struct hse_kvs_bulk **bulk)
+{
+    struct kvdb_kvs *      kk = (struct kvdb_kvs *)handle;
+    struct ikvdb_impl *    parent;
+    struct ikvdb_kvs_bulk *kb;
+    merr_t                 err;
+
+    INVARIANT(handle && bulk);
+
+    parent = kk->kk_parent;
+    if (ev(parent->ikdb_read_only))
+        return merr(EROFS);
+
+    err = kvdb_health_check(&parent->ikdb_health, KVDB_HEALTH_FLAG_ALL);
+    if (ev(err))
+        return err;
+
+    kb = calloc(1, sizeof(*kb));
+    if (ev(!kb))
+        return merr(ENOMEM);
+
+    kb->kb_kvs = kk;
+    kb->kb_behind = flags & HSE_KVS_BULK_BEHIND;
+
+    err = ikvdb_kvs_bulk_check(kb);
+    if (!err)
+        err = cn_bulk_create(kvs_cn(kk->kk_ikvs), kb->kb_behind, &kb->kb_bulk);
+    if (ev(err)) {
+        free(kb);
+        return err;
+    }
+
+    *bulk = (struct hse_kvs_bulk *)kb;
+
+    return 0;
+}
+
+merr_t
+ikvdb_kvs_bulk_put(struct hse_kvs_bulk *bulk, struct kvs_ktuple *kt, struct kvs_vtuple *vt)
+{
+    struct ikvdb_kvs_bulk *kb = (struct ikvdb_kvs_bulk *)bulk;
+
+    return cn_bulk_add(kb->kb_bulk, kt, vt);
+}
+
+merr_t
+ikvdb_kvs_bulk_commit(struct hse_kvs_bulk *bulk)
+{
+    struct ikvdb_kvs_bulk *kb = (struct ikvdb_kvs_bulk *)bulk;
+    merr_t                 err;
+
+    err = ikvdb_kvs_bulk_check(kb);
+    if (ev(err))
+        return err;
+
+    return cn_bulk_commit(kb->kb_bulk);
+}
+
+void
+ikvdb_kvs_bulk_destroy(struct hse_kvs_bulk *bulk)
+{
+    struct ikvdb_kvs_bulk *kb = (struct ikvdb_kvs_bulk *)bulk;
+
+    if (!kb)
+        return;
+
+    cn_bulk_destroy(kb->kb_bulk);
+    free(kb);
+}
+
 /*-  IKVDB Cursors --------------------------------------------------*/
 
 /*
@@ -2641,7 +2889,12 @@ ikvdb_kvs_cursor_create(
      *  - initialize cursor
      * The failure path must unregister the cursor from kk_cursors.
      */
-    cur = kvs_cursor_alloc(kk->kk_ikvs, prefix, pfx_len, flags & HSE_CURSOR_CREATE_REV);
+    cur = kvs_cursor_alloc(
+        kk->kk_ikvs,
+        prefix,
+        pfx_len,
+        flags & HSE_CURSOR_CREATE_REV,
+        flags & HSE_CURSOR_CREATE_KEYS);
     if (ev(!cur))
         return merr(ENOMEM);
 
@@ -2690,6 +2943,200 @@ out:
     return err;
 }
 
+/* Limit the number of split keys so as to bound the number of keys that
+ * cn samples to choose them.
+ */
+#define IKVDB_RANGE_SPLIT_MAX (1024)
+
+merr_t
+ikvdb_kvs_range_split(
+    struct hse_kvs *          handle,
+    const void *              prefix,
+    size_t                    pfx_len,
+    void *                    buf,
+    size_t                    buf_sz,
+    struct hse_kvs_split_key *splitv,
+    size_t                    splitc,
+    size_t *                  split_cnt)
+{
+    struct kvdb_kvs *  kk = (struct kvdb_kvs *)handle;
+    struct kvs_ktuple *ktv;
+    merr_t             err;
+    uint               cnt, i;
+
+    *split_cnt = 0;
+
+    if (ev(pfx_len > HSE_KVS_KEY_LEN_MAX))
+        return merr(EINVAL);
+
+    splitc = min_t(size_t, splitc, IKVDB_RANGE_SPLIT_MAX);
+    if (!splitc)
+        return 0;
+
+    ktv = malloc(splitc * sizeof(*ktv));
+    if (ev(!ktv))
+        return merr(ENOMEM);
+
+    err = cn_split_keys(kvs_cn(kk->kk_ikvs), prefix, pfx_len, splitc, buf, buf_sz, ktv, &cnt);
+    if (!ev(err)) {
+        for (i = 0; i < cnt; i++) {
+            splitv[i].sk_key = ktv[i].kt_data;
+            splitv[i].sk_key_len = ktv[i].kt_len;
+        }
+
+        *split_cnt = cnt;
+    }
+
+    free(ktv);
+
+    return err;
+}
+
+/* Cursor limits are inclusive, so a slice that ends just before a split key
+ * is bounded by the largest key that sorts before it.  That is the split key
+ * less its last byte if that byte is zero, else the split key with its last
+ * byte decremented and padded out to the maximum key length with 0xff bytes.
+ */
+static bool
+cursor_slice_limit(const void *key, size_t klen, void *limit, size_t *limit_len)
+{
+    u8 *p = limit;
+
+    if (klen == 0 || klen > HSE_KVS_KEY_LEN_MAX)
+        return false;
+
+    memcpy(p, key, klen);
+
+    if (p[klen - 1] == 0) {
+        *limit_len = klen - 1;
+        return klen > 1;
+    }
+
+    p[klen - 1]--;
+    memset(p + klen, 0xff, HSE_KVS_KEY_LEN_MAX - klen);
+    *limit_len = HSE_KVS_KEY_LEN_MAX;
+
+    return true;
+}
+
+merr_t
+ikvdb_kvs_cursor_create_slices(
+    struct hse_kvs *                handle,
+    const unsigned int              flags,
+    const void *                    prefix,
+    size_t                          pfx_len,
+    const struct hse_kvs_split_key *splitv,
+    size_t                          splitc,
+    struct hse_kvs_cursor **        cursorv)
+{
+    struct kvdb_kvs *  kk = (struct kvdb_kvs *)handle;
+    struct ikvdb_impl *ikvdb = kk->kk_parent;
+    struct perfc_set * pkvsl_pc;
+    u8                 limit[HSE_KVS_KEY_LEN_MAX];
+    size_t             limit_len, i;
+    u64                tstart, tseqno;
+    merr_t             err = 0;
+
+    for (i = 0; i <= splitc; i++)
+        cursorv[i] = NULL;
+
+    /* Slices are bounded by cursor limits, which reverse cursors lack. */
+    if (ev(flags & HSE_CURSOR_CREATE_REV))
+        return merr(EINVAL);
+
+    if (ev(!is_read_allowed(kk->kk_ikvs, NULL)))
+        return merr(EINVAL);
+
+    for (i = 0; i < splitc; i++) {
+        const struct hse_kvs_split_key *sk = splitv + i;
+
+        if (ev(!cursor_slice_limit(sk->sk_key, sk->sk_key_len, limit, &limit_len)))
+            return merr(EINVAL);
+
+        if (ev(pfx_len > 0 && keycmp_prefix(prefix, pfx_len, sk->sk_key, sk->sk_key_len)))
+            return merr(EINVAL);
+
+        if (ev(i > 0 && keycmp(sk[-1].sk_key, sk[-1].sk_key_len, sk->sk_key, sk->sk_key_len) >= 0))
+            return merr(EINVAL);
+    }
+
+    if (ev(atomic_read(&ikvdb->ikdb_curcnt) + splitc > ikvdb->ikdb_curcnt_max))
+        return merr(ECANCELED);
+
+    pkvsl_pc = kvs_perfc_pkvsl(kk->kk_ikvs);
+    tstart = perfc_lat_start(pkvsl_pc);
+
+    for (i = 0; i <= splitc; i++) {
+        struct hse_kvs_cursor *cur;
+
+        cur = kvs_cursor_alloc(kk->kk_ikvs, prefix, pfx_len, false, flags & HSE_CURSOR_CREATE_KEYS);
+        if (ev(!cur)) {
+            err = merr(ENOMEM);
+            goto out;
+        }
+
+        cur->kc_pkvsl_pc = pkvsl_pc;
+        cur->kc_seq = HSE_SQNREF_UNDEFINED;
+        cur->kc_flags = flags;
+        cur->kc_kvs = kk;
+        cur->kc_gen = 0;
+        cur->kc_ctxn = NULL;
+        cur->kc_bind = NULL;
+
+        cursorv[i] = cur;
+    }
+
+    /* The view locked by the first cursor pins the view of all the cursors
+     * until each has acquired its refs on c0 and cn.
+     */
+    err = cursor_view_acquire(cursorv[0], &tseqno);
+    if (ev(err))
+        goto out;
+
+    for (i = 0; i <= splitc && !err; i++) {
+        cursorv[i]->kc_seq = cursorv[0]->kc_seq;
+        err = kvs_cursor_init(cursorv[i], NULL);
+    }
+
+    cursor_view_release(cursorv[0]);
+
+    if (ev(err))
+        goto out;
+
+    kvdb_ctxn_set_wait_commits(ikvdb->ikdb_ctxn_set, tseqno);
+
+    /* Position each cursor at the start of its slice and bound it by the
+     * largest key that precedes the next slice.
+     */
+    for (i = 0; i <= splitc; i++) {
+        const void *key = i > 0 ? splitv[i - 1].sk_key : NULL;
+        size_t      klen = i > 0 ? splitv[i - 1].sk_key_len : 0;
+
+        limit_len = 0;
+        if (i < splitc)
+            cursor_slice_limit(splitv[i].sk_key, splitv[i].sk_key_len, limit, &limit_len);
+
+        err = kvs_cursor_seek(cursorv[i], key, klen, limit_len ? limit : NULL, limit_len, NULL);
+        if (ev(err))
+            goto out;
+
+        perfc_inc(&kvdb_metrics_pc, PERFC_BA_KVDBMETRICS_CURCNT);
+        cursorv[i]->kc_create_time = tstart;
+    }
+
+    perfc_lat_record(pkvsl_pc, PERFC_LT_PKVSL_KVS_CURSOR_CREATE, tstart);
+
+out:
+    if (err) {
+        for (i = 0; i <= splitc; i++) {
+            ikvdb_kvs_cursor_destroy(cursorv[i]);
+            cursorv[i] = NULL;
+        }
+    }
+
+    return err;
+}
+
 merr_t
 ikvdb_kvs_cursor_update_view(struct hse_kvs_cursor *cur, unsigned int flags)
 {
@@ -2887,6 +3334,46 @@ ikvdb_kvs_cursor_read_copy(
     return 0;
 }
 
+merr_t
+ikvdb_kvs_cursor_read_batch(
+    struct hse_kvs_cursor *   cur,
+    unsigned int              flags,
+    void *                    buf,
+    size_t                    buf_sz,
+    struct hse_kvs_cursor_kv *kvv,
+    size_t                    kvc,
+    size_t *                  kv_cnt,
+    bool *                    eof)
+{
+    merr_t err;
+    u64    tstart;
+
+    tstart = perfc_lat_start(cur->kc_pkvsl_pc);
+
+    if (ev(cur->kc_err))
+        return cur->kc_err;
+
+    if (cur->kc_bind) {
+        cur->kc_err = cursor_refresh(cur);
+        if (ev(cur->kc_err))
+            return cur->kc_err;
+    }
+
+    err = kvs_cursor_read_batch(cur, flags, buf, buf_sz, kvv, kvc, kv_cnt, eof);
+    if (ev(err))
+        return err;
+    if (*eof)
+        return 0;
+
+    perfc_lat_record(
+        cur->kc_pkvsl_pc,
+        cur->kc_flags & HSE_CURSOR_CREATE_REV ? PERFC_LT_PKVSL_KVS_CURSOR_READREV
+                                                : PERFC_LT_PKVSL_KVS_CURSOR_READFWD,
+        tstart);
+
+    return 0;
+}
+
 merr_t
 ikvdb_kvs_cursor_destroy(struct hse_kvs_cursor *cur)
 {
@@ -3225,7 +3712,7 @@ ikvdb_wal_replay_put(
     if (ev(!kk))
         return 0; /* Possible that the kvs is dropped just prior to crash */
 
-    err = kvs_put(kk->kk_ikvs, NULL, kt, vt, HSE_ORDNL_TO_SQNREF(seqno));
+    err = kvs_put(kk->kk_ikvs, NULL, kt, vt, HSE_ORDNL_TO_SQNREF(seqno), 0);
     if (!err) /* Update ikdb_seqno if it's lower than "seqno", called from the replay thread */
         ikvdb_wal_replay_seqno_set(ikvdb, seqno);
 
@@ -3280,6 +3767,31 @@ ikvdb_wal_replay_prefix_del(
     return err;
 }
 
+merr_t
+ikvdb_wal_replay_range_del(
+    struct ikvdb         *ikvdb,
+    struct ikvdb_kvs_hdl *ikvsh,
+    u64                   cnid,
+    u64                   seqno,
+    struct kvs_ktuple    *kt,
+    struct kvs_ktuple    *kt_end)
+{
+    struct kvdb_kvs *kk;
+    merr_t err;
+
+    assert(ikvdb && ikvsh);
+
+    kk = ikvdb_wal_replay_kvs_get(ikvsh, cnid);
+    if (ev(!kk))
+        return 0; /* Possible that the kvs is dropped just prior to crash */
+
+    err = kvs_range_del(kk->kk_ikvs, kt, kt_end, HSE_ORDNL_TO_SQNREF(seqno));
+    if (!err)
+        ikvdb_wal_replay_seqno_set(ikvdb, seqno);
+
+    return err;
+}
+
 void
 ikvdb_wal_replay_seqno_set(struct ikvdb *ikvdb, uint64_t seqno)
 {
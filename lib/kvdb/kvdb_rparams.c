@@ -541,7 +541,7 @@ csched_policy_validator(const struct param_spec *const ps, const void *const dat
     assert(data);
 
     return policy == csched_policy_old || policy == csched_policy_sp3 ||
-           policy == csched_policy_noop;
+           policy == csched_policy_adapt || policy == csched_policy_noop;
 }
 
 static const struct param_spec pspecs[] = {
@@ -954,6 +954,48 @@ static const struct param_spec pspecs[] = {
             },
         },
     },
+    {
+        .ps_name = "csched_adapt_goal",
+        .ps_description = "adaptive csched goal (0: write amp, 1: read amp, 2: space amp)",
+        .ps_flags = PARAM_FLAG_EXPERIMENTAL | PARAM_FLAG_WRITABLE,
+        .ps_type = PARAM_TYPE_U8,
+        .ps_offset = offsetof(struct kvdb_rparams, csched_adapt_goal),
+        .ps_size = PARAM_SZ(struct kvdb_rparams, csched_adapt_goal),
+        .ps_convert = param_default_converter,
+        .ps_validate = param_default_validator,
+        .ps_stringify = param_default_stringify,
+        .ps_jsonify = param_default_jsonify,
+        .ps_default_value = {
+            .as_uscalar = csched_adapt_goal_wamp,
+        },
+        .ps_bounds = {
+            .as_uscalar = {
+                .ps_min = csched_adapt_goal_wamp,
+                .ps_max = csched_adapt_goal_samp,
+            },
+        },
+    },
+    {
+        .ps_name = "csched_adapt_ramp_max",
+        .ps_description = "adaptive csched max kvsets on a root-to-leaf path",
+        .ps_flags = PARAM_FLAG_EXPERIMENTAL | PARAM_FLAG_WRITABLE,
+        .ps_type = PARAM_TYPE_U32,
+        .ps_offset = offsetof(struct kvdb_rparams, csched_adapt_ramp_max),
+        .ps_size = PARAM_SZ(struct kvdb_rparams, csched_adapt_ramp_max),
+        .ps_convert = param_default_converter,
+        .ps_validate = param_default_validator,
+        .ps_stringify = param_default_stringify,
+        .ps_jsonify = param_default_jsonify,
+        .ps_default_value = {
+            .as_uscalar = 24,
+        },
+        .ps_bounds = {
+            .as_uscalar = {
+                .ps_min = 2,
+                .ps_max = 1024,
+            },
+        },
+    },
     {
         .ps_name = "durability.enabled",
         .ps_description = "Enable durability in the event of a crash",
@@ -990,6 +1032,48 @@ static const struct param_spec pspecs[] = {
             },
         },
     },
+    {
+        .ps_name = "durability.sync_latency_us",
+        .ps_description = "target p99 latency of sync operations in usecs",
+        .ps_flags = PARAM_FLAG_EXPERIMENTAL,
+        .ps_type = PARAM_TYPE_U32,
+        .ps_offset = offsetof(struct kvdb_rparams, dur_sync_lat_us),
+        .ps_size = PARAM_SZ(struct kvdb_rparams, dur_sync_lat_us),
+        .ps_convert = param_default_converter,
+        .ps_validate = param_default_validator,
+        .ps_stringify = param_default_stringify,
+        .ps_jsonify = param_default_jsonify,
+        .ps_default_value = {
+            .as_uscalar = HSE_WAL_SYNC_LAT_US_DFLT,
+        },
+        .ps_bounds = {
+            .as_uscalar = {
+                .ps_min = HSE_WAL_SYNC_LAT_US_MIN,
+                .ps_max = HSE_WAL_SYNC_LAT_US_MAX,
+            },
+        },
+    },
+    {
+        .ps_name = "durability.aio_qdepth",
+        .ps_description = "async write queue depth per WAL buffer (0: synchronous writes)",
+        .ps_flags = PARAM_FLAG_EXPERIMENTAL,
+        .ps_type = PARAM_TYPE_U32,
+        .ps_offset = offsetof(struct kvdb_rparams, dur_aio_qdepth),
+        .ps_size = PARAM_SZ(struct kvdb_rparams, dur_aio_qdepth),
+        .ps_convert = param_default_converter,
+        .ps_validate = param_default_validator,
+        .ps_stringify = param_default_stringify,
+        .ps_jsonify = param_default_jsonify,
+        .ps_default_value = {
+            .as_uscalar = HSE_WAL_AIO_QDEPTH_DFLT,
+        },
+        .ps_bounds = {
+            .as_uscalar = {
+                .ps_min = HSE_WAL_AIO_QDEPTH_MIN,
+                .ps_max = HSE_WAL_AIO_QDEPTH_MAX,
+            },
+        },
+    },
     {
         .ps_name = "durability.buffer.size",
         .ps_description = "durability buffer size in MiB",
@@ -1350,6 +1434,27 @@ static const struct param_spec pspecs[] = {
             },
         },
     },
+    {
+        .ps_name = "c0_ingest_parts",
+        .ps_description = "max number of key range partitions built in parallel per kvs ingest",
+        .ps_flags = PARAM_FLAG_EXPERIMENTAL,
+        .ps_type = PARAM_TYPE_U32,
+        .ps_offset = offsetof(struct kvdb_rparams, c0_ingest_parts),
+        .ps_size = PARAM_SZ(struct kvdb_rparams, c0_ingest_parts),
+        .ps_convert = param_default_converter,
+        .ps_validate = param_default_validator,
+        .ps_stringify = param_default_stringify,
+        .ps_jsonify = param_default_jsonify,
+        .ps_default_value = {
+            .as_uscalar = HSE_C0_INGEST_PARTS_DFLT,
+        },
+        .ps_bounds = {
+            .as_uscalar = {
+                .ps_min = HSE_C0_INGEST_PARTS_MIN,
+                .ps_max = HSE_C0_INGEST_PARTS_MAX,
+            },
+        },
+    },
     {
         .ps_name = "cn_maint_threads",
         .ps_description = "max number of cn maintenance threads",
@@ -1392,6 +1497,69 @@ static const struct param_spec pspecs[] = {
             },
         },
     },
+    {
+        .ps_name = "cn_compaction_slices",
+        .ps_description = "max number of key range slices merged in parallel per spill or kv-compaction",
+        .ps_flags = PARAM_FLAG_EXPERIMENTAL,
+        .ps_type = PARAM_TYPE_U32,
+        .ps_offset = offsetof(struct kvdb_rparams, cn_compaction_slices),
+        .ps_size = PARAM_SZ(struct kvdb_rparams, cn_compaction_slices),
+        .ps_convert = param_default_converter,
+        .ps_validate = param_default_validator,
+        .ps_stringify = param_default_stringify,
+        .ps_jsonify = param_default_jsonify,
+        .ps_default_value = {
+            .as_uscalar = HSE_CN_COMPACTION_SLICES_DFLT,
+        },
+        .ps_bounds = {
+            .as_uscalar = {
+                .ps_min = HSE_CN_COMPACTION_SLICES_MIN,
+                .ps_max = HSE_CN_COMPACTION_SLICES_MAX,
+            },
+        },
+    },
+    {
+        .ps_name = "cn_io_rate_mb",
+        .ps_description = "max cn compaction IO rate in MiB/s (0: unlimited)",
+        .ps_flags = PARAM_FLAG_EXPERIMENTAL,
+        .ps_type = PARAM_TYPE_U32,
+        .ps_offset = offsetof(struct kvdb_rparams, cn_io_rate_mb),
+        .ps_size = PARAM_SZ(struct kvdb_rparams, cn_io_rate_mb),
+        .ps_convert = param_default_converter,
+        .ps_validate = param_default_validator,
+        .ps_stringify = param_default_stringify,
+        .ps_jsonify = param_default_jsonify,
+        .ps_default_value = {
+            .as_uscalar = 0,
+        },
+        .ps_bounds = {
+            .as_uscalar = {
+                .ps_min = 0,
+                .ps_max = 1024 * 1024,
+            },
+        },
+    },
+    {
+        .ps_name = "cn_bcache_size_mb",
+        .ps_description = "cn userspace page cache size in MiB (0: use mcache maps)",
+        .ps_flags = PARAM_FLAG_EXPERIMENTAL,
+        .ps_type = PARAM_TYPE_U32,
+        .ps_offset = offsetof(struct kvdb_rparams, cn_bcache_size_mb),
+        .ps_size = PARAM_SZ(struct kvdb_rparams, cn_bcache_size_mb),
+        .ps_convert = param_default_converter,
+        .ps_validate = param_default_validator,
+        .ps_stringify = param_default_stringify,
+        .ps_jsonify = param_default_jsonify,
+        .ps_default_value = {
+            .as_uscalar = 0,
+        },
+        .ps_bounds = {
+            .as_uscalar = {
+                .ps_min = 0,
+                .ps_max = 1024 * 1024,
+            },
+        },
+    },
     {
         .ps_name = "keylock_tables",
         .ps_description = "number of keylock tables",
@@ -7,6 +7,7 @@
  * Exported API of the HSE struct ikvs
  */
 
+#include <hse/flags.h>
 #include <hse/kvdb_perfc.h>
 
 #include <hse_util/assert.h>
@@ -275,7 +276,8 @@ kvs_put(
     struct hse_kvdb_txn *const txn,
     struct kvs_ktuple *        kt,
     struct kvs_vtuple *        vt,
-    uintptr_t                  seqnoref)
+    uintptr_t                  seqnoref,
+    const unsigned int         flags)
 {
     struct kvdb_ctxn *ctxn = txn ? kvdb_ctxn_h2h(txn) : 0;
     struct perfc_set *pkvsl_pc = kvs_perfc_pkvsl(kvs);
@@ -343,6 +345,13 @@ kvs_put(
     if (ctxn)
         kvdb_ctxn_unlock(ctxn);
 
+    /* A sync put outside of a txn waits only for its own record to become
+     * durable.  Concurrent sync puts are coalesced into a single WAL write
+     * by the WAL timer thread (see wal_op_sync()).
+     */
+    if (!err && !ctxn && (flags & HSE_KVS_PUT_SYNC))
+        err = wal_op_sync(kvs->ikv_wal, &rec);
+
     perfc_lat_record(pkvsl_pc, PERFC_LT_PKVSL_KVS_PUT, tstart);
 
     return err;
@@ -397,6 +406,70 @@ kvs_get(
     return err;
 }
 
+merr_t
+kvs_get_multi(
+    struct ikvs *              kvs,
+    struct hse_kvdb_txn *const txn,
+    struct kvs_ktuple *        ktv,
+    u64                        seqno,
+    enum key_lookup_res *      resv,
+    struct kvs_buf *           vbufv,
+    uint                       cnt)
+{
+    struct kvdb_ctxn *ctxn = txn ? kvdb_ctxn_h2h(txn) : 0;
+    struct perfc_set *pkvsl_pc = kvs_perfc_pkvsl(kvs);
+    struct c0 *       c0 = kvs->ikv_c0;
+    struct lc *       lc = kvs->ikv_lc;
+    uintptr_t         seqnoref = 0;
+    uint              c0idx, npend, i;
+    u64               tstart;
+    merr_t            err;
+
+    tstart = perfc_lat_start(pkvsl_pc);
+
+    for (i = 0; i < cnt; ++i) {
+        struct kvs_ktuple *kt = ktv + i;
+
+        kt->kt_hash = key_hash64(kt->kt_data, kt->kt_len - kvs->ikv_sfx_len);
+        resv[i] = NOT_FOUND;
+    }
+
+    /* Exclusively lock txn once for the whole batch.
+     * seqnoref is invalid ater lock is released.
+     */
+    if (ctxn) {
+        err = kvdb_ctxn_trylock_read(ctxn, &seqnoref, &seqno);
+        if (err)
+            return err;
+    }
+
+    c0idx = c0_index(c0);
+    npend = 0;
+    err = 0;
+
+    for (i = 0; i < cnt; ++i) {
+        err = c0_get(c0, ktv + i, seqno, seqnoref, resv + i, vbufv + i);
+
+        if (!err && resv[i] == NOT_FOUND)
+            err = lc_get(lc, c0idx, kvs->ikv_pfx_len, ktv + i, seqno, seqnoref, resv + i, vbufv + i);
+
+        if (err)
+            break;
+
+        npend += (resv[i] == NOT_FOUND);
+    }
+
+    if (ctxn)
+        kvdb_ctxn_unlock(ctxn);
+
+    if (!err && npend > 0)
+        err = cn_get_multi(kvs->ikv_cn, ktv, seqno, resv, vbufv, cnt);
+
+    perfc_lat_record(pkvsl_pc, PERFC_LT_PKVSL_KVS_GET, tstart);
+
+    return err;
+}
+
 merr_t
 kvs_del(struct ikvs *kvs, struct hse_kvdb_txn *const txn, struct kvs_ktuple *kt, uintptr_t seqnoref)
 {
@@ -515,6 +588,31 @@ kvs_prefix_del(
     return ev(err);
 }
 
+merr_t
+kvs_range_del(
+    struct ikvs       *kvs,
+    struct kvs_ktuple *kt,
+    struct kvs_ktuple *kt_end,
+    uintptr_t          seqnoref)
+{
+    struct wal_record rec;
+    merr_t            err;
+
+    if (!kt->kt_hash)
+        kt->kt_hash = key_hash64(kt->kt_data, kt->kt_len);
+
+    rec.cookie = -1;
+
+    err = wal_del_range(kvs->ikv_wal, kvs, kt, kt_end, &rec);
+    if (!err) {
+        err = c0_range_del(kvs->ikv_c0, kt, kt_end, seqnoref);
+
+        wal_op_finish(kvs->ikv_wal, &rec, kt->kt_seqno, kt->kt_dgen, merr_errno(err));
+    }
+
+    return ev(err);
+}
+
 merr_t
 kvs_pfx_probe(
     struct ikvs *              kvs,
@@ -5,12 +5,92 @@
 
 #include <limits.h>
 #include <stddef.h>
+#include <stdio.h>
+#include <string.h>
 
 #include <hse/limits.h>
 #include <hse_ikvdb/limits.h>
 #include <hse_ikvdb/param.h>
 #include <hse_ikvdb/kvs_cparams.h>
+#include <hse_util/assert.h>
 #include <hse_util/base.h>
+#include <hse_util/logging.h>
+
+static bool HSE_NONNULL(1, 2, 3) filter_type_converter(
+    const struct param_spec *const ps,
+    const cJSON *const             node,
+    void *const                    data)
+{
+    static const char *types[KVS_FILTER_MAX + 1] = {
+        KVS_FILTER_PARAM_BLOOM, KVS_FILTER_PARAM_XOR
+    };
+
+    assert(ps);
+    assert(node);
+    assert(data);
+
+    if (!cJSON_IsString(node))
+        return false;
+
+    const char *value = cJSON_GetStringValue(node);
+
+    for (size_t i = KVS_FILTER_MIN; i < NELEM(types); i++) {
+        if (!strcmp(types[i], value)) {
+            *(enum kvs_filter_type *)data = i;
+            return true;
+        }
+    }
+
+    log_err("Unknown filter type: %s", value);
+
+    return false;
+}
+
+static const char *
+filter_type_name(enum kvs_filter_type type)
+{
+    switch (type) {
+        case KVS_FILTER_BLOOM:
+            return KVS_FILTER_PARAM_BLOOM;
+        case KVS_FILTER_XOR:
+            return KVS_FILTER_PARAM_XOR;
+    }
+
+    abort();
+}
+
+static merr_t
+filter_type_stringify(
+    const struct param_spec *const ps,
+    const void *const              value,
+    char *const                    buf,
+    const size_t                   buf_sz,
+    size_t *const                  needed_sz)
+{
+    int n;
+
+    INVARIANT(ps);
+    INVARIANT(value);
+    INVARIANT(buf);
+
+    n = snprintf(buf, buf_sz, "\"%s\"", filter_type_name(*(enum kvs_filter_type *)value));
+    if (n < 0)
+        return merr(EBADMSG);
+
+    if (needed_sz)
+        *needed_sz = n;
+
+    return 0;
+}
+
+static cJSON *
+filter_type_jsonify(const struct param_spec *const ps, const void *const value)
+{
+    INVARIANT(ps);
+    INVARIANT(value);
+
+    return cJSON_CreateString(filter_type_name(*(enum kvs_filter_type *)value));
+}
 
 static const struct param_spec pspecs[] = {
     {
@@ -117,7 +197,28 @@ static const struct param_spec pspecs[] = {
                 .ps_max = UINT32_MAX,
             }
         }
-    }
+    },
+    {
+        .ps_name = "filter.type",
+        .ps_description = "kblock key filter type (bloom or xor)",
+        .ps_flags = PARAM_FLAG_EXPERIMENTAL,
+        .ps_type = PARAM_TYPE_ENUM,
+        .ps_offset = offsetof(struct kvs_cparams, filter_type),
+        .ps_size = PARAM_SZ(struct kvs_cparams, filter_type),
+        .ps_convert = filter_type_converter,
+        .ps_validate = param_default_validator,
+        .ps_stringify = filter_type_stringify,
+        .ps_jsonify = filter_type_jsonify,
+        .ps_default_value = {
+            .as_enum = KVS_FILTER_BLOOM,
+        },
+        .ps_bounds = {
+            .as_enum = {
+                .ps_min = KVS_FILTER_MIN,
+                .ps_max = KVS_FILTER_MAX,
+            },
+        },
+    },
 };
 
 const struct param_spec *
@@ -13,6 +13,7 @@
 #include <hse_util/compression_lz4.h>
 
 #include <hse/kvdb_perfc.h>
+#include <hse/experimental.h>
 
 #include <hse_ikvdb/c0.h>
 #include <hse_ikvdb/lc.h>
@@ -164,11 +165,17 @@ struct kvs_cursor_impl {
     u8 *                       kci_last_kbuf;
     u32                        kci_last_klen;
 
+    /* range tombstones of c0 and cn, keys owned by the c0/cn cursors */
+    struct rtomb *             kci_rtombv;
+    u32                        kci_rtombc;
+    u32                        kci_rtombmax;
+
     u32 kci_eof : 1;
     u32 kci_need_toss : 1;
     u32 kci_need_seek : 1;
     u32 kci_need_prepare : 1;
     u32 kci_reverse : 1;
+    u32 kci_keys_only : 1;
     u32 kci_ptomb_set : 1;
 
     u32    kci_pfxlen;
@@ -391,9 +398,14 @@ ikvs_curcache_timer_cb(ulong arg)
  * we have to touch while walking the tree.
  */
 static HSE_ALWAYS_INLINE uint64_t
-ikvs_curcache_key(const uint64_t gen, const char *prefix, const u64 pfxhash, const bool reverse)
+ikvs_curcache_key(
+    const uint64_t gen,
+    const char *   prefix,
+    const u64      pfxhash,
+    const bool     reverse,
+    const bool     keys_only)
 {
-    return (gen << 24) | (pfxhash & 0xfffffau) | ((!!prefix) << 1) | reverse;
+    return (gen << 24) | (pfxhash & 0xfffffau) | (keys_only << 2) | ((!!prefix) << 1) | reverse;
 }
 
 static HSE_ALWAYS_INLINE int
@@ -573,14 +585,20 @@ ikvs_cursor_reset(struct kvs_cursor_impl *cursor)
 }
 
 static struct kvs_cursor_impl *
-ikvs_cursor_restore(struct ikvs *kvs, const void *prefix, size_t pfx_len, u64 pfxhash, bool reverse)
+ikvs_cursor_restore(
+    struct ikvs *kvs,
+    const void * prefix,
+    size_t       pfx_len,
+    u64          pfxhash,
+    bool         reverse,
+    bool         keys_only)
 {
     struct kvs_cursor_impl *cur;
     uint64_t                key, tstart;
 
     tstart = perfc_lat_startl(&kvs->ikv_cd_pc, PERFC_LT_CD_RESTORE);
 
-    key = ikvs_curcache_key(kvs->ikv_gen, prefix, pfxhash, reverse);
+    key = ikvs_curcache_key(kvs->ikv_gen, prefix, pfxhash, reverse, keys_only);
 
     cur = ikvs_curcache_remove(ikvs_curcache_td2bkt(), key, prefix, pfx_len);
     if (!cur) {
@@ -637,14 +655,19 @@ ikvs_cursor_save(struct kvs_cursor_impl *cur)
 }
 
 struct hse_kvs_cursor *
-kvs_cursor_alloc(struct ikvs *kvs, const void *prefix, size_t pfx_len, bool reverse)
+kvs_cursor_alloc(
+    struct ikvs *kvs,
+    const void * prefix,
+    size_t       pfx_len,
+    bool         reverse,
+    bool         keys_only)
 {
     struct kvs_cursor_impl *cur;
     u64                     pfxhash;
 
     pfxhash = (prefix && pfx_len > 0) ? key_hash64(prefix, pfx_len) : 0;
 
-    cur = ikvs_cursor_restore(kvs, prefix, pfx_len, pfxhash, reverse);
+    cur = ikvs_cursor_restore(kvs, prefix, pfx_len, pfxhash, reverse, keys_only);
     if (cur) {
 
         /*
@@ -663,7 +686,7 @@ kvs_cursor_alloc(struct ikvs *kvs, const void *prefix, size_t pfx_len, bool reve
 
     memset(cur, 0, sizeof(*cur));
 
-    cur->kci_item.ci_key = ikvs_curcache_key(kvs->ikv_gen, prefix, pfxhash, reverse);
+    cur->kci_item.ci_key = ikvs_curcache_key(kvs->ikv_gen, prefix, pfxhash, reverse, keys_only);
     cur->kci_cc_pc = PERFC_ISON(&kvs->ikv_cc_pc) ? &kvs->ikv_cc_pc : NULL;
     cur->kci_cd_pc = PERFC_ISON(&kvs->ikv_cd_pc) ? &kvs->ikv_cd_pc : NULL;
     cur->kci_kvs = kvs;
@@ -682,6 +705,7 @@ kvs_cursor_alloc(struct ikvs *kvs, const void *prefix, size_t pfx_len, bool reve
     cur->kci_handle.kc_filter.kcf_maxkey = 0;
 
     cur->kci_reverse = reverse;
+    cur->kci_keys_only = keys_only;
     ikvs_cursor_reset(cur);
 
     /* Pad with 0xff to make reverse cursor seek-to-pfx simple */
@@ -700,6 +724,64 @@ kvs_cursor_free(struct hse_kvs_cursor *cursor)
         ikvs_cursor_save(cursor_h2r(cursor));
 }
 
+static merr_t
+ikvs_cursor_rtomb_add(void *arg, const struct rtomb *rt)
+{
+    struct kvs_cursor_impl *cur = arg;
+
+    if (cur->kci_rtombc >= cur->kci_rtombmax) {
+        u32           max = cur->kci_rtombmax ? cur->kci_rtombmax * 2 : 8;
+        struct rtomb *rtv;
+
+        rtv = realloc(cur->kci_rtombv, max * sizeof(*rtv));
+        if (ev(!rtv))
+            return merr(ENOMEM);
+
+        cur->kci_rtombv = rtv;
+        cur->kci_rtombmax = max;
+    }
+
+    cur->kci_rtombv[cur->kci_rtombc++] = *rt;
+
+    return 0;
+}
+
+/* Gather the range tombstones of the c0 and cn cursors, which must be
+ * repeated whenever they are updated.
+ */
+static merr_t
+ikvs_cursor_rtombs_load(struct kvs_cursor_impl *cur)
+{
+    merr_t err;
+
+    cur->kci_rtombc = 0;
+
+    err = c0_cursor_rtombs(cur->kci_c0cur, ikvs_cursor_rtomb_add, cur);
+    if (ev(err))
+        return err;
+
+    err = cn_cursor_rtombs(cur->kci_cncur, ikvs_cursor_rtomb_add, cur);
+    if (ev(err))
+        return err;
+
+    rtomb_sort(cur->kci_rtombv, cur->kci_rtombc);
+
+    return 0;
+}
+
+static bool
+ikvs_cursor_rtomb_hides(struct kvs_cursor_impl *cur, struct kvs_cursor_element *item)
+{
+    u64 seqno;
+
+    /* Elements of an active txn are newer than any visible tombstone */
+    if (seqnoref_to_seqno(item->kce_seqnoref, &seqno) != HSE_SQNREF_STATE_DEFINED)
+        return false;
+
+    return seqno < rtomb_seqno(cur->kci_rtombv, cur->kci_rtombc, &item->kce_kobj,
+                               cur->kci_handle.kc_seq);
+}
+
 static merr_t
 kvs_cursor_bh_create(struct hse_kvs_cursor *cursor)
 {
@@ -808,7 +890,8 @@ kvs_cursor_init(struct hse_kvs_cursor *cursor, struct kvdb_ctxn *ctxn)
         /* Create cn cursor */
         perfc_inc(cur->kci_cc_pc, PERFC_BA_CC_INIT_CREATE_CN);
         tstart = perfc_lat_startu(cur->kci_cd_pc, PERFC_LT_CD_CREATE_CN);
-        err = cn_cursor_create(cn, seqno, reverse, prefix, pfxlen, summary, &cur->kci_cncur);
+        err = cn_cursor_create(
+            cn, seqno, reverse, cur->kci_keys_only, prefix, pfxlen, summary, &cur->kci_cncur);
         perfc_lat_record(cur->kci_cd_pc, PERFC_LT_CD_CREATE_CN, tstart);
     } else {
         /* Update cn cursor */
@@ -850,6 +933,10 @@ kvs_cursor_init(struct hse_kvs_cursor *cursor, struct kvdb_ctxn *ctxn)
     if (cursor->kc_bind)
         c0_cursor_bind_txn(cur->kci_c0cur, ctxn);
 
+    err = ikvs_cursor_rtombs_load(cur);
+    if (ev(err))
+        goto error;
+
     err = kvs_cursor_bh_create(cursor);
 
 error:
@@ -887,6 +974,7 @@ kvs_cursor_destroy(struct hse_kvs_cursor *handle)
     if (cursor->kci_bh)
         bin_heap2_destroy(cursor->kci_bh);
 
+    free(cursor->kci_rtombv);
     vlb_free(cursor, kvs_cursor_impl_alloc_sz);
 }
 
@@ -961,6 +1049,10 @@ kvs_cursor_update(struct hse_kvs_cursor *handle, struct kvdb_ctxn *ctxn, u64 seq
         perfc_rec_sample(cursor->kci_cd_pc, PERFC_DI_CD_ACTIVEKVSETS_CN, active);
     }
 
+    cursor->kci_err = ikvs_cursor_rtombs_load(cursor);
+    if (ev(cursor->kci_err))
+        return cursor->kci_err;
+
     /* Seek will re-prepare the binheap. */
     cursor->kci_need_seek = 1;
 
@@ -1049,6 +1141,12 @@ ikvs_cursor_replenish(struct kvs_cursor_impl *cursor)
             }
         }
 
+        if (!is_ptomb && cursor->kci_rtombc &&
+            ikvs_cursor_rtomb_hides(cursor, &cursor->kci_elem_last)) {
+            is_tomb = true;
+            continue;
+        }
+
         if (is_ptomb) {
             cursor->kci_ptomb = cursor->kci_elem_last;
             cursor->kci_ptomb_set = 1;
@@ -1140,6 +1238,17 @@ kvs_cursor_val_copy(
     uint               clen = cur->kci_elem_last.kce_complen;
     merr_t             err = 0;
 
+    /* A keys-only cursor reports only the length of each value, as cn
+     * never reads (or decompresses) values on behalf of such a cursor.
+     */
+    if (cur->kci_keys_only) {
+        if (vlen_out)
+            *vlen_out = vt->vt_xlen;
+        if (val_out)
+            *val_out = NULL;
+        return 0;
+    }
+
     if (!buf) {
         buf = cur->kci_buf + HSE_KVS_KEY_LEN_MAX;
         bufsz = HSE_KVS_VALUE_LEN_MAX;
@@ -1248,6 +1357,77 @@ kvs_cursor_read(struct hse_kvs_cursor *handle, unsigned int flags, bool *eofp)
     return cursor->kci_err;
 }
 
+merr_t
+kvs_cursor_read_batch(
+    struct hse_kvs_cursor *   handle,
+    unsigned int              flags,
+    void *                    buf,
+    size_t                    bufsz,
+    struct hse_kvs_cursor_kv *kvv,
+    size_t                    kvc,
+    size_t *                  kvcnt,
+    bool *                    eofp)
+{
+    struct kvs_cursor_impl *cursor = (void *)handle;
+    bool                    keys_only = (flags & HSE_CURSOR_READ_KEYS) || cursor->kci_keys_only;
+    size_t                  used = 0;
+    size_t                  cnt = 0;
+    merr_t                  err;
+
+    *kvcnt = 0;
+
+    /* The first pair is read the usual way so as to apply any pending
+     * prepare, seek or toss.  Thereafter each pair is simply popped off
+     * the merge heap by ikvs_cursor_replenish().
+     */
+    err = kvs_cursor_read(handle, 0, eofp);
+    if (ev(err) || *eofp)
+        return err;
+
+    while (true) {
+        struct hse_kvs_cursor_kv *kv = kvv + cnt;
+        size_t                    klen, vlen, need;
+
+        klen = key_obj_len(cursor->kci_last);
+        vlen = cursor->kci_elem_last.kce_vt.vt_xlen;
+        need = klen + (keys_only ? 0 : vlen);
+
+        if (used + need > bufsz) {
+            /* Leave the pair to be returned by the next read. */
+            cursor->kci_need_toss = 0;
+            if (cnt == 0)
+                return merr(ENOSPC);
+            break;
+        }
+
+        kvs_cursor_key_copy(handle, buf + used, klen, &kv->kv_key, &kv->kv_key_len);
+        used += klen;
+
+        kv->kv_val = NULL;
+        kv->kv_val_len = vlen;
+
+        if (!keys_only) {
+            err = kvs_cursor_val_copy(handle, buf + used, vlen, &kv->kv_val, &kv->kv_val_len);
+            if (ev(err))
+                break;
+            used += vlen;
+        }
+
+        if (++cnt >= kvc)
+            break;
+
+        cursor->kci_err = ikvs_cursor_replenish(cursor);
+        if (ev(cursor->kci_err) || cursor->kci_eof) {
+            err = cursor->kci_err;
+            break;
+        }
+    }
+
+    *kvcnt = cnt;
+
+    return err;
+}
+
 merr_t
 kvs_cursor_seek(
     struct hse_kvs_cursor *handle,
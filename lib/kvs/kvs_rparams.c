@@ -72,7 +72,7 @@ static bool HSE_NONNULL(1, 2, 3) compression_value_algorithm_converter(
     void *const                    data)
 {
     static const char *algos[VCOMP_ALGO_COUNT] = {
-        VCOMP_PARAM_NONE, VCOMP_PARAM_LZ4
+        VCOMP_PARAM_NONE, VCOMP_PARAM_LZ4, VCOMP_PARAM_ZSTD
     };
 
     assert(ps);
@@ -84,7 +84,7 @@ static bool HSE_NONNULL(1, 2, 3) compression_value_algorithm_converter(
 
     const char *value = cJSON_GetStringValue(node);
 
-    for (size_t i = VCOMP_ALGO_NONE; i < NELEM(algos); i++) {
+    for (size_t i = VCOMP_ALGO_NONE; i <= ps->ps_bounds.as_enum.ps_max; i++) {
         if (!strcmp(algos[i], value)) {
             *(enum vcomp_algorithm *)data = i;
             return true;
@@ -120,6 +120,9 @@ compression_value_algorithm_stringify(
         case VCOMP_ALGO_LZ4:
             param = VCOMP_PARAM_LZ4;
             break;
+        case VCOMP_ALGO_ZSTD:
+            param = VCOMP_PARAM_ZSTD;
+            break;
     }
 
     assert(param);
@@ -147,6 +150,8 @@ compression_value_jsonify(const struct param_spec *const ps, const void *const v
             return cJSON_CreateString(VCOMP_PARAM_NONE);
         case VCOMP_ALGO_LZ4:
             return cJSON_CreateString(VCOMP_PARAM_LZ4);
+        case VCOMP_ALGO_ZSTD:
+            return cJSON_CreateString(VCOMP_PARAM_ZSTD);
     }
 
     abort();
@@ -317,6 +322,27 @@ static const struct param_spec pspecs[] = {
             },
         },
     },
+    {
+        .ps_name = "cn_compact_aio_qdepth",
+        .ps_description = "compaction async read queue depth per kvset (0: use cn_io_threads)",
+        .ps_flags = PARAM_FLAG_EXPERIMENTAL,
+        .ps_type = PARAM_TYPE_U32,
+        .ps_offset = offsetof(struct kvs_rparams, cn_compact_aio_qdepth),
+        .ps_size = PARAM_SZ(struct kvs_rparams, cn_compact_aio_qdepth),
+        .ps_convert = param_default_converter,
+        .ps_validate = param_default_validator,
+        .ps_stringify = param_default_stringify,
+        .ps_jsonify = param_default_jsonify,
+        .ps_default_value = {
+            .as_uscalar = 0,
+        },
+        .ps_bounds = {
+            .as_uscalar = {
+                .ps_min = 0,
+                .ps_max = 1024,
+            },
+        },
+    },
     {
         .ps_name = "cn_capped_ttl",
         .ps_description = "cn cursor cache TTL (ms) for capped kvs",
@@ -543,6 +569,27 @@ static const struct param_spec pspecs[] = {
             },
         },
     },
+    {
+        .ps_name = "cn_bcache",
+        .ps_description = "use kvdb page cache for gets (1:enable, 2:also prioritize wbt internal nodes and blooms)",
+        .ps_flags = PARAM_FLAG_EXPERIMENTAL,
+        .ps_type = PARAM_TYPE_U8,
+        .ps_offset = offsetof(struct kvs_rparams, cn_bcache),
+        .ps_size = PARAM_SZ(struct kvs_rparams, cn_bcache),
+        .ps_convert = param_default_converter,
+        .ps_validate = param_default_validator,
+        .ps_stringify = param_default_stringify,
+        .ps_jsonify = param_default_jsonify,
+        .ps_default_value = {
+            .as_uscalar = 2,
+        },
+        .ps_bounds = {
+            .as_uscalar = {
+                .ps_min = 0,
+                .ps_max = 2,
+            },
+        },
+    },
     {
         .ps_name = "cn_diag_mode",
         .ps_description = "enable/disable cn diag mode",
@@ -856,6 +903,42 @@ static const struct param_spec pspecs[] = {
         .ps_default_value = {
             .as_enum = VCOMP_ALGO_NONE,
         },
+        .ps_bounds = {
+            .as_enum = {
+                .ps_min = VCOMP_ALGO_MIN,
+                .ps_max = VCOMP_ALGO_PUT_MAX,
+            },
+        },
+    },
+    {
+        .ps_name = "compression.value.defer",
+        .ps_description = "defer value compression from put to kv-compaction and spill",
+        .ps_flags = 0,
+        .ps_type = PARAM_TYPE_BOOL,
+        .ps_offset = offsetof(struct kvs_rparams, vcomp_defer),
+        .ps_size = PARAM_SZ(struct kvs_rparams, vcomp_defer),
+        .ps_convert = param_default_converter,
+        .ps_validate = param_default_validator,
+        .ps_stringify = param_default_stringify,
+        .ps_jsonify = param_default_jsonify,
+        .ps_default_value = {
+            .as_bool = false,
+        },
+    },
+    {
+        .ps_name = "compression.cn.algorithm",
+        .ps_description = "value compression applied by kv-compaction and spill (none, lz4 or zstd)",
+        .ps_flags = PARAM_FLAG_EXPERIMENTAL,
+        .ps_type = PARAM_TYPE_ENUM,
+        .ps_offset = offsetof(struct kvs_rparams, cn_vcomp),
+        .ps_size = PARAM_SZ(struct kvs_rparams, cn_vcomp),
+        .ps_convert = compression_value_algorithm_converter,
+        .ps_validate = param_default_validator,
+        .ps_stringify = compression_value_algorithm_stringify,
+        .ps_jsonify = compression_value_jsonify,
+        .ps_default_value = {
+            .as_enum = VCOMP_ALGO_NONE,
+        },
         .ps_bounds = {
             .as_enum = {
                 .ps_min = VCOMP_ALGO_MIN,
@@ -863,6 +946,69 @@ static const struct param_spec pspecs[] = {
             },
         },
     },
+    {
+        .ps_name = "compression.cn.zstd_level",
+        .ps_description = "zstd compression level used by kv-compaction and spill",
+        .ps_flags = PARAM_FLAG_EXPERIMENTAL,
+        .ps_type = PARAM_TYPE_U32,
+        .ps_offset = offsetof(struct kvs_rparams, cn_vcomp_level),
+        .ps_size = PARAM_SZ(struct kvs_rparams, cn_vcomp_level),
+        .ps_convert = param_default_converter,
+        .ps_validate = param_default_validator,
+        .ps_stringify = param_default_stringify,
+        .ps_jsonify = param_default_jsonify,
+        .ps_default_value = {
+            .as_uscalar = HSE_CN_VCOMP_LEVEL_DFLT,
+        },
+        .ps_bounds = {
+            .as_uscalar = {
+                .ps_min = HSE_CN_VCOMP_LEVEL_MIN,
+                .ps_max = HSE_CN_VCOMP_LEVEL_MAX,
+            },
+        },
+    },
+    {
+        .ps_name = "compression.cn.dict_size",
+        .ps_description = "size of the per-kvs zstd dictionary trained by compaction (0 disables)",
+        .ps_flags = PARAM_FLAG_EXPERIMENTAL,
+        .ps_type = PARAM_TYPE_U32,
+        .ps_offset = offsetof(struct kvs_rparams, cn_vcomp_dictsz),
+        .ps_size = PARAM_SZ(struct kvs_rparams, cn_vcomp_dictsz),
+        .ps_convert = param_default_converter,
+        .ps_validate = param_default_validator,
+        .ps_stringify = param_default_stringify,
+        .ps_jsonify = param_default_jsonify,
+        .ps_default_value = {
+            .as_uscalar = HSE_CN_VCOMP_DICTSZ_DFLT,
+        },
+        .ps_bounds = {
+            .as_uscalar = {
+                .ps_min = 0,
+                .ps_max = HSE_CN_VCOMP_DICTSZ_MAX,
+            },
+        },
+    },
+    {
+        .ps_name = "compression.cn.block_size",
+        .ps_description = "size of compressed blocks into which compaction packs small values (0 disables)",
+        .ps_flags = PARAM_FLAG_EXPERIMENTAL,
+        .ps_type = PARAM_TYPE_U32,
+        .ps_offset = offsetof(struct kvs_rparams, cn_vcomp_blksz),
+        .ps_size = PARAM_SZ(struct kvs_rparams, cn_vcomp_blksz),
+        .ps_convert = param_default_converter,
+        .ps_validate = param_default_validator,
+        .ps_stringify = param_default_stringify,
+        .ps_jsonify = param_default_jsonify,
+        .ps_default_value = {
+            .as_uscalar = 0,
+        },
+        .ps_bounds = {
+            .as_uscalar = {
+                .ps_min = 0,
+                .ps_max = HSE_CN_VCOMP_BLKSZ_MAX,
+            },
+        },
+    },
 };
 
 const struct param_spec *
@@ -166,10 +166,16 @@ bonsai_iter_next(struct element_source *es, void **element)
 
     elem = &iter->bi_elem;
     key2kobj(&elem->kce_kobj, bkv->bkv_key, key_imm_klen(&bkv->bkv_key_imm));
-    kvs_vtuple_init(&elem->kce_vt, val->bv_value, bonsai_val_ulen(val));
     elem->kce_source = KCE_SOURCE_LC;
     elem->kce_seqnoref = val->bv_seqnoref;
-    elem->kce_complen = bonsai_val_clen(val);
+
+    if (kvs_expired(val->bv_expire)) {
+        kvs_vtuple_init(&elem->kce_vt, HSE_CORE_TOMB_REG, 0);
+        elem->kce_complen = 0;
+    } else {
+        kvs_vtuple_init(&elem->kce_vt, val->bv_value, bonsai_val_ulen(val));
+        elem->kce_complen = bonsai_val_clen(val);
+    }
     elem->kce_is_ptomb = iter->bi_is_ptomb;
 
     *element = &iter->bi_elem;
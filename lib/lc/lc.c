@@ -490,6 +490,7 @@ lc_builder_cb(void *rock, struct bonsai_kv *bkv, struct bonsai_val *vlist)
         struct bonsai_sval  sval;
 
         bn_sval_init(val->bv_value, val->bv_xlen, val->bv_seqnoref, &sval);
+        sval.bsv_expire = val->bv_expire;
         root = sval.bsv_val == HSE_CORE_TOMB_PFX ? rcu_dereference(lc->lc_broot[0])
                                                  : rcu_dereference(lc->lc_broot[1]);
 
@@ -610,7 +611,10 @@ lc_get_main(
     *val_out = val;
     *oseqnoref = val->bv_seqnoref;
 
-    *res = HSE_CORE_IS_TOMB(val->bv_value) ? FOUND_TMB : FOUND_VAL;
+    if (HSE_CORE_IS_TOMB(val->bv_value) || kvs_expired(val->bv_expire))
+        *res = FOUND_TMB;
+    else
+        *res = FOUND_VAL;
 }
 
 static merr_t
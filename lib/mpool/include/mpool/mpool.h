@@ -16,7 +16,9 @@
 struct mpool;            /* opaque mpool handle */
 struct mpool_mdc;        /* opaque MDC (metadata container) handle */
 struct mpool_mcache_map; /* opaque mcache map handle */
+struct mpool_bcache_page; /* opaque pinned bcache page handle */
 struct mpool_file;       /* opaque mpool file handle */
+struct mpool_aio_ctx;    /* opaque async io context */
 struct iovec;
 
 /* MTF_MOCK_DECL(mpool) */
@@ -439,6 +441,107 @@ mpool_mblock_write(struct mpool *mp, uint64_t mbid, const struct iovec *iov, int
 merr_t
 mpool_mblock_read(struct mpool *mp, uint64_t mbid, const struct iovec *iov, int iovc, off_t offset);
 
+/**
+ * mpool_aio_cb_t - completion callback for asynchronous reads and writes
+ *
+ * @arg: argument given to mpool_mblock_read_async() or mpool_file_write_async()
+ * @err: completion status
+ * @len: number of bytes read or written on success
+ */
+typedef void mpool_aio_cb_t(void *arg, merr_t err, size_t len);
+
+/**
+ * mpool_aio_ctx_create() - create an asynchronous io context
+ *
+ * @qdepth: max number of in-flight requests
+ * @ctx:    async io context (output)
+ *
+ * An async context batches the reads issued via mpool_mblock_read_async()
+ * and the writes issued via mpool_file_write_async(), and completes them
+ * when polled with mpool_aio_poll().  A context may be used by only one
+ * thread at a time.
+ *
+ * Return: %0 on success, ENOTSUP if no async io backend is available
+ */
+/* MTF_MOCK */
+merr_t
+mpool_aio_ctx_create(unsigned int qdepth, struct mpool_aio_ctx **ctx);
+
+/**
+ * mpool_aio_ctx_destroy() - wait for in-flight requests and destroy an async io context
+ *
+ * @ctx: async io context
+ */
+/* MTF_MOCK */
+void
+mpool_aio_ctx_destroy(struct mpool_aio_ctx *ctx);
+
+/**
+ * mpool_mblock_read_async() - queue an asynchronous read from an mblock
+ *
+ * @mp:      mpool
+ * @ctx:     async io context
+ * @mbid:    mblock object ID
+ * @iov:     iovec for output data (must remain valid until @cb is invoked)
+ * @iov_cnt: length of iov[]
+ * @offset:  PAGE aligned offset into the mblock
+ * @cb:      completion callback, invoked from mpool_aio_poll()
+ * @arg:     completion callback argument
+ *
+ * The read is not issued to the device until the next call to
+ * mpool_aio_submit() or mpool_aio_poll().
+ *
+ * Return: %0 on success, <%0 on error
+ */
+/* MTF_MOCK */
+merr_t
+mpool_mblock_read_async(
+    struct mpool         *mp,
+    struct mpool_aio_ctx *ctx,
+    uint64_t              mbid,
+    const struct iovec   *iov,
+    int                   iovc,
+    off_t                 offset,
+    mpool_aio_cb_t       *cb,
+    void                 *arg);
+
+/**
+ * mpool_aio_submit() - submit all queued reads and writes to the device in one batch
+ *
+ * @ctx: async io context
+ */
+/* MTF_MOCK */
+merr_t
+mpool_aio_submit(struct mpool_aio_ctx *ctx);
+
+/**
+ * mpool_aio_buffers_register() - register long-lived io buffers with an async io context
+ *
+ * @ctx: async io context
+ * @iov: buffers to register
+ * @iovc: length of iov[]
+ *
+ * Writes issued from within a registered buffer avoid the cost of pinning
+ * and unpinning the buffer's pages on every request.  Registration may
+ * fail (e.g., due to RLIMIT_MEMLOCK), in which case requests still work
+ * but are issued unregistered.  May be called at most once per context.
+ */
+/* MTF_MOCK */
+merr_t
+mpool_aio_buffers_register(struct mpool_aio_ctx *ctx, const struct iovec *iov, int iovc);
+
+/**
+ * mpool_aio_poll() - submit queued reads and writes and reap completions
+ *
+ * @ctx:          async io context
+ * @min_complete: min number of completions to wait for
+ *
+ * Invokes the completion callback of each reaped read or write.
+ */
+/* MTF_MOCK */
+merr_t
+mpool_aio_poll(struct mpool_aio_ctx *ctx, unsigned int min_complete);
+
 /******************************** MCACHE APIs ************************************/
 
 /**
@@ -555,6 +658,55 @@ mpool_mcache_mincore(
     size_t *                 rssp,
     size_t *                 vssp);
 
+/**
+ * mpool_bcache_get() - Pin a page of an mblock in the mpool page cache
+ *
+ * @mp:    mpool handle
+ * @mbid:  mblock ID
+ * @pgno:  page number within the mblock
+ * @prio:  retain this page in preference to non-priority pages
+ * @pagep: pinned page handle (output)
+ * @addrp: address of the cached page (output)
+ *
+ * The page cache is an alternative to mcache maps that reads pages with
+ * direct io into a fixed size pool of buffers, so that cached mblock data
+ * neither depends on nor consumes the kernel page cache.  It is present
+ * only if the mpool was opened with a non-zero mpool_rparams.bcache_size.
+ *
+ * The returned address remains valid until the page is released with
+ * mpool_bcache_put().
+ *
+ * Return: %0 on success, ENOENT if the mpool has no page cache, EBUSY if
+ * every page in the cache is pinned, merr_t on read failure
+ */
+/* MTF_MOCK */
+merr_t
+mpool_bcache_get(
+    struct mpool              *mp,
+    uint64_t                   mbid,
+    uint32_t                   pgno,
+    bool                       prio,
+    struct mpool_bcache_page **pagep,
+    void                     **addrp);
+
+/**
+ * mpool_bcache_put() - Release a page pinned by mpool_bcache_get()
+ *
+ * @page: pinned page handle
+ */
+/* MTF_MOCK */
+void
+mpool_bcache_put(struct mpool_bcache_page *page);
+
+/**
+ * mpool_bcache_enabled() - Check whether the mpool has a page cache
+ *
+ * @mp: mpool handle
+ */
+/* MTF_MOCK */
+bool
+mpool_bcache_enabled(struct mpool *mp);
+
 /**
  * An mpool_file is a simple wrapper around mpool to manage files in a specified
  * mpool and media class.
@@ -628,6 +780,32 @@ mpool_file_write(
     size_t             buflen,
     size_t            *wrlen);
 
+/**
+ * mpool_file_write_async() - queue an asynchronous write to an mpool file
+ *
+ * @file:   mpool file handle
+ * @ctx:    async io context
+ * @offset: write offset
+ * @buf:    write buffer (must remain valid until @cb is invoked)
+ * @buflen: buffer len
+ * @cb:     completion callback, invoked from mpool_aio_poll()
+ * @arg:    completion callback argument
+ *
+ * The write is not issued to the device until the next call to
+ * mpool_aio_submit() or mpool_aio_poll().  Alignment requirements are
+ * those of the flags given to mpool_file_open().
+ */
+/* MTF_MOCK */
+merr_t
+mpool_file_write_async(
+    struct mpool_file    *file,
+    struct mpool_aio_ctx *ctx,
+    off_t                 offset,
+    const char           *buf,
+    size_t                buflen,
+    mpool_aio_cb_t       *cb,
+    void                 *arg);
+
 /**
  * mpool_file_sync() - Sync mpool file
  *
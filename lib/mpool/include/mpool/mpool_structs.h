@@ -48,12 +48,14 @@ struct mpool_cparams {
 /**
  * struct mpool_rparams - mpool run params
  *
- * @path:      storage path
+ * @path:        storage path
+ * @bcache_size: userspace page cache size in bytes (0: disabled)
  */
 struct mpool_rparams {
     struct {
         char path[PATH_MAX];
     } mclass[HSE_MCLASS_COUNT];
+    uint64_t bcache_size;
 };
 
 /**
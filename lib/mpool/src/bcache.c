@@ -0,0 +1,404 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/*
+ * Copyright (C) 2021 Micron Technology, Inc.  All rights reserved.
+ */
+
+#include <hse_util/alloc.h>
+#include <hse_util/assert.h>
+#include <hse_util/atomic.h>
+#include <hse_util/condvar.h>
+#include <hse_util/event_counter.h>
+#include <hse_util/log2.h>
+#include <hse_util/logging.h>
+#include <hse_util/minmax.h>
+#include <hse_util/mutex.h>
+#include <hse_util/page.h>
+
+#include <mpool/mpool.h>
+
+#include "mpool_internal.h"
+#include "bcache.h"
+
+#define BCACHE_SHARDS_MAX      (64)
+#define BCACHE_SHARD_PAGES_MIN (1024)
+
+/* CLOCK weights given to a page on each access.  Priority pages survive
+ * several sweeps of the clock hand without being referenced.
+ */
+#define BCACHE_CLOCK_NORMAL (1)
+#define BCACHE_CLOCK_PRIO   (3)
+
+#define BCACHE_NIL (UINT32_MAX)
+
+enum bcache_page_state {
+    BP_FREE = 0,
+    BP_LOADING,
+    BP_VALID,
+};
+
+/**
+ * struct mpool_bcache_page - cached mblock page
+ * @bp_mbid:  mblock ID
+ * @bp_pgno:  page number within the mblock
+ * @bp_next:  next page in hash chain (index into shard page vector)
+ * @bp_pins:  number of outstanding bcache_get() references
+ * @bp_clock: CLOCK reference weight
+ * @bp_state: page state (enum bcache_page_state)
+ * @bp_addr:  page-aligned page buffer
+ *
+ * All fields except @bp_pins are protected by the shard lock.  @bp_pins
+ * is only ever incremented under the shard lock, so a page observed with
+ * zero pins under the lock cannot be concurrently acquired.
+ */
+struct mpool_bcache_page {
+    uint64_t             bp_mbid;
+    uint32_t             bp_pgno;
+    uint32_t             bp_next;
+    atomic_int           bp_pins;
+    uint8_t              bp_clock;
+    uint8_t              bp_state;
+    void                *bp_addr;
+};
+
+/**
+ * struct bcache_shard - independently locked partition of the cache
+ * @bs_lock:    protects the hash table, page states and clock hand
+ * @bs_cv:      signaled when a page finishes loading
+ * @bs_hand:    CLOCK hand (index into @bs_pagev)
+ * @bs_pagec:   number of pages in this shard
+ * @bs_bktmask: hash bucket mask
+ * @bs_bktv:    hash bucket heads (indices into @bs_pagev)
+ * @bs_pagev:   page descriptors
+ * @bs_mem:     page buffers
+ * @bs_hits:    number of cache hits
+ * @bs_misses:  number of cache misses
+ */
+struct bcache_shard {
+    struct mutex              bs_lock;
+    struct cv                 bs_cv;
+    uint32_t                  bs_hand;
+    uint32_t                  bs_pagec;
+    uint32_t                  bs_bktmask;
+    uint32_t                 *bs_bktv;
+    struct mpool_bcache_page *bs_pagev;
+    void                     *bs_mem;
+    uint64_t                  bs_hits;
+    uint64_t                  bs_misses;
+} HSE_L1D_ALIGNED;
+
+/**
+ * struct bcache - userspace mblock page cache
+ * @bc_mp:     mpool used to fill misses
+ * @bc_shardc: number of shards
+ * @bc_shardv: shard vector
+ */
+struct bcache {
+    struct mpool       *bc_mp;
+    uint                bc_shardc;
+    struct bcache_shard bc_shardv[];
+};
+
+static HSE_ALWAYS_INLINE uint64_t
+bcache_hash(uint64_t mbid, uint32_t pgno)
+{
+    uint64_t h;
+
+    h = mbid * 0x9e3779b97f4a7c15ull;
+    h ^= (uint64_t)pgno * 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+
+    return h;
+}
+
+static struct mpool_bcache_page *
+bcache_shard_find(struct bcache_shard *bs, uint64_t h, uint64_t mbid, uint32_t pgno)
+{
+    uint32_t idx = bs->bs_bktv[h & bs->bs_bktmask];
+
+    while (idx != BCACHE_NIL) {
+        struct mpool_bcache_page *bp = bs->bs_pagev + idx;
+
+        if (bp->bp_mbid == mbid && bp->bp_pgno == pgno)
+            return bp;
+
+        idx = bp->bp_next;
+    }
+
+    return NULL;
+}
+
+static void
+bcache_shard_unhash(struct bcache_shard *bs, struct mpool_bcache_page *bp)
+{
+    uint32_t *idxp;
+    uint32_t  idx = bp - bs->bs_pagev;
+
+    idxp = &bs->bs_bktv[bcache_hash(bp->bp_mbid, bp->bp_pgno) & bs->bs_bktmask];
+
+    while (*idxp != idx) {
+        assert(*idxp != BCACHE_NIL);
+        idxp = &bs->bs_pagev[*idxp].bp_next;
+    }
+
+    *idxp = bp->bp_next;
+    bp->bp_next = BCACHE_NIL;
+    bp->bp_state = BP_FREE;
+}
+
+/* Find a page to evict using CLOCK.  Pinned and loading pages are skipped,
+ * referenced pages have their weight decremented.  Returns NULL if every
+ * page stays busy for several full revolutions of the hand.
+ */
+static struct mpool_bcache_page *
+bcache_shard_evict(struct bcache_shard *bs)
+{
+    uint32_t n;
+
+    for (n = 0; n < bs->bs_pagec * (BCACHE_CLOCK_PRIO + 1); n++) {
+        struct mpool_bcache_page *bp = bs->bs_pagev + bs->bs_hand;
+
+        if (++bs->bs_hand >= bs->bs_pagec)
+            bs->bs_hand = 0;
+
+        if (bp->bp_state == BP_FREE)
+            return bp;
+
+        if (bp->bp_state == BP_LOADING || atomic_read(&bp->bp_pins) > 0)
+            continue;
+
+        if (bp->bp_clock > 0) {
+            bp->bp_clock--;
+            continue;
+        }
+
+        bcache_shard_unhash(bs, bp);
+
+        return bp;
+    }
+
+    return NULL;
+}
+
+merr_t
+bcache_get(
+    struct bcache             *bc,
+    uint64_t                   mbid,
+    uint32_t                   pgno,
+    bool                       prio,
+    struct mpool_bcache_page **pagep,
+    void                     **addrp)
+{
+    struct mpool_bcache_page *bp;
+    struct bcache_shard      *bs;
+    struct iovec              iov;
+    uint8_t                   clock;
+    uint64_t                  h;
+    merr_t                    err;
+
+    h = bcache_hash(mbid, pgno);
+    bs = bc->bc_shardv + (h >> 32) % bc->bc_shardc;
+    clock = prio ? BCACHE_CLOCK_PRIO : BCACHE_CLOCK_NORMAL;
+
+    mutex_lock(&bs->bs_lock);
+    while (1) {
+        bp = bcache_shard_find(bs, h, mbid, pgno);
+        if (!bp)
+            break;
+
+        if (bp->bp_state == BP_VALID) {
+            atomic_inc(&bp->bp_pins);
+            if (bp->bp_clock < clock)
+                bp->bp_clock = clock;
+            bs->bs_hits++;
+            mutex_unlock(&bs->bs_lock);
+
+            *pagep = bp;
+            *addrp = bp->bp_addr;
+
+            return 0;
+        }
+
+        /* Another thread is filling this page, wait for it (and then
+         * recheck as the fill may have failed).
+         */
+        cv_wait(&bs->bs_cv, &bs->bs_lock);
+    }
+
+    bp = bcache_shard_evict(bs);
+    if (ev(!bp)) {
+        mutex_unlock(&bs->bs_lock);
+        return merr(EBUSY);
+    }
+
+    bp->bp_mbid = mbid;
+    bp->bp_pgno = pgno;
+    bp->bp_clock = clock;
+    bp->bp_state = BP_LOADING;
+    bp->bp_next = bs->bs_bktv[h & bs->bs_bktmask];
+    bs->bs_bktv[h & bs->bs_bktmask] = bp - bs->bs_pagev;
+    atomic_set(&bp->bp_pins, 1);
+    bs->bs_misses++;
+    mutex_unlock(&bs->bs_lock);
+
+    iov.iov_base = bp->bp_addr;
+    iov.iov_len = PAGE_SIZE;
+
+    err = mpool_mblock_read(bc->bc_mp, mbid, &iov, 1, (off_t)pgno * PAGE_SIZE);
+
+    mutex_lock(&bs->bs_lock);
+    if (ev(err)) {
+        atomic_set(&bp->bp_pins, 0);
+        bcache_shard_unhash(bs, bp);
+    } else {
+        bp->bp_state = BP_VALID;
+    }
+    cv_broadcast(&bs->bs_cv);
+    mutex_unlock(&bs->bs_lock);
+
+    if (err)
+        return err;
+
+    *pagep = bp;
+    *addrp = bp->bp_addr;
+
+    return 0;
+}
+
+void
+bcache_put(struct mpool_bcache_page *page)
+{
+    int pins HSE_MAYBE_UNUSED;
+
+    pins = atomic_dec_return(&page->bp_pins);
+    assert(pins >= 0);
+}
+
+merr_t
+bcache_create(struct mpool *mp, size_t size, struct bcache **bcp)
+{
+    struct bcache *bc;
+    size_t         pagec;
+    uint           shardc, i, j;
+
+    if (!mp || !bcp)
+        return merr(EINVAL);
+
+    pagec = size / PAGE_SIZE;
+    if (ev(pagec == 0))
+        return merr(EINVAL);
+
+    shardc = clamp_t(size_t, pagec / BCACHE_SHARD_PAGES_MIN, 1, BCACHE_SHARDS_MAX);
+
+    bc = alloc_aligned(sizeof(*bc) + shardc * sizeof(bc->bc_shardv[0]), alignof(*bc));
+    if (ev(!bc))
+        return merr(ENOMEM);
+
+    memset(bc, 0, sizeof(*bc) + shardc * sizeof(bc->bc_shardv[0]));
+    bc->bc_mp = mp;
+    bc->bc_shardc = shardc;
+
+    for (i = 0; i < shardc; i++) {
+        struct bcache_shard *bs = bc->bc_shardv + i;
+        uint32_t             bktc;
+
+        bs->bs_pagec = pagec / shardc + (i < pagec % shardc);
+
+        bktc = roundup_pow_of_two(bs->bs_pagec);
+        bs->bs_bktmask = bktc - 1;
+
+        bs->bs_bktv = malloc(bktc * sizeof(*bs->bs_bktv));
+        bs->bs_pagev = calloc(bs->bs_pagec, sizeof(*bs->bs_pagev));
+        bs->bs_mem = alloc_page_aligned((size_t)bs->bs_pagec * PAGE_SIZE);
+
+        if (ev(!bs->bs_bktv || !bs->bs_pagev || !bs->bs_mem)) {
+            free_aligned(bs->bs_mem);
+            free(bs->bs_pagev);
+            free(bs->bs_bktv);
+
+            bc->bc_shardc = i;
+            bcache_destroy(bc);
+            return merr(ENOMEM);
+        }
+
+        for (j = 0; j < bktc; j++)
+            bs->bs_bktv[j] = BCACHE_NIL;
+
+        for (j = 0; j < bs->bs_pagec; j++) {
+            struct mpool_bcache_page *bp = bs->bs_pagev + j;
+
+            bp->bp_next = BCACHE_NIL;
+            bp->bp_addr = bs->bs_mem + (size_t)j * PAGE_SIZE;
+        }
+
+        mutex_init(&bs->bs_lock);
+        cv_init(&bs->bs_cv, "bcache");
+    }
+
+    log_info("bcache: %zu MiB, %u shards", (pagec * PAGE_SIZE) >> 20, shardc);
+
+    *bcp = bc;
+
+    return 0;
+}
+
+void
+bcache_destroy(struct bcache *bc)
+{
+    uint64_t hits = 0, misses = 0;
+    uint     i;
+
+    if (!bc)
+        return;
+
+    for (i = 0; i < bc->bc_shardc; i++) {
+        struct bcache_shard *bs = bc->bc_shardv + i;
+
+        hits += bs->bs_hits;
+        misses += bs->bs_misses;
+
+        cv_destroy(&bs->bs_cv);
+        mutex_destroy(&bs->bs_lock);
+
+        free_aligned(bs->bs_mem);
+        free(bs->bs_pagev);
+        free(bs->bs_bktv);
+    }
+
+    log_info("bcache: hits %lu, misses %lu", hits, misses);
+
+    free_aligned(bc);
+}
+
+merr_t
+mpool_bcache_get(
+    struct mpool              *mp,
+    uint64_t                   mbid,
+    uint32_t                   pgno,
+    bool                       prio,
+    struct mpool_bcache_page **pagep,
+    void                     **addrp)
+{
+    struct bcache *bc;
+
+    if (!mp || !pagep || !addrp)
+        return merr(EINVAL);
+
+    bc = mpool_bcache_handle(mp);
+    if (!bc)
+        return merr(ENOENT);
+
+    return bcache_get(bc, mbid, pgno, prio, pagep, addrp);
+}
+
+void
+mpool_bcache_put(struct mpool_bcache_page *page)
+{
+    if (page)
+        bcache_put(page);
+}
+
+bool
+mpool_bcache_enabled(struct mpool *mp)
+{
+    return mpool_bcache_handle(mp) != NULL;
+}
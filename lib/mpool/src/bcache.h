@@ -0,0 +1,67 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/*
+ * Copyright (C) 2021 Micron Technology, Inc.  All rights reserved.
+ */
+
+#ifndef MPOOL_BCACHE_H
+#define MPOOL_BCACHE_H
+
+#include <hse_util/hse_err.h>
+
+struct bcache;
+struct mpool;
+struct mpool_bcache_page;
+
+/**
+ * bcache_create() - create a userspace mblock page cache
+ *
+ * @mp:   mpool handle, used to fill cache misses
+ * @size: cache capacity in bytes
+ * @bcp:  bcache handle (output)
+ *
+ * The cache is split into a number of independently locked shards, each
+ * of which manages a fixed set of page-aligned page buffers with CLOCK
+ * replacement.  Pages are filled via mpool_mblock_read(), which uses
+ * direct io, so cached pages do not also consume page cache.
+ */
+merr_t
+bcache_create(struct mpool *mp, size_t size, struct bcache **bcp);
+
+/**
+ * bcache_destroy() - destroy a bcache
+ *
+ * @bc: bcache handle
+ *
+ * All pages must have been released via bcache_put().
+ */
+void
+bcache_destroy(struct bcache *bc);
+
+/**
+ * bcache_get() - pin a page of an mblock in the cache
+ *
+ * @bc:    bcache handle
+ * @mbid:  mblock ID
+ * @pgno:  page number within the mblock
+ * @prio:  retain this page in preference to non-priority pages
+ * @pagep: pinned page handle (output)
+ * @addrp: address of the cached page data (output)
+ */
+merr_t
+bcache_get(
+    struct bcache             *bc,
+    uint64_t                   mbid,
+    uint32_t                   pgno,
+    bool                       prio,
+    struct mpool_bcache_page **pagep,
+    void                     **addrp);
+
+/**
+ * bcache_put() - release a page pinned by bcache_get()
+ *
+ * @page: pinned page handle
+ */
+void
+bcache_put(struct mpool_bcache_page *page);
+
+#endif /* MPOOL_BCACHE_H */
@@ -24,6 +24,49 @@ struct io_ops {
     merr_t (*msync)(void *addr, size_t len, int flags);
 };
 
+struct io_aio_ops;
+
+/**
+ * struct mpool_aio_ctx - base of an asynchronous io context
+ *
+ * Each async backend embeds this at the start of its private context.  A
+ * context may be used by only one thread at a time.  Completion callbacks
+ * are invoked from within aio_poll() on the polling thread, and may queue
+ * further requests on the same context.
+ *
+ * aio_ops: backend that owns this context
+ */
+struct mpool_aio_ctx {
+    const struct io_aio_ops *aio_ops;
+};
+
+typedef void io_aio_cb_t(void *arg, merr_t err, size_t len);
+
+/**
+ * struct io_aio_ops - asynchronous io operations
+ *
+ * create:  allocate a context able to track up to qdepth in-flight requests
+ * destroy: wait for all in-flight requests to complete and free the context
+ * read:    queue a read (iov must remain valid until completion)
+ * write:   queue a write (as for read, but a single-segment iov need not
+ *          outlive the call)
+ * bufreg:  register long-lived buffers with the backend, which may then
+ *          skip per-request page pinning for writes from those buffers
+ * submit:  submit all queued requests in a single batch
+ * poll:    reap at least min_complete completions, invoking their callbacks
+ */
+struct io_aio_ops {
+    merr_t (*create)(unsigned int qdepth, struct mpool_aio_ctx **ctx);
+    void (*destroy)(struct mpool_aio_ctx *ctx);
+    merr_t (*read)(struct mpool_aio_ctx *ctx, int src_fd, off_t off,
+                   const struct iovec *iov, int iovcnt, io_aio_cb_t *cb, void *arg);
+    merr_t (*write)(struct mpool_aio_ctx *ctx, int dst_fd, off_t off,
+                    const struct iovec *iov, int iovcnt, io_aio_cb_t *cb, void *arg);
+    merr_t (*bufreg)(struct mpool_aio_ctx *ctx, const struct iovec *iov, int iovcnt);
+    merr_t (*submit)(struct mpool_aio_ctx *ctx);
+    merr_t (*poll)(struct mpool_aio_ctx *ctx, unsigned int min_complete);
+};
+
 /* sync backend */
 extern const struct io_ops io_sync_ops;
 
@@ -32,4 +75,9 @@ extern const struct io_ops io_sync_ops;
 extern const struct io_ops io_pmem_ops;
 #endif /* HAVE_PMEM */
 
+/* io_uring async backend */
+#ifdef HAVE_IO_URING
+extern const struct io_aio_ops io_uring_aio_ops;
+#endif /* HAVE_IO_URING */
+
 #endif /* MPOOL_IO_H */
@@ -0,0 +1,353 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/*
+ * Copyright (C) 2021 Micron Technology, Inc.  All rights reserved.
+ */
+
+#include <hse_util/base.h>
+#include <hse_util/event_counter.h>
+#include <hse_util/minmax.h>
+#include <hse_util/assert.h>
+
+#include "io.h"
+
+#include <liburing.h>
+
+/**
+ * struct io_uring_req - per-request completion state
+ * @cb:   completion callback
+ * @arg:  completion callback argument
+ * @next: free list linkage
+ */
+struct io_uring_req {
+    io_aio_cb_t         *cb;
+    void                *arg;
+    struct io_uring_req *next;
+};
+
+/**
+ * struct io_uring_ctx - io_uring based async io context
+ * @base:     generic async context (must be first)
+ * @ring:     submission and completion rings
+ * @queued:   number of requests prepared but not yet submitted
+ * @inflight: number of requests submitted but not yet reaped
+ * @freelist: list of unused request slots
+ * @bufv:     registered buffers (indexed as registered with the ring)
+ * @bufc:     number of registered buffers
+ * @reqv:     request slots, one per unit of queue depth
+ */
+struct io_uring_ctx {
+    struct mpool_aio_ctx base;
+    struct io_uring      ring;
+    unsigned int         queued;
+    unsigned int         inflight;
+    struct io_uring_req *freelist;
+    struct iovec        *bufv;
+    int                  bufc;
+    struct io_uring_req  reqv[];
+};
+
+#define aio2uring(_ctx) container_of(_ctx, struct io_uring_ctx, base)
+
+static merr_t
+io_uring_aio_submit(struct mpool_aio_ctx *ctx)
+{
+    struct io_uring_ctx *uctx = aio2uring(ctx);
+    int rc;
+
+    while (uctx->queued > 0) {
+        rc = io_uring_submit(&uctx->ring);
+        if (rc < 0) {
+            if (rc == -EINTR || rc == -EAGAIN)
+                continue;
+            return merr(-rc);
+        }
+
+        assert(rc <= uctx->queued);
+        uctx->queued -= rc;
+        uctx->inflight += rc;
+    }
+
+    return 0;
+}
+
+static merr_t
+io_uring_aio_poll(struct mpool_aio_ctx *ctx, unsigned int min_complete)
+{
+    struct io_uring_ctx *uctx = aio2uring(ctx);
+    unsigned int reaped = 0;
+    merr_t err;
+
+    err = io_uring_aio_submit(ctx);
+    if (ev(err))
+        return err;
+
+    min_complete = min_t(unsigned int, min_complete, uctx->inflight);
+
+    while (uctx->inflight > 0) {
+        struct io_uring_cqe *cqe;
+        struct io_uring_req *req;
+        int res, rc;
+
+        if (reaped < min_complete)
+            rc = io_uring_wait_cqe(&uctx->ring, &cqe);
+        else
+            rc = io_uring_peek_cqe(&uctx->ring, &cqe);
+
+        if (rc) {
+            if (rc == -EINTR)
+                continue;
+            if (rc == -EAGAIN)
+                break;
+            return merr(-rc);
+        }
+
+        req = io_uring_cqe_get_data(cqe);
+        res = cqe->res;
+        io_uring_cqe_seen(&uctx->ring, cqe);
+
+        uctx->inflight--;
+        reaped++;
+
+        /* Release the slot before invoking the callback so that the
+         * callback may immediately queue a follow-on request.
+         */
+        req->next = uctx->freelist;
+        uctx->freelist = req;
+
+        if (res < 0)
+            req->cb(req->arg, merr(-res), 0);
+        else
+            req->cb(req->arg, 0, res);
+    }
+
+    return 0;
+}
+
+/* Obtain an sqe and a request slot for a new request, reaping completions
+ * as needed to free up a slot.  The caller must attach the request to the
+ * sqe (after preparing it) via io_uring_sqe_set_data().
+ *
+ * Nothing is taken from the context until both an sqe and a slot are in
+ * hand, so a failure leaves the context as it was (aside from requests
+ * that were submitted or reaped along the way).
+ */
+static merr_t
+io_uring_aio_prep(
+    struct io_uring_ctx  *uctx,
+    io_aio_cb_t          *cb,
+    void                 *arg,
+    struct io_uring_sqe **sqep,
+    struct io_uring_req **reqp)
+{
+    struct mpool_aio_ctx *ctx = &uctx->base;
+    struct io_uring_sqe *sqe;
+    struct io_uring_req *req;
+    merr_t err;
+
+    INVARIANT(cb);
+
+    while (true) {
+        if (uctx->freelist) {
+            sqe = io_uring_get_sqe(&uctx->ring);
+            if (sqe)
+                break;
+
+            /* The submission queue is full, hand it to the kernel. */
+            err = io_uring_aio_submit(ctx);
+            if (ev(err))
+                return err;
+
+            sqe = io_uring_get_sqe(&uctx->ring);
+            if (sqe)
+                break;
+        }
+
+        /* Out of request slots or sqes, submit whatever is queued and wait
+         * for a request to retire.  With nothing queued or in flight there
+         * is nothing to wait for.
+         */
+        if (ev(uctx->queued + uctx->inflight == 0))
+            return merr(EBUSY);
+
+        err = io_uring_aio_poll(ctx, 1);
+        if (ev(err))
+            return err;
+    }
+
+    req = uctx->freelist;
+    uctx->freelist = req->next;
+
+    req->cb = cb;
+    req->arg = arg;
+
+    uctx->queued++;
+
+    *sqep = sqe;
+    *reqp = req;
+
+    return 0;
+}
+
+static merr_t
+io_uring_aio_read(
+    struct mpool_aio_ctx *ctx,
+    int                   src_fd,
+    off_t                 off,
+    const struct iovec   *iov,
+    int                   iovcnt,
+    io_aio_cb_t          *cb,
+    void                 *arg)
+{
+    struct io_uring_sqe *sqe;
+    struct io_uring_req *req;
+    merr_t err;
+
+    err = io_uring_aio_prep(aio2uring(ctx), cb, arg, &sqe, &req);
+    if (err)
+        return err;
+
+    io_uring_prep_readv(sqe, src_fd, iov, iovcnt, off);
+    io_uring_sqe_set_data(sqe, req);
+
+    return 0;
+}
+
+static int
+io_uring_bufidx(struct io_uring_ctx *uctx, const void *buf, size_t len)
+{
+    for (int i = 0; i < uctx->bufc; i++) {
+        const char *base = uctx->bufv[i].iov_base;
+
+        if ((const char *)buf >= base && (const char *)buf + len <= base + uctx->bufv[i].iov_len)
+            return i;
+    }
+
+    return -1;
+}
+
+static merr_t
+io_uring_aio_write(
+    struct mpool_aio_ctx *ctx,
+    int                   dst_fd,
+    off_t                 off,
+    const struct iovec   *iov,
+    int                   iovcnt,
+    io_aio_cb_t          *cb,
+    void                 *arg)
+{
+    struct io_uring_ctx *uctx = aio2uring(ctx);
+    struct io_uring_sqe *sqe;
+    struct io_uring_req *req;
+    merr_t err;
+    int idx;
+
+    err = io_uring_aio_prep(uctx, cb, arg, &sqe, &req);
+    if (err)
+        return err;
+
+    /* Single-segment writes are issued from the buffer itself rather than
+     * via the iovec, so the caller's iovec need not outlive this call.
+     */
+    if (iovcnt == 1) {
+        idx = io_uring_bufidx(uctx, iov->iov_base, iov->iov_len);
+        if (idx >= 0)
+            io_uring_prep_write_fixed(sqe, dst_fd, iov->iov_base, iov->iov_len, off, idx);
+        else
+            io_uring_prep_write(sqe, dst_fd, iov->iov_base, iov->iov_len, off);
+    } else {
+        io_uring_prep_writev(sqe, dst_fd, iov, iovcnt, off);
+    }
+
+    io_uring_sqe_set_data(sqe, req);
+
+    return 0;
+}
+
+static merr_t
+io_uring_aio_bufreg(struct mpool_aio_ctx *ctx, const struct iovec *iov, int iovcnt)
+{
+    struct io_uring_ctx *uctx = aio2uring(ctx);
+    struct iovec *bufv;
+    int rc;
+
+    if (uctx->bufc > 0)
+        return merr(EEXIST);
+
+    bufv = malloc(iovcnt * sizeof(*bufv));
+    if (ev(!bufv))
+        return merr(ENOMEM);
+
+    memcpy(bufv, iov, iovcnt * sizeof(*bufv));
+
+    rc = io_uring_register_buffers(&uctx->ring, bufv, iovcnt);
+    if (rc) {
+        free(bufv);
+        return merr(-rc);
+    }
+
+    uctx->bufv = bufv;
+    uctx->bufc = iovcnt;
+
+    return 0;
+}
+
+static merr_t
+io_uring_aio_create(unsigned int qdepth, struct mpool_aio_ctx **ctx)
+{
+    struct io_uring_ctx *uctx;
+    unsigned int i;
+    int rc;
+
+    if (!ctx || qdepth == 0)
+        return merr(EINVAL);
+
+    uctx = calloc(1, sizeof(*uctx) + qdepth * sizeof(uctx->reqv[0]));
+    if (ev(!uctx))
+        return merr(ENOMEM);
+
+    rc = io_uring_queue_init(qdepth, &uctx->ring, 0);
+    if (rc) {
+        free(uctx);
+        return merr(-rc);
+    }
+
+    for (i = 0; i < qdepth; i++) {
+        uctx->reqv[i].next = uctx->freelist;
+        uctx->freelist = &uctx->reqv[i];
+    }
+
+    uctx->base.aio_ops = &io_uring_aio_ops;
+    *ctx = &uctx->base;
+
+    return 0;
+}
+
+static void
+io_uring_aio_destroy(struct mpool_aio_ctx *ctx)
+{
+    struct io_uring_ctx *uctx;
+
+    if (!ctx)
+        return;
+
+    uctx = aio2uring(ctx);
+
+    while (uctx->queued + uctx->inflight > 0) {
+        if (ev(io_uring_aio_poll(ctx, uctx->queued + uctx->inflight)))
+            break;
+    }
+
+    io_uring_queue_exit(&uctx->ring);
+    free(uctx->bufv);
+    free(uctx);
+}
+
+const struct io_aio_ops io_uring_aio_ops = {
+    .create = io_uring_aio_create,
+    .destroy = io_uring_aio_destroy,
+    .read = io_uring_aio_read,
+    .write = io_uring_aio_write,
+    .bufreg = io_uring_aio_bufreg,
+    .submit = io_uring_aio_submit,
+    .poll = io_uring_aio_poll,
+};
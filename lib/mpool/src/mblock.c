@@ -6,10 +6,13 @@
 #include <hse_util/event_counter.h>
 #include <hse_util/logging.h>
 
+#include <mpool/mpool.h>
+
 #include "mpool_internal.h"
 #include "mclass.h"
 #include "mblock_fset.h"
 #include "mblock_file.h"
+#include "io.h"
 
 struct mpool;
 
@@ -156,3 +159,75 @@ mpool_mblock_read(struct mpool *mp, uint64_t mbid, const struct iovec *iov, int
 
     return mblock_fset_read(mclass_fset(mc), mbid, iov, iovc, off);
 }
+
+merr_t
+mpool_aio_ctx_create(unsigned int qdepth, struct mpool_aio_ctx **ctx)
+{
+    if (!ctx)
+        return merr(EINVAL);
+
+#ifdef HAVE_IO_URING
+    return io_uring_aio_ops.create(qdepth, ctx);
+#else
+    return merr(ENOTSUP);
+#endif
+}
+
+void
+mpool_aio_ctx_destroy(struct mpool_aio_ctx *ctx)
+{
+    if (ctx)
+        ctx->aio_ops->destroy(ctx);
+}
+
+merr_t
+mpool_mblock_read_async(
+    struct mpool         *mp,
+    struct mpool_aio_ctx *ctx,
+    uint64_t              mbid,
+    const struct iovec   *iov,
+    int                   iovc,
+    off_t                 off,
+    mpool_aio_cb_t       *cb,
+    void                 *arg)
+{
+    struct media_class *mc;
+    enum hse_mclass   mclass;
+
+    if (!mp || !ctx || !iov || !cb)
+        return merr(EINVAL);
+
+    mclass = mcid_to_mclass(mclassid(mbid));
+    mc = mpool_mclass_handle(mp, mclass);
+    if (!mc)
+        return merr(ENOENT);
+
+    return mblock_fset_read_async(mclass_fset(mc), ctx, mbid, iov, iovc, off, cb, arg);
+}
+
+merr_t
+mpool_aio_buffers_register(struct mpool_aio_ctx *ctx, const struct iovec *iov, int iovc)
+{
+    if (!ctx || !iov || iovc <= 0)
+        return merr(EINVAL);
+
+    return ctx->aio_ops->bufreg(ctx, iov, iovc);
+}
+
+merr_t
+mpool_aio_submit(struct mpool_aio_ctx *ctx)
+{
+    if (!ctx)
+        return merr(EINVAL);
+
+    return ctx->aio_ops->submit(ctx);
+}
+
+merr_t
+mpool_aio_poll(struct mpool_aio_ctx *ctx, unsigned int min_complete)
+{
+    if (!ctx)
+        return merr(EINVAL);
+
+    return ctx->aio_ops->poll(ctx, min_complete);
+}
@@ -988,13 +988,14 @@ iov_len_get(const struct iovec *iov, int iovc, size_t *tlen)
     return 0;
 }
 
-merr_t
-mblock_file_read(
+static merr_t
+mblock_file_read_prep(
     struct mblock_file *mbfp,
     uint64_t            mbid,
     const struct iovec *iov,
     int                 iovc,
-    off_t               off)
+    off_t               off,
+    off_t              *roffp)
 {
     uint32_t  block;
     off_t     roff, eoff;
@@ -1002,12 +1003,6 @@ mblock_file_read(
     merr_t    err;
     atomic_int *wlenp;
 
-    if (!mbfp || !iov)
-        return merr(EINVAL);
-
-    if (iovc == 0)
-        return 0;
-
     if (!PAGE_ALIGNED(off))
         return merr(EINVAL);
 
@@ -1034,9 +1029,59 @@ mblock_file_read(
         return merr(EINVAL);
     }
 
+    *roffp = roff;
+
+    return 0;
+}
+
+merr_t
+mblock_file_read(
+    struct mblock_file *mbfp,
+    uint64_t            mbid,
+    const struct iovec *iov,
+    int                 iovc,
+    off_t               off)
+{
+    off_t  roff;
+    merr_t err;
+
+    if (!mbfp || !iov)
+        return merr(EINVAL);
+
+    if (iovc == 0)
+        return 0;
+
+    err = mblock_file_read_prep(mbfp, mbid, iov, iovc, off, &roff);
+    if (err)
+        return err;
+
     return mbfp->dataio.read(mbfp->fd, roff, iov, iovc, 0, NULL);
 }
 
+merr_t
+mblock_file_read_async(
+    struct mblock_file   *mbfp,
+    struct mpool_aio_ctx *ctx,
+    uint64_t              mbid,
+    const struct iovec   *iov,
+    int                   iovc,
+    off_t                 off,
+    io_aio_cb_t          *cb,
+    void                 *arg)
+{
+    off_t  roff;
+    merr_t err;
+
+    if (!mbfp || !ctx || !iov || iovc == 0 || !cb)
+        return merr(EINVAL);
+
+    err = mblock_file_read_prep(mbfp, mbid, iov, iovc, off, &roff);
+    if (err)
+        return err;
+
+    return ctx->aio_ops->read(ctx, mbfp->fd, roff, iov, iovc, cb, arg);
+}
+
 merr_t
 mblock_file_write(struct mblock_file *mbfp, uint64_t mbid, const struct iovec *iov, int iovc)
 {
@@ -10,6 +10,7 @@
 #include <hse_util/hse_err.h>
 
 #include "mclass.h"
+#include "io.h"
 
 /* clang-format off */
 
@@ -229,6 +230,29 @@ mblock_file_read(
     int                 iovc,
     off_t               off);
 
+/**
+ * mblock_file_read_async() - queue an asynchronous read of an mblock object
+ *
+ * @mbfp:   mblock file handle
+ * @ctx:    async io context
+ * @mbid:   mblock id
+ * @iov:    iovec ptr (must remain valid until @cb is invoked)
+ * @iovc:   iov count
+ * @off:    offset
+ * @cb:     completion callback
+ * @arg:    completion callback argument
+ */
+merr_t
+mblock_file_read_async(
+    struct mblock_file   *mbfp,
+    struct mpool_aio_ctx *ctx,
+    uint64_t              mbid,
+    const struct iovec   *iov,
+    int                   iovc,
+    off_t                 off,
+    io_aio_cb_t          *cb,
+    void                 *arg);
+
 /**
  * mblock_file_write() - write an mblock object
  *
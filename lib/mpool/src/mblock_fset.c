@@ -752,6 +752,27 @@ mblock_fset_read(
     return mblock_file_read(mbfp, mbid, iov, iovc, off);
 }
 
+merr_t
+mblock_fset_read_async(
+    struct mblock_fset   *mbfsp,
+    struct mpool_aio_ctx *ctx,
+    uint64_t              mbid,
+    const struct iovec   *iov,
+    int                   iovc,
+    off_t                 off,
+    io_aio_cb_t          *cb,
+    void                 *arg)
+{
+    struct mblock_file *mbfp;
+
+    if (!mbfsp || file_id(mbid) > mbfsp->mhdr.fcnt)
+        return merr(EINVAL);
+
+    mbfp = mbfsp->filev[file_index(mbid)];
+
+    return mblock_file_read_async(mbfp, ctx, mbid, iov, iovc, off, cb, arg);
+}
+
 merr_t
 mblock_fset_map_getbase(struct mblock_fset *mbfsp, uint64_t mbid, char **addr_out, uint32_t *wlen)
 {
@@ -138,6 +138,29 @@ mblock_fset_read(
     int                 iovc,
     off_t               off);
 
+/**
+ * mblock_fset_read_async() - queue an asynchronous read of an mblock
+ *
+ * @mbfsp: mblock fileset handle
+ * @ctx:   async io context
+ * @mbid:  mblock id
+ * @iov:   iovec ptr
+ * @iovc:  iovec cnt
+ * @off:   offset to read from
+ * @cb:    completion callback
+ * @arg:   completion callback argument
+ */
+merr_t
+mblock_fset_read_async(
+    struct mblock_fset   *mbfsp,
+    struct mpool_aio_ctx *ctx,
+    uint64_t              mbid,
+    const struct iovec   *iov,
+    int                   iovc,
+    off_t                 off,
+    io_aio_cb_t          *cb,
+    void                 *arg);
+
 /**
  * mblock_fset_find() - find an mblock and return write length
  *
@@ -23,17 +23,20 @@
 #include "mpool_internal.h"
 #include "mblock_fset.h"
 #include "mblock_file.h"
+#include "bcache.h"
 
 /**
  * struct mpool - mpool handle
  *
- * @mc:   media class handles
- * @home: kvdb home
+ * @mc:     media class handles
+ * @bcache: userspace page cache (NULL if disabled)
+ * @home:   kvdb home
  *
  * [HSE_REVISIT]: Remove home member when logging is reworked
  */
 struct mpool {
     struct media_class *mc[HSE_MCLASS_COUNT];
+    struct bcache      *bcache;
     const char          home[]; /* flexible array */
 };
 
@@ -318,6 +321,12 @@ mpool_open(
             goto errout;
     }
 
+    if (rparams->bcache_size > 0) {
+        err = bcache_create(mp, rparams->bcache_size, &mp->bcache);
+        if (err)
+            goto errout;
+    }
+
     *handle = mp;
 
     return 0;
@@ -340,6 +349,8 @@ mpool_close(struct mpool *mp)
     if (!mp)
         return 0;
 
+    bcache_destroy(mp->bcache);
+
     for (i = HSE_MCLASS_COUNT - 1; i >= HSE_MCLASS_BASE; i--) {
         if (mp->mc[i]) {
             err = mclass_close(mp->mc[i]);
@@ -479,6 +490,12 @@ mpool_mclass_handle(struct mpool *mp, enum hse_mclass mclass)
     return mp->mc[mclass];
 }
 
+struct bcache *
+mpool_bcache_handle(struct mpool *mp)
+{
+    return mp ? mp->bcache : NULL;
+}
+
 merr_t
 mpool_mclass_dirfd(struct mpool *mp, enum hse_mclass mclass, int *dirfd)
 {
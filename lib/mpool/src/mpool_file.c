@@ -8,6 +8,8 @@
 #include <hse_util/logging.h>
 #include <hse_util/mman.h>
 
+#include <mpool/mpool.h>
+
 #include "mpool_internal.h"
 #include "mclass.h"
 #include "io.h"
@@ -200,6 +202,30 @@ mpool_file_write(
     return 0;
 }
 
+merr_t
+mpool_file_write_async(
+    struct mpool_file    *file,
+    struct mpool_aio_ctx *ctx,
+    off_t                 offset,
+    const char           *buf,
+    size_t                buflen,
+    mpool_aio_cb_t       *cb,
+    void                 *arg)
+{
+    struct iovec iov;
+
+    if (!file || !ctx || !buf || !cb)
+        return merr(EINVAL);
+
+    iov.iov_base = (char *)buf;
+    iov.iov_len = buflen;
+
+    /* The backend does not retain single-segment iovecs, so it is safe
+     * to pass one from the stack.
+     */
+    return ctx->aio_ops->write(ctx, file->fd, offset, &iov, 1, cb, arg);
+}
+
 merr_t
 mpool_file_sync(struct mpool_file *file)
 {
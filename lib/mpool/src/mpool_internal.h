@@ -10,6 +10,7 @@
 
 #include <mpool/mpool_structs.h>
 
+struct bcache;
 struct media_class;
 struct mpool;
 
@@ -31,4 +32,14 @@ mpool_mclass_handle(struct mpool *mp, enum hse_mclass mclass);
 merr_t
 mpool_mclass_dirfd(struct mpool *mp, enum hse_mclass mclass, int *dirfd);
 
+/**
+ * mpool_bcache_handle - return the mpool page cache handle
+ *
+ * @mp: mpool handle
+ *
+ * Returns NULL if the mpool was opened without a page cache.
+ */
+struct bcache *
+mpool_bcache_handle(struct mpool *mp);
+
 #endif /* MPOOL_INTERNAL_H */
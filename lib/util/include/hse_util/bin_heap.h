@@ -51,7 +51,7 @@ bin_heap_delete_top(struct bin_heap *bh);
 /* ------------------------------------------------------------------------ */
 
 #define BIN_HEAP2_SZ(_bh2_width) \
-    (sizeof(struct bin_heap2) + sizeof(struct heap_node) * (_bh2_width))
+    (sizeof(struct bin_heap2) + (sizeof(struct heap_node) + sizeof(int)) * (_bh2_width))
 
 #define BIN_HEAP2_DEFINE(_bh2_name, _bh2_width)                 \
     union {                                                     \
@@ -70,15 +70,38 @@ struct bin_heap2;
 typedef int
 bin_heap2_compare_fn(const void *a, const void *b);
 
+/*
+ * An optional discriminator maps an element to an integer that must be
+ * consistent with the compare function, i.e., disc(A) < disc(B) implies
+ * that A must come out of the heap before B.  Elements with differing
+ * discriminators are ordered without calling the compare function.
+ */
+typedef u64
+bin_heap2_disc_fn(const void *item);
+
 struct heap_node {
     void *                 hn_data;
     struct element_source *hn_es;
+    u64                    hn_disc;
 };
 
+/*
+ * struct bin_heap2 - tournament (loser) tree of element sources
+ * @bh2_width:     number of sources that have not reached eof
+ * @bh2_max_width: max number of sources
+ * @bh2_leafc:     number of leaves in the tree (including exhausted sources)
+ * @bh2_winner:    index of the leaf that holds the next element
+ * @bh2_cmp:       element comparator
+ * @bh2_disc:      element discriminator (optional)
+ * @bh2_elts:      leaves, followed by the tree's internal nodes
+ */
 struct bin_heap2 {
     int                   bh2_width;
     int                   bh2_max_width;
+    int                   bh2_leafc;
+    int                   bh2_winner;
     bin_heap2_compare_fn *bh2_cmp;
+    bin_heap2_disc_fn *   bh2_disc;
     struct heap_node      bh2_elts[];
 };
 
@@ -88,6 +111,14 @@ bin_heap2_width(struct bin_heap2 *bh);
 void
 bin_heap2_init(u32 max_width, bin_heap2_compare_fn *cmp, struct bin_heap2 *bh);
 
+/**
+ * bin_heap2_set_disc() - set the discriminator of an empty bin heap
+ * @bh:   handle to the bin heap structure
+ * @disc: discriminator, or NULL for none
+ */
+void
+bin_heap2_set_disc(struct bin_heap2 *bh, bin_heap2_disc_fn *disc);
+
 merr_t
 bin_heap2_create(u32 max_width, bin_heap2_compare_fn *cmp, struct bin_heap2 **bh_out);
 
@@ -116,7 +147,7 @@ bin_heap2_peek(struct bin_heap2 *bh, void **item)
         return false;
     }
 
-    node = bh->bh2_elts[0];
+    node = bh->bh2_elts[bh->bh2_winner];
     *item = node.hn_data;
     return true;
 }
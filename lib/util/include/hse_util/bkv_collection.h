@@ -28,6 +28,13 @@ bkv_collection_count(struct bkv_collection *bkvc);
 merr_t
 bkv_collection_add(struct bkv_collection *bkvc, struct bonsai_kv *bkv, struct bonsai_val *val_list);
 
+void
+bkv_collection_get(
+    struct bkv_collection *bkvc,
+    size_t                 idx,
+    struct bonsai_kv     **bkv,
+    struct bonsai_val    **vlist);
+
 merr_t
 bkv_collection_apply(struct bkv_collection *bkvc);
 
@@ -106,6 +106,61 @@ bf_hash2bit(u64 *hashp, u32 rotl, u32 mask)
     return hash & mask;
 }
 
+/**
+ * bf_lookup512() - check to see if hash is in a 512-bit bloom bucket
+ * @hash:       hash used to select the bucket
+ * @bitmap:     base byte address of the bucket
+ * @n:          number of hashes to check
+ * @rotl:       number of bits to rotate left
+ *
+ * Rather than test each hash bit in turn (which incurs a hard to predict
+ * branch per bit), gather all n bits into a bucket-sized mask and then
+ * check the mask against the bucket in one (avx512) or two (avx2) vector
+ * operations.  Buckets of 2^9 bits are the default (see BF_BKTSHIFT), and
+ * are exactly one cacheline in size.  Without vector support the bits are
+ * tested in turn, stopping at the first that isn't set.
+ *
+ * Return:
+ *     Returns %true if all n hashes have bits set in the bucket,
+ *     otherwise returns %false.
+ */
+static HSE_ALWAYS_INLINE bool
+bf_lookup512(u64 hash, const u8 *bitmap, s32 n, u32 rotl)
+{
+#if __amd64__ && (__AVX512F__ || __AVX2__)
+    u8 maskv[64] HSE_ALIGNED(64) = { 0 };
+
+    while (n-- > 0) {
+        u32 bit = bf_hash2bit(&hash, rotl, 511);
+
+        maskv[bit >> BYTE_SHIFT] |= (u8)(1u << (bit & 7));
+    }
+#endif
+
+#if __amd64__ && __AVX512F__
+    {
+        __m512i m = _mm512_load_si512((const void *)maskv);
+        __m512i b = _mm512_loadu_si512((const void *)bitmap);
+
+        return _mm512_cmpneq_epi64_mask(_mm512_and_si512(b, m), m) == 0;
+    }
+#elif __amd64__ && __AVX2__
+    {
+        __m256i m0 = _mm256_load_si256((const __m256i *)maskv);
+        __m256i m1 = _mm256_load_si256((const __m256i *)(maskv + 32));
+        __m256i b0 = _mm256_loadu_si256((const __m256i *)bitmap);
+        __m256i b1 = _mm256_loadu_si256((const __m256i *)(bitmap + 32));
+
+        return _mm256_testc_si256(b0, m0) & _mm256_testc_si256(b1, m1);
+    }
+#else
+    while (n-- > 0 && hse_bitmap_test32(bitmap, bf_hash2bit(&hash, rotl, 511)))
+        ;
+
+    return (n < 0);
+#endif
+}
+
 /**
  * bf_lookup() - check to see if hash is in bloom bucket
  * @hash:       hash used to select the bucket
@@ -121,6 +176,9 @@ bf_hash2bit(u64 *hashp, u32 rotl, u32 mask)
 static HSE_ALWAYS_INLINE bool
 bf_lookup(u64 hash, const u8 *bitmap, s32 n, u32 rotl, u32 mask)
 {
+    if (mask == 511)
+        return bf_lookup512(hash, bitmap, n, rotl);
+
     while (n-- > 0 && hse_bitmap_test32(bitmap, bf_hash2bit(&hash, rotl, mask)))
         ;
 
@@ -89,6 +89,7 @@ struct bonsai_skey {
  * @bv_xlen:      opaque encoded value length
  * @bv_priv:      user-managed ptr
  * @bv_free:      ptr to next value in free list bkv_freevals
+ * @bv_expire:    expiration time in seconds since the epoch, zero if none
  * @bv_valbuf:    value data (zero length if caller managed)
  *
  * A bonsai_val includes the value data and may be on both the bnkv_values
@@ -105,6 +106,7 @@ struct bonsai_val {
     u64                bv_xlen;
     struct bonsai_val *bv_priv;
     struct bonsai_val *bv_free;
+    u64                bv_expire;
     char               bv_valbuf[];
 };
 
@@ -155,6 +157,7 @@ bonsai_val_vlen(const struct bonsai_val *bv)
  * @bsv_val:      pointer to value data
  * @bsv_xlen:     opaque encoded value length
  * @bsv_seqnoref: sequence number reference
+ * @bsv_expire:   expiration time in seconds since the epoch, zero if none
  *
  * Note that the value length (@bsv_xlen) is an opaque encoding of compressed
  * and uncompressed value lengths so one must use the bonsai_sval_vlen()
@@ -164,6 +167,7 @@ struct bonsai_sval {
     void     *bsv_val;
     u64       bsv_xlen;
     uintptr_t bsv_seqnoref;
+    u64       bsv_expire;
 };
 
 /**
@@ -594,6 +598,7 @@ bn_sval_init(void *val, u64 xlen, uintptr_t seqnoref, struct bonsai_sval *sval)
     sval->bsv_val = val;
     sval->bsv_xlen = xlen;
     sval->bsv_seqnoref = seqnoref;
+    sval->bsv_expire = 0;
 }
 
 static inline s32
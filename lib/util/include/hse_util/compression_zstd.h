@@ -0,0 +1,123 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/*
+ * Copyright (C) 2021 Micron Technology, Inc.  All rights reserved.
+ */
+#ifndef HSE_UTIL_COMPRESS_ZSTD_H
+#define HSE_UTIL_COMPRESS_ZSTD_H
+
+#include <hse_util/compression.h>
+
+#define COMPRESS_ZSTD_LEVEL_MIN     (1)
+#define COMPRESS_ZSTD_LEVEL_DEFAULT (3)
+#define COMPRESS_ZSTD_LEVEL_MAX     (19)
+
+struct compress_zstd_cdict;
+struct compress_zstd_ddict;
+
+/* Dictionary-less zstd at COMPRESS_ZSTD_LEVEL_DEFAULT.
+ */
+extern struct compress_ops compress_zstd_ops;
+
+/**
+ * compress_zstd_cdict_create() - prepare a dictionary for compression
+ * @dict:    dictionary content (may be NULL)
+ * @dictlen: length of @dict in bytes (zero if @dict is NULL)
+ * @level:   compression level
+ * @cdictp:  (output) compression dictionary handle
+ *
+ * The dictionary content is copied, the caller need not retain it.
+ * A handle created without a dictionary simply carries @level.
+ */
+merr_t
+compress_zstd_cdict_create(
+    const void                  *dict,
+    size_t                       dictlen,
+    int                          level,
+    struct compress_zstd_cdict **cdictp);
+
+void
+compress_zstd_cdict_destroy(struct compress_zstd_cdict *cdict);
+
+/**
+ * compress_zstd_compress() - compress a buffer with a prepared dictionary
+ *
+ * Returns EFBIG if the compressed result does not fit in @dst_capacity.
+ */
+merr_t
+compress_zstd_compress(
+    const struct compress_zstd_cdict *cdict,
+    const void                       *src,
+    uint                              src_len,
+    void                             *dst,
+    uint                              dst_capacity,
+    uint                             *dst_len);
+
+/**
+ * compress_zstd_ddict_get() - get the decompression dictionary for @dict
+ * @dict:    dictionary content
+ * @dictlen: length of @dict in bytes
+ * @ddictp:  (output) decompression dictionary handle
+ *
+ * Decompression dictionaries are shared by all users of the same dictionary
+ * (as identified by its zstd dictionary ID, length and a hash of its content)
+ * and are reference counted.  Hence @dict need only remain valid for the
+ * duration of the call.  Each successful get must be paired with a call to
+ * compress_zstd_ddict_put().
+ */
+merr_t
+compress_zstd_ddict_get(
+    const void                        *dict,
+    size_t                             dictlen,
+    const struct compress_zstd_ddict **ddictp);
+
+/**
+ * compress_zstd_ddict_put() - release a reference acquired by compress_zstd_ddict_get()
+ * @ddict: decompression dictionary handle (may be NULL)
+ */
+void
+compress_zstd_ddict_put(const struct compress_zstd_ddict *ddict);
+
+/**
+ * compress_zstd_decompress() - decompress a buffer
+ * @ddict: decompression dictionary (NULL if compressed without one)
+ *
+ * If @dst_capacity is less than the decompressed length then only the
+ * first @dst_capacity bytes are decompressed.
+ */
+merr_t
+compress_zstd_decompress(
+    const struct compress_zstd_ddict *ddict,
+    const void                       *src,
+    uint                              src_len,
+    void                             *dst,
+    uint                              dst_capacity,
+    uint                             *dst_len);
+
+/**
+ * compress_zstd_dict_id() - get the dictionary ID of @dict (zero if none)
+ */
+uint
+compress_zstd_dict_id(const void *dict, size_t dictlen);
+
+/**
+ * compress_zstd_dict_train() - train a dictionary from a set of samples
+ * @samples:  concatenated samples
+ * @samplev:  length of each sample in @samples
+ * @samplec:  number of samples
+ * @dict:     (output) buffer in which to build the dictionary
+ * @dictcap:  size of @dict in bytes
+ * @dictlen:  (output) length of the dictionary
+ */
+merr_t
+compress_zstd_dict_train(
+    const void   *samples,
+    const size_t *samplev,
+    uint          samplec,
+    void         *dict,
+    size_t        dictcap,
+    size_t       *dictlen);
+
+void
+compress_zstd_fini(void);
+
+#endif
@@ -357,6 +357,17 @@ key_obj_cmp_prefix(const struct key_obj *ko_pfx, const struct key_obj *ko_key)
     return 1;
 }
 
+/**
+ * key_obj_disc64() - 64-bit key discriminator of a key object
+ * @kobj: key object
+ *
+ * Return: the first eight bytes of the key (zero padded) as a big endian
+ * integer.  If key_obj_disc64(ko1) < key_obj_disc64(ko2) then ko1 sorts
+ * lexicographically less than ko2.  Equal discriminators are inconclusive.
+ */
+u64
+key_obj_disc64(const struct key_obj *kobj);
+
 static HSE_ALWAYS_INLINE struct key_obj *
 key2kobj(struct key_obj *kobj, const void *kdata, size_t klen)
 {
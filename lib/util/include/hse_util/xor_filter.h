@@ -0,0 +1,155 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/*
+ * Copyright (C) 2021 Micron Technology, Inc.  All rights reserved.
+ */
+
+#ifndef HSE_PLATFORM_XOR_FILTER_H
+#define HSE_PLATFORM_XOR_FILTER_H
+
+#include <hse_util/compiler.h>
+#include <hse_util/inttypes.h>
+#include <hse_util/hse_err.h>
+
+/* An xor filter (Graf & Lemire, "Xor Filters: Faster and Smaller Than
+ * Bloom and Cuckoo Filters") stores one b-bit fingerprint per slot in
+ * an array of roughly 1.23n slots, split into three equal segments.
+ * A key is present if the xor of the three slots it hashes to (one
+ * in each segment) equals its fingerprint, which yields a false
+ * positive rate of 2^-b at ~1.23b bits per key.  By comparison, a
+ * block bloom with a similar false positive rate requires roughly
+ * 1.44 * log2(1/fpr) bits per key, plus some for bucket imbalance.
+ *
+ * Unlike a bloom filter, an xor filter is immutable and must be built
+ * from the complete set of key hashes in one go (see xf_filter_build()).
+ *
+ * XF_FPBITS_MIN and XF_FPBITS_MAX bound the supported fingerprint
+ * widths, which must be a multiple of eight bits.
+ */
+#define XF_FPBITS_MIN (8)
+#define XF_FPBITS_MAX (16)
+
+struct xor_filter {
+    u8 *xf_fpv;
+    u32 xf_fpvsz;
+    u32 xf_seglen;
+    u32 xf_seed;
+    u32 xf_fpbits;
+};
+
+static HSE_ALWAYS_INLINE u64
+xf_mix(u64 hash, u32 seed)
+{
+    u64 h = hash + seed;
+
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ull;
+    h ^= h >> 33;
+
+    return h;
+}
+
+static HSE_ALWAYS_INLINE u32
+xf_reduce(u32 hash, u32 n)
+{
+    return ((u64)hash * n) >> 32;
+}
+
+/**
+ * xf_hash2slots() - determine the three slots probed for a key
+ * @hash:    key hash (as for bloom filters)
+ * @seed:    filter seed
+ * @seglen:  number of slots per segment
+ * @slotv:   (output) slot indices, one in each segment
+ *
+ * Return: the key's fingerprint (not yet truncated to the filter's width)
+ */
+static HSE_ALWAYS_INLINE u32
+xf_hash2slots(u64 hash, u32 seed, u32 seglen, u32 *slotv)
+{
+    u64 h = xf_mix(hash, seed);
+
+    slotv[0] = xf_reduce((u32)h, seglen);
+    slotv[1] = xf_reduce((u32)((h << 21) | (h >> 43)), seglen) + seglen;
+    slotv[2] = xf_reduce((u32)((h << 42) | (h >> 22)), seglen) + seglen * 2;
+
+    return (u32)(h ^ (h >> 32));
+}
+
+static HSE_ALWAYS_INLINE u32
+xf_fpget(const u8 *fpv, u32 slot, u32 fpbits)
+{
+    if (fpbits == 8)
+        return fpv[slot];
+
+    return fpv[slot * 2] | ((u32)fpv[slot * 2 + 1] << 8);
+}
+
+/**
+ * xf_lookup() - check to see if hash is in an xor filter
+ * @hash:    key hash
+ * @fpv:     base address of the fingerprint array
+ * @seed:    filter seed
+ * @seglen:  number of slots per segment
+ * @fpbits:  fingerprint width in bits
+ *
+ * Return:
+ *     Returns %true if the key might be in the set, otherwise
+ *     returns %false.
+ */
+static HSE_ALWAYS_INLINE bool
+xf_lookup(u64 hash, const u8 *fpv, u32 seed, u32 seglen, u32 fpbits)
+{
+    u32 slotv[3], fp;
+
+    fp = xf_hash2slots(hash, seed, seglen, slotv);
+    fp ^= xf_fpget(fpv, slotv[0], fpbits);
+    fp ^= xf_fpget(fpv, slotv[1], fpbits);
+    fp ^= xf_fpget(fpv, slotv[2], fpbits);
+
+    return (fp & ((1u << fpbits) - 1)) == 0;
+}
+
+/**
+ * xf_fpbits() - select a fingerprint width for a false positive rate
+ * @probability: desired false positive rate times one million
+ */
+u32
+xf_fpbits(u32 probability);
+
+/**
+ * xf_size_estimate() - bytes needed to build a filter over @num_elmnts keys
+ */
+u32
+xf_size_estimate(u32 fpbits, u32 num_elmnts);
+
+/**
+ * xf_element_estimate() - max keys for which a filter fits in @size bytes
+ */
+u32
+xf_element_estimate(u32 fpbits, size_t size);
+
+/**
+ * xf_filter_build() - build an xor filter from a set of key hashes
+ * @xf:         (output) filter descriptor
+ * @fpbits:     fingerprint width in bits
+ * @hashv:      key hashes (will be sorted and deduplicated in place)
+ * @hashc:      number of hashes in @hashv
+ * @storage:    buffer in which to build the fingerprint array
+ * @storage_sz: size of @storage in bytes
+ *
+ * Return: 0 on success, ENOSPC if @storage is too small, or ENOMEM.
+ * In the exceedingly unlikely event that no seed can be found that
+ * allows the filter to be constructed then EAGAIN is returned.
+ */
+merr_t
+xf_filter_build(
+    struct xor_filter *xf,
+    u32                fpbits,
+    u64 *              hashv,
+    u32                hashc,
+    u8 *               storage,
+    size_t             storage_sz);
+
+#endif
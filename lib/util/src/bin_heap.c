@@ -241,48 +241,119 @@ bin_heap_insert(struct bin_heap *bh, const void *new_item)
     return 0;
 }
 
-#define BH2_PARENT(_index)  (((_index) - 1) / 2)
-#define BH2_LEFT(_index)    (2 * (_index) + 1)
-#define BH2_RIGHT(_index)   (2 * (_index) + 2)
+/* bin_heap2 is implemented as a loser tree (tournament tree).  Each element
+ * source occupies a leaf, and internal node n (1 <= n < leafc) records the
+ * leaf that lost the match between the winners of its subtrees 2n and 2n+1
+ * (where nodes leafc through 2*leafc-1 are the leaves).  Replacing the
+ * overall winner requires replaying only the matches on the path from its
+ * leaf to the root, i.e., about log2(leafc) comparisons per pop rather than
+ * the ~2*log2(width) required to sift down a binary heap.
+ *
+ * Exhausted sources remain in the tree as empty leaves which lose every
+ * match until the tree is rebuilt.
+ */
+static HSE_ALWAYS_INLINE int *
+bin_heap2_tree(struct bin_heap2 *bh)
+{
+    return (int *)(bh->bh2_elts + bh->bh2_max_width);
+}
 
-static HSE_ALWAYS_INLINE int
-bin_heap2_cmp(bin_heap2_compare_fn *cmp, struct heap_node *elts, int a, int b)
+/* Return true if leaf a must be popped before leaf b.
+ */
+static HSE_ALWAYS_INLINE bool
+bin_heap2_beats(struct bin_heap2 *bh, int a, int b)
 {
-    int rc = cmp(elts[a].hn_data, elts[b].hn_data);
+    const struct heap_node *na = bh->bh2_elts + a;
+    const struct heap_node *nb = bh->bh2_elts + b;
+    int                     rc;
+
+    if (HSE_UNLIKELY(!nb->hn_es))
+        return true;
+    if (HSE_UNLIKELY(!na->hn_es))
+        return false;
 
-    return rc ?: elts[a].hn_es->es_sort - elts[b].hn_es->es_sort;
+    if (na->hn_disc != nb->hn_disc)
+        return na->hn_disc < nb->hn_disc;
+
+    rc = bh->bh2_cmp(na->hn_data, nb->hn_data);
+
+    return rc ? rc < 0 : na->hn_es->es_sort < nb->hn_es->es_sort;
+}
+
+static HSE_ALWAYS_INLINE void
+bin_heap2_leaf_set(struct bin_heap2 *bh, int leaf, struct element_source *es, void *elt)
+{
+    struct heap_node *node = bh->bh2_elts + leaf;
+
+    node->hn_data = elt;
+    node->hn_es = es;
+    node->hn_disc = bh->bh2_disc ? bh->bh2_disc(elt) : 0;
+}
+
+/* Play all the matches of the subtree rooted at node, return its winner.
+ */
+static int
+bin_heap2_play(struct bin_heap2 *bh, int node)
+{
+    int *tree = bin_heap2_tree(bh);
+    int  l, r;
+
+    if (node >= bh->bh2_leafc)
+        return node - bh->bh2_leafc;
+
+    l = bin_heap2_play(bh, 2 * node);
+    r = bin_heap2_play(bh, 2 * node + 1);
+
+    if (bin_heap2_beats(bh, r, l)) {
+        tree[node] = l;
+        return r;
+    }
+
+    tree[node] = r;
+    return l;
 }
 
 static void
-bin_heap2_heapify(struct bin_heap2 *heap, int index)
+bin_heap2_build(struct bin_heap2 *bh)
 {
-    int                   l, r;
-    int                   xest; /* biggest or smallest index, per cmp */
-    int                   heap_sz = heap->bh2_width;
-    bin_heap2_compare_fn *cmp = heap->bh2_cmp;
-    struct heap_node *    elts = heap->bh2_elts;
+    bh->bh2_winner = bh->bh2_leafc > 0 ? bin_heap2_play(bh, 1) : 0;
+}
 
-restart:
-    l = BH2_LEFT(index);
-    r = BH2_RIGHT(index);
-    xest = index;
+/* Replay the matches on the path from the previous winner's leaf to the root.
+ */
+static HSE_ALWAYS_INLINE void
+bin_heap2_replay(struct bin_heap2 *bh, int leaf)
+{
+    int *tree = bin_heap2_tree(bh);
+    int  winner = leaf;
+    int  node;
 
-    if (l < heap_sz && bin_heap2_cmp(cmp, elts, l, index) < 0)
-        xest = l;
+    for (node = (leaf + bh->bh2_leafc) / 2; node > 0; node /= 2) {
+        if (bin_heap2_beats(bh, tree[node], winner)) {
+            int tmp = tree[node];
 
-    if (r < heap_sz && bin_heap2_cmp(cmp, elts, r, xest) < 0)
-        xest = r;
+            tree[node] = winner;
+            winner = tmp;
+        }
+    }
 
-    if (xest != index) {
-        struct heap_node tmp;
+    bh->bh2_winner = winner;
+}
 
-        tmp = elts[xest];
-        elts[xest] = elts[index];
-        elts[index] = tmp;
+/* Drop exhausted leaves so that only live sources occupy the tree.
+ */
+static void
+bin_heap2_compact(struct bin_heap2 *bh)
+{
+    int i, j;
 
-        index = xest;
-        goto restart;
+    for (i = 0, j = 0; i < bh->bh2_leafc; ++i) {
+        if (bh->bh2_elts[i].hn_es)
+            bh->bh2_elts[j++] = bh->bh2_elts[i];
     }
+
+    assert(j == bh->bh2_width);
+    bh->bh2_leafc = j;
 }
 
 u32
@@ -297,8 +368,19 @@ bin_heap2_init(u32 max_width, bin_heap2_compare_fn *cmp, struct bin_heap2 *bh)
     assert(max_width > 0 && cmp && bh);
 
     bh->bh2_cmp = cmp;
+    bh->bh2_disc = NULL;
     bh->bh2_max_width = max_width;
     bh->bh2_width = 0;
+    bh->bh2_leafc = 0;
+    bh->bh2_winner = 0;
+}
+
+void
+bin_heap2_set_disc(struct bin_heap2 *bh, bin_heap2_disc_fn *disc)
+{
+    assert(bh->bh2_width == 0);
+
+    bh->bh2_disc = disc;
 }
 
 merr_t
@@ -333,6 +415,7 @@ merr_t
 bin_heap2_reset(struct bin_heap2 *bh)
 {
     bh->bh2_width = 0;
+    bh->bh2_leafc = 0;
     return 0;
 }
 
@@ -348,18 +431,14 @@ bin_heap2_prepare(struct bin_heap2 *bh, u32 width, struct element_source *es[])
         void *elt;
 
         if (es[i] && es[i]->es_get_next(es[i], &elt)) {
-            bh->bh2_elts[j].hn_data = elt;
-            bh->bh2_elts[j].hn_es = es[i];
-            bh->bh2_elts[j].hn_es->es_sort = j;
+            bin_heap2_leaf_set(bh, j, es[i], elt);
+            es[i]->es_sort = j;
             ++j;
         }
     }
 
-    bh->bh2_width = j;
-    if (j > 1) {
-        for (i = bh->bh2_width / 2 - 1; i >= 0; --i)
-            bin_heap2_heapify(bh, i);
-    }
+    bh->bh2_width = bh->bh2_leafc = j;
+    bin_heap2_build(bh);
 
     return 0;
 }
@@ -367,28 +446,23 @@ bin_heap2_prepare(struct bin_heap2 *bh, u32 width, struct element_source *es[])
 merr_t
 bin_heap2_prepare_list(struct bin_heap2 *bh, u32 width, struct element_source *es)
 {
-    int i, j;
+    int j;
 
-    for (i = 0, j = 0; es; ++i) {
+    for (j = 0; es; es = es->es_next_src) {
         void *elt;
 
-        if (j > bh->bh2_max_width)
-            return merr(ev(EOVERFLOW));
-
         if (es->es_get_next(es, &elt)) {
-            bh->bh2_elts[j].hn_data = elt;
-            bh->bh2_elts[j].hn_es = es;
-            bh->bh2_elts[j].hn_es->es_sort = j;
+            if (j >= bh->bh2_max_width)
+                return merr(ev(EOVERFLOW));
+
+            bin_heap2_leaf_set(bh, j, es, elt);
+            es->es_sort = j;
             ++j;
         }
-        es = es->es_next_src;
     }
 
-    bh->bh2_width = j;
-    if (j > 1) {
-        for (i = bh->bh2_width / 2 - 1; i >= 0; --i)
-            bin_heap2_heapify(bh, i);
-    }
+    bh->bh2_width = bh->bh2_leafc = j;
+    bin_heap2_build(bh);
 
     return 0;
 }
@@ -411,31 +485,27 @@ bin_heap2_remove_src(struct bin_heap2 *bh, struct element_source *es, bool unget
 {
     int i;
 
-    for (i = 0; i < bh->bh2_width; ++i) {
+    for (i = 0; i < bh->bh2_leafc; ++i) {
         if (bh->bh2_elts[i].hn_es == es)
             break;
     }
 
-    if (i >= bh->bh2_width)
+    if (i >= bh->bh2_leafc)
         return;
 
-    /* If the last element is replaced with itself, heapify isn't necessary.
-     * In fact, heapifying such a bin heap will cause this deleted element
-     * to be dereferenced which could be pointing into freed memory.
+    /* The removed leaf is emptied rather than compared against, since its
+     * element may point into freed memory.
      *
      * This situation can arise when a cursor is trying to unbind from a
      * transaction that was committed via a flush and the flushed KVMS has
      * been ingested.
      */
-    if (i != bh->bh2_width - 1) {
-        int j;
+    bh->bh2_elts[i].hn_es = NULL;
+    bh->bh2_elts[i].hn_data = NULL;
+    --bh->bh2_width;
 
-        bh->bh2_elts[i] = bh->bh2_elts[bh->bh2_width - 1];
-        for (j = bh->bh2_width / 2 - 1; j >= 0; --j)
-            bin_heap2_heapify(bh, j);
-    }
+    bin_heap2_build(bh);
 
-    --bh->bh2_width;
     if (unget)
         es->es_unget(es);
 }
@@ -453,13 +523,15 @@ bin_heap2_remove_all(struct bin_heap2 *bh)
 {
     int i;
 
-    for (i = 0; i < bh->bh2_width; ++i) {
+    for (i = 0; i < bh->bh2_leafc; ++i) {
         struct element_source *es;
 
         es = bh->bh2_elts[i].hn_es;
-        es->es_unget(es);
+        if (es)
+            es->es_unget(es);
     }
     bh->bh2_width = 0;
+    bh->bh2_leafc = 0;
 }
 
 /*
@@ -472,38 +544,34 @@ bin_heap2_remove_all(struct bin_heap2 *bh)
 merr_t
 bin_heap2_insert_src(struct bin_heap2 *bh, struct element_source *es)
 {
-    struct heap_node *node;
-    void *            elt;
-    int               i, width;
+    void *elt;
+    int   i;
 
     /*
      * ensure the incoming src will fit and has something to contribute;
      * otherwise, we would insert it, then remove it next pop
      */
 
-    width = bh->bh2_width;
-    if (width + 1 > bh->bh2_max_width)
+    if (bh->bh2_width + 1 > bh->bh2_max_width)
         return merr(ev(EOVERFLOW));
 
     if (!es->es_get_next(es, &elt))
         return 0;
 
+    bin_heap2_compact(bh);
+
     /*
      * renumber everything, and append new thing
      */
-    node = &bh->bh2_elts[0];
-    for (i = 0; i < width; ++i) {
-        node->hn_es->es_sort++;
-        ++node;
-    }
+    for (i = 0; i < bh->bh2_leafc; ++i)
+        bh->bh2_elts[i].hn_es->es_sort++;
 
-    node->hn_data = elt;
-    node->hn_es = es;
-    node->hn_es->es_sort = 0;
+    bin_heap2_leaf_set(bh, bh->bh2_leafc, es, elt);
+    es->es_sort = 0;
+    ++bh->bh2_leafc;
     ++bh->bh2_width;
 
-    for (i = bh->bh2_width / 2 - 1; i >= 0; --i)
-        bin_heap2_heapify(bh, i);
+    bin_heap2_build(bh);
 
     return 0;
 }
@@ -519,18 +587,15 @@ bin_heap2_replace_src(struct bin_heap2 *bh, struct element_source *es)
         return 0;
     }
 
-    for (i = 0; i < bh->bh2_width; ++i)
+    for (i = 0; i < bh->bh2_leafc; ++i)
         if (bh->bh2_elts[i].hn_es == es)
             break;
 
-    if (i >= bh->bh2_width)
+    if (i >= bh->bh2_leafc)
         return merr(ev(ENOENT));
 
-    assert(es->es_sort == bh->bh2_elts[i].hn_es->es_sort);
-    bh->bh2_elts[i].hn_data = es_data;
-
-    for (i = bh->bh2_width / 2 - 1; i >= 0; --i)
-        bin_heap2_heapify(bh, i);
+    bin_heap2_leaf_set(bh, i, es, es_data);
+    bin_heap2_build(bh);
 
     return 0;
 }
@@ -538,33 +603,33 @@ bin_heap2_replace_src(struct bin_heap2 *bh, struct element_source *es)
 bool
 bin_heap2_pop(struct bin_heap2 *bh, void **item)
 {
-    struct heap_node       node;
-    void *                 elt;
     struct element_source *es;
-    int                    sort;
+    struct heap_node *     node;
+    void *                 elt;
+    int                    winner;
 
     if (bh->bh2_width == 0) {
         *item = 0;
         return false;
     }
 
-    node = bh->bh2_elts[0];
-    es = node.hn_es;
-    sort = node.hn_es->es_sort;
+    winner = bh->bh2_winner;
+    node = bh->bh2_elts + winner;
+    es = node->hn_es;
 
-    if (es->es_get_next(es, &elt)) {
-        bh->bh2_elts[0].hn_data = elt;
-        bh->bh2_elts[0].hn_es = es;
-        bh->bh2_elts[0].hn_es->es_sort = sort;
+    *item = node->hn_data;
 
-    } else if (bh->bh2_width-- > 1) {
-        /* an element source was exhausted, narrow the heap  */
-        bh->bh2_elts[0] = bh->bh2_elts[bh->bh2_width];
+    if (es->es_get_next(es, &elt)) {
+        bin_heap2_leaf_set(bh, winner, es, elt);
+    } else {
+        /* an element source was exhausted, it loses every match from now on */
+        node->hn_es = NULL;
+        node->hn_data = NULL;
+        if (--bh->bh2_width == 0)
+            return true;
     }
 
-    bin_heap2_heapify(bh, 0);
-
-    *item = node.hn_data;
+    bin_heap2_replay(bh, winner);
 
     return true;
 }
@@ -580,7 +645,7 @@ bin_heap2_peek_debug(struct bin_heap2 *bh, void **item, struct element_source **
         return false;
     }
 
-    node = bh->bh2_elts[0];
+    node = bh->bh2_elts[bh->bh2_winner];
     *item = node.hn_data;
     *es = node.hn_es;
     return true;
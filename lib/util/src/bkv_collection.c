@@ -118,6 +118,19 @@ bkv_collection_add(struct bkv_collection *bkvc, struct bonsai_kv *bkv, struct bo
     return 0;
 }
 
+void
+bkv_collection_get(
+    struct bkv_collection *bkvc,
+    size_t                 idx,
+    struct bonsai_kv     **bkv,
+    struct bonsai_val    **vlist)
+{
+    assert(idx < bkvc->bkvcol_cnt);
+
+    *bkv = bkvc->bkvcol_entry[idx].bkv;
+    *vlist = bkvc->bkvcol_entry[idx].vlist;
+}
+
 void *
 bkv_collection_rock_get(struct bkv_collection *bkvc)
 {
@@ -365,6 +365,7 @@ bn_val_init(struct bonsai_val *v, const struct bonsai_sval *sval, size_t sz)
     v->bv_seqnoref = sval->bsv_seqnoref;
     v->bv_value = sval->bsv_val;
     v->bv_xlen = sval->bsv_xlen;
+    v->bv_expire = sval->bsv_expire;
 
     if (sz > sizeof(*v)) {
         memcpy(v->bv_valbuf, sval->bsv_val, sz - sizeof(*v));
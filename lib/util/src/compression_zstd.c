@@ -0,0 +1,411 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/*
+ * Copyright (C) 2021 Micron Technology, Inc.  All rights reserved.
+ */
+
+#include <hse_util/assert.h>
+#include <hse_util/alloc.h>
+#include <hse_util/event_counter.h>
+#include <hse_util/hash.h>
+#include <hse_util/compression_zstd.h>
+#include <hse_util/logging.h>
+#include <hse_util/minmax.h>
+#include <hse_util/mutex.h>
+
+#include <pthread.h>
+
+#include <zstd.h>
+#include <zdict.h>
+
+#if ZSTD_VERSION_NUMBER < (10000 + 400 + 0)
+#error "Need zstd 1.4.0 or higher"
+#endif
+
+struct compress_zstd_cdict {
+    ZSTD_CDict *zc_cdict;
+    int         zc_level;
+};
+
+struct compress_zstd_ddict {
+    struct compress_zstd_ddict *zd_next;
+    ZSTD_DDict                 *zd_ddict;
+    u64                         zd_hash;
+    size_t                      zd_len;
+    uint                        zd_id;
+    uint                        zd_refcnt;
+};
+
+/* Compression contexts are large and expensive to create, so each thread
+ * lazily creates one of each and keeps them until it exits.
+ */
+struct zstd_tls {
+    ZSTD_CCtx *zt_cctx;
+    ZSTD_DCtx *zt_dctx;
+};
+
+static pthread_once_t zstd_tls_once = PTHREAD_ONCE_INIT;
+static pthread_key_t  zstd_tls_key;
+static int            zstd_tls_rc;
+
+static DEFINE_MUTEX(zstd_ddict_lock);
+static struct compress_zstd_ddict *zstd_ddict_head;
+
+static void
+zstd_tls_dtor(void *arg)
+{
+    struct zstd_tls *tls = arg;
+
+    ZSTD_freeCCtx(tls->zt_cctx);
+    ZSTD_freeDCtx(tls->zt_dctx);
+    free(tls);
+}
+
+static void
+zstd_tls_init(void)
+{
+    zstd_tls_rc = pthread_key_create(&zstd_tls_key, zstd_tls_dtor);
+}
+
+static struct zstd_tls *
+zstd_tls_get(void)
+{
+    struct zstd_tls *tls;
+
+    pthread_once(&zstd_tls_once, zstd_tls_init);
+    if (ev(zstd_tls_rc))
+        return NULL;
+
+    tls = pthread_getspecific(zstd_tls_key);
+    if (tls)
+        return tls;
+
+    tls = calloc(1, sizeof(*tls));
+    if (ev(!tls))
+        return NULL;
+
+    if (pthread_setspecific(zstd_tls_key, tls)) {
+        free(tls);
+        return NULL;
+    }
+
+    return tls;
+}
+
+static ZSTD_CCtx *
+zstd_cctx_get(void)
+{
+    struct zstd_tls *tls = zstd_tls_get();
+
+    if (tls && !tls->zt_cctx)
+        tls->zt_cctx = ZSTD_createCCtx();
+
+    return tls ? tls->zt_cctx : NULL;
+}
+
+static ZSTD_DCtx *
+zstd_dctx_get(void)
+{
+    struct zstd_tls *tls = zstd_tls_get();
+
+    if (tls && !tls->zt_dctx)
+        tls->zt_dctx = ZSTD_createDCtx();
+
+    return tls ? tls->zt_dctx : NULL;
+}
+
+merr_t
+compress_zstd_cdict_create(
+    const void                  *dict,
+    size_t                       dictlen,
+    int                          level,
+    struct compress_zstd_cdict **cdictp)
+{
+    struct compress_zstd_cdict *cdict;
+
+    INVARIANT(cdictp);
+
+    cdict = calloc(1, sizeof(*cdict));
+    if (ev(!cdict))
+        return merr(ENOMEM);
+
+    cdict->zc_level = clamp_t(int, level, COMPRESS_ZSTD_LEVEL_MIN, COMPRESS_ZSTD_LEVEL_MAX);
+
+    if (dict && dictlen > 0) {
+        cdict->zc_cdict = ZSTD_createCDict(dict, dictlen, cdict->zc_level);
+        if (ev(!cdict->zc_cdict)) {
+            free(cdict);
+            return merr(ENOMEM);
+        }
+    }
+
+    *cdictp = cdict;
+
+    return 0;
+}
+
+void
+compress_zstd_cdict_destroy(struct compress_zstd_cdict *cdict)
+{
+    if (!cdict)
+        return;
+
+    ZSTD_freeCDict(cdict->zc_cdict);
+    free(cdict);
+}
+
+merr_t
+compress_zstd_compress(
+    const struct compress_zstd_cdict *cdict,
+    const void                       *src,
+    uint                              src_len,
+    void                             *dst,
+    uint                              dst_capacity,
+    uint                             *dst_len)
+{
+    ZSTD_CCtx *cctx;
+    size_t     len;
+
+    assert(cdict && src && dst && dst_len);
+    assert(src_len && dst_capacity);
+
+    cctx = zstd_cctx_get();
+    if (ev(!cctx))
+        return merr(ENOMEM);
+
+    if (cdict->zc_cdict)
+        len = ZSTD_compress_usingCDict(cctx, dst, dst_capacity, src, src_len, cdict->zc_cdict);
+    else
+        len = ZSTD_compressCCtx(cctx, dst, dst_capacity, src, src_len, cdict->zc_level);
+
+    /* The only expected error is that the result doesn't fit.
+     */
+    if (ZSTD_isError(len))
+        return merr(EFBIG);
+
+    *dst_len = len;
+
+    return 0;
+}
+
+merr_t
+compress_zstd_ddict_get(
+    const void                        *dict,
+    size_t                             dictlen,
+    const struct compress_zstd_ddict **ddictp)
+{
+    struct compress_zstd_ddict *ddict;
+    uint                        id;
+    u64                         hash;
+    merr_t                      err = 0;
+
+    INVARIANT(dict && ddictp);
+
+    /* Dictionary IDs are not unique (e.g., raw content dictionaries all
+     * have ID zero), so match on a hash of the content as well.
+     */
+    id = ZSTD_getDictID_fromDict(dict, dictlen);
+    hash = hse_hash64(dict, dictlen);
+
+    mutex_lock(&zstd_ddict_lock);
+    for (ddict = zstd_ddict_head; ddict; ddict = ddict->zd_next) {
+        if (ddict->zd_hash == hash && ddict->zd_id == id && ddict->zd_len == dictlen)
+            break;
+    }
+
+    if (!ddict) {
+        ddict = calloc(1, sizeof(*ddict));
+        if (ddict) {
+            ddict->zd_ddict = ZSTD_createDDict(dict, dictlen);
+            if (ddict->zd_ddict) {
+                ddict->zd_hash = hash;
+                ddict->zd_id = id;
+                ddict->zd_len = dictlen;
+                ddict->zd_next = zstd_ddict_head;
+                zstd_ddict_head = ddict;
+            } else {
+                free(ddict);
+                ddict = NULL;
+            }
+        }
+
+        if (ev(!ddict))
+            err = merr(ENOMEM);
+    }
+
+    if (ddict)
+        ddict->zd_refcnt++;
+    mutex_unlock(&zstd_ddict_lock);
+
+    *ddictp = ddict;
+
+    return err;
+}
+
+void
+compress_zstd_ddict_put(const struct compress_zstd_ddict *ddict)
+{
+    struct compress_zstd_ddict **pp;
+
+    if (!ddict)
+        return;
+
+    mutex_lock(&zstd_ddict_lock);
+    assert(ddict->zd_refcnt > 0);
+
+    for (pp = &zstd_ddict_head; *pp; pp = &(*pp)->zd_next) {
+        if (*pp == ddict) {
+            if (--(*pp)->zd_refcnt == 0) {
+                *pp = ddict->zd_next;
+                ZSTD_freeDDict(ddict->zd_ddict);
+                free((void *)ddict);
+            }
+            break;
+        }
+    }
+    mutex_unlock(&zstd_ddict_lock);
+}
+
+merr_t
+compress_zstd_decompress(
+    const struct compress_zstd_ddict *ddict,
+    const void                       *src,
+    uint                              src_len,
+    void                             *dst,
+    uint                              dst_capacity,
+    uint                             *dst_len)
+{
+    unsigned long long content_len;
+    ZSTD_DCtx *        dctx;
+    size_t             len;
+
+    assert(src && dst && dst_len);
+    assert(src_len && dst_capacity);
+
+    dctx = zstd_dctx_get();
+    if (ev(!dctx))
+        return merr(ENOMEM);
+
+    ZSTD_DCtx_reset(dctx, ZSTD_reset_session_and_parameters);
+
+    content_len = ZSTD_getFrameContentSize(src, src_len);
+
+    if (content_len <= dst_capacity) {
+        if (ddict)
+            len = ZSTD_decompress_usingDDict(dctx, dst, dst_capacity, src, src_len, ddict->zd_ddict);
+        else
+            len = ZSTD_decompressDCtx(dctx, dst, dst_capacity, src, src_len);
+    } else {
+        ZSTD_outBuffer out = { dst, dst_capacity, 0 };
+        ZSTD_inBuffer  in = { src, src_len, 0 };
+
+        /* Partial decompression: stop as soon as the output is full.
+         */
+        len = ZSTD_DCtx_refDDict(dctx, ddict ? ddict->zd_ddict : NULL);
+
+        while (!ZSTD_isError(len) && out.pos < out.size && in.pos < in.size)
+            len = ZSTD_decompressStream(dctx, &out, &in);
+
+        if (!ZSTD_isError(len))
+            len = out.pos;
+    }
+
+    if (HSE_UNLIKELY(ZSTD_isError(len) || len < 1)) {
+        log_err("slen %u, cap %u, src %p, dst %p, ver %s: %s",
+                src_len, dst_capacity, src, dst, ZSTD_versionString(),
+                ZSTD_isError(len) ? ZSTD_getErrorName(len) : "empty");
+
+        return merr(EFBIG);
+    }
+
+    *dst_len = len;
+
+    return 0;
+}
+
+uint
+compress_zstd_dict_id(const void *dict, size_t dictlen)
+{
+    return dict ? ZSTD_getDictID_fromDict(dict, dictlen) : 0;
+}
+
+merr_t
+compress_zstd_dict_train(
+    const void   *samples,
+    const size_t *samplev,
+    uint          samplec,
+    void         *dict,
+    size_t        dictcap,
+    size_t       *dictlen)
+{
+    size_t len;
+
+    INVARIANT(samples && samplev && dict && dictlen);
+
+    len = ZDICT_trainFromBuffer(dict, dictcap, samples, samplev, samplec);
+
+    /* Training fails if the samples are too few or too uniform.
+     */
+    if (ZDICT_isError(len)) {
+        log_debug("samples %u, dictcap %zu: %s", samplec, dictcap, ZDICT_getErrorName(len));
+        return merr(ENODATA);
+    }
+
+    *dictlen = len;
+
+    return 0;
+}
+
+void
+compress_zstd_fini(void)
+{
+    struct compress_zstd_ddict *ddict;
+
+    /* Free dictionaries whose references were never put (e.g., leaked
+     * by an aborted open) so that they don't outlive the library.
+     */
+    mutex_lock(&zstd_ddict_lock);
+    while ((ddict = zstd_ddict_head)) {
+        zstd_ddict_head = ddict->zd_next;
+        ZSTD_freeDDict(ddict->zd_ddict);
+        free(ddict);
+    }
+    mutex_unlock(&zstd_ddict_lock);
+}
+
+static uint
+compress_zstd_estimate(const void *data, uint len)
+{
+    return len ? ZSTD_compressBound(len) : 0;
+}
+
+static merr_t
+compress_zstd_ops_compress(
+    const void *src,
+    uint        src_len,
+    void       *dst,
+    uint        dst_capacity,
+    uint       *dst_len)
+{
+    static const struct compress_zstd_cdict nodict = {
+        .zc_level = COMPRESS_ZSTD_LEVEL_DEFAULT,
+    };
+
+    return compress_zstd_compress(&nodict, src, src_len, dst, dst_capacity, dst_len);
+}
+
+static merr_t
+compress_zstd_ops_decompress(
+    const void *src,
+    uint        src_len,
+    void       *dst,
+    uint        dst_capacity,
+    uint       *dst_len)
+{
+    return compress_zstd_decompress(NULL, src, src_len, dst, dst_capacity, dst_len);
+}
+
+struct compress_ops compress_zstd_ops HSE_READ_MOSTLY = {
+    .cop_estimate   = compress_zstd_estimate,
+    .cop_compress   = compress_zstd_ops_compress,
+    .cop_decompress = compress_zstd_ops_decompress,
+};
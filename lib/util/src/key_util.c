@@ -77,6 +77,26 @@ key_disc_init(const void *key, size_t len, struct key_disc *kdisc)
     kdisc->kdisc[3] = be64toh(kdisc->kdisc[3]);
 }
 
+u64
+key_obj_disc64(const struct key_obj *kobj)
+{
+    u8   buf[sizeof(u64)] = { 0 };
+    uint len, sfx_len;
+    u64  disc;
+
+    len = min_t(uint, kobj->ko_pfx_len, sizeof(buf));
+    if (len > 0)
+        memcpy(buf, kobj->ko_pfx, len);
+
+    sfx_len = min_t(uint, kobj->ko_sfx_len, sizeof(buf) - len);
+    if (sfx_len > 0)
+        memcpy(buf + len, kobj->ko_sfx, sfx_len);
+
+    memcpy(&disc, buf, sizeof(disc));
+
+    return be64toh(disc);
+}
+
 int
 key_disc_cmp(const struct key_disc *lhs, const struct key_disc *rhs)
 {
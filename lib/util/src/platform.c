@@ -15,6 +15,7 @@
 #include <hse_util/rest_api.h>
 #include <hse_util/slab.h>
 #include <hse_util/minmax.h>
+#include <hse_util/compression_zstd.h>
 
 #include <hse/version.h>
 
@@ -217,6 +218,9 @@ errout:
 void
 hse_platform_fini(void)
 {
+#ifdef HAVE_ZSTD
+    compress_zstd_fini();
+#endif
     rest_destroy();
     kmem_cache_fini();
     perfc_fini();
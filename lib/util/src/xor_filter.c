@@ -0,0 +1,249 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/*
+ * Copyright (C) 2021 Micron Technology, Inc.  All rights reserved.
+ */
+
+#include <hse_util/assert.h>
+#include <hse_util/event_counter.h>
+#include <hse_util/xor_filter.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+/* Number of seeds to try before giving up on building a filter.  With
+ * 1.23n + 32 slots the probability that peeling fails for a given seed
+ * is very small, so in practice the first seed nearly always succeeds.
+ */
+#define XF_BUILD_TRIES (64)
+
+struct xf_slot {
+    u64 xs_xormask;
+    u32 xs_count;
+};
+
+struct xf_peeled {
+    u64 xp_hash;
+    u32 xp_slot;
+};
+
+static u32
+xf_seglen(u32 num_elmnts)
+{
+    u64 slots = 32 + ((u64)num_elmnts * 123 + 99) / 100;
+
+    return (slots + 2) / 3;
+}
+
+u32
+xf_fpbits(u32 probability)
+{
+    /* 2^-8 is ~3906 per million */
+    return (probability >= 3906) ? 8 : 16;
+}
+
+u32
+xf_size_estimate(u32 fpbits, u32 num_elmnts)
+{
+    return xf_seglen(num_elmnts) * 3 * (fpbits / 8);
+}
+
+u32
+xf_element_estimate(u32 fpbits, size_t size)
+{
+    u64 slots = (size / (fpbits / 8)) / 3 * 3;
+    u64 n;
+
+    if (slots <= 32)
+        return 0;
+
+    n = (slots - 32) * 100 / 123;
+    if (n > U32_MAX)
+        n = U32_MAX;
+
+    while (n > 0 && xf_size_estimate(fpbits, n) > size)
+        --n;
+
+    return n;
+}
+
+static int
+xf_hash_cmp(const void *lhs, const void *rhs)
+{
+    u64 l = *(const u64 *)lhs;
+    u64 r = *(const u64 *)rhs;
+
+    return (l > r) - (l < r);
+}
+
+static void
+xf_fpset(u8 *fpv, u32 slot, u32 fpbits, u32 fp)
+{
+    if (fpbits == 8) {
+        fpv[slot] = fp;
+        return;
+    }
+
+    fpv[slot * 2] = fp;
+    fpv[slot * 2 + 1] = fp >> 8;
+}
+
+/* Try to peel every key from the 3-hypergraph defined by seed.  On
+ * success the peeled keys are left in peelv in the order in which
+ * they were peeled, and the number of keys peeled equals hashc.
+ */
+static u32
+xf_peel(
+    const u64 *       hashv,
+    u32               hashc,
+    u32               seed,
+    u32               seglen,
+    struct xf_slot *  slotv,
+    u32 *             queuev,
+    struct xf_peeled *peelv)
+{
+    u32 nslots = seglen * 3;
+    u32 qhead, qtail, npeeled, i, j;
+
+    memset(slotv, 0, nslots * sizeof(*slotv));
+
+    for (i = 0; i < hashc; ++i) {
+        u32 idxv[3];
+
+        xf_hash2slots(hashv[i], seed, seglen, idxv);
+
+        for (j = 0; j < 3; ++j) {
+            slotv[idxv[j]].xs_xormask ^= hashv[i];
+            slotv[idxv[j]].xs_count++;
+        }
+    }
+
+    qhead = qtail = 0;
+
+    for (i = 0; i < nslots; ++i) {
+        if (slotv[i].xs_count == 1)
+            queuev[qtail++] = i;
+    }
+
+    npeeled = 0;
+
+    while (qhead < qtail) {
+        u32 slot = queuev[qhead++];
+        u32 idxv[3];
+        u64 hash;
+
+        if (slotv[slot].xs_count != 1)
+            continue;
+
+        hash = slotv[slot].xs_xormask;
+
+        peelv[npeeled].xp_hash = hash;
+        peelv[npeeled].xp_slot = slot;
+        ++npeeled;
+
+        xf_hash2slots(hash, seed, seglen, idxv);
+
+        for (j = 0; j < 3; ++j) {
+            struct xf_slot *s = slotv + idxv[j];
+
+            s->xs_xormask ^= hash;
+            if (--s->xs_count == 1)
+                queuev[qtail++] = idxv[j];
+        }
+    }
+
+    return npeeled;
+}
+
+merr_t
+xf_filter_build(
+    struct xor_filter *xf,
+    u32                fpbits,
+    u64 *              hashv,
+    u32                hashc,
+    u8 *               storage,
+    size_t             storage_sz)
+{
+    struct xf_peeled *peelv;
+    struct xf_slot *  slotv;
+    u32 *             queuev;
+    u32               seglen, nslots, seed, tries, i, j;
+    size_t            sz;
+    merr_t            err;
+
+    INVARIANT(xf);
+    INVARIANT(fpbits == 8 || fpbits == 16);
+
+    memset(xf, 0, sizeof(*xf));
+
+    /* The hypergraph cannot be peeled if it contains duplicate
+     * edges, which are common given that keys which differ only
+     * in their suffix hash to the same value.
+     */
+    if (hashc > 1) {
+        qsort(hashv, hashc, sizeof(*hashv), xf_hash_cmp);
+
+        for (i = 1, j = 1; i < hashc; ++i) {
+            if (hashv[i] != hashv[j - 1])
+                hashv[j++] = hashv[i];
+        }
+        hashc = j;
+    }
+
+    seglen = xf_seglen(hashc);
+    nslots = seglen * 3;
+
+    if (ev(xf_size_estimate(fpbits, hashc) > storage_sz))
+        return merr(ENOSPC);
+
+    sz = nslots * (sizeof(*slotv) + sizeof(*queuev)) + hashc * sizeof(*peelv);
+
+    slotv = malloc(sz);
+    if (ev(!slotv))
+        return merr(ENOMEM);
+
+    queuev = (u32 *)(slotv + nslots);
+    peelv = (struct xf_peeled *)(queuev + nslots);
+
+    err = merr(EAGAIN);
+    seed = 0;
+
+    for (tries = 0; tries < XF_BUILD_TRIES; ++tries) {
+        seed = (tries + 1) * 0x9e3779b9u;
+
+        if (xf_peel(hashv, hashc, seed, seglen, slotv, queuev, peelv) == hashc) {
+            err = 0;
+            break;
+        }
+    }
+
+    if (ev(err))
+        goto out;
+
+    /* Assign fingerprints in the reverse order in which the keys were
+     * peeled, such that each key's slot is the last of its three slots
+     * to be assigned.
+     */
+    memset(storage, 0, nslots * (fpbits / 8));
+
+    for (i = hashc; i-- > 0;) {
+        u32 idxv[3], fp;
+
+        fp = xf_hash2slots(peelv[i].xp_hash, seed, seglen, idxv);
+
+        for (j = 0; j < 3; ++j)
+            fp ^= xf_fpget(storage, idxv[j], fpbits);
+
+        xf_fpset(storage, peelv[i].xp_slot, fpbits, fp);
+    }
+
+    xf->xf_fpv = storage;
+    xf->xf_fpvsz = nslots * (fpbits / 8);
+    xf->xf_seglen = seglen;
+    xf->xf_seed = seed;
+    xf->xf_fpbits = fpbits;
+
+out:
+    free(slotv);
+
+    return err;
+}
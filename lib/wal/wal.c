@@ -48,11 +48,16 @@ struct wal {
     struct mutex     sync_mutex HSE_L1D_ALIGNED;
     struct list_head sync_waiters;
     struct cv        sync_cv;
+    atomic_int       sync_waitc;
 
     struct mutex timer_mutex HSE_L1D_ALIGNED;
     bool         sync_pending;
     struct cv    timer_cv;
 
+    atomic_ulong sync_lat_p99 HSE_L1D_ALIGNED;
+    uint64_t     sync_lat_tgt_ns;
+    uint64_t     sync_batch_ns;
+
     atomic_long error HSE_L1D_ALIGNED;
     atomic_int closing;
     bool       clean;
@@ -89,6 +94,46 @@ struct wal_sync_waiter {
 void
 wal_ionotify_cb(void *cbarg, merr_t err);
 
+/* Group commit: Each sync waiter folds its observed latency into a running
+ * estimate of the p99 sync latency.  The timer thread uses that estimate to
+ * size the window for which it delays a requested flush in order to gather
+ * more sync waiters into the same write.  The window grows additively while
+ * the estimate is below the target and is halved when it exceeds the target.
+ * A lone sync waiter has no one to share the write with, so the window is
+ * applied only while several waiters are outstanding.
+ */
+static void
+wal_sync_lat_update(struct wal *wal, uint64_t lat)
+{
+    uint64_t est = atomic_read(&wal->sync_lat_p99);
+    uint64_t step = est / 16 + 1000;
+
+    /* Frugal streaming quantile: Step up on samples above the estimate
+     * and down by 1/99th of that on samples below, which converges on
+     * the 99th percentile.
+     */
+    if (lat > est)
+        est += step;
+    else
+        est -= min_t(uint64_t, est, step / 99);
+
+    atomic_set(&wal->sync_lat_p99, est);
+}
+
+static uint64_t
+wal_sync_batch_adjust(struct wal *wal)
+{
+    uint64_t tgt = wal->sync_lat_tgt_ns;
+    uint64_t p99 = atomic_read(&wal->sync_lat_p99);
+
+    if (p99 > tgt)
+        wal->sync_batch_ns /= 2;
+    else
+        wal->sync_batch_ns = min_t(uint64_t, wal->sync_batch_ns + (tgt - p99) / 8, tgt / 2);
+
+    return wal->sync_batch_ns;
+}
+
 static void *
 wal_timer(void *rock)
 {
@@ -107,6 +152,7 @@ wal_timer(void *rock)
 
     while (!closing && !atomic_read(&wal->error)) {
         uint64_t tstart, rid, lag, sleep_ns, flushb, bufsz, buflen;
+        bool sync;
 
         closing = !!atomic_read(&wal->closing);
 
@@ -148,12 +194,31 @@ wal_timer(void *rock)
         }
 
         mutex_lock(&wal->timer_mutex);
-        if (wal->sync_pending)
-            closing = false;
-        else if (!closing && sleep_ns > 0)
+        if (!wal->sync_pending && !closing && sleep_ns > 0)
             cv_timedwait(&wal->timer_cv, &wal->timer_mutex, NSEC_TO_MSEC(sleep_ns));
+        sync = wal->sync_pending;
         wal->sync_pending = false;
         mutex_unlock(&wal->timer_mutex);
+
+        if (sync) {
+            closing = false;
+
+            /* Give concurrent sync callers a chance to join this flush.
+             */
+            if (wal->sync_lat_tgt_ns > 0 && atomic_read(&wal->sync_waitc) > 1 &&
+                !atomic_read(&wal->closing)) {
+                uint64_t batch_ns = wal_sync_batch_adjust(wal);
+
+                if (batch_ns > 0) {
+                    struct timespec ts = {
+                        .tv_sec = batch_ns / NSEC_PER_SEC,
+                        .tv_nsec = batch_ns % NSEC_PER_SEC,
+                    };
+
+                    nanosleep(&ts, NULL);
+                }
+            }
+        }
     }
 
     err = atomic_read(&wal->error);
@@ -219,8 +284,11 @@ wal_ionotify_cb(void *cbarg, merr_t err)
 static merr_t
 wal_sync_impl(struct wal *wal, struct wal_sync_waiter *swait)
 {
+    uint64_t tstart = get_time_ns();
+
     mutex_lock(&wal->sync_mutex);
     list_add_tail(&swait->ws_link, &wal->sync_waiters);
+    atomic_inc(&wal->sync_waitc);
 
     /* Notify the timer worker */
     mutex_lock(&wal->timer_mutex);
@@ -233,6 +301,9 @@ wal_sync_impl(struct wal *wal, struct wal_sync_waiter *swait)
         cv_timedwait(&swait->ws_cv, &wal->sync_mutex, wal->dur_ms);
 
     list_del(&swait->ws_link);
+    atomic_dec(&wal->sync_waitc);
+    if (!swait->ws_err)
+        wal_sync_lat_update(wal, get_time_ns() - tstart);
     mutex_unlock(&wal->sync_mutex);
 
     cv_destroy(&swait->ws_cv);
@@ -258,6 +329,31 @@ wal_sync(struct wal *wal)
     return wal_sync_impl(wal, &swait);
 }
 
+merr_t
+wal_op_sync(struct wal *wal, const struct wal_record *rec)
+{
+    struct wal_sync_waiter swait = {0};
+    uint64_t endoff;
+
+    if (!wal)
+        return 0;
+
+    swait.ws_bufcnt = wal_bufset_curoff(wal->wbs, WAL_BUF_MAX, swait.ws_offv);
+    if (swait.ws_bufcnt < 0 || rec->wbidx >= swait.ws_bufcnt)
+        return merr(EBUG);
+
+    /* Offset zero is trivially durable for all the other buffers.
+     */
+    endoff = rec->offset + rec->len;
+    memset(swait.ws_offv, 0, sizeof(swait.ws_offv));
+    swait.ws_offv[rec->wbidx] = endoff;
+
+    cv_init(&swait.ws_cv, "wal_op_sync_waiter");
+    INIT_LIST_HEAD(&swait.ws_link);
+
+    return wal_sync_impl(wal, &swait);
+}
+
 static merr_t
 wal_cond_sync(struct wal *wal, uint64_t gen)
 {
@@ -314,6 +410,8 @@ wal_put(
     vlen = kvs_vtuple_vlen(vt);
     rlen = wal_reclen(wal->version);
     kvlen = ALIGN(klen, kvalign) + ALIGN(vlen, kvalign);
+    if (vt->vt_expire)
+        kvlen += sizeof(uint64_t);
     len = rlen + kvlen;
 
     rec = wal_bufset_alloc(wal->wbs, len, &recout->offset, &recout->wbidx, &recout->cookie);
@@ -330,19 +428,27 @@ wal_put(
     rtype = (txid > 0) ? WAL_RT_TX : WAL_RT_NONTX;
     wal_rechdr_pack(rtype, rid, len, 0, rec);
 
-    wal_rec_pack(WAL_OP_PUT, kvs->ikv_cnid, txid, klen, vt->vt_xlen, rec);
+    wal_rec_pack(vt->vt_expire ? WAL_OP_PUT_TTL : WAL_OP_PUT, kvs->ikv_cnid, txid, klen,
+                 vt->vt_xlen, rec);
 
     kvdata = (char *)rec + rlen;
     memcpy(kvdata, kt->kt_data, klen);
     kt->kt_data = kvdata;
     kt->kt_flags = wal->buf_flags;
+    kvdata = PTR_ALIGN(kvdata + klen, kvalign);
 
     if (vlen > 0) {
-        kvdata = PTR_ALIGN(kvdata + klen, kvalign);
         memcpy(kvdata, vt->vt_data, vlen);
         vt->vt_data = kvdata;
     }
 
+    /* The expiration time of a put with a ttl follows the value */
+    if (vt->vt_expire) {
+        uint64_t expire = cpu_to_omf64(vt->vt_expire);
+
+        memcpy(kvdata + ALIGN(vlen, kvalign), &expire, sizeof(expire));
+    }
+
     return 0;
 }
 
@@ -417,6 +523,59 @@ wal_del_pfx(
     return wal_del_impl(wal, kvs, kt, txid, recout, true);
 }
 
+merr_t
+wal_del_range(
+    struct wal *wal,
+    struct ikvs *kvs,
+    struct kvs_ktuple *kt,
+    struct kvs_ktuple *kt_end,
+    struct wal_record *recout)
+{
+    const size_t kalign = sizeof(uint64_t);
+    struct wal_rec_omf *rec;
+    uint64_t rid;
+    size_t klen, elen, rlen, len;
+    char *kdata;
+    merr_t err;
+
+    if (!wal)
+        return 0;
+
+    /* The end key is logged in place of a value.
+     */
+    rlen = wal_reclen(wal->version);
+    klen = kt->kt_len;
+    elen = kt_end->kt_len;
+    len = rlen + ALIGN(klen, kalign) + ALIGN(elen, kalign);
+
+    rec = wal_bufset_alloc(wal->wbs, len, &recout->offset, &recout->wbidx, &recout->cookie);
+    if (!rec) {
+        err = merr(ENOMEM); /* unrecoverable error */
+        kvdb_health_error(wal->health, err);
+        return err;
+    }
+
+    recout->recbuf = rec;
+    recout->len = len;
+
+    rid = atomic_inc_return(&wal->wal_rid);
+    wal_rechdr_pack(WAL_RT_NONTX, rid, len, 0, rec);
+
+    wal_rec_pack(WAL_OP_RDEL, kvs->ikv_cnid, 0, klen, elen, rec);
+
+    kdata = (char *)rec + rlen;
+    memcpy(kdata, kt->kt_data, klen);
+    kt->kt_data = kdata;
+    kt->kt_flags = wal->buf_flags;
+
+    kdata = PTR_ALIGN(kdata + klen, kalign);
+    memcpy(kdata, kt_end->kt_data, elen);
+    kt_end->kt_data = kdata;
+    kt_end->kt_flags = wal->buf_flags;
+
+    return 0;
+}
+
 static merr_t
 wal_txn(
     struct wal *wal,
@@ -585,6 +744,7 @@ wal_open(
     mutex_init(&wal->sync_mutex);
     cv_init(&wal->sync_cv, "wal_sync_cv");
     INIT_LIST_HEAD(&wal->sync_waiters);
+    atomic_set(&wal->sync_waitc, 0);
     wal->sync_pending = false;
 
     err = wal_mdc_open(mp, rinfo->mdcid1, rinfo->mdcid2, wal->read_only, &wal->mdc);
@@ -624,6 +784,8 @@ wal_open(
     if (rp->dur_bufsz_mb != HSE_WAL_DUR_BUFSZ_MB_DFLT)
         wal->dur_bufsz = (size_t)rp->dur_bufsz_mb << MB_SHIFT;
 
+    wal->sync_lat_tgt_ns = (uint64_t)rp->dur_sync_lat_us * 1000;
+
     mclass = rp->dur_mclass;
     if (mclass == HSE_MCLASS_AUTO) {
         int i;
@@ -668,7 +830,8 @@ wal_open(
 
     wal->wiocb.iocb = wal_ionotify_cb;
     wal->wiocb.cbarg = wal;
-    wal->wbs = wal_bufset_open(wal->wfset, wal->dur_bufsz, &wal->wal_ingestgen, &wal->wiocb);
+    wal->wbs = wal_bufset_open(wal->wfset, wal->dur_bufsz, &wal->wal_ingestgen, &wal->wiocb,
+                               rp->dur_aio_qdepth);
     if (!wal->wbs) {
         err = merr(ENOMEM);
         goto errout;
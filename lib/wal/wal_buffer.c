@@ -223,7 +223,8 @@ wal_bufset_open(
     struct wal_fileset *wfset,
     size_t              bufsz,
     atomic_ulong       *ingestgen,
-    struct wal_iocb    *iocb)
+    struct wal_iocb    *iocb,
+    uint32_t            aio_qdepth)
 {
     struct wal_bufset *wbs;
     uint32_t i, j, k;
@@ -292,7 +293,8 @@ wal_bufset_open(
     for (i = 0; i < threads; i++) {
         struct wal_buffer *wb = wbs->wbs_bufv + i;
 
-        wb->wb_io = wal_io_create(wfset, i, &wb->wb_doff, iocb);
+        wb->wb_io = wal_io_create(wfset, i, &wb->wb_doff, iocb, wb->wb_buf,
+                                  wbs->wbs_buf_allocsz, aio_qdepth);
         if (!wb->wb_io)
             goto errout;
     }
@@ -16,7 +16,8 @@ wal_bufset_open(
     struct wal_fileset *wfset,
     size_t              bufsz,
     atomic_ulong       *ingestgen,
-    struct wal_iocb    *iocb);
+    struct wal_iocb    *iocb,
+    uint32_t            aio_qdepth);
 
 void
 wal_bufset_close(struct wal_bufset *wbs);
@@ -399,7 +399,14 @@ wal_file_read(struct wal_file *wfile, char *buf, size_t len)
 }
 
 merr_t
-wal_file_write(struct wal_file *wfile, char *buf, size_t len, bool bufwrap)
+wal_file_write_prep(
+    struct wal_file *wfile,
+    char            *buf,
+    size_t           len,
+    bool             bufwrap,
+    char           **abufp,
+    off_t           *aoffp,
+    size_t          *alenp)
 {
     merr_t err;
     char *abuf;
@@ -452,6 +459,31 @@ wal_file_write(struct wal_file *wfile, char *buf, size_t len, bool bufwrap)
 
     assert(PAGE_ALIGNED(abuf) && PAGE_ALIGNED(aoff) && PAGE_ALIGNED(alen));
 
+    /* Bring the buffer addr and file offset to the same alignment if it mismatched */
+    if (adjust_woff)
+        wfile->woff += roundsz;
+
+    wfile->woff += len;
+
+    *abufp = abuf;
+    *aoffp = aoff;
+    *alenp = alen;
+
+    return 0;
+}
+
+merr_t
+wal_file_write(struct wal_file *wfile, char *buf, size_t len, bool bufwrap)
+{
+    merr_t err;
+    char *abuf;
+    off_t aoff;
+    size_t alen;
+
+    err = wal_file_write_prep(wfile, buf, len, bufwrap, &abuf, &aoff, &alen);
+    if (err)
+        return err;
+
     while (alen > 0) {
         size_t cc;
 
@@ -465,15 +497,26 @@ wal_file_write(struct wal_file *wfile, char *buf, size_t len, bool bufwrap)
         alen -= cc;
     }
 
-    /* Bring the buffer addr and file offset to the same alignment if it mismatched */
-    if (adjust_woff)
-        wfile->woff += roundsz;
-
-    wfile->woff += len;
-
     return 0;
 }
 
+merr_t
+wal_file_write_async(
+    struct wal_file      *wfile,
+    struct mpool_aio_ctx *aio,
+    char                 *abuf,
+    off_t                 aoff,
+    size_t                alen,
+    mpool_aio_cb_t       *cb,
+    void                 *arg)
+{
+    if (!wfile)
+        return merr(EINVAL);
+
+    assert(PAGE_ALIGNED(abuf) && PAGE_ALIGNED(aoff) && PAGE_ALIGNED(alen));
+
+    return mpool_file_write_async(wfile->mpf, aio, aoff, abuf, alen, cb, arg);
+}
 
 /*
  * WAL fileset replay interfaces
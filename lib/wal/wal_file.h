@@ -63,6 +63,31 @@ wal_file_read(struct wal_file *walf, char *buf, size_t len);
 merr_t
 wal_file_write(struct wal_file *wfile, char *buf, size_t len, bool bufwrap);
 
+/* Map a buffer range onto the page-aligned region of the file to which it
+ * must be written, and advance the file's write offset past it.  Writes
+ * the file header if this is the first write to the file.
+ */
+merr_t
+wal_file_write_prep(
+    struct wal_file *wfile,
+    char            *buf,
+    size_t           len,
+    bool             bufwrap,
+    char           **abufp,
+    off_t           *aoffp,
+    size_t          *alenp);
+
+/* Queue a write of a page-aligned region obtained via wal_file_write_prep() */
+merr_t
+wal_file_write_async(
+    struct wal_file      *wfile,
+    struct mpool_aio_ctx *aio,
+    char                 *abuf,
+    off_t                 aoff,
+    size_t                alen,
+    mpool_aio_cb_t       *cb,
+    void                 *arg);
+
 void
 wal_file_minmax_update(struct wal_file *wfile, struct wal_minmax_info *info);
 
@@ -12,10 +12,20 @@
 #include <hse_util/list.h>
 #include <hse_util/condvar.h>
 #include <hse_util/mutex.h>
+#include <hse_util/event_counter.h>
 
 #include "wal.h"
 #include "wal_file.h"
 
+/* Max length of a single async write.  Larger flushes are split so that
+ * the pieces can proceed in parallel on the device.
+ */
+#define WAL_IO_SEGSZ_MAX    (1ul << 20)
+
+/* Max length of a single registered buffer region (kernel limit) */
+#define WAL_IO_BUFREG_MAX   (1ul << 30)
+#define WAL_IO_BUFREG_CNT   (16)
+
 static struct kmem_cache       *iowcache HSE_READ_MOSTLY;
 static struct workqueue_struct *iowq HSE_READ_MOSTLY;
 
@@ -29,6 +39,15 @@ struct wal_io_work {
     uint64_t    iow_gen;
     uint32_t    iow_index;
     bool        iow_bufwrap;
+
+    /* Async write state */
+    struct wal_file *iow_wfile;
+    char            *iow_headbuf;
+    off_t            iow_headoff;
+    off_t            iow_tailoff;
+    size_t           iow_wrlen;
+    size_t           iow_donelen;
+    uint32_t         iow_pending;
 } HSE_L1D_ALIGNED;
 
 
@@ -50,25 +69,39 @@ struct wal_io {
     atomic_long         io_err;
     uint32_t            io_index;
     struct work_struct  io_work;
+
+    struct mpool_aio_ctx *io_aio;
+    struct list_head      io_inflight;
+    uint32_t              io_inflightc;
 };
 
+static void
+wal_io_error(struct wal_io *io, merr_t err)
+{
+    if (!atomic_read(&io->io_err)) {
+        atomic_set(&io->io_err, err);
+        io->io_cb->iocb(io->io_cb->cbarg, err); /* Notify sync waiters */
+    }
+}
 
 static merr_t
-wal_io_submit(struct wal_io_work *iow)
-{
-    struct wal_io *io;
-    size_t buflen;
-    merr_t err = 0;
-    uint64_t gen, cgen;
+wal_io_drain(struct wal_io *io);
 
-    io = iow->iow_io;
-    buflen = iow->iow_len;
+static merr_t
+wal_io_file_get(struct wal_io *io, uint64_t gen, uint32_t index)
+{
+    uint64_t cgen;
+    merr_t err;
 
     cgen = atomic_read(&io->io_gen);
-    gen = iow->iow_gen;
     if (gen > cgen) {
         atomic_set(&io->io_gen, gen);
         if (io->io_wfile) {
+            /* All writes to the current file must land before it is completed */
+            err = wal_io_drain(io);
+            if (err)
+                return err;
+
             err = wal_file_complete(io->io_wfset, io->io_wfile);
             if (err)
                 return err;
@@ -82,9 +115,7 @@ wal_io_submit(struct wal_io_work *iow)
     }
 
     if (!io->io_wfile) {
-        merr_t err;
-
-        err = wal_file_open(io->io_wfset, gen, iow->iow_index, false, &io->io_wfile);
+        err = wal_file_open(io->io_wfset, gen, index, false, &io->io_wfile);
         if (err)
             return err;
 
@@ -93,6 +124,24 @@ wal_io_submit(struct wal_io_work *iow)
 
     assert(io->io_wfile);
 
+    return 0;
+}
+
+
+static merr_t
+wal_io_submit(struct wal_io_work *iow)
+{
+    struct wal_io *io;
+    size_t buflen;
+    merr_t err = 0;
+
+    io = iow->iow_io;
+    buflen = iow->iow_len;
+
+    err = wal_io_file_get(io, iow->iow_gen, iow->iow_index);
+    if (err)
+        return err;
+
     err = wal_file_write(io->io_wfile, iow->iow_buf, buflen, iow->iow_bufwrap);
     if (err) {
         wal_file_put(io->io_wfile);
@@ -108,6 +157,187 @@ wal_io_submit(struct wal_io_work *iow)
     return 0;
 }
 
+/*
+ * Async write path
+ *
+ * With an async io context each work is split into one or more writes which
+ * are queued without waiting for prior writes to complete.  Works are kept
+ * on io_inflight in buffer order and are retired strictly in that order, so
+ * the durable offset (io_doff) never runs ahead of a hole.
+ *
+ * Consecutive works usually share the partial page at the boundary between
+ * them.  The later work's copy of that page is a superset of the earlier's,
+ * so it must reach the media last.  To that end a work's first page is held
+ * back (iow_headbuf) until the preceding work has completed, while the rest
+ * of the work is issued immediately.
+ */
+static void
+wal_io_write_cb(void *arg, merr_t err, size_t len)
+{
+    struct wal_io_work *iow = arg;
+
+    if (err)
+        wal_io_error(iow->iow_io, err);
+    else
+        iow->iow_donelen += len;
+
+    assert(iow->iow_pending > 0);
+    iow->iow_pending--;
+}
+
+static void
+wal_io_head_submit(struct wal_io *io, struct wal_io_work *iow)
+{
+    char *buf = iow->iow_headbuf;
+    merr_t err;
+
+    iow->iow_headbuf = NULL;
+
+    if (!atomic_read(&io->io_err)) {
+        err = wal_file_write_async(
+            iow->iow_wfile, io->io_aio, buf, iow->iow_headoff, PAGE_SIZE, wal_io_write_cb, iow);
+        if (!err)
+            return;
+
+        wal_io_error(io, err);
+    }
+
+    iow->iow_pending--;
+}
+
+static void
+wal_io_retire(struct wal_io *io)
+{
+    struct wal_io_work *iow, *next;
+    bool prev_done = true;
+    bool notify = false;
+
+    list_for_each_entry_safe(iow, next, &io->io_inflight, iow_list) {
+        if (iow->iow_pending > 0)
+            break;
+
+        if (!atomic_read(&io->io_err)) {
+            if (ev(iow->iow_donelen != iow->iow_wrlen)) {
+                wal_io_error(io, merr(EIO));
+            } else {
+                wal_file_minmax_update(iow->iow_wfile, &iow->iow_info);
+                atomic_add(io->io_doff, iow->iow_len);
+                notify = true;
+            }
+        }
+
+        list_del(&iow->iow_list);
+        io->io_inflightc--;
+
+        wal_file_put(iow->iow_wfile);
+        atomic_inc(&io->io_comp);
+        kmem_cache_free(iowcache, iow);
+    }
+
+    if (notify)
+        io->io_cb->iocb(io->io_cb->cbarg, 0);
+
+    /* Release held-back first pages whose predecessors have completed */
+    list_for_each_entry(iow, &io->io_inflight, iow_list) {
+        if (iow->iow_headbuf && prev_done)
+            wal_io_head_submit(io, iow);
+
+        prev_done = (iow->iow_pending == 0);
+    }
+}
+
+static merr_t
+wal_io_drain(struct wal_io *io)
+{
+    while (io->io_inflightc > 0) {
+        merr_t err;
+
+        err = mpool_aio_poll(io->io_aio, 1);
+        if (ev(err))
+            return err;
+
+        wal_io_retire(io);
+    }
+
+    return atomic_read(&io->io_err);
+}
+
+/* Takes ownership of iow, even on error */
+static merr_t
+wal_io_submit_async(struct wal_io_work *iow)
+{
+    struct wal_io *io = iow->iow_io;
+    struct wal_io_work *prev;
+    char *abuf;
+    off_t aoff;
+    size_t alen;
+    merr_t err;
+
+    /* Rewriting the first page of a wrapped buffer reads it back from the
+     * file, so all prior writes must have landed.
+     */
+    if (iow->iow_bufwrap) {
+        err = wal_io_drain(io);
+        if (err)
+            goto errout;
+    }
+
+    err = wal_io_file_get(io, iow->iow_gen, iow->iow_index);
+    if (err)
+        goto errout;
+
+    err = wal_file_write_prep(
+        io->io_wfile, iow->iow_buf, iow->iow_len, iow->iow_bufwrap, &abuf, &aoff, &alen);
+    if (err) {
+        wal_file_put(io->io_wfile);
+        goto errout;
+    }
+
+    prev = list_last_entry_or_null(&io->io_inflight, struct wal_io_work, iow_list);
+
+    iow->iow_wfile = io->io_wfile;
+    iow->iow_headbuf = NULL;
+    iow->iow_tailoff = aoff + alen - PAGE_SIZE;
+    iow->iow_wrlen = alen;
+    iow->iow_donelen = 0;
+    iow->iow_pending = 0;
+
+    list_add_tail(&iow->iow_list, &io->io_inflight);
+    io->io_inflightc++;
+
+    if (prev && prev->iow_pending > 0 && prev->iow_wfile == iow->iow_wfile &&
+        prev->iow_tailoff == aoff) {
+        iow->iow_headbuf = abuf;
+        iow->iow_headoff = aoff;
+        iow->iow_pending++;
+
+        abuf += PAGE_SIZE;
+        aoff += PAGE_SIZE;
+        alen -= PAGE_SIZE;
+    }
+
+    while (alen > 0) {
+        size_t len = min_t(size_t, alen, WAL_IO_SEGSZ_MAX);
+
+        err = wal_file_write_async(iow->iow_wfile, io->io_aio, abuf, aoff, len, wal_io_write_cb, iow);
+        if (err)
+            return err; /* Retired via wal_io_retire() */
+
+        iow->iow_pending++;
+        abuf += len;
+        aoff += len;
+        alen -= len;
+    }
+
+    return 0;
+
+errout:
+    atomic_inc(&io->io_comp);
+    kmem_cache_free(iowcache, iow);
+
+    return err;
+}
+
 static void
 wal_io_worker(struct work_struct *work)
 {
@@ -118,12 +348,13 @@ wal_io_worker(struct work_struct *work)
     while (true) {
         struct wal_io_work *iow, *next;
         struct list_head active;
+        bool idle;
 
         INIT_LIST_HEAD(&active);
 
         mutex_lock(&io->io_lock);
 
-        while (list_empty(&io->io_active)) {
+        while (list_empty(&io->io_active) && io->io_inflightc == 0) {
             if (io->io_stop) {
                 mutex_unlock(&io->io_lock);
                 atomic_set(&io->io_stopped, 1);
@@ -137,22 +368,42 @@ wal_io_worker(struct work_struct *work)
         mutex_unlock(&io->io_lock);
 
         list_for_each_entry_safe(iow, next, &active, iow_list) {
-            if (atomic_read(&io->io_err) == 0) {
-                merr_t err;
+            merr_t err;
 
-                assert(iow->iow_index == io->io_index);
+            list_del(&iow->iow_list);
 
-                err = wal_io_submit(iow);
-                if (err) {
-                    atomic_set(&io->io_err, err);
-                    io->io_cb->iocb(io->io_cb->cbarg, err); /* Notify sync waiters */
-                }
+            if (atomic_read(&io->io_err)) {
+                kmem_cache_free(iowcache, iow);
+                continue;
+            }
 
+            assert(iow->iow_index == io->io_index);
+
+            if (io->io_aio) {
+                err = wal_io_submit_async(iow);
+            } else {
+                err = wal_io_submit(iow);
                 atomic_inc(&io->io_comp);
+                kmem_cache_free(iowcache, iow);
             }
 
-            list_del(&iow->iow_list);
-            kmem_cache_free(iowcache, iow);
+            if (err)
+                wal_io_error(io, err);
+        }
+
+        if (io->io_inflightc > 0) {
+            merr_t err;
+
+            /* Block for a completion only if there's no new work to issue */
+            mutex_lock(&io->io_lock);
+            idle = list_empty(&io->io_active);
+            mutex_unlock(&io->io_lock);
+
+            err = mpool_aio_poll(io->io_aio, idle ? 1 : 0);
+            if (ev(err))
+                wal_io_error(io, err);
+
+            wal_io_retire(io);
         }
     }
 }
@@ -206,10 +457,14 @@ wal_io_create(
     struct wal_fileset *wfset,
     uint32_t            index,
     atomic_ulong       *doff,
-    struct wal_iocb    *iocb)
+    struct wal_iocb    *iocb,
+    char               *buf,
+    size_t              bufsz,
+    uint32_t            qdepth)
 {
     struct wal_io *io;
     size_t sz;
+    merr_t err;
 
     sz = sizeof(*io);
     io = aligned_alloc(alignof(*io), sz);
@@ -218,6 +473,7 @@ wal_io_create(
 
     memset(io, 0, sz);
     INIT_LIST_HEAD(&io->io_active);
+    INIT_LIST_HEAD(&io->io_inflight);
     mutex_init(&io->io_lock);
     cv_init(&io->io_cv, "wal_wcv");
     io->io_stop = false;
@@ -231,6 +487,32 @@ wal_io_create(
     io->io_wfset = wfset;
     io->io_cb = iocb;
 
+    /* Fall back to synchronous writes if async io is not available */
+    if (qdepth > 0) {
+        err = mpool_aio_ctx_create(qdepth, &io->io_aio);
+        if (ev(err)) {
+            io->io_aio = NULL;
+        } else {
+            struct iovec iov[WAL_IO_BUFREG_CNT];
+            int iovc;
+
+            /* Registration of the wal buffer is an optimization which may
+             * fail under RLIMIT_MEMLOCK, in which case writes are issued
+             * from unregistered memory.
+             */
+            for (iovc = 0; iovc < NELEM(iov) && bufsz > 0; ++iovc) {
+                iov[iovc].iov_base = buf;
+                iov[iovc].iov_len = min_t(size_t, bufsz, WAL_IO_BUFREG_MAX);
+
+                buf += iov[iovc].iov_len;
+                bufsz -= iov[iovc].iov_len;
+            }
+
+            err = mpool_aio_buffers_register(io->io_aio, iov, iovc);
+            ev(err);
+        }
+    }
+
     INIT_WORK(&io->io_work, wal_io_worker);
     queue_work(iowq, &io->io_work);
 
@@ -251,6 +533,8 @@ wal_io_destroy(struct wal_io *io)
     while (atomic_read(&io->io_stopped) == 0)
         cpu_relax();
 
+    mpool_aio_ctx_destroy(io->io_aio);
+
     mutex_destroy(&io->io_lock);
     cv_destroy(&io->io_cv);
 
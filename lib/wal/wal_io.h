@@ -24,7 +24,10 @@ wal_io_create(
     struct wal_fileset *wfset,
     uint32_t            index,
     atomic_ulong       *doff,
-    struct wal_iocb    *iocb);
+    struct wal_iocb    *iocb,
+    char               *buf,
+    size_t              bufsz,
+    uint32_t            qdepth);
 
 void
 wal_io_destroy(struct wal_io *io);
@@ -371,6 +371,14 @@ wal_rec_unpack_latest(const char *inbuf, struct wal_rechdr *hdr, struct wal_rec
     if (vxlen > 0)
         vdata = PTR_ALIGN((void *)rec->kt.kt_data + klen, kvalign);
     kvs_vtuple_init(&rec->vt, vdata, vxlen);
+
+    if (rec->op == WAL_OP_PUT_TTL) {
+        const void *p = PTR_ALIGN((void *)rec->kt.kt_data + klen, kvalign);
+        uint64_t expire;
+
+        memcpy(&expire, p + ALIGN(kvs_vtuple_vlen(&rec->vt), kvalign), sizeof(expire));
+        rec->vt.vt_expire = omf64_to_cpu(expire);
+    }
 }
 
 void
@@ -535,6 +535,7 @@ wal_replay_gen_impl(struct wal_replay *rep, struct wal_replay_gen *rgen, bool fl
 
         switch (rec->op) {
           case WAL_OP_PUT:
+          case WAL_OP_PUT_TTL:
             err = ikvdb_wal_replay_put(ikvdb, ikvsh, rec->cnid, rec->seqno, kt, vt);
             break;
 
@@ -546,6 +547,17 @@ wal_replay_gen_impl(struct wal_replay *rep, struct wal_replay_gen *rgen, bool fl
             err = ikvdb_wal_replay_prefix_del(ikvdb, ikvsh, rec->cnid, rec->seqno, kt);
             break;
 
+          case WAL_OP_RDEL: {
+            struct kvs_ktuple kt_end;
+
+            /* The end of the range is logged in place of a value */
+            kvs_ktuple_init_nohash(&kt_end, vt->vt_data, vt->vt_xlen);
+            kt_end.kt_flags = flags;
+
+            err = ikvdb_wal_replay_range_del(ikvdb, ikvsh, rec->cnid, rec->seqno, kt, &kt_end);
+            break;
+          }
+
           default:
             err = merr(EINVAL);
             break;
@@ -3,10 +3,14 @@
  * Copyright (C) 2021 Micron Technology, Inc.  All rights reserved.
  */
 
+#include <hse/experimental.h>
+
 #include <mtf/framework.h>
 #include <fixtures/kvdb.h>
 #include <fixtures/kvs.h>
 
+#include <hse_util/base.h>
+
 /* Globals */
 struct hse_kvdb *kvdb_handle = NULL;
 struct hse_kvs * kvs_handle = NULL;
@@ -18,7 +22,12 @@ test_collection_setup(struct mtf_test_info *lcl_ti)
 {
     hse_err_t err;
 
-    err = fxt_kvdb_setup(home, 0, NULL, 0, NULL, &kvdb_handle);
+    /* With durability disabled hse_kvdb_sync() ingests c0 into cn, which
+     * lets tests exercise cursors over kvsets.
+     */
+    const char *rparamv[] = { "durability.enabled=false" };
+
+    err = fxt_kvdb_setup(home, NELEM(rparamv), rparamv, 0, NULL, &kvdb_handle);
 
     return hse_err_to_errno(err);
 }
@@ -417,6 +426,206 @@ MTF_DEFINE_UTEST_PREPOST(cursor_api_test, cursor_read_copy_only_keys, populate_k
     ASSERT_EQ(err, 0);
 }
 
+MTF_DEFINE_UTEST_PREPOST(cursor_api_test, cursor_read_batch, populate_kvs, destroy_kvs)
+{
+    struct hse_kvs_cursor_kv kvv[8];
+    struct hse_kvs_cursor *  cursor;
+    char                     buf[256], key[16], val[16];
+    size_t                   cnt;
+    bool                     eof;
+    hse_err_t                err;
+    int                      i, n;
+
+    err = hse_kvs_cursor_create(kvs_handle, 0, NULL, NULL, 0, &cursor);
+    ASSERT_EQ(err, 0);
+
+    /* TC: A batch read requires a vector of pairs */
+    err = hse_kvs_cursor_read_batch(cursor, 0, buf, sizeof(buf), kvv, 0, &cnt, &eof);
+    ASSERT_EQ(hse_err_to_errno(err), EINVAL);
+
+    /* TC: A batch read fails if the next pair doesn't fit, without consuming it */
+    err = hse_kvs_cursor_read_batch(cursor, 0, buf, 10, kvv, 3, &cnt, &eof);
+    ASSERT_EQ(hse_err_to_errno(err), ENOSPC);
+    ASSERT_EQ(cnt, 0);
+
+    /* TC: A batch read stops at the first pair that doesn't fit */
+    err = hse_kvs_cursor_read_batch(cursor, 0, buf, 30, kvv, 3, &cnt, &eof);
+    ASSERT_EQ(err, 0);
+    ASSERT_FALSE(eof);
+    ASSERT_EQ(cnt, 1);
+
+    /* TC: A batch read stops when the vector of pairs is full */
+    err = hse_kvs_cursor_read_batch(cursor, 0, buf + 30, sizeof(buf) - 30, kvv + 1, 3, &cnt, &eof);
+    ASSERT_EQ(err, 0);
+    ASSERT_FALSE(eof);
+    ASSERT_EQ(cnt, 3);
+
+    for (i = 0; i < 4; i++) {
+        n = snprintf(key, sizeof(key), "test_key_%02d", i);
+        ASSERT_EQ(kvv[i].kv_key_len, n);
+        ASSERT_EQ(0, memcmp(kvv[i].kv_key, key, n));
+
+        n = snprintf(val, sizeof(val), "test_value_%02d", i);
+        ASSERT_EQ(kvv[i].kv_val_len, n);
+        ASSERT_EQ(0, memcmp(kvv[i].kv_val, val, n));
+    }
+
+    /* TC: A keys-only batch read reports value lengths but copies no values */
+    err = hse_kvs_cursor_read_batch(
+        cursor, HSE_CURSOR_READ_KEYS, buf, sizeof(buf), kvv, NELEM(kvv), &cnt, &eof);
+    ASSERT_EQ(err, 0);
+    ASSERT_FALSE(eof);
+    ASSERT_EQ(cnt, key_value_pairs - 4);
+
+    n = snprintf(key, sizeof(key), "test_key_%02d", 4);
+    ASSERT_EQ(kvv[0].kv_key_len, n);
+    ASSERT_EQ(0, memcmp(kvv[0].kv_key, key, n));
+    ASSERT_TRUE(kvv[0].kv_val == NULL);
+    ASSERT_EQ(kvv[0].kv_val_len, strlen("test_value_04"));
+
+    /* TC: A batch read at the end of the cursor reports eof */
+    err = hse_kvs_cursor_read_batch(cursor, 0, buf, sizeof(buf), kvv, NELEM(kvv), &cnt, &eof);
+    ASSERT_EQ(err, 0);
+    ASSERT_TRUE(eof);
+    ASSERT_EQ(cnt, 0);
+
+    err = hse_kvs_cursor_destroy(cursor);
+    ASSERT_EQ(err, 0);
+}
+
+MTF_DEFINE_UTEST_PREPOST(cursor_api_test, cursor_keys_only, populate_kvs, destroy_kvs)
+{
+    int                    count = 0, n;
+    bool                   eof = false;
+    const void *           cur_key, *cur_val;
+    size_t                 cur_klen, cur_vlen;
+    char                   expec_buff[16], valbuf[16];
+    hse_err_t              err;
+    struct hse_kvs_cursor *cursor;
+
+    /* Move the keys into cn so that the values reside in vblocks */
+    err = hse_kvdb_sync(kvdb_handle, 0);
+    ASSERT_EQ(err, 0);
+
+    err = hse_kvs_cursor_create(kvs_handle, HSE_CURSOR_CREATE_KEYS, NULL, NULL, 0, &cursor);
+    ASSERT_EQ(err, 0);
+
+    /* TC: A keys-only cursor returns each key and the length of its value, but no value */
+    while (!eof) {
+        err = hse_kvs_cursor_read(cursor, 0, &cur_key, &cur_klen, &cur_val, &cur_vlen, &eof);
+        ASSERT_EQ(err, 0);
+
+        if (!eof) {
+            n = snprintf(expec_buff, sizeof(expec_buff), "test_key_%02d", count);
+            ASSERT_EQ(cur_klen, n);
+            ASSERT_EQ(memcmp(expec_buff, cur_key, cur_klen), 0);
+
+            n = snprintf(expec_buff, sizeof(expec_buff), "test_value_%02d", count++);
+            ASSERT_EQ(cur_vlen, n);
+            ASSERT_TRUE(cur_val == NULL);
+        }
+    }
+
+    ASSERT_EQ(count, key_value_pairs);
+
+    /* TC: A keys-only cursor copies no value, but reports its length */
+    err = hse_kvs_cursor_seek(cursor, 0, "test_key_00", strlen("test_key_00"), NULL, NULL);
+    ASSERT_EQ(err, 0);
+
+    memset(valbuf, 0, sizeof(valbuf));
+    err = hse_kvs_cursor_read_copy(
+        cursor, 0, expec_buff, sizeof(expec_buff), &cur_klen, valbuf, sizeof(valbuf), &cur_vlen,
+        &eof);
+    ASSERT_EQ(err, 0);
+    ASSERT_FALSE(eof);
+    ASSERT_EQ(cur_vlen, strlen("test_value_00"));
+    ASSERT_EQ(valbuf[0], 0);
+
+    err = hse_kvs_cursor_destroy(cursor);
+    ASSERT_EQ(err, 0);
+}
+
+MTF_DEFINE_UTEST_PREPOST(cursor_api_test, cursor_slices, populate_kvs, destroy_kvs)
+{
+    struct hse_kvs_split_key splitv[3];
+    struct hse_kvs_cursor *  cursorv[NELEM(splitv) + 1];
+    char                     buf[NELEM(splitv) * HSE_KVS_KEY_LEN_MAX], key[16];
+    const void *             cur_key, *cur_val;
+    size_t                   cur_klen, cur_vlen, cnt, i;
+    int                      count = 0, n;
+    bool                     eof;
+    hse_err_t                err;
+
+    err = hse_kvdb_sync(kvdb_handle, 0);
+    ASSERT_EQ(err, 0);
+
+    /* TC: Split keys are in ascending order and within the filter */
+    err = hse_kvs_range_split(
+        kvs_handle, 0, "test", 4, buf, sizeof(buf), splitv, NELEM(splitv), &cnt);
+    ASSERT_EQ(err, 0);
+    ASSERT_LE(cnt, NELEM(splitv));
+
+    for (i = 0; i < cnt; i++) {
+        ASSERT_GE(splitv[i].sk_key_len, 4);
+        ASSERT_EQ(0, memcmp(splitv[i].sk_key, "test", 4));
+        if (i > 0) {
+            size_t len = splitv[i - 1].sk_key_len;
+            int    rc;
+
+            len = len < splitv[i].sk_key_len ? len : splitv[i].sk_key_len;
+            rc = memcmp(splitv[i - 1].sk_key, splitv[i].sk_key, len);
+            ASSERT_TRUE(rc < 0 || (rc == 0 && len < splitv[i].sk_key_len));
+        }
+    }
+
+    /* TC: Split keys must be in strictly ascending order */
+    splitv[0].sk_key = "test_key_03";
+    splitv[0].sk_key_len = strlen(splitv[0].sk_key);
+    splitv[1].sk_key = "test_key_01";
+    splitv[1].sk_key_len = strlen(splitv[1].sk_key);
+
+    err = hse_kvs_cursor_create_slices(kvs_handle, 0, NULL, 0, splitv, 2, cursorv);
+    ASSERT_EQ(hse_err_to_errno(err), EINVAL);
+
+    /* TC: Reverse cursors cannot be bounded to a slice */
+    err = hse_kvs_cursor_create_slices(
+        kvs_handle, HSE_CURSOR_CREATE_REV, NULL, 0, splitv, 1, cursorv);
+    ASSERT_EQ(hse_err_to_errno(err), EINVAL);
+
+    /* TC: Slice cursors together read each key exactly once, in order */
+    splitv[0].sk_key = "test_key_01";
+    splitv[0].sk_key_len = strlen(splitv[0].sk_key);
+    splitv[1].sk_key = "test_key_02";
+    splitv[1].sk_key_len = strlen(splitv[1].sk_key);
+    splitv[2].sk_key = "test_key_03x";
+    splitv[2].sk_key_len = strlen(splitv[2].sk_key);
+
+    err = hse_kvs_cursor_create_slices(kvs_handle, 0, NULL, 0, splitv, NELEM(splitv), cursorv);
+    ASSERT_EQ(err, 0);
+
+    for (i = 0; i < NELEM(cursorv); i++) {
+        eof = false;
+
+        while (!eof) {
+            err = hse_kvs_cursor_read(
+                cursorv[i], 0, &cur_key, &cur_klen, &cur_val, &cur_vlen, &eof);
+            ASSERT_EQ(err, 0);
+
+            if (!eof) {
+                n = snprintf(key, sizeof(key), "test_key_%02d", count++);
+                ASSERT_EQ(cur_klen, n);
+                ASSERT_EQ(0, memcmp(cur_key, key, n));
+            }
+        }
+
+        /* The third slice, [test_key_02, test_key_03x), holds two keys */
+        ASSERT_EQ(count, i < 2 ? i + 1 : (i == 2 ? 4 : key_value_pairs));
+
+        err = hse_kvs_cursor_destroy(cursorv[i]);
+        ASSERT_EQ(err, 0);
+    }
+}
+
 MTF_DEFINE_UTEST(cursor_api_test, cursor_read_copy_with_compression)
 {
     bool eof;
@@ -519,4 +728,167 @@ MTF_DEFINE_UTEST(cursor_api_test, cursor_read_copy_with_compression)
     destroy_kvs(lcl_ti);
 }
 
+/* Keys "<kr_pfx><nn>" for nn from kr_first to kr_last (either direction) */
+struct keyrange {
+    const char *kr_pfx;
+    int         kr_first;
+    int         kr_last;
+};
+
+static int
+put_keyrange(struct mtf_test_info *lcl_ti, struct hse_kvs *kvs, const struct keyrange *kr)
+{
+    hse_err_t err;
+    char      key[16];
+    int       i, n;
+
+    for (i = kr->kr_first; i <= kr->kr_last; i++) {
+        n = snprintf(key, sizeof(key), "%s%02d", kr->kr_pfx, i);
+        ASSERT_LT_RET(n, sizeof(key), -1);
+
+        err = hse_kvs_put(kvs, 0, NULL, key, n, key, n);
+        ASSERT_EQ_RET(err, 0, -1);
+    }
+
+    return 0;
+}
+
+/* Seek to @seek and verify that the cursor returns exactly the keys
+ * of @krv, in order.
+ */
+static int
+verify_seek(
+    struct mtf_test_info * lcl_ti,
+    struct hse_kvs *       kvs,
+    unsigned int           flags,
+    const char *           seek,
+    const struct keyrange *krv,
+    int                    krc)
+{
+    struct hse_kvs_cursor *cursor;
+    const void *           key, *val;
+    size_t                 klen, vlen;
+    char                   expect[16];
+    hse_err_t              err;
+    bool                   eof;
+    int                    i, k, n;
+
+    err = hse_kvs_cursor_create(kvs, flags, NULL, NULL, 0, &cursor);
+    ASSERT_EQ_RET(err, 0, -1);
+
+    err = hse_kvs_cursor_seek(cursor, 0, seek, strlen(seek), NULL, NULL);
+    ASSERT_EQ_RET(err, 0, -1);
+
+    for (i = 0; i < krc; i++) {
+        const struct keyrange *kr = krv + i;
+        int                    step = (kr->kr_first <= kr->kr_last) ? 1 : -1;
+
+        for (k = kr->kr_first; k != kr->kr_last + step; k += step) {
+            n = snprintf(expect, sizeof(expect), "%s%02d", kr->kr_pfx, k);
+            ASSERT_LT_RET(n, sizeof(expect), -1);
+
+            err = hse_kvs_cursor_read(cursor, 0, &key, &klen, &val, &vlen, &eof);
+            ASSERT_EQ_RET(err, 0, -1);
+            ASSERT_FALSE_RET(eof, -1);
+            ASSERT_EQ_RET(klen, n, -1);
+            ASSERT_EQ_RET(memcmp(key, expect, klen), 0, -1);
+            ASSERT_EQ_RET(vlen, n, -1);
+            ASSERT_EQ_RET(memcmp(val, expect, vlen), 0, -1);
+        }
+    }
+
+    err = hse_kvs_cursor_read(cursor, 0, &key, &klen, &val, &vlen, &eof);
+    ASSERT_EQ_RET(err, 0, -1);
+    ASSERT_TRUE_RET(eof, -1);
+
+    err = hse_kvs_cursor_destroy(cursor);
+    ASSERT_EQ_RET(err, 0, -1);
+
+    return 0;
+}
+
+MTF_DEFINE_UTEST(cursor_api_test, cursor_seek_kvsets)
+{
+    const char *           cparamv[] = { "prefix.length=2" };
+    const char *           name = "kvs_cursor_seek_kvsets";
+    const struct keyrange  ab = { "ab", 0, 19 }, cd = { "cd", 0, 19 }, aa = { "aa", 0, 0 };
+    struct hse_kvs *       kvs;
+    hse_err_t              err;
+    int                    rc;
+
+    err = fxt_kvs_setup(kvdb_handle, name, 0, NULL, NELEM(cparamv), cparamv, &kvs);
+    ASSERT_EQ(err, 0);
+
+    /* Ingest "ab00".."ab19" and "cd00".."cd19" into separate kvsets */
+    rc = put_keyrange(lcl_ti, kvs, &ab);
+    ASSERT_EQ(rc, 0);
+    err = hse_kvdb_sync(kvdb_handle, 0);
+    ASSERT_EQ(err, 0);
+
+    rc = put_keyrange(lcl_ti, kvs, &cd);
+    ASSERT_EQ(rc, 0);
+    err = hse_kvdb_sync(kvdb_handle, 0);
+    ASSERT_EQ(err, 0);
+
+    /* TC: A forward seek into the middle of a kvset returns the rest of
+     * that kvset followed by the newer kvset.
+     */
+    {
+        const struct keyrange krv[] = { { "ab", 10, 19 }, { "cd", 0, 19 } };
+
+        rc = verify_seek(lcl_ti, kvs, 0, "ab10", krv, NELEM(krv));
+        ASSERT_EQ(rc, 0);
+    }
+
+    /* TC: A forward seek past the end of the older kvset returns only
+     * keys from the newer kvset.
+     */
+    {
+        const struct keyrange krv[] = { { "cd", 5, 19 } };
+
+        rc = verify_seek(lcl_ti, kvs, 0, "cd05", krv, NELEM(krv));
+        ASSERT_EQ(rc, 0);
+    }
+
+    /* TC: A reverse seek before the start of the newer kvset returns
+     * only keys from the older kvset.
+     */
+    {
+        const struct keyrange krv[] = { { "ab", 10, 0 } };
+
+        rc = verify_seek(lcl_ti, kvs, HSE_CURSOR_CREATE_REV, "ab10", krv, NELEM(krv));
+        ASSERT_EQ(rc, 0);
+    }
+
+    /* Ingest a kvset whose only key "aa00" sorts before prefix tombstone
+     * "ab", so its max key precedes every key the ptomb deletes.
+     */
+    err = hse_kvs_prefix_delete(kvs, 0, NULL, "ab", 2);
+    ASSERT_EQ(err, 0);
+    rc = put_keyrange(lcl_ti, kvs, &aa);
+    ASSERT_EQ(rc, 0);
+    err = hse_kvdb_sync(kvdb_handle, 0);
+    ASSERT_EQ(err, 0);
+
+    /* TC: A seek past the max key of a kvset with a ptomb still applies
+     * the ptomb to the keys it covers in older kvsets.
+     */
+    {
+        const struct keyrange krv[] = { { "cd", 0, 19 } };
+
+        rc = verify_seek(lcl_ti, kvs, 0, "ab05", krv, NELEM(krv));
+        ASSERT_EQ(rc, 0);
+    }
+
+    {
+        const struct keyrange krv[] = { { "aa", 0, 0 } };
+
+        rc = verify_seek(lcl_ti, kvs, HSE_CURSOR_CREATE_REV, "ab15", krv, NELEM(krv));
+        ASSERT_EQ(rc, 0);
+    }
+
+    err = fxt_kvs_teardown(kvdb_handle, name, kvs);
+    ASSERT_EQ(err, 0);
+}
+
 MTF_END_UTEST_COLLECTION(cursor_api_test)
@@ -5,7 +5,14 @@
 
 #include <mtf/framework.h>
 #include <errno.h>
+#include <pthread.h>
 #include <fixtures/kvdb.h>
+#include <fixtures/kvs.h>
+
+#include <hse/hse.h>
+#include <hse/limits.h>
+
+#include <hse_util/base.h>
 
 /* Globals */
 struct hse_kvdb *kvdb_handle;
@@ -51,4 +58,142 @@ MTF_DEFINE_UTEST(kvdb_api, kvdb_close)
     ASSERT_EQ(hse_err_to_errno(err), EINVAL);
 }
 
+#define PUT_SYNC_THREADS 4
+#define PUT_SYNC_KEYS    100
+
+struct put_sync_arg {
+    struct hse_kvs *kvs;
+    int             id;
+    hse_err_t       err;
+};
+
+static void *
+put_sync_worker(void *rock)
+{
+    struct put_sync_arg *arg = rock;
+    char                 key[32];
+    int                  klen, i;
+
+    for (i = 0; i < PUT_SYNC_KEYS; i++) {
+        klen = snprintf(key, sizeof(key), "sync%d-%04d", arg->id, i);
+
+        arg->err = hse_kvs_put(arg->kvs, HSE_KVS_PUT_SYNC, NULL, key, klen, key, klen);
+        if (arg->err)
+            break;
+    }
+
+    return NULL;
+}
+
+MTF_DEFINE_UTEST(kvdb_api, kvs_put_sync)
+{
+    const char *        rparamv[] = { "durability.sync_latency_us=1000", "durability.aio_qdepth=8" };
+    const char *        kvs_name = "kvdb-api-put-sync";
+    struct put_sync_arg argv[PUT_SYNC_THREADS];
+    pthread_t           tidv[PUT_SYNC_THREADS];
+    struct hse_kvs *    kvs;
+    char                key[32], vbuf[32];
+    char *              bigval;
+    size_t              vlen;
+    bool                found;
+    hse_err_t           err;
+    int                 pass, klen, rc, i, j;
+
+    bigval = malloc(HSE_KVS_VALUE_LEN_MAX);
+    ASSERT_NE(NULL, bigval);
+
+    for (i = 0; i < HSE_KVS_VALUE_LEN_MAX; i++)
+        bigval[i] = i % 251;
+
+    /* The first pass uses the default of flushing each sync immediately,
+     * the second one batches concurrent syncs to meet a latency target,
+     * and the third one writes the WAL asynchronously.
+     */
+    for (pass = 0; pass < 3; pass++) {
+        if (pass > 0) {
+            err = hse_kvdb_close(kvdb_handle);
+            ASSERT_EQ(err, 0);
+
+            err = hse_kvdb_open(home, 1, &rparamv[pass - 1], &kvdb_handle);
+            ASSERT_EQ(err, 0);
+        }
+
+        err = fxt_kvs_setup(kvdb_handle, kvs_name, 0, NULL, 0, NULL, &kvs);
+        ASSERT_EQ(err, 0);
+
+        /* TC: A sync put is visible when it returns */
+        err = hse_kvs_put(kvs, HSE_KVS_PUT_SYNC, NULL, "sync", 4, "val", 3);
+        ASSERT_EQ(err, 0);
+
+        err = hse_kvs_get(kvs, 0, NULL, "sync", 4, &found, vbuf, sizeof(vbuf), &vlen);
+        ASSERT_EQ(err, 0);
+        ASSERT_TRUE(found);
+        ASSERT_EQ(vlen, 3);
+
+        /* TC: Sync puts of max length values, whose WAL writes are split */
+        for (i = 0; i < 4; i++) {
+            klen = snprintf(key, sizeof(key), "big%d", i);
+
+            err = hse_kvs_put(
+                kvs, HSE_KVS_PUT_SYNC, NULL, key, klen, bigval, HSE_KVS_VALUE_LEN_MAX - i);
+            ASSERT_EQ(err, 0);
+        }
+
+        /* TC: Concurrent sync puts all complete */
+        for (i = 0; i < PUT_SYNC_THREADS; i++) {
+            argv[i].kvs = kvs;
+            argv[i].id = i;
+            argv[i].err = 0;
+
+            rc = pthread_create(&tidv[i], NULL, put_sync_worker, &argv[i]);
+            ASSERT_EQ(rc, 0);
+        }
+
+        for (i = 0; i < PUT_SYNC_THREADS; i++) {
+            rc = pthread_join(tidv[i], NULL);
+            ASSERT_EQ(rc, 0);
+            ASSERT_EQ(argv[i].err, 0);
+        }
+
+        /* TC: The puts survive a close and reopen with default params */
+        if (pass == 2) {
+            err = hse_kvdb_close(kvdb_handle);
+            ASSERT_EQ(err, 0);
+
+            err = hse_kvdb_open(home, 0, NULL, &kvdb_handle);
+            ASSERT_EQ(err, 0);
+
+            err = hse_kvdb_kvs_open(kvdb_handle, kvs_name, 0, NULL, &kvs);
+            ASSERT_EQ(err, 0);
+        }
+
+        for (i = 0; i < PUT_SYNC_THREADS; i++) {
+            for (j = 0; j < PUT_SYNC_KEYS; j++) {
+                klen = snprintf(key, sizeof(key), "sync%d-%04d", i, j);
+
+                err = hse_kvs_get(kvs, 0, NULL, key, klen, &found, vbuf, sizeof(vbuf), &vlen);
+                ASSERT_EQ(err, 0);
+                ASSERT_TRUE(found);
+                ASSERT_EQ(vlen, klen);
+                ASSERT_EQ(memcmp(vbuf, key, klen), 0);
+            }
+        }
+
+        for (i = 0; i < 4; i++) {
+            klen = snprintf(key, sizeof(key), "big%d", i);
+
+            err = hse_kvs_get(kvs, 0, NULL, key, klen, &found, vbuf, sizeof(vbuf), &vlen);
+            ASSERT_EQ(err, 0);
+            ASSERT_TRUE(found);
+            ASSERT_EQ(vlen, HSE_KVS_VALUE_LEN_MAX - i);
+            ASSERT_EQ(memcmp(vbuf, bigval, sizeof(vbuf)), 0);
+        }
+
+        err = fxt_kvs_teardown(kvdb_handle, kvs_name, kvs);
+        ASSERT_EQ(err, 0);
+    }
+
+    free(bigval);
+}
+
 MTF_END_UTEST_COLLECTION(kvdb_api)
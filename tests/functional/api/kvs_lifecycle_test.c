@@ -3,11 +3,15 @@
  * Copyright (C) 2021 Micron Technology, Inc.  All rights reserved.
  */
 
+#include <hse/experimental.h>
+
 #include <mtf/framework.h>
 #include <fixtures/kvdb.h>
 #include <fixtures/kvs.h>
 #include <errno.h>
 
+#include <hse_util/base.h>
+
 /* Globals */
 struct hse_kvdb *kvdb_handle = NULL;
 struct hse_kvs * kvs_handle = NULL;
@@ -18,7 +22,11 @@ test_collection_setup(struct mtf_test_info *lcl_ti)
 {
     hse_err_t err;
 
-    err = fxt_kvdb_setup(home, 0, NULL, 0, NULL, &kvdb_handle);
+    /* With durability disabled hse_kvdb_sync() ingests c0 into cn.
+     */
+    const char *rparamv[] = { "durability.enabled=false" };
+
+    err = fxt_kvdb_setup(home, NELEM(rparamv), rparamv, 0, NULL, &kvdb_handle);
 
     return hse_err_to_errno(err);
 }
@@ -147,4 +155,165 @@ MTF_DEFINE_UTEST_PREPOST(kvs_api, kvs_valid_handle, kvs_setup, kvs_teardown)
     ASSERT_EQ(found, false);
 }
 
+MTF_DEFINE_UTEST_PREPOST(kvs_api, kvs_bulk_load, kvs_setup, kvs_teardown)
+{
+    struct hse_kvs_bulk *bulk;
+    hse_err_t            err;
+    char                 kbuf[32], vbuf[32], gbuf[32];
+    size_t               klen, vlen;
+    bool                 found;
+    int                  i;
+    const int            nkeys = 10000;
+
+    /* TC: Keys must be strictly ascending */
+    err = hse_kvs_bulk_create(kvs_handle, 0, &bulk);
+    ASSERT_EQ(err, 0);
+    err = hse_kvs_bulk_put(bulk, "key2", 4, "val", 3);
+    ASSERT_EQ(err, 0);
+    err = hse_kvs_bulk_put(bulk, "key1", 4, "val", 3);
+    ASSERT_EQ(hse_err_to_errno(err), EINVAL);
+    err = hse_kvs_bulk_put(bulk, "key2", 4, "val", 3);
+    ASSERT_EQ(hse_err_to_errno(err), EINVAL);
+
+    /* TC: A failed load cannot be committed */
+    err = hse_kvs_bulk_commit(bulk);
+    ASSERT_EQ(hse_err_to_errno(err), EINVAL);
+    hse_kvs_bulk_destroy(bulk);
+
+    /* TC: A committed load is visible in its entirety */
+    err = hse_kvs_bulk_create(kvs_handle, 0, &bulk);
+    ASSERT_EQ(err, 0);
+    for (i = 0; i < nkeys; i++) {
+        klen = snprintf(kbuf, sizeof(kbuf), "key%08d", i);
+        vlen = snprintf(vbuf, sizeof(vbuf), "val%d", i);
+        err = hse_kvs_bulk_put(bulk, kbuf, klen, vbuf, vlen);
+        ASSERT_EQ(err, 0);
+    }
+
+    err = hse_kvs_get(kvs_handle, 0, NULL, "key00000000", 11, &found, gbuf, sizeof(gbuf), &vlen);
+    ASSERT_EQ(err, 0);
+    ASSERT_EQ(found, false);
+
+    err = hse_kvs_bulk_commit(bulk);
+    ASSERT_EQ(err, 0);
+
+    /* TC: A load can only be committed once */
+    err = hse_kvs_bulk_commit(bulk);
+    ASSERT_EQ(hse_err_to_errno(err), EINVAL);
+    hse_kvs_bulk_destroy(bulk);
+
+    for (i = 0; i < nkeys; i++) {
+        klen = snprintf(kbuf, sizeof(kbuf), "key%08d", i);
+        snprintf(vbuf, sizeof(vbuf), "val%d", i);
+        err = hse_kvs_get(kvs_handle, 0, NULL, kbuf, klen, &found, gbuf, sizeof(gbuf), &vlen);
+        ASSERT_EQ(err, 0);
+        ASSERT_EQ(found, true);
+        ASSERT_EQ(vlen, strlen(vbuf));
+        ASSERT_EQ(memcmp(gbuf, vbuf, vlen), 0);
+    }
+
+    /* TC: Puts supersede loaded keys */
+    err = hse_kvs_put(kvs_handle, 0, NULL, "key00000000", 11, "new", 3);
+    ASSERT_EQ(err, 0);
+    err = hse_kvs_get(kvs_handle, 0, NULL, "key00000000", 11, &found, gbuf, sizeof(gbuf), &vlen);
+    ASSERT_EQ(err, 0);
+    ASSERT_EQ(found, true);
+    ASSERT_EQ(vlen, 3);
+    ASSERT_EQ(memcmp(gbuf, "new", 3), 0);
+
+    /* TC: A non-empty KVS cannot be loaded */
+    err = hse_kvs_bulk_create(kvs_handle, 0, &bulk);
+    ASSERT_EQ(hse_err_to_errno(err), EBUSY);
+
+    /* TC: Destroying a NULL loader is a no-op */
+    hse_kvs_bulk_destroy(NULL);
+}
+
+MTF_DEFINE_UTEST_PREPOST(kvs_api, kvs_bulk_load_uningested, kvs_setup, kvs_teardown)
+{
+    struct hse_kvs_bulk *bulk;
+    hse_err_t            err;
+
+    /* TC: A load is refused while a put has yet to be ingested */
+    err = hse_kvs_bulk_create(kvs_handle, 0, &bulk);
+    ASSERT_EQ(err, 0);
+    err = hse_kvs_bulk_put(bulk, "key1", 4, "load", 4);
+    ASSERT_EQ(err, 0);
+
+    err = hse_kvs_put(kvs_handle, 0, NULL, "key2", 4, "put", 3);
+    ASSERT_EQ(err, 0);
+
+    err = hse_kvs_bulk_commit(bulk);
+    ASSERT_EQ(hse_err_to_errno(err), EBUSY);
+    hse_kvs_bulk_destroy(bulk);
+
+    err = hse_kvs_bulk_create(kvs_handle, 0, &bulk);
+    ASSERT_EQ(hse_err_to_errno(err), EBUSY);
+
+    /* TC: Loading behind is unaffected */
+    err = hse_kvs_bulk_create(kvs_handle, HSE_KVS_BULK_BEHIND, &bulk);
+    ASSERT_EQ(err, 0);
+    hse_kvs_bulk_destroy(bulk);
+}
+
+MTF_DEFINE_UTEST_PREPOST(kvs_api, kvs_bulk_load_behind, kvs_setup, kvs_teardown)
+{
+    struct hse_kvs_bulk *bulk, *bulk2;
+    hse_err_t            err;
+    char                 kbuf[32], gbuf[32];
+    size_t               klen, vlen;
+    bool                 found;
+    int                  i;
+    const int            nkeys = 10000;
+
+    /* Put every tenth key and move them from c0 into cn */
+    for (i = 0; i < nkeys; i += 10) {
+        klen = snprintf(kbuf, sizeof(kbuf), "key%08d", i);
+        err = hse_kvs_put(kvs_handle, 0, NULL, kbuf, klen, "put", 3);
+        ASSERT_EQ(err, 0);
+    }
+
+    err = hse_kvdb_sync(kvdb_handle, 0);
+    ASSERT_EQ(err, 0);
+
+    /* TC: A live KVS can be loaded behind its data */
+    err = hse_kvs_bulk_create(kvs_handle, HSE_KVS_BULK_BEHIND, &bulk);
+    ASSERT_EQ(err, 0);
+
+    /* TC: Only one loader at a time may link behind a KVS */
+    err = hse_kvs_bulk_create(kvs_handle, HSE_KVS_BULK_BEHIND, &bulk2);
+    ASSERT_EQ(hse_err_to_errno(err), EBUSY);
+
+    for (i = 0; i < nkeys; i++) {
+        klen = snprintf(kbuf, sizeof(kbuf), "key%08d", i);
+        err = hse_kvs_bulk_put(bulk, kbuf, klen, "load", 4);
+        ASSERT_EQ(err, 0);
+    }
+
+    /* TC: The KVS remains writable while a load is built */
+    err = hse_kvs_put(kvs_handle, 0, NULL, "key00000001", 11, "put", 3);
+    ASSERT_EQ(err, 0);
+
+    err = hse_kvs_bulk_commit(bulk);
+    ASSERT_EQ(err, 0);
+    hse_kvs_bulk_destroy(bulk);
+
+    /* TC: Loaded keys are visible only where the KVS had no other version */
+    for (i = 0; i < nkeys; i++) {
+        const char *val = (i % 10 == 0 || i == 1) ? "put" : "load";
+
+        klen = snprintf(kbuf, sizeof(kbuf), "key%08d", i);
+        err = hse_kvs_get(kvs_handle, 0, NULL, kbuf, klen, &found, gbuf, sizeof(gbuf), &vlen);
+        ASSERT_EQ(err, 0);
+        ASSERT_EQ(found, true);
+        ASSERT_EQ(vlen, strlen(val));
+        ASSERT_EQ(memcmp(gbuf, val, vlen), 0);
+    }
+
+    /* TC: The loader is released once destroyed */
+    err = hse_kvs_bulk_create(kvs_handle, HSE_KVS_BULK_BEHIND, &bulk);
+    ASSERT_EQ(err, 0);
+    hse_kvs_bulk_destroy(bulk);
+}
+
 MTF_END_UTEST_COLLECTION(kvs_api)
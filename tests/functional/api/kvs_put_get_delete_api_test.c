@@ -3,7 +3,12 @@
  * Copyright (C) 2021 Micron Technology, Inc.  All rights reserved.
  */
 
+#include <unistd.h>
+
 #include <hse/hse.h>
+#include <hse/experimental.h>
+
+#include <hse_util/base.h>
 
 #include <mtf/framework.h>
 #include <fixtures/kvdb.h>
@@ -44,7 +49,13 @@ test_collection_setup(struct mtf_test_info *lcl_ti)
 {
     hse_err_t err;
 
-    err = fxt_kvdb_setup(home, 0, NULL, 0, NULL, &kvdb);
+    /* With durability disabled hse_kvdb_sync() ingests c0 into cn, and the
+     * root node spills each kvset it receives, which lets tests exercise
+     * lookups, cursors and compaction over kvsets.
+     */
+    const char *rparamv[] = { "durability.enabled=false", "csched_rspill_params=257" };
+
+    err = fxt_kvdb_setup(home, NELEM(rparamv), rparamv, 0, NULL, &kvdb);
     ASSERT_EQ_RET(err, 0, hse_err_to_errno(err));
 
     err = fxt_kvs_setup(kvdb, kvs_name, 0, NULL, 0, NULL, &kvs);
@@ -119,4 +130,352 @@ MTF_DEFINE_UTEST(put_get_delete, kvs_put_get_delete)
     ASSERT_EQ(found, false);
 }
 
+MTF_DEFINE_UTEST(put_get_delete, kvs_get_multi)
+{
+    hse_err_t    err;
+    struct tuple tupv[8];
+    const void * keys[8];
+    size_t       key_lens[8];
+    void *       bufs[8];
+    size_t       buf_lens[8];
+    size_t       val_lens[8];
+    bool         found[8];
+    const char * prefix = "MULTI";
+    int          i, rc;
+
+    for (i = 0; i < 8; i++) {
+        rc = make_tuple(lcl_ti, &tupv[i], prefix, i);
+        ASSERT_EQ(rc, 0);
+
+        /* Only store the even keys so that half the batch misses */
+        if (i % 2 == 0) {
+            err = hse_kvs_put(kvs, 0, NULL, tupv[i].key, tupv[i].klen, tupv[i].putval, tupv[i].vlen);
+            ASSERT_EQ(err, 0);
+        }
+
+        memset(tupv[i].getval, 0, sizeof(tupv[i].getval));
+
+        keys[i] = tupv[i].key;
+        key_lens[i] = tupv[i].klen;
+        bufs[i] = tupv[i].getval;
+        buf_lens[i] = sizeof(tupv[i].getval);
+    }
+
+    /* TC: A batched get with an invalid count fails */
+    err = hse_kvs_get_multi(kvs, 0, NULL, 0, keys, key_lens, found, bufs, buf_lens, val_lens);
+    ASSERT_EQ(hse_err_to_errno(err), EINVAL);
+
+    /* TC: A batched get with a NULL key fails */
+    keys[3] = NULL;
+    err = hse_kvs_get_multi(kvs, 0, NULL, 8, keys, key_lens, found, bufs, buf_lens, val_lens);
+    ASSERT_EQ(hse_err_to_errno(err), EINVAL);
+    keys[3] = tupv[3].key;
+
+    /* TC: A batched get returns the same results as individual gets */
+    err = hse_kvs_get_multi(kvs, 0, NULL, 8, keys, key_lens, found, bufs, buf_lens, val_lens);
+    ASSERT_EQ(err, 0);
+
+    for (i = 0; i < 8; i++) {
+        ASSERT_EQ(found[i], i % 2 == 0);
+        if (found[i]) {
+            ASSERT_EQ(val_lens[i], tupv[i].vlen);
+            ASSERT_EQ(memcmp(tupv[i].getval, tupv[i].putval, tupv[i].vlen), 0);
+        }
+    }
+
+    /* TC: A batched get without buffers probes for existence and value length */
+    err = hse_kvs_get_multi(kvs, 0, NULL, 8, keys, key_lens, found, NULL, NULL, val_lens);
+    ASSERT_EQ(err, 0);
+
+    for (i = 0; i < 8; i++) {
+        ASSERT_EQ(found[i], i % 2 == 0);
+        if (found[i])
+            ASSERT_EQ(val_lens[i], tupv[i].vlen);
+    }
+}
+
+MTF_DEFINE_UTEST(put_get_delete, kvs_get_pinned)
+{
+    hse_err_t           err;
+    char                vbuf[VAL_LEN_MAX];
+    const void *        val;
+    size_t              vlen;
+    bool                found;
+    struct hse_kvs_pin *pin;
+    const char          test_key[] = "pinned_key";
+    const char          test_value[] = "pinned_value";
+    size_t              klen = sizeof(test_key) - 1;
+    size_t              vallen = sizeof(test_value) - 1;
+
+    err = hse_kvs_put(kvs, 0, NULL, test_key, klen, test_value, vallen);
+    ASSERT_EQ(err, 0);
+
+    /* TC: A pinned get without a pin handle fails */
+    err = hse_kvs_get_pinned(
+        kvs, 0, NULL, test_key, klen, &found, vbuf, sizeof(vbuf), &val, &vlen, NULL);
+    ASSERT_EQ(hse_err_to_errno(err), EINVAL);
+
+    /* TC: An uncompressed value is returned by reference rather than copied */
+    memset(vbuf, 0, sizeof(vbuf));
+    err = hse_kvs_get_pinned(
+        kvs, 0, NULL, test_key, klen, &found, vbuf, sizeof(vbuf), &val, &vlen, &pin);
+    ASSERT_EQ(err, 0);
+    ASSERT_EQ(found, true);
+    ASSERT_EQ(vlen, vallen);
+    ASSERT_NE(pin, NULL);
+    ASSERT_NE(val, (const void *)vbuf);
+    ASSERT_EQ(memcmp(val, test_value, vlen), 0);
+
+    hse_kvs_pin_release(pin);
+
+    /* TC: A pinned get of a missing key neither pins nor returns a value */
+    err = hse_kvs_delete(kvs, 0, NULL, test_key, klen);
+    ASSERT_EQ(err, 0);
+    err = hse_kvs_get_pinned(
+        kvs, 0, NULL, test_key, klen, &found, vbuf, sizeof(vbuf), &val, &vlen, &pin);
+    ASSERT_EQ(err, 0);
+    ASSERT_EQ(found, false);
+    ASSERT_EQ(pin, NULL);
+    ASSERT_EQ(val, NULL);
+
+    /* TC: Releasing a NULL pin is a no-op */
+    hse_kvs_pin_release(NULL);
+}
+
+static int
+range_count(struct mtf_test_info *lcl_ti, const char *prefix)
+{
+    struct hse_kvs_cursor *cur;
+    const void *           key, *val;
+    size_t                 klen, vlen;
+    bool                   eof = false;
+    hse_err_t              err;
+    int                    cnt = 0;
+
+    err = hse_kvs_cursor_create(kvs, 0, NULL, prefix, strlen(prefix), &cur);
+    ASSERT_EQ_RET(err, 0, -1);
+
+    while (true) {
+        err = hse_kvs_cursor_read(cur, 0, &key, &klen, &val, &vlen, &eof);
+        ASSERT_EQ_RET(err, 0, -1);
+        if (eof)
+            break;
+        cnt++;
+    }
+
+    hse_kvs_cursor_destroy(cur);
+
+    return cnt;
+}
+
+/* Wait up to 10 seconds for the number of keys with the given prefix to
+ * reach expect, as values put with a ttl expire asynchronously.
+ */
+static int
+range_count_wait(struct mtf_test_info *lcl_ti, const char *prefix, int expect)
+{
+    int cnt = -1, i;
+
+    for (i = 0; i < 100; i++) {
+        cnt = range_count(lcl_ti, prefix);
+        if (cnt == expect || cnt < 0)
+            break;
+
+        usleep(100 * 1000);
+    }
+
+    return cnt;
+}
+
+MTF_DEFINE_UTEST(put_get_delete, kvs_range_delete)
+{
+    const char * prefix = "RDEL";
+    struct tuple tup, kmin, kmax;
+    char         vbuf[VAL_LEN_MAX];
+    size_t       vlen;
+    bool         found;
+    hse_err_t    err;
+    int          rc, i;
+
+    for (i = 10; i < 30; i++) {
+        rc = make_tuple(lcl_ti, &tup, prefix, i);
+        ASSERT_EQ(rc, 0);
+
+        err = hse_kvs_put(kvs, 0, NULL, tup.key, tup.klen, tup.putval, tup.vlen);
+        ASSERT_EQ(err, 0);
+    }
+
+    /* Ingest the keys so that the range tombstone must hide keys in
+     * an older cn kvset rather than in c0.
+     */
+    err = hse_kvdb_sync(kvdb, 0);
+    ASSERT_EQ(err, 0);
+
+    rc = make_tuple(lcl_ti, &kmin, prefix, 15);
+    ASSERT_EQ(rc, 0);
+    rc = make_tuple(lcl_ti, &kmax, prefix, 20);
+    ASSERT_EQ(rc, 0);
+
+    /* TC: A range delete requires a non-empty range */
+    err = hse_kvs_range_delete(kvs, 0, kmax.key, kmax.klen, kmin.key, kmin.klen);
+    ASSERT_EQ(hse_err_to_errno(err), EINVAL);
+    err = hse_kvs_range_delete(kvs, 0, kmin.key, kmin.klen, kmin.key, kmin.klen);
+    ASSERT_EQ(hse_err_to_errno(err), EINVAL);
+    err = hse_kvs_range_delete(kvs, 0, NULL, 0, kmax.key, kmax.klen);
+    ASSERT_EQ(hse_err_to_errno(err), EINVAL);
+
+    /* TC: A range delete hides the keys in [kmin, kmax) from gets and cursors */
+    err = hse_kvs_range_delete(kvs, 0, kmin.key, kmin.klen, kmax.key, kmax.klen);
+    ASSERT_EQ(err, 0);
+
+    for (int pass = 0; pass < 3; pass++) {
+        for (i = 10; i < 30; i++) {
+            rc = make_tuple(lcl_ti, &tup, prefix, i);
+            ASSERT_EQ(rc, 0);
+
+            err = hse_kvs_get(kvs, 0, NULL, tup.key, tup.klen, &found, vbuf, sizeof(vbuf), &vlen);
+            ASSERT_EQ(err, 0);
+            ASSERT_EQ(found, i < 15 || i >= 20);
+        }
+
+        ASSERT_EQ(range_count(lcl_ti, prefix), 15);
+
+        /* TC: The range tombstone persists when c0 is ingested into cn,
+         * and when the root spills it and compaction merges the kvsets.
+         */
+        if (pass == 0) {
+            err = hse_kvdb_sync(kvdb, 0);
+            ASSERT_EQ(err, 0);
+        } else if (pass == 1) {
+            err = hse_kvdb_compact(kvdb, HSE_KVDB_COMPACT_SAMP_LWM);
+            ASSERT_EQ(err, 0);
+        }
+    }
+
+    /* TC: A key put after a range delete is visible */
+    rc = make_tuple(lcl_ti, &tup, prefix, 17);
+    ASSERT_EQ(rc, 0);
+
+    err = hse_kvs_put(kvs, 0, NULL, tup.key, tup.klen, tup.putval, tup.vlen);
+    ASSERT_EQ(err, 0);
+
+    err = hse_kvs_get(kvs, 0, NULL, tup.key, tup.klen, &found, vbuf, sizeof(vbuf), &vlen);
+    ASSERT_EQ(err, 0);
+    ASSERT_EQ(found, true);
+    ASSERT_EQ(vlen, tup.vlen);
+    ASSERT_EQ(memcmp(vbuf, tup.putval, vlen), 0);
+
+    ASSERT_EQ(range_count(lcl_ti, prefix), 16);
+
+    /* TC: The newer key stays visible once it too is ingested */
+    err = hse_kvdb_sync(kvdb, 0);
+    ASSERT_EQ(err, 0);
+
+    err = hse_kvs_get(kvs, 0, NULL, tup.key, tup.klen, &found, vbuf, sizeof(vbuf), &vlen);
+    ASSERT_EQ(err, 0);
+    ASSERT_EQ(found, true);
+
+    ASSERT_EQ(range_count(lcl_ti, prefix), 16);
+}
+
+static void
+verify_ttl(struct mtf_test_info *lcl_ti, const char *prefix, int cnt, bool (*expect)(int))
+{
+    struct tuple tup;
+    char         vbuf[VAL_LEN_MAX];
+    size_t       vlen;
+    bool         found;
+    hse_err_t    err;
+    int          rc, i;
+
+    for (i = 0; i < cnt; i++) {
+        rc = make_tuple(lcl_ti, &tup, prefix, i);
+        ASSERT_EQ(rc, 0);
+
+        err = hse_kvs_get(kvs, 0, NULL, tup.key, tup.klen, &found, vbuf, sizeof(vbuf), &vlen);
+        ASSERT_EQ(err, 0);
+        ASSERT_EQ(found, expect(i));
+
+        if (found) {
+            ASSERT_EQ(vlen, tup.vlen);
+            ASSERT_EQ(memcmp(vbuf, tup.putval, vlen), 0);
+        }
+    }
+}
+
+static bool
+ttl_live(int i)
+{
+    /* Odd keys below 10 expire after an hour, all the others after a second */
+    return i < 10 && i % 2;
+}
+
+MTF_DEFINE_UTEST(put_get_delete, kvs_put_ttl)
+{
+    const char * prefix = "TTL";
+    struct tuple tup;
+    hse_err_t    err;
+    int          rc, i;
+
+    rc = make_tuple(lcl_ti, &tup, prefix, 0);
+    ASSERT_EQ(rc, 0);
+
+    /* TC: A put with a ttl requires a non-zero ttl */
+    err = hse_kvs_put_ttl(kvs, 0, NULL, tup.key, tup.klen, tup.putval, tup.vlen, 0);
+    ASSERT_EQ(hse_err_to_errno(err), EINVAL);
+
+    for (i = 0; i < 10; i++) {
+        rc = make_tuple(lcl_ti, &tup, prefix, i);
+        ASSERT_EQ(rc, 0);
+
+        err = hse_kvs_put_ttl(
+            kvs, 0, NULL, tup.key, tup.klen, tup.putval, tup.vlen, ttl_live(i) ? 3600 : 1);
+        ASSERT_EQ(err, 0);
+    }
+
+    ASSERT_EQ(range_count(lcl_ti, prefix), 10);
+
+    /* Ingest the first batch into cn, where the root spill carries the
+     * expiration times into the leaves, and leave the second one in c0.
+     */
+    err = hse_kvdb_sync(kvdb, 0);
+    ASSERT_EQ(err, 0);
+
+    for (i = 10; i < 12; i++) {
+        rc = make_tuple(lcl_ti, &tup, prefix, i);
+        ASSERT_EQ(rc, 0);
+
+        err = hse_kvs_put_ttl(kvs, 0, NULL, tup.key, tup.klen, tup.putval, tup.vlen, 1);
+        ASSERT_EQ(err, 0);
+    }
+
+    /* TC: Expired values are hidden from gets and cursors in both c0 and cn */
+    ASSERT_EQ(range_count_wait(lcl_ti, prefix, 5), 5);
+    verify_ttl(lcl_ti, prefix, 12, ttl_live);
+
+    /* TC: Expired values stay hidden once ingested and compacted, as
+     * tombstones in cn
+     */
+    err = hse_kvdb_sync(kvdb, 0);
+    ASSERT_EQ(err, 0);
+
+    err = hse_kvdb_compact(kvdb, HSE_KVDB_COMPACT_SAMP_LWM);
+    ASSERT_EQ(err, 0);
+
+    ASSERT_EQ(range_count(lcl_ti, prefix), 5);
+    verify_ttl(lcl_ti, prefix, 12, ttl_live);
+
+    /* TC: A put without a ttl replaces an expired value */
+    rc = make_tuple(lcl_ti, &tup, prefix, 0);
+    ASSERT_EQ(rc, 0);
+
+    err = hse_kvs_put(kvs, 0, NULL, tup.key, tup.klen, tup.putval, tup.vlen);
+    ASSERT_EQ(err, 0);
+
+    err = hse_kvdb_sync(kvdb, 0);
+    ASSERT_EQ(err, 0);
+
+    ASSERT_EQ(range_count(lcl_ti, prefix), 6);
+}
+
 MTF_END_UTEST_COLLECTION(put_get_delete)
@@ -482,6 +482,7 @@ _cn_cursor_create(
     struct cn *            cn,
     u64                    seqno,
     bool                   reverse,
+    bool                   keys_only,
     const void *           prefix,
     u32                    pfx_len,
     struct cursor_summary *summary,
@@ -663,6 +664,7 @@ static struct mapi_injection cn_inject_list[] = {
     { mapi_idx_cn_get_ingest_perfc,  MAPI_RC_PTR, NULL },
 
     { mapi_idx_cn_tree_cursor_prepare,  MAPI_RC_SCALAR, 0 },
+    { mapi_idx_cn_cursor_rtombs,        MAPI_RC_SCALAR, 0 },
 
     { -1 },
 };
@@ -729,6 +731,7 @@ static struct mapi_injection c0_inject_list[] = {
     { mapi_idx_c0_cursor_update,    MAPI_RC_SCALAR, 0 },
     { mapi_idx_c0_cursor_bind_txn,  MAPI_RC_SCALAR, 0 },
     { mapi_idx_c0_cursor_prepare,   MAPI_RC_SCALAR, 0 },
+    { mapi_idx_c0_cursor_rtombs,    MAPI_RC_SCALAR, 0 },
     { -1 },
 };
 
@@ -919,6 +922,7 @@ static struct mapi_injection wal_inject_list[] = {
     { mapi_idx_wal_put,        MAPI_RC_SCALAR, 0 },
     { mapi_idx_wal_del,        MAPI_RC_SCALAR, 0 },
     { mapi_idx_wal_del_pfx,    MAPI_RC_SCALAR, 0 },
+    { mapi_idx_wal_del_range,  MAPI_RC_SCALAR, 0 },
     { mapi_idx_wal_txn_begin,  MAPI_RC_SCALAR, 0 },
     { mapi_idx_wal_txn_abort,  MAPI_RC_SCALAR, 0 },
     { mapi_idx_wal_txn_commit, MAPI_RC_SCALAR, 0 },
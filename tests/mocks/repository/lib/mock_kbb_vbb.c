@@ -45,11 +45,15 @@ static struct mapi_injection inject_list[] = {
     { mapi_idx_kbb_add_entry, MAPI_RC_SCALAR, 0},
     { mapi_idx_kbb_add_entry, MAPI_RC_SCALAR, 0},
     { mapi_idx_kbb_add_ptomb, MAPI_RC_SCALAR, 0},
+    { mapi_idx_kbb_add_rtomb, MAPI_RC_SCALAR, 0},
     { mapi_idx_kbb_finish, MAPI_RC_SCALAR, 0},
+    { mapi_idx_kbb_hlog_union, MAPI_RC_SCALAR, 0},
     /* vblock builder */
     { mapi_idx_vbb_destroy, MAPI_RC_SCALAR, 0},
     { mapi_idx_vbb_add_entry, MAPI_RC_SCALAR, 0},
+    { mapi_idx_vbb_add_blk_entry, MAPI_RC_SCALAR, 0},
     { mapi_idx_vbb_finish, MAPI_RC_SCALAR, 0},
+    { mapi_idx_vbb_set_comp, MAPI_RC_SCALAR, 0},
     /* required termination */
     { -1 },
 };
@@ -387,6 +387,47 @@ _kvset_put_ref(struct kvset *kvset)
     }
 }
 
+/* The key range of a mock kvset is that of its kvdata array, whose
+ * keys are in ascending order only for big-endian keys.
+ */
+static void
+_kvset_key_range(struct kvset *kvset, bool max, const void **key, u16 *klen)
+{
+    static char        ffkey[HSE_KVS_KEY_LEN_MAX];
+    struct mock_kvset *mk = (void *)kvset;
+    struct kvdata *    d = mk->iter_data;
+    int                i, best;
+
+    if (!d || d == (void *)-1 || d[0].key == 0) {
+        memset(ffkey, 0xff, sizeof(ffkey));
+        *key = max ? ffkey : NULL;
+        *klen = max ? sizeof(ffkey) : 0;
+        return;
+    }
+
+    for (best = i = 1; i <= d[0].key; ++i) {
+        int rc = keycmp(&d[i].key, sizeof(d[i].key), &d[best].key, sizeof(d[best].key));
+
+        if (max ? rc > 0 : rc < 0)
+            best = i;
+    }
+
+    *key = &d[best].key;
+    *klen = sizeof(d[best].key);
+}
+
+static void
+_kvset_minkey(struct kvset *kvset, const void **minkey, u16 *minklen)
+{
+    _kvset_key_range(kvset, false, minkey, minklen);
+}
+
+static void
+_kvset_maxkey(struct kvset *kvset, const void **maxkey, u16 *maxklen)
+{
+    _kvset_key_range(kvset, true, maxkey, maxklen);
+}
+
 /* ------------------------------------------------------------
  * Mocked kvset iterator
  */
@@ -637,6 +678,7 @@ _kvset_iter_seek(struct kv_iterator *kvi, const void *key, int len, bool *eof)
  */
 static struct mapi_injection inject_list[] = {
     { mapi_idx_kvset_kblk_start, MAPI_RC_SCALAR, 0},
+    { mapi_idx_kvset_get_rtombs, MAPI_RC_SCALAR, 0},
     { mapi_idx_kvset_get_scatter_score, MAPI_RC_SCALAR, 10},
     { -1 }
 };
@@ -654,6 +696,8 @@ mock_kvset_set(void)
     MOCK_SET(kvset, _kvset_list_add_tail);
     MOCK_SET(kvset, _kvset_get_ref);
     MOCK_SET(kvset, _kvset_put_ref);
+    MOCK_SET(kvset, _kvset_minkey);
+    MOCK_SET(kvset, _kvset_maxkey);
     MOCK_SET(kvset, _kvset_iter_set_start);
     MOCK_SET(kvset, _kvset_iter_create);
     MOCK_SET(kvset, _kvset_iter_release);
@@ -681,6 +725,8 @@ mock_kvset_unset(void)
     MOCK_UNSET(kvset, _kvset_list_add_tail);
     MOCK_UNSET(kvset, _kvset_get_ref);
     MOCK_UNSET(kvset, _kvset_put_ref);
+    MOCK_UNSET(kvset, _kvset_minkey);
+    MOCK_UNSET(kvset, _kvset_maxkey);
     MOCK_UNSET(kvset, _kvset_iter_create);
     MOCK_UNSET(kvset, _kvset_iter_release);
     MOCK_UNSET(kvset, _kvset_from_iter);
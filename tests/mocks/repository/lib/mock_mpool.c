@@ -427,6 +427,12 @@ _mpool_mblock_read(struct mpool *mp, uint64_t id, const struct iovec *iovec, int
     return mblock_rw(id, iovec, niov, off, true);
 }
 
+static bool
+_mpool_bcache_enabled(struct mpool *mp)
+{
+    return false;
+}
+
 static merr_t
 _mpool_mblock_write(struct mpool *mp, uint64_t id, const struct iovec *iovec, int niov)
 {
@@ -830,6 +836,8 @@ mock_mpool_set(void)
     MOCK_SET(mpool, _mpool_mcache_munmap);
     MOCK_SET(mpool, _mpool_mcache_madvise);
 
+    MOCK_SET(mpool, _mpool_bcache_enabled);
+
     MOCK_SET(mpool, _mpool_mdc_append);
     MOCK_SET(mpool, _mpool_mdc_cend);
     MOCK_SET(mpool, _mpool_mdc_close);
@@ -863,6 +871,8 @@ mock_mpool_unset(void)
     MOCK_UNSET(mpool, _mpool_mcache_munmap);
     MOCK_UNSET(mpool, _mpool_mcache_madvise);
 
+    MOCK_UNSET(mpool, _mpool_bcache_enabled);
+
     MOCK_UNSET(mpool, _mpool_mdc_append);
     MOCK_UNSET(mpool, _mpool_mdc_cend);
     MOCK_UNSET(mpool, _mpool_mdc_close);
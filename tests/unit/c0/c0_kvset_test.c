@@ -15,6 +15,8 @@
 #include <hse_ikvdb/c0_kvset.h>
 #include <hse_ikvdb/c0_kvset_iterator.h>
 
+#include <pthread.h>
+
 int
 test_collection_setup(struct mtf_test_info *info)
 {
@@ -179,6 +181,114 @@ MTF_DEFINE_UTEST_PREPOST(c0_kvset_test, basic_put_get, no_fail_pre, no_fail_post
     c0kvs_destroy(kvs);
 }
 
+#define CONCURRENT_PUT_THREADS (16)
+#define CONCURRENT_PUT_KEYS    (4096)
+
+struct concurrent_put_args {
+    struct c0_kvset *kvs;
+    int              tid;
+    merr_t           err;
+};
+
+static void *
+concurrent_put_worker(void *arg)
+{
+    struct concurrent_put_args *args = arg;
+    char                        kbuf[32];
+    int                         i;
+
+    for (i = 0; i < CONCURRENT_PUT_KEYS; ++i) {
+        struct kvs_ktuple kt;
+        struct kvs_vtuple vt;
+        merr_t            err;
+
+        /* Every thread puts its own key plus one value to a key
+         * shared by all threads.
+         */
+        snprintf(kbuf, sizeof(kbuf), "key%02d.%06d", args->tid, i);
+        kvs_ktuple_init(&kt, kbuf, strlen(kbuf));
+        kvs_vtuple_init(&vt, &args->tid, sizeof(args->tid));
+
+        err = c0kvs_put(args->kvs, 0, &kt, &vt, HSE_ORDNL_TO_SQNREF(i));
+        if (err)
+            args->err = err;
+
+        snprintf(kbuf, sizeof(kbuf), "shared.%06d", i);
+        kvs_ktuple_init(&kt, kbuf, strlen(kbuf));
+
+        err = c0kvs_put(args->kvs, 0, &kt, &vt, HSE_ORDNL_TO_SQNREF(args->tid));
+        if (err)
+            args->err = err;
+    }
+
+    return NULL;
+}
+
+MTF_DEFINE_UTEST_PREPOST(c0_kvset_test, concurrent_put, no_fail_pre, no_fail_post)
+{
+    struct concurrent_put_args argv[CONCURRENT_PUT_THREADS];
+    pthread_t                  tidv[CONCURRENT_PUT_THREADS];
+    struct c0_kvset *          kvs;
+    u64                        keys, tombs, keyb, valb;
+    char                       kbuf[32];
+    int                        i, j, rc;
+    merr_t                     err;
+
+    err = c0kvs_create(NULL, NULL, &kvs);
+    ASSERT_EQ(0, err);
+
+    for (i = 0; i < CONCURRENT_PUT_THREADS; ++i) {
+        argv[i].kvs = kvs;
+        argv[i].tid = i;
+        argv[i].err = 0;
+
+        rc = pthread_create(tidv + i, NULL, concurrent_put_worker, argv + i);
+        ASSERT_EQ(0, rc);
+    }
+
+    for (i = 0; i < CONCURRENT_PUT_THREADS; ++i) {
+        rc = pthread_join(tidv[i], NULL);
+        ASSERT_EQ(0, rc);
+        ASSERT_EQ(0, argv[i].err);
+    }
+
+    c0kvs_get_content_metrics(kvs, &keys, &tombs, &keyb, &valb);
+    ASSERT_EQ((CONCURRENT_PUT_THREADS + 1) * CONCURRENT_PUT_KEYS, keys);
+
+    for (i = 0; i < CONCURRENT_PUT_THREADS; ++i) {
+        for (j = 0; j < CONCURRENT_PUT_KEYS; ++j) {
+            struct kvs_ktuple   kt;
+            struct kvs_buf      vb;
+            enum key_lookup_res res;
+            uintptr_t           oseqnoref;
+            int                 val = -1;
+
+            snprintf(kbuf, sizeof(kbuf), "key%02d.%06d", i, j);
+            kvs_ktuple_init(&kt, kbuf, strlen(kbuf));
+            kvs_buf_init(&vb, &val, sizeof(val));
+
+            err = c0kvs_get_excl(kvs, 0, &kt, j, 0, &res, &vb, &oseqnoref);
+            ASSERT_EQ(0, err);
+            ASSERT_EQ(FOUND_VAL, res);
+            ASSERT_EQ(i, val);
+
+            /* Each thread's value for the shared key is visible at
+             * the seqno with which it was put.
+             */
+            snprintf(kbuf, sizeof(kbuf), "shared.%06d", j);
+            kvs_ktuple_init(&kt, kbuf, strlen(kbuf));
+            kvs_buf_init(&vb, &val, sizeof(val));
+
+            err = c0kvs_get_excl(kvs, 0, &kt, i, 0, &res, &vb, &oseqnoref);
+            ASSERT_EQ(0, err);
+            ASSERT_EQ(FOUND_VAL, res);
+            ASSERT_EQ(i, val);
+        }
+    }
+
+    c0kvs_destroy(kvs);
+}
+
 MTF_DEFINE_UTEST_PREPOST(c0_kvset_test, basic_put_get_fail, no_fail_pre, no_fail_post)
 {
     struct c0_kvset * kvs;
@@ -82,7 +82,7 @@ read_blooms(struct mtf_test_info *lcl_ti, char *kblock_file)
     char *                endptr;
     char                  filename[PATH_MAX];
     char                  keybuf[100];
-    struct kvs_mblk_desc  blkdesc;
+    struct kvs_mblk_desc  blkdesc = {};
     u64                   blkid;
     u8 *                  blm_pages;
 
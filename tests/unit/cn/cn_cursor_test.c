@@ -59,7 +59,7 @@ test_collection_setup(struct mtf_test_info *info)
     mock_mpool_set();
     mock_kvset_set();
 
-    err = cn_kvdb_create(4, 4, &cn_kvdb);
+    err = cn_kvdb_create(4, 4, 1, 0, &cn_kvdb);
 
     return merr_errno(err);
 }
@@ -230,7 +230,7 @@ verify_cursor(
     merr_t                err;
 
     /* make seqno so large there is never any filtering */
-    err = cn_cursor_create(cn, seqno, false, pfx, pfx_len, &sum, &cur);
+    err = cn_cursor_create(cn, seqno, false, false, pfx, pfx_len, &sum, &cur);
     ASSERT_EQ(err, 0);
     ASSERT_NE(cur, NULL);
 
@@ -254,7 +254,7 @@ verify_seek(
     struct cn_cursor *    cur;
     merr_t                err;
 
-    err = cn_cursor_create(cn, seqno, false, pfx, pfx_len, &sum, &cur);
+    err = cn_cursor_create(cn, seqno, false, false, pfx, pfx_len, &sum, &cur);
     ASSERT_EQ(err, 0);
     ASSERT_NE(cur, NULL);
 
@@ -280,7 +280,7 @@ verify_seek_eof(
     struct cn_cursor *    cur;
     merr_t err;
 
-    err = cn_cursor_create(cn, seqno, false, pfx, pfx_len, &sum, &cur);
+    err = cn_cursor_create(cn, seqno, false, false, pfx, pfx_len, &sum, &cur);
     ASSERT_EQ(err, 0);
     ASSERT_NE(cur, NULL);
 
@@ -424,7 +424,7 @@ MTF_DEFINE_UTEST_PREPOST(cn_cursor, repeat_update, pre, post)
     err = cn_tree_insert_kvset(tree, ITV_KVSET(itv[0]), 0, 0);
     ASSERT_EQ(err, 0);
 
-    err = cn_cursor_create(cn, seqno, false, NULL, 0, &sum, &cur);
+    err = cn_cursor_create(cn, seqno, false, false, NULL, 0, &sum, &cur);
     ASSERT_EQ(err, 0);
     ASSERT_NE(cur, NULL);
 
@@ -953,6 +953,154 @@ MTF_DEFINE_UTEST_PREPOST(cn_cursor, cursor_seek, pre, post)
     free(cndb.cndb_cbuf);
 }
 
+static int
+cursor_kvset_idx(struct cn_cursor *cur, struct kv_iterator *itv)
+{
+    int i;
+
+    for (i = 0; i < cur->iterc; ++i)
+        if (cur->ksv[i] == ITV_KVSET(itv))
+            return i;
+
+    return -1;
+}
+
+MTF_DEFINE_UTEST_PREPOST(cn_cursor, seek_prune, pre, post)
+{
+    struct cn *           cn;
+    struct cn_tree *      tree;
+    struct mock_kvset *   mk;
+    struct mpool *        ds = (void *)-1;
+    struct kv_iterator *  itv[3];
+    struct cn_cursor *    cur;
+    struct cursor_summary sum;
+    merr_t                err;
+    struct cndb           cndb;
+    struct cndb_cn        cndbcn = cndb_cn_initializer(3, 0, 0);
+    struct kvdb_kvs       kk = { 0 };
+    struct kvs_cparams    cp = {};
+    int                   i, pass;
+
+    /* Three kvsets with disjoint key ranges: [0, 0x100), [0x100, 0x200)
+     * and [0x200, 0x300).
+     */
+    struct nkv_tab make[] = {
+        { 0x100, 0x000, 0x000, VMX_S32, KVDATA_BE_KEY, 1 },
+        { 0x100, 0x100, 0x100, VMX_S32, KVDATA_BE_KEY, 2 },
+        { 0x100, 0x200, 0x200, VMX_S32, KVDATA_BE_KEY, 3 },
+    };
+
+    unsigned char seek[] = { 0, 0, 1, 0x80 };
+
+    struct nkv_tab vtab[] = {
+        { 0x80,  0x180, 0x180, VMX_S32, 0, 0 },
+        { 0x100, 0x200, 0x200, VMX_S32, 0, 0 },
+    };
+
+    ITV_INIT(itv, 0, make);
+    ITV_INIT(itv, 1, make);
+    ITV_INIT(itv, 2, make);
+
+    mk = ITV_KVSET_MOCK(itv[2]);
+    mapi_inject(mapi_idx_cn_tree_initial_dgen, mk->dgen);
+
+    err = cndb_init(&cndb, ds, true, 0, CNDB_ENTRIES, 0, 0, &health, 0);
+    ASSERT_EQ(err, 0);
+
+    cndb.cndb_cnc = 1;
+    cndb.cndb_cnv[0] = &cndbcn;
+    ASSERT_NE(cndb.cndb_workv, NULL);
+    ASSERT_NE(cndb.cndb_keepv, NULL);
+    ASSERT_NE(cndb.cndb_tagv, NULL);
+
+    kk.kk_parent = dummy_ikvdb_create();
+    kk.kk_cparams = &cp;
+    kk.kk_cparams->fanout = 1 << 3;
+
+    err = cn_open(cn_kvdb, ds, &kk, &cndb, 0, &rp, "mp", "kvs", &health, 0, &cn);
+    ASSERT_EQ(err, 0);
+
+    tree = cn_get_tree(cn);
+    ASSERT_NE(tree, NULL);
+
+    for (i = 0; i < NELEM(make); ++i) {
+        err = cn_tree_insert_kvset(tree, ITV_KVSET(itv[i]), 0, 0);
+        ASSERT_EQ(err, 0);
+    }
+
+    /* TC: A forward seek creates no iterator for a kvset whose keys all
+     * precede the seek key, and still returns every key from the seek
+     * key onward.
+     */
+    err = cn_cursor_create(cn, seqno, false, false, NULL, 0, &sum, &cur);
+    ASSERT_EQ(err, 0);
+    ASSERT_EQ(cur->iterc, NELEM(make));
+
+    for (i = 0; i < cur->iterc; ++i)
+        ASSERT_EQ(cur->iterv[i], NULL);
+
+    err = cn_cursor_seek(cur, seek, sizeof(seek), 0);
+    ASSERT_EQ(err, 0);
+
+    ASSERT_EQ(cur->iterv[cursor_kvset_idx(cur, itv[0])], NULL);
+    ASSERT_NE(cur->iterv[cursor_kvset_idx(cur, itv[1])], NULL);
+    ASSERT_NE(cur->iterv[cursor_kvset_idx(cur, itv[2])], NULL);
+
+    verify(lcl_ti, cur, vtab, NELEM(vtab), 0);
+
+    /* TC: A reverse seek creates no iterator for a kvset whose keys all
+     * follow the seek key.
+     */
+    err = cn_cursor_create(cn, seqno, true, false, NULL, 0, &sum, &cur);
+    ASSERT_EQ(err, 0);
+
+    err = cn_cursor_seek(cur, seek, sizeof(seek), 0);
+    ASSERT_EQ(err, 0);
+
+    ASSERT_NE(cur->iterv[cursor_kvset_idx(cur, itv[0])], NULL);
+    ASSERT_NE(cur->iterv[cursor_kvset_idx(cur, itv[1])], NULL);
+    ASSERT_EQ(cur->iterv[cursor_kvset_idx(cur, itv[2])], NULL);
+
+    cn_cursor_destroy(cur);
+
+    /* TC: Kvsets with ptombs are never pruned, in either direction,
+     * because their key range does not account for their ptombs.
+     */
+    mapi_inject(mapi_idx_kvset_pt_start, 0);
+
+    for (pass = 0; pass < 2; ++pass) {
+        err = cn_cursor_create(cn, seqno, pass, false, NULL, 0, &sum, &cur);
+        ASSERT_EQ(err, 0);
+
+        err = cn_cursor_seek(cur, seek, sizeof(seek), 0);
+        ASSERT_EQ(err, 0);
+
+        for (i = 0; i < cur->iterc; ++i)
+            ASSERT_NE(cur->iterv[i], NULL);
+
+        cn_cursor_destroy(cur);
+    }
+
+    mapi_inject(mapi_idx_kvset_pt_start, -1);
+
+    err = cn_close(cn);
+    ASSERT_EQ(err, 0);
+
+    dummy_ikvdb_destroy(kk.kk_parent);
+    free(cndb.cndb_workv);
+    free(cndb.cndb_keepv);
+    free(cndb.cndb_tagv);
+    free(cndb.cndb_cbuf);
+
+    for (i = 0; i < NELEM(make); ++i) {
+        struct mock_kv_iterator *iter = itv[i]->kvi_context;
+        struct kvdata *          d = iter->kvset->iter_data;
+
+        free(d);
+        kvset_iter_release(itv[i]);
+    }
+}
+
 void
 _kvset_maxkey(struct kvset *ks, const void **maxkey, u16 *maxklen)
 {
@@ -1036,7 +1184,7 @@ MTF_DEFINE_UTEST_PREPOST(cn_cursor, capped_update, pre, post)
     }
 
     /* Test 1: capped cursor update test */
-    err = cn_cursor_create(cn, seqno, false, NULL, 0, &sum, &cur);
+    err = cn_cursor_create(cn, seqno, false, false, NULL, 0, &sum, &cur);
     ASSERT_EQ(err, 0);
 
     for (; i < NELEM(make); ++i) {
@@ -1185,7 +1333,7 @@ MTF_DEFINE_UTEST_PREPOST(cn_cursor, capped_update_errors, pre, post)
         ASSERT_EQ(err, 0);
     }
 
-    err = cn_cursor_create(cn, seqno, false, NULL, 0, &sum, &cur);
+    err = cn_cursor_create(cn, seqno, false, false, NULL, 0, &sum, &cur);
     ASSERT_EQ(err, 0);
 
     for (; i < NELEM(make); ++i) {
@@ -0,0 +1,97 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/*
+ * Copyright (C) 2021 Micron Technology, Inc.  All rights reserved.
+ */
+
+#include <mtf/framework.h>
+
+#include <hse_ikvdb/cn_iogov.h>
+#include <hse_ikvdb/throttle.h>
+
+MTF_BEGIN_UTEST_COLLECTION(cn_iogov_test);
+
+MTF_DEFINE_UTEST(cn_iogov_test, unlimited)
+{
+    struct cn_iogov gov;
+    int             cls;
+
+    cn_iogov_init(&gov, 0);
+
+    for (cls = 0; cls < CN_IOGOV_CLASS_CNT; cls++) {
+        ASSERT_EQ(0, tbkt_rate_get(&gov.ig_tbv[cls]));
+        cn_iogov_request(&gov, cls, 1ul << 40);
+    }
+
+    /* A NULL governor is also unlimited.
+     */
+    cn_iogov_request(NULL, CN_IOGOV_ROOT, 1ul << 40);
+}
+
+MTF_DEFINE_UTEST(cn_iogov_test, shares)
+{
+    struct cn_iogov gov;
+    u64             rate = 100ul << 20;
+
+    cn_iogov_init(&gov, 100);
+
+    ASSERT_EQ(rate, gov.ig_rate);
+    ASSERT_EQ(rate * 50 / 100, tbkt_rate_get(&gov.ig_tbv[CN_IOGOV_ROOT]));
+    ASSERT_EQ(rate * 30 / 100, tbkt_rate_get(&gov.ig_tbv[CN_IOGOV_INTERN]));
+    ASSERT_EQ(rate * 20 / 100, tbkt_rate_get(&gov.ig_tbv[CN_IOGOV_LEAF]));
+}
+
+MTF_DEFINE_UTEST(cn_iogov_test, loosen)
+{
+    struct throttle_sensor  sensorv[2] = {};
+    struct throttle_sensor *sensorpv[] = { &sensorv[0], NULL, &sensorv[1] };
+    struct cn_iogov         gov;
+    u64                     root, leaf;
+
+    cn_iogov_init(&gov, 100);
+    cn_iogov_sensors_set(&gov, sensorpv, NELEM(sensorpv));
+    ASSERT_EQ(2, gov.ig_sensorc);
+
+    root = tbkt_rate_get(&gov.ig_tbv[CN_IOGOV_ROOT]);
+    leaf = tbkt_rate_get(&gov.ig_tbv[CN_IOGOV_LEAF]);
+
+    /* Backpressure below half scale is ignored.
+     */
+    throttle_sensor_set(&sensorv[0], THROTTLE_SENSOR_SCALE / 2);
+    atomic_set(&gov.ig_adjust, 0);
+    cn_iogov_request(&gov, CN_IOGOV_LEAF, 1);
+    ASSERT_EQ(100, gov.ig_factor);
+    ASSERT_EQ(root, tbkt_rate_get(&gov.ig_tbv[CN_IOGOV_ROOT]));
+
+    /* The highest sensor determines the multiplier.
+     */
+    throttle_sensor_set(&sensorv[1], THROTTLE_SENSOR_SCALE * 3 / 4);
+    atomic_set(&gov.ig_adjust, 0);
+    cn_iogov_request(&gov, CN_IOGOV_LEAF, 1);
+    ASSERT_EQ(250, gov.ig_factor);
+    ASSERT_EQ(root * 250 / 100, tbkt_rate_get(&gov.ig_tbv[CN_IOGOV_ROOT]));
+    ASSERT_EQ(leaf, tbkt_rate_get(&gov.ig_tbv[CN_IOGOV_LEAF]));
+
+    /* The sensors are not re-evaluated until the adjustment interval passes.
+     */
+    throttle_sensor_set(&sensorv[1], 0);
+    cn_iogov_request(&gov, CN_IOGOV_LEAF, 1);
+    ASSERT_EQ(250, gov.ig_factor);
+
+    /* Root and internal spills are unlimited once ingest is throttled.
+     */
+    throttle_sensor_set(&sensorv[0], THROTTLE_SENSOR_SCALE);
+    atomic_set(&gov.ig_adjust, 0);
+    cn_iogov_request(&gov, CN_IOGOV_LEAF, 1);
+    ASSERT_EQ(0, gov.ig_factor);
+    ASSERT_EQ(0, tbkt_rate_get(&gov.ig_tbv[CN_IOGOV_ROOT]));
+    ASSERT_EQ(0, tbkt_rate_get(&gov.ig_tbv[CN_IOGOV_INTERN]));
+    ASSERT_EQ(leaf, tbkt_rate_get(&gov.ig_tbv[CN_IOGOV_LEAF]));
+
+    throttle_sensor_set(&sensorv[0], 0);
+    atomic_set(&gov.ig_adjust, 0);
+    cn_iogov_request(&gov, CN_IOGOV_LEAF, 1);
+    ASSERT_EQ(100, gov.ig_factor);
+    ASSERT_EQ(root, tbkt_rate_get(&gov.ig_tbv[CN_IOGOV_ROOT]));
+}
+
+MTF_END_UTEST_COLLECTION(cn_iogov_test)
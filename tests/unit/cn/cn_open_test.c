@@ -108,7 +108,7 @@ pre(struct mtf_test_info *lcl_ti)
     h = &health;
     flags = 0;
 
-    err = cn_kvdb_create(4, 4, &cn_kvdb);
+    err = cn_kvdb_create(4, 4, 1, 0, &cn_kvdb);
 
     return merr_errno(err);
 }
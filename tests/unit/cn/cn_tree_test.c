@@ -15,6 +15,9 @@
 #include <hse_ikvdb/cn_node_loc.h>
 #include <hse_ikvdb/kvdb_health.h>
 #include <hse_ikvdb/cn.h>
+#include <hse_ikvdb/query_ctx.h>
+#include <hse_ikvdb/tuple.h>
+#include <hse_ikvdb/omf_kmd.h>
 
 #include <cn/cn_tree.h>
 #include <cn/cn_tree_iter.h>
@@ -318,6 +321,8 @@ struct mapi_injection inject_list[] = {
      * need the guts of an iterator b/c we mock
      * the actual compact/spill functions. */
     { mapi_idx_kvset_iter_set_stats, MAPI_RC_SCALAR, 0 },
+    { mapi_idx_kvset_iter_set_iogov, MAPI_RC_SCALAR, 0 },
+    { mapi_idx_kvset_iter_set_now, MAPI_RC_SCALAR, 0 },
     { mapi_idx_kvset_iter_seek, MAPI_RC_SCALAR, -1 },
     { mapi_idx_kvset_iter_next_key, MAPI_RC_SCALAR, -1 },
     { mapi_idx_kvset_iter_next_val, MAPI_RC_SCALAR, -1 },
@@ -910,6 +915,351 @@ MTF_DEFINE_UTEST_PRE(test, t_cn_comp, test_setup)
         NAME(&test);                                                   \
     }
 
+/*----------------------------------------------------------------
+ * Batched lookups.
+ *
+ * Each key's fate is determined by its class (n % LK_NCLASS) and the
+ * level and age of the kvset probed.  The root node and every level 1
+ * node each hold a newer and an older kvset.
+ */
+enum lk_class {
+    LK_MISS,      /* in no kvset, bloom misses everywhere */
+    LK_ROOT_VAL,  /* value in the newer root kvset */
+    LK_ROOT_TMB,  /* tombstone in the older root kvset, values below it */
+    LK_CHILD_VAL, /* root bloom false positives, value in the older child kvset */
+    LK_CHILD_TMB, /* tombstone in the newer child kvset, value in the older */
+    LK_C0,        /* resolved before cn is searched */
+    LK_NCLASS,
+};
+
+#define LK_DGEN_ROOT_NEW  (40)
+#define LK_DGEN_ROOT_OLD  (30)
+#define LK_DGEN_CHILD_NEW (20)
+#define LK_DGEN_CHILD_OLD (10)
+
+struct lk_counts {
+    uint probes[2][LK_NCLASS];
+    uint lookups[2][LK_NCLASS];
+};
+
+static struct lk_counts lk_counts;
+
+static uint
+lk_key2num(const struct kvs_ktuple *kt)
+{
+    return strtoul((const char *)kt->kt_data + 3, NULL, 10);
+}
+
+/* Returns the result of looking up key @n in @kvset, and whether its
+ * bloom filter would admit the key.
+ */
+static enum key_lookup_res
+lk_result(const struct fake_kvset *kvset, uint n, bool *bloom)
+{
+    enum key_lookup_res res = NOT_FOUND;
+
+    *bloom = false;
+
+    switch (n % LK_NCLASS) {
+    case LK_ROOT_VAL:
+        if (kvset->dgen == LK_DGEN_ROOT_NEW)
+            res = FOUND_VAL;
+        break;
+
+    case LK_ROOT_TMB:
+        if (kvset->dgen == LK_DGEN_ROOT_OLD)
+            res = FOUND_TMB;
+        else if (kvset->node_level > 0)
+            res = FOUND_VAL;
+        break;
+
+    case LK_CHILD_VAL:
+        if (kvset->node_level == 0)
+            *bloom = true;
+        else if (kvset->dgen == LK_DGEN_CHILD_OLD)
+            res = FOUND_VAL;
+        break;
+
+    case LK_CHILD_TMB:
+        if (kvset->dgen == LK_DGEN_CHILD_NEW)
+            res = FOUND_TMB;
+        else if (kvset->dgen == LK_DGEN_CHILD_OLD)
+            res = FOUND_VAL;
+        break;
+    }
+
+    if (res != NOT_FOUND)
+        *bloom = true;
+
+    return res;
+}
+
+static merr_t
+_kvset_lookup(
+    struct kvset *         handle,
+    struct kvs_ktuple *    kt,
+    const struct key_disc *kdisc,
+    u64                    seq,
+    enum key_lookup_res *  res,
+    struct kvs_buf *       vbuf)
+{
+    struct fake_kvset *kvset = (struct fake_kvset *)handle;
+    uint               n = lk_key2num(kt);
+    u64                val;
+    bool               bloom;
+
+    lk_counts.lookups[kvset->node_level][n % LK_NCLASS]++;
+
+    *res = lk_result(kvset, n, &bloom);
+
+    if (*res == FOUND_VAL) {
+        val = (u64)n << 32 | kvset->dgen;
+        memcpy(vbuf->b_buf, &val, min_t(size_t, sizeof(val), vbuf->b_buf_sz));
+        vbuf->b_len = sizeof(val);
+    }
+
+    return 0;
+}
+
+static void
+_kvset_bloom_probe_multi(
+    struct kvset *          handle,
+    struct kvs_ktuple **    ktv,
+    const struct key_disc **kdiscv,
+    uint                    cnt,
+    bool *                  hitv)
+{
+    struct fake_kvset *kvset = (struct fake_kvset *)handle;
+    uint               i;
+
+    VERIFY_LE(cnt, KVSET_BLOOM_PROBE_MAX);
+
+    for (i = 0; i < cnt; i++) {
+        uint n = lk_key2num(ktv[i]);
+
+        lk_counts.probes[kvset->node_level][n % LK_NCLASS]++;
+        lk_result(kvset, n, hitv + i);
+    }
+}
+
+MTF_DEFINE_UTEST_PRE(test, t_cn_tree_lookup_multi, test_setup)
+{
+    const uint           nkeys = 20 * LK_NCLASS;
+    const uint           nchild = 4;
+    struct fake_kvset *  kvset_list = NULL, *kvset;
+    struct cn_tree *     tree;
+    struct kvs_ktuple *  ktv;
+    struct kvs_buf *     vbufv;
+    enum key_lookup_res *resv;
+    char (*keyv)[8];
+    u64 *                valv;
+    merr_t               err;
+    uint                 i, j;
+
+    struct kvs_cparams cp = {
+        .fanout = nchild,
+    };
+
+    MOCK_SET(kvset, _kvset_lookup);
+    MOCK_SET(kvset, _kvset_bloom_probe_multi);
+
+    err = cn_tree_create(&tree, NULL, 0, &cp, &mock_health, rp);
+    ASSERT_EQ(err, 0);
+
+    kvset = fake_kvset_create_add(&kvset_list, tree, 0, 0, LK_DGEN_ROOT_OLD);
+    ASSERT_NE(NULL, kvset);
+    kvset = fake_kvset_create_add(&kvset_list, tree, 0, 0, LK_DGEN_ROOT_NEW);
+    ASSERT_NE(NULL, kvset);
+
+    for (i = 0; i < nchild; i++) {
+        kvset = fake_kvset_create_add(&kvset_list, tree, 1, i, LK_DGEN_CHILD_NEW);
+        ASSERT_NE(NULL, kvset);
+        kvset = fake_kvset_create_add(&kvset_list, tree, 1, i, LK_DGEN_CHILD_OLD);
+        ASSERT_NE(NULL, kvset);
+    }
+
+    ktv = calloc(nkeys, sizeof(*ktv));
+    vbufv = calloc(nkeys, sizeof(*vbufv));
+    resv = calloc(nkeys, sizeof(*resv));
+    keyv = calloc(nkeys, sizeof(*keyv));
+    valv = calloc(nkeys, sizeof(*valv));
+    ASSERT_TRUE(ktv && vbufv && resv && keyv && valv);
+
+    for (j = 0; j < 2; j++) {
+        memset(&lk_counts, 0, sizeof(lk_counts));
+
+        /* Keys of all classes are interleaved so that each node's group
+         * spans several bloom probe batches.
+         */
+        for (i = 0; i < nkeys; i++) {
+            snprintf(keyv[i], sizeof(keyv[i]), "key%04u", i);
+            kvs_ktuple_init(ktv + i, keyv[i], strlen(keyv[i]));
+
+            valv[i] = 0;
+            kvs_buf_init(vbufv + i, valv + i, sizeof(valv[i]));
+
+            resv[i] = (i % LK_NCLASS == LK_C0) ? FOUND_VAL : NOT_FOUND;
+        }
+
+        if (j == 0) {
+            err = cn_tree_lookup_multi(tree, NULL, ktv, 100, resv, vbufv, nkeys);
+            ASSERT_EQ(err, 0);
+        } else {
+            struct query_ctx qctx = { .qtype = QUERY_GET };
+
+            /* The batched results must match those of single lookups.
+             */
+            for (i = 0; i < nkeys; i++) {
+                if (resv[i] != NOT_FOUND)
+                    continue;
+
+                err = cn_tree_lookup(tree, NULL, ktv + i, 100, resv + i, &qctx, NULL, vbufv + i);
+                ASSERT_EQ(err, 0);
+            }
+        }
+
+        for (i = 0; i < nkeys; i++) {
+            switch (i % LK_NCLASS) {
+            case LK_MISS:
+                ASSERT_EQ(resv[i], NOT_FOUND);
+                break;
+
+            case LK_ROOT_VAL:
+                ASSERT_EQ(resv[i], FOUND_VAL);
+                ASSERT_EQ(valv[i], (u64)i << 32 | LK_DGEN_ROOT_NEW);
+                break;
+
+            case LK_ROOT_TMB:
+            case LK_CHILD_TMB:
+                ASSERT_EQ(resv[i], FOUND_TMB);
+                break;
+
+            case LK_CHILD_VAL:
+                ASSERT_EQ(resv[i], FOUND_VAL);
+                ASSERT_EQ(valv[i], (u64)i << 32 | LK_DGEN_CHILD_OLD);
+                break;
+
+            case LK_C0:
+                ASSERT_EQ(resv[i], FOUND_VAL);
+                ASSERT_EQ(valv[i], 0);
+                break;
+            }
+        }
+
+        if (j > 0)
+            continue;
+
+        /* Keys are probed only until resolved, and only kvsets whose
+         * bloom admits a key are searched for it.
+         */
+        ASSERT_EQ(lk_counts.probes[0][LK_MISS], 2 * 20);
+        ASSERT_EQ(lk_counts.probes[1][LK_MISS], 2 * 20);
+        ASSERT_EQ(lk_counts.lookups[0][LK_MISS], 0);
+        ASSERT_EQ(lk_counts.lookups[1][LK_MISS], 0);
+
+        ASSERT_EQ(lk_counts.probes[0][LK_ROOT_VAL], 20);
+        ASSERT_EQ(lk_counts.lookups[0][LK_ROOT_VAL], 20);
+        ASSERT_EQ(lk_counts.probes[1][LK_ROOT_VAL], 0);
+
+        ASSERT_EQ(lk_counts.probes[0][LK_ROOT_TMB], 2 * 20);
+        ASSERT_EQ(lk_counts.lookups[0][LK_ROOT_TMB], 20);
+        ASSERT_EQ(lk_counts.probes[1][LK_ROOT_TMB], 0);
+
+        ASSERT_EQ(lk_counts.lookups[0][LK_CHILD_VAL], 2 * 20);
+        ASSERT_EQ(lk_counts.probes[1][LK_CHILD_VAL], 2 * 20);
+        ASSERT_EQ(lk_counts.lookups[1][LK_CHILD_VAL], 20);
+
+        ASSERT_EQ(lk_counts.lookups[0][LK_CHILD_TMB], 0);
+        ASSERT_EQ(lk_counts.probes[1][LK_CHILD_TMB], 20);
+        ASSERT_EQ(lk_counts.lookups[1][LK_CHILD_TMB], 20);
+
+        ASSERT_EQ(lk_counts.probes[0][LK_C0] + lk_counts.probes[1][LK_C0], 0);
+        ASSERT_EQ(lk_counts.lookups[0][LK_C0] + lk_counts.lookups[1][LK_C0], 0);
+    }
+
+    free(valv);
+    free(keyv);
+    free(resv);
+    free(vbufv);
+    free(ktv);
+
+    cn_tree_destroy(tree);
+
+    while (kvset_list) {
+        kvset = kvset_list;
+        kvset_list = kvset->next;
+        fake_kvset_destroy(kvset);
+    }
+
+    MOCK_UNSET(kvset, _kvset_bloom_probe_multi);
+    MOCK_UNSET(kvset, _kvset_lookup);
+}
+
+MTF_DEFINE_UTEST_PRE(test, t_kvset_iter_vref_expire_now, test_setup)
+{
+    struct kvset_iter_vctx vc;
+    enum kmd_vtype         vtype;
+    const void *           vdata;
+    uint                   vbidx, vboff, vlen, complen;
+    u64                    seq, expire, job_now;
+    size_t                 off = 0;
+    u8                     kmd[64];
+    bool                   more;
+    int                    pass;
+
+    /* The value's ttl ran out after the compaction job fixed its time
+     * but before the job's second pass over the slice.
+     */
+    expire = kvs_now() - 10;
+    job_now = expire - 1;
+
+    kmd_set_count(kmd, &off, 1);
+    kmd_add_expire(kmd, &off, expire);
+    kmd_add_val(kmd, &off, 7, 3, 4096, 100);
+
+    mapi_inject_unset(mapi_idx_kvset_iter_next_vref);
+
+    /* Both passes must see the value live at the job's time.
+     */
+    for (pass = 0; pass < 2; pass++) {
+        memset(&vc, 0, sizeof(vc));
+        vc.kmd = kmd;
+        vc.now = job_now;
+
+        more = kvset_iter_next_vref(NULL, &vc, &seq, &vtype, &vbidx, &vboff, &vdata, &vlen,
+                                    &complen);
+        ASSERT_TRUE(more);
+        ASSERT_EQ(vtype_val, vtype);
+        ASSERT_EQ(7, seq);
+        ASSERT_EQ(3, vbidx);
+        ASSERT_EQ(100, vlen);
+
+        more = kvset_iter_next_vref(NULL, &vc, &seq, &vtype, &vbidx, &vboff, &vdata, &vlen,
+                                    &complen);
+        ASSERT_FALSE(more);
+    }
+
+    /* At or after its expiration time the value reads as a tombstone.
+     */
+    memset(&vc, 0, sizeof(vc));
+    vc.kmd = kmd;
+    vc.now = expire;
+
+    more = kvset_iter_next_vref(NULL, &vc, &seq, &vtype, &vbidx, &vboff, &vdata, &vlen, &complen);
+    ASSERT_TRUE(more);
+    ASSERT_EQ(vtype_tomb, vtype);
+    ASSERT_EQ(0, vlen);
+
+    /* Without a fixed time the wall clock decides.
+     */
+    memset(&vc, 0, sizeof(vc));
+    vc.kmd = kmd;
+
+    more = kvset_iter_next_vref(NULL, &vc, &seq, &vtype, &vbidx, &vboff, &vdata, &vlen, &complen);
+    ASSERT_TRUE(more);
+    ASSERT_EQ(vtype_tomb, vtype);
+}
+
 MY_TEST1(create, fanout_bits, 1, 0);
 MY_TEST1(create, fanout_bits, 2, 0);
 MY_TEST1(create, fanout_bits, 3, 0);
@@ -17,6 +17,7 @@
 #include <hse_ikvdb/cn_kvdb.h>
 #include <hse_ikvdb/csched_rp.h>
 #include <hse_ikvdb/cn.h>
+#include <hse_ikvdb/throttle.h>
 
 #include <cn/csched_ops.h>
 #include <cn/csched_sp3.h>
@@ -342,6 +343,7 @@ cn_node_stats_get_mock(const struct cn_tree_node *tn, struct cn_node_stats *s)
  */
 struct mapi_injection inject_list[] = {
     { mapi_idx_cn_get_io_wq, MAPI_RC_PTR, NULL },
+    { mapi_idx_cn_get_iogov, MAPI_RC_PTR, NULL },
     { mapi_idx_cn_ref_get, MAPI_RC_SCALAR, 0 },
     { mapi_idx_cn_ref_put, MAPI_RC_SCALAR, 0 },
     { -1 },
@@ -454,6 +456,155 @@ MTF_DEFINE_UTEST_PRE(test, t_sp3_create, pre_test)
     err = sp3_create(NULL, kvdb_rp, mp, &health, &ops);
     ASSERT_EQ(err, 0);
     ops->cs_destroy(ops);
+
+    kvdb_rp->csched_policy = csched_policy_adapt;
+    kvdb_rp->csched_adapt_goal = csched_adapt_goal_ramp;
+    err = sp3_create(NULL, kvdb_rp, mp, &health, &ops);
+    ASSERT_EQ(err, 0);
+    ops->cs_destroy(ops);
+}
+
+static int
+check_adapt_order(
+    struct mtf_test_info *       lcl_ti,
+    const struct sp3_adapt_rank *rank,
+    const enum sp3_job_type *    expv,
+    uint                         expc)
+{
+    uint i;
+
+    ASSERT_EQ_RET(rank->orderc, expc, -1);
+
+    for (i = 0; i < expc; i++) {
+        ASSERT_EQ_RET(rank->orderv[i], expv[i], -1);
+        ASSERT_GT_RET(rank->prio[expv[i]], 0, -1);
+    }
+
+    return 0;
+}
+
+MTF_DEFINE_UTEST(test, t_sp3_adapt_rank)
+{
+    struct sp3_adapt_input in0, in;
+    struct sp3_adapt_rank  rank;
+    int                    rc;
+
+    /* Space amp, read amp and leaf percentage all within bounds.
+     */
+    in0 = (struct sp3_adapt_input){
+        .goal = csched_adapt_goal_wamp,
+        .samp = 100,
+        .samp_max = 150,
+        .samp_lwm = 120,
+        .ramp = 10,
+        .ramp_max = 20,
+        .lpct = 90,
+        .lpct_min = 90,
+        .rspill_sval = 0,
+        .llen_max = 8,
+    };
+
+    /* Minimizing write amp schedules only the jobs that are needed.
+     */
+    {
+        const enum sp3_job_type expv[] = { jtype_root, jtype_ispill, jtype_leaf_size };
+
+        in = in0;
+        sp3_adapt_rank(&in, &rank);
+        rc = check_adapt_order(lcl_ti, &rank, expv, NELEM(expv));
+        ASSERT_EQ(rc, 0);
+        ASSERT_EQ(rank.llen_min, in.llen_max);
+        ASSERT_EQ(rank.gmin, 20);
+    }
+
+    /* Space amp at twice its bound puts garbage and internal spills first.
+     */
+    {
+        const enum sp3_job_type expv[] = {
+            jtype_leaf_garbage, jtype_ispill, jtype_root, jtype_leaf_size
+        };
+
+        in = in0;
+        in.samp = 2 * in.samp_max;
+        sp3_adapt_rank(&in, &rank);
+        rc = check_adapt_order(lcl_ti, &rank, expv, NELEM(expv));
+        ASSERT_EQ(rc, 0);
+        ASSERT_EQ(rank.gmin, 0);
+    }
+
+    /* Read amp at twice its bound puts length compactions first, on
+     * nodes of any length, and enables idle and scatter compactions.
+     */
+    {
+        const enum sp3_job_type expv[] = {
+            jtype_node_len, jtype_root, jtype_ispill, jtype_leaf_size,
+            jtype_node_idle, jtype_leaf_scatter
+        };
+
+        in = in0;
+        in.ramp = 2 * in.ramp_max;
+        sp3_adapt_rank(&in, &rank);
+        rc = check_adapt_order(lcl_ti, &rank, expv, NELEM(expv));
+        ASSERT_EQ(rc, 0);
+        ASSERT_EQ(rank.llen_min, 0);
+    }
+
+    /* Minimizing read amp at its bound, with ingest throttled: root
+     * spills come first and optional jobs are deferred.
+     */
+    {
+        const enum sp3_job_type expv[] = {
+            jtype_root, jtype_node_len, jtype_ispill, jtype_leaf_size
+        };
+
+        in = in0;
+        in.goal = csched_adapt_goal_ramp;
+        in.ramp = in.ramp_max;
+        in.rspill_sval = 2 * THROTTLE_SENSOR_SCALE;
+        sp3_adapt_rank(&in, &rank);
+        rc = check_adapt_order(lcl_ti, &rank, expv, NELEM(expv));
+        ASSERT_EQ(rc, 0);
+        ASSERT_GT(rank.prio[jtype_root], 2 * rank.prio[jtype_ispill]);
+        ASSERT_EQ(rank.llen_min, 0);
+        ASSERT_EQ(rank.gmin, 10);
+
+        /* The throttle sensor's contribution is capped */
+        in.rspill_sval = 10 * THROTTLE_SENSOR_SCALE;
+        rc = rank.prio[jtype_root];
+        sp3_adapt_rank(&in, &rank);
+        ASSERT_EQ(rank.prio[jtype_root], rc);
+    }
+
+    /* Minimizing space amp compacts garbage while over the low water
+     * mark, even though within the bound.
+     */
+    {
+        const enum sp3_job_type expv[] = {
+            jtype_root, jtype_leaf_garbage, jtype_ispill, jtype_leaf_size,
+            jtype_node_idle, jtype_leaf_scatter
+        };
+
+        in = in0;
+        in.goal = csched_adapt_goal_samp;
+        in.samp = 140;
+        sp3_adapt_rank(&in, &rank);
+        rc = check_adapt_order(lcl_ti, &rank, expv, NELEM(expv));
+        ASSERT_EQ(rc, 0);
+        ASSERT_EQ(rank.gmin, 0);
+    }
+
+    /* A low leaf percentage raises the priority of internal spills.
+     */
+    {
+        const enum sp3_job_type expv[] = { jtype_root, jtype_ispill, jtype_leaf_size };
+
+        in = in0;
+        in.lpct = in.lpct_min / 2;
+        sp3_adapt_rank(&in, &rank);
+        rc = check_adapt_order(lcl_ti, &rank, expv, NELEM(expv));
+        ASSERT_EQ(rc, 0);
+        ASSERT_EQ(rank.prio[jtype_ispill], rank.prio[jtype_root]);
+    }
 }
 
 MTF_DEFINE_UTEST_PRE(test, t_sp3_create_nomem, pre_test)
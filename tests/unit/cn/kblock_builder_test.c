@@ -17,8 +17,11 @@
 #include <hse_ikvdb/limits.h>
 #include <hse_ikvdb/kvset_builder.h>
 #include <hse_ikvdb/mclass_policy.h>
+#include <hse_ikvdb/rtomb.h>
 
 #include <cn/kblock_builder.h>
+#include <cn/kblock_reader.h>
+#include <cn/kvs_mblk_desc.h>
 #include <cn/omf.h>
 #include <cn/blk_list.h>
 #include <cn/bloom_reader.h>
@@ -514,6 +517,165 @@ MTF_DEFINE_UTEST_PRE(test, t_kbb_finish_with_ptombs, test_setup)
     kbb_destroy(kbb);
 }
 
+struct rtomb_check {
+    struct mtf_test_info *lcl_ti;
+    const struct rtomb *  rtv;
+    uint                  rtc;
+    uint                  cnt;
+};
+
+static merr_t
+rtomb_check_visit(void *arg, const struct rtomb *rt)
+{
+    struct rtomb_check * rc = arg;
+    struct mtf_test_info *lcl_ti = rc->lcl_ti;
+    const struct rtomb * exp;
+
+    ASSERT_LT_RET(rc->cnt, rc->rtc, merr(EINVAL));
+
+    exp = rc->rtv + rc->cnt++;
+    ASSERT_EQ_RET(rt->rt_seqno, exp->rt_seqno, merr(EINVAL));
+    ASSERT_EQ_RET(rt->rt_slen, exp->rt_slen, merr(EINVAL));
+    ASSERT_EQ_RET(rt->rt_elen, exp->rt_elen, merr(EINVAL));
+    ASSERT_EQ_RET(0, memcmp(rt->rt_start, exp->rt_start, rt->rt_slen), merr(EINVAL));
+    ASSERT_EQ_RET(0, memcmp(rt->rt_end, exp->rt_end, rt->rt_elen), merr(EINVAL));
+
+    return 0;
+}
+
+/* Test: range tombstones survive a kbb_finish/kbr_read_rtombs round trip */
+MTF_DEFINE_UTEST_PRE(test, t_kbb_finish_with_rtombs, test_setup)
+{
+    struct kblock_builder *  kbb = 0;
+    struct blk_list          blks;
+    struct mpool_mcache_map *map;
+    struct kvs_mblk_desc     kbd;
+    struct mblock_props      props = { 0 };
+    struct rtomb_check       rc;
+    merr_t                   err;
+    uint                     i;
+
+    const struct rtomb rtv[] = {
+        { .rt_start = "ab", .rt_slen = 2, .rt_end = "ad", .rt_elen = 2, .rt_seqno = 7 },
+        { .rt_start = "a", .rt_slen = 1, .rt_end = "b", .rt_elen = 1, .rt_seqno = 3 },
+        { .rt_start = "c", .rt_slen = 1, .rt_end = "czzzzzzzz", .rt_elen = 9, .rt_seqno = 11 },
+    };
+
+    err = kbb_create(KBB_CREATE_ARGS);
+    ASSERT_EQ(err, 0);
+
+    err = add_entry(lcl_ti, kbb, 123, 0, 9, 0);
+    ASSERT_EQ(err, 0);
+
+    for (i = 0; i < NELEM(rtv); i++) {
+        err = kbb_add_rtomb(kbb, rtv + i);
+        ASSERT_EQ(err, 0);
+    }
+
+    err = kbb_finish(kbb, &blks, 0, 11);
+    ASSERT_EQ(err, 0);
+    ASSERT_GE(blks.n_blks, 1);
+
+    err = mpool_mcache_mmap(NULL, 1, &blks.blks[blks.n_blks - 1].bk_blkid, &map);
+    ASSERT_EQ(err, 0);
+
+    err = kbr_get_kblock_desc(NULL, map, &props, 0, blks.blks[blks.n_blks - 1].bk_blkid, &kbd);
+    ASSERT_EQ(err, 0);
+
+    /* Tombstones come back in the order in which they were added. */
+    rc.lcl_ti = lcl_ti;
+    rc.rtv = rtv;
+    rc.rtc = NELEM(rtv);
+    rc.cnt = 0;
+
+    err = kbr_read_rtombs(&kbd, rtomb_check_visit, &rc);
+    ASSERT_EQ(err, 0);
+    ASSERT_EQ(rc.cnt, NELEM(rtv));
+
+    mpool_mcache_munmap(map);
+    blk_list_free(&blks);
+    kbb_destroy(kbb);
+
+    /* A kblock without range tombstones visits nothing. */
+    err = kbb_create(KBB_CREATE_ARGS);
+    ASSERT_EQ(err, 0);
+
+    err = add_entry(lcl_ti, kbb, 123, 0, 9, 0);
+    ASSERT_EQ(err, 0);
+
+    err = kbb_finish(kbb, &blks, 0, 0);
+    ASSERT_EQ(err, 0);
+
+    err = mpool_mcache_mmap(NULL, 1, &blks.blks[0].bk_blkid, &map);
+    ASSERT_EQ(err, 0);
+
+    err = kbr_get_kblock_desc(NULL, map, &props, 0, blks.blks[0].bk_blkid, &kbd);
+    ASSERT_EQ(err, 0);
+
+    rc.cnt = 0;
+    err = kbr_read_rtombs(&kbd, rtomb_check_visit, &rc);
+    ASSERT_EQ(err, 0);
+    ASSERT_EQ(rc.cnt, 0);
+
+    mpool_mcache_munmap(map);
+    blk_list_free(&blks);
+    kbb_destroy(kbb);
+}
+
+static u64
+rtomb_seqno_str(const struct rtomb *rtv, uint rtc, const char *key, u64 view)
+{
+    struct key_obj ko;
+
+    key2kobj(&ko, key, strlen(key));
+
+    return rtomb_seqno(rtv, rtc, &ko, view);
+}
+
+/* Test: rtomb_seqno() on a sorted vector of nested and overlapping ranges */
+MTF_DEFINE_UTEST(test, t_rtomb_seqno)
+{
+    struct rtomb rtv[] = {
+        { .rt_start = "m", .rt_slen = 1, .rt_end = "n", .rt_elen = 1, .rt_seqno = 40 },
+        { .rt_start = "b", .rt_slen = 1, .rt_end = "y", .rt_elen = 1, .rt_seqno = 10 },
+        { .rt_start = "c", .rt_slen = 1, .rt_end = "e", .rt_elen = 1, .rt_seqno = 30 },
+        { .rt_start = "d", .rt_slen = 1, .rt_end = "g", .rt_elen = 1, .rt_seqno = 20 },
+        { .rt_start = "z", .rt_slen = 1, .rt_end = "zz", .rt_elen = 2, .rt_seqno = 50 },
+    };
+    const uint rtc = NELEM(rtv);
+    uint       i;
+
+    rtomb_sort(rtv, rtc);
+
+    for (i = 1; i < rtc; i++) {
+        const struct rtomb *prev = rtv + i - 1;
+
+        ASSERT_LE(keycmp(prev->rt_start, prev->rt_slen, rtv[i].rt_start, rtv[i].rt_slen), 0);
+    }
+
+    /* "b".."y" stays the max end behind the shorter ranges it encloses */
+    ASSERT_EQ(0, memcmp(rtv[rtc - 2].rt_maxend, "y", 1));
+
+    ASSERT_EQ(0, rtomb_seqno_str(rtv, rtc, "a", UINT64_MAX));
+    ASSERT_EQ(10, rtomb_seqno_str(rtv, rtc, "b", UINT64_MAX));
+    ASSERT_EQ(30, rtomb_seqno_str(rtv, rtc, "c", UINT64_MAX));
+    ASSERT_EQ(30, rtomb_seqno_str(rtv, rtc, "dz", UINT64_MAX));
+    ASSERT_EQ(20, rtomb_seqno_str(rtv, rtc, "e", UINT64_MAX));
+    ASSERT_EQ(10, rtomb_seqno_str(rtv, rtc, "g", UINT64_MAX));
+    ASSERT_EQ(40, rtomb_seqno_str(rtv, rtc, "m", UINT64_MAX));
+    ASSERT_EQ(10, rtomb_seqno_str(rtv, rtc, "n", UINT64_MAX));
+    ASSERT_EQ(0, rtomb_seqno_str(rtv, rtc, "y", UINT64_MAX));
+    ASSERT_EQ(50, rtomb_seqno_str(rtv, rtc, "z", UINT64_MAX));
+    ASSERT_EQ(0, rtomb_seqno_str(rtv, rtc, "zz", UINT64_MAX));
+
+    /* Tombstones newer than the view are invisible. */
+    ASSERT_EQ(20, rtomb_seqno_str(rtv, rtc, "d", 29));
+    ASSERT_EQ(10, rtomb_seqno_str(rtv, rtc, "m", 39));
+    ASSERT_EQ(0, rtomb_seqno_str(rtv, rtc, "m", 9));
+
+    ASSERT_EQ(0, rtomb_seqno_str(rtv, 0, "m", UINT64_MAX));
+}
+
 /* Test: kbb_finish handling of various errors */
 MTF_DEFINE_UTEST_PRE(test, t_kbb_finish_fail, test_setup)
 {
@@ -14,6 +14,10 @@
 
 #include <hse/limits.h>
 
+#include <cn/kblock_builder.h>
+#include <cn/kvset_builder_internal.h>
+#include <cn/cn_vcomp.h>
+
 #include <mocks/mock_kbb_vbb.h>
 
 int
@@ -336,6 +340,282 @@ MTF_DEFINE_UTEST_PREPOST(test, t_kvset_builder_get_mblocks, pre, post)
     kvset_builder_destroy(bld);
 }
 
+/* Add a compressible value to a fresh builder and return the vtype and
+ * compressed length that it records in the key's kmd.
+ */
+static merr_t
+vcomp_add_val(const struct cn_vcomp *vc, enum kmd_vtype *vtype, uint *complen)
+{
+    struct kvset_builder *bld = 0;
+    static char           val[4000];
+    uint                  vbidx, vboff, vlen;
+    size_t                off = 0;
+    u64                   seq;
+    merr_t                err;
+
+    memset(val, 'A', sizeof(val));
+
+    err = KVSET_BUILDER_CREATE();
+    if (err)
+        return err;
+
+    err = kvset_builder_set_vcomp(bld, vc);
+    if (!err)
+        err = kvset_builder_add_val(bld, 1, val, sizeof(val), 0);
+
+    if (!err) {
+        *complen = 0;
+        kmd_type_seq(bld->main.kmd, &off, vtype, &seq);
+        if (*vtype == vtype_cval)
+            kmd_cval(bld->main.kmd, &off, &vbidx, &vboff, &vlen, complen);
+        else
+            kmd_val(bld->main.kmd, &off, &vbidx, &vboff, &vlen);
+
+        if (vlen != sizeof(val))
+            err = merr(EBUG);
+    }
+
+    kvset_builder_destroy(bld);
+
+    return err;
+}
+
+MTF_DEFINE_UTEST_PREPOST(test, t_kvset_builder_vcomp_defer, pre, post)
+{
+    struct kvs_rparams rparams = kvs_rparams_defaults();
+    struct cn_vcomp *  vc = NULL;
+    enum kmd_vtype     vtype;
+    uint               complen;
+    merr_t             err;
+
+    /* Puts don't compress values, so without compaction's compressor
+     * (as in ingest) the value is stored as is.
+     */
+    err = vcomp_add_val(NULL, &vtype, &complen);
+    ASSERT_EQ(0, err);
+    ASSERT_EQ(vtype_val, vtype);
+    ASSERT_EQ(0, complen);
+
+    rparams.value_compression = VCOMP_ALGO_LZ4;
+    ASSERT_EQ(VCOMP_ALGO_NONE, cn_vcomp_algo(&rparams));
+
+    /* Deferring value compression hands the algorithm to compaction,
+     * whose builders then write the value compressed.
+     */
+    rparams.vcomp_defer = true;
+    ASSERT_EQ(VCOMP_ALGO_LZ4, cn_vcomp_algo(&rparams));
+
+    err = cn_vcomp_create(cn_vcomp_algo(&rparams), rparams.cn_vcomp_level,
+                          rparams.cn_vcomp_blksz, NULL, 0, &vc);
+    ASSERT_EQ(0, err);
+
+    err = vcomp_add_val(vc, &vtype, &complen);
+    ASSERT_EQ(0, err);
+    ASSERT_EQ(vtype_cval, vtype);
+    ASSERT_GT(complen, 0);
+    ASSERT_LT(complen, 4000);
+
+    cn_vcomp_destroy(vc);
+
+    /* An explicit cn algorithm takes precedence.
+     */
+    rparams.cn_vcomp = VCOMP_ALGO_ZSTD;
+    ASSERT_EQ(VCOMP_ALGO_ZSTD, cn_vcomp_algo(&rparams));
+}
+
+MTF_DEFINE_UTEST_PREPOST(test, t_kvset_builder_part, pre, post)
+{
+    struct kvset_builder *bldv[3];
+    struct kvset_mblocks  blks;
+    struct key_obj        ko;
+    char                  key[16], val[100];
+    merr_t                err;
+    uint                  vblkc, i, pass;
+    u32                   api;
+
+    memset(val, 'x', sizeof(val));
+
+    for (i = 0; i < NELEM(bldv); ++i) {
+        err = kvset_builder_create(&bldv[i], (void *)-1, 0, i + 1);
+        ASSERT_EQ(0, err);
+
+        kvset_builder_part_begin(bldv[i]);
+    }
+
+    /* Each partition gets one key with a vblock value (100 bytes), an
+     * inline value (4 bytes) and a tombstone.  Only the vblock values
+     * are accounted for in the value pass.
+     */
+    for (pass = 0; pass < 2; ++pass) {
+        for (i = 0; i < NELEM(bldv); ++i) {
+            err = kvset_builder_add_val(bldv[i], 30 + i, val, sizeof(val), 0);
+            ASSERT_EQ(0, err);
+            err = kvset_builder_add_val(bldv[i], 20 + i, val, 4, 0);
+            ASSERT_EQ(0, err);
+            err = kvset_builder_add_val(bldv[i], 10 + i, HSE_CORE_TOMB_REG, 0, 0);
+            ASSERT_EQ(0, err);
+
+            snprintf(key, sizeof(key), "key%u", i);
+            key2kobj(&ko, key, strlen(key));
+            err = kvset_builder_add_key(bldv[i], &ko);
+            ASSERT_EQ(0, err);
+
+            if (pass == 0) {
+                err = kvset_builder_part_vblocks(bldv[i], &vblkc);
+                ASSERT_EQ(0, err);
+                ASSERT_EQ(0, vblkc); /* vbb_finish() is mocked */
+
+                kvset_builder_part_rebase(bldv[i], i * 7);
+            }
+        }
+    }
+
+    err = kvset_builder_join(bldv, 0, &blks);
+    ASSERT_EQ(EINVAL, merr_errno(err));
+
+    api = mapi_idx_kbb_finish;
+    mapi_inject(api, api + 1234);
+    err = kvset_builder_join(bldv, NELEM(bldv), &blks);
+    ASSERT_EQ(api + 1234, err);
+    mapi_inject_unset(api);
+
+    memset(&blks, 0, sizeof(blks));
+    err = kvset_builder_join(bldv, NELEM(bldv), &blks);
+    ASSERT_EQ(0, err);
+    ASSERT_EQ(NELEM(bldv) * sizeof(val), blks.bl_vused);
+    ASSERT_EQ(10, blks.bl_seqno_min);
+    ASSERT_EQ(30 + NELEM(bldv) - 1, blks.bl_seqno_max);
+
+    kvset_mblocks_destroy(&blks);
+
+    for (i = 0; i < NELEM(bldv); ++i)
+        kvset_builder_destroy(bldv[i]);
+}
+
+MTF_DEFINE_UTEST_PREPOST(test, t_kvset_builder_part_replay, pre, post)
+{
+    struct kvset_builder *bldv[3];
+    struct kvset_mblocks  blks;
+    struct key_obj        ko;
+    char                  key[16], val[100];
+    merr_t                err;
+    uint                  vblkc, i;
+
+    memset(val, 'x', sizeof(val));
+
+    for (i = 0; i < NELEM(bldv); ++i) {
+        err = kvset_builder_create(&bldv[i], (void *)-1, 0, 1);
+        ASSERT_EQ(0, err);
+
+        kvset_builder_part_begin(bldv[i]);
+        kvset_builder_part_log(bldv[i]);
+    }
+
+    /* The entries are added only once, and the last builder is empty.
+     */
+    for (i = 0; i < NELEM(bldv) - 1; ++i) {
+        err = kvset_builder_add_val(bldv[i], 30 + i, val, sizeof(val), 0);
+        ASSERT_EQ(0, err);
+        err = kvset_builder_add_val(bldv[i], 20 + i, val, 4, 0);
+        ASSERT_EQ(0, err);
+        err = kvset_builder_add_val(bldv[i], 10 + i, HSE_CORE_TOMB_REG, 0, 0);
+        ASSERT_EQ(0, err);
+
+        snprintf(key, sizeof(key), "key%u", i);
+        key2kobj(&ko, key, strlen(key));
+        err = kvset_builder_add_key(bldv[i], &ko);
+        ASSERT_EQ(0, err);
+    }
+
+    for (i = 0; i < NELEM(bldv); ++i) {
+        err = kvset_builder_part_vblocks(bldv[i], &vblkc);
+        ASSERT_EQ(0, err);
+
+        kvset_builder_part_rebase(bldv[i], i * 7);
+
+        err = kvset_builder_part_replay(bldv[i]);
+        ASSERT_EQ(0, err);
+    }
+
+    memset(&blks, 0, sizeof(blks));
+    err = kvset_builder_join(bldv, NELEM(bldv), &blks);
+    ASSERT_EQ(0, err);
+    ASSERT_EQ((NELEM(bldv) - 1) * sizeof(val), blks.bl_vused);
+    ASSERT_EQ(10, blks.bl_seqno_min);
+    ASSERT_EQ(30 + NELEM(bldv) - 2, blks.bl_seqno_max);
+
+    kvset_mblocks_destroy(&blks);
+
+    for (i = 0; i < NELEM(bldv); ++i)
+        kvset_builder_destroy(bldv[i]);
+}
+
+MTF_DEFINE_UTEST_PREPOST(test, t_kvset_builder_part_unlog, pre, post)
+{
+    struct kvset_builder *bld;
+    struct kvset_mblocks  blks;
+    struct key_obj        ko;
+    char                  key[1024];
+    merr_t                err;
+    uint                  vblkc, keyc, i;
+
+    err = kvset_builder_create(&bld, (void *)-1, 0, 1);
+    ASSERT_EQ(0, err);
+
+    kvset_builder_part_begin(bld);
+    ASSERT_FALSE(kvset_builder_part_logged(bld));
+
+    kvset_builder_part_log(bld);
+    ASSERT_TRUE(kvset_builder_part_logged(bld));
+
+    /* Add large keys until the log is discarded, at which point the
+     * entries must be added again for the key pass.
+     */
+    memset(key, 'k', sizeof(key));
+    keyc = 0;
+
+    while (kvset_builder_part_logged(bld)) {
+        ASSERT_LT(keyc, 2 * KVSET_BUILDER_LOG_MAX / sizeof(key));
+
+        err = kvset_builder_add_val(bld, 10, HSE_CORE_TOMB_REG, 0, 0);
+        ASSERT_EQ(0, err);
+
+        snprintf(key, sizeof(key), "%08u", keyc++);
+        key[8] = 'k';
+        key2kobj(&ko, key, sizeof(key));
+        err = kvset_builder_add_key(bld, &ko);
+        ASSERT_EQ(0, err);
+    }
+
+    ASSERT_GT(keyc, KVSET_BUILDER_LOG_MAX / (2 * sizeof(key)));
+
+    err = kvset_builder_part_vblocks(bld, &vblkc);
+    ASSERT_EQ(0, err);
+
+    kvset_builder_part_rebase(bld, 0);
+    ASSERT_FALSE(kvset_builder_part_logged(bld));
+
+    for (i = 0; i < keyc; ++i) {
+        err = kvset_builder_add_val(bld, 10, HSE_CORE_TOMB_REG, 0, 0);
+        ASSERT_EQ(0, err);
+
+        snprintf(key, sizeof(key), "%08u", i);
+        key[8] = 'k';
+        key2kobj(&ko, key, sizeof(key));
+        err = kvset_builder_add_key(bld, &ko);
+        ASSERT_EQ(0, err);
+    }
+
+    memset(&blks, 0, sizeof(blks));
+    err = kvset_builder_join(&bld, 1, &blks);
+    ASSERT_EQ(0, err);
+    ASSERT_EQ(10, blks.bl_seqno_min);
+    ASSERT_EQ(10, blks.bl_seqno_max);
+
+    kvset_mblocks_destroy(&blks);
+    kvset_builder_destroy(bld);
+}
+
 MTF_DEFINE_UTEST_PREPOST(test, t_kvset_build_destroy, pre, post)
 {
     kvset_builder_destroy(NULL);
@@ -182,6 +182,33 @@ t_udata_init(
     return u->return_code;
 }
 
+static uint udata_fini_calls;
+static uint udata_fail_bnum = UINT_MAX;
+
+static merr_t
+t_udata_init_fail(
+    struct mbset *       mbs,
+    uint                 bnum,
+    uint *               argcp,
+    u64 *                argv,
+    struct mblock_props *props,
+    void *               rock)
+{
+    t_udata_init(mbs, bnum, argcp, argv, props, rock);
+
+    return bnum == udata_fail_bnum ? merr(EINVAL) : 0;
+}
+
+static void
+t_udata_fini(struct mbset *mbs, uint bnum, void *rock)
+{
+    struct udata *u = rock;
+
+    VERIFY_EQ(u->bnum, bnum);
+    VERIFY_EQ(u->id, bnum2id(bnum));
+    udata_fini_calls++;
+}
+
 static merr_t
 t_udata_update(
     struct mbset *       mbs,
@@ -230,7 +257,7 @@ t_mbs_create(struct mtf_test_info *lcl_ti, uint idc, u64 **idv_out, struct mbset
     idv = idv_alloc(idc);
     ASSERT_NE_RET(idv, NULL, -1);
 
-    err = mbset_create(ds, idc, idv, usz, ufn, 0, MBLOCKS_MAX, &mbs);
+    err = mbset_create(ds, idc, idv, usz, ufn, NULL, 0, MBLOCKS_MAX, &mbs);
     ASSERT_EQ_RET(err, 0, -1);
 
     *idv_out = idv;
@@ -297,7 +324,7 @@ MTF_DEFINE_UTEST_PREPOST(test, t_mbset_create_simple, pre, post)
     idv = idv_alloc(idc);
     ASSERT_NE(idv, NULL);
 
-    err = mbset_create(ds, idc, idv, usz, ufn, 0, MBLOCKS_MAX, &mbs);
+    err = mbset_create(ds, idc, idv, usz, ufn, NULL, 0, MBLOCKS_MAX, &mbs);
     ASSERT_EQ(err, 0);
     mbset_put_ref(mbs);
 
@@ -314,16 +341,16 @@ MTF_DEFINE_UTEST_PREPOST(test, t_mbset_create_invalid_params, pre, post)
     idv = idv_alloc(idc);
     ASSERT_NE(idv, NULL);
 
-    err = mbset_create(0, idc, idv, usz, ufn, 0, MBLOCKS_MAX, &mbs);
+    err = mbset_create(0, idc, idv, usz, ufn, NULL, 0, MBLOCKS_MAX, &mbs);
     ASSERT_NE(err, 0);
 
-    err = mbset_create(ds, 0, idv, usz, ufn, 0, MBLOCKS_MAX, &mbs);
+    err = mbset_create(ds, 0, idv, usz, ufn, NULL, 0, MBLOCKS_MAX, &mbs);
     ASSERT_NE(err, 0);
 
-    err = mbset_create(ds, idc, 0, usz, ufn, 0, MBLOCKS_MAX, &mbs);
+    err = mbset_create(ds, idc, 0, usz, ufn, NULL, 0, MBLOCKS_MAX, &mbs);
     ASSERT_NE(err, 0);
 
-    err = mbset_create(ds, idc, idv, usz, ufn, 0, MBLOCKS_MAX, 0);
+    err = mbset_create(ds, idc, idv, usz, ufn, NULL, 0, MBLOCKS_MAX, 0);
     ASSERT_NE(err, 0);
 
     mapi_safe_free(idv);
@@ -347,7 +374,7 @@ MTF_DEFINE_UTEST_PREPOST(test, t_mbset_create_alloc_fail, pre, post)
     num_allocs = 2;
     for (i = 0; i <= num_allocs; i++) {
         mapi_inject_once_ptr(mapi_idx_malloc, i + 1, 0);
-        err = mbset_create(ds, idc, idv, usz, ufn, 0, MBLOCKS_MAX, &mbs);
+        err = mbset_create(ds, idc, idv, usz, ufn, NULL, 0, MBLOCKS_MAX, &mbs);
         if (i < num_allocs) {
             ASSERT_EQ(merr_errno(err), ENOMEM);
         } else {
@@ -421,7 +448,7 @@ MTF_DEFINE_UTEST_PREPOST(test, t_mbset_create_fail, pre, post)
              */
             mapi_inject_unset(api);
 
-            err = mbset_create(ds, idc, idv, usz, ufn, 0, MBLOCKS_MAX, &mbs);
+            err = mbset_create(ds, idc, idv, usz, ufn, NULL, 0, MBLOCKS_MAX, &mbs);
             ASSERT_EQ(err, 0);
             num_allocs = mapi_calls(api);
 
@@ -441,7 +468,7 @@ MTF_DEFINE_UTEST_PREPOST(test, t_mbset_create_fail, pre, post)
                 else
                     mapi_inject_once(api, i + 1, rc);
 
-                err = mbset_create(ds, idc, idv, usz, ufn, 0, MBLOCKS_MAX, &mbs);
+                err = mbset_create(ds, idc, idv, usz, ufn, NULL, 0, MBLOCKS_MAX, &mbs);
 
                 if (i < num_allocs) {
                     ASSERT_NE(err, 0);
@@ -486,7 +513,7 @@ MTF_DEFINE_UTEST_PREPOST(test, t_mbset_callback, pre, post)
 
         mapi_inject(mapi_idx_mpool_mblock_delete, 0);
 
-        err = mbset_create(ds, idc, idv, usz, ufn, 0, MBLOCKS_MAX, &mbs);
+        err = mbset_create(ds, idc, idv, usz, ufn, NULL, 0, MBLOCKS_MAX, &mbs);
         ASSERT_EQ(err, 0);
 
         switch (i) {
@@ -545,7 +572,7 @@ MTF_DEFINE_UTEST_PREPOST(test, t_mbset_madvise, pre, post)
     idv = idv_alloc(idc);
     ASSERT_NE(idv, NULL);
 
-    err = mbset_create(ds, idc, idv, usz, ufn, 0, MBLOCKS_MAX, &mbs);
+    err = mbset_create(ds, idc, idv, usz, ufn, NULL, 0, MBLOCKS_MAX, &mbs);
     ASSERT_EQ(err, 0);
 
     /* This madvise will fail, but we'll get coverage...
@@ -569,7 +596,7 @@ MTF_DEFINE_UTEST_PREPOST(test, t_mbset_mincore, pre, post)
     idv = idv_alloc(idc);
     ASSERT_NE(idv, NULL);
 
-    err = mbset_create(ds, idc, idv, usz, ufn, 0, MBLOCKS_MAX, &mbs);
+    err = mbset_create(ds, idc, idv, usz, ufn, NULL, 0, MBLOCKS_MAX, &mbs);
     ASSERT_EQ(err, 0);
 
     err = mbset_mincore(NULL, &rss, &vss);
@@ -613,7 +640,7 @@ MTF_DEFINE_UTEST_PREPOST(test, t_mbset_apply, pre, post)
     idv = idv_alloc(idc);
     ASSERT_NE(idv, NULL);
 
-    err = mbset_create(ds, idc, idv, usz, ufn, 0, MBLOCKS_MAX, &mbs);
+    err = mbset_create(ds, idc, idv, usz, ufn, NULL, 0, MBLOCKS_MAX, &mbs);
     ASSERT_EQ(err, 0);
 
     mbset_apply(NULL, t_udata_update, &argc, argv);
@@ -633,4 +660,44 @@ MTF_DEFINE_UTEST_PREPOST(test, t_mbset_apply, pre, post)
     mapi_safe_free(idv);
 }
 
+MTF_DEFINE_UTEST_PREPOST(test, t_mbset_udata_fini, pre, post)
+{
+    u64 *         idv;
+    uint          idc = 5;
+    struct mbset *mbs;
+    merr_t        err;
+
+    idv = idv_alloc(idc);
+    ASSERT_NE(idv, NULL);
+
+    /* The destructor releases the udata of every block.
+     */
+    udata_fini_calls = 0;
+    udata_fail_bnum = UINT_MAX;
+
+    err = mbset_create(ds, idc, idv, usz, t_udata_init_fail, t_udata_fini, 0, MBLOCKS_MAX, &mbs);
+    ASSERT_EQ(err, 0);
+    ASSERT_EQ(udata_fini_calls, 0);
+
+    mbset_get_ref(mbs);
+    mbset_put_ref(mbs);
+    ASSERT_EQ(udata_fini_calls, 0);
+
+    mbset_put_ref(mbs);
+    ASSERT_EQ(udata_fini_calls, idc);
+
+    /* A failed constructor releases only the blocks it initialized.
+     */
+    udata_fini_calls = 0;
+    udata_fail_bnum = 3;
+
+    err = mbset_create(ds, idc, idv, usz, t_udata_init_fail, t_udata_fini, 0, MBLOCKS_MAX, &mbs);
+    ASSERT_EQ(merr_errno(err), EINVAL);
+    ASSERT_EQ(udata_fini_calls, 3);
+
+    udata_fail_bnum = UINT_MAX;
+
+    mapi_safe_free(idv);
+}
+
 MTF_END_UTEST_COLLECTION(test);
@@ -1565,6 +1565,7 @@ test_prehook(struct mtf_test_info *info)
     mapi_inject_ptr(mapi_idx_cn_tree_get_khashmap, NULL);
     mapi_inject_ptr(mapi_idx_cn_tree_get_cn, NULL);
     mapi_inject(mapi_idx_kvset_builder_set_merge_stats, 0);
+    mapi_inject(mapi_idx_kvset_builder_set_iogov, 0);
 
     return 0;
 }
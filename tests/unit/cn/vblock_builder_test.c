@@ -10,16 +10,21 @@
 #include <hse_util/inttypes.h>
 #include <hse_util/logging.h>
 #include <hse_util/page.h>
+#include <hse_util/xrand.h>
 
 #include <hse_ikvdb/tuple.h>
 #include <hse_ikvdb/limits.h>
 #include <hse_ikvdb/kvset_builder.h>
 #include <hse_ikvdb/kvs_rparams.h>
+#include <hse_ikvdb/omf_kmd.h>
 
 #include <hse/limits.h>
 
 #include <cn/vblock_builder.h>
 #include <cn/blk_list.h>
+#include <cn/cn_vcomp.h>
+#include <cn/omf.h>
+#include <cn/vblock_reader.h>
 
 #include <mocks/mock_mpool.h>
 
@@ -591,4 +596,358 @@ MTF_DEFINE_UTEST_PRE(test, t_destroy_with_3_vblock, test_setup)
     run_test_case(lcl_ti, tc_destroy, 3);
 }
 
+#define CBLK_SZ (4096)
+#define CBLK_NVALS (600)
+
+struct cblk_val {
+    const void *vdata;
+    uint        vlen;
+    u8          kmd[32];
+};
+
+/* Test: values packed into compressed blocks read back via their kmd */
+MTF_DEFINE_UTEST_PRE(test, t_vbb_blk_entry_roundtrip, test_setup)
+{
+    struct vblock_builder *  vbb;
+    struct cn_vcomp *        vc;
+    struct blk_list          blks;
+    struct mpool_mcache_map *map;
+    struct vblock_desc *     vbdv;
+    struct cblk_val *        valv;
+    struct xrand             xr;
+    u64                      blkid, argv[1];
+    uint                     vgroups = 0;
+    uint                     vbidx, vboff, boff, vlen, end;
+    uint                     i;
+    u8 *                     noise;
+    merr_t                   err;
+
+    /* Lengths that fill a block exactly, overflow it by one byte,
+     * and exceed the quarter-block threshold used by compaction.
+     */
+    const uint vlenv[] = { 1, 7, 100, 1023, 1024, CBLK_SZ - 1, 1, CBLK_SZ, 2048, 2048, 2049 };
+
+    valv = calloc(CBLK_NVALS, sizeof(*valv));
+    ASSERT_NE(NULL, valv);
+
+    noise = malloc(CBLK_SZ * 2);
+    ASSERT_NE(NULL, noise);
+
+    xrand_init(&xr, 42);
+    for (i = 0; i < CBLK_SZ * 2; i++)
+        noise[i] = xrand64(&xr);
+
+    err = cn_vcomp_create(VCOMP_ALGO_LZ4, 0, CBLK_SZ, NULL, 0, &vc);
+    ASSERT_EQ(err, 0);
+
+    err = vbb_create(VBB_CREATE_ARGS);
+    ASSERT_EQ(err, 0);
+
+    err = vbb_set_comp(vbb, vc);
+    ASSERT_EQ(err, 0);
+
+    /* A value larger than the block size cannot be packed */
+    err = vbb_add_blk_entry(vbb, workbuf, CBLK_SZ + 1, &blkid, &vbidx, &vboff, &boff);
+    ASSERT_EQ(merr_errno(err), EINVAL);
+
+    end = 0;
+
+    for (i = 0; i < CBLK_NVALS; i++) {
+        struct cblk_val *v = valv + i;
+        size_t           off = 0;
+
+        v->vlen = vlenv[i % NELEM(vlenv)];
+
+        /* The second half of the values doesn't compress. */
+        if (i < CBLK_NVALS / 2)
+            v->vdata = workbuf + (i * 13) % (WORKBUF_SIZE - CBLK_SZ);
+        else
+            v->vdata = noise + (i * 13) % CBLK_SZ;
+
+        /* Every so often interleave an unpacked value, which closes the open block. */
+        if (i % 97 == 96) {
+            err = vbb_add_entry(vbb, v->vdata, v->vlen, &blkid, &vbidx, &vboff);
+            ASSERT_EQ(err, 0);
+
+            kmd_add_val(v->kmd, &off, i, vbidx, vboff, v->vlen);
+            v->vlen = 0;
+
+            end = max_t(uint, end, vboff + vlenv[i % NELEM(vlenv)]);
+            continue;
+        }
+
+        err = vbb_add_blk_entry(vbb, v->vdata, v->vlen, &blkid, &vbidx, &vboff, &boff);
+        ASSERT_EQ(err, 0);
+        ASSERT_LE(boff + v->vlen, CBLK_SZ);
+
+        kmd_add_bval(v->kmd, &off, i, vbidx, vboff, v->vlen, boff);
+        ASSERT_LE(off, sizeof(v->kmd));
+
+        end = max_t(uint, end, vboff + sizeof(struct vblock_cblk_omf) + CBLK_SZ);
+    }
+
+    err = vbb_finish(vbb, &blks);
+    ASSERT_EQ(err, 0);
+    ASSERT_GE(blks.n_blks, 1);
+
+    vbdv = calloc(blks.n_blks, sizeof(*vbdv));
+    ASSERT_NE(NULL, vbdv);
+
+    err = mpool_mcache_mmap(NULL, blks.n_blks, &blks.blks[0].bk_blkid, &map);
+    ASSERT_EQ(err, 0);
+
+    for (i = 0; i < blks.n_blks; i++) {
+        struct mblock_props props = {
+            .mpr_objid = blks.blks[i].bk_blkid,
+            .mpr_write_len = PAGE_SIZE + end,
+        };
+
+        err = vbr_desc_read(NULL, map, i, &vgroups, argv, &props, vbdv + i);
+        ASSERT_EQ(err, 0);
+        ASSERT_EQ(vbdv[i].vbd_calgo, VBLOCK_CALGO_LZ4);
+    }
+
+    for (i = 0; i < CBLK_NVALS; i++) {
+        struct cblk_val *v = valv + i;
+        enum kmd_vtype   vtype;
+        const void *     vdata;
+        size_t           off = 0;
+        u64              seq;
+
+        kmd_type_seq(v->kmd, &off, &vtype, &seq);
+        ASSERT_EQ(seq, i);
+
+        if (!v->vlen) {
+            ASSERT_EQ(vtype, vtype_val);
+            continue;
+        }
+
+        ASSERT_EQ(vtype, vtype_bval);
+
+        kmd_bval(v->kmd, &off, &vbidx, &vboff, &vlen, &boff);
+        ASSERT_EQ(vlen, v->vlen);
+        ASSERT_LT(vbidx, blks.n_blks);
+
+        err = vbr_cblk_value(vbdv + vbidx, vboff, NULL, boff, vlen, &vdata);
+        ASSERT_EQ(err, 0);
+        ASSERT_EQ(0, memcmp(vdata, v->vdata, vlen));
+
+        /* Reading past the end of the block is detected */
+        err = vbr_cblk_value(vbdv + vbidx, vboff, NULL, CBLK_SZ, 1, &vdata);
+        ASSERT_EQ(merr_errno(err), EPROTO);
+    }
+
+    for (i = 0; i < blks.n_blks; i++)
+        vbr_desc_destroy(vbdv + i);
+
+    mpool_mcache_munmap(map);
+    free(vbdv);
+    blk_list_free(&blks);
+    vbb_destroy(vbb);
+    cn_vcomp_destroy(vc);
+    free(noise);
+    free(valv);
+}
+
+#ifdef HAVE_ZSTD
+#include <hse_util/compression_zstd.h>
+
+#define ZVAL_CNT    (2000)
+#define ZVAL_LENMAX (128)
+
+struct zval {
+    char vdata[ZVAL_LENMAX];
+    uint vlen;
+    uint vboff;
+    uint complen;
+};
+
+/* Build a vblock of values compressed by @vc, then read it back via a
+ * vblock descriptor and return the descriptor and the mcache map.
+ */
+static int
+zval_vblock_build(
+    struct mtf_test_info *    lcl_ti,
+    const struct cn_vcomp *   vc,
+    struct zval *             zvalv,
+    const struct zval *       srcv,
+    struct blk_list *         blks,
+    struct mpool_mcache_map **map,
+    struct vblock_desc *      vbd)
+{
+    struct vblock_builder *vbb;
+    char                   cbuf[ZVAL_LENMAX];
+    u64                    blkid, argv[1];
+    uint                   vgroups = 0;
+    uint                   vbidx, end, i;
+    merr_t                 err;
+
+    struct mblock_props props = { 0 };
+
+    err = vbb_create(VBB_CREATE_ARGS);
+    ASSERT_EQ_RET(err, 0, -1);
+
+    err = vbb_set_comp(vbb, vc);
+    ASSERT_EQ_RET(err, 0, -1);
+
+    for (i = end = 0; i < ZVAL_CNT; i++) {
+        const void *vdata = srcv[i].vdata;
+        uint        vlen = srcv[i].vlen;
+
+        zvalv[i].complen = 0;
+
+        err = cn_vcomp_compress(vc, vdata, vlen, cbuf, vlen - 1, &zvalv[i].complen);
+        if (!err)
+            vdata = cbuf;
+        else
+            zvalv[i].complen = 0;
+
+        err = vbb_add_entry(vbb, vdata, zvalv[i].complen ?: vlen, &blkid, &vbidx,
+                            &zvalv[i].vboff);
+        ASSERT_EQ_RET(err, 0, -1);
+        ASSERT_EQ_RET(vbidx, 0, -1);
+
+        end = zvalv[i].vboff + (zvalv[i].complen ?: vlen);
+    }
+
+    err = vbb_finish(vbb, blks);
+    ASSERT_EQ_RET(err, 0, -1);
+    ASSERT_EQ_RET(blks->n_blks, 1, -1);
+    vbb_destroy(vbb);
+
+    err = mpool_mcache_mmap(NULL, 1, &blks->blks[0].bk_blkid, map);
+    ASSERT_EQ_RET(err, 0, -1);
+
+    props.mpr_objid = blks->blks[0].bk_blkid;
+    props.mpr_write_len = ALIGN(sizeof(struct vblock_hdr_omf) + vc->cv_dictlen, PAGE_SIZE) + end;
+
+    err = vbr_desc_read(NULL, *map, 0, &vgroups, argv, &props, vbd);
+    ASSERT_EQ_RET(err, 0, -1);
+    ASSERT_EQ_RET(vbd->vbd_calgo, vc->cv_calgo, -1);
+    ASSERT_EQ_RET(vbd->vbd_dictlen, vc->cv_dictlen, -1);
+    ASSERT_EQ_RET(vbd->vbd_dictid, vc->cv_dictid, -1);
+
+    if (vc->cv_dictlen > 0)
+        ASSERT_EQ_RET(0, memcmp(vbd->vbd_dict, vc->cv_dict, vc->cv_dictlen), -1);
+
+    return 0;
+}
+
+/* Read back values from a v3 vblock compressed with a zstd dictionary,
+ * and transcode them to an lz4 vblock the way spill does.
+ */
+MTF_DEFINE_UTEST_PRE(test, t_vbb_zstd_dict_transcode, test_setup)
+{
+    struct cn_vcomp *        zvc, *lvc;
+    struct mpool_mcache_map *zmap, *lmap;
+    struct vblock_desc       zvbd, zvbd2, lvbd;
+    struct blk_list          zblks, lblks;
+    struct zval *            srcv, *zvalv, *lvalv;
+    size_t *                 samplev;
+    char *                   samples, *dict;
+    char                     dbuf[ZVAL_LENMAX];
+    size_t                   dictlen, off;
+    uint                     dlen, i, ncomp;
+    int                      rc;
+    merr_t                   err;
+
+    srcv = calloc(ZVAL_CNT, sizeof(*srcv));
+    zvalv = calloc(ZVAL_CNT, sizeof(*zvalv));
+    lvalv = calloc(ZVAL_CNT, sizeof(*lvalv));
+    samples = malloc(ZVAL_CNT * ZVAL_LENMAX);
+    samplev = malloc(ZVAL_CNT * sizeof(*samplev));
+    dict = malloc(VBLOCK_DICT_LEN_MAX);
+    ASSERT_TRUE(srcv && zvalv && lvalv && samples && samplev && dict);
+
+    for (i = off = 0; i < ZVAL_CNT; i++) {
+        srcv[i].vlen = snprintf(srcv[i].vdata, ZVAL_LENMAX,
+                                "{\"id\": %u, \"name\": \"user%u\", \"email\": "
+                                "\"user%u@example.com\", \"status\": \"%s\", \"score\": %u}",
+                                i, i * 7, i * 13, (i % 3) ? "active" : "inactive", i % 101);
+        memcpy(samples + off, srcv[i].vdata, srcv[i].vlen);
+        samplev[i] = srcv[i].vlen;
+        off += srcv[i].vlen;
+    }
+
+    err = compress_zstd_dict_train(samples, samplev, ZVAL_CNT, dict, 4096, &dictlen);
+    ASSERT_EQ(err, 0);
+
+    err = cn_vcomp_create(VCOMP_ALGO_ZSTD, COMPRESS_ZSTD_LEVEL_DEFAULT, 0, dict, dictlen, &zvc);
+    ASSERT_EQ(err, 0);
+    ASSERT_NE(zvc->cv_dictid, 0);
+
+    err = cn_vcomp_create(VCOMP_ALGO_LZ4, 0, 0, NULL, 0, &lvc);
+    ASSERT_EQ(err, 0);
+
+    rc = zval_vblock_build(lcl_ti, zvc, zvalv, srcv, &zblks, &zmap, &zvbd);
+    ASSERT_EQ(rc, 0);
+    ASSERT_NE(NULL, zvbd.vbd_ddict);
+
+    /* Descriptors of vblocks with the same dictionary share its ddict,
+     * which outlives the release of any one of them.
+     */
+    zvbd2 = zvbd;
+    zvbd2.vbd_ddict = NULL;
+    err = compress_zstd_ddict_get(zvbd.vbd_dict, zvbd.vbd_dictlen, &zvbd2.vbd_ddict);
+    ASSERT_EQ(err, 0);
+    ASSERT_EQ(zvbd.vbd_ddict, zvbd2.vbd_ddict);
+    vbr_desc_destroy(&zvbd);
+    ASSERT_EQ(NULL, zvbd.vbd_ddict);
+
+    /* Decompress each zstd value, as kv_spill_transcode() would, and
+     * recompress it into an lz4 vblock.
+     */
+    for (i = ncomp = 0; i < ZVAL_CNT; i++) {
+        const void *vdata = vbr_value(&zvbd2, zvalv[i].vboff, zvalv[i].complen ?: srcv[i].vlen);
+
+        ASSERT_NE(NULL, vdata);
+
+        if (zvalv[i].complen) {
+            err = vbr_decompress(&zvbd2, vdata, zvalv[i].complen, dbuf, srcv[i].vlen, &dlen);
+            ASSERT_EQ(err, 0);
+            ASSERT_EQ(dlen, srcv[i].vlen);
+            vdata = dbuf;
+            ncomp++;
+        }
+
+        ASSERT_EQ(0, memcmp(vdata, srcv[i].vdata, srcv[i].vlen));
+    }
+
+    /* With a dictionary, nearly every value compresses. */
+    ASSERT_GT(ncomp, ZVAL_CNT / 2);
+
+    rc = zval_vblock_build(lcl_ti, lvc, lvalv, srcv, &lblks, &lmap, &lvbd);
+    ASSERT_EQ(rc, 0);
+    ASSERT_EQ(NULL, lvbd.vbd_ddict);
+
+    for (i = 0; i < ZVAL_CNT; i++) {
+        const void *vdata = vbr_value(&lvbd, lvalv[i].vboff, lvalv[i].complen ?: srcv[i].vlen);
+
+        if (lvalv[i].complen) {
+            err = vbr_decompress(&lvbd, vdata, lvalv[i].complen, dbuf, srcv[i].vlen, &dlen);
+            ASSERT_EQ(err, 0);
+            ASSERT_EQ(dlen, srcv[i].vlen);
+            vdata = dbuf;
+        }
+
+        ASSERT_EQ(0, memcmp(vdata, srcv[i].vdata, srcv[i].vlen));
+    }
+
+    vbr_desc_destroy(&zvbd2);
+    vbr_desc_destroy(&lvbd);
+    mpool_mcache_munmap(lmap);
+    mpool_mcache_munmap(zmap);
+    blk_list_free(&lblks);
+    blk_list_free(&zblks);
+    cn_vcomp_destroy(lvc);
+    cn_vcomp_destroy(zvc);
+    free(dict);
+    free(samplev);
+    free(samples);
+    free(lvalv);
+    free(zvalv);
+    free(srcv);
+}
+#endif
+
 MTF_END_UTEST_COLLECTION(test);
@@ -7,6 +7,7 @@
 
 #include <hse_util/logging.h>
 #include <hse_util/page.h>
+#include <hse_util/compression_lz4.h>
 
 #include <cn/vblock_reader.h>
 #include <cn/omf.h>
@@ -63,6 +64,7 @@ MTF_DEFINE_UTEST_PRE(vblock_reader_test, t_vbr_desc_read, pre)
     err = mpm_mblock_alloc(PAGE_SIZE, &blkid);
     ASSERT_EQ(0, err);
 
+    memset(&vbhdr, 0, sizeof(vbhdr));
     omf_set_vbh_magic(&vbhdr, VBLOCK_HDR_MAGIC);
     omf_set_vbh_version(&vbhdr, VBLOCK_HDR_VERSION);
     omf_set_vbh_vgroup(&vbhdr, get_time_ns());
@@ -103,6 +105,7 @@ MTF_DEFINE_UTEST_PRE(vblock_reader_test, t_vbr_desc_update, pre)
     err = mpm_mblock_alloc(PAGE_SIZE, &blkid);
     ASSERT_EQ(0, err);
 
+    memset(&vbhdr, 0, sizeof(vbhdr));
     omf_set_vbh_magic(&vbhdr, VBLOCK_HDR_MAGIC);
     omf_set_vbh_version(&vbhdr, VBLOCK_HDR_VERSION);
     omf_set_vbh_vgroup(&vbhdr, get_time_ns());
@@ -156,6 +159,7 @@ MTF_DEFINE_UTEST_PRE(vblock_reader_test, t_vbr_desc_read_errors, pre)
     err = mpm_mblock_alloc(PAGE_SIZE, &blkid);
     ASSERT_EQ(0, err);
 
+    memset(&vbhdr, 0, sizeof(vbhdr));
     omf_set_vbh_magic(&vbhdr, VBLOCK_HDR_MAGIC);
     omf_set_vbh_version(&vbhdr, VBLOCK_HDR_VERSION);
     omf_set_vbh_vgroup(&vbhdr, get_time_ns());
@@ -190,6 +194,7 @@ MTF_DEFINE_UTEST_PRE(vblock_reader_test, t_detect_bad_magic, pre)
     ASSERT_EQ(0, err);
 
     /* vbh_magic is wrong, and should be detected in vbr_desc_read */
+    memset(&vbhdr, 0, sizeof(vbhdr));
     omf_set_vbh_magic(&vbhdr, -1);
     omf_set_vbh_version(&vbhdr, VBLOCK_HDR_VERSION);
     omf_set_vbh_vgroup(&vbhdr, get_time_ns());
@@ -458,4 +463,122 @@ MTF_DEFINE_UTEST_PRE(vblock_reader_test, t_vbr_madvise_async, pre)
     mapi_safe_free(vblk);
 }
 
+/* Test: vbr_cblk_value() on valid, raw, short and corrupt compressed blocks */
+MTF_DEFINE_UTEST_PRE(vblock_reader_test, t_vbr_cblk_value, pre)
+{
+    struct vblock_cblk_omf *cbh;
+    struct vblock_desc      vbd;
+    const void *            vdata;
+    u8                      raw[1024];
+    u8 *                    buf;
+    uint                    clen, i;
+    merr_t                  err;
+
+    buf = mapi_safe_malloc(sizeof(*cbh) + VBLOCK_CBLK_LEN_MAX);
+    ASSERT_NE(NULL, buf);
+
+    for (i = 0; i < sizeof(raw); i++)
+        raw[i] = i % 7;
+
+    cbh = (void *)buf;
+
+    err = compress_lz4_ops.cop_compress(raw, sizeof(raw), cbh + 1, VBLOCK_CBLK_LEN_MAX, &clen);
+    ASSERT_EQ(err, 0);
+    ASSERT_LT(clen, sizeof(raw));
+
+    omf_set_cbh_rawlen(cbh, sizeof(raw));
+    omf_set_cbh_clen(cbh, clen);
+
+    memset(&vbd, 0, sizeof(vbd));
+    vbd.vbd_mblkdesc.mb_id = 0x1234;
+    vbd.vbd_calgo = VBLOCK_CALGO_LZ4;
+    vbd.vbd_len = 1024 * 1024;
+
+    /* Each case uses its own vgroup so that it cannot hit a block
+     * cached by a previous case.
+     */
+    vbd.vbd_vgroup = 1;
+    ASSERT_FALSE(vbr_cblk_cached(&vbd, 0));
+    ASSERT_EQ(vbr_cblk_len(&vbd, 0, cbh), sizeof(*cbh) + clen);
+
+    err = vbr_cblk_value(&vbd, 0, cbh, 100, 50, &vdata);
+    ASSERT_EQ(err, 0);
+    ASSERT_EQ(0, memcmp(vdata, raw + 100, 50));
+    ASSERT_TRUE(vbr_cblk_cached(&vbd, 0));
+    ASSERT_FALSE(vbr_cblk_cached(&vbd, 8));
+
+    /* Cached lookups at the very end of the block, and one byte past it */
+    err = vbr_cblk_value(&vbd, 0, NULL, sizeof(raw) - 24, 24, &vdata);
+    ASSERT_EQ(err, 0);
+    ASSERT_EQ(0, memcmp(vdata, raw + sizeof(raw) - 24, 24));
+
+    err = vbr_cblk_value(&vbd, 0, NULL, sizeof(raw) - 24, 25, &vdata);
+    ASSERT_EQ(merr_errno(err), EPROTO);
+
+    /* Value past the end of an uncached block */
+    vbd.vbd_vgroup = 2;
+    err = vbr_cblk_value(&vbd, 0, cbh, sizeof(raw), 1, &vdata);
+    ASSERT_EQ(merr_errno(err), EPROTO);
+
+    /* Vblock too short for the block header */
+    vbd.vbd_vgroup = 3;
+    vbd.vbd_len = sizeof(*cbh) - 1;
+    err = vbr_cblk_value(&vbd, 0, cbh, 0, 1, &vdata);
+    ASSERT_EQ(merr_errno(err), EPROTO);
+
+    /* Vblock too short for the compressed data */
+    vbd.vbd_len = sizeof(*cbh) + clen - 1;
+    ASSERT_EQ(vbr_cblk_len(&vbd, 0, cbh), sizeof(*cbh));
+    err = vbr_cblk_value(&vbd, 0, cbh, 0, 1, &vdata);
+    ASSERT_EQ(merr_errno(err), EPROTO);
+    ASSERT_FALSE(vbr_cblk_cached(&vbd, 0));
+
+    vbd.vbd_len = 1024 * 1024;
+
+    /* Corrupt lengths in the block header */
+    vbd.vbd_vgroup = 4;
+    omf_set_cbh_rawlen(cbh, VBLOCK_CBLK_LEN_MAX + 1);
+    ASSERT_EQ(vbr_cblk_len(&vbd, 0, cbh), sizeof(*cbh) + clen);
+    err = vbr_cblk_value(&vbd, 0, cbh, 0, 1, &vdata);
+    ASSERT_EQ(merr_errno(err), EPROTO);
+
+    omf_set_cbh_rawlen(cbh, clen - 1);
+    err = vbr_cblk_value(&vbd, 0, cbh, 0, 1, &vdata);
+    ASSERT_EQ(merr_errno(err), EPROTO);
+
+    omf_set_cbh_clen(cbh, VBLOCK_CBLK_LEN_MAX + 1);
+    ASSERT_EQ(vbr_cblk_len(&vbd, 0, cbh), sizeof(*cbh));
+
+    /* A raw length that disagrees with the decompressed length */
+    vbd.vbd_vgroup = 5;
+    omf_set_cbh_rawlen(cbh, sizeof(raw) + 8);
+    omf_set_cbh_clen(cbh, clen);
+    err = vbr_cblk_value(&vbd, 0, cbh, 0, 1, &vdata);
+    ASSERT_EQ(merr_errno(err), EPROTO);
+    ASSERT_FALSE(vbr_cblk_cached(&vbd, 0));
+
+    /* Truncated compressed data */
+    vbd.vbd_vgroup = 6;
+    omf_set_cbh_rawlen(cbh, sizeof(raw));
+    omf_set_cbh_clen(cbh, clen / 2);
+    err = vbr_cblk_value(&vbd, 0, cbh, 0, 1, &vdata);
+    ASSERT_NE(err, 0);
+    ASSERT_FALSE(vbr_cblk_cached(&vbd, 0));
+
+    /* A block that didn't compress is stored raw and read in place */
+    vbd.vbd_vgroup = 7;
+    memcpy(cbh + 1, raw, sizeof(raw));
+    omf_set_cbh_rawlen(cbh, sizeof(raw));
+    omf_set_cbh_clen(cbh, sizeof(raw));
+    err = vbr_cblk_value(&vbd, 0, cbh, 512, 512, &vdata);
+    ASSERT_EQ(err, 0);
+    ASSERT_EQ(vdata, (u8 *)(cbh + 1) + 512);
+    ASSERT_FALSE(vbr_cblk_cached(&vbd, 0));
+
+    err = vbr_cblk_value(&vbd, 0, cbh, 512, 513, &vdata);
+    ASSERT_EQ(merr_errno(err), EPROTO);
+
+    mapi_safe_free(buf);
+}
+
 MTF_END_UTEST_COLLECTION(vblock_reader_test)
@@ -32,6 +32,7 @@
 
 #include <c0/c0_cursor.h>
 #include <c0/c0sk_internal.h>
+#include <kvdb/kvdb_kvs.h>
 
 #include <mocks/mock_c0cn.h>
 
@@ -560,9 +561,7 @@ MTF_DEFINE_UTEST_PREPOST(ikvdb_test, txn_del_test, test_pre, test_post)
     ikvdb_txn_free(h, txn);
     txn = 0;
 
-    vbuf.b_buf = buf;
-    vbuf.b_buf_sz = sizeof(buf);
-    vbuf.b_len = 0;
+    kvs_buf_init(&vbuf, buf, sizeof(buf));
     err = ikvdb_kvs_get(kvs_h, 0, txn, &kt, &found, &vbuf);
     ASSERT_EQ(0, err);
     ASSERT_EQ(found, FOUND_TMB);
@@ -613,9 +612,7 @@ parallel_transactions(void *info)
 
     ikvdb_txn_free(ti->kvdb, txn);
 
-    val.b_buf = vbuf;
-    val.b_buf_sz = sizeof(vbuf);
-    val.b_len = 0;
+    kvs_buf_init(&val, vbuf, sizeof(vbuf));
     txn = 0;
     err = ikvdb_kvs_get(ti->kvs, 0, txn, &kt, &found, &val);
     VERIFY_EQ_RET(0, err, 0);
@@ -963,6 +960,108 @@ MTF_DEFINE_UTEST_PREPOST(ikvdb_test, cursor_1, test_pre_c0, test_post_c0)
     ASSERT_EQ(0, err);
 }
 
+/* Put a compressible value and return the compressed length with which
+ * it is stored in c0.
+ */
+static merr_t
+vcomp_c0_complen(struct hse_kvs *kvs_h, uint *complen)
+{
+    struct c0 *               c0 = ((struct kvdb_kvs *)kvs_h)->kk_ikvs->ikv_c0;
+    struct cursor_summary     summary = {};
+    struct kvs_cursor_element elem;
+    struct c0_cursor *        c0cur;
+    struct kvs_ktuple         kt;
+    struct kvs_vtuple         vt;
+    static char               val[4000];
+    bool                      eof = true;
+    merr_t                    err;
+
+    memset(val, 'A', sizeof(val));
+    kvs_ktuple_init(&kt, "key", 3);
+    kvs_vtuple_init(&vt, val, sizeof(val));
+
+    err = ikvdb_kvs_put(kvs_h, 0, NULL, &kt, &vt);
+    if (err)
+        return err;
+
+    err = c0_cursor_create(c0, U64_MAX, false, NULL, 0, &summary, &c0cur);
+    if (err)
+        return err;
+
+    err = c0_cursor_seek(c0cur, NULL, 0, NULL);
+    if (!err)
+        err = c0_cursor_read(c0cur, &elem, &eof);
+    if (!err && (eof || kvs_vtuple_vlen(&elem.kce_vt) != sizeof(val)))
+        err = merr(EBUG);
+
+    *complen = elem.kce_complen;
+
+    c0_cursor_destroy(c0cur);
+
+    return err;
+}
+
+MTF_DEFINE_UTEST_PREPOST(ikvdb_test, vcomp_defer, test_pre_c0, test_post_c0)
+{
+    struct ikvdb *      h = NULL;
+    struct hse_kvs *    kvs_h = NULL;
+    const char *        mpool = __func__;
+    const char *const   kvdb_open_paramv[] = { "c0_diag_mode=true" };
+    const char *const   kvs_open_paramv[] = { "mclass.policy=\"capacity_only\"",
+                                            "compression.value.algorithm=lz4" };
+    merr_t              err;
+    uint                complen;
+    struct kvdb_rparams params = kvdb_rparams_defaults();
+    struct kvs_rparams  kvs_rp = kvs_rparams_defaults();
+    struct kvs_cparams  kvs_cp = kvs_cparams_defaults();
+
+    err = argv_deserialize_to_kvdb_rparams(NELEM(kvdb_open_paramv), kvdb_open_paramv, &params);
+    ASSERT_EQ(0, err);
+
+    err = argv_deserialize_to_kvs_rparams(NELEM(kvs_open_paramv), kvs_open_paramv, &kvs_rp);
+    ASSERT_EQ(0, err);
+
+    err = ikvdb_open(mpool, &params, &h);
+    ASSERT_EQ(0, err);
+
+    err = ikvdb_kvs_create(h, "comp", &kvs_cp);
+    ASSERT_EQ(0, err);
+    err = ikvdb_kvs_create(h, "defer", &kvs_cp);
+    ASSERT_EQ(0, err);
+
+    mapi_inject(mapi_idx_mpool_mclass_props_get, 0);
+
+    /* Without deferral puts compress the value on its way into c0.
+     */
+    err = ikvdb_kvs_open(h, "comp", &kvs_rp, 0, &kvs_h);
+    ASSERT_EQ(0, err);
+
+    err = vcomp_c0_complen(kvs_h, &complen);
+    ASSERT_EQ(0, err);
+    ASSERT_GT(complen, 0);
+
+    err = ikvdb_kvs_close(kvs_h);
+    ASSERT_EQ(0, err);
+
+    /* With it the value lands in c0 uncompressed, and is compressed only
+     * by compaction (see t_kvset_builder_vcomp_defer).
+     */
+    kvs_rp.vcomp_defer = true;
+
+    err = ikvdb_kvs_open(h, "defer", &kvs_rp, 0, &kvs_h);
+    ASSERT_EQ(0, err);
+
+    err = vcomp_c0_complen(kvs_h, &complen);
+    ASSERT_EQ(0, err);
+    ASSERT_EQ(0, complen);
+
+    err = ikvdb_kvs_close(kvs_h);
+    ASSERT_EQ(0, err);
+
+    err = ikvdb_close(h);
+    ASSERT_EQ(0, err);
+}
+
 #if 0
 MTF_DEFINE_UTEST_PREPOST(ikvdb_test, cursor_tx, test_pre_c0, test_post_c0)
 {
@@ -20,14 +20,14 @@ MTF_DEFINE_UTEST(omf_version_test, global_version)
      */
 
      /* Global OMF version */
-    ASSERT_EQ(GLOBAL_OMF_VERSION, 2);
+    ASSERT_EQ(GLOBAL_OMF_VERSION, 7);
 
     /* Low-level OMF versions */
     ASSERT_EQ(CNDB_VERSION, 12);
-    ASSERT_EQ(KBLOCK_HDR_VERSION, 5);
-    ASSERT_EQ(VBLOCK_HDR_VERSION, 2);
-    ASSERT_EQ(BLOOM_OMF_VERSION, 5);
-    ASSERT_EQ(WBT_TREE_VERSION, 6);
+    ASSERT_EQ(KBLOCK_HDR_VERSION, 6);
+    ASSERT_EQ(VBLOCK_HDR_VERSION, 3);
+    ASSERT_EQ(BLOOM_OMF_VERSION, 6);
+    ASSERT_EQ(WBT_TREE_VERSION, 8);
     ASSERT_EQ(CN_TSTATE_VERSION, 1);
     ASSERT_EQ(MBLOCK_METAHDR_VERSION, 2);
     ASSERT_EQ(MDC_LOGHDR_VERSION, 2);
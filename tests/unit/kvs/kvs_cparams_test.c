@@ -40,6 +40,42 @@ ps_get(const char *name)
     return NULL;
 }
 
+/**
+ * Check the validity of various key=value combinations
+ */
+merr_t HSE_SENTINEL
+check(const char *const arg, ...)
+{
+    merr_t      err;
+    bool        success;
+    const char *a = arg;
+    va_list     ap;
+
+    assert(arg);
+
+    va_start(ap, arg);
+
+    do {
+        const char * paramv[] = { a };
+        const size_t paramc = NELEM(paramv);
+
+        success = !!va_arg(ap, int);
+
+        err = argv_deserialize_to_kvs_cparams(paramc, paramv, &params);
+
+        if (success != !err) {
+            break;
+        } else {
+            /* Reset err because we expected it */
+            err = 0;
+        }
+    } while ((a = va_arg(ap, char *)));
+
+    va_end(ap);
+
+    return err;
+}
+
 MTF_DEFINE_UTEST_PRE(kvs_cparams_test, fanout, test_pre)
 {
     const struct param_spec *ps = ps_get("fanout");
@@ -135,6 +171,43 @@ MTF_DEFINE_UTEST_PRE(kvs_cparams_test, suffix_length, test_pre)
     ASSERT_EQ(UINT32_MAX, ps->ps_bounds.as_uscalar.ps_max);
 }
 
+MTF_DEFINE_UTEST_PRE(kvs_cparams_test, filter_type, test_pre)
+{
+    merr_t                   err;
+    char                     buf[128];
+    size_t                   needed_sz;
+    const struct param_spec *ps = ps_get("filter.type");
+
+    ASSERT_NE(NULL, ps);
+    ASSERT_NE(NULL, ps->ps_description);
+    ASSERT_EQ(PARAM_FLAG_EXPERIMENTAL, ps->ps_flags);
+    ASSERT_EQ(PARAM_TYPE_ENUM, ps->ps_type);
+    ASSERT_EQ(offsetof(struct kvs_cparams, filter_type), ps->ps_offset);
+    ASSERT_EQ(sizeof(enum kvs_filter_type), ps->ps_size);
+    ASSERT_NE((uintptr_t)ps->ps_convert, (uintptr_t)param_default_converter);
+    ASSERT_EQ((uintptr_t)ps->ps_validate, (uintptr_t)param_default_validator);
+    ASSERT_NE((uintptr_t)ps->ps_stringify, (uintptr_t)param_default_stringify);
+    ASSERT_NE((uintptr_t)ps->ps_jsonify, (uintptr_t)param_default_jsonify);
+    ASSERT_EQ(KVS_FILTER_BLOOM, params.filter_type);
+    ASSERT_EQ(KVS_FILTER_MIN, ps->ps_bounds.as_uscalar.ps_min);
+    ASSERT_EQ(KVS_FILTER_MAX, ps->ps_bounds.as_uscalar.ps_max);
+
+    ps->ps_stringify(ps, &params.filter_type, buf, sizeof(buf), &needed_sz);
+    ASSERT_STREQ("\"bloom\"", buf);
+    ASSERT_EQ(7, needed_sz);
+
+    /* clang-format off */
+    err = check(
+        "filter.type=bloom", true,
+        "filter.type=xor", true,
+        "filter.type=does-not-exist", false,
+        NULL
+    );
+    /* clang-format on */
+
+    ASSERT_EQ(0, merr_errno(err));
+}
+
 MTF_DEFINE_UTEST(kvs_cparams_test, get)
 {
     merr_t err;
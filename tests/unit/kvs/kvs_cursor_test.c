@@ -69,7 +69,7 @@ insert_key(struct mtf_test_info *lcl_ti, char *key)
     kvs_ktuple_init(&kt, key, strlen(key));
     kvs_vtuple_init(&vt, key, strlen(key));
 
-    err = kvs_put(kvs, NULL, &kt, &vt, 1);
+    err = kvs_put(kvs, NULL, &kt, &vt, 1, 0);
     ASSERT_EQ(0, err);
 }
 
@@ -125,7 +125,7 @@ void verify_range(struct mtf_test_info *lcl_ti, const char *pfx, int start, int
     struct hse_kvs_cursor *cur;
     struct kvs_ktuple kt;
 
-    cur = kvs_cursor_alloc(kvs, pfx, strlen(pfx), false);
+    cur = kvs_cursor_alloc(kvs, pfx, strlen(pfx), false, false);
     ASSERT_NE(NULL, cur);
 
     err = kvs_cursor_init(cur, NULL);
@@ -0,0 +1,386 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/*
+ * Copyright (C) 2021 Micron Technology, Inc.  All rights reserved.
+ */
+
+#include <mtf/framework.h>
+
+#include <hse_util/hse_err.h>
+#include <hse_util/page.h>
+
+#include <mpool/mpool.h>
+
+#include <fcntl.h>
+#include <stdlib.h>
+
+#include "common.h"
+
+#define AIO_FILE_SZ   (8ul << 20)
+#define AIO_BUF_SZ    (4ul << 20)
+#define AIO_WRITE_SZ  (256ul << 10)
+#define AIO_QDEPTH    (4)
+#define AIO_MBLK_PGS  (32)
+
+struct aio_state {
+    uint   cnt;
+    size_t len;
+    merr_t err;
+};
+
+static void
+aio_cb(void *arg, merr_t err, size_t len)
+{
+    struct aio_state *st = arg;
+
+    st->cnt++;
+    st->len += len;
+    if (err && !st->err)
+        st->err = err;
+}
+
+/* io_uring may be missing from the build or disabled in the kernel */
+static bool
+aio_unsupported(merr_t err)
+{
+    int rc = merr_errno(err);
+
+    return rc == ENOTSUP || rc == ENOSYS || rc == EPERM;
+}
+
+MTF_BEGIN_UTEST_COLLECTION_PRE(aio_test, mpool_collection_pre)
+
+MTF_DEFINE_UTEST_PREPOST(aio_test, file_write_async, mpool_test_pre, mpool_test_post)
+{
+    struct mpool_aio_ctx *ctx;
+    struct mpool_file *   mpf;
+    struct mpool *        mp;
+    struct aio_state      st = { 0 };
+    struct iovec          iov;
+    size_t                rdlen;
+    char *                buf, *rdbuf;
+    bool                  registered;
+    uint                  i, nwrites;
+    merr_t                err;
+
+    err = mpool_create(home, &tcparams);
+    ASSERT_EQ(0, err);
+
+    err = mpool_open(home, &trparams, O_RDWR, &mp);
+    ASSERT_EQ(0, err);
+
+    err = mpool_file_open(mp, HSE_MCLASS_CAPACITY, "aio-test", O_RDWR | O_DIRECT, AIO_FILE_SZ,
+                          false, &mpf);
+    ASSERT_EQ(0, err);
+
+    buf = aligned_alloc(PAGE_SIZE, AIO_BUF_SZ);
+    ASSERT_NE(NULL, buf);
+
+    rdbuf = aligned_alloc(PAGE_SIZE, AIO_WRITE_SZ);
+    ASSERT_NE(NULL, rdbuf);
+
+    for (i = 0; i < AIO_BUF_SZ; i++)
+        buf[i] = i * 7 + i / PAGE_SIZE;
+
+    err = mpool_aio_ctx_create(AIO_QDEPTH, &ctx);
+    if (aio_unsupported(err))
+        goto out;
+    ASSERT_EQ(0, err);
+
+    err = mpool_file_write_async(NULL, ctx, 0, buf, PAGE_SIZE, aio_cb, &st);
+    ASSERT_EQ(EINVAL, merr_errno(err));
+    err = mpool_file_write_async(mpf, ctx, 0, buf, PAGE_SIZE, NULL, &st);
+    ASSERT_EQ(EINVAL, merr_errno(err));
+    err = mpool_aio_buffers_register(ctx, NULL, 1);
+    ASSERT_EQ(EINVAL, merr_errno(err));
+
+    /* Register the first half of the buffer, so that writes are issued both
+     * from a registered buffer and from unregistered memory.  Registration
+     * may fail under a small RLIMIT_MEMLOCK, which writes must tolerate.
+     */
+    iov.iov_base = buf;
+    iov.iov_len = AIO_BUF_SZ / 2;
+
+    err = mpool_aio_buffers_register(ctx, &iov, 1);
+    registered = !err;
+
+    if (registered) {
+        err = mpool_aio_buffers_register(ctx, &iov, 1);
+        ASSERT_EQ(EEXIST, merr_errno(err));
+    }
+
+    /* Queue more writes than the queue depth, which forces the context to
+     * reap completions to free up request slots.
+     */
+    nwrites = AIO_BUF_SZ / AIO_WRITE_SZ;
+
+    for (i = 0; i < nwrites; i++) {
+        off_t off = i * AIO_WRITE_SZ;
+
+        err = mpool_file_write_async(mpf, ctx, off, buf + off, AIO_WRITE_SZ, aio_cb, &st);
+        ASSERT_EQ(0, err);
+    }
+
+    err = mpool_aio_submit(ctx);
+    ASSERT_EQ(0, err);
+
+    while (st.cnt < nwrites) {
+        err = mpool_aio_poll(ctx, nwrites - st.cnt);
+        ASSERT_EQ(0, err);
+    }
+
+    ASSERT_EQ(0, st.err);
+    ASSERT_EQ(nwrites * AIO_WRITE_SZ, st.len);
+
+    for (i = 0; i < nwrites; i++) {
+        off_t off = i * AIO_WRITE_SZ;
+
+        err = mpool_file_read(mpf, off, rdbuf, AIO_WRITE_SZ, &rdlen);
+        ASSERT_EQ(0, err);
+        ASSERT_EQ(AIO_WRITE_SZ, rdlen);
+        ASSERT_EQ(0, memcmp(rdbuf, buf + off, AIO_WRITE_SZ));
+    }
+
+    /* Polling an idle context returns immediately */
+    err = mpool_aio_poll(ctx, 1);
+    ASSERT_EQ(0, err);
+    ASSERT_EQ(nwrites, st.cnt);
+
+    mpool_aio_ctx_destroy(ctx);
+
+out:
+    free(rdbuf);
+    free(buf);
+
+    err = mpool_file_close(mpf);
+    ASSERT_EQ(0, err);
+
+    err = mpool_file_destroy(mp, HSE_MCLASS_CAPACITY, "aio-test");
+    ASSERT_EQ(0, err);
+
+    err = mpool_close(mp);
+    ASSERT_EQ(0, err);
+
+    mpool_destroy(home, &tdparams);
+}
+
+/* Reads pages of an mblock, queueing the read of the next page from the
+ * completion callback of the previous one until all pages have been read.
+ */
+struct aio_chain {
+    struct mpool *        mp;
+    struct mpool_aio_ctx *ctx;
+    uint64_t              mbid;
+    struct iovec          iov;
+    uint                  next;
+    struct aio_state      st;
+};
+
+static void
+aio_chain_cb(void *arg, merr_t err, size_t len)
+{
+    struct aio_chain *ch = arg;
+
+    aio_cb(&ch->st, err, len);
+
+    if (err || ++ch->next >= AIO_MBLK_PGS)
+        return;
+
+    ch->iov.iov_base += PAGE_SIZE;
+
+    err = mpool_mblock_read_async(
+        ch->mp, ch->ctx, ch->mbid, &ch->iov, 1, ch->next * PAGE_SIZE, aio_chain_cb, ch);
+    if (err)
+        aio_cb(&ch->st, err, 0);
+}
+
+MTF_DEFINE_UTEST_PREPOST(aio_test, mblock_read_async, mpool_test_pre, mpool_test_post)
+{
+    struct mpool_aio_ctx *ctx;
+    struct mpool *        mp;
+    struct aio_state      st = { 0 };
+    struct aio_chain      ch;
+    struct iovec          iov, iovv[AIO_MBLK_PGS];
+    uint64_t              mbid;
+    char *                buf, *rdbuf;
+    uint                  i;
+    merr_t                err;
+
+    err = mpool_create(home, &tcparams);
+    ASSERT_EQ(0, err);
+
+    err = mpool_open(home, &trparams, O_RDWR, &mp);
+    ASSERT_EQ(0, err);
+
+    buf = aligned_alloc(PAGE_SIZE, AIO_MBLK_PGS * PAGE_SIZE);
+    ASSERT_NE(NULL, buf);
+
+    rdbuf = aligned_alloc(PAGE_SIZE, AIO_MBLK_PGS * PAGE_SIZE);
+    ASSERT_NE(NULL, rdbuf);
+
+    for (i = 0; i < AIO_MBLK_PGS * PAGE_SIZE; i++)
+        buf[i] = i * 13 + i / PAGE_SIZE;
+
+    err = mpool_mblock_alloc(mp, HSE_MCLASS_CAPACITY, &mbid, NULL);
+    ASSERT_EQ(0, err);
+
+    iov.iov_base = buf;
+    iov.iov_len = AIO_MBLK_PGS * PAGE_SIZE;
+
+    err = mpool_mblock_write(mp, mbid, &iov, 1);
+    ASSERT_EQ(0, err);
+
+    err = mpool_mblock_commit(mp, mbid);
+    ASSERT_EQ(0, err);
+
+    /* A queue depth of two makes nearly every read wait for a free slot */
+    err = mpool_aio_ctx_create(2, &ctx);
+    if (aio_unsupported(err))
+        goto out;
+    ASSERT_EQ(0, err);
+
+    err = mpool_mblock_read_async(NULL, ctx, mbid, &iov, 1, 0, aio_cb, &st);
+    ASSERT_EQ(EINVAL, merr_errno(err));
+    err = mpool_mblock_read_async(mp, ctx, mbid, NULL, 1, 0, aio_cb, &st);
+    ASSERT_EQ(EINVAL, merr_errno(err));
+    err = mpool_mblock_read_async(mp, ctx, mbid, &iov, 1, 0, NULL, &st);
+    ASSERT_EQ(EINVAL, merr_errno(err));
+
+    /* TC: Slot exhaustion, one read per page in reverse order */
+    memset(rdbuf, 0, AIO_MBLK_PGS * PAGE_SIZE);
+
+    for (i = 0; i < AIO_MBLK_PGS; i++) {
+        uint pg = AIO_MBLK_PGS - 1 - i;
+
+        iovv[pg].iov_base = rdbuf + pg * PAGE_SIZE;
+        iovv[pg].iov_len = PAGE_SIZE;
+
+        err = mpool_mblock_read_async(mp, ctx, mbid, &iovv[pg], 1, pg * PAGE_SIZE, aio_cb, &st);
+        ASSERT_EQ(0, err);
+        ASSERT_LE(i + 1 - st.cnt, 2);
+    }
+
+    while (st.cnt < AIO_MBLK_PGS) {
+        err = mpool_aio_poll(ctx, 1);
+        ASSERT_EQ(0, err);
+    }
+
+    ASSERT_EQ(0, st.err);
+    ASSERT_EQ(AIO_MBLK_PGS * PAGE_SIZE, st.len);
+    ASSERT_EQ(0, memcmp(rdbuf, buf, AIO_MBLK_PGS * PAGE_SIZE));
+
+    /* TC: A completion callback may queue the next request */
+    memset(rdbuf, 0, AIO_MBLK_PGS * PAGE_SIZE);
+    memset(&ch, 0, sizeof(ch));
+    ch.mp = mp;
+    ch.ctx = ctx;
+    ch.mbid = mbid;
+    ch.iov.iov_base = rdbuf;
+    ch.iov.iov_len = PAGE_SIZE;
+
+    err = mpool_mblock_read_async(mp, ctx, mbid, &ch.iov, 1, 0, aio_chain_cb, &ch);
+    ASSERT_EQ(0, err);
+
+    while (ch.st.cnt < AIO_MBLK_PGS && !ch.st.err) {
+        err = mpool_aio_poll(ctx, 1);
+        ASSERT_EQ(0, err);
+    }
+
+    ASSERT_EQ(0, ch.st.err);
+    ASSERT_EQ(AIO_MBLK_PGS, ch.st.cnt);
+    ASSERT_EQ(0, memcmp(rdbuf, buf, AIO_MBLK_PGS * PAGE_SIZE));
+
+    /* TC: Destroying a context waits for queued requests */
+    memset(&st, 0, sizeof(st));
+
+    for (i = 0; i < 2; i++) {
+        err = mpool_mblock_read_async(mp, ctx, mbid, &iovv[i], 1, i * PAGE_SIZE, aio_cb, &st);
+        ASSERT_EQ(0, err);
+    }
+
+    mpool_aio_ctx_destroy(ctx);
+    ASSERT_EQ(2, st.cnt);
+    ASSERT_EQ(0, st.err);
+
+out:
+    err = mpool_mblock_delete(mp, mbid);
+    ASSERT_EQ(0, err);
+
+    free(rdbuf);
+    free(buf);
+
+    err = mpool_close(mp);
+    ASSERT_EQ(0, err);
+
+    mpool_destroy(home, &tdparams);
+}
+
+MTF_DEFINE_UTEST_PREPOST(aio_test, error_completion, mpool_test_pre, mpool_test_post)
+{
+    struct mpool_aio_ctx *ctx;
+    struct mpool_file *   mpf;
+    struct mpool *        mp;
+    struct aio_state      st = { 0 };
+    char *                buf;
+    uint                  i;
+    merr_t                err;
+
+    err = mpool_create(home, &tcparams);
+    ASSERT_EQ(0, err);
+
+    err = mpool_open(home, &trparams, O_RDWR, &mp);
+    ASSERT_EQ(0, err);
+
+    /* Create the file, then reopen it read-only so that writes fail */
+    err = mpool_file_open(mp, HSE_MCLASS_CAPACITY, "aio-err", O_RDWR, AIO_FILE_SZ, false, &mpf);
+    ASSERT_EQ(0, err);
+
+    err = mpool_file_close(mpf);
+    ASSERT_EQ(0, err);
+
+    err = mpool_file_open(mp, HSE_MCLASS_CAPACITY, "aio-err", O_RDONLY, AIO_FILE_SZ, false, &mpf);
+    ASSERT_EQ(0, err);
+
+    buf = aligned_alloc(PAGE_SIZE, PAGE_SIZE);
+    ASSERT_NE(NULL, buf);
+
+    memset(buf, 0xa5, PAGE_SIZE);
+
+    err = mpool_aio_ctx_create(AIO_QDEPTH, &ctx);
+    if (aio_unsupported(err))
+        goto out;
+    ASSERT_EQ(0, err);
+
+    /* Failed requests complete with an error and zero length, and their
+     * slots are reused (there are more requests than slots).
+     */
+    for (i = 0; i < AIO_QDEPTH * 2; i++) {
+        err = mpool_file_write_async(mpf, ctx, i * PAGE_SIZE, buf, PAGE_SIZE, aio_cb, &st);
+        ASSERT_EQ(0, err);
+    }
+
+    while (st.cnt < AIO_QDEPTH * 2) {
+        err = mpool_aio_poll(ctx, 1);
+        ASSERT_EQ(0, err);
+    }
+
+    ASSERT_EQ(EBADF, merr_errno(st.err));
+    ASSERT_EQ(0, st.len);
+
+    mpool_aio_ctx_destroy(ctx);
+
+out:
+    free(buf);
+
+    err = mpool_file_close(mpf);
+    ASSERT_EQ(0, err);
+
+    err = mpool_file_destroy(mp, HSE_MCLASS_CAPACITY, "aio-err");
+    ASSERT_EQ(0, err);
+
+    err = mpool_close(mp);
+    ASSERT_EQ(0, err);
+
+    mpool_destroy(home, &tdparams);
+}
+
+MTF_END_UTEST_COLLECTION(aio_test);
@@ -0,0 +1,150 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/*
+ * Copyright (C) 2021 Micron Technology, Inc.  All rights reserved.
+ */
+
+#include <mtf/framework.h>
+#include <support/random_buffer.h>
+
+#include <hse_util/hse_err.h>
+#include <hse_util/page.h>
+
+#include <mpool/mpool.h>
+
+#include "common.h"
+
+#define BCACHE_TEST_PAGES (8)
+#define MBLOCK_TEST_PAGES (32)
+
+MTF_BEGIN_UTEST_COLLECTION_PRE(bcache_test, mpool_collection_pre)
+
+static merr_t
+mblock_write(struct mpool *mp, uint64_t mbid, char *buf, int pagec)
+{
+    struct iovec iov[MBLOCK_TEST_PAGES];
+    int          i;
+
+    for (i = 0; i < pagec; i++) {
+        iov[i].iov_base = buf + i * PAGE_SIZE;
+        iov[i].iov_len = PAGE_SIZE;
+    }
+
+    return mpool_mblock_write(mp, mbid, iov, pagec);
+}
+
+MTF_DEFINE_UTEST_PREPOST(bcache_test, bcache_disabled, mpool_test_pre, mpool_test_post)
+{
+    struct mpool_bcache_page *bp;
+    struct mpool             *mp;
+    void                     *addr;
+    merr_t                    err;
+
+    err = mpool_create(home, &tcparams);
+    ASSERT_EQ(0, err);
+
+    err = mpool_open(home, &trparams, O_RDWR, &mp);
+    ASSERT_EQ(0, err);
+
+    ASSERT_FALSE(mpool_bcache_enabled(mp));
+
+    err = mpool_bcache_get(mp, 0, 0, false, &bp, &addr);
+    ASSERT_EQ(ENOENT, merr_errno(err));
+
+    err = mpool_bcache_get(NULL, 0, 0, false, &bp, &addr);
+    ASSERT_EQ(EINVAL, merr_errno(err));
+
+    mpool_bcache_put(NULL);
+
+    err = mpool_close(mp);
+    ASSERT_EQ(0, err);
+    mpool_destroy(home, &tdparams);
+}
+
+MTF_DEFINE_UTEST_PREPOST(bcache_test, bcache_get_put, mpool_test_pre, mpool_test_post)
+{
+    struct mpool_bcache_page *bpv[BCACHE_TEST_PAGES + 1];
+    struct mpool_rparams      rparams = trparams;
+    struct mpool             *mp;
+    uint64_t                  mbid;
+    void                     *addr, *addr2;
+    char                     *buf;
+    merr_t                    err;
+    int                       rc, i;
+
+    err = mpool_create(home, &tcparams);
+    ASSERT_EQ(0, err);
+
+    rparams.bcache_size = BCACHE_TEST_PAGES * PAGE_SIZE;
+
+    err = mpool_open(home, &rparams, O_RDWR, &mp);
+    ASSERT_EQ(0, err);
+
+    ASSERT_TRUE(mpool_bcache_enabled(mp));
+
+    rc = posix_memalign((void **)&buf, PAGE_SIZE, MBLOCK_TEST_PAGES * PAGE_SIZE);
+    ASSERT_EQ(0, rc);
+
+    randomize_buffer(buf, MBLOCK_TEST_PAGES * PAGE_SIZE, MBLOCK_TEST_PAGES);
+
+    err = mpool_mblock_alloc(mp, HSE_MCLASS_CAPACITY, &mbid, NULL);
+    ASSERT_EQ(0, err);
+
+    err = mblock_write(mp, mbid, buf, MBLOCK_TEST_PAGES);
+    ASSERT_EQ(0, err);
+
+    err = mpool_mblock_commit(mp, mbid);
+    ASSERT_EQ(0, err);
+
+    /* Touch more pages than the cache holds to force eviction. */
+    for (i = 0; i < MBLOCK_TEST_PAGES; i++) {
+        err = mpool_bcache_get(mp, mbid, i, i % 2, &bpv[0], &addr);
+        ASSERT_EQ(0, err);
+        ASSERT_EQ(0, (uintptr_t)addr & (PAGE_SIZE - 1));
+
+        rc = memcmp(addr, buf + i * PAGE_SIZE, PAGE_SIZE);
+        ASSERT_EQ(0, rc);
+
+        mpool_bcache_put(bpv[0]);
+    }
+
+    /* A cached page is returned without being read again. */
+    err = mpool_bcache_get(mp, mbid, 0, false, &bpv[0], &addr);
+    ASSERT_EQ(0, err);
+    err = mpool_bcache_get(mp, mbid, 0, false, &bpv[1], &addr2);
+    ASSERT_EQ(0, err);
+    ASSERT_EQ(bpv[0], bpv[1]);
+    ASSERT_EQ(addr, addr2);
+    mpool_bcache_put(bpv[1]);
+    mpool_bcache_put(bpv[0]);
+
+    /* Pinned pages are never evicted. */
+    for (i = 0; i < BCACHE_TEST_PAGES; i++) {
+        err = mpool_bcache_get(mp, mbid, i, false, &bpv[i], &addr);
+        ASSERT_EQ(0, err);
+    }
+
+    err = mpool_bcache_get(mp, mbid, BCACHE_TEST_PAGES, false, &bpv[i], &addr);
+    ASSERT_EQ(EBUSY, merr_errno(err));
+
+    for (i = 0; i < BCACHE_TEST_PAGES; i++)
+        mpool_bcache_put(bpv[i]);
+
+    err = mpool_bcache_get(mp, mbid, BCACHE_TEST_PAGES, false, &bpv[0], &addr);
+    ASSERT_EQ(0, err);
+
+    rc = memcmp(addr, buf + BCACHE_TEST_PAGES * PAGE_SIZE, PAGE_SIZE);
+    ASSERT_EQ(0, rc);
+
+    mpool_bcache_put(bpv[0]);
+
+    err = mpool_mblock_delete(mp, mbid);
+    ASSERT_EQ(0, err);
+
+    err = mpool_close(mp);
+    ASSERT_EQ(0, err);
+    mpool_destroy(home, &tdparams);
+
+    free(buf);
+}
+
+MTF_END_UTEST_COLLECTION(bcache_test);
@@ -846,6 +846,63 @@ MTF_DEFINE_UTEST(bin_heap_test, bin_heap2_dups)
         sample_es_destroy(es[i]);
 }
 
+static u64
+ks_disc(const void *a)
+{
+    return getval((const u32 *)a) >> 4;
+}
+
+MTF_DEFINE_UTEST(bin_heap_test, bin_heap2_disc)
+{
+    const u32 WIDTH = 13;
+    const u32 CNT = 300;
+
+    struct bin_heap2 *     bh;
+    struct sample_es *     es[WIDTH];
+    struct element_source *handles[WIDTH];
+    u32 *                  item;
+    merr_t                 err;
+    int                    i, n;
+    u32                    last, src;
+
+    /* overlapping ranges of keys, so that every source has duplicates */
+    for (i = 0; i < WIDTH; ++i) {
+        err = sample_es_create_srcid(&es[i], CNT, i * 7, i, SES_LINEAR);
+        ASSERT_EQ(0, err);
+        handles[i] = sample_es_get_es_handle(es[i]);
+    }
+
+    err = bin_heap2_create(WIDTH, ks_cmp, &bh);
+    ASSERT_EQ(0, err);
+
+    bin_heap2_set_disc(bh, ks_disc);
+    bin_heap2_prepare(bh, WIDTH, handles);
+    ASSERT_EQ(WIDTH, bin_heap2_width(bh));
+
+    last = 0;
+    src = 0;
+    n = 0;
+
+    while (bin_heap2_pop(bh, (void **)&item)) {
+        ASSERT_LE(last, getval(item));
+        if (n > 0 && getval(item) == last) {
+            ASSERT_LT(src, getsrc(item));
+        }
+
+        last = getval(item);
+        src = getsrc(item);
+        ++n;
+    }
+
+    ASSERT_EQ(WIDTH * CNT, n);
+    ASSERT_EQ(0, bin_heap2_width(bh));
+
+    bin_heap2_destroy(bh);
+
+    for (i = 0; i < WIDTH; ++i)
+        sample_es_destroy(es[i]);
+}
+
 MTF_DEFINE_UTEST(bin_heap_test, bin_heap2_usage_error)
 {
     const u32 WIDTH = 17;
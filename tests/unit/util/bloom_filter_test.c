@@ -138,6 +138,37 @@ MTF_DEFINE_UTEST(bloom_filter_basic, BasicInsert)
     }
 }
 
+MTF_DEFINE_UTEST(bloom_filter_basic, Lookup512)
+{
+    u8  bucket[64] HSE_ALIGNED(64);
+    u64 hash, h;
+    u32 i, j, n;
+
+    /* Verify that the whole-bucket check agrees with testing each
+     * bit in turn over randomly populated buckets.
+     */
+    for (i = 0; i < 100000; ++i) {
+        bool expect;
+        int  k;
+
+        hash = hse_hash64(&i, sizeof(i));
+
+        for (j = 0; j < sizeof(bucket); ++j)
+            bucket[j] = (u8)(hash >> (j % 57)) | (u8)(hash >> (j % 29));
+
+        hash = hse_hash64(&hash, sizeof(hash));
+        n = 1 + i % 12;
+
+        h = hash;
+        for (k = n; k > 0; --k)
+            if (!hse_bitmap_test32(bucket, bf_hash2bit(&h, BF_ROTL, 511)))
+                break;
+        expect = (k == 0);
+
+        ASSERT_EQ(expect, bf_lookup512(hash, bucket, n, BF_ROTL));
+    }
+}
+
 MTF_DEFINE_UTEST(bloom_filter_basic, RepeatableBasic)
 {
     const char *buf1 = "The cow jumped over the moon";
@@ -5,7 +5,9 @@
 
 #include <hse_util/platform.h>
 #include <hse_util/compression_lz4.h>
+#include <hse_util/compression_zstd.h>
 #include <hse_util/logging.h>
+#include <hse_util/minmax.h>
 
 #include <mtf/framework.h>
 
@@ -163,5 +165,209 @@ MTF_DEFINE_UTEST(compression_test, mongo)
     free(cbuf);
 }
 
+#ifdef HAVE_ZSTD
+MTF_DEFINE_UTEST(compression_test, zstd)
+{
+    struct compress_zstd_cdict *cdict;
+    size_t srcsz, cbufsz;
+    char *src, *cbuf, *dbuf;
+    uint cbuflen, dbuflen;
+    merr_t err;
+    int i;
+
+    srcsz = 64 * 1024;
+    src = malloc(srcsz);
+    ASSERT_NE(NULL, src);
+
+    cbufsz = compress_zstd_ops.cop_estimate(NULL, srcsz);
+    ASSERT_GE(cbufsz, srcsz);
+
+    cbuf = malloc(cbufsz);
+    ASSERT_NE(NULL, cbuf);
+
+    dbuf = malloc(srcsz);
+    ASSERT_NE(NULL, dbuf);
+
+    for (i = 0; i < srcsz; ++i)
+        src[i] = i / 7;
+
+    err = compress_zstd_ops.cop_compress(src, srcsz, cbuf, cbufsz, &cbuflen);
+    ASSERT_EQ(0, err);
+    ASSERT_LT(cbuflen, srcsz);
+
+    /* The result must not be silently truncated...
+     */
+    err = compress_zstd_ops.cop_compress(src, srcsz, cbuf, cbuflen - 1, &dbuflen);
+    ASSERT_EQ(EFBIG, merr_errno(err));
+
+    err = compress_zstd_ops.cop_decompress(cbuf, cbuflen, dbuf, srcsz, &dbuflen);
+    ASSERT_EQ(0, err);
+    ASSERT_EQ(srcsz, dbuflen);
+    ASSERT_EQ(0, memcmp(src, dbuf, dbuflen));
+
+    /* Partial decompression...
+     */
+    for (i = 1; i < srcsz; i += 4093) {
+        memset(dbuf, 0xaa, srcsz);
+
+        err = compress_zstd_ops.cop_decompress(cbuf, cbuflen, dbuf, i, &dbuflen);
+        ASSERT_EQ(0, err);
+        ASSERT_EQ(i, dbuflen);
+        ASSERT_EQ(0, memcmp(src, dbuf, dbuflen));
+        ASSERT_EQ((char)0xaa, dbuf[i]);
+    }
+
+    /* A level-only cdict behaves like the ops vector.
+     */
+    err = compress_zstd_cdict_create(NULL, 0, COMPRESS_ZSTD_LEVEL_MAX + 1, &cdict);
+    ASSERT_EQ(0, err);
+
+    err = compress_zstd_compress(cdict, src, srcsz, cbuf, cbufsz, &cbuflen);
+    ASSERT_EQ(0, err);
+
+    err = compress_zstd_decompress(NULL, cbuf, cbuflen, dbuf, srcsz, &dbuflen);
+    ASSERT_EQ(0, err);
+    ASSERT_EQ(srcsz, dbuflen);
+    ASSERT_EQ(0, memcmp(src, dbuf, dbuflen));
+
+    compress_zstd_cdict_destroy(cdict);
+
+    free(dbuf);
+    free(cbuf);
+    free(src);
+}
+
+MTF_DEFINE_UTEST(compression_test, zstd_dict)
+{
+    const struct compress_zstd_ddict *ddict, *ddict2;
+    struct compress_zstd_cdict *cdict;
+    const uint samplec = 2000;
+    const uint dictcap = 4096;
+    size_t *samplev, dictlen, off;
+    char *samples, *dict, cbuf[512], dbuf[512];
+    uint cbuflen, dbuflen, i;
+    merr_t err;
+
+    samples = malloc(samplec * 256);
+    samplev = malloc(samplec * sizeof(*samplev));
+    dict = malloc(dictcap);
+    ASSERT_NE(NULL, samples);
+    ASSERT_NE(NULL, samplev);
+    ASSERT_NE(NULL, dict);
+
+    /* Build similar json-like records that share most of their content.
+     */
+    for (i = off = 0; i < samplec; ++i) {
+        samplev[i] = snprintf(samples + off, 256,
+                              "{\"id\": %u, \"name\": \"user%u\", \"email\": "
+                              "\"user%u@example.com\", \"status\": \"%s\", \"score\": %u}",
+                              i, i * 7, i * 13, (i % 3) ? "active" : "inactive", i % 101);
+        off += samplev[i];
+    }
+
+    err = compress_zstd_dict_train(samples, samplev, samplec, dict, dictcap, &dictlen);
+    ASSERT_EQ(0, err);
+    ASSERT_GT(dictlen, 0);
+    ASSERT_LE(dictlen, dictcap);
+    ASSERT_NE(0, compress_zstd_dict_id(dict, dictlen));
+
+    err = compress_zstd_cdict_create(dict, dictlen, COMPRESS_ZSTD_LEVEL_DEFAULT, &cdict);
+    ASSERT_EQ(0, err);
+
+    err = compress_zstd_ddict_get(dict, dictlen, &ddict);
+    ASSERT_EQ(0, err);
+    ASSERT_NE(NULL, ddict);
+
+    /* The same dictionary yields the same shared ddict.
+     */
+    err = compress_zstd_ddict_get(dict, dictlen, &ddict2);
+    ASSERT_EQ(0, err);
+    ASSERT_EQ(ddict, ddict2);
+
+    for (i = off = 0; i < samplec; off += samplev[i++]) {
+        if (i % 97)
+            continue;
+
+        err = compress_zstd_compress(cdict, samples + off, samplev[i], cbuf, sizeof(cbuf),
+                                     &cbuflen);
+        ASSERT_EQ(0, err);
+        ASSERT_LT(cbuflen, samplev[i]);
+
+        err = compress_zstd_decompress(ddict, cbuf, cbuflen, dbuf, sizeof(dbuf), &dbuflen);
+        ASSERT_EQ(0, err);
+        ASSERT_EQ(samplev[i], dbuflen);
+        ASSERT_EQ(0, memcmp(samples + off, dbuf, dbuflen));
+    }
+
+    compress_zstd_ddict_put(ddict2);
+    compress_zstd_ddict_put(ddict);
+    compress_zstd_cdict_destroy(cdict);
+
+    free(dict);
+    free(samplev);
+    free(samples);
+}
+
+MTF_DEFINE_UTEST(compression_test, zstd_ddict_identity)
+{
+    const struct compress_zstd_ddict *ddict1, *ddict2, *ddict3;
+    struct compress_zstd_cdict *cdict;
+    char dict1[1024], dict2[1024], src[512], cbuf[512], dbuf[512];
+    uint cbuflen, dbuflen, i;
+    merr_t err;
+
+    /* Two raw content dictionaries of the same length, both of which
+     * have dictionary ID zero.
+     */
+    for (i = 0; i < sizeof(dict1); ++i) {
+        dict1[i] = 'a' + (i * 7) % 26;
+        dict2[i] = 'A' + (i * 11) % 26;
+    }
+
+    ASSERT_EQ(0, compress_zstd_dict_id(dict1, sizeof(dict1)));
+    ASSERT_EQ(0, compress_zstd_dict_id(dict2, sizeof(dict2)));
+
+    err = compress_zstd_ddict_get(dict1, sizeof(dict1), &ddict1);
+    ASSERT_EQ(0, err);
+
+    err = compress_zstd_ddict_get(dict2, sizeof(dict2), &ddict2);
+    ASSERT_EQ(0, err);
+    ASSERT_NE(ddict1, ddict2);
+
+    /* A copy of a dictionary (e.g., from another vblock) shares its ddict.
+     */
+    memcpy(src, dict1, sizeof(src));
+
+    err = compress_zstd_ddict_get(dict1, sizeof(dict1), &ddict3);
+    ASSERT_EQ(0, err);
+    ASSERT_EQ(ddict1, ddict3);
+
+    err = compress_zstd_cdict_create(dict1, sizeof(dict1), COMPRESS_ZSTD_LEVEL_DEFAULT, &cdict);
+    ASSERT_EQ(0, err);
+
+    err = compress_zstd_compress(cdict, src, sizeof(src), cbuf, sizeof(cbuf), &cbuflen);
+    ASSERT_EQ(0, err);
+
+    /* Releasing one reference leaves the shared ddict usable.
+     */
+    compress_zstd_ddict_put(ddict1);
+
+    err = compress_zstd_decompress(ddict3, cbuf, cbuflen, dbuf, sizeof(dbuf), &dbuflen);
+    ASSERT_EQ(0, err);
+    ASSERT_EQ(sizeof(src), dbuflen);
+    ASSERT_EQ(0, memcmp(src, dbuf, dbuflen));
+
+    /* The wrong dictionary must not reproduce the data.
+     */
+    err = compress_zstd_decompress(ddict2, cbuf, cbuflen, dbuf, sizeof(dbuf), &dbuflen);
+    if (!err)
+        ASSERT_NE(0, memcmp(src, dbuf, min_t(uint, dbuflen, sizeof(src))));
+
+    compress_zstd_ddict_put(ddict3);
+    compress_zstd_ddict_put(ddict2);
+    compress_zstd_ddict_put(NULL);
+    compress_zstd_cdict_destroy(cdict);
+}
+#endif
 
 MTF_END_UTEST_COLLECTION(compression_test)
@@ -0,0 +1,118 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/*
+ * Copyright (C) 2021 Micron Technology, Inc.  All rights reserved.
+ */
+
+#include <mtf/framework.h>
+
+#include <hse_util/hse_err.h>
+#include <hse_util/inttypes.h>
+#include <hse_util/xrand.h>
+#include <hse_util/xor_filter.h>
+
+#include <stdlib.h>
+
+MTF_BEGIN_UTEST_COLLECTION(xor_filter_test);
+
+MTF_DEFINE_UTEST(xor_filter_test, Estimates)
+{
+    u32 fpbits, n;
+
+    ASSERT_EQ(8, xf_fpbits(10000));
+    ASSERT_EQ(8, xf_fpbits(3906));
+    ASSERT_EQ(16, xf_fpbits(3905));
+    ASSERT_EQ(16, xf_fpbits(1));
+
+    for (fpbits = XF_FPBITS_MIN; fpbits <= XF_FPBITS_MAX; fpbits += 8) {
+        for (n = 0; n < 1000000; n = n * 3 + 1) {
+            u32 sz = xf_size_estimate(fpbits, n);
+
+            /* Roughly 1.23 slots per element */
+            ASSERT_GE(sz, n * (fpbits / 8));
+            ASSERT_LE(sz, (n * 124 / 100 + 36) * (fpbits / 8));
+
+            ASSERT_GE(xf_element_estimate(fpbits, sz), n);
+            ASSERT_LE(xf_size_estimate(fpbits, xf_element_estimate(fpbits, sz)), sz);
+        }
+    }
+}
+
+MTF_DEFINE_UTEST(xor_filter_test, BuildLookup)
+{
+    const u32          nkeys = 100000;
+    const u32          nprobes = 1000000;
+    struct xor_filter  xf;
+    struct xrand       xr;
+    u64 *              keyv, *hashv;
+    u8 *               storage;
+    u32                fpbits, i, fp;
+    size_t             sz;
+    merr_t             err;
+
+    xrand_init(&xr, 42);
+
+    keyv = malloc(nkeys * sizeof(*keyv));
+    hashv = malloc(nkeys * sizeof(*hashv));
+    ASSERT_NE(NULL, keyv);
+    ASSERT_NE(NULL, hashv);
+
+    for (i = 0; i < nkeys; ++i)
+        keyv[i] = xrand64(&xr);
+
+    /* Duplicate hashes must be tolerated.
+     */
+    for (i = 0; i < nkeys / 100; ++i)
+        keyv[i * 2 + 1] = keyv[i * 2];
+
+    for (fpbits = XF_FPBITS_MIN; fpbits <= XF_FPBITS_MAX; fpbits += 8) {
+        sz = xf_size_estimate(fpbits, nkeys);
+
+        storage = malloc(sz);
+        ASSERT_NE(NULL, storage);
+
+        memcpy(hashv, keyv, nkeys * sizeof(*hashv));
+
+        err = xf_filter_build(&xf, fpbits, hashv, nkeys, storage, sz - 1);
+        ASSERT_EQ(ENOSPC, merr_errno(err));
+
+        err = xf_filter_build(&xf, fpbits, hashv, nkeys, storage, sz);
+        ASSERT_EQ(0, err);
+        ASSERT_EQ(storage, xf.xf_fpv);
+        ASSERT_EQ(fpbits, xf.xf_fpbits);
+        ASSERT_LE(xf.xf_fpvsz, sz);
+        ASSERT_EQ(xf.xf_seglen * 3 * (fpbits / 8), xf.xf_fpvsz);
+
+        /* No false negatives.
+         */
+        for (i = 0; i < nkeys; ++i)
+            ASSERT_TRUE(xf_lookup(keyv[i], xf.xf_fpv, xf.xf_seed, xf.xf_seglen, fpbits));
+
+        /* The false positive rate should be close to 2^-fpbits.
+         */
+        for (i = fp = 0; i < nprobes; ++i)
+            fp += xf_lookup(xrand64(&xr), xf.xf_fpv, xf.xf_seed, xf.xf_seglen, fpbits);
+
+        ASSERT_LE(fp, (nprobes >> fpbits) * 2 + 10);
+
+        free(storage);
+    }
+
+    /* An empty set yields a valid (all zero) filter.
+     */
+    sz = xf_size_estimate(8, 0);
+    storage = malloc(sz);
+    ASSERT_NE(NULL, storage);
+
+    err = xf_filter_build(&xf, 8, hashv, 0, storage, sz);
+    ASSERT_EQ(0, err);
+
+    for (i = fp = 0; i < 1000; ++i)
+        fp += xf_lookup(xrand64(&xr), xf.xf_fpv, xf.xf_seed, xf.xf_seglen, 8);
+    ASSERT_LE(fp, (1000 >> 8) * 2 + 10);
+
+    free(storage);
+    free(hashv);
+    free(keyv);
+}
+
+MTF_END_UTEST_COLLECTION(xor_filter_test)
@@ -463,6 +463,20 @@ val_get_next(void *kmd, size_t *off, struct kmd_vref *vref)
                 vref->vboff,
                 vref->vlen);
             break;
+        case vtype_bval: {
+            u32 boff;
+
+            kmd_bval(kmd, off, &vref->vbidx, &vref->vboff, &vref->vlen, &boff);
+            snprintf(
+                vref->vinfo,
+                sizeof(vref->vinfo),
+                "type=bv %u/%u/%u/%u",
+                vref->vbidx,
+                vref->vboff,
+                vref->vlen,
+                boff);
+            break;
+        }
         case vtype_ival:
             kmd_ival(kmd, off, &vdata, &vlen);
             snprintf(vref->vinfo, sizeof(vref->vinfo), "type=iv %u", vlen);
@@ -682,7 +696,9 @@ void
 print_wbt(void *wbt_hdr, void *kblk, bool ptomb)
 {
     switch (wbt_hdr_version(wbt_hdr)) {
-        case WBT_TREE_VERSION:
+        case WBT_TREE_VERSION6:
+        case WBT_TREE_VERSION7:
+        case WBT_TREE_VERSION8:
             print_wbt_impl(wbt_hdr, kblk, ptomb);
             break;
         default:
@@ -23,13 +23,14 @@
 #include <unistd.h>
 
 #include <hse/hse.h>
+#include <hse/experimental.h>
 
 #include <hse_util/event_timer.h>
 
 #include <tools/common.h>
 #include <tools/parm_groups.h>
 
-enum Actions { PUT = 0, GET = 1, DEL = 2 };
+enum Actions { PUT = 0, GET = 1, DEL = 2, LOAD = 3 };
 
 struct Action {
     char *name;
@@ -38,6 +39,7 @@ struct Action {
     { "put", "writing" },
     { "get", "reading" },
     { "del", "deleting" },
+    { "load", "loading" },
 };
 
 /* --------------------------------------------------
@@ -72,6 +74,7 @@ run(void *p)
     uint32_t *      seq = ti->key;
     uint32_t *      uniq = ti->val + sizeof(*seq);
     struct hse_kvs *h = ti->kvs;
+    struct hse_kvs_bulk *bulk = NULL;
     char *          test = tab[ti->action].name;
     unsigned        i;
     bool            found;
@@ -91,6 +94,17 @@ run(void *p)
     if (clock_gettime(CLOCK_REALTIME, &ts) == 0)
         now = (ts.tv_sec << 20) | (ts.tv_nsec >> 10);
 
+    /*
+     * a bulk load builds its kvsets while the kvs stays live,
+     * and then links them in behind the data already in the kvs
+     */
+    if (ti->action == LOAD) {
+        hse_err_t rc = hse_kvs_bulk_create(h, HSE_KVS_BULK_BEHIND, &bulk);
+
+        if (rc)
+            fatal(rc, "cannot create bulk loader");
+    }
+
     for (i = ti->start; i < ti->last; ++i) {
         hse_err_t rc = 0;
 
@@ -128,6 +142,12 @@ run(void *p)
                 EVENT_SAMPLE(t);
                 break;
 
+            case LOAD:
+                EVENT_START(t);
+                rc = hse_kvs_bulk_put(bulk, ti->key, ti->klen, ti->val, ti->vlen);
+                EVENT_SAMPLE(t);
+                break;
+
             default:
                 fatal(ESRCH, "invalid action");
         }
@@ -148,6 +168,14 @@ run(void *p)
         }
     }
 
+    if (bulk) {
+        hse_err_t rc = hse_kvs_bulk_commit(bulk);
+
+        if (rc)
+            fatal(rc, "cannot commit bulk load");
+        hse_kvs_bulk_destroy(bulk);
+    }
+
     snprintf(
         msg, sizeof(msg), "%s: tid 0x%0lx: keys %d..%d", test, ti->tid, ti->start, ti->last - 1);
     EVENT_PRINT(t, msg);
@@ -216,6 +244,7 @@ usage(char *prog)
     fprintf(
         stderr,
         "usage: %s [options] kvdb kvs [param=value ...]\n"
+        "-B         bulk load behind existing data (one thread, big-endian)\n"
         "-c n       do count $n operations per iteration, default 1000\n"
         "-D         delete puts\n"
         "-h         print help\n"
@@ -271,8 +300,11 @@ main(int argc, char **argv)
 
     opterr = 0;
 
-    while ((c = getopt(argc, argv, "?hVDC:Xen:p:t:i:l:L:c:s:o:Z:")) != -1) {
+    while ((c = getopt(argc, argv, "?hBVDC:Xen:p:t:i:l:L:c:s:o:Z:")) != -1) {
         switch (c) {
+            case 'B':
+                action = LOAD;
+                break;
             case 'V':
                 action = GET;
                 break;
@@ -328,6 +360,10 @@ main(int argc, char **argv)
     mpname = argv[optind++];
     kvname = argv[optind++];
 
+    /* bulk loaded keys must be added in ascending order */
+    if (action == LOAD && (tc != 1 || endian != BIG_ENDIAN || klen < 4))
+        fatal(0, "-B requires one thread and big-endian keys of at least 4 bytes");
+
     rc = pg_parse_argv(pg, argc, argv, &optind);
     switch (rc) {
         case 0: